@@ -13,6 +13,9 @@
   \brief The file implements the main computational machinery of the listHamiltonian_MM class and some auxiliary functions
 */
 
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
 #include "Hamiltonian_MM.h"
 
 /// liblibra namespace
@@ -350,10 +353,15 @@ void listHamiltonian_MM::set_atom_interactions_for_atoms
   int* at; at = new int[sz];
   int* id; id = new int[sz];
   bool x = true;
+
+  // Hashed union of the two lists - avoids the linear scans for every atom
+  std::unordered_set<int> in_lst(lst1.begin(), lst1.end());
+  in_lst.insert(lst2.begin(), lst2.end());
+
   for(j=0;j<sz;j++){
     at[j] = top_elt[j].globAtom_Index;
     id[j] = top_elt[j].Atom_id;
-    x = (x && (is_in_vector(at[j],lst1)||is_in_vector(at[j],lst2)));
+    x = (x && (in_lst.count(at[j])>0));
   }
   // If now x is true - then each of the atoms of the topological element
   // belongs to one of the lists
@@ -429,29 +437,64 @@ void listHamiltonian_MM::set_atom_interactions_for_atoms
 
       if(verb>1){  cout<<"=============== Exclusion map ========================\n"; }
 
+      // Positions of the atoms in the at[] array and the atoms grouped by fragments. Only the
+      // atoms of the same group or the atoms within 3 bonds can form the excluded/scaled pairs,
+      // so only these candidates are classified, rather than all sz^2 pairs
+      std::unordered_map<int,int> pos;
+      std::unordered_map<int, vector<int> > grp_members;
+      for(i=0;i<sz;i++){
+        pos[at[i]] = i;
+        grp_members[syst.Atoms[at[i]].globGroup_Index].push_back(i);
+      }
+
       int num_excl = 0;
       for(i=0;i<sz;i++){
         vector<int> ve1,ve2,vs;
-        for(j=i;j<sz;j++){ 
+
+        vector<int> nb[3];
+        syst.get_bonded_neighbors(at[i], nb[0], nb[1], nb[2]);
+
+        // Candidates j >= i (in the at[] order) with their bonded class: 1 - 1,2; 2 - 1,3; 3 - 1,4; 0 - none
+        std::unordered_map<int,int> cls;
+        vector<int>& grp = grp_members[syst.Atoms[at[i]].globGroup_Index];
+        for(j=0;j<grp.size();j++){ if(grp[j]>=i){ cls.emplace(grp[j], 0); } }
+        for(int d=0;d<3;d++){
+          for(j=0;j<nb[d].size();j++){
+            std::unordered_map<int,int>::iterator it = pos.find(nb[d][j]);
+            if(it!=pos.end() && it->second>=i){ 
+              std::unordered_map<int,int>::iterator c = cls.find(it->second);
+              if(c==cls.end()){ cls[it->second] = d+1; }
+              else if(c->second==0){ c->second = d+1; }
+            }
+          }// for j
+        }// for d
+
+        vector<int> cand;
+        for(std::unordered_map<int,int>::iterator c=cls.begin(); c!=cls.end(); c++){ cand.push_back(c->first); }
+        std::sort(cand.begin(), cand.end());
+
+        for(int c=0;c<cand.size();c++){ 
+          j = cand[c];
+          int d = cls[j];
           if(syst.is_group_pair(at[i],at[j])){ vexcl1.push_back(at[i]); vexcl2.push_back(at[j]); vscale.push_back(0.0); 
                                                ve1.push_back(at[i]); ve2.push_back(at[j]); vs.push_back(0.0);
                                         }
           else{
-            if(syst.is_12pair(at[i],at[j])) { vexcl1.push_back(at[i]); vexcl2.push_back(at[j]); vscale.push_back(scale12); 
-                                              ve1.push_back(at[i]); ve2.push_back(at[j]); vs.push_back(scale12);
-                                       }
+            if(d==1) { vexcl1.push_back(at[i]); vexcl2.push_back(at[j]); vscale.push_back(scale12); 
+                       ve1.push_back(at[i]); ve2.push_back(at[j]); vs.push_back(scale12);
+                     }
             else{
-              if(syst.is_13pair(at[i],at[j])) { vexcl1.push_back(at[i]); vexcl2.push_back(at[j]); vscale.push_back(scale13); 
-                                                ve1.push_back(at[i]); ve2.push_back(at[j]); vs.push_back(scale13);
-                                         }
+              if(d==2) { vexcl1.push_back(at[i]); vexcl2.push_back(at[j]); vscale.push_back(scale13); 
+                         ve1.push_back(at[i]); ve2.push_back(at[j]); vs.push_back(scale13);
+                       }
               else{
-                if(syst.is_14pair(at[i],at[j])) { vexcl1.push_back(at[i]); vexcl2.push_back(at[j]); vscale.push_back(scale14);
-                                                  ve1.push_back(at[i]); ve2.push_back(at[j]); vs.push_back(scale14);
-                                           }         
+                if(d==3) { vexcl1.push_back(at[i]); vexcl2.push_back(at[j]); vscale.push_back(scale14);
+                           ve1.push_back(at[i]); ve2.push_back(at[j]); vs.push_back(scale14);
+                         }         
               }
             }
           }
-        }//for j
+        }//for c
 
         // Add new entry in excl_scales:
         vector<excl_scale> excli;
@@ -534,6 +577,11 @@ void listHamiltonian_MM::set_group_interactions_for_atoms
 
   int g_indx[4];
   int m_indx[4];
+
+  // Hashed union of the two lists - avoids the linear scans for every atom of every element
+  std::unordered_set<int> in_lst(lst1.begin(), lst1.end());
+  in_lst.insert(lst2.begin(), lst2.end());
+
   for(int b=0;b<top_elt.size();b++){
     int sz = top_elt[0].Group_Size;
     bool x = true;
@@ -542,7 +590,7 @@ void listHamiltonian_MM::set_group_interactions_for_atoms
       at[j] = top_elt[b].globAtom_Index[j];
       g_indx[j] = syst.Atoms[at[j]].globGroup_Index;
       m_indx[j] = syst.Atoms[at[j]].globMolecule_Index;
-      x = (x && (is_in_vector(at[j],lst1)||is_in_vector(at[j],lst2)));
+      x = (x && (in_lst.count(at[j])>0));
     }
     // If now x is true - then each of the atoms of the topological element
     // belongs to one of the lists
@@ -16,6 +16,7 @@
 
 #include "Hamiltonian_QM.h"
 #include "SCF.h"
+#include "../../timer/Profiler.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -46,6 +47,7 @@ void Hamiltonian_core(
 
   The generic function for computing the core Hamiltonian for a given system
 */
+  ScopedTimer _prof("Hamiltonian_core");
 
   if(prms.hamiltonian=="hf"){
 
@@ -82,6 +84,7 @@ void Hamiltonian_Fock(Electronic_Structure* el, System& syst, vector<AO>& basis_
 
   The generic function for computing the Fock Hamiltonian for a given system
 */
+  ScopedTimer _prof("Hamiltonian_Fock");
 
 
   if(prms.hamiltonian=="hf"){
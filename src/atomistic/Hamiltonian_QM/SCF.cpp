@@ -17,6 +17,7 @@
 */
 
 #include "SCF.h"
+#include "../../timer/Profiler.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -48,6 +49,7 @@ double scf(Electronic_Structure* el, System& syst, vector<AO>& basis_ao,
 
   Returns the converged total electronic energy 
 */
+  ScopedTimer _prof("scf");
 
 
 
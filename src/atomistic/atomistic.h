@@ -89,6 +89,7 @@ public:
   void set_respa_types(std::string inter_type,std::string respa_type);
 
   MATRIX3x3 get_stress(std::string);
+  int is_stress_available(){ return (ham_types[0]==1 && ham_types[1]==0); } ///< 1 - get_stress() is implemented for this Hamiltonian (pure MM)
 
 
   //--------- QM Hamiltonians -----------   
@@ -92,6 +92,32 @@ void update_derivative_coupling_matrix
  vector<AO>& basis_ao, int c, MATRIX& Dao_x, MATRIX& Dao_y, MATRIX& Dao_z
 );
 
+void update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, const VECTOR& k,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, vector<CMATRIX>& Dao
+);
+
+vector<CMATRIX> update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, const VECTOR& k,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2
+);
+
+void update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, vector<MATRIX>& Dao
+);
+
+
+// Basis_symm.cpp
+void update_overlap_matrix(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+                           vector<int>& ao_to_atom_map, vector<AO>& basis_ao, std::string space_group_name, double tol, MATRIX& Sao);
+
+void update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, std::string space_group_name, double tol,
+ vector<MATRIX>& Dao
+);
+
 
 
 
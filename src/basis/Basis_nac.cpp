@@ -10,11 +10,12 @@
 *********************************************************************************/
 /**
   \file Basis_nac.cpp
-  \brief The file implements function for creating derivative coupling matrix
+  \brief The file implements functions for creating derivative coupling matrices
     
 */
 
 #include "Basis.h"
+#include "../timer/Profiler.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -110,6 +111,147 @@ void update_derivative_coupling_matrix
 }
 
 
+void update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, const VECTOR& k,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, vector<CMATRIX>& Dao
+){
+/**
+  \brief Update the derivative coupling matrices (in AO basis) for all atoms at once: <AO(i)|d/dR_c|AO(j)>
+  \param[in] x_period Then number of periodic shells in X direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] y_period Then number of periodic shells in Y direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] z_period Then number of periodic shells in Z direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] t1 The periodicity vector along a crystal direction ("X")
+  \param[in] t2 The periodicity vector along b crystal direction ("Y")
+  \param[in] t3 The periodicity vector along c crystal direction ("Z")
+  \param[in] k The k-point (Cartesian, in units of Bohr^-1); k = 0 is the Gamma-point
+  \param[in] ao_to_atom_map The mapping from the global AO index to the atomic index: ao_to_atom_map[I] - is the index of the atom on which 
+  AO with the global index I is located
+  \param[in] basis_ao The list of all AOs (basis) - not modified
+  \param[in] max_d2 The screening threshold: the pairs of AO i and the periodic image of AO j whose centers are
+  separated by more than sqrt(max_d2) are skipped; max_d2 <= 0 - no screening
+  \param[out] Dao The derivative coupling matrices in AO basis, 3*Natoms of them: Dao[3*c+0], Dao[3*c+1], Dao[3*c+2] are 
+  coupled to the x, y and z coordinates of the atom c. The list is (re)allocated if its size is not 3*Natoms
+
+  The Bloch sums are constructed as:  D^c_ij(k) = sum_T { exp(i*k*T) * <AO(i)|d/dR_c|AO(j)(r-T)> }, 
+  where c is the atom on which AO j is located. As in update_derivative_coupling_matrix, the AOs on the same atom 
+  are not coupled. Each pair (i,j) contributes only to the matrices of the atom of AO j, so all the matrices are 
+  computed in a single pass over the AO pairs and the images. The columns are processed in parallel.
+*/
+  ScopedTimer _prof("update_derivative_coupling_matrices");
+
+  int i, n;
+  int Norb = basis_ao.size();
+
+  if(ao_to_atom_map.size()!=Norb){
+    cout<<"Error in update_derivative_coupling_matrices: the size of the ao_to_atom_map ("<<ao_to_atom_map.size()
+        <<") is not equal to the number of AOs ("<<Norb<<")\nExiting...\n";
+    exit(0);
+  }
+
+  int Natoms = 0;
+  for(i=0;i<Norb;i++){  if(ao_to_atom_map[i]+1 > Natoms){ Natoms = ao_to_atom_map[i]+1; }  }
+
+  int is_alloc = (Dao.size()==3*Natoms);
+  for(n=0;n<Dao.size();n++){  if(Dao[n].n_rows!=Norb || Dao[n].n_cols!=Norb){ is_alloc = 0; }  }
+
+  if(!is_alloc){  Dao.clear();  Dao.resize(3*Natoms, CMATRIX(Norb, Norb));  }
+  for(n=0;n<3*Natoms;n++){  Dao[n] = complex<double>(0.0, 0.0);  }
+
+
+  // The periodic images and their Bloch phases
+  vector<VECTOR> TV;
+  vector< complex<double> > phase;
+
+  for(int nx=-x_period;nx<=x_period;nx++){
+    for(int ny=-y_period;ny<=y_period;ny++){
+      for(int nz=-z_period;nz<=z_period;nz++){
+        VECTOR T; T = nx*t1 + ny*t2 + nz*t3;
+        double arg = k.x*T.x + k.y*T.y + k.z*T.z;
+        TV.push_back(T);
+        phase.push_back(complex<double>(cos(arg), sin(arg)));
+      }
+    }
+  }
+  int nimages = TV.size();
+
+
+  #pragma omp parallel private(i, n)
+  {
+    // Working memory of this thread
+    int n_aux = 20;
+    vector<double*> auxd(10);
+    for(n=0;n<10;n++){ auxd[n] = new double[n_aux]; }
+    MATRIX3x3 dMdA, dMdB;
+    AO ao_j;
+
+    #pragma omp for schedule(dynamic)
+    for(int j=0;j<Norb;j++){
+
+      int c = ao_to_atom_map[j];
+      VECTOR Rj; Rj = basis_ao[j].primitives[0].R;
+      ao_j = basis_ao[j];
+
+      for(int img=0; img<nimages; img++){
+
+        VECTOR Rjt; Rjt = Rj + TV[img];
+        ao_j.set_position_const_ref(Rjt);
+
+        for(i=0;i<Norb;i++){
+
+          if(ao_to_atom_map[i]==c){ continue; } // orbitals on the same atom - no NAC
+          if(max_d2>0.0 && (basis_ao[i].primitives[0].R - Rjt).length2() > max_d2){ continue; }
+
+          //<i|d/dR_c|j(T)> where c - is the atom of orbital j
+          VECTOR dao; dao = derivative_coupling_integral(basis_ao[i], ao_j, 1, 0, dMdA, dMdB, auxd, n_aux);
+
+          Dao[3*c+0].M[i*Norb+j] += phase[img] * dao.x;
+          Dao[3*c+1].M[i*Norb+j] += phase[img] * dao.y;
+          Dao[3*c+2].M[i*Norb+j] += phase[img] * dao.z;
+
+        }// for i
+      }// for img
+    }// for j
+
+    for(n=0;n<10;n++){ delete [] auxd[n]; }
+  }// omp parallel
+
+}
+
+
+vector<CMATRIX> update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, const VECTOR& k,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2
+){
+/**
+  Same as above, but the list of the derivative coupling matrices is returned
+*/
+
+  vector<CMATRIX> Dao;
+  update_derivative_coupling_matrices(x_period, y_period, z_period, t1, t2, t3, k, ao_to_atom_map, basis_ao, max_d2, Dao);
+
+  return Dao;
+}
+
+
+void update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, vector<MATRIX>& Dao
+){
+/**
+  The Gamma-point version of the above function: the derivative coupling matrices are real
+*/
+
+  VECTOR k; k = 0.0;
+  vector<CMATRIX> Dao_k;
+  update_derivative_coupling_matrices(x_period, y_period, z_period, t1, t2, t3, k, ao_to_atom_map, basis_ao, max_d2, Dao_k);
+
+  Dao.clear();
+  Dao.resize(Dao_k.size(), MATRIX(basis_ao.size(), basis_ao.size()));
+  for(int n=0;n<Dao_k.size();n++){  Dao[n] = Dao_k[n].real();  }
+
+}
+
+
 
 
 }//namespace libbasis
@@ -16,6 +16,7 @@
 
 #include "Basis.h"
 #include "../math_meigen/libmeigen.h"
+#include "../timer/Profiler.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -45,6 +46,7 @@ void update_overlap_matrix(int x_period,int y_period,int z_period,const VECTOR&
 
   This function can also take periodic images of the system into account
 */
+  ScopedTimer _prof("update_overlap_matrix");
 
 
   int i,j,n,I,J;
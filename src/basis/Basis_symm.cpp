@@ -0,0 +1,638 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 2 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Basis_symm.cpp
+  \brief The file implements the symmetry-reduced computation of the AO overlap and derivative
+  coupling matrices of periodic systems
+
+  Only one atom pair block per orbit of the space group is integrated; the blocks of all other pairs
+  of the orbit are obtained by rotating the AOs:  if the operation g maps the atoms A, B onto A', B'
+  (modulo the lattice translations), then
+
+      S(A',B') = W_A^T * S(A,B) * W_B
+      D(A',B') = Rc * W_A^T * D(A,B) * W_B    (D is a vector of 3 matrices, Rc acts on this index)
+
+  where Rc is the Cartesian rotation part of g and W_A is the block-diagonal transformation of the
+  Cartesian Gaussian shells of the atom A under Rc. The lattice translations of g only relabel the
+  periodic images, so the result is the same as the one of the direct computation once the periodic
+  sums are converged (the outermost images contribute negligibly).
+*/
+
+#include <map>
+#include <sstream>
+
+#include "Basis.h"
+#include "../math_symmetry/Symmetry_Ops.h"
+#include "../timer/Profiler.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+using namespace libqobjects;
+using namespace libsymmetry;
+
+/// libbasis namespace
+namespace libbasis{
+
+
+// (n)!! for n >= -1
+double double_factorial(int n){
+  double res = 1.0;
+  for(int i=n; i>1; i-=2){ res *= i; }
+  return res;
+}
+
+
+void cartesian_shell_transform(const double* Rc, vector<int>& ax, vector<int>& ay, vector<int>& az, MATRIX& T){
+/**
+  \brief The transformation of a shell of normalized Cartesian Gaussians under the rotation Rc
+  \param[in] Rc The 3x3 Cartesian rotation matrix, row-major
+  \param[in] ax, ay, az The Cartesian exponents of the shell components (all of the same L)
+  \param[out] T The transformation: chi_k(Rc * u) = sum_i { T(i,k) * chi_i(u) }
+
+  The monomial (Rc u)_x^a (Rc u)_y^b (Rc u)_z^c is expanded in the monomials of u. The normalization
+  of a component is proportional to 1/sqrt((2a-1)!!(2b-1)!!(2c-1)!!), the rest of it is common to the shell.
+*/
+
+  int n = ax.size();
+  int L = ax[0] + ay[0] + az[0];
+  int L1 = L + 1;
+
+  vector<double> norm(n);
+  for(int i=0;i<n;i++){
+    norm[i] = 1.0/sqrt(double_factorial(2*ax[i]-1) * double_factorial(2*ay[i]-1) * double_factorial(2*az[i]-1));
+  }
+
+  vector<double> poly(L1*L1*L1), tmp(L1*L1*L1);
+
+  for(int k=0;k<n;k++){
+
+    poly.assign(L1*L1*L1, 0.0);
+    poly[0] = 1.0;
+
+    int exps[3] = {ax[k], ay[k], az[k]};
+
+    // Multiply by the linear forms (Rc u)_x, (Rc u)_y and (Rc u)_z
+    for(int row=0; row<3; row++){
+      for(int e=0; e<exps[row]; e++){
+
+        tmp.assign(L1*L1*L1, 0.0);
+        for(int p=0;p<L;p++){
+          for(int q=0;q<L-p;q++){
+            for(int r=0;r<L-p-q;r++){
+              double c = poly[(p*L1 + q)*L1 + r];
+              if(c==0.0){ continue; }
+              tmp[((p+1)*L1 + q)*L1 + r] += c * Rc[3*row+0];
+              tmp[(p*L1 + q+1)*L1 + r] += c * Rc[3*row+1];
+              tmp[(p*L1 + q)*L1 + r+1] += c * Rc[3*row+2];
+            }
+          }
+        }
+        poly.swap(tmp);
+
+      }// for e
+    }// for row
+
+    for(int i=0;i<n;i++){
+      T.set(i, k, poly[(ax[i]*L1 + ay[i])*L1 + az[i]] * norm[k] / norm[i]);
+    }
+
+  }// for k
+
+}
+
+
+
+class ao_symmetry{
+/**
+  The symmetry data of the AO basis of a periodic system: the equivalent atoms and the AO
+  transformations for every valid symmetry operation
+*/
+
+public:
+
+  int Natoms;
+  int Norb;
+  int is_usable;                         ///< 0 - the basis is not made of complete Cartesian shells, the symmetry can not be used
+  vector< vector<int> > atom_aos;        ///< atom_aos[A] - the global indices of the AOs on the atom A
+  symmetry_atom_map smap;
+  vector<int> ops;                       ///< the indices (in smap.valid_ops) of the operations that are used
+  vector< vector<double> > Rc;           ///< Rc[n] - the Cartesian rotation of the operation ops[n], row-major
+  vector< vector<MATRIX> > W;            ///< W[n][A] - the transformation of the AOs of the atom A under ops[n]
+
+
+  ao_symmetry(const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, vector<int>& ao_to_atom_map, vector<AO>& basis_ao,
+              std::string space_group_name, double tol);
+
+};
+
+
+ao_symmetry::ao_symmetry
+(const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, vector<int>& ao_to_atom_map, vector<AO>& basis_ao,
+ std::string space_group_name, double tol){
+
+  int i, A, n;
+
+  Norb = basis_ao.size();
+  is_usable = 1;
+
+  if(ao_to_atom_map.size()!=Norb){
+    cout<<"Error in ao_symmetry: the size of the ao_to_atom_map ("<<ao_to_atom_map.size()
+        <<") is not equal to the number of AOs ("<<Norb<<")\nExiting...\n";
+    exit(0);
+  }
+
+  Natoms = 0;
+  for(i=0;i<Norb;i++){  if(ao_to_atom_map[i]+1 > Natoms){ Natoms = ao_to_atom_map[i]+1; }  }
+
+  atom_aos = vector< vector<int> >(Natoms);
+  for(i=0;i<Norb;i++){  atom_aos[ao_to_atom_map[i]].push_back(i);  }
+
+
+  // The cell: the columns are the lattice vectors
+  MATRIX3x3 C, Cinv;
+  C.xx = t1.x;  C.xy = t2.x;  C.xz = t3.x;
+  C.yx = t1.y;  C.yy = t2.y;  C.yz = t3.y;
+  C.zx = t1.z;  C.zy = t2.z;  C.zz = t3.z;
+  Cinv = C.inverse();
+
+
+  // The fractional coordinates and the types of the atoms. Only the atoms of the same element
+  // carrying the same AOs (in the same order) can be equivalent
+  vector<VECTOR> frac(Natoms);
+  vector<int> types(Natoms, -1);
+  std::map<std::string, int> type_index;
+
+  for(A=0;A<Natoms;A++){
+    if(atom_aos[A].size()==0){
+      cout<<"Error in ao_symmetry: there are no AOs on the atom "<<A<<"\nExiting...\n";
+      exit(0);
+    }
+
+    frac[A] = Cinv * basis_ao[atom_aos[A][0]].primitives[0].R;
+
+    stringstream ss;
+    ss.precision(12);
+    ss<<basis_ao[atom_aos[A][0]].element;
+    for(n=0;n<atom_aos[A].size();n++){
+      AO& ao = basis_ao[atom_aos[A][n]];
+      ss<<"|"<<ao.expansion_size;
+      for(int p=0;p<ao.expansion_size;p++){
+        ss<<" "<<ao.primitives[p].x_exp<<" "<<ao.primitives[p].y_exp<<" "<<ao.primitives[p].z_exp
+          <<" "<<ao.primitives[p].alpha<<" "<<ao.coefficients[p];
+      }
+    }
+
+    std::map<std::string, int>::iterator it = type_index.find(ss.str());
+    if(it==type_index.end()){ int t = type_index.size(); type_index[ss.str()] = t; types[A] = t; }
+    else{ types[A] = it->second; }
+  }
+
+  smap = symmetry_atom_map(get_space_group(space_group_name), frac, types, tol);
+  const compiled_space_group& g = get_space_group(space_group_name);
+
+
+  // The Cartesian rotations Rc = C * R * C^-1; the operations that are not orthogonal in the given
+  // cell (the cell setting does not match the group) are not used
+  for(int k=0;k<smap.valid_ops.size();k++){
+    MATRIX3x3 R;
+    const double* r = &g.rot[9*smap.valid_ops[k]];
+    R.xx = r[0];  R.xy = r[1];  R.xz = r[2];
+    R.yx = r[3];  R.yy = r[4];  R.yz = r[5];
+    R.zx = r[6];  R.zy = r[7];  R.zz = r[8];
+
+    MATRIX3x3 Rk;  Rk = C * R * Cinv;
+    vector<double> rc(9);
+    rc[0] = Rk.xx;  rc[1] = Rk.xy;  rc[2] = Rk.xz;
+    rc[3] = Rk.yx;  rc[4] = Rk.yy;  rc[5] = Rk.yz;
+    rc[6] = Rk.zx;  rc[7] = Rk.zy;  rc[8] = Rk.zz;
+
+    double err = 0.0;
+    for(int a=0;a<3;a++){
+      for(int b=0;b<3;b++){
+        double x = (a==b) ? -1.0 : 0.0;
+        for(int c=0;c<3;c++){ x += rc[3*a+c] * rc[3*b+c]; }
+        err += x*x;
+      }
+    }
+    if(err < 1e-10){  ops.push_back(k);  Rc.push_back(rc);  }
+  }
+
+
+  // The shells of each atom: the AOs with the same radial part and the same L. Each shell must
+  // contain all the (L+1)(L+2)/2 Cartesian components
+  vector< vector< vector<int> > > shells(Natoms);   // shells[A][s] - the positions (in atom_aos[A]) of the shell components
+
+  for(A=0;A<Natoms;A++){
+    for(n=0;n<atom_aos[A].size();n++){
+      AO& ao = basis_ao[atom_aos[A][n]];
+      int L = ao.primitives[0].x_exp + ao.primitives[0].y_exp + ao.primitives[0].z_exp;
+
+      int found = -1;
+      for(int s=0; s<shells[A].size() && found<0; s++){
+        AO& ao0 = basis_ao[atom_aos[A][shells[A][s][0]]];
+        int L0 = ao0.primitives[0].x_exp + ao0.primitives[0].y_exp + ao0.primitives[0].z_exp;
+
+        // The stored coefficients include the normalization of the primitives, which depends on the component
+        int same = (L==L0 && ao.expansion_size==ao0.expansion_size);
+        for(int p=0; p<ao.expansion_size && same; p++){
+          double c  = ao.coefficients[p] / ao.primitives[p].normalization_factor();
+          double c0 = ao0.coefficients[p] / ao0.primitives[p].normalization_factor();
+          same = (ao.primitives[p].alpha==ao0.primitives[p].alpha && fabs(c - c0) <= 1e-10*fabs(c0));
+        }
+        // The same component can not appear twice in one shell
+        for(int m=0; m<shells[A][s].size() && same; m++){
+          AO& aom = basis_ao[atom_aos[A][shells[A][s][m]]];
+          if(aom.primitives[0].x_exp==ao.primitives[0].x_exp && aom.primitives[0].y_exp==ao.primitives[0].y_exp){ same = 0; }
+        }
+        if(same){ found = s; }
+      }
+
+      if(found<0){ shells[A].push_back(vector<int>(1, n)); }
+      else{ shells[A][found].push_back(n); }
+    }
+
+    for(int s=0; s<shells[A].size(); s++){
+      AO& ao0 = basis_ao[atom_aos[A][shells[A][s][0]]];
+      int L = ao0.primitives[0].x_exp + ao0.primitives[0].y_exp + ao0.primitives[0].z_exp;
+      if(shells[A][s].size() != (L+1)*(L+2)/2){ is_usable = 0; }
+    }
+  }
+
+  if(!is_usable){ return; }
+
+
+  // The AO transformations
+  W = vector< vector<MATRIX> >(ops.size());
+
+  for(n=0;n<ops.size();n++){
+    for(A=0;A<Natoms;A++){
+
+      int nA = atom_aos[A].size();
+      MATRIX WA(nA, nA);
+
+      for(int s=0; s<shells[A].size(); s++){
+        int ns = shells[A][s].size();
+        vector<int> ax(ns), ay(ns), az(ns);
+        for(int m=0;m<ns;m++){
+          AO& ao = basis_ao[atom_aos[A][shells[A][s][m]]];
+          ax[m] = ao.primitives[0].x_exp;  ay[m] = ao.primitives[0].y_exp;  az[m] = ao.primitives[0].z_exp;
+        }
+
+        MATRIX T(ns, ns);
+        cartesian_shell_transform(&Rc[n][0], ax, ay, az, T);
+
+        for(int a=0;a<ns;a++){
+          for(int b=0;b<ns;b++){  WA.set(shells[A][s][a], shells[A][s][b], T.get(a,b));  }
+        }
+      }// for s
+
+      W[n].push_back(WA);
+
+    }// for A
+  }// for n
+
+}
+
+
+
+// X = W_A^T * Y * W_B, where Y is given by the elements (rows of A, columns of B) of M
+void transform_block(MATRIX& M, vector<int>& rows, vector<int>& cols, MATRIX& WA, MATRIX& WB, vector<double>& X){
+
+  int nA = rows.size();
+  int nB = cols.size();
+  int Norb = M.n_cols;
+
+  vector<double> tmp(nA*nB, 0.0);
+  X.assign(nA*nB, 0.0);
+
+  // tmp = Y * W_B
+  for(int i=0;i<nA;i++){
+    for(int j=0;j<nB;j++){
+      double y = M.M[rows[i]*Norb + cols[j]];
+      if(y==0.0){ continue; }
+      for(int l=0;l<nB;l++){  tmp[i*nB+l] += y * WB.M[j*nB+l];  }
+    }
+  }
+
+  // X = W_A^T * tmp
+  for(int i=0;i<nA;i++){
+    for(int k=0;k<nA;k++){
+      double w = WA.M[i*nA+k];
+      if(w==0.0){ continue; }
+      for(int l=0;l<nB;l++){  X[k*nB+l] += w * tmp[i*nB+l];  }
+    }
+  }
+
+}
+
+
+
+void update_overlap_matrix(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+                           vector<int>& ao_to_atom_map, vector<AO>& basis_ao, std::string space_group_name, double tol, MATRIX& Sao){
+/**
+  \brief Update the overlap matrix (in AO basis) of a periodic system using its space group symmetry: <AO(i)|AO(j)>
+  \param[in] x_period Then number of periodic shells in X direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] y_period Then number of periodic shells in Y direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] z_period Then number of periodic shells in Z direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] t1 The periodicity vector along a crystal direction ("X")
+  \param[in] t2 The periodicity vector along b crystal direction ("Y")
+  \param[in] t3 The periodicity vector along c crystal direction ("Z")
+  \param[in] ao_to_atom_map The mapping from the global AO index to the atomic index
+  \param[in] basis_ao The list of all AOs (basis) - not modified
+  \param[in] space_group_name The space group of the system, in the setting of the cell t1, t2, t3
+  \param[in] tol The tolerance of matching the atomic positions (fractional units), e.g. 1e-4
+  \param[out] Sao The output overlap matrix, Norb x Norb
+
+  Same as update_overlap_matrix (Gamma-point), but only one atom pair per orbit is integrated. If the
+  AOs do not form complete Cartesian shells, the symmetry can not be used and the matrix is computed directly.
+*/
+  ScopedTimer _prof("update_overlap_matrix(symmetry)");
+
+  ao_symmetry sym(t1, t2, t3, ao_to_atom_map, basis_ao, space_group_name, tol);
+
+  if(!sym.is_usable){
+    update_overlap_matrix(x_period, y_period, z_period, t1, t2, t3, basis_ao, Sao);
+    return;
+  }
+
+  int Natoms = sym.Natoms;
+  int Norb = sym.Norb;
+  int A, B, r;
+
+  if(Sao.n_rows!=Norb || Sao.n_cols!=Norb){
+    cout<<"Error in update_overlap_matrix: the Sao matrix must be "<<Norb<<" x "<<Norb<<"\nExiting...\n";
+    exit(0);
+  }
+  Sao = 0.0;
+
+
+  // The orbits of the unordered atom pairs
+  vector<int> repA, repB;                    // the representative pairs, A <= B
+  vector<int> imgA, imgB, img_rep, img_op;   // all other pairs: computed from the representative img_rep by the operation img_op
+  vector<int> is_done(Natoms*Natoms, 0);
+
+  for(A=0;A<Natoms;A++){
+    for(B=A;B<Natoms;B++){
+      if(is_done[A*Natoms+B]){ continue; }
+
+      is_done[A*Natoms+B] = 1;
+      r = repA.size();
+      repA.push_back(A);  repB.push_back(B);
+
+      for(int n=0;n<sym.ops.size();n++){
+        int k = sym.ops[n];
+        int a = sym.smap.atom_map[k][A];
+        int b = sym.smap.atom_map[k][B];
+        int key = (a<=b) ? a*Natoms+b : b*Natoms+a;
+        if(is_done[key]){ continue; }
+
+        is_done[key] = 1;
+        imgA.push_back(a);  imgB.push_back(b);  img_rep.push_back(r);  img_op.push_back(n);
+      }
+    }
+  }
+
+
+  // The periodic images
+  vector<VECTOR> TV;
+  for(int nx=-x_period;nx<=x_period;nx++){
+    for(int ny=-y_period;ny<=y_period;ny++){
+      for(int nz=-z_period;nz<=z_period;nz++){
+        VECTOR T; T = nx*t1 + ny*t2 + nz*t3;
+        TV.push_back(T);
+      }
+    }
+  }
+  int nimages = TV.size();
+
+
+  // The representative blocks - computed directly
+  #pragma omp parallel private(A, B, r)
+  {
+    int n_aux = 20;
+    vector<double*> auxd(10);
+    for(int n=0;n<10;n++){ auxd[n] = new double[n_aux]; }
+    VECTOR dIdA, dIdB;
+    AO ao_j;
+
+    #pragma omp for schedule(dynamic)
+    for(r=0; r<repA.size(); r++){
+      A = repA[r];  B = repB[r];
+
+      for(int q=0;q<sym.atom_aos[B].size();q++){
+        int j = sym.atom_aos[B][q];
+        VECTOR Rj; Rj = basis_ao[j].primitives[0].R;
+        ao_j = basis_ao[j];
+
+        for(int p=0;p<sym.atom_aos[A].size();p++){
+          int i = sym.atom_aos[A][p];
+          double s = 0.0;
+
+          for(int img=0; img<nimages; img++){
+            VECTOR Rjt; Rjt = Rj + TV[img];
+            ao_j.set_position_const_ref(Rjt);
+            s += gaussian_overlap(basis_ao[i], ao_j, 1, 0, dIdA, dIdB, auxd, n_aux);
+          }
+
+          Sao.M[i*Norb+j] = s;
+          Sao.M[j*Norb+i] = s;
+        }// for p
+      }// for q
+    }// for r
+
+    for(int n=0;n<10;n++){ delete [] auxd[n]; }
+  }// omp parallel
+
+
+  // All other blocks - by the symmetry
+  #pragma omp parallel for schedule(dynamic)
+  for(int m=0; m<imgA.size(); m++){
+    int r = img_rep[m];
+    int n = img_op[m];
+    vector<int>& rows = sym.atom_aos[imgA[m]];
+    vector<int>& cols = sym.atom_aos[imgB[m]];
+    int nB = cols.size();
+
+    vector<double> X;
+    transform_block(Sao, sym.atom_aos[repA[r]], sym.atom_aos[repB[r]], sym.W[n][repA[r]], sym.W[n][repB[r]], X);
+
+    for(int p=0;p<rows.size();p++){
+      for(int q=0;q<nB;q++){
+        Sao.M[rows[p]*Norb + cols[q]] = X[p*nB+q];
+        Sao.M[cols[q]*Norb + rows[p]] = X[p*nB+q];
+      }
+    }
+  }// for m
+
+}
+
+
+
+void update_derivative_coupling_matrices
+(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+ vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, std::string space_group_name, double tol,
+ vector<MATRIX>& Dao
+){
+/**
+  \brief Update the derivative coupling matrices (in AO basis) of a periodic system using its space group symmetry
+  \param[in] x_period Then number of periodic shells in X direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] y_period Then number of periodic shells in Y direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] z_period Then number of periodic shells in Z direction: 0 - only the central shell, 1 - [-1,0,1], etc.
+  \param[in] t1 The periodicity vector along a crystal direction ("X")
+  \param[in] t2 The periodicity vector along b crystal direction ("Y")
+  \param[in] t3 The periodicity vector along c crystal direction ("Z")
+  \param[in] ao_to_atom_map The mapping from the global AO index to the atomic index
+  \param[in] basis_ao The list of all AOs (basis) - not modified
+  \param[in] max_d2 The screening threshold (as in update_derivative_coupling_matrices); max_d2 <= 0 - no screening
+  \param[in] space_group_name The space group of the system, in the setting of the cell t1, t2, t3
+  \param[in] tol The tolerance of matching the atomic positions (fractional units), e.g. 1e-4
+  \param[out] Dao The derivative coupling matrices in AO basis, 3*Natoms of them, as in the Gamma-point
+  version of update_derivative_coupling_matrices
+
+  Only one ordered atom pair per orbit is integrated. If the AOs do not form complete Cartesian shells,
+  the symmetry can not be used and the matrices are computed directly.
+*/
+  ScopedTimer _prof("update_derivative_coupling_matrices(symmetry)");
+
+  ao_symmetry sym(t1, t2, t3, ao_to_atom_map, basis_ao, space_group_name, tol);
+
+  if(!sym.is_usable){
+    update_derivative_coupling_matrices(x_period, y_period, z_period, t1, t2, t3, ao_to_atom_map, basis_ao, max_d2, Dao);
+    return;
+  }
+
+  int Natoms = sym.Natoms;
+  int Norb = sym.Norb;
+  int A, B, r, n;
+
+  int is_alloc = (Dao.size()==3*Natoms);
+  for(n=0;n<Dao.size();n++){  if(Dao[n].n_rows!=Norb || Dao[n].n_cols!=Norb){ is_alloc = 0; }  }
+
+  if(!is_alloc){  Dao.clear();  Dao.resize(3*Natoms, MATRIX(Norb, Norb));  }
+  for(n=0;n<3*Natoms;n++){  Dao[n] = 0.0;  }
+
+
+  // The orbits of the ordered pairs of different atoms
+  vector<int> repA, repB;
+  vector<int> imgA, imgB, img_rep, img_op;
+  vector<int> is_done(Natoms*Natoms, 0);
+
+  for(A=0;A<Natoms;A++){
+    for(B=0;B<Natoms;B++){
+      if(A==B || is_done[A*Natoms+B]){ continue; }
+
+      is_done[A*Natoms+B] = 1;
+      r = repA.size();
+      repA.push_back(A);  repB.push_back(B);
+
+      for(n=0;n<sym.ops.size();n++){
+        int k = sym.ops[n];
+        int a = sym.smap.atom_map[k][A];
+        int b = sym.smap.atom_map[k][B];
+        if(is_done[a*Natoms+b]){ continue; }
+
+        is_done[a*Natoms+b] = 1;
+        imgA.push_back(a);  imgB.push_back(b);  img_rep.push_back(r);  img_op.push_back(n);
+      }
+    }
+  }
+
+
+  // The periodic images
+  vector<VECTOR> TV;
+  for(int nx=-x_period;nx<=x_period;nx++){
+    for(int ny=-y_period;ny<=y_period;ny++){
+      for(int nz=-z_period;nz<=z_period;nz++){
+        VECTOR T; T = nx*t1 + ny*t2 + nz*t3;
+        TV.push_back(T);
+      }
+    }
+  }
+  int nimages = TV.size();
+
+
+  // The representative blocks - computed directly
+  #pragma omp parallel private(A, B, r)
+  {
+    int n_aux = 20;
+    vector<double*> auxd(10);
+    for(int m=0;m<10;m++){ auxd[m] = new double[n_aux]; }
+    MATRIX3x3 dMdA, dMdB;
+    AO ao_j;
+
+    #pragma omp for schedule(dynamic)
+    for(r=0; r<repA.size(); r++){
+      A = repA[r];  B = repB[r];
+
+      for(int q=0;q<sym.atom_aos[B].size();q++){
+        int j = sym.atom_aos[B][q];
+        VECTOR Rj; Rj = basis_ao[j].primitives[0].R;
+        ao_j = basis_ao[j];
+
+        for(int img=0; img<nimages; img++){
+          VECTOR Rjt; Rjt = Rj + TV[img];
+          ao_j.set_position_const_ref(Rjt);
+
+          for(int p=0;p<sym.atom_aos[A].size();p++){
+            int i = sym.atom_aos[A][p];
+            if(max_d2>0.0 && (basis_ao[i].primitives[0].R - Rjt).length2() > max_d2){ continue; }
+
+            VECTOR dao; dao = derivative_coupling_integral(basis_ao[i], ao_j, 1, 0, dMdA, dMdB, auxd, n_aux);
+
+            Dao[3*B+0].M[i*Norb+j] += dao.x;
+            Dao[3*B+1].M[i*Norb+j] += dao.y;
+            Dao[3*B+2].M[i*Norb+j] += dao.z;
+          }// for p
+        }// for img
+      }// for q
+    }// for r
+
+    for(int m=0;m<10;m++){ delete [] auxd[m]; }
+  }// omp parallel
+
+
+  // All other blocks - by the symmetry
+  #pragma omp parallel for schedule(dynamic)
+  for(int m=0; m<imgA.size(); m++){
+    int r = img_rep[m];
+    int n = img_op[m];
+    int a0 = repA[r], b0 = repB[r];
+    vector<int>& rows = sym.atom_aos[imgA[m]];
+    vector<int>& cols = sym.atom_aos[imgB[m]];
+    int nA = rows.size();
+    int nB = cols.size();
+    const double* Rc = &sym.Rc[n][0];
+
+    vector<double> X[3];
+    for(int beta=0; beta<3; beta++){
+      transform_block(Dao[3*b0+beta], sym.atom_aos[a0], sym.atom_aos[b0], sym.W[n][a0], sym.W[n][b0], X[beta]);
+    }
+
+    for(int alp=0; alp<3; alp++){
+      MATRIX& D = Dao[3*imgB[m]+alp];
+      for(int p=0;p<nA;p++){
+        for(int q=0;q<nB;q++){
+          int pq = p*nB+q;
+          D.M[rows[p]*Norb + cols[q]] = Rc[3*alp+0]*X[0][pq] + Rc[3*alp+1]*X[1][pq] + Rc[3*alp+2]*X[2][pq];
+        }
+      }
+    }
+  }// for m
+
+}
+
+
+
+}//namespace libbasis
+}//namespace liblibra
+
@@ -47,7 +47,7 @@ void export_basis_objects(){
 */
 
 
-
+
   // Basis.cpp
   void (*expt_basis_params_s_v1)
   (int, vector<double>&, vector<double>&) = &basis_params_s;
@@ -77,6 +77,9 @@ void export_basis_objects(){
   void (*expt_update_overlap_matrix_v1)(int,int,int,const VECTOR&,const VECTOR&,const VECTOR&,
   vector<AO>&,MATRIX&) = &update_overlap_matrix;
 
+  void (*expt_update_overlap_matrix_v2)(int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+  vector<int>& ao_to_atom_map, vector<AO>& basis_ao, std::string space_group_name, double tol, MATRIX& Sao) = &update_overlap_matrix;
+
   void (*expt_MO_overlap_v1)(MATRIX& Smo, vector<AO>& ao_i, vector<AO>& ao_j, MATRIX& Ci, MATRIX& Cj,
   vector<int>& active_orb_i, vector<int>& active_orb_j, double max_d2) = &MO_overlap;
 
@@ -109,10 +112,31 @@ void export_basis_objects(){
    vector<AO>& basis_ao, int c, MATRIX& Dao_x, MATRIX& Dao_y, MATRIX& Dao_z
   ) = &update_derivative_coupling_matrix;
 
-
-
-
-
+  void (*expt_update_derivative_coupling_matrices_v1)
+  (int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, const VECTOR& k,
+   vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, vector<CMATRIX>& Dao
+  ) = &update_derivative_coupling_matrices;
+
+  vector<CMATRIX> (*expt_update_derivative_coupling_matrices_v2)
+  (int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3, const VECTOR& k,
+   vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2
+  ) = &update_derivative_coupling_matrices;
+
+  void (*expt_update_derivative_coupling_matrices_v3)
+  (int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+   vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, vector<MATRIX>& Dao
+  ) = &update_derivative_coupling_matrices;
+
+  void (*expt_update_derivative_coupling_matrices_v4)
+  (int x_period,int y_period,int z_period,const VECTOR& t1, const VECTOR& t2, const VECTOR& t3,
+   vector<int>& ao_to_atom_map, vector<AO>& basis_ao, double max_d2, std::string space_group_name, double tol,
+   vector<MATRIX>& Dao
+  ) = &update_derivative_coupling_matrices;
+
+
+
+
+
   def("basis_params_s", expt_basis_params_s_v1);
   def("basis_params_p", expt_basis_params_p_v1);
   def("basis_params_d", expt_basis_params_d_v1);
@@ -122,6 +146,7 @@ void export_basis_objects(){
   def("num_valence_elec", expt_num_valence_elec_v1);
 
   def("update_overlap_matrix", expt_update_overlap_matrix_v1);
+  def("update_overlap_matrix", expt_update_overlap_matrix_v2);
   def("MO_overlap", expt_MO_overlap_v1);
   def("MO_overlap", expt_MO_overlap_v2);
   def("MO_overlap", expt_MO_overlap_v3);
@@ -135,6 +160,10 @@ void export_basis_objects(){
   def("show_mapping", expt_show_mapping_v1);
 
   def("update_derivative_coupling_matrix", expt_update_derivative_coupling_matrix_v1);
+  def("update_derivative_coupling_matrices", expt_update_derivative_coupling_matrices_v1);
+  def("update_derivative_coupling_matrices", expt_update_derivative_coupling_matrices_v2);
+  def("update_derivative_coupling_matrices", expt_update_derivative_coupling_matrices_v3);
+  def("update_derivative_coupling_matrices", expt_update_derivative_coupling_matrices_v4);
 
 
 
@@ -0,0 +1,104 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file bench.h
+  \brief The performance benchmark suite of the Libra C++ kernels (the libra_bench executable)
+
+  Every kernel is set up with synthetic, deterministic inputs (fixed RNG seeds) for a
+  given problem size, then timed for a number of repetitions at each requested
+  OpenMP thread count. The results are written as JSON lines and can be compared
+  against the results of an earlier run (the baseline) with a relative tolerance.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+/// liblibra namespace
+namespace liblibra{
+
+/// libbench namespace
+namespace libbench{
+
+using namespace std;
+
+
+/// A prepared benchmark: one call = one unit of timed work
+typedef std::function<void()> bench_run;
+
+/// Prepares the inputs for the problem size `size`, returns the callable to be timed
+/// and sets `work` - the amount of work done per call, in the units of the kernel throughput
+typedef bench_run (*bench_setup)(int size, double& work);
+
+
+class bench_kernel{
+/**
+  Description of one benchmarked kernel
+*/
+public:
+  std::string name;          ///< identifier used on the command line and in the output
+  std::string unit;          ///< units of the throughput (work per second)
+  vector<int> sizes;         ///< problem sizes of the full run
+  vector<int> quick_sizes;   ///< problem sizes of the quick (--quick) run
+  int needs_python;          ///< 1 - the kernel uses Python objects, so the interpreter must be started
+  bench_setup setup;
+
+  bench_kernel(std::string _name, std::string _unit, vector<int> _sizes, vector<int> _quick_sizes,
+               int _needs_python, bench_setup _setup){
+    name = _name; unit = _unit; sizes = _sizes; quick_sizes = _quick_sizes;
+    needs_python = _needs_python; setup = _setup;
+  }
+};
+
+
+class bench_result{
+/**
+  Timings of one (kernel, size, number of threads) case
+*/
+public:
+  std::string kernel;
+  int size;
+  int nthreads;
+  int reps;
+  double t_min;        ///< the fastest repetition [s]
+  double t_median;     ///< the median repetition [s]
+  double throughput;   ///< work / t_min
+  std::string unit;
+  double speedup;      ///< t_min(1 thread) / t_min(nthreads), 1.0 if the 1-thread run is not done
+  double efficiency;   ///< speedup / nthreads
+
+  bench_result(){ size = nthreads = reps = 0; t_min = t_median = throughput = 0.0; speedup = efficiency = 1.0; }
+
+  std::string to_json() const;
+};
+
+
+// Kernels - bench_kernels.cpp
+vector<bench_kernel> all_kernels();
+void init_python();
+
+// Harness - bench_harness.cpp
+bench_result run_case(bench_kernel& kernel, int size, int nthreads, int reps);
+vector<bench_result> read_results(std::string filename);
+int compare_to_baseline(vector<bench_result>& results, vector<bench_result>& baseline, double tolerance);
+
+
+}// namespace libbench
+}// namespace liblibra
+
+#endif // BENCH_H
@@ -0,0 +1,197 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file bench_harness.cpp
+  \brief Timing, output and baseline comparison of the benchmark suite
+*/
+
+#include "bench.h"
+#include "../timer/Profiler.h"
+#include <algorithm>
+#include <stdlib.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+/// liblibra namespace
+namespace liblibra{
+
+/// libbench namespace
+namespace libbench{
+
+
+std::string bench_result::to_json() const{
+
+  stringstream ss;
+  ss<<setprecision(8)
+    <<"{\"kernel\": \""<<kernel<<"\""
+    <<", \"size\": "<<size
+    <<", \"threads\": "<<nthreads
+    <<", \"reps\": "<<reps
+    <<", \"t_min\": "<<t_min
+    <<", \"t_median\": "<<t_median
+    <<", \"throughput\": "<<throughput
+    <<", \"unit\": \""<<unit<<"\""
+    <<", \"speedup\": "<<speedup
+    <<", \"efficiency\": "<<efficiency
+    <<"}";
+
+  return ss.str();
+}
+
+
+bench_result run_case(bench_kernel& kernel, int size, int nthreads, int reps){
+/**
+  Set up the kernel for the given size, do one warm-up call and then time `reps` calls
+  with `nthreads` OpenMP threads. The setup is not timed.
+*/
+
+#if defined(_OPENMP)
+  omp_set_num_threads(nthreads);
+#endif
+
+  double work = 1.0;
+  bench_run run = kernel.setup(size, work);
+
+  run();  // warm-up
+
+  vector<double> t(reps, 0.0);
+  for(int r=0; r<reps; r++){
+    double t0 = wall_time();
+    run();
+    t[r] = wall_time() - t0;
+  }
+
+  std::sort(t.begin(), t.end());
+
+  bench_result res;
+  res.kernel = kernel.name;
+  res.size = size;
+  res.nthreads = nthreads;
+  res.reps = reps;
+  res.t_min = t[0];
+  res.t_median = (reps % 2) ? t[reps/2] : 0.5*(t[reps/2 - 1] + t[reps/2]);
+  res.throughput = (res.t_min > 0.0) ? work / res.t_min : 0.0;
+  res.unit = kernel.unit;
+
+  return res;
+}
+
+
+namespace{
+
+/// Minimal extraction of a value from the flat one-line JSON objects written by bench_result::to_json
+int json_value(const std::string& line, std::string key, std::string& value){
+
+  std::string pattern = "\"" + key + "\":";
+  size_t pos = line.find(pattern);
+  if(pos==std::string::npos){ return 0; }
+
+  pos += pattern.size();
+  while(pos<line.size() && line[pos]==' '){ pos++; }
+
+  size_t end;
+  if(pos<line.size() && line[pos]=='"'){
+    pos++;
+    end = line.find('"', pos);
+  }
+  else{
+    end = line.find_first_of(",}", pos);
+  }
+  if(end==std::string::npos){ return 0; }
+
+  value = line.substr(pos, end - pos);
+  return 1;
+}
+
+}// anonymous namespace
+
+
+vector<bench_result> read_results(std::string filename){
+/**
+  Read the results (e.g. the stored baseline) written earlier with --output
+*/
+
+  ifstream in(filename.c_str(), ios::in);
+  if(!in.is_open()){
+    cout<<"Error in read_results: can not open file "<<filename<<"\nExiting...\n";
+    exit(1);
+  }
+
+  vector<bench_result> res;
+  std::string line, val;
+
+  while(std::getline(in, line)){
+    bench_result r;
+
+    if(!json_value(line, "kernel", r.kernel)){ continue; }
+    if(json_value(line, "size", val)){ r.size = atoi(val.c_str()); }
+    if(json_value(line, "threads", val)){ r.nthreads = atoi(val.c_str()); }
+    if(json_value(line, "reps", val)){ r.reps = atoi(val.c_str()); }
+    if(json_value(line, "t_min", val)){ r.t_min = atof(val.c_str()); }
+    if(json_value(line, "t_median", val)){ r.t_median = atof(val.c_str()); }
+    if(json_value(line, "throughput", val)){ r.throughput = atof(val.c_str()); }
+    json_value(line, "unit", r.unit);
+    if(json_value(line, "speedup", val)){ r.speedup = atof(val.c_str()); }
+    if(json_value(line, "efficiency", val)){ r.efficiency = atof(val.c_str()); }
+
+    res.push_back(r);
+  }
+
+  in.close();
+
+  return res;
+}
+
+
+int compare_to_baseline(vector<bench_result>& results, vector<bench_result>& baseline, double tolerance){
+/**
+  Compare the throughputs with the baseline ones for the matching (kernel, size, threads) cases.
+  A case is a regression if its throughput is below (1 - tolerance) of the baseline one.
+  Returns the number of regressions.
+*/
+
+  int nregress = 0;
+
+  cout<<"\n"<<left<<setw(20)<<"kernel"<<right<<setw(8)<<"size"<<setw(9)<<"threads"
+      <<setw(16)<<"throughput"<<setw(16)<<"baseline"<<setw(10)<<"ratio"<<"  status\n";
+
+  for(int i=0; i<(int)results.size(); i++){
+    bench_result& r = results[i];
+
+    int found = -1;
+    for(int j=0; j<(int)baseline.size(); j++){
+      if(baseline[j].kernel==r.kernel && baseline[j].size==r.size && baseline[j].nthreads==r.nthreads){ found = j; }
+    }
+
+    cout<<left<<setw(20)<<r.kernel<<right<<setw(8)<<r.size<<setw(9)<<r.nthreads
+        <<setw(16)<<scientific<<setprecision(4)<<r.throughput;
+
+    if(found<0 || baseline[found].throughput<=0.0){
+      cout<<setw(16)<<"-"<<setw(10)<<"-"<<"  no baseline\n";
+      continue;
+    }
+
+    double ratio = r.throughput / baseline[found].throughput;
+    std::string status = "ok";
+    if(ratio < 1.0 - tolerance){  status = "REGRESSION"; nregress++; }
+    else if(ratio > 1.0 + tolerance){  status = "improved"; }
+
+    cout<<setw(16)<<baseline[found].throughput<<setw(10)<<fixed<<setprecision(3)<<ratio<<"  "<<status<<"\n";
+  }
+
+  return nregress;
+}
+
+
+}// namespace libbench
+}// namespace liblibra
+
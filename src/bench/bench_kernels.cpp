@@ -0,0 +1,348 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file bench_kernels.cpp
+  \brief Set up of the benchmarked kernels with synthetic, deterministic inputs
+*/
+
+#include <memory>
+#include <random>
+#include <cmath>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "bench.h"
+#include "../math_linalg/liblinalg.h"
+#include "../math_meigen/libmeigen.h"
+#include "../models/libmodels.h"
+#include "../nhamiltonian/libnhamiltonian.h"
+#include "../dyn/libdyn.h"
+#include "../dyn/wfcgrid2/libwfcgrid2.h"
+#include "../pot/libpot.h"
+#include "../molint/libmolint.h"
+
+
+#ifdef CYGWIN
+extern "C" PyObject* PyInit_cyglibra_core();
+#else
+extern "C" PyObject* PyInit_liblibra_core();
+#endif
+
+
+/// liblibra namespace
+namespace liblibra{
+
+/// libbench namespace
+namespace libbench{
+
+using namespace liblinalg;
+using namespace libmeigen;
+using namespace libmodels;
+using namespace libnhamiltonian;
+using namespace libdyn;
+using namespace libdyn::libwfcgrid2;
+using namespace libpot;
+using namespace libmolint;
+using namespace librandom;
+namespace bp = boost::python;
+
+
+void init_python(){
+/**
+  Start the embedded interpreter and register all the Libra types with it, the same
+  way as "import liblibra_core" does. Needed by the kernels that go through the
+  Python-facing interfaces (bp::dict parameters, the model callback).
+*/
+
+  if(Py_IsInitialized()){ return; }
+
+#ifdef CYGWIN
+  PyImport_AppendInittab("cyglibra_core", &PyInit_cyglibra_core);
+  Py_Initialize();
+  bp::import("cyglibra_core");
+#else
+  PyImport_AppendInittab("liblibra_core", &PyInit_liblibra_core);
+  Py_Initialize();
+  bp::import("liblibra_core");
+#endif
+
+}
+
+
+//======================= base_matrix::product ==========================
+
+bench_run setup_matrix_product(int n, double& work){
+
+  std::mt19937 gen(12345 + n);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+
+  std::shared_ptr<MATRIX> A(new MATRIX(n, n));
+  std::shared_ptr<MATRIX> B(new MATRIX(n, n));
+  std::shared_ptr<MATRIX> C(new MATRIX(n, n));
+
+  for(int i=0; i<n*n; i++){  A->M[i] = U(gen);  B->M[i] = U(gen);  }
+
+  work = 2.0e-9 * double(n) * double(n) * double(n);   // GFLOP per call
+
+  return [A, B, C](){  C->product(*A, *B);  };
+}
+
+
+//======================= Hermitian CMATRIX eigensolver ==========================
+
+bench_run setup_cmatrix_eigen(int n, double& work){
+
+  std::mt19937 gen(23456 + n);
+  std::uniform_real_distribution<double> U(-1.0, 1.0);
+
+  std::shared_ptr<CMATRIX> H(new CMATRIX(n, n));
+  std::shared_ptr<CMATRIX> E(new CMATRIX(n, n));
+  std::shared_ptr<CMATRIX> C(new CMATRIX(n, n));
+
+  CMATRIX X(n, n);
+  for(int i=0; i<n; i++){
+    for(int j=0; j<n; j++){  X.set(i, j, complex<double>(U(gen), U(gen)));  }
+  }
+  *H = X + X.H();
+
+  work = 1.0;   // solves per call
+
+  return [H, E, C](){  solve_eigen(*H, *E, *C, 0);  };
+}
+
+
+//======================= compute_dynamics ==========================
+// One FSSH step of ntraj independent trajectories on Tully's single avoided
+// crossing model. The diabatic Hamiltonian is evaluated by the C++ model_SAC
+// through the same callback interface that the Python models use.
+
+bp::object bench_SAC_model(MATRIX& q, bp::object params, vector<int>& full_id){
+
+  int traj = full_id[full_id.size()-1];
+
+  CMATRIX Hdia(2, 2);
+  CMATRIX Sdia(2, 2);
+  CMATRIXList d1ham_dia(1, CMATRIX(2, 2));
+  CMATRIXList dc1_dia(1, CMATRIX(2, 2));
+  vector<double> _q(1, q.get(0, traj));
+  vector<double> _params;
+
+  model_SAC(Hdia, Sdia, d1ham_dia, dc1_dia, _q, _params);
+
+  bp::object obj = bp::import("types").attr("SimpleNamespace")();
+  obj.attr("ham_dia") = Hdia;
+  obj.attr("ovlp_dia") = Sdia;
+  obj.attr("d1ham_dia") = d1ham_dia;
+  obj.attr("dc1_dia") = dc1_dia;
+
+  return obj;
+}
+
+
+bench_run setup_compute_dynamics(int ntraj, double& work){
+
+  int ndia = 2, nadi = 2, ndof = 1;
+
+  std::shared_ptr<Random> rnd(new Random());
+  srand(34567 + ntraj);   // Random draws from rand()
+
+  bp::object model = bp::make_function(&bench_SAC_model);
+  bp::dict model_params;
+
+  bp::dict dyn_params;
+  dyn_params["dt"] = 1.0;
+  dyn_params["rep_tdse"] = 1;
+  dyn_params["rep_sh"] = 1;
+  dyn_params["tsh_method"] = 0;
+  dyn_params["ham_update_method"] = 1;
+  dyn_params["ham_transform_method"] = 1;
+  dyn_params["time_overlap_method"] = 1;
+  dyn_params["nac_update_method"] = 1;
+  dyn_params["hvib_update_method"] = 1;
+  dyn_params["force_method"] = 1;
+  dyn_params["decoherence_algo"] = -1;
+  dyn_params["num_electronic_substeps"] = 1;
+
+  // Nuclear and electronic initial conditions
+  bp::list q0, p0, m0, k0;
+  q0.append(-4.0);  p0.append(20.0);  m0.append(2000.0);  k0.append(0.01);
+
+  bp::dict init_nucl;
+  init_nucl["init_type"] = 3;
+  init_nucl["q"] = q0;
+  init_nucl["p"] = p0;
+  init_nucl["mass"] = m0;
+  init_nucl["force_constant"] = k0;
+
+  bp::dict init_elec;
+  init_elec["init_type"] = 0;
+  init_elec["nstates"] = 2;
+  init_elec["istate"] = 0;
+  init_elec["rep"] = 1;
+  init_elec["ntraj"] = ntraj;
+
+  std::shared_ptr<dyn_variables> dyn_var(new dyn_variables(ndia, nadi, ndof, ntraj));
+  dyn_var->init_nuclear_dyn_var(init_nucl, *rnd);
+  dyn_var->init_amplitudes(init_elec, *rnd);
+  dyn_var->init_density_matrix(init_elec);
+
+  std::shared_ptr<nHamiltonian> ham(new nHamiltonian(ndia, nadi, ndof));
+  ham->add_new_children(ndia, nadi, ndof, ntraj);
+  ham->init_all(2, 1);
+
+  update_Hamiltonian_variables(dyn_params, *dyn_var, *ham, *ham, model, model_params, 0);
+  update_Hamiltonian_variables(dyn_params, *dyn_var, *ham, *ham, model, model_params, 1);
+
+  bp::dict rep_params;
+  rep_params["rep_tdse"] = 1;
+  dyn_var->update_basis_transform(*ham);
+  dyn_var->update_amplitudes(rep_params, *ham);
+  dyn_var->update_density_matrix(dyn_params, *ham, 1);
+  dyn_var->init_active_states(init_elec, *rnd);
+
+  std::shared_ptr<nHamiltonian> ham_aux(new nHamiltonian(*ham));
+  std::shared_ptr< vector<Thermostat> > therm(new vector<Thermostat>());
+
+  work = double(ntraj);   // trajectory steps per call
+
+  return [dyn_var, dyn_params, ham, ham_aux, model, model_params, rnd, therm](){
+    compute_dynamics(*dyn_var, dyn_params, *ham, *ham_aux, model, model_params, *rnd, *therm);
+  };
+}
+
+
+//======================= Elec_Ewald3D ==========================
+
+bench_run setup_elec_ewald3d(int n, double& work){
+
+  std::mt19937 gen(45678 + n);
+  std::uniform_real_distribution<double> U(0.0, 1.0);
+
+  double L = pow(100.0 * double(n), 1.0/3.0);   // ~0.01 charges per Bohr^3
+
+  std::shared_ptr< vector<VECTOR> > r(new vector<VECTOR>(n));
+  std::shared_ptr< vector<VECTOR> > f(new vector<VECTOR>(n));
+  std::shared_ptr< vector<double> > q(new vector<double>(n));
+  std::shared_ptr<MATRIX3x3> box(new MATRIX3x3());
+  std::shared_ptr<MATRIX3x3> stress(new MATRIX3x3());
+
+  for(int i=0; i<n; i++){
+    (*r)[i] = VECTOR(L*U(gen), L*U(gen), L*U(gen));
+    (*q)[i] = (i % 2) ? -0.5 : 0.5;
+  }
+  box->identity();
+  *box = L * (*box);
+
+  double R_off = 0.5*L;
+  double R_on = 0.9*R_off;
+  double etha = R_off / 3.5;
+
+  work = double(n);   // charges per call
+
+  return [r, q, box, f, stress, etha, R_on, R_off](){
+    Elec_Ewald3D(*r, *q, *box, 1.0, *f, *stress, 4, 1, etha, R_on, R_off);
+  };
+}
+
+
+//======================= molint: electron repulsion integrals ==========================
+
+bench_run setup_molint_eri(int n, double& work){
+
+  std::mt19937 gen(56789 + n);
+  std::uniform_real_distribution<double> U(0.0, 1.0);
+
+  // n primitive Gaussians cycling through s, px, py, pz
+  std::shared_ptr< vector<VECTOR> > R(new vector<VECTOR>(n));
+  std::shared_ptr< vector<double> > alp(new vector<double>(n));
+  std::shared_ptr< vector<int> > l(new vector<int>(3*n, 0));
+
+  for(int i=0; i<n; i++){
+    (*R)[i] = VECTOR(3.0*U(gen), 3.0*U(gen), 3.0*U(gen));
+    (*alp)[i] = 0.5 + 1.5*U(gen);
+    if(i % 4 > 0){ (*l)[3*i + (i % 4) - 1] = 1; }
+  }
+
+  work = double(n)*double(n)*double(n)*double(n);   // integrals per call
+
+  return [n, R, alp, l](){
+
+    double sum = 0.0;
+
+    #pragma omp parallel for collapse(2) reduction(+:sum) schedule(dynamic)
+    for(int a=0; a<n; a++){
+      for(int b=0; b<n; b++){
+        vector<int>& L = *l;
+        VECTOR Ra((*R)[a]), Rb((*R)[b]);
+
+        for(int c=0; c<n; c++){
+          for(int d=0; d<n; d++){
+            VECTOR Rc((*R)[c]), Rd((*R)[d]);
+            sum += electron_repulsion_integral(L[3*a], L[3*a+1], L[3*a+2], (*alp)[a], Ra,
+                                               L[3*b], L[3*b+1], L[3*b+2], (*alp)[b], Rb,
+                                               L[3*c], L[3*c+1], L[3*c+2], (*alp)[c], Rc,
+                                               L[3*d], L[3*d+1], L[3*d+2], (*alp)[d], Rd, 1);
+          }
+        }
+      }
+    }
+
+    if(std::isnan(sum)){ cout<<"Warning in molint_eri benchmark: NaN integrals\n"; }
+  };
+}
+
+
+//======================= Wfcgrid2 FFT path ==========================
+
+bench_run setup_wfcgrid2_fft(int npts, double& work){
+
+  int nstates = 2;
+  double L = 0.1 * double(npts);
+
+  vector<double> rmin(1, -0.5*L);
+  vector<double> rmax(1, 0.5*L);
+  vector<double> dr(1, L / double(npts));
+
+  std::shared_ptr<Wfcgrid2> wfc(new Wfcgrid2(rmin, rmax, dr, nstates));
+
+  vector<double> x0(1, -0.1*L), px0(1, 10.0), dx0(1, 0.05*L);
+  wfc->add_wfc_Gau(x0, px0, dx0, 0, complex<double>(1.0, 0.0), 0);
+  wfc->add_wfc_Gau(x0, px0, dx0, 1, complex<double>(0.0, 0.5), 0);
+
+  work = double(wfc->Npts) * double(nstates);   // grid points transformed (forward + back) per call
+
+  return [wfc](){
+    wfc->update_reciprocal(0);
+    wfc->update_real(0);
+  };
+}
+
+
+
+vector<bench_kernel> all_kernels(){
+
+  vector<bench_kernel> res;
+
+  res.push_back( bench_kernel("matrix_product", "GFLOP/s", {64, 128, 256, 512}, {64, 128}, 0, &setup_matrix_product) );
+  res.push_back( bench_kernel("cmatrix_eigen", "solves/s", {32, 64, 128, 256}, {32, 64}, 0, &setup_cmatrix_eigen) );
+  res.push_back( bench_kernel("compute_dynamics", "traj-steps/s", {10, 100, 1000}, {10}, 1, &setup_compute_dynamics) );
+  res.push_back( bench_kernel("elec_ewald3d", "charges/s", {64, 256, 1024}, {64}, 0, &setup_elec_ewald3d) );
+  res.push_back( bench_kernel("molint_eri", "integrals/s", {4, 8, 12}, {4}, 0, &setup_molint_eri) );
+  res.push_back( bench_kernel("wfcgrid2_fft", "points/s", {1024, 4096, 16384}, {1024}, 0, &setup_wfcgrid2_fft) );
+
+  return res;
+}
+
+
+}// namespace libbench
+}// namespace liblibra
+
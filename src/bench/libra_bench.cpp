@@ -0,0 +1,190 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file libra_bench.cpp
+  \brief The driver of the Libra C++ performance benchmark suite
+
+  Usage:
+
+    libra_bench [--list] [--quick] [--kernels k1,k2,...] [--sizes n1,n2,...]
+                [--threads t1,t2,...] [--reps N] [--output results.jsonl]
+                [--baseline baseline.jsonl] [--tolerance 0.15]
+
+  The results are printed to stdout and, with --output, written as JSON lines. A file
+  written with --output can be used as the --baseline of a later run; the exit code is
+  the number of regressions found (capped at 100), so the run can be used in scripts.
+*/
+
+#include "bench.h"
+#include <stdlib.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+
+using namespace liblibra;
+using namespace liblibra::libbench;
+
+
+vector<int> parse_int_list(std::string s){
+
+  vector<int> res;
+  stringstream ss(s);
+  std::string item;
+
+  while(std::getline(ss, item, ',')){
+    if(item.size()>0){ res.push_back(atoi(item.c_str())); }
+  }
+
+  return res;
+}
+
+vector<std::string> parse_str_list(std::string s){
+
+  vector<std::string> res;
+  stringstream ss(s);
+  std::string item;
+
+  while(std::getline(ss, item, ',')){
+    if(item.size()>0){ res.push_back(item); }
+  }
+
+  return res;
+}
+
+
+void usage(vector<bench_kernel>& kernels){
+
+  cout<<"Usage: libra_bench [--list] [--quick] [--kernels k1,k2,...] [--sizes n1,n2,...]\n"
+      <<"                   [--threads t1,t2,...] [--reps N] [--output file] [--baseline file]\n"
+      <<"                   [--tolerance x]\n\n"
+      <<"Kernels:\n";
+
+  for(int i=0; i<(int)kernels.size(); i++){
+    cout<<"  "<<left<<setw(20)<<kernels[i].name<<" ["<<kernels[i].unit<<"]  sizes:";
+    for(int j=0; j<(int)kernels[i].sizes.size(); j++){ cout<<" "<<kernels[i].sizes[j]; }
+    cout<<"\n";
+  }
+}
+
+
+int main(int argc, char** argv){
+
+  vector<bench_kernel> kernels = all_kernels();
+
+  vector<std::string> selected;
+  vector<int> sizes;
+  vector<int> threads;
+  int reps = 5;
+  int quick = 0;
+  double tolerance = 0.15;
+  std::string output_file = "";
+  std::string baseline_file = "";
+
+  for(int i=1; i<argc; i++){
+    std::string arg = argv[i];
+    int has_val = (i+1 < argc);
+
+    if(arg=="--list" || arg=="--help" || arg=="-h"){  usage(kernels); return 0; }
+    else if(arg=="--quick"){  quick = 1; }
+    else if(arg=="--kernels" && has_val){  selected = parse_str_list(argv[++i]); }
+    else if(arg=="--sizes" && has_val){  sizes = parse_int_list(argv[++i]); }
+    else if(arg=="--threads" && has_val){  threads = parse_int_list(argv[++i]); }
+    else if(arg=="--reps" && has_val){  reps = atoi(argv[++i]); }
+    else if(arg=="--output" && has_val){  output_file = argv[++i]; }
+    else if(arg=="--baseline" && has_val){  baseline_file = argv[++i]; }
+    else if(arg=="--tolerance" && has_val){  tolerance = atof(argv[++i]); }
+    else{
+      cout<<"Error in libra_bench: unknown or incomplete argument "<<arg<<"\n\n";
+      usage(kernels);
+      return 1;
+    }
+  }
+
+  if(reps<1){ reps = 1; }
+
+  // Default thread counts: 1, 2, 4, ... up to the maximum available
+  if(threads.size()==0){
+    int max_threads = 1;
+#if defined(_OPENMP)
+    max_threads = omp_get_max_threads();
+#endif
+    for(int t=1; t<max_threads; t*=2){ threads.push_back(t); }
+    threads.push_back(max_threads);
+  }
+
+  // Select kernels
+  vector<bench_kernel> todo;
+  for(int i=0; i<(int)kernels.size(); i++){
+    int is_selected = (selected.size()==0);
+    for(int j=0; j<(int)selected.size(); j++){ if(selected[j]==kernels[i].name){ is_selected = 1; } }
+    if(is_selected){ todo.push_back(kernels[i]); }
+  }
+  for(int j=0; j<(int)selected.size(); j++){
+    int found = 0;
+    for(int i=0; i<(int)kernels.size(); i++){ if(selected[j]==kernels[i].name){ found = 1; } }
+    if(!found){
+      cout<<"Error in libra_bench: unknown kernel "<<selected[j]<<"\n\n";
+      usage(kernels);
+      return 1;
+    }
+  }
+
+  for(int i=0; i<(int)todo.size(); i++){
+    if(todo[i].needs_python){ init_python(); break; }
+  }
+
+
+  // Run
+  vector<bench_result> results;
+
+  for(int i=0; i<(int)todo.size(); i++){
+    vector<int>& sz = (sizes.size()>0) ? sizes : (quick ? todo[i].quick_sizes : todo[i].sizes);
+
+    for(int j=0; j<(int)sz.size(); j++){
+      double t1 = -1.0;
+
+      for(int k=0; k<(int)threads.size(); k++){
+        bench_result r = run_case(todo[i], sz[j], threads[k], reps);
+
+        if(threads[k]==1){ t1 = r.t_min; }
+        if(t1>0.0 && r.t_min>0.0){
+          r.speedup = t1 / r.t_min;
+          r.efficiency = r.speedup / double(threads[k]);
+        }
+
+        cout<<r.to_json()<<endl;
+        results.push_back(r);
+      }
+    }
+  }
+
+
+  if(output_file.size()>0){
+    ofstream out(output_file.c_str(), ios::out);
+    if(!out.is_open()){
+      cout<<"Error in libra_bench: can not open file "<<output_file<<"\n";
+      return 1;
+    }
+    for(int i=0; i<(int)results.size(); i++){ out<<results[i].to_json()<<"\n"; }
+    out.close();
+  }
+
+  int nregress = 0;
+  if(baseline_file.size()>0){
+    vector<bench_result> baseline = read_results(baseline_file);
+    nregress = compare_to_baseline(results, baseline, tolerance);
+    cout<<"\n"<<nregress<<" regression(s) beyond the tolerance of "<<tolerance<<"\n";
+  }
+
+  return (nregress > 100) ? 100 : nregress;
+}
+
@@ -15,6 +15,7 @@
 */
 
 #include "System.h"
+#include "../../Units.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -61,6 +62,27 @@ void System::init_variables(){
 
   Nf_t = 0;     is_Nf_t = 1;
   Nf_r = 0;     is_Nf_r = 1;
+
+  n_indexed_atoms = 0;
+  n_indexed_bonds = 0;
+  n_indexed_angles = 0;
+  n_indexed_dihedrals = 0;
+  n_indexed_impropers = 0;
+
+  perc_tol = 0.4*Angst;
+  perc_periodic = 0;
+
+  rings_nat = -1;
+  rings_nbonds = -1;
+  rings_max_size = -1;
+
+  Number_of_constraints = 0;
+  constraint_method = "SHAKE";
+  constraint_tol = 1e-8;
+  constraint_max_iter = 500;
+  lincs_order = 4;
+  stress_cons = 0.0;
+  is_cons_init = 0;
 /*
   stress_opt = "fr"; is_stress_opt = 1;
   stress_at = 0.0;   is_stress_at = 0;
@@ -118,6 +140,31 @@ void System::copy_content(const System& sys){
   Frag_dihedrals = sys.Frag_dihedrals;
   Frag_impropers = sys.Frag_impropers;
   Frag_pairs = sys.Frag_pairs;
+
+  atom_id_index = sys.atom_id_index;       n_indexed_atoms = sys.n_indexed_atoms;
+  bond_index = sys.bond_index;             n_indexed_bonds = sys.n_indexed_bonds;
+  angle_index = sys.angle_index;           angle_ends_index = sys.angle_ends_index;
+  n_indexed_angles = sys.n_indexed_angles;
+  dihedral_index = sys.dihedral_index;     n_indexed_dihedrals = sys.n_indexed_dihedrals;
+  improper_index = sys.improper_index;     n_indexed_impropers = sys.n_indexed_impropers;
+
+  perc_atoms = sys.perc_atoms;        perc_valence = sys.perc_valence;
+  perc_radius = sys.perc_radius;      perc_ref = sys.perc_ref;
+  perc_tol = sys.perc_tol;            perc_periodic = sys.perc_periodic;
+
+  rings_nat = sys.rings_nat;          rings_nbonds = sys.rings_nbonds;
+  rings_max_size = sys.rings_max_size;
+
+  Number_of_constraints = sys.Number_of_constraints;
+  constraint_method = sys.constraint_method;    constraint_tol = sys.constraint_tol;
+  constraint_max_iter = sys.constraint_max_iter; lincs_order = sys.lincs_order;
+  cons_at1 = sys.cons_at1;            cons_at2 = sys.cons_at2;
+  cons_fr1 = sys.cons_fr1;            cons_fr2 = sys.cons_fr2;
+  cons_d = sys.cons_d;                cons_index = sys.cons_index;
+  cons_clusters = sys.cons_clusters;  cons_cluster_frags = sys.cons_cluster_frags;
+  cons_cluster_type = sys.cons_cluster_type;
+  cons_ref = sys.cons_ref;            stress_cons = sys.stress_cons;
+  is_cons_init = sys.is_cons_init;
   Surface_atoms = sys.Surface_atoms;
 
   if(sys.is_name){  name = sys.name;  is_name = 1; }
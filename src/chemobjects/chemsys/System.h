@@ -21,6 +21,8 @@
 #include "../../math_graph/libgraph.h"
 #include "../../math_linalg/liblinalg.h"
 #include "../mol/libmol.h"
+#include "../../io/libio.h"
+#include <unordered_map>
 
 
 
@@ -52,6 +54,40 @@ public:
 };
 
 
+struct topo_key{
+/**
+  \brief The canonical (orientation-independent) key of a topological element: bond, angle or dihedral.
+  The unused positions are set to -1
+*/
+  int a[4];  ///< The indices of the atoms forming the element
+
+  bool operator==(const topo_key& k) const{
+    return (a[0]==k.a[0]) && (a[1]==k.a[1]) && (a[2]==k.a[2]) && (a[3]==k.a[3]);
+  }
+};
+
+struct topo_key_hash{
+/**
+  \brief The hash function for the topo_key objects
+*/
+  std::size_t operator()(const topo_key& k) const{
+    std::size_t h = 0;
+    for(int i=0;i<4;i++){  h ^= std::hash<int>()(k.a[i]) + 0x9e3779b9 + (h<<6) + (h>>2);  }
+    return h;
+  }
+};
+
+typedef std::unordered_map<topo_key, int, topo_key_hash> topo_index;
+
+topo_key bond_key(int a1, int a2);
+topo_key angle_key(int a1, int a2, int a3);
+topo_key dihedral_key(int a1, int a2, int a3, int a4);
+
+double covalent_radius(std::string elt);
+int default_valence(std::string elt);
+
+
+
 class System{
 /**
   \brief The System class for representation of chemical system (topology, geometry, properties)
@@ -80,6 +116,65 @@ class System{
   int is_in_vector(int indx,vector<int>& vect);
 
 
+  //----------- Defined in System_methods.cpp -----------------
+  // Hashed indices of the topology. They are kept up to date by the builder functions
+  // and are rebuilt whenever the corresponding containers are found to be modified elsewhere
+  std::unordered_map<int,int> atom_id_index;  int n_indexed_atoms;     ///< Atom ID -> atom index
+  topo_index bond_index;                      int n_indexed_bonds;     ///< Canonical (a1,a2) -> bond index
+  topo_index angle_index;                     int n_indexed_angles;    ///< Canonical (a1,a2,a3) -> angle index
+  topo_index angle_ends_index;                                         ///< Canonical (a1,a3) -> index of the first such angle
+  topo_index dihedral_index;                  int n_indexed_dihedrals; ///< Canonical (a1,a2,a3,a4) -> dihedral index
+  std::unordered_map<int,int> improper_index; int n_indexed_impropers; ///< Central atom -> index of the first such improper
+
+  void index_atom(int);
+  void index_bond(int);
+  void index_angle(int);
+  void index_dihedral(int);
+  void index_improper(int);
+
+
+  //----------- Defined in System_methods2.cpp -----------------
+  // The setup of the last automatic bond perception - used by the incremental UPDATE_BONDS
+  vector<int> perc_atoms;        ///< Indices of the atoms included in the bond perception
+  vector<int> perc_valence;      ///< Maximal valences of these atoms
+  vector<double> perc_radius;    ///< Covalent radii of these atoms [a.u.]
+  vector<VECTOR> perc_ref;       ///< Positions of these atoms at the last (re-)perception
+  double perc_tol;               ///< The distance tolerance [a.u.]
+  int perc_periodic;             ///< Flag to use the periodic (minimum image) distances
+
+  int perceive_bonds(vector<int>& active);
+
+
+  //----------- Defined in System_methods1.cpp -----------------
+  // The topology for which the rings have been assigned last time
+  int rings_nat;                 ///< The number of atoms
+  int rings_nbonds;              ///< The number of bonds
+  int rings_max_size;            ///< The largest ring looked for
+
+
+  //----------- Defined in System_methods8.cpp -----------------
+  // Holonomic (bond-length) constraints between the atoms that form single-atom fragments
+  vector<int> cons_at1, cons_at2;            ///< The indices of the constrained atoms
+  vector<int> cons_fr1, cons_fr2;            ///< The indices of the fragments formed by these atoms
+  vector<double> cons_d;                     ///< The target distances [a.u.]
+  topo_index cons_index;                     ///< Canonical (a1,a2) -> constraint index
+  vector< vector<int> > cons_clusters;       ///< The indices of the constraints coupled through the shared atoms
+  vector< vector<int> > cons_cluster_frags;  ///< The indices of the fragments in each cluster (O, H1, H2 for rigid waters)
+  vector<int> cons_cluster_type;             ///< 0 - single constraint, 1 - coupled cluster, 2 - rigid water (SETTLE)
+  vector<VECTOR> cons_ref;                   ///< The positions of the fragments at the beginning of the MD step
+  MATRIX3x3 stress_cons;                     ///< The constraint virial accumulated during the MD step
+  int is_cons_init;                          ///< Flag showing the clusters are up to date
+
+  void init_constraints();
+  double constraint_inv_mass(int fr);
+  void constraint_shift(int fr, const VECTOR& dr, double dt);
+  void constraint_pair_shift(int k, const VECTOR& g, double dt);
+  int shake_cluster(int c, double dt);
+  int mshake_cluster(int c, double dt);
+  int lincs_cluster(int c, double dt);
+  void settle_cluster(int c, double dt);
+
+
   //---------- Defined in System_aux.cpp ----------------------
   // Topology and builder related functions:
   void create_bond(int,int,int);
@@ -142,6 +237,13 @@ public:
   int         Nf_t;         int is_Nf_t;  ///< The total number of translational DOF and the status flag
   int         Nf_r;         int is_Nf_r;  ///< The total number of rotational DOF and the status flag
 
+//---------- Holonomic constraints (see System_methods8.cpp) ---------------
+  int         Number_of_constraints;     ///< The number of the bond-length constraints
+  std::string constraint_method;         ///< The solver for the coupled constraints: "SHAKE" (default), "M-SHAKE" or "LINCS"
+  double      constraint_tol;            ///< The relative tolerance of the constraint lengths (SHAKE and M-SHAKE)
+  int         constraint_max_iter;       ///< The maximal number of SHAKE and M-SHAKE iterations
+  int         lincs_order;               ///< The order of the matrix expansion in LINCS
+
   //----------- Basic class operations ---------------------------
   // Defined in System.cpp
   System();                ///< constructor
@@ -186,11 +288,14 @@ public:
   int is_13pair(int,int);
   int is_14pair(int,int);
   int is_group_pair(int,int);
+  void update_topology_index();
+  void get_bonded_neighbors(int at_indx, vector<int>& nb12, vector<int>& nb13, vector<int>& nb14);
 
   //----------- Defined in System_methods1.cpp -----------
   // Topological functions
   void Generate_Connectivity_Matrix();
   void Assign_Rings();
+  void Assign_Rings(int max_ring_size);
   void DIVIDE_GRAPH(int,int, vector<int>&);  
 
   //----------- Defined in System_methods2.cpp ------------------
@@ -204,6 +309,8 @@ public:
   void ADD_ATOM_TO_FRAGMENT(int,int);
   void GROUP_ATOMS(boost::python::list,int);
   void CREATE_BONDS(boost::python::list,boost::python::dict);
+  void CREATE_BONDS(boost::python::list,boost::python::dict,double tol,int is_periodic);
+  int UPDATE_BONDS(double displ_threshold);
   void CLONE_MOLECULE(int);
 
   //----------- Defined in System_methods3.cpp ------------------
@@ -213,6 +320,7 @@ public:
   void move_molecule_by_index(VECTOR&,int);
 
   void update_atoms_for_fragment(int);
+  void update_atoms_for_fragments();
   void update_fragments_for_molecule(int);
   void update_atoms_for_molecule(int);
   void rotate_atoms_of_fragment(int,MATRIX3x3&);
@@ -336,6 +444,21 @@ public:
 
 
   std::string get_xyz(int fold,std::string pbc_type,int frame);
+
+  void get_traj_frame(libio::traj_frame& fr);
+
+
+  //---------------- Defined in System_methods8.cpp -----------------
+  void add_constraint(int at_indx1, int at_indx2, double d);
+  void add_constraint(int at_indx1, int at_indx2);
+  void CONSTRAIN_BONDS(std::string opt);
+  void clear_constraints();
+  void save_constraint_reference();
+  int apply_position_constraints(double dt);
+  void apply_velocity_constraints(double dt, int is_virial);
+  void apply_velocity_constraints(double dt);
+  double max_constraint_deviation();
+  MATRIX3x3 constraint_virial();
   
 };
 
@@ -29,6 +29,111 @@ namespace libchemsys{
 
 //================= ObjectSpace member-functions =========================
 
+topo_key bond_key(int a1, int a2){
+/**
+  \brief The canonical key of the bond a1-a2: the same for a1-a2 and a2-a1
+*/
+  topo_key k;
+  k.a[0] = (a1<a2)?a1:a2;  k.a[1] = (a1<a2)?a2:a1;  k.a[2] = -1;  k.a[3] = -1;
+  return k;
+}
+
+topo_key angle_key(int a1, int a2, int a3){
+/**
+  \brief The canonical key of the angle a1-a2-a3: the same for a1-a2-a3 and a3-a2-a1
+*/
+  topo_key k;
+  if(a1<=a3){ k.a[0] = a1; k.a[2] = a3; }
+  else{       k.a[0] = a3; k.a[2] = a1; }
+  k.a[1] = a2;  k.a[3] = -1;
+  return k;
+}
+
+topo_key dihedral_key(int a1, int a2, int a3, int a4){
+/**
+  \brief The canonical key of the dihedral a1-a2-a3-a4: the same for a1-a2-a3-a4 and a4-a3-a2-a1
+*/
+  topo_key k;
+  if( (a1<a4) || ((a1==a4) && (a2<=a3)) ){ k.a[0] = a1; k.a[1] = a2; k.a[2] = a3; k.a[3] = a4; }
+  else{                                    k.a[0] = a4; k.a[1] = a3; k.a[2] = a2; k.a[3] = a1; }
+  return k;
+}
+
+
+void System::index_atom(int i){
+/**
+  \brief Add the i-th atom to the hashed index. As in the linear search, the last atom with given ID wins
+*/
+  if(Atoms[i].is_Atom_id){ atom_id_index[Atoms[i].Atom_id] = i; }
+  n_indexed_atoms++;
+}
+
+void System::index_bond(int i){
+/**
+  \brief Add the i-th bond to the hashed index
+*/
+  bond_index.emplace(bond_key(Bonds[i].globAtom_Index[0], Bonds[i].globAtom_Index[1]), i);
+  n_indexed_bonds++;
+}
+
+void System::index_angle(int i){
+/**
+  \brief Add the i-th angle to the hashed indices
+*/
+  vector<int>& a = Angles[i].globAtom_Index;
+  angle_index.emplace(angle_key(a[0], a[1], a[2]), i);
+  angle_ends_index.emplace(bond_key(a[0], a[2]), i);
+  n_indexed_angles++;
+}
+
+void System::index_dihedral(int i){
+/**
+  \brief Add the i-th dihedral to the hashed index
+*/
+  vector<int>& a = Dihedrals[i].globAtom_Index;
+  dihedral_index.emplace(dihedral_key(a[0], a[1], a[2], a[3]), i);
+  n_indexed_dihedrals++;
+}
+
+void System::index_improper(int i){
+/**
+  \brief Add the i-th improper to the hashed index
+*/
+  improper_index.emplace(Impropers[i].globAtom_Index[0], i);
+  n_indexed_impropers++;
+}
+
+
+void System::update_topology_index(){
+/**
+  \brief Rebuild the hashed indices of atoms, bonds, angles, dihedrals, and impropers
+
+  The indices are maintained automatically by the builder functions, so normally there
+  is no need to call this function. It is called internally, if the topology containers
+  have been changed directly (e.g. from Python)
+*/
+  int i;
+
+  atom_id_index.clear();     n_indexed_atoms = 0;
+  bond_index.clear();        n_indexed_bonds = 0;
+  angle_index.clear();       angle_ends_index.clear();   n_indexed_angles = 0;
+  dihedral_index.clear();    n_indexed_dihedrals = 0;
+  improper_index.clear();    n_indexed_impropers = 0;
+
+  atom_id_index.reserve(Number_of_atoms);
+  bond_index.reserve(Number_of_bonds);
+  angle_index.reserve(Number_of_angles);
+  dihedral_index.reserve(Number_of_dihedrals);
+
+  for(i=0;i<Number_of_atoms;i++){ index_atom(i); }
+  for(i=0;i<Number_of_bonds;i++){ index_bond(i); }
+  for(i=0;i<Number_of_angles;i++){ index_angle(i); }
+  for(i=0;i<Number_of_dihedrals;i++){ index_dihedral(i); }
+  for(i=0;i<Number_of_impropers;i++){ index_improper(i); }
+
+}
+
+
 int System::get_atom_index_by_atom_id(int id){
 /**
   \brief This auxiliary function returns the index of the atom given the id
@@ -36,11 +141,20 @@ int System::get_atom_index_by_atom_id(int id){
   \param[in] id The ID of the atom (note that this can be any integer, not necessarily sequential)
 */
 
-  int indx = -1;
-  for(int i=0;i<Number_of_atoms;i++){
-    if(Atoms[i].is_Atom_id){ if(Atoms[i].Atom_id==id){indx = i; }  }
+  if(n_indexed_atoms!=Number_of_atoms){ update_topology_index(); }
+
+  std::unordered_map<int,int>::iterator it = atom_id_index.find(id);
+  if(it==atom_id_index.end()){ return -1; }
+
+  int indx = it->second;
+  if(indx<Number_of_atoms){
+    if(Atoms[indx].is_Atom_id && Atoms[indx].Atom_id==id){ return indx; }
   }
-  return indx;
+
+  // The index is outdated - rebuild it and try again
+  update_topology_index();
+  it = atom_id_index.find(id);
+  return (it==atom_id_index.end()) ? -1 : it->second;
 }
 
 int System::get_fragment_index_by_fragment_id(int id){
@@ -82,13 +196,21 @@ int System::Find_Bond(int at_indx1,int at_indx2){
   It returns globGroup_Index of corresponding bond
 */
 
-  int res = -1;
-  for(int i=0;i<Number_of_bonds;i++){
-    if((  (Bonds[i].globAtom_Index[0]==at_indx1) && (Bonds[i].globAtom_Index[1]==at_indx2)  )||
-       (  (Bonds[i].globAtom_Index[0]==at_indx2) && (Bonds[i].globAtom_Index[1]==at_indx1)  )
-      ){   res = i;break;   }
+  if(n_indexed_bonds!=Number_of_bonds){ update_topology_index(); }
+
+  topo_key k = bond_key(at_indx1, at_indx2);
+  topo_index::iterator it = bond_index.find(k);
+  if(it==bond_index.end()){ return -1; }
+
+  int res = it->second;
+  if(res<Number_of_bonds){
+    if(bond_key(Bonds[res].globAtom_Index[0], Bonds[res].globAtom_Index[1])==k){ return res; }
   }
-  return res;
+
+  // The index is outdated - rebuild it and try again
+  update_topology_index();
+  it = bond_index.find(k);
+  return (it==bond_index.end()) ? -1 : it->second;
 }
 
 int System::Find_Frag_Pair(int at_indx1,int at_indx2){
@@ -121,13 +243,21 @@ int System::Find_Angle(int at_indx1,int at_indx3){
   It returns globGroup_Index of corresponding angle
 */
 
-  int res = -1;
-  for(int i=0;i<Number_of_angles;i++){
-    if((  (Angles[i].globAtom_Index[0]==at_indx1) && (Angles[i].globAtom_Index[2]==at_indx3)  )||
-       (  (Angles[i].globAtom_Index[0]==at_indx3) && (Angles[i].globAtom_Index[2]==at_indx1)  )
-      ){   res = i;break;   }
+  if(n_indexed_angles!=Number_of_angles){ update_topology_index(); }
+
+  topo_key k = bond_key(at_indx1, at_indx3);
+  topo_index::iterator it = angle_ends_index.find(k);
+  if(it==angle_ends_index.end()){ return -1; }
+
+  int res = it->second;
+  if(res<Number_of_angles){
+    if(bond_key(Angles[res].globAtom_Index[0], Angles[res].globAtom_Index[2])==k){ return res; }
   }
-  return res;
+
+  // The index is outdated - rebuild it and try again
+  update_topology_index();
+  it = angle_ends_index.find(k);
+  return (it==angle_ends_index.end()) ? -1 : it->second;
 }
 
 int System::Find_Angle(int at_indx1,int at_indx2,int at_indx3){
@@ -141,13 +271,22 @@ int System::Find_Angle(int at_indx1,int at_indx2,int at_indx3){
   It returns globGroup_Index of corresponding angle
 */
 
-  int res = -1;
-  for(int i=0;i<Number_of_angles;i++){
-    if((  (Angles[i].globAtom_Index[0]==at_indx1) && (Angles[i].globAtom_Index[1]==at_indx2) && (Angles[i].globAtom_Index[2]==at_indx3) )||
-       (  (Angles[i].globAtom_Index[0]==at_indx3) && (Angles[i].globAtom_Index[1]==at_indx2) && (Angles[i].globAtom_Index[2]==at_indx1) )
-      ){   res = i;break;   }
+  if(n_indexed_angles!=Number_of_angles){ update_topology_index(); }
+
+  topo_key k = angle_key(at_indx1, at_indx2, at_indx3);
+  topo_index::iterator it = angle_index.find(k);
+  if(it==angle_index.end()){ return -1; }
+
+  int res = it->second;
+  if(res<Number_of_angles){
+    vector<int>& a = Angles[res].globAtom_Index;
+    if(angle_key(a[0], a[1], a[2])==k){ return res; }
   }
-  return res;
+
+  // The index is outdated - rebuild it and try again
+  update_topology_index();
+  it = angle_index.find(k);
+  return (it==angle_index.end()) ? -1 : it->second;
 }
 
 int System::Find_Dihedral(int at_indx1,int at_indx2,int at_indx3,int at_indx4){
@@ -162,21 +301,22 @@ int System::Find_Dihedral(int at_indx1,int at_indx2,int at_indx3,int at_indx4){
   It returns globGroup_Index of corresponding dihedral
 */
 
-  int res = -1;
-  for(int i=0;i<Number_of_dihedrals;i++){
-    if((  (Dihedrals[i].globAtom_Index[0]==at_indx1)
-        &&(Dihedrals[i].globAtom_Index[1]==at_indx2)
-        &&(Dihedrals[i].globAtom_Index[2]==at_indx3)
-        &&(Dihedrals[i].globAtom_Index[3]==at_indx4)
-       )||
-       (  (Dihedrals[i].globAtom_Index[0]==at_indx4)
-        &&(Dihedrals[i].globAtom_Index[1]==at_indx3)
-        &&(Dihedrals[i].globAtom_Index[2]==at_indx2)
-        &&(Dihedrals[i].globAtom_Index[3]==at_indx1)
-       )
-      ){   res = i;break;   }
+  if(n_indexed_dihedrals!=Number_of_dihedrals){ update_topology_index(); }
+
+  topo_key k = dihedral_key(at_indx1, at_indx2, at_indx3, at_indx4);
+  topo_index::iterator it = dihedral_index.find(k);
+  if(it==dihedral_index.end()){ return -1; }
+
+  int res = it->second;
+  if(res<Number_of_dihedrals){
+    vector<int>& a = Dihedrals[res].globAtom_Index;
+    if(dihedral_key(a[0], a[1], a[2], a[3])==k){ return res; }
   }
-  return res;
+
+  // The index is outdated - rebuild it and try again
+  update_topology_index();
+  it = dihedral_index.find(k);
+  return (it==dihedral_index.end()) ? -1 : it->second;
 }
 
 int System::Find_Improper(int at_indx1){
@@ -187,11 +327,20 @@ int System::Find_Improper(int at_indx1){
   It returns globGroup_Index of corresponding improper
 */
 
-  int res = -1;
-  for(int i=0;i<Number_of_impropers;i++){
-    if(Impropers[i].globAtom_Index[0]==at_indx1 ){   res = i;break;   }
+  if(n_indexed_impropers!=Number_of_impropers){ update_topology_index(); }
+
+  std::unordered_map<int,int>::iterator it = improper_index.find(at_indx1);
+  if(it==improper_index.end()){ return -1; }
+
+  int res = it->second;
+  if(res<Number_of_impropers){
+    if(Impropers[res].globAtom_Index[0]==at_indx1){ return res; }
   }
-  return res;
+
+  // The index is outdated - rebuild it and try again
+  update_topology_index();
+  it = improper_index.find(at_indx1);
+  return (it==improper_index.end()) ? -1 : it->second;
 }
 
 int System::is_12pair(int at_indx1,int at_indx2){
@@ -268,6 +417,42 @@ int System::is_group_pair(int at_indx1,int at_indx2){
 }
 
 
+void System::get_bonded_neighbors(int at_indx, vector<int>& nb12, vector<int>& nb13, vector<int>& nb14){
+/**
+  \param[in] at_indx The index of the atom
+  \param[out] nb12 The indices of the atoms forming 1,2-pairs with the given atom
+  \param[out] nb13 The indices of the atoms forming 1,3-pairs (but not 1,2-pairs) with the given atom
+  \param[out] nb14 The indices of the atoms forming 1,4-pairs (but not 1,2- or 1,3-pairs) with the given atom
+
+  This function walks the adjacency lists of the atoms, so its cost does not depend on the
+  size of the system. The classification is the same as given by the is_12pair, is_13pair, and
+  is_14pair functions, applied in this order. The given atom itself is not included.
+*/
+
+  nb12.clear();  nb13.clear();  nb14.clear();
+
+  std::unordered_map<int,int> dist;
+  dist[at_indx] = 0;
+
+  vector<int>* shells[3] = {&nb12, &nb13, &nb14};
+  vector<int> front(1, at_indx);
+
+  for(int d=0; d<3; d++){
+    for(int i=0;i<front.size();i++){
+      vector<int>& adj = Atoms[front[i]].globAtom_Adjacent_Atoms;
+      for(int j=0;j<adj.size();j++){
+        if(dist.find(adj[j])==dist.end()){
+          dist[adj[j]] = d+1;
+          shells[d]->push_back(adj[j]);
+        }
+      }// for j
+    }// for i
+    front = *shells[d];
+  }// for d
+
+}
+
+
 void System::show_atoms(){
 /**
   Print out the information for all atoms
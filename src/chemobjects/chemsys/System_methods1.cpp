@@ -51,91 +51,60 @@ void System::Generate_Connectivity_Matrix(){
 }
 
 
-void System::Assign_Rings(){
+void System::Assign_Rings(int max_ring_size){
 /**
+  \param[in] max_ring_size The largest ring to be looked for. Use a non-positive value to remove this limit
+
   This function assings the rings - meaning it determines how many and which rings are present in the system. 
-  Carefully - this may become a very slow procedure for large and dense graphs. 
+  The smallest set of smallest rings is found with the sparse algorithm (see find_sssr in math_graph), so
+  the cost grows linearly with the system size. The results are kept in the Rings array and the ring 
+  membership is cached for each atom (Atom_ring_sizes, Atom_min_ring_size - 1 for the atoms not in rings).
+  If the topology has not changed since the last call with the same max_ring_size, nothing is recomputed.
 */
 
-  cout<<"In System::Assign_Rings\n";
-  typedef GRAPH<Atom*,Group*> Graph;
-  Graph g;
-  // Create a vertices of the graph
-  for(int i2=0;i2<Number_of_atoms;i2++){
-    VERTEX<Atom*> vrtx(&Atoms[i2]);
-    g.ADD_VERTEX(vrtx);
-  }
-  // Create edges of the graph
-  for(int i3=0;i3<Number_of_bonds;i3++){
-    int indx1 = Bonds[i3].globAtom_Index[0];
-    int indx2 = Bonds[i3].globAtom_Index[1];
-    EDGE<Group*> edg(indx1,indx2,0,&Bonds[i3]);
-    g.ADD_EDGE(edg);
-  }
+  if(rings_nat==Number_of_atoms && rings_nbonds==Number_of_bonds && rings_max_size==max_ring_size){ return; }
 
-  vector<Path> rings;
+  cout<<"In System::Assign_Rings\n";
 
-//  std::cout<<std::endl<<"Original graph"<<std::endl;
-//  int _V_ = g.show_vertices(1);
-//  int _E_ = g.show_edges(1);
-//  std::cout<<"_V_ = "<<_V_<<std::endl;
-//  std::cout<<"_E_ = "<<_E_<<std::endl;
+  int i,j,sz;
 
-  // Reduce graph 
-  g.REDUCE_GRAPH();
+  // Reset the previous assignment
+  Rings.clear();
+  Number_of_rings = 0;
+  for(i=0;i<Number_of_atoms;i++){
+    Atoms[i].Atom_ring_sizes.clear();
+    Atoms[i].is_Atom_ring_sizes = 0;
+  }
 
-//  std::cout<<std::endl<<"Reduced Original graph"<<std::endl;
-//  _V_ = g.show_vertices(1);
-//  _E_ = g.show_edges(1);
-//  std::cout<<"_V_ = "<<_V_<<std::endl;
-//  std::cout<<"_E_ = "<<_E_<<std::endl;
+  // The molecular graph
+  vector< vector<int> > adj(Number_of_atoms);
+  for(i=0;i<Number_of_atoms;i++){  adj[i] = Atoms[i].globAtom_Adjacent_Atoms;  }
 
   // Find the smallest rings 
-  // !!! This option is commented by default - uncomment it when you need the information about rings !!!!
-  g.FIND_SSSR(rings);
+  vector< vector<int> > rings;
+  int nrings = find_sssr(adj, rings, max_ring_size);
+  cout<<"Ring search completed. Number of rings found is "<<nrings<<endl;   
 
   // Now assign
-  int indx,i,j,nrings,sz;
-  nrings = rings.size();
-//  cout<<"nrings = "<<nrings<<endl;
   for(i=0;i<nrings;i++){
     sz = rings[i].size();
     Group rng;
-    int loc_indx = 0;
-//    cout<<"Ring "<<i<<" : ";
 
     for(j=0;j<sz;j++){
-      int indx1 = g.E[rings[i][j]].edge_vertex_id1;
-      int indx2 = g.E[rings[i][j]].edge_vertex_id2;
-
-      if(!is_in_vector(indx1,rng.globAtom_Index)){
-        rng.globAtom_Index.push_back(indx1);
-        rng.locAtom_Index.push_back(loc_indx++); 
-        rng.Group_Size++;
-        rng.globGroup_Size++;
-        rng.locGroup_Size++;
-      }
-      if(!is_in_vector(indx2,rng.globAtom_Index)){ 
-        rng.globAtom_Index.push_back(indx2);
-        rng.locAtom_Index.push_back(loc_indx++);
-        rng.Group_Size++;
-        rng.globGroup_Size++;
-        rng.locGroup_Size++;
-      }
-
-//      cout<<Atoms[indx1].Atom_id<<"  "<<Atoms[indx2].Atom_id<<"  ";
+      int indx = rings[i][j];
 
-      if(!is_in_vector(sz,Atoms[indx1].Atom_ring_sizes)){
-        Atoms[indx1].Atom_ring_sizes.push_back(sz);
-        Atoms[indx1].is_Atom_ring_sizes = 1;
-      }
+      rng.globAtom_Index.push_back(indx);
+      rng.locAtom_Index.push_back(j); 
+      rng.Group_Size++;
+      rng.globGroup_Size++;
+      rng.locGroup_Size++;
 
-      if(!is_in_vector(sz,Atoms[indx2].Atom_ring_sizes)){
-        Atoms[indx2].Atom_ring_sizes.push_back(sz);
-        Atoms[indx2].is_Atom_ring_sizes = 1;
+      if(!is_in_vector(sz,Atoms[indx].Atom_ring_sizes)){
+        Atoms[indx].Atom_ring_sizes.push_back(sz);
+        Atoms[indx].is_Atom_ring_sizes = 1;
       }
     }// for j
-//    cout<<endl;
+
     rng.globGroup_Index = Number_of_rings;
     Rings.push_back(rng);
     Number_of_rings++;
@@ -144,19 +113,28 @@ void System::Assign_Rings(){
 
   for(i=0;i<Number_of_atoms;i++){
     sz = Atoms[i].Atom_ring_sizes.size();
-    cout<<"i= "<<i<<" number of rings this atom belong to = "<<sz<<endl;
-    int min_sz=1;
-    if(sz>=1){ min_sz = Atoms[i].Atom_ring_sizes[0];}
-    else{
-      for(j=0;j<sz-1;j++){
-        min_sz=(Atoms[i].Atom_ring_sizes[j]<=Atoms[i].Atom_ring_sizes[j+1])?Atoms[i].Atom_ring_sizes[j]:Atoms[i].Atom_ring_sizes[j+1];
-      }
+    int min_sz = 1;  // not in a ring
+    if(sz>=1){
+      min_sz = Atoms[i].Atom_ring_sizes[0];
+      for(j=1;j<sz;j++){  if(Atoms[i].Atom_ring_sizes[j]<min_sz){ min_sz = Atoms[i].Atom_ring_sizes[j]; }  }
     }      
     Atoms[i].Atom_min_ring_size = min_sz;
-
-    cout<<"Atom i="<<i<<" belongs to the minimal ring of size = "<<Atoms[i].Atom_min_ring_size<<endl;
+    Atoms[i].is_Atom_min_ring_size = 1;
   }// for i
 
+  rings_nat = Number_of_atoms;
+  rings_nbonds = Number_of_bonds;
+  rings_max_size = max_ring_size;
+
+}
+
+void System::Assign_Rings(){
+/**
+  Same as above, looking for the rings with up to 8 atoms - this covers the usual (aromatic, cage, etc.) rings.
+  The macrocycles are found only when the larger max_ring_size is requested explicitly
+*/
+
+  Assign_Rings(8);
 
 }
 
@@ -18,9 +18,11 @@
 #include "../../pch.h"
 #else
 #include <map>
+#include <algorithm>
 #endif
 
 #include "System.h"
+#include "../../Units.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -86,6 +88,7 @@ void System::create_bond(int a1,int a2,int exclude12){
         bond.globMolecule_Index = Atoms[a1].globMolecule_Index;
 
         Bonds.push_back(bond);
+        index_bond(Bonds.size()-1);
 
       //-------------- Create fragmental bond ------------------------
       int g1,g2;
@@ -161,6 +164,7 @@ void System::create_angle(int a1,int a2,int a3,int exclude13){
         angle.globMolecule_Index = Atoms[a1].globMolecule_Index;
 
         Angles.push_back(angle);
+        index_angle(Angles.size()-1);
     
       //-------------- Create fragmental angle ------------------------
       int g1,g2,g3;
@@ -239,6 +243,7 @@ void System::create_dihedral(int a1,int a2,int a3,int a4,int exclude14){
         dihedral.globMolecule_Index = Atoms[a1].globMolecule_Index;
 
         Dihedrals.push_back(dihedral);
+        index_dihedral(Dihedrals.size()-1);
 
       //-------------- Create fragmental dihedral ------------------------
       int g1,g2,g3,g4;
@@ -308,7 +313,8 @@ void System::create_improper(int a1,int a2,int a3,int a4){
     improper.locGroup_Index = Molecules[Atoms[a1].globMolecule_Index].Molecule_Number_of_impropers;
     Molecules[Atoms[a1].globMolecule_Index].Molecule_Number_of_impropers++;
     improper.globMolecule_Index = Atoms[a1].globMolecule_Index;
-    Impropers.push_back(improper); 
+    Impropers.push_back(improper);
+    index_improper(Impropers.size()-1);
 
     //-------------- Create fragmental improper ------------------------
     int g1,g2,g3,g4;
@@ -359,6 +365,7 @@ void System::create_improper(int a1,int a2,int a3,int a4){
       // Erase it from the Impropers list:
       //------- Effective erasing of the impr_indx-th (for short i-th) improper ------------
       int last = Number_of_impropers-1;
+      int center = Impropers[impr_indx].globAtom_Index[0];
 
       // Copy last pair to i-th position
       Impropers[impr_indx] = Impropers[last];
@@ -368,6 +375,12 @@ void System::create_improper(int a1,int a2,int a3,int a4){
       // Delete last pair (just copied - avoid pair repetition)
       Impropers.pop_back();
       Number_of_impropers--;
+
+      // Update the index in place: drop the erased improper, the last one is now at impr_indx
+      std::unordered_map<int,int>::iterator it = improper_index.find(center);
+      if(it!=improper_index.end() && it->second==impr_indx){ improper_index.erase(it); }
+      if(impr_indx<last){ improper_index[Impropers[impr_indx].globAtom_Index[0]] = impr_indx; }
+      n_indexed_impropers--;
       //-------------------------------------------------------------------------------------------
 
     }// if impr_indx>=0
@@ -512,6 +525,7 @@ void System::CREATE_ATOM(Atom at1){
     //for(int i=0;i<(Number_of_atoms-1);i++){
 
     Atoms.push_back(at);
+    index_atom(Atoms.size()-1);
 
     // Run over ALL atoms that currently exist, so this will include self-self pairs!
     for(int i=0;i<Number_of_atoms;i++){
@@ -1362,193 +1376,306 @@ void System::GROUP_ATOMS(boost::python::list atoms_list,int Group_Id){
 
 
 
-void System::CREATE_BONDS(boost::python::list atoms_list,boost::python::dict valence_by_element){
+double covalent_radius(std::string elt){
 /**
-  \param[in] atoms_list The list of the IDs of the atoms that are considered in automatic bonding assignment
-  \param[in] valence_by_element Defines the valences (the maximal number of connections a given element may have) of elements
+  \param[in] elt The element symbol
 
-  This function will search for neighbour atoms. If the atoms
-  are located on the distance smaller then the sum of their 
-  radii (+/- some tolerance) and if the valence is satisfied then 
-  the bond between atoms will be created. If necessary the 
-  order of the bond will be assigned to value bigger then 1.
-  Only atoms from the atom list will be considered.
-  hyper_atoms dictionalry specifies some special cases of hypervalent atoms
-  this dictionalry contains pairs: [ atom element : valence ]
+  Returns the single-bond covalent radius of the element [a.u.], B. Cordero et al.
+  Dalton Trans. 2008, 2832. For the elements not in the table, 1.5 Angstrom is returned
+*/
+
+  static const std::map<std::string,double> radii = {
+    {"H",0.31}, {"He",0.28}, {"Li",1.28}, {"Be",0.96}, {"B",0.84}, {"C",0.76}, {"N",0.71}, {"O",0.66},
+    {"F",0.57}, {"Ne",0.58}, {"Na",1.66}, {"Mg",1.41}, {"Al",1.21}, {"Si",1.11}, {"P",1.07}, {"S",1.05},
+    {"Cl",1.02}, {"Ar",1.06}, {"K",2.03}, {"Ca",1.76}, {"Sc",1.70}, {"Ti",1.60}, {"V",1.53}, {"Cr",1.39},
+    {"Mn",1.39}, {"Fe",1.32}, {"Co",1.26}, {"Ni",1.24}, {"Cu",1.32}, {"Zn",1.22}, {"Ga",1.22}, {"Ge",1.20},
+    {"As",1.19}, {"Se",1.20}, {"Br",1.20}, {"Kr",1.16}, {"Rb",2.20}, {"Sr",1.95}, {"Y",1.90}, {"Zr",1.75},
+    {"Nb",1.64}, {"Mo",1.54}, {"Tc",1.47}, {"Ru",1.46}, {"Rh",1.42}, {"Pd",1.39}, {"Ag",1.45}, {"Cd",1.44},
+    {"In",1.42}, {"Sn",1.39}, {"Sb",1.39}, {"Te",1.38}, {"I",1.39}, {"Xe",1.40}, {"Cs",2.44}, {"Ba",2.15},
+    {"La",2.07}, {"Hf",1.75}, {"Ta",1.70}, {"W",1.62}, {"Re",1.51}, {"Os",1.44}, {"Ir",1.41}, {"Pt",1.36},
+    {"Au",1.36}, {"Hg",1.32}, {"Tl",1.45}, {"Pb",1.46}, {"Bi",1.48}
+  };
+
+  std::map<std::string,double>::const_iterator it = radii.find(elt);
+  return ((it!=radii.end())? it->second : 1.5) * Angst;
+}
+
+int default_valence(std::string elt){
+/**
+  \param[in] elt The element symbol
 
+  Returns the maximal number of connections the atom of given element is allowed to make
+  in the automatic bond perception, unless defined by the user. Metals and the elements not
+  in the table may have up to 8 connections
 */
 
-  vector<int> at_indexes; // Indexes of the atoms in the list, not their IDs
-  vector<int> at_valences;
-  // Sorted
-  vector<int> at_indexes_sorted;
-  vector<int> at_valences_sorted;
-  int i,j;
-  int id,indx;
-  int grp,per;
-  int sz;
-  std::string blk;
-  std::string elt;
-  int val,max_val;  
+  static const std::map<std::string,int> valences = {
+    {"H",1}, {"He",0}, {"Li",1}, {"Be",2}, {"B",3}, {"C",4}, {"N",3}, {"O",2}, {"F",1}, {"Ne",0},
+    {"Na",1}, {"Mg",2}, {"Si",4}, {"P",5}, {"S",6}, {"Cl",1}, {"Ar",0}, {"K",1}, {"Ca",2},
+    {"Ge",4}, {"As",5}, {"Se",6}, {"Br",1}, {"Kr",0}, {"I",1}, {"Xe",0}
+  };
 
-//------- Zero step: Determine the maximal possible valence, determined by user
-  max_val = 8;
-  for(i=0;i<len(valence_by_element.values());i++){
-    val = extract<int>(valence_by_element.values()[i]);
-    if(val>max_val) {max_val = val;}
-  }// for i
+  std::map<std::string,int>::const_iterator it = valences.find(elt);
+  return (it!=valences.end())? it->second : 8;
+}
 
-//-------- First step: Create array of atom indexes --------------
-  sz = len(atoms_list);
-  for(i=0;i<sz;i++){
-    id = extract<int>(atoms_list[i]);      
-    int is_found = 0;
-    j = get_atom_index_by_atom_id(id);
-    if(j!=-1){ at_indexes.push_back(j); }
-    else{ cout<<"Error: Can not find atom with id = "<<id<<endl; }
-  }
 
-//--------- Second step: Calculate valence of the atoms -------------
-  sz = at_indexes.size();
-  for(i=0;i<sz;i++){
-    indx = at_indexes[i];
-       // Get the position of the atom in Periodic Table
+int System::perceive_bonds(vector<int>& active){
+/**
+  \param[in] active The flags (one per each atom in perc_atoms) telling which atoms have to be examined
 
-//       if(os.ObjectSpace_Atoms[indx].is_Atom_group){ grp = os.ObjectSpace_Atoms[indx].Atom_group; }
-//       else{ /* Alternative handling */    }
+  This is the engine of the automatic bond perception. The atoms are hashed into a uniform grid with
+  the cell size equal to the longest possible bond, so the candidate partners of each atom are found
+  only in the 27 neighboring cells. Only the pairs with at least one active atom are considered.
+  The pairs are linked in the order of increasing ratio of the distance to the sum of the covalent
+  radii (the shortest relative contacts first), as long as both atoms have the unsaturated valence.
 
-//       if(os.ObjectSpace_Atoms[indx].is_Atom_period){ per = os.ObjectSpace_Atoms[indx].Atom_period; }
-//       else{ /* Alternative handling */    }
-     
-//       if(os.ObjectSpace_Atoms[indx].is_Atom_block){  blk = os.ObjectSpace_Atoms[indx].Atom_block;  }
-//       else{ /* Alternative handling */    }
+  Returns the number of the new bonds
+*/
 
-//       if(os.ObjectSpace_Atoms[indx].is_Atom_element){elt = os.ObjectSpace_Atoms[indx].Atom_element;  }
-//       else{ /* Alternative handling */    }
+  int i,j,k,a;
+  int n = perc_atoms.size();
+  if(n==0){ return 0; }
 
+  int is_pbc = (perc_periodic && is_Box);
 
+  double max_rad = 0.0;
+  for(i=0;i<n;i++){  if(perc_radius[i]>max_rad){ max_rad = perc_radius[i]; }  }
+  double cell = 2.0*max_rad + perc_tol;
 
-       if(!valence_by_element.has_key(elt)){
-       // Now calculate maximal valence
-       if((blk == "S" )||(blk == "P")){
-          val = ((grp<=4)?grp:(8-grp));
-       }
-       else if(blk == "D"){
-          val = grp;
-       }
-       else if(blk == "F"){
-          val = 3;
-       }
+  // Grid coordinates: fractional coordinates for the periodic case, Cartesian otherwise
+  vector<VECTOR> s(n);
+  int ncell[3] = {1, 1, 1};
+  MATRIX3x3 inv_box;
+  VECTOR rmin;
+
+  if(is_pbc){
+    inv_box = Box.inverse();
+    VECTOR t1, t2, t3;  Box.get_vectors(t1, t2, t3);
+    double V = fabs(Box.Determinant());
+    VECTOR c23, c31, c12;
+    c23.cross(t2,t3);  c31.cross(t3,t1);  c12.cross(t1,t2);
+    double w[3] = { V/c23.length(), V/c31.length(), V/c12.length() }; // widths of the cell along the normals
 
-       // Also take into account some other connections
-//       val = val - os.ObjectSpace_Atoms[indx].globAtom_Adjacent_Atoms.size();
+    for(a=0;a<3;a++){  ncell[a] = (int)(w[a]/cell);  if(ncell[a]<1){ ncell[a] = 1; }  }
 
-       }else{
-       val = extract<int>(valence_by_element.get(elt));
-       } 
+    for(i=0;i<n;i++){
+      s[i] = inv_box * Atoms[perc_atoms[i]].Atom_RB.rb_cm;
+      s[i].x -= floor(s[i].x);  s[i].y -= floor(s[i].y);  s[i].z -= floor(s[i].z);
+    }
+  }
+  else{
+    rmin = Atoms[perc_atoms[0]].Atom_RB.rb_cm;
+    for(i=1;i<n;i++){
+      VECTOR& r = Atoms[perc_atoms[i]].Atom_RB.rb_cm;
+      if(r.x<rmin.x){ rmin.x = r.x; }   if(r.y<rmin.y){ rmin.y = r.y; }   if(r.z<rmin.z){ rmin.z = r.z; }
+    }
+    for(i=0;i<n;i++){  s[i] = Atoms[perc_atoms[i]].Atom_RB.rb_cm - rmin;  }
+  }
 
+  // Integer cell coordinates of all atoms
+  vector<int> cx(n), cy(n), cz(n);
+  for(i=0;i<n;i++){
+    if(is_pbc){
+      cx[i] = ((int)(s[i].x*ncell[0])) % ncell[0];
+      cy[i] = ((int)(s[i].y*ncell[1])) % ncell[1];
+      cz[i] = ((int)(s[i].z*ncell[2])) % ncell[2];
+    }
+    else{
+      cx[i] = (int)(s[i].x/cell);  cy[i] = (int)(s[i].y/cell);  cz[i] = (int)(s[i].z/cell);
+    }
+  }
 
-       at_valences.push_back(val);
+  std::unordered_map<long long, vector<int> > grid;
+  for(i=0;i<n;i++){
+    long long key = (((long long)cx[i])<<42) | (((long long)cy[i])<<21) | ((long long)cz[i]);
+    grid[key].push_back(i);
+  }
 
-   }// for i
+  // Collect the candidate pairs
+  vector< pair<double, pair<int,int> > > cand;
 
-//--------- Third step: Sort valences and reindex at_indexes array ---------
-   for(i=max_val;i>=1;i--){// The maximal valence is 8     
-  
-      for(j=0;j<at_valences.size();j++){
+  for(i=0;i<n;i++){
+    if(!active[i]){ continue; }
 
-          if(at_valences[j]==i){
-             at_valences_sorted.push_back(at_valences[j]); 
-             at_indexes_sorted.push_back(at_indexes[j]);
+    vector<long long> visited; // to not visit the same cell twice, when there are less than 3 cells along some direction
 
-             at_valences.erase(at_valences.begin()+j);
-             at_indexes.erase(at_indexes.begin()+j);
+    for(int dx=-1;dx<=1;dx++){
+      for(int dy=-1;dy<=1;dy++){
+        for(int dz=-1;dz<=1;dz++){
 
-             j--;
+          int nx = cx[i]+dx, ny = cy[i]+dy, nz = cz[i]+dz;
+          if(is_pbc){
+            nx = (nx+ncell[0]) % ncell[0];  ny = (ny+ncell[1]) % ncell[1];  nz = (nz+ncell[2]) % ncell[2];
           }
-      }
+          else if(nx<0 || ny<0 || nz<0){ continue; }
 
-   }// for i
- 
-//--------- Fourth step: make pairs of atoms based on the relation between distance
-//--------- and the sum of the atomic (covalent) radii of corresponding atoms
+          long long key = (((long long)nx)<<42) | (((long long)ny)<<21) | ((long long)nz);
+          if(std::find(visited.begin(), visited.end(), key)!=visited.end()){ continue; }
+          visited.push_back(key);
+
+          std::unordered_map<long long, vector<int> >::iterator it = grid.find(key);
+          if(it==grid.end()){ continue; }
+
+          for(k=0;k<(int)it->second.size();k++){
+            j = it->second[k];
+            if(j==i){ continue; }
+            if(active[j] && j<i){ continue; }  // this pair is considered from the atom j
 
-   vector<connect> all_pairs;
+            VECTOR dr;
+            if(is_pbc){
+              VECTOR ds = s[j] - s[i];
+              ds.x -= floor(ds.x + 0.5);  ds.y -= floor(ds.y + 0.5);  ds.z -= floor(ds.z + 0.5);
+              dr = Box * ds;
+            }
+            else{  dr = s[j] - s[i];  }
 
-   double tol = 1.0;
-   int indx1,indx2;
-   double dist_real, dist_exp;
+            double d = dr.length();
+            double rsum = perc_radius[i] + perc_radius[j];
+            if(d < rsum + perc_tol){  cand.push_back( make_pair(d/rsum, make_pair(i,j)) );  }
 
-   sz = at_indexes_sorted.size();
+          }// for k
+        }// for dz
+      }// for dy
+    }// for dx
+  }// for i
 
-   for(i=0;i<(sz-1);i++){
+  std::sort(cand.begin(), cand.end());
 
-      connect pr;
-      pr.self = at_indexes_sorted[i];
+  // Link the atoms, respecting the valences
+  int num_new_bonds = 0;
+  for(k=0;k<(int)cand.size();k++){
+    i = cand[k].second.first;
+    j = cand[k].second.second;
 
-      for(j=i+1;j<sz;j++){
+    int indx1 = perc_atoms[i];
+    int indx2 = perc_atoms[j];
 
-          indx1 = at_indexes_sorted[i];
-          indx2 = at_indexes_sorted[j];
+    if(Find_Bond(indx1, indx2)>-1){ continue; }
+    if((int)Atoms[indx1].globAtom_Adjacent_Atoms.size() >= perc_valence[i]){ continue; }
+    if((int)Atoms[indx2].globAtom_Adjacent_Atoms.size() >= perc_valence[j]){ continue; }
 
-          if((at_valences_sorted[i]>=1)&&(at_valences_sorted[j]>=1)){ // Valence criterion
+    LINK_ATOMS(Atoms[indx1], Atoms[indx2]);
+    num_new_bonds++;
+  }
 
-          dist_real = 100.0; // Default value - Very far away
-//          if(os.ObjectSpace_Atoms[indx1].is_Atom_coords_cart&&os.ObjectSpace_Atoms[indx2].is_Atom_coords_cart){
-//          dist_real = (os.ObjectSpace_Atoms[indx1].Atom_coords_cart - os.ObjectSpace_Atoms[indx2].Atom_coords_cart).length();
-//          }
+  for(i=0;i<n;i++){  if(active[i]){ perc_ref[i] = Atoms[perc_atoms[i]].Atom_RB.rb_cm; }  }
 
-          dist_exp = 2.0;   // Default value - atoms which are separated by this much assumed to be connected
-//          if(os.ObjectSpace_Atoms[indx1].is_Atom_atomic_radius&&os.ObjectSpace_Atoms[indx2].is_Atom_atomic_radius){
-//          dist_exp = (os.ObjectSpace_Atoms[indx1].Atom_atomic_radius + os.ObjectSpace_Atoms[indx2].Atom_atomic_radius);
-//          }
+  return num_new_bonds;
+}
 
-          if(dist_real<=(dist_exp + tol)){ // Distance criterion            
 
-             pr.others.push_back(indx2);
-             at_valences_sorted[i]--;
-             at_valences_sorted[j]--;
+void System::CREATE_BONDS(boost::python::list atoms_list,boost::python::dict valence_by_element,double tol,int is_periodic){
+/**
+  \param[in] atoms_list The list of the IDs of the atoms that are considered in automatic bonding assignment
+  \param[in] valence_by_element Defines the valences (the maximal number of connections a given element may have) of elements
+  \param[in] tol The tolerance [a.u.]: the atoms are bonded if the distance is smaller than the sum of their radii plus tol
+  \param[in] is_periodic If set to 1 and the system has the Box defined, the minimum image distances are used
 
-          }// distance criterion
+  This function will search for neighbour atoms. If the atoms
+  are located on the distance smaller then the sum of their 
+  radii (+ tolerance) and if the valence is satisfied then 
+  the bond between atoms will be created.
+  Only atoms from the atom list will be considered.
+  The radii are taken from the Atom_atomic_radius (if defined) or from the covalent radii
+  of the elements. The valences of the elements not listed in valence_by_element are 
+  given by the default_valence function. The already existing connections count towards 
+  the valence.
 
-          }// valence criterion                 
+  The search uses the spatial hashing, so the cost grows linearly with the number of atoms.
+  The setup is memorized, so the bonding can be updated later with UPDATE_BONDS
+*/
 
-      }// for j
+  int i,j,id;
+  std::string elt;
 
-      if(pr.others.size()>0){
-         all_pairs.push_back(pr);
-      }
-      
-   }// for i
+//-------- First step: Create array of atom indexes --------------
+  perc_atoms.clear();  perc_valence.clear();  perc_radius.clear();  perc_ref.clear();
 
-//------- Fifth step: calculate bond orders (optional) ------------------
+  int sz = len(atoms_list);
+  for(i=0;i<sz;i++){
+    id = extract<int>(atoms_list[i]);      
+    j = get_atom_index_by_atom_id(id);
+    if(j!=-1){ perc_atoms.push_back(j); }
+    else{ cout<<"Error: Can not find atom with id = "<<id<<endl; }
+  }
 
+//--------- Second step: Valences and radii of the atoms -------------
+  sz = perc_atoms.size();
+  for(i=0;i<sz;i++){
+    Atom& at = Atoms[perc_atoms[i]];
+    elt = (at.is_Atom_element)? at.Atom_element : "";
 
-//-------Sixth step: Link atoms -----------------
-   sz = all_pairs.size();
-   int num_new_bonds = 0;
-   std::cout<<"In CREATE_BONDS function: "<<std::endl;
-   for(i=0;i<sz;i++){
- 
-     indx1 = all_pairs[i].self;
+    if(valence_by_element.has_key(elt)){  perc_valence.push_back( extract<int>(valence_by_element.get(elt)) );  }
+    else{ perc_valence.push_back( default_valence(elt) );   }
 
-     for(j=0;j<all_pairs[i].others.size();j++){
+    if(at.is_Atom_atomic_radius){  perc_radius.push_back(at.Atom_atomic_radius);  }
+    else{  perc_radius.push_back( covalent_radius(elt) ); }
 
-         indx2 = all_pairs[i].others[j];
+    perc_ref.push_back(at.Atom_RB.rb_cm);
+  }// for i
 
-         std::cout<<"LINK atoms with indexes "<<indx1<<" and "<<indx2<<std::endl;
+  perc_tol = tol;
+  perc_periodic = is_periodic;
 
-//         LINK_ATOMS(os,os.ObjectSpace_Atoms[indx1],os.ObjectSpace_Atoms[indx2]);
-         num_new_bonds++;
+//--------- Third step: Find and link the bonded pairs ---------
+  vector<int> active(sz, 1);
+  int num_new_bonds = perceive_bonds(active);
 
-     }// for j
+  std::cout<<"In CREATE_BONDS function: "<<num_new_bonds<<" new bonds created"<<std::endl;
 
-   }// for i
+}
 
-//------------------------------------------------------
-  
-//   return num_new_bonds;
+void System::CREATE_BONDS(boost::python::list atoms_list,boost::python::dict valence_by_element){
+/**
+  \param[in] atoms_list The list of the IDs of the atoms that are considered in automatic bonding assignment
+  \param[in] valence_by_element Defines the valences (the maximal number of connections a given element may have) of elements
+
+  Same as above, with the tolerance of 0.4 Angstrom. The periodic boundary conditions are used
+  if the Box is defined
+*/
+
+  CREATE_BONDS(atoms_list, valence_by_element, 0.4*Angst, is_Box);
+
+}
+
+int System::UPDATE_BONDS(double displ_threshold){
+/**
+  \param[in] displ_threshold The largest change [a.u.] of an interatomic distance that may go unexamined
+
+  Incremental re-perception of the bonding for the atoms set up in the last call of CREATE_BONDS.
+  The per-atom Verlet-list criterion is used: only the atoms displaced by more than displ_threshold/2
+  from their reference positions are marked, only the pairs that involve a marked atom are re-examined,
+  and only the marked atoms get new reference positions. A pair of unmarked atoms has not approached
+  by more than displ_threshold relative to their reference positions, so calling this function every
+  MD step is cheap. A reasonable choice of the threshold is a half of the tolerance used in CREATE_BONDS;
+  displ_threshold = 0 re-examines all the atoms that have moved at all.
+  Only new bonds are formed: the existing bonds are not broken.
+
+  Returns the number of the new bonds
+*/
+
+  int sz = perc_atoms.size();
+  if(sz==0){
+    cout<<"Error in UPDATE_BONDS: the bond perception is not set up, call CREATE_BONDS first\n";
+    return 0;
+  }
+
+  vector<int> active(sz, 0);
+  int num_active = 0;
+  for(int i=0;i<sz;i++){
+    if(perc_atoms[i]>=Number_of_atoms){
+      cout<<"Error in UPDATE_BONDS: the atoms have been changed since the last call of CREATE_BONDS\n";
+      return 0;
+    }
+    double d = (Atoms[perc_atoms[i]].Atom_RB.rb_cm - perc_ref[i]).length();
+    if(d > 0.5*displ_threshold){ active[i] = 1; num_active++; }
+  }
+
+  if(num_active==0){ return 0; }
 
+  // perceive_bonds examines only the pairs with an active atom and resets only their reference positions
+  return perceive_bonds(active);
 }
 
 void System::CLONE_MOLECULE(int mol_id){
@@ -90,6 +90,16 @@ void System::update_atoms_for_fragment(int indx){
   }
 }
 
+void System::update_atoms_for_fragments(){
+/**
+  Recompute Cartesian coordinates of the atoms of all fragments from the rigid-body (fragmental) variables.
+  The fragments do not share atoms, so they are processed in parallel
+*/
+
+  #pragma omp parallel for
+  for(int i=0;i<Number_of_fragments;i++){  update_atoms_for_fragment(i);  }
+}
+
 void System::update_fragments_for_molecule(int indx){
 /// So far this function does nothing
 
@@ -347,6 +347,11 @@ void System::init_fragments(){
     delete [] masses;
     delete [] coords;
   }
+
+  // The recount above does not know about the holonomic constraints - each of them removes one more
+  // translational DOF (see add_constraint)
+  Nf_t -= Number_of_constraints;
+  is_cons_init = 0;
 }
 
 void System::init_molecules(){
@@ -679,6 +684,7 @@ void System::fix_fragment_translation(int gr_id){
     cout<<"Fixing fragment with indx = "<<indx<<". Translational DOFs\n";
     Fragments[indx].Group_RB.fix_translation();
     Nf_t -= 3;
+    is_cons_init = 0;   // the constraint clusters with this fragment are re-classified
   }
 }
 
@@ -705,6 +711,7 @@ void System::fix_fragment(int gr_id){
     cout<<"Fixing fragment with indx = "<<indx<<". Translational DOFs\n";
     Fragments[indx].Group_RB.fix_translation();
     Nf_t -= 3;
+    is_cons_init = 0;   // the constraint clusters with this fragment are re-classified
   }
   if(indx>-1){
     cout<<"Fixing fragment with indx = "<<indx<<". Rotational DOFs\n";
@@ -935,6 +942,9 @@ MATRIX3x3 System::pressure_tensor(){
   else if(stress_opt=="fr"){ Pvir = stress_fr; }
   else if(stress_opt=="ml"){ Pvir = stress_ml; }
 
+  // Contribution of the holonomic constraints
+  if(Number_of_constraints>0){ Pvir += stress_cons; }
+
   //-------------------------------------------------------------------------------
   if(is_Box){  P_tens = (Pid + Pvir)/(volume());  }
   else{ P_tens = 0.0; }
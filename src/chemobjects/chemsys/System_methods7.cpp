@@ -393,6 +393,40 @@ std::string System::get_xyz(int fold,std::string pbc_type,int frame){
 
 
 
+void System::get_traj_frame(libio::traj_frame& fr){
+/**
+  \param[out] fr The binary trajectory frame to be filled with the current state of the system
+
+  The atomic positions, velocities and forces are stored atom-wise (x, y, z of atom 0, then atom 1, ...),
+  in the internal units (a.u.). The box is stored row-wise (tv1, tv2, tv3) if defined. The electronic
+  populations and states, as well as the step and time of the frame are not changed
+*/
+
+  fr.pos.resize(3*Number_of_atoms);
+  fr.vel.resize(3*Number_of_atoms);
+  fr.frc.resize(3*Number_of_atoms);
+
+  for(int i=0;i<Number_of_atoms;i++){
+    RigidBody& rb = Atoms[i].Atom_RB;
+
+    fr.pos[3*i+0] = rb.rb_cm.x;    fr.pos[3*i+1] = rb.rb_cm.y;    fr.pos[3*i+2] = rb.rb_cm.z;
+    fr.vel[3*i+0] = rb.rb_v.x;     fr.vel[3*i+1] = rb.rb_v.y;     fr.vel[3*i+2] = rb.rb_v.z;
+    fr.frc[3*i+0] = rb.rb_force.x; fr.frc[3*i+1] = rb.rb_force.y; fr.frc[3*i+2] = rb.rb_force.z;
+  }
+
+  fr.box.clear();
+  if(is_Box){
+    VECTOR tv1,tv2,tv3;
+    Box.get_vectors(tv1,tv2,tv3);
+    fr.box.resize(9);
+    fr.box[0] = tv1.x; fr.box[1] = tv1.y; fr.box[2] = tv1.z;
+    fr.box[3] = tv2.x; fr.box[4] = tv2.y; fr.box[5] = tv2.z;
+    fr.box[6] = tv3.x; fr.box[7] = tv3.y; fr.box[8] = tv3.z;
+  }
+
+}
+
+
 }// namespace libchemsys
 }// namespace libchemobjects
 }// liblibra
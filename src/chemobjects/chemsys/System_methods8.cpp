@@ -0,0 +1,782 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 2 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file System_methods8.cpp
+  \brief The file implements the holonomic (bond-length) constraints: SHAKE/RATTLE, SETTLE, M-SHAKE and LINCS
+
+  The constraints act on the atoms which form the single-atom fragments, so they are used with the
+  flexible atomistic MD, in which all the propagated (fragmental) variables are atomic positions and momenta
+
+*/
+
+#include "System.h"
+#include "../../Units.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+/// libchemobjects namespace
+namespace libchemobjects{
+
+/// libchemsys namespace
+namespace libchemsys{
+
+
+/// Solves the dense linear system A*x = b (n x n, stored row-wise) by Gaussian elimination with partial pivoting
+/// A and b are destroyed. Returns 0 on success, 1 if the matrix is singular
+static int solve_dense(int n, vector<double>& A, vector<double>& b, vector<double>& x){
+
+  int i, j, k, piv;
+
+  for(k=0;k<n;k++){
+    piv = k;
+    for(i=k+1;i<n;i++){  if(fabs(A[i*n+k]) > fabs(A[piv*n+k])){ piv = i; }  }
+    if(fabs(A[piv*n+k]) < 1e-300){ return 1; }
+
+    if(piv!=k){
+      for(j=0;j<n;j++){ double tmp = A[k*n+j]; A[k*n+j] = A[piv*n+j]; A[piv*n+j] = tmp; }
+      double tmp = b[k]; b[k] = b[piv]; b[piv] = tmp;
+    }
+
+    for(i=k+1;i<n;i++){
+      double f = A[i*n+k]/A[k*n+k];
+      if(f==0.0){ continue; }
+      for(j=k;j<n;j++){  A[i*n+j] -= f*A[k*n+j];  }
+      b[i] -= f*b[k];
+    }
+  }
+
+  x.resize(n);
+  for(i=n-1;i>=0;i--){
+    double s = b[i];
+    for(j=i+1;j<n;j++){  s -= A[i*n+j]*x[j];  }
+    x[i] = s/A[i*n+i];
+  }
+  return 0;
+}
+
+
+
+void System::add_constraint(int at_indx1, int at_indx2, double d){
+/**
+  \param[in] at_indx1 The index of the first atom
+  \param[in] at_indx2 The index of the second atom
+  \param[in] d The target distance between the atoms [a.u.]
+
+  Add the bond-length constraint |r1 - r2| = d. Each of the atoms must form its own (single-atom) fragment.
+  Each constraint removes one translational DOF from the system. Adding an already existing constraint
+  only updates its target distance
+*/
+
+  if(at_indx1<0 || at_indx1>=Number_of_atoms || at_indx2<0 || at_indx2>=Number_of_atoms || at_indx1==at_indx2){
+    cout<<"Error in add_constraint: invalid atom indices "<<at_indx1<<" and "<<at_indx2<<"\nExiting...\n";
+    exit(0);
+  }
+
+  int fr1 = Atoms[at_indx1].globGroup_Index;
+  int fr2 = Atoms[at_indx2].globGroup_Index;
+  if(fr1<0 || fr1>=Number_of_fragments || fr2<0 || fr2>=Number_of_fragments){
+    cout<<"Error in add_constraint: the atoms must be assigned to fragments first (init_fragments())\nExiting...\n";
+    exit(0);
+  }
+  if(Fragments[fr1].Group_Size!=1 || Fragments[fr2].Group_Size!=1){
+    cout<<"Error in add_constraint: the constrained atoms "<<at_indx1<<" and "<<at_indx2
+        <<" must form single-atom fragments. Use the rigid-body fragments instead\nExiting...\n";
+    exit(0);
+  }
+
+  topo_key key = bond_key(at_indx1, at_indx2);
+  topo_index::iterator it = cons_index.find(key);
+  if(it!=cons_index.end()){ cons_d[it->second] = d; return; }
+
+  cons_index[key] = Number_of_constraints;
+  cons_at1.push_back(at_indx1);  cons_fr1.push_back(fr1);
+  cons_at2.push_back(at_indx2);  cons_fr2.push_back(fr2);
+  cons_d.push_back(d);
+  Number_of_constraints++;
+
+  Nf_t -= 1;
+  is_cons_init = 0;
+}
+
+
+void System::add_constraint(int at_indx1, int at_indx2){
+/**
+  \param[in] at_indx1 The index of the first atom
+  \param[in] at_indx2 The index of the second atom
+
+  Add the bond-length constraint that keeps the current distance between the atoms
+*/
+
+  VECTOR dr = Atoms[at_indx1].Atom_RB.rb_cm - Atoms[at_indx2].Atom_RB.rb_cm;
+  add_constraint(at_indx1, at_indx2, dr.length());
+}
+
+
+void System::CONSTRAIN_BONDS(std::string opt){
+/**
+  \param[in] opt The type of the constraints to add:
+  "h-bonds" - all bonds that involve hydrogen atoms
+  "all-bonds" - all bonds
+  "rigid-water" - the O-H and H-H distances of all water molecules (the O atom bonded to exactly two H atoms
+   which are bonded only to it). These clusters are solved by SETTLE
+
+  The constraints are set to the current bond lengths
+*/
+
+  int i;
+
+  if(opt=="h-bonds" || opt=="all-bonds"){
+    for(i=0;i<Number_of_bonds;i++){
+      int a1 = Bonds[i].globAtom_Index[0];
+      int a2 = Bonds[i].globAtom_Index[1];
+      int is_h = (Atoms[a1].Atom_element=="H" || Atoms[a2].Atom_element=="H");
+      if(opt=="all-bonds" || is_h){  add_constraint(a1, a2);  }
+    }
+  }
+  else if(opt=="rigid-water"){
+    for(i=0;i<Number_of_atoms;i++){
+      if(Atoms[i].Atom_element!="O"){ continue; }
+      vector<int>& nb = Atoms[i].globAtom_Adjacent_Atoms;
+      if(nb.size()!=2){ continue; }
+      int h1 = nb[0], h2 = nb[1];
+      if(Atoms[h1].Atom_element!="H" || Atoms[h2].Atom_element!="H"){ continue; }
+      if(Atoms[h1].globAtom_Adjacent_Atoms.size()!=1 || Atoms[h2].globAtom_Adjacent_Atoms.size()!=1){ continue; }
+
+      add_constraint(i, h1);
+      add_constraint(i, h2);
+      add_constraint(h1, h2);
+    }
+  }
+  else{
+    cout<<"Error in CONSTRAIN_BONDS: unknown option "<<opt<<". Allowed: h-bonds, all-bonds, rigid-water\nExiting...\n";
+    exit(0);
+  }
+
+}
+
+
+void System::clear_constraints(){
+/**
+  Remove all the holonomic constraints and return the constrained DOFs to the system
+*/
+
+  Nf_t += Number_of_constraints;
+  Number_of_constraints = 0;
+
+  cons_at1.clear();  cons_at2.clear();
+  cons_fr1.clear();  cons_fr2.clear();
+  cons_d.clear();    cons_index.clear();
+  cons_clusters.clear(); cons_cluster_type.clear(); cons_cluster_frags.clear();
+  stress_cons = 0.0;
+  is_cons_init = 0;
+}
+
+
+void System::init_constraints(){
+/**
+  Split the constraints into the clusters coupled through the shared atoms. The clusters are classified as:
+  0 - a single constraint (solved analytically for velocities, iteratively for positions)
+  1 - a coupled cluster (solved by the method set in constraint_method: SHAKE, M-SHAKE or LINCS)
+  2 - a rigid water molecule (solved by SETTLE for positions, exactly for velocities). SETTLE moves all
+      three atoms, so the molecules with a fixed-translation atom are left to the general solver (type 1)
+
+  This is called automatically, when the constraints are modified
+*/
+
+  int i, k, n;
+
+  // Union-find over fragments
+  vector<int> parent(Number_of_fragments);
+  for(i=0;i<Number_of_fragments;i++){ parent[i] = i; }
+
+  for(k=0;k<Number_of_constraints;k++){
+    int r1 = cons_fr1[k];  while(parent[r1]!=r1){ parent[r1] = parent[parent[r1]]; r1 = parent[r1]; }
+    int r2 = cons_fr2[k];  while(parent[r2]!=r2){ parent[r2] = parent[parent[r2]]; r2 = parent[r2]; }
+    if(r1!=r2){ parent[r1] = r2; }
+  }
+
+  std::unordered_map<int,int> root_to_cluster;
+  cons_clusters.clear();
+  cons_cluster_type.clear();
+  cons_cluster_frags.clear();
+
+  for(k=0;k<Number_of_constraints;k++){
+    int r = cons_fr1[k];  while(parent[r]!=r){ r = parent[r]; }
+
+    std::unordered_map<int,int>::iterator it = root_to_cluster.find(r);
+    if(it==root_to_cluster.end()){
+      root_to_cluster[r] = cons_clusters.size();
+      cons_clusters.push_back(vector<int>(1,k));
+    }
+    else{  cons_clusters[it->second].push_back(k);  }
+  }
+
+  n = cons_clusters.size();
+  cons_cluster_type = vector<int>(n, 1);
+  cons_cluster_frags = vector< vector<int> >(n);
+
+  for(i=0;i<n;i++){
+    vector<int>& cl = cons_clusters[i];
+    vector<int>& frs = cons_cluster_frags[i];
+
+    for(k=0;k<(int)cl.size();k++){
+      if(!is_in_vector(cons_fr1[cl[k]], frs)){ frs.push_back(cons_fr1[cl[k]]); }
+      if(!is_in_vector(cons_fr2[cl[k]], frs)){ frs.push_back(cons_fr2[cl[k]]); }
+    }
+
+    if(cl.size()==1){ cons_cluster_type[i] = 0; }
+
+    else if(cl.size()==3 && frs.size()==3){
+      // A triangle: check whether this is a rigid water - the "O" apex has two equal sides,
+      // and the two "H" atoms have equal masses
+      for(int apex=0;apex<3;apex++){
+        int o = frs[apex], h1 = frs[(apex+1)%3], h2 = frs[(apex+2)%3];
+        int k_oh1 = -1, k_oh2 = -1, k_hh = -1;
+        for(k=0;k<3;k++){
+          int f1 = cons_fr1[cl[k]], f2 = cons_fr2[cl[k]];
+          if((f1==o && f2==h1) || (f1==h1 && f2==o)){ k_oh1 = cl[k]; }
+          else if((f1==o && f2==h2) || (f1==h2 && f2==o)){ k_oh2 = cl[k]; }
+          else{ k_hh = cl[k]; }
+        }
+        double m1 = Fragments[h1].Group_RB.rb_mass;
+        double m2 = Fragments[h2].Group_RB.rb_mass;
+        int is_free = (constraint_inv_mass(o)>0.0 && constraint_inv_mass(h1)>0.0 && constraint_inv_mass(h2)>0.0);
+
+        if(is_free && k_oh1>=0 && k_oh2>=0 && k_hh>=0 && fabs(cons_d[k_oh1]-cons_d[k_oh2])<1e-8 && fabs(m1-m2)<1e-8*m1 &&
+           cons_d[k_hh] < 2.0*cons_d[k_oh1] ){
+          cons_cluster_type[i] = 2;
+          frs[0] = o; frs[1] = h1; frs[2] = h2;
+          cl[0] = k_oh1; cl[1] = k_oh2; cl[2] = k_hh;
+          break;
+        }
+      }// for apex
+    }
+
+  }// for i
+
+  if((int)cons_ref.size()!=Number_of_fragments){ cons_ref = vector<VECTOR>(Number_of_fragments); }
+  is_cons_init = 1;
+}
+
+
+double System::constraint_inv_mass(int fr){
+/**
+  \param[in] fr The index of the fragment
+  Returns the inverse mass of the fragment as seen by the constraints - zero for the fragments with fixed translation
+*/
+  RigidBody& top = Fragments[fr].Group_RB;
+  if(top.is_fixed_translation){ return 0.0; }
+  return top.rb_iM;
+}
+
+
+void System::constraint_shift(int fr, const VECTOR& dr, double dt){
+/**
+  \param[in] fr The index of the fragment
+  \param[in] dr The constraint correction of the position of the fragment
+  \param[in] dt The time step of the drift
+
+  Apply the position correction and the consistent momentum correction p += m*dr/dt.
+  The constraint virial is accumulated by the callers, from the constraint (pair) vectors
+*/
+  RigidBody& top = Fragments[fr].Group_RB;
+  double iM = constraint_inv_mass(fr);
+  if(iM<=0.0){ return; }
+
+  VECTOR dp = dr/(iM*dt);
+
+  top.shift_position(dr);
+  top.set_momentum(top.rb_p + dp);
+}
+
+
+void System::constraint_pair_shift(int k, const VECTOR& g, double dt){
+/**
+  \param[in] k The index of the constraint
+  \param[in] g The constraint displacement (per unit inverse mass) along the constraint direction
+  \param[in] dt The time step of the drift
+
+  Shift the first atom of the constraint by iM1*g and the second one by -iM2*g. The pair impulse g/dt is added
+  to the constraint virial with the constraint vector r_12 at the beginning of the step, like in
+  apply_velocity_constraints() - not with the absolute positions, which are not continuous across the periodic
+  boundaries
+*/
+  int f1 = cons_fr1[k], f2 = cons_fr2[k];
+  VECTOR dp = g/dt;
+  MATRIX3x3 tmp;
+
+  constraint_shift(f1,  constraint_inv_mass(f1)*g, dt);
+  constraint_shift(f2, -constraint_inv_mass(f2)*g, dt);
+
+  tmp.tensor_product(cons_ref[f1] - cons_ref[f2], dp);
+  stress_cons += tmp/dt;
+}
+
+
+void System::save_constraint_reference(){
+/**
+  Store the positions of the constrained fragments at the beginning of the MD step (they satisfy the constraints)
+  and reset the constraint virial of the step. Must be called before the positions are drifted
+*/
+
+  if(Number_of_constraints==0){ return; }
+  if(!is_cons_init){ init_constraints(); }
+
+  for(int i=0;i<(int)cons_cluster_frags.size();i++){
+    for(int j=0;j<(int)cons_cluster_frags[i].size();j++){
+      int fr = cons_cluster_frags[i][j];
+      cons_ref[fr] = Fragments[fr].Group_RB.rb_cm;
+    }
+  }
+  stress_cons = 0.0;
+}
+
+
+int System::shake_cluster(int c, double dt){
+/**
+  \param[in] c The index of the cluster
+  \param[in] dt The time step of the drift
+
+  Iterative SHAKE for one cluster: the constraints are corrected one after another along the reference bond directions.
+  Returns the number of iterations used
+
+  Ryckaert, J.-P.; Ciccotti, G.; Berendsen, H. J. C. J. Comput. Phys. 1977, 23, 327-341
+*/
+
+  vector<int>& cl = cons_clusters[c];
+  int iter, k, done = 0;
+
+  for(iter=0; iter<constraint_max_iter && !done; iter++){
+    done = 1;
+    for(k=0;k<(int)cl.size();k++){
+      int ik = cl[k];
+      int f1 = cons_fr1[ik], f2 = cons_fr2[ik];
+      double iM1 = constraint_inv_mass(f1);
+      double iM2 = constraint_inv_mass(f2);
+      if(iM1+iM2<=0.0){ continue; }
+
+      double d2 = cons_d[ik]*cons_d[ik];
+      VECTOR r = Fragments[f1].Group_RB.rb_cm - Fragments[f2].Group_RB.rb_cm;
+      double diff = d2 - r.length2();
+
+      if(fabs(diff) > 2.0*constraint_tol*d2){
+        done = 0;
+        VECTOR r0 = cons_ref[f1] - cons_ref[f2];
+        double rr0 = r*r0;
+        if(rr0 < 1e-6*d2){
+          cout<<"Error in SHAKE: the constraint between atoms "<<cons_at1[ik]<<" and "<<cons_at2[ik]
+              <<" has rotated by more than 90 degrees. Reduce the time step\nExiting...\n";
+          exit(0);
+        }
+        double g = diff/(2.0*(iM1+iM2)*rr0);
+        constraint_pair_shift(ik, g*r0, dt);
+      }
+    }// for k
+  }// for iter
+
+  if(!done){
+    cout<<"Warning: SHAKE has not converged in "<<constraint_max_iter<<" iterations for the cluster "<<c<<endl;
+  }
+  return iter;
+}
+
+
+int System::mshake_cluster(int c, double dt){
+/**
+  \param[in] c The index of the cluster
+  \param[in] dt The time step of the drift
+
+  Matrix SHAKE for one cluster: all the Lagrange multipliers of the cluster are found simultaneously by the
+  Newton iterations on the linearized constraint equations. Converges quadratically for the strongly coupled clusters.
+  Returns the number of iterations used
+
+  Kraeutler, V.; van Gunsteren, W. F.; Huenenberger, P. H. J. Comput. Chem. 2001, 22, 501-508
+*/
+
+  vector<int>& cl = cons_clusters[c];
+  int n = cl.size();
+  int iter, k, l, done = 0;
+
+  vector<VECTOR> r0(n);
+  for(k=0;k<n;k++){  r0[k] = cons_ref[cons_fr1[cl[k]]] - cons_ref[cons_fr2[cl[k]]];  }
+
+  vector<double> A(n*n), b(n), lambda(n);
+
+  for(iter=0; iter<constraint_max_iter; iter++){
+    done = 1;
+    vector<VECTOR> r(n);
+    for(k=0;k<n;k++){
+      int ik = cl[k];
+      double d2 = cons_d[ik]*cons_d[ik];
+      r[k] = Fragments[cons_fr1[ik]].Group_RB.rb_cm - Fragments[cons_fr2[ik]].Group_RB.rb_cm;
+      b[k] = d2 - r[k].length2();
+      if(fabs(b[k]) > 2.0*constraint_tol*d2){ done = 0; }
+    }
+    if(done){ break; }
+
+    // d(sigma_k)/d(lambda_l) = 2 r_k * (coupling_kl * r0_l), the coupling is the signed sum of the inverse masses of the shared atoms
+    for(k=0;k<n;k++){
+      int ik = cl[k];
+      for(l=0;l<n;l++){
+        int il = cl[l];
+        double cpl = 0.0;
+        if(cons_fr1[ik]==cons_fr1[il]){ cpl += constraint_inv_mass(cons_fr1[ik]); }
+        if(cons_fr1[ik]==cons_fr2[il]){ cpl -= constraint_inv_mass(cons_fr1[ik]); }
+        if(cons_fr2[ik]==cons_fr1[il]){ cpl -= constraint_inv_mass(cons_fr2[ik]); }
+        if(cons_fr2[ik]==cons_fr2[il]){ cpl += constraint_inv_mass(cons_fr2[ik]); }
+        A[k*n+l] = 2.0*cpl*(r[k]*r0[l]);
+      }
+    }
+
+    if(solve_dense(n, A, b, lambda)){
+      cout<<"Error in M-SHAKE: singular constraint matrix for the cluster "<<c<<"\nExiting...\n";
+      exit(0);
+    }
+
+    for(k=0;k<n;k++){
+      constraint_pair_shift(cl[k], lambda[k]*r0[k], dt);
+    }
+  }// for iter
+
+  if(!done){
+    cout<<"Warning: M-SHAKE has not converged in "<<constraint_max_iter<<" iterations for the cluster "<<c<<endl;
+  }
+  return iter;
+}
+
+
+int System::lincs_cluster(int c, double dt){
+/**
+  \param[in] c The index of the cluster
+  \param[in] dt The time step of the drift
+
+  LINCS for one cluster: the inverse of the constraint coupling matrix is approximated by the series expansion
+  of the order lincs_order, followed by one correction for the rotational lengthening. Non-iterative.
+  Returns the number of the matrix expansions done (2)
+
+  Hess, B.; Bekker, H.; Berendsen, H. J. C.; Fraaije, J. G. E. M. J. Comput. Chem. 1997, 18, 1463-1472
+*/
+
+  vector<int>& cl = cons_clusters[c];
+  int n = cl.size();
+  int k, l, pass, rec;
+
+  vector<VECTOR> B(n);
+  vector<double> S(n), rhs(n), sol(n), tmp(n);
+  vector<double> A(n*n, 0.0);
+
+  for(k=0;k<n;k++){
+    int ik = cl[k];
+    B[k] = cons_ref[cons_fr1[ik]] - cons_ref[cons_fr2[ik]];
+    B[k] = B[k]/B[k].length();
+    double im = constraint_inv_mass(cons_fr1[ik]) + constraint_inv_mass(cons_fr2[ik]);
+    S[k] = (im>0.0) ? 1.0/sqrt(im) : 0.0;
+  }
+
+  for(k=0;k<n;k++){
+    int ik = cl[k];
+    for(l=0;l<n;l++){
+      if(l==k){ continue; }
+      int il = cl[l];
+      double cpl = 0.0;
+      if(cons_fr1[ik]==cons_fr1[il]){ cpl += constraint_inv_mass(cons_fr1[ik]); }
+      if(cons_fr1[ik]==cons_fr2[il]){ cpl -= constraint_inv_mass(cons_fr1[ik]); }
+      if(cons_fr2[ik]==cons_fr1[il]){ cpl -= constraint_inv_mass(cons_fr2[ik]); }
+      if(cons_fr2[ik]==cons_fr2[il]){ cpl += constraint_inv_mass(cons_fr2[ik]); }
+      A[k*n+l] = -S[k]*S[l]*cpl*(B[k]*B[l]);
+    }
+  }
+
+  for(pass=0;pass<2;pass++){
+
+    for(k=0;k<n;k++){
+      int ik = cl[k];
+      VECTOR r = Fragments[cons_fr1[ik]].Group_RB.rb_cm - Fragments[cons_fr2[ik]].Group_RB.rb_cm;
+      if(pass==0){  rhs[k] = S[k]*(B[k]*r - cons_d[ik]);  }
+      else{
+        // Correction for the rotational lengthening
+        double p2 = 2.0*cons_d[ik]*cons_d[ik] - r.length2();
+        double p = (p2>0.0) ? sqrt(p2) : 0.0;
+        rhs[k] = S[k]*(cons_d[ik] - p);
+      }
+      sol[k] = rhs[k];
+    }
+
+    // sol = (I + A + A^2 + ... + A^lincs_order) * rhs
+    for(rec=0;rec<lincs_order;rec++){
+      for(k=0;k<n;k++){
+        tmp[k] = 0.0;
+        for(l=0;l<n;l++){  tmp[k] += A[k*n+l]*rhs[l];  }
+      }
+      for(k=0;k<n;k++){  rhs[k] = tmp[k];  sol[k] += tmp[k];  }
+    }
+
+    for(k=0;k<n;k++){
+      double s = S[k]*sol[k];
+      constraint_pair_shift(cl[k], (-s)*B[k], dt);
+    }
+  }// for pass
+
+  return 2;
+}
+
+
+void System::settle_cluster(int c, double dt){
+/**
+  \param[in] c The index of the cluster
+  \param[in] dt The time step of the drift
+
+  Analytic SETTLE for one rigid water molecule (the fragments of the cluster are ordered as O, H1, H2).
+  The method assumes the two H atoms have equal masses and the two O-H distances are equal - this is checked
+  in init_constraints(), the clusters which are not such are solved by the general methods. The molecule
+  can not be settled if it is distorted too much in one step - then the step is too large, the program stops
+
+  Miyamoto, S.; Kollman, P. A. J. Comput. Chem. 1992, 13, 952-962
+*/
+
+  vector<int>& cl = cons_clusters[c];
+  vector<int>& frs = cons_cluster_frags[c];
+  int o = frs[0], h1 = frs[1], h2 = frs[2];
+
+  double mO = Fragments[o].Group_RB.rb_mass;
+  double mH = Fragments[h1].Group_RB.rb_mass;
+  double dOH = cons_d[cl[0]];
+  double dHH = cons_d[cl[2]];
+
+  double wohh = mO + 2.0*mH;
+  double rc = 0.5*dHH;
+  double h = sqrt(dOH*dOH - rc*rc);
+  double ra = 2.0*mH*h/wohh;
+  double rb = h - ra;
+
+  // Reference (constrained) geometry and the unconstrained positions
+  VECTOR b0 = cons_ref[h1] - cons_ref[o];
+  VECTOR c0 = cons_ref[h2] - cons_ref[o];
+
+  VECTOR a1 = Fragments[o].Group_RB.rb_cm;
+  VECTOR b1 = Fragments[h1].Group_RB.rb_cm;
+  VECTOR c1 = Fragments[h2].Group_RB.rb_cm;
+  VECTOR com = (mO*a1 + mH*b1 + mH*c1)/wohh;
+  a1 -= com;  b1 -= com;  c1 -= com;
+
+  // The local frame: z is normal to the reference plane, x is orthogonal to z and the O position
+  VECTOR ez, ex, ey;
+  ez.cross(b0, c0);
+  ex.cross(a1, ez);
+  ey.cross(ez, ex);
+  ex = ex/ex.length();  ey = ey/ey.length();  ez = ez/ez.length();
+
+  double xb0d = ex*b0, yb0d = ey*b0;
+  double xc0d = ex*c0, yc0d = ey*c0;
+  double za1d = ez*a1;
+  double xb1d = ex*b1, yb1d = ey*b1, zb1d = ez*b1;
+  double xc1d = ex*c1, yc1d = ey*c1, zc1d = ez*c1;
+
+  double sinphi = za1d/ra;
+  double tmp = 1.0 - sinphi*sinphi;
+  if(tmp<=0.0){
+    cout<<"Error in SETTLE: the water molecule (O atom "<<Fragments[o].globAtom_Index[0]<<") can not be settled. Reduce the time step\nExiting...\n";
+    exit(0);
+  }
+  double cosphi = sqrt(tmp);
+  double sinpsi = (zb1d - zc1d)/(2.0*rc*cosphi);
+  tmp = 1.0 - sinpsi*sinpsi;
+  if(tmp<=0.0){
+    cout<<"Error in SETTLE: the water molecule (O atom "<<Fragments[o].globAtom_Index[0]<<") can not be settled. Reduce the time step\nExiting...\n";
+    exit(0);
+  }
+  double cospsi = sqrt(tmp);
+
+  double ya2d = ra*cosphi;
+  double xb2d = -rc*cospsi;
+  double t1 = -rb*cosphi;
+  double t2 = rc*sinpsi*sinphi;
+  double yb2d = t1 - t2;
+  double yc2d = t1 + t2;
+
+  double alpha = xb2d*(xb0d - xc0d) + yb0d*yb2d + yc0d*yc2d;
+  double beta  = xb2d*(yc0d - yb0d) + xb0d*yb2d + xc0d*yc2d;
+  double gamma = xb0d*yb1d - xb1d*yb0d + xc0d*yc1d - xc1d*yc0d;
+  double al2be2 = alpha*alpha + beta*beta;
+  tmp = al2be2 - gamma*gamma;
+  if(al2be2<=0.0 || tmp<0.0){
+    cout<<"Error in SETTLE: the water molecule (O atom "<<Fragments[o].globAtom_Index[0]<<") can not be settled. Reduce the time step\nExiting...\n";
+    exit(0);
+  }
+  double sinthe = (alpha*gamma - beta*sqrt(tmp))/al2be2;
+  tmp = 1.0 - sinthe*sinthe;
+  double costhe = (tmp>0.0) ? sqrt(tmp) : 0.0;   // |sinthe| <= 1 up to the round-off
+
+  VECTOR a3 = (-ya2d*sinthe)*ex + (ya2d*costhe)*ey + za1d*ez;
+  VECTOR b3 = (xb2d*costhe - yb2d*sinthe)*ex + (xb2d*sinthe + yb2d*costhe)*ey + zb1d*ez;
+  VECTOR c3 = (-xb2d*costhe - yc2d*sinthe)*ex + (-xb2d*sinthe + yc2d*costhe)*ey + zc1d*ez;
+
+  constraint_shift(o,  a3 - a1, dt);
+  constraint_shift(h1, b3 - b1, dt);
+  constraint_shift(h2, c3 - c1, dt);
+
+  // The virial: the impulses sum to zero (the center of mass is kept), so it only depends on the O-H vectors
+  VECTOR dp1 = (mH/dt)*(b3 - b1);
+  VECTOR dp2 = (mH/dt)*(c3 - c1);
+  MATRIX3x3 vir, tmp2;
+  vir.tensor_product(b0, dp1);
+  tmp2.tensor_product(c0, dp2);
+  vir += tmp2;
+  stress_cons += vir/dt;
+}
+
+
+int System::apply_position_constraints(double dt){
+/**
+  \param[in] dt The time step of the drift (the one used to update the positions from the momenta)
+
+  Correct the positions (and consistently the momenta) of the constrained fragments after the drift,
+  so that all the constraints are satisfied. The reference positions must be stored by save_constraint_reference()
+  before the drift. The constraint impulses are accumulated in the constraint virial.
+  Returns the largest number of iterations used for a cluster
+*/
+
+  if(Number_of_constraints==0){ return 0; }
+  if(!is_cons_init){ init_constraints(); }
+
+  int c, n_iter, max_iter = 0;
+
+  for(c=0;c<(int)cons_clusters.size();c++){
+    if(cons_cluster_type[c]==2){  settle_cluster(c, dt); n_iter = 1; }
+    else if(cons_cluster_type[c]==0 || constraint_method=="SHAKE"){  n_iter = shake_cluster(c, dt);  }
+    else if(constraint_method=="M-SHAKE"){  n_iter = mshake_cluster(c, dt);  }
+    else if(constraint_method=="LINCS"){  n_iter = lincs_cluster(c, dt);  }
+    else{
+      cout<<"Error in apply_position_constraints: unknown constraint_method "<<constraint_method
+          <<". Allowed: SHAKE, M-SHAKE, LINCS\nExiting...\n";
+      exit(0);
+    }
+    if(n_iter>max_iter){ max_iter = n_iter; }
+  }
+
+  return max_iter;
+}
+
+
+void System::apply_velocity_constraints(double dt, int is_virial){
+/**
+  \param[in] dt The MD time step (used only to convert the constraint impulses into the virial)
+  \param[in] is_virial 1 - add the constraint impulses to the constraint virial, 0 - do not (e.g. when
+  the momenta are only projected back onto the constraint manifold after a thermostat resampling)
+
+  Remove the components of the momenta which violate the time derivatives of the constraints (RATTLE).
+  The velocity constraints are linear, so they are solved exactly: analytically for the single constraints,
+  and by the direct solution of the linear system for the coupled clusters (including the rigid waters)
+
+  Andersen, H. C. J. Comput. Phys. 1983, 52, 24-34
+*/
+
+  if(Number_of_constraints==0){ return; }
+  if(!is_cons_init){ init_constraints(); }
+
+  int c, k, l, n;
+  MATRIX3x3 tmp;
+
+  for(c=0;c<(int)cons_clusters.size();c++){
+    vector<int>& cl = cons_clusters[c];
+    n = cl.size();
+
+    vector<VECTOR> r(n);
+    vector<double> A(n*n), b(n), lambda(n);
+
+    for(k=0;k<n;k++){
+      int ik = cl[k];
+      RigidBody& t1 = Fragments[cons_fr1[ik]].Group_RB;
+      RigidBody& t2 = Fragments[cons_fr2[ik]].Group_RB;
+      r[k] = t1.rb_cm - t2.rb_cm;
+      VECTOR v = constraint_inv_mass(cons_fr1[ik])*t1.rb_p - constraint_inv_mass(cons_fr2[ik])*t2.rb_p;
+      b[k] = -(r[k]*v);
+    }
+
+    for(k=0;k<n;k++){
+      int ik = cl[k];
+      for(l=0;l<n;l++){
+        int il = cl[l];
+        double cpl = 0.0;
+        if(cons_fr1[ik]==cons_fr1[il]){ cpl += constraint_inv_mass(cons_fr1[ik]); }
+        if(cons_fr1[ik]==cons_fr2[il]){ cpl -= constraint_inv_mass(cons_fr1[ik]); }
+        if(cons_fr2[ik]==cons_fr1[il]){ cpl -= constraint_inv_mass(cons_fr2[ik]); }
+        if(cons_fr2[ik]==cons_fr2[il]){ cpl += constraint_inv_mass(cons_fr2[ik]); }
+        A[k*n+l] = cpl*(r[k]*r[l]);
+      }
+    }
+
+    if(n==1){
+      if(A[0]<=0.0){ continue; }
+      lambda[0] = b[0]/A[0];
+    }
+    else if(solve_dense(n, A, b, lambda)){
+      cout<<"Error in apply_velocity_constraints: singular constraint matrix for the cluster "<<c<<"\nExiting...\n";
+      exit(0);
+    }
+
+    for(k=0;k<n;k++){
+      int ik = cl[k];
+      VECTOR dp = lambda[k]*r[k];
+      RigidBody& t1 = Fragments[cons_fr1[ik]].Group_RB;
+      RigidBody& t2 = Fragments[cons_fr2[ik]].Group_RB;
+
+      if(constraint_inv_mass(cons_fr1[ik])>0.0){ t1.set_momentum(t1.rb_p + dp); }
+      if(constraint_inv_mass(cons_fr2[ik])>0.0){ t2.set_momentum(t2.rb_p - dp); }
+
+      if(is_virial){
+        tmp.tensor_product(r[k], dp);
+        stress_cons += tmp/dt;
+      }
+    }
+  }// for c
+
+}
+
+void System::apply_velocity_constraints(double dt){
+/**
+  \param[in] dt The MD time step
+
+  Same as above, with the constraint impulses added to the virial
+*/
+  apply_velocity_constraints(dt, 1);
+}
+
+
+double System::max_constraint_deviation(){
+/**
+  Returns the largest relative deviation |r - d|/d over all the constraints
+*/
+
+  double res = 0.0;
+  for(int k=0;k<Number_of_constraints;k++){
+    VECTOR r = Fragments[cons_fr1[k]].Group_RB.rb_cm - Fragments[cons_fr2[k]].Group_RB.rb_cm;
+    double dev = fabs(r.length() - cons_d[k])/cons_d[k];
+    if(dev>res){ res = dev; }
+  }
+  return res;
+}
+
+
+MATRIX3x3 System::constraint_virial(){
+/**
+  Returns the constraint contribution to the virial accumulated since the last call of save_constraint_reference()
+*/
+  return stress_cons;
+}
+
+
+
+}// namespace libchemsys
+}// namespace libchemobjects
+}// liblibra
+
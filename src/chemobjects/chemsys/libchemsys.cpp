@@ -62,6 +62,14 @@ std::string (System::*expt_get_xyz_v1)(int fold,std::string pbc_type,int frame)
 
 int (System::*expt_Find_Angle_v1)(int,int) = &System::Find_Angle;
 int (System::*expt_Find_Angle_v2)(int,int,int) = &System::Find_Angle;
+void (System::*expt_CREATE_BONDS_v1)(boost::python::list,boost::python::dict) = &System::CREATE_BONDS;
+void (System::*expt_CREATE_BONDS_v2)(boost::python::list,boost::python::dict,double,int) = &System::CREATE_BONDS;
+void (System::*expt_Assign_Rings_v1)() = &System::Assign_Rings;
+void (System::*expt_Assign_Rings_v2)(int) = &System::Assign_Rings;
+void (System::*expt_add_constraint_v1)(int,int,double) = &System::add_constraint;
+void (System::*expt_add_constraint_v2)(int,int) = &System::add_constraint;
+void (System::*expt_apply_velocity_constraints_v1)(double) = &System::apply_velocity_constraints;
+void (System::*expt_apply_velocity_constraints_v2)(double,int) = &System::apply_velocity_constraints;
 
 
 void (System::*expt_init_fragment_velocities_v1)(double Temp, Random& rnd) = &System::init_fragment_velocities;
@@ -88,6 +96,11 @@ void (System::*expt_ROTATE_FRAGMENT_v6)(const MATRIX3x3& rot, int fr_id) = &Syst
       .def_readwrite("mass",&System::mass)
       .def_readwrite("Nf_t",&System::Nf_t)
       .def_readwrite("Nf_r",&System::Nf_r)
+      .def_readwrite("Number_of_constraints",&System::Number_of_constraints)
+      .def_readwrite("constraint_method",&System::constraint_method)
+      .def_readwrite("constraint_tol",&System::constraint_tol)
+      .def_readwrite("constraint_max_iter",&System::constraint_max_iter)
+      .def_readwrite("lincs_order",&System::lincs_order)
 
 //      .def("set",&System::set)
       .def("show_info",&System::show_info)
@@ -162,13 +175,15 @@ void (System::*expt_ROTATE_FRAGMENT_v6)(const MATRIX3x3& rot, int fr_id) = &Syst
       .def("is_13pair", &System::is_13pair)
       .def("is_14pair", &System::is_14pair)
       .def("is_group_pair", &System::is_group_pair)
+      .def("update_topology_index", &System::update_topology_index)
 
       
 
   //----------- Defined in System_methods1.cpp -----------
 
       .def("Generate_Connectivity_Matrix", &System::Generate_Connectivity_Matrix)
-      .def("Assign_Rings", &System::Assign_Rings)
+      .def("Assign_Rings", expt_Assign_Rings_v1)
+      .def("Assign_Rings", expt_Assign_Rings_v2)
       .def("DIVIDE_GRAPH", &System::DIVIDE_GRAPH)
 
 
@@ -180,7 +195,9 @@ void (System::*expt_ROTATE_FRAGMENT_v6)(const MATRIX3x3& rot, int fr_id) = &Syst
       .def("GROUP_ATOMS",&System::GROUP_ATOMS)
       .def("UPDATE_FRAG_TOPOLOGY", &System::UPDATE_FRAG_TOPOLOGY)
       .def("ADD_ATOM_TO_FRAGMENT", &System::ADD_ATOM_TO_FRAGMENT)
-      .def("CREATE_BONDS", &System::CREATE_BONDS)
+      .def("CREATE_BONDS", expt_CREATE_BONDS_v1)
+      .def("CREATE_BONDS", expt_CREATE_BONDS_v2)
+      .def("UPDATE_BONDS", &System::UPDATE_BONDS)
       .def("CLONE_MOLECULE", &System::CLONE_MOLECULE)
 
 
@@ -192,6 +209,7 @@ void (System::*expt_ROTATE_FRAGMENT_v6)(const MATRIX3x3& rot, int fr_id) = &Syst
       .def("move_molecule_by_index",&System::move_molecule_by_index)
 
       .def("update_atoms_for_fragment", &System::update_atoms_for_fragment)
+      .def("update_atoms_for_fragments", &System::update_atoms_for_fragments)
       .def("update_fragments_for_molecule", &System::update_fragments_for_molecule)
       .def("update_atoms_for_molecule", &System::update_atoms_for_molecule)
 
@@ -312,7 +330,21 @@ void (System::*expt_ROTATE_FRAGMENT_v6)(const MATRIX3x3& rot, int fr_id) = &Syst
       .def("print_xyz",print_xyz1)
       .def("print_xyz",print_xyz2)
 
-      .def("get_xyz", expt_get_xyz_v1);
+      .def("get_xyz", expt_get_xyz_v1)
+      .def("get_traj_frame", &System::get_traj_frame)
+
+
+  //---------------- Defined in System_methods8.cpp -----------------
+      .def("add_constraint", expt_add_constraint_v1)
+      .def("add_constraint", expt_add_constraint_v2)
+      .def("CONSTRAIN_BONDS", &System::CONSTRAIN_BONDS)
+      .def("clear_constraints", &System::clear_constraints)
+      .def("save_constraint_reference", &System::save_constraint_reference)
+      .def("apply_position_constraints", &System::apply_position_constraints)
+      .def("apply_velocity_constraints", expt_apply_velocity_constraints_v1)
+      .def("apply_velocity_constraints", expt_apply_velocity_constraints_v2)
+      .def("max_constraint_deviation", &System::max_constraint_deviation)
+      .def("constraint_virial", &System::constraint_virial)
 
   ;
 
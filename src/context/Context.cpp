@@ -21,10 +21,93 @@ namespace libcontext{
 
 //-------------- Class methods implementation ------------------------
 
+void Context::detach(){
+/**
+  Makes the data of this object its own, before it is modified (copy-on-write):
+  a view gets its own tree with the content of the shared node, the shared tree is copied.
+  The cached values are dropped.
+*/
+
+  if(node!=NULL){
+    std::shared_ptr<boost::property_tree::ptree> pt = std::make_shared<boost::property_tree::ptree>();
+    pt->add_child(boost::property_tree::ptree::path_type(path, path_separator), *node);
+    ctx_pt = pt;
+    node = NULL;
+  }
+  else if(ctx_pt.use_count()>1){
+    ctx_pt = std::make_shared<boost::property_tree::ptree>(*ctx_pt);
+  }
+
+  if(cache.use_count()>1){  cache = std::make_shared<ctx_cache>();  }
+  else{  cache->values.clear();  }
+
+}
+
+
+boost::property_tree::ptree* Context::vars_node(){
+/**
+  The node that holds the variables of this context, or NULL if there is no such node
+*/
+
+  if(node!=NULL){ return node; }
+
+  boost::optional<boost::property_tree::ptree&> x = 
+  ctx_pt->get_child_optional(boost::property_tree::ptree::path_type(path, path_separator));
+
+  if(x){ return &(*x); }
+  return NULL;
+}
+
+
+boost::property_tree::ptree* Context::first_node(){
+/**
+  The first child of the top level of the tree 
+*/
+
+  if(node!=NULL){ return node; }
+
+  BOOST_FOREACH(ptree::value_type &v, *ctx_pt){  return &v.second;  }
+  return NULL;
+}
+
+
+boost::property_tree::ptree& Context::resolve(std::string _path){
+/**
+  The node of the tree given by the full path (which starts with the name of this context)
+*/
+
+  if(node==NULL){  return ctx_pt->get_child(boost::property_tree::ptree::path_type(_path, path_separator));  }
+
+  if(_path==path){ return *node; }
+
+  std::string prefix = path + path_separator;
+  if(_path.compare(0, prefix.size(), prefix)==0){
+    return node->get_child(boost::property_tree::ptree::path_type(_path.substr(prefix.size()), path_separator));
+  }
+
+  throw boost::property_tree::ptree_bad_path("No such node", boost::property_tree::ptree::path_type(_path, path_separator));
+}
+
+
+Context Context::make_view(const std::string& name, boost::property_tree::ptree& subtree){
+/**
+  The context which refers to the subtree of the data of this context, without copying it
+*/
+
+  Context res(*this);
+  res.path = name;
+  res.node = &subtree;
+  res.cache = std::make_shared<ctx_cache>();
+
+  return res;
+}
+
+
 void Context::set_path(std::string new_path){
+  detach();
   path = new_path;
   int i= 0;
-  BOOST_FOREACH(ptree::value_type& v, ctx_pt){ 
+  BOOST_FOREACH(ptree::value_type& v, *ctx_pt){ 
   //BOOST_FOREACH(auto& v, ctx_pt){ 
   //for (auto& v : ctx_pt){  // C++11
    // if(i==0){ v.first = std::move(new_path); } i++;    AVA: Temporary comment it to be able to compile with C++11
@@ -40,7 +123,41 @@ int Context::size(){
   The number of direct children on this node
 */
 
-  return ctx_pt.size();
+  if(node!=NULL){ return 1; }
+  return ctx_pt->size();
+}
+
+
+boost::property_tree::ptree Context::get_ptree(){
+/**
+  The property tree with all the data of this context
+*/
+
+  if(node!=NULL){
+    boost::property_tree::ptree pt;
+    pt.add_child(boost::property_tree::ptree::path_type(path, path_separator), *node);
+    return pt;
+  }
+  return *ctx_pt;
+}
+
+
+void Context::save_xml(std::string filename){ 
+
+  if(node!=NULL){
+    boost::property_tree::ptree pt = get_ptree();
+    libio::save_xml(filename, pt); 
+  }
+  else{  libio::save_xml(filename, *ctx_pt);  }
+}
+
+void Context::load_xml(std::string filename){ 
+
+  ctx_pt = std::make_shared<boost::property_tree::ptree>();
+  node = NULL;
+  cache = std::make_shared<ctx_cache>();
+
+  libio::load_xml(filename, *ctx_pt); 
 }
 
 
@@ -53,15 +170,14 @@ void Context::add_context(Context ctxt){
   Copies one context object into another
 */
 
-  int i= 0;
-  BOOST_FOREACH(ptree::value_type &v, ctx_pt){ 
-    if(i==0){ 
-      int j = 0;
-      BOOST_FOREACH(ptree::value_type &v1, ctxt.ctx_pt){
-        if(j==0){ v.second.put_child(boost::property_tree::ptree::path_type(ctxt.path, ctxt.path_separator), v1.second); } j++;
-      }
-    } i++;  
-  } // foreach
+  detach();
+
+  boost::property_tree::ptree* x = first_node();
+  boost::property_tree::ptree* y = ctxt.first_node();
+
+  if(x!=NULL && y!=NULL){ 
+    x->put_child(boost::property_tree::ptree::path_type(ctxt.path, ctxt.path_separator), *y); 
+  }
 }// add
 
 
@@ -81,7 +197,7 @@ void Context::show_children(std::string _path){
   int j = 0;
   cout<<"current path = "<<path<<endl;
 
-  BOOST_FOREACH(ptree::value_type &v1, ctx_pt.get_child(boost::property_tree::ptree::path_type(_path, path_separator))){
+  BOOST_FOREACH(ptree::value_type &v1, resolve(_path)){
     cout<<"key = "<<v1.first<<endl; //
   }
 
@@ -107,20 +223,15 @@ void Context::show_children(){
 
 
 Context Context::get_child(std::string _path, std::string varname, Context default_val){ 
+/**
+  The child named "varname" in the path given by "_path". The child shares the data 
+  with this object (no copies are made)
+*/
 
-
-  boost::property_tree::ptree x;
-
-  x = ctx_pt.get_child(boost::property_tree::ptree::path_type(_path, path_separator));
-
-  BOOST_FOREACH(ptree::value_type &v, x){ 
+  BOOST_FOREACH(ptree::value_type &v, resolve(_path)){ 
 
     if(v.first == varname){
-      Context res;
-      res.path_separator = path_separator;
-      res.path = v.first;
-      res.ctx_pt.add_child(boost::property_tree::ptree::path_type(v.first, path_separator), v.second);  
-      return res;
+      return make_view(v.first, v.second);
     }
   } 
 
@@ -142,19 +253,10 @@ vector<Context> Context::get_children(std::string _path, std::string varname){
 
   vector<Context> res;
 
-  boost::property_tree::ptree x;
-
-  x = ctx_pt.get_child(boost::property_tree::ptree::path_type(_path, path_separator));
-
-  BOOST_FOREACH(ptree::value_type &v1, x){
+  BOOST_FOREACH(ptree::value_type &v1, resolve(_path)){
 
     if(v1.first==varname){
-
-      Context y; 
-      y.path_separator = path_separator;
-      y.path = v1.first;
-      y.ctx_pt.add_child(boost::property_tree::ptree::path_type(v1.first, path_separator), v1.second);  
-      res.push_back( y );
+      res.push_back( make_view(v1.first, v1.second) );
     }
   }
 
@@ -181,17 +283,9 @@ vector<Context> Context::get_children_all(std::string _path){
 
   vector<Context> res;
 
-  boost::property_tree::ptree x;
-
-  x = ctx_pt.get_child(boost::property_tree::ptree::path_type(_path, path_separator));
-
-  BOOST_FOREACH(ptree::value_type &v1, x){
+  BOOST_FOREACH(ptree::value_type &v1, resolve(_path)){
 
-    Context y; 
-    y.path_separator = path_separator;
-    y.path = v1.first; 
-    y.ctx_pt.add_child(boost::property_tree::ptree::path_type(v1.first, path_separator), v1.second);  
-    res.push_back( y );
+    res.push_back( make_view(v1.first, v1.second) );
 
   }
 
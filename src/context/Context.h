@@ -12,6 +12,12 @@
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <typeindex>
+#include <boost/any.hpp>
+
 #include "../io/libio.h"
 #include "../math_linalg/liblinalg.h"
 
@@ -26,37 +32,98 @@ namespace libcontext{
 
 //class Context;
 
+
+class ctx_cache{
+/**
+  The values already parsed from the property tree, for every type and variable name.
+  The empty entries mark the variables which are not present in the tree.
+*/
+public:
+  std::mutex mtx;
+  std::unordered_map<std::type_index, std::unordered_map<std::string, boost::any> > values;
+};
+
+
 class Context{
+/**
+  The data are kept in the property tree, which is shared by the copies of the Context object and 
+  by the children returned by get_child/get_children (views) - nothing is copied until one of them 
+  is modified (copy-on-write). The values returned by get are parsed from the tree only once and are 
+  cached in a hash table, so the repeated queries (e.g. in the loops) do not walk and re-parse the tree.
+*/
 
   std::string path;  // the top-most level of the property tree = the name of the variable of the "context" type
   char path_separator; //
-  boost::property_tree::ptree ctx_pt; // This is the internal representation of the data
+  std::shared_ptr<boost::property_tree::ptree> ctx_pt; // This is the internal representation of the data
+  boost::property_tree::ptree* node;  // for views: the node of the shared tree that holds the variables, otherwise NULL
+  std::shared_ptr<ctx_cache> cache;   // the parsed values 
+
+  void detach();
+  boost::property_tree::ptree* vars_node();
+  boost::property_tree::ptree* first_node();
+  boost::property_tree::ptree& resolve(std::string _path);
+  Context make_view(const std::string& name, boost::property_tree::ptree& subtree);
+
+
+  template <typename X, typename Loader>
+  int cached_load(const std::string& varname, X& varval, Loader load_fn){
+  /**
+    Looks for the value in the cache first, and parses the tree only if it is not there
+  */
+    std::type_index tp(typeid(X));
+    {
+      std::lock_guard<std::mutex> lock(cache->mtx);
+      std::unordered_map<std::string, boost::any>& tab = cache->values[tp];
+      std::unordered_map<std::string, boost::any>::iterator it = tab.find(varname);
+      if(it!=tab.end()){
+        if(it->second.empty()){ return 0; }
+        varval = boost::any_cast<const X&>(it->second);
+        return 1;
+      }
+    }
+
+    int st = 0;
+    boost::property_tree::ptree* nd = vars_node();
+    if(nd!=NULL){ load_fn(*nd, varname, path_separator, varval, st); }
+
+    std::lock_guard<std::mutex> lock(cache->mtx);
+    if(st){ cache->values[tp][varname] = boost::any(varval); }
+    else{   cache->values[tp][varname] = boost::any(); }
+    return st;
+  }
+
 
   public:
 
  
   //------------------------------------------------
-  Context() { path = "glob_context"; path_separator = '.'; } 
+  Context() { 
+    path = "glob_context"; path_separator = '.'; 
+    ctx_pt = std::make_shared<boost::property_tree::ptree>(); node = NULL; cache = std::make_shared<ctx_cache>();
+  } 
   Context(std::string filename){ 
     path_separator = '.';
-    libio::load_xml(filename, ctx_pt);
-    int i= 0; BOOST_FOREACH(ptree::value_type &v, ctx_pt){ if(i==0){ path = v.first; } i++;  }
+    ctx_pt = std::make_shared<boost::property_tree::ptree>(); node = NULL; cache = std::make_shared<ctx_cache>();
+    libio::load_xml(filename, *ctx_pt);
+    int i= 0; BOOST_FOREACH(ptree::value_type &v, *ctx_pt){ if(i==0){ path = v.first; } i++;  }
   }
-  Context(const Context& c){  ctx_pt = c.ctx_pt; path = c.path; path_separator = c.path_separator; } 
-  Context(const boost::property_tree::ptree& pt, std::string _path, char _path_separator)
-  { ctx_pt = pt; path = _path; path_separator = _path_separator; } 
+  Context(const Context& c){  ctx_pt = c.ctx_pt; node = c.node; cache = c.cache; path = c.path; path_separator = c.path_separator; } 
+  Context(const boost::property_tree::ptree& pt, std::string _path, char _path_separator){ 
+    ctx_pt = std::make_shared<boost::property_tree::ptree>(pt); node = NULL; cache = std::make_shared<ctx_cache>();
+    path = _path; path_separator = _path_separator; 
+  } 
 
   virtual ~Context(){}
 
   // Manupulation of the "path": These functions are essentially for getting and setting the name of the context variable (path)
   void set_path(std::string new_path);
-  void set_path_separator(char _path_separator){ path_separator = _path_separator; }
+  void set_path_separator(char _path_separator){ detach(); path_separator = _path_separator; }
   std::string get_path();
 
 
   // Add new variables to data-structure
   template <typename X>
-  void add(std::string varname, X varval){   libio::save(ctx_pt, path+path_separator+varname, path_separator, varval);  }
+  void add(std::string varname, X varval){   detach(); libio::save(*ctx_pt, path+path_separator+varname, path_separator, varval);  }
 
   void add_context(Context ctxt);
 
@@ -79,22 +146,20 @@ class Context{
   // Get value for given variable name, if exist in datastructure. Or return default value
   template <typename X>
   X get1(std::string varname, X default_val){   
-    int st;
     X varval; 
 
-    libio::load(ctx_pt, path+path_separator+varname, path_separator, varval, st); 
-//    libio::load(ctx_pt, varname, path_separator, varval, st); 
+    int st = cached_load(varname, varval, 
+             [](boost::property_tree::ptree& pt, const std::string& p, char sep, X& v, int& s){ libio::load(pt, p, sep, v, s); });
     if(st){ return varval; }else{ return default_val; }
 
   }
 
   template <typename X>
   X get2(std::string varname, X& default_val){   
-    int st;
     X varval; 
 
-    liblinalg::load(ctx_pt, path+path_separator+varname, path_separator, varval, st); 
-//    liblinalg::load(ctx_pt, varname, path_separator, varval, st); 
+    int st = cached_load(varname, varval, 
+             [](boost::property_tree::ptree& pt, const std::string& p, char sep, X& v, int& s){ liblinalg::load(pt, p, sep, v, s); });
     if(st){ return varval; }else{ return default_val; }
 
   }
@@ -107,12 +172,15 @@ class Context{
     \param[in] pt Is the property tree from which we want to extract the value
   */
 
-    try{  return ctx_pt.get_value<X>();    }
+    try{  
+      if(node!=NULL){ return boost::property_tree::ptree().get_value<X>(); }
+      return ctx_pt->get_value<X>();    
+    }
     catch(std::exception& e){ cout<<"Error in get_value()!\n"; }
   }
 
 
-
+  boost::property_tree::ptree get_ptree();
 
 
 /*
@@ -151,8 +219,8 @@ class Context{
 
 
  
-  void save_xml(std::string filename){ libio::save_xml(filename, ctx_pt); }
-  void load_xml(std::string filename){ libio::load_xml(filename, ctx_pt); }
+  void save_xml(std::string filename);
+  void load_xml(std::string filename);
 
 
 };
@@ -31,6 +31,7 @@
 #include "dyn_variables.h"
 #include "dyn_ham.h"
 #include "../calculators/NPI.h"
+#include "../timer/Profiler.h"
 
 
 /// liblibra namespace
@@ -413,11 +414,20 @@ void SSY_correction(CMATRIX& Ham, dyn_variables& dyn_var, nHamiltonian& ham, int
 
 
 void propagate_electronic(dyn_variables& dyn_var, nHamiltonian& ham, nHamiltonian& ham_prev, dyn_control_params& prms){
+  ScopedTimer _prof("propagate_electronic");
 
   propagate_electronic(dyn_var, &ham, &ham_prev, prms);
 
 }
 
+void propagate_electronic(dyn_variables& dyn_var, nHamiltonian& ham, nHamiltonian& ham_prev, dyn_control_params& prms,
+                          const vector<int>& num_el, int isubstep){
+  ScopedTimer _prof("propagate_electronic");
+
+  propagate_electronic(dyn_var, &ham, &ham_prev, prms, num_el, isubstep);
+
+}
+
 void apply_thermal_correction(dyn_variables& dyn_var, nHamiltonian& ham, nHamiltonian& ham_old, 
                               vector<int> old_states, dyn_control_params& prms, Random& rnd){
 /**
@@ -551,6 +561,7 @@ void update_wp_width(dyn_variables& dyn_var, dyn_control_params& prms){
     double elapsed_time, s2;
     
     elapsed_time = prms.dt*dyn_var.timestep;
+    if(prms.adaptive_dt==1){ elapsed_time = dyn_var.elapsed_time; }
 
     for(int itraj=0; itraj<ntraj; itraj++){
       for(int idof=0; idof<ndof; idof++){
@@ -563,6 +574,7 @@ void update_wp_width(dyn_variables& dyn_var, dyn_control_params& prms){
     double elapsed_time, s2;
 
     elapsed_time = prms.dt*dyn_var.timestep;
+    if(prms.adaptive_dt==1){ elapsed_time = dyn_var.elapsed_time; }
     
     for(int itraj=0; itraj<ntraj; itraj++){
       for(int idof=0; idof<ndof; idof++){
@@ -645,11 +657,26 @@ int need_active_states_diff_rep(dyn_control_params& prms){
 }
 
 void propagate_electronic(dyn_variables& dyn_var, nHamiltonian* Ham, nHamiltonian* Ham_prev, dyn_control_params& prms){
+/**
+  One electronic substep, dt / num_electronic_substeps, of all trajectories
+*/
+
+  vector<int> num_el(dyn_var.ntraj, prms.num_electronic_substeps);
+
+  propagate_electronic(dyn_var, Ham, Ham_prev, prms, num_el, 0);
+
+}
+
+void propagate_electronic(dyn_variables& dyn_var, nHamiltonian* Ham, nHamiltonian* Ham_prev, dyn_control_params& prms,
+                          const vector<int>& num_el, int isubstep){
+/**
+  The substep isubstep of each trajectory: the trajectory itraj makes num_el[itraj] substeps of
+  the length dt / num_el[itraj], so it is skipped if isubstep >= num_el[itraj]
+*/
 
   int itraj, i, j;
 
-  int num_el = prms.num_electronic_substeps;
-  double dt = prms.dt / num_el;
+  double dt = prms.dt;
   int rep = prms.rep_tdse;
   int method = prms.electronic_integrator;
   int is_ssy = prms.do_ssy;
@@ -680,6 +707,9 @@ void propagate_electronic(dyn_variables& dyn_var, nHamiltonian* Ham, nHamiltonia
   ///======================== Now do the integration of the TD-SE ===================
   for(itraj=0; itraj<ntraj; itraj++){
 
+    if(isubstep >= num_el[itraj]){ continue; }
+    dt = prms.dt / num_el[itraj];
+
     C = Coeff.col(itraj);
 
     int traj1 = itraj;  if(method >=100 && method <200){ traj1 = 0; }
@@ -1147,6 +1177,7 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
   Return: propagates C, q, p and updates state variables
 
 */
+  ScopedTimer _prof("compute_dynamics");
 
 //  cout<<"In compute_dynamics\n";
   //======== General variables =======================
@@ -1156,6 +1187,14 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
   dyn_control_params prms;
   prms.set_parameters(dyn_params);
 
+  // Adaptive nuclear step: the "dt" parameter is only the initial step, the current one is kept in dyn_var
+  if(prms.adaptive_dt==1){
+    if(prms.adaptive_dt_min<=0.0){ prms.adaptive_dt_min = prms.dt/16.0; }
+    if(prms.adaptive_dt_max<=0.0){ prms.adaptive_dt_max = 4.0*prms.dt; }
+    if(dyn_var.dt_adapt<=0.0){ dyn_var.dt_adapt = prms.dt; }
+    prms.dt = dyn_var.dt_adapt;
+  }
+
   int num_el = prms.num_electronic_substeps;
   double dt_el = prms.dt / num_el;
 
@@ -1207,6 +1246,19 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
   }
 
 
+  // The total energies and the forces at t, for the step size control
+  vector<double> Etot0, dE(ntraj, 0.0), dF(ntraj, 0.0);
+  MATRIX f0(ndof, ntraj);
+  int is_event = 0;
+
+  if(prms.adaptive_dt==1){
+    Etot0 = potential_energies(prms, dyn_var, ham);
+    Ekin = dyn_var.compute_kinetic_energies();
+    for(traj=0; traj<ntraj; traj++){ Etot0[traj] += Ekin[traj]; }
+    f0 = *dyn_var.f;
+  }
+
+
   //***************************** Coherent dynamics *******************************
   //============== Nuclear propagation ===================
   // NVT dynamics
@@ -1217,6 +1269,13 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
         dyn_var.p->scale(dof, traj, therm[traj].vel_scale(0.5*prms.dt));
       }// traj
     }// idof 
+
+    // CSVR and Andersen thermostats - symmetric half-step operators, similar to the Nose-Hoover scaling
+    for(traj=0; traj<ntraj; traj++){
+      if(therm[traj].thermostat_kind>=3){
+        therm[traj].propagate_stochastic(*dyn_var.p, invM, prms.thermostat_dofs, traj, 0.5*prms.dt);
+      }
+    }// traj
   }
 
   *dyn_var.p = *dyn_var.p + 0.5 * prms.dt * (*dyn_var.f);
@@ -1233,13 +1292,32 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
   }
   // Update coordinates of nuclei for all trajectories
   for(traj=0; traj<ntraj; traj++){
+
+    // Langevin thermostat, BAOAB splitting: the drift is split into two halves, the O step acts in the middle
+    int is_baoab = (prms.ensemble==1 && therm[traj].thermostat_kind==2);
+    double dt_drift = prms.dt;
+    if(is_baoab){ dt_drift = 0.5*prms.dt; }
+
     for(dof=0; dof<ndof; dof++){  
-      dyn_var.q->add(dof, traj,  invM.get(dof,0) * dyn_var.p->get(dof,traj) * prms.dt ); 
+      dyn_var.q->add(dof, traj,  invM.get(dof,0) * dyn_var.p->get(dof,traj) * dt_drift ); 
       
       if(prms.entanglement_opt==22){
         dyn_var.q->add(dof, traj,  invM.get(dof,0) * gamma.get(dof,traj) * prms.dt ); 
       }
     }
+
+    if(is_baoab){
+      therm[traj].propagate_stochastic(*dyn_var.p, invM, prms.thermostat_dofs, traj, prms.dt);
+
+      // Kinetic constraint
+      for(cdof = 0; cdof < prms.constrained_dofs.size(); cdof++){   
+        dyn_var.p->set(prms.constrained_dofs[cdof], traj, 0.0); 
+      }
+
+      for(dof=0; dof<ndof; dof++){  
+        dyn_var.q->add(dof, traj,  invM.get(dof,0) * dyn_var.p->get(dof,traj) * dt_drift ); 
+      }
+    }// is_baoab
   }
 
 
@@ -1266,6 +1344,15 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
     update_wp_width(dyn_var, prms);  
   }
 
+  // The number of the electronic substeps of each trajectory
+  if(prms.adaptive_electronic_substeps==1){
+    dyn_var.num_el_substeps = electronic_substeps(dyn_var, ham, ham_aux, prms);
+    num_el = 1;
+    for(traj=0; traj<ntraj; traj++){ num_el = std::max(num_el, dyn_var.num_el_substeps[traj]); }
+    prms.num_electronic_substeps = num_el;  // the XF methods use the same number for all trajectories
+  }
+  else{  dyn_var.num_el_substeps = vector<int>(ntraj, num_el);  }
+
   // Propagate electronic coefficients in the [t, t + dt] interval, this also updates the 
   // basis re-projection matrices 
   for(i=0; i<num_el; i++){
@@ -1274,7 +1361,7 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
       propagate_half_xf(dyn_var, ham, prms);
     }
 
-    propagate_electronic(dyn_var, ham, ham_aux, prms);
+    propagate_electronic(dyn_var, ham, ham_aux, prms, dyn_var.num_el_substeps, i);
 
     if(prms.decoherence_algo == 5 or prms.decoherence_algo == 6){
       rotate_nab_phase(dyn_var, ham, prms);
@@ -1298,6 +1385,8 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
   else{  dyn_var.update_active_states(1, 0); // 1 - forward; 0 - only active state
   }
 
+  if(dyn_var.act_states != old_states){ is_event = 1; }
+
   // For now, this function also accounts for the kinetic energy adjustments to reflect the adiabatic evolution
   if(prms.thermally_corrected_nbra==1){    apply_thermal_correction(dyn_var, ham, ham_aux, old_states, prms, rnd); }
 
@@ -1327,6 +1416,24 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
     dyn_var.p->scale(prms.constrained_dofs[cdof], -1, 0.0); 
   }
 
+  // The errors of the step: the change of the total energy and the relative change of the force,
+  // before the thermostat and the hops change the momenta
+  if(prms.adaptive_dt==1){
+    vector<double> Etot1 = potential_energies(prms, dyn_var, ham);
+    Ekin = dyn_var.compute_kinetic_energies();
+
+    for(traj=0; traj<ntraj; traj++){
+      dE[traj] = Etot1[traj] + Ekin[traj] - Etot0[traj];
+
+      double df = 0.0, nf0 = 0.0, nf1 = 0.0;
+      for(dof=0; dof<ndof; dof++){
+        double x0 = f0.get(dof, traj), x1 = dyn_var.f->get(dof, traj);
+        df += (x1-x0)*(x1-x0);  nf0 += x0*x0;  nf1 += x1*x1;
+      }
+      dF[traj] = sqrt(df) / (sqrt(std::max(nf0, nf1)) + 1e-8);
+    }
+  }
+
   // NVT dynamics
   if(prms.ensemble==1){  
     for(idof=0; idof<n_therm_dofs; idof++){
@@ -1335,6 +1442,13 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
         dyn_var.p->scale(dof, traj, therm[traj].vel_scale(0.5*prms.dt));
       }// traj
     }// idof 
+
+    // CSVR and Andersen thermostats - symmetric half-step operators, similar to the Nose-Hoover scaling
+    for(traj=0; traj<ntraj; traj++){
+      if(therm[traj].thermostat_kind>=3){
+        therm[traj].propagate_stochastic(*dyn_var.p, invM, prms.thermostat_dofs, traj, 0.5*prms.dt);
+      }
+    }// traj
   }
 
   //ham_aux.copy_content(ham);
@@ -1468,6 +1582,10 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
         act_states_dia = accept_hops(dyn_var, ham, prop_states, dyn_var.act_states_dia, prms, rnd);
       }
 
+      // Any attempted hop: the force on the new surface is not known yet, so the next step is not increased
+      if(prms.rep_sh==1 && prop_states != old_states){ is_event = 1; }
+      if(prms.rep_sh==0 && prop_states != old_states_dia){ is_event = 1; }
+
       //=== Post-hop decoherence options ===
 
       // Instantaneous decoherence
@@ -1512,6 +1630,9 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
 
     //====================== Momenta adjustment after successful/frustrated hops ===================
     // Velocity rescaling: however here we may be changing velocities
+    if(prms.rep_sh==1 && act_states != old_states){ is_event = 1; }
+    if(prms.rep_sh==0 && act_states_dia != old_states_dia){ is_event = 1; }
+
     if(prms.rep_sh==1){
       handle_hops_nuclear(dyn_var, ham, act_states, old_states, prms);
       dyn_var.act_states = act_states;
@@ -1544,7 +1665,17 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params,
   // Saves the current density matrix into the previous - needed for FSSH2
   dyn_var.save_curr_dm_into_prev();
 
-  
+  // The time and the step for the next call
+  dyn_var.elapsed_time += prms.dt;
+  if(prms.adaptive_dt==1){  dyn_var.dt_adapt = adaptive_time_step(prms, prms.dt, dE, dF, is_event);  }
+
+  // Periodic checkpoints: timestep is the index of the step just completed
+  if(prms.checkpoint_frequency>0){
+    dyn_var.get_current_timestep(params);
+    if( (dyn_var.timestep + 1) % prms.checkpoint_frequency == 0 ){
+      dyn_var.save_checkpoint(prms.checkpoint_filename, ham, rnd, therm);
+    }
+  }
 
 }
 
@@ -74,6 +74,10 @@ int need_active_states_diff_rep(dyn_control_params& prms);
 
 void propagate_electronic(dyn_variables& dyn_var, nHamiltonian& ham, nHamiltonian& ham_prev, dyn_control_params& prms);
 void propagate_electronic(dyn_variables& dyn_var, nHamiltonian* ham, nHamiltonian* ham_prev, dyn_control_params& prms);
+void propagate_electronic(dyn_variables& dyn_var, nHamiltonian& ham, nHamiltonian& ham_prev, dyn_control_params& prms,
+                          const vector<int>& num_el, int isubstep);
+void propagate_electronic(dyn_variables& dyn_var, nHamiltonian* ham, nHamiltonian* ham_prev, dyn_control_params& prms,
+                          const vector<int>& num_el, int isubstep);
 
 /*
 void compute_dynamics(MATRIX& q, MATRIX& p, MATRIX& invM, CMATRIX& C, vector<CMATRIX>& projectors, vector<int>& act_states, 
@@ -92,6 +96,12 @@ void compute_dynamics(dyn_variables& dyn_var, bp::dict dyn_params, nHamiltonian&
                       bp::object py_funct, bp::dict model_params, Random& rnd, vector<Thermostat>& therm);
 
 
+//========== dyn_adaptive_step.cpp ===================
+
+vector<int> electronic_substeps(dyn_variables& dyn_var, nHamiltonian& Ham, nHamiltonian& Ham_prev, dyn_control_params& prms);
+double adaptive_time_step(dyn_control_params& prms, double dt, vector<double>& dE, vector<double>& dF, int is_event);
+
+
 
 
 
@@ -19,6 +19,7 @@
 
 #include "Energy_and_Forces.h"
 #include "dyn_projectors.h"
+#include "../timer/Profiler.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -297,6 +298,7 @@ void update_forces(dyn_control_params& prms, dyn_variables& dyn_vars, nHamiltoni
   /**
     Compute the force depending on the method used
   */
+  ScopedTimer _prof("update_forces");
 
   int ndof = ham.nnucl;
   int nst = ham.nadi;
@@ -340,7 +342,7 @@ void update_forces(dyn_control_params& prms, dyn_variables& dyn_vars, nHamiltoni
   else if(prms.force_method==2){  // Ehrenfest forces
     // Diabatic 
     if(prms.rep_force==0){  
-     *dyn_vars.f = ham.Ehrenfest_forces_dia(*dyn_vars.ampl_dia, 1).real();  
+     ham.Ehrenfest_forces_dia(*dyn_vars.ampl_dia, *dyn_vars.f, 1, 0);
 
      //cout<<"dia MF forces\n"; dyn_vars.f->show_matrix();
      //cout<<"adi MF forces\n"; ham.Ehrenfest_forces_adi(*dyn_vars.ampl_adi, 1).real().show_matrix();
@@ -359,7 +361,7 @@ void update_forces(dyn_control_params& prms, dyn_variables& dyn_vars, nHamiltoni
 
       option = 0;
       //*dyn_vars.f = ham.Ehrenfest_forces_adi(*dyn_vars.ampl_adi, 1, option, dyn_vars.proj_adi).real();
-      *dyn_vars.f = ham.Ehrenfest_forces_adi(*dyn_vars.ampl_adi, 1, option).real();
+      ham.Ehrenfest_forces_adi(*dyn_vars.ampl_adi, *dyn_vars.f, 1, option);
 /*
       CMATRIX& U = *ham.basis_transform;
       CMATRIX& C = *dyn_vars.ampl_adi;
@@ -0,0 +1,179 @@
+/*********************************************************************************
+* Copyright (C) 2023 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file dyn_adaptive_step.cpp
+  \brief The file implements the adaptive control of the nuclear time step and of the number
+  of the electronic substeps used in compute_dynamics
+
+*/
+
+#include "Dynamics.h"
+#include "dyn_control_params.h"
+#include "dyn_variables.h"
+
+
+/// liblibra namespace
+namespace liblibra{
+
+
+/// libdyn namespace
+namespace libdyn{
+
+
+
+vector<int> electronic_substeps(dyn_variables& dyn_var, nHamiltonian& Ham, nHamiltonian& Ham_prev, dyn_control_params& prms){
+/**
+  \brief The number of the electronic substeps needed by each trajectory in the nuclear step [t, t + dt]
+
+  \param[in] dyn_var The dynamical variables
+  \param[in] Ham The Hamiltonian at t + dt
+  \param[in] Ham_prev The Hamiltonian at t
+  \param[in] prms The control parameters: dt, rep_tdse, electronic_substep_tol, max_electronic_substeps, ...
+
+  With the substep h = dt / n, the number n of each trajectory is chosen so that neither of the two phases:
+
+    |Hvib_ij| * h  - the largest off-diagonal element of the mid-point vibronic Hamiltonian (the
+                     coupling that the splitting and the reprojection schemes treat approximately)
+
+    (dE/dt) * h^2 / 8  - a heuristic for the energy gaps changing at the rate
+                     dE/dt = [ max_i (E_i(t+dt) - E_i(t)) - min_i (E_i(t+dt) - E_i(t)) ] / dt
+
+  exceeds prms.electronic_substep_tol. The numbers are within [1, prms.max_electronic_substeps].
+  The second term is not an error bound: the mid-point rule is exact for the gaps that change linearly
+  in time, and its actual error is set by the curvature of E(t), which the two end points of the step do
+  not give. The term only refines the substeps of the trajectories whose gaps change fast, on the
+  assumption that these also change non-linearly.
+  With the XF methods (decoherence_algo = 5 or 6), which share the substep between all the
+  trajectories, all the trajectories use the largest number.
+*/
+
+  int itraj, i, j;
+  int ntraj = dyn_var.ntraj;
+  int is_adi = (prms.rep_tdse==1 || prms.rep_tdse==3);
+  int method = prms.electronic_integrator;
+  double dt = prms.dt;
+  double tol = prms.electronic_substep_tol;
+
+  vector<int> res(ntraj, 1);
+
+  for(itraj=0; itraj<ntraj; itraj++){
+
+    int traj1 = itraj;  if(method >=100 && method <200){ traj1 = 0; }
+    if(prms.isNBRA==1){ traj1 = 0; }
+
+    nHamiltonian* ham = Ham.children[traj1];
+    nHamiltonian* ham_prev = Ham_prev.children[traj1];
+
+    // The vibronic Hamiltonians, if available; otherwise - only the energies
+    CMATRIX* H1; CMATRIX* H0;
+    if(is_adi){
+      if(ham->hvib_adi_mem_status && ham_prev->hvib_adi_mem_status){  H1 = ham->hvib_adi;  H0 = ham_prev->hvib_adi; }
+      else{  H1 = ham->ham_adi;  H0 = ham_prev->ham_adi; }
+    }
+    else{
+      if(ham->hvib_dia_mem_status && ham_prev->hvib_dia_mem_status){  H1 = ham->hvib_dia;  H0 = ham_prev->hvib_dia; }
+      else{  H1 = ham->ham_dia;  H0 = ham_prev->ham_dia; }
+    }
+
+    int nst = H1->n_rows;
+    double vmax = 0.0;
+    double de_min = 0.0, de_max = 0.0;
+
+    for(i=0; i<nst; i++){
+      double de = H1->get(i,i).real() - H0->get(i,i).real();
+      if(i==0 || de<de_min){ de_min = de; }
+      if(i==0 || de>de_max){ de_max = de; }
+
+      for(j=0; j<nst; j++){
+        if(j==i){ continue; }
+        double v = std::abs( 0.5*(H1->get(i,j) + H0->get(i,j)) );
+        if(v>vmax){ vmax = v; }
+      }
+    }
+
+    double rate = (de_max - de_min) / dt;
+
+    double n1 = vmax * dt / tol;
+    double n2 = dt * sqrt( rate / (8.0 * tol) );
+    double n = std::ceil( std::max(n1, n2) );
+
+    if(n < 1.0){ n = 1.0; }
+    if(n > prms.max_electronic_substeps){ n = prms.max_electronic_substeps; }
+
+    res[itraj] = int(n);
+
+  }// for itraj
+
+
+  if(prms.decoherence_algo==5 || prms.decoherence_algo==6){
+    int nmax = 1;
+    for(itraj=0; itraj<ntraj; itraj++){  nmax = std::max(nmax, res[itraj]);  }
+    for(itraj=0; itraj<ntraj; itraj++){  res[itraj] = nmax;  }
+  }
+
+  return res;
+}
+
+
+
+double adaptive_time_step(dyn_control_params& prms, double dt, vector<double>& dE, vector<double>& dF, int is_event){
+/**
+  \brief The nuclear time step for the next call of compute_dynamics
+
+  \param[in] prms The control parameters: adaptive_dt_energy_tol, adaptive_dt_force_tol, adaptive_dt_min, ...
+  \param[in] dt The step that has just been made
+  \param[in] dE The changes of the total energies of all trajectories in this step [Ha]
+  \param[in] dF The relative changes of the forces of all trajectories in this step
+  \param[in] is_event 1 - a hop has been attempted or the active state has changed in this step in
+  any of the trajectories, so the step is not increased; 0 - otherwise. Such a step is neither rejected
+  nor redone with a smaller step - the only effect is that the next step can not grow
+
+  The energy error of the velocity Verlet step scales as dt^2 and the force change - as dt, so
+  the new step is:
+
+     0.9 * dt * min( sqrt( energy_tol / max|dE| ),  force_tol / max|dF| )
+
+  limited by the factor prms.adaptive_dt_max_factor in either direction and by the bounds
+  prms.adaptive_dt_min, prms.adaptive_dt_max. The energy criterion is not used in the NVT dynamics.
+*/
+
+  int i;
+  double fac = prms.adaptive_dt_max_factor;
+
+  if(prms.ensemble==0 && prms.adaptive_dt_energy_tol>0.0){
+    double x = 0.0;
+    for(i=0; i<(int)dE.size(); i++){  x = std::max(x, std::fabs(dE[i]));  }
+    if(x>0.0){  fac = std::min(fac, 0.9*sqrt(prms.adaptive_dt_energy_tol / x));  }
+  }
+
+  if(prms.adaptive_dt_force_tol>0.0){
+    double x = 0.0;
+    for(i=0; i<(int)dF.size(); i++){  x = std::max(x, std::fabs(dF[i]));  }
+    if(x>0.0){  fac = std::min(fac, 0.9*prms.adaptive_dt_force_tol / x);  }
+  }
+
+  if(is_event){  fac = std::min(fac, 1.0);  }
+
+  double fac_min = (prms.adaptive_dt_max_factor>1.0) ? 1.0/prms.adaptive_dt_max_factor : 0.25;
+  if(fac < fac_min){ fac = fac_min; }
+
+  double res = fac * dt;
+  if(res < prms.adaptive_dt_min){ res = prms.adaptive_dt_min; }
+  if(res > prms.adaptive_dt_max){ res = prms.adaptive_dt_max; }
+
+  return res;
+}
+
+
+
+}// namespace libdyn
+}// liblibra
+
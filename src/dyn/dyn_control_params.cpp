@@ -127,6 +127,17 @@ dyn_control_params::dyn_control_params(){
   electronic_integrator = 0;
   ampl_transformation_method = 1; 
   assume_always_consistent = 0;
+  checkpoint_frequency = 0;
+  checkpoint_filename = "checkpoint.bin";
+  adaptive_dt = 0;
+  adaptive_dt_energy_tol = 1e-5;
+  adaptive_dt_force_tol = 0.1;
+  adaptive_dt_min = 0.0;
+  adaptive_dt_max = 0.0;
+  adaptive_dt_max_factor = 2.0;
+  adaptive_electronic_substeps = 0;
+  electronic_substep_tol = 0.05;
+  max_electronic_substeps = 100;
 
   thermally_corrected_nbra = 0;
   total_energy = 0.01; // some reasonable value
@@ -233,6 +244,17 @@ dyn_control_params::dyn_control_params(const dyn_control_params& x){
   electronic_integrator = x.electronic_integrator;
   ampl_transformation_method = x.ampl_transformation_method;
   assume_always_consistent = x. assume_always_consistent;
+  checkpoint_frequency = x.checkpoint_frequency;
+  checkpoint_filename = x.checkpoint_filename;
+  adaptive_dt = x.adaptive_dt;
+  adaptive_dt_energy_tol = x.adaptive_dt_energy_tol;
+  adaptive_dt_force_tol = x.adaptive_dt_force_tol;
+  adaptive_dt_min = x.adaptive_dt_min;
+  adaptive_dt_max = x.adaptive_dt_max;
+  adaptive_dt_max_factor = x.adaptive_dt_max_factor;
+  adaptive_electronic_substeps = x.adaptive_electronic_substeps;
+  electronic_substep_tol = x.electronic_substep_tol;
+  max_electronic_substeps = x.max_electronic_substeps;
 
   decoherence_rates = new MATRIX(x.decoherence_rates->n_rows, x.decoherence_rates->n_cols);  
   *decoherence_rates = *x.decoherence_rates;
@@ -324,6 +346,20 @@ void dyn_control_params::sanity_check(){
       cout<<"Exiting...\n";
   }
 
+  if(adaptive_dt==1 && isNBRA==1){
+      cout<<"Error in dyn_control_params::sanity_check: adaptive_dt = 1 can not be used with NBRA, "
+          <<"the precomputed Hamiltonians are given on a fixed time grid"<<endl;
+      cout<<"Exiting...\n";
+      exit(0);
+  }
+
+  if(adaptive_electronic_substeps==1 && (electronic_substep_tol<=0.0 || max_electronic_substeps<=0)){
+      cout<<"Error in dyn_control_params::sanity_check: electronic_substep_tol and max_electronic_substeps "
+          <<"should be positive"<<endl;
+      cout<<"Exiting...\n";
+      exit(0);
+  }
+
 }
 
 
@@ -476,6 +512,17 @@ void dyn_control_params::set_parameters(bp::dict params){
     else if(key=="electronic_integrator"){ electronic_integrator = bp::extract<int>(params.values()[i]); }
     else if(key=="ampl_transformation_method"){ ampl_transformation_method = bp::extract<int>(params.values()[i]); }
     else if(key=="assume_always_consistent"){  assume_always_consistent = bp::extract<int>(params.values()[i]); }
+    else if(key=="checkpoint_frequency"){  checkpoint_frequency = bp::extract<int>(params.values()[i]); }
+    else if(key=="checkpoint_filename"){  checkpoint_filename = bp::extract<std::string>(params.values()[i]); }
+    else if(key=="adaptive_dt"){  adaptive_dt = bp::extract<int>(params.values()[i]); }
+    else if(key=="adaptive_dt_energy_tol"){  adaptive_dt_energy_tol = bp::extract<double>(params.values()[i]); }
+    else if(key=="adaptive_dt_force_tol"){  adaptive_dt_force_tol = bp::extract<double>(params.values()[i]); }
+    else if(key=="adaptive_dt_min"){  adaptive_dt_min = bp::extract<double>(params.values()[i]); }
+    else if(key=="adaptive_dt_max"){  adaptive_dt_max = bp::extract<double>(params.values()[i]); }
+    else if(key=="adaptive_dt_max_factor"){  adaptive_dt_max_factor = bp::extract<double>(params.values()[i]); }
+    else if(key=="adaptive_electronic_substeps"){  adaptive_electronic_substeps = bp::extract<int>(params.values()[i]); }
+    else if(key=="electronic_substep_tol"){  electronic_substep_tol = bp::extract<double>(params.values()[i]); }
+    else if(key=="max_electronic_substeps"){  max_electronic_substeps = bp::extract<int>(params.values()[i]); }
 
     else if(key=="thermally_corrected_nbra"){ thermally_corrected_nbra = bp::extract<int>(params.values()[i]); }
     else if(key=="total_energy") { total_energy = bp::extract<double>(params.values()[i]);  }
@@ -900,6 +900,98 @@ class dyn_control_params{
   */
   int assume_always_consistent;
 
+
+  /**
+    How often to write the checkpoint of the dynamical variables (see dyn_variables::save_checkpoint)
+    in compute_dynamics. The checkpoint is written after the steps with ("timestep" + 1) divisible by 
+    this number, where "timestep" is the index of the step set in the model parameters
+
+    Options:
+
+      - 0: do not write checkpoints [ default ]
+      - N > 0: every N steps
+  */
+  int checkpoint_frequency;
+
+
+  /**
+    The name of the checkpoint file written by compute_dynamics [ default: "checkpoint.bin" ]
+    The file is overwritten every time, so it always contains the latest state.
+  */
+  std::string checkpoint_filename;
+
+
+  /**
+    Adaptive control of the nuclear time step in compute_dynamics. The step is chosen at the end of each
+    call for the next one, from the energy conservation and the force change of all trajectories (all the
+    trajectories share one step, since they share the Hamiltonian calculations and the output times).
+    The steps are not rejected. The current step and the elapsed time are kept in dyn_variables::dt_adapt 
+    and dyn_variables::elapsed_time; the "dt" parameter is only the initial step
+
+    Options:
+
+      - 0: fixed step `dt` [ default ]
+      - 1: adaptive step
+  */
+  int adaptive_dt;
+
+
+  /**
+    The target change of the total energy of a trajectory during one nuclear step (adaptive_dt = 1).
+    Not used in the NVT dynamics. Zero or negative - not used [ units: Ha, default: 1e-5 ]
+  */
+  double adaptive_dt_energy_tol;
+
+
+  /**
+    The target relative change of the force acting on a trajectory during one nuclear step (adaptive_dt = 1), 
+    |F(t+dt) - F(t)| / max(|F(t)|, |F(t+dt)|). Zero or negative - not used [ default: 0.1 ]
+  */
+  double adaptive_dt_force_tol;
+
+
+  /**
+    The smallest and the largest nuclear steps allowed (adaptive_dt = 1). Zero or negative values select
+    dt/16 and 4*dt, respectively [ units: a.u. of time, default: 0.0 ]
+  */
+  double adaptive_dt_min;
+  double adaptive_dt_max;
+
+
+  /**
+    The largest factor by which the nuclear step may change from one step to the next (adaptive_dt = 1). 
+    The step is never increased after a step in which any trajectory attempted a hop or changed its active
+    state by the decoherence correction, since the force on the new surface is not known yet. This is the
+    only handling of these events: the step in which they happen is neither rejected nor shortened [ default: 2.0 ]
+  */
+  double adaptive_dt_max_factor;
+
+
+  /**
+    Adaptive number of the electronic integration substeps:
+
+      - 0: `num_electronic_substeps` for all trajectories [ default ]
+      - 1: chosen for each trajectory in every nuclear step, from the largest off-diagonal element of 
+           its vibronic Hamiltonian and the rate of change of its energy gaps, see electronic_substep_tol. 
+           With the XF methods, all the trajectories use the largest of these numbers
+  */
+  int adaptive_electronic_substeps;
+
+
+  /**
+    The largest phase [ radians ] accumulated by the electronic coefficients in one electronic substep
+    due to the couplings (adaptive_electronic_substeps = 1). The same number also limits the heuristic 
+    (dE/dt) * h^2 / 8 term of the energy gaps changing at the rate dE/dt, which is not an error bound 
+    [ default: 0.05 ]
+  */
+  double electronic_substep_tol;
+
+
+  /**
+    The largest number of the electronic substeps per nuclear step (adaptive_electronic_substeps = 1) [ default: 100 ]
+  */
+  int max_electronic_substeps;
+
  
   /**
     Flag setting to use the thermal correction to NBRA: 0 - no (default approach); 1 - rescale NACs
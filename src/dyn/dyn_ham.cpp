@@ -17,6 +17,7 @@
 
 #include "dyn_ham.h"
 #include "dyn_projectors.h"
+#include "../timer/Profiler.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -69,6 +70,7 @@ void update_Hamiltonian_variables(dyn_control_params& prms, dyn_variables& dyn_v
      - 1: update according to changed NACs and energies
      
 */ 
+  ScopedTimer _prof("update_Hamiltonian_variables");
 
   int nadi = ham.nadi;
   int ndof = dyn_var.ndof;
@@ -325,6 +327,7 @@ void update_proj_adi(dyn_control_params& prms, dyn_variables& dyn_var, nHamilton
 /**
   Just re-compute the proj_adi matrices
 */
+  ScopedTimer _prof("update_proj_adi");
 
   //======= Parameters of the dyn variables ==========
   int ntraj = dyn_var.ntraj;
@@ -114,6 +114,11 @@ dyn_variables::dyn_variables(int _ndia, int _nadi, int _ndof, int _ntraj){
   ///================= QTSH ====================
   qtsh_vars_status = 0;
 
+  ///================= Misc ====================
+  timestep = 0;
+  dt_adapt = 0.0;
+  elapsed_time = 0.0;
+
 }
 
 
@@ -441,6 +446,11 @@ dyn_variables::dyn_variables(const dyn_variables& x){
 
   }// if QTSH vars
 
+  // The time stepping state
+  dt_adapt = x.dt_adapt;
+  elapsed_time = x.elapsed_time;
+  num_el_substeps = x.num_el_substeps;
+
 }// dyn_variables cctor
 
 
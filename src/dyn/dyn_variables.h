@@ -28,6 +28,7 @@
 #include "../math_random/librandom.h"
 #include "../math_specialfunctions/libspecialfunctions.h"
 #include "../nhamiltonian/libnhamiltonian.h"
+#include "../io/libio.h"
 #include "dyn_control_params.h"
 #include "thermostat/Thermostat.h"
 
@@ -517,6 +518,26 @@ class dyn_variables{
   int timestep; 
 
 
+  /**
+    The nuclear time step to be used by the next call of compute_dynamics, with the adaptive
+    step control (dyn_control_params::adaptive_dt = 1); 0 - not set yet, the "dt" parameter is used
+    [ units: a.u. of time ]
+  */
+  double dt_adapt;
+
+
+  /**
+    The simulation time elapsed in all the calls of compute_dynamics [ units: a.u. of time ]
+  */
+  double elapsed_time;
+
+
+  /**
+    The numbers of the electronic substeps used by each trajectory in the last nuclear step
+  */
+  vector<int> num_el_substeps;
+
+
 
   ///====================== In dyn_variables.cpp =====================
 
@@ -620,6 +641,8 @@ class dyn_variables{
   vector<double> compute_average_sh_pop_TR(int rep);
   vector<double> compute_average_mash_pop(int rep);
 
+  void get_traj_frame(libio::traj_frame& fr, int rep);
+
 
   double compute_tcnbra_ekin();
   double compute_tcnbra_thermostat_energy();
@@ -627,6 +650,14 @@ class dyn_variables{
   void save_curr_dm_into_prev();
 
 
+  ///====================== In dyn_variables_checkpoint.cpp =====================
+
+  void save_checkpoint(std::string filename);
+  void save_checkpoint(std::string filename, nHamiltonian& ham, Random& rnd, vector<Thermostat>& therm);
+  void load_checkpoint(std::string filename);
+  void load_checkpoint(std::string filename, nHamiltonian& ham, Random& rnd, vector<Thermostat>& therm);
+
+
 
   friend bool operator == (const dyn_variables& n1, const dyn_variables& n2){
     return &n1 == &n2;
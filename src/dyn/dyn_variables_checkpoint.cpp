@@ -0,0 +1,767 @@
+/*********************************************************************************
+* Copyright (C) 2021-2024 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file dyn_variables_checkpoint.cpp
+  \brief The file implements the binary checkpoints of the dynamical variables
+
+  File layout (native byte order):
+
+    header:   char[8] "LIBRACHK", int32 version, int32 ndia, nadi, ndof, ntraj, int32 timestep
+    sections: int32 tag, int64 nbytes, payload[nbytes]  ...  int32 0 (end)
+
+  Every group of the variables (electronic, nuclear, A-FSSH, ..., the random number stream,
+  the thermostats, the Hamiltonians) is stored in its own section, only if it is allocated.
+  The reader skips the sections it does not know, so adding a new section keeps the version
+  and such files can still be read by the older code. The version is increased only when the
+  layout of the header or of an existing section changes; the reader refuses the files with a
+  version newer than its own. Matrices are stored as int32 n_rows, int32 n_cols and the raw
+  elements, so the restart is exact to the last bit.
+
+  The whole checkpoint is serialized in memory and written by one call to a temporary file,
+  which is then renamed - the previous checkpoint stays intact if the job is killed while writing.
+*/
+
+#include "dyn_variables.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+
+/// libdyn namespace
+namespace libdyn{
+
+namespace bp = boost::python;
+
+
+static const int checkpoint_version = 1;   ///< increase only for incompatible changes of the layout
+
+/// The tags of the checkpoint sections
+enum{ chk_end = 0, chk_electronic = 1, chk_nuclear = 2, chk_afssh = 3, chk_bcsh = 4, chk_dish = 5,
+      chk_fssh2 = 6, chk_shxf = 7, chk_mqcxf = 8, chk_tcnbra = 9, chk_qtsh = 10, chk_time = 11,
+      chk_random = 20, chk_thermostats = 21, chk_hamiltonian = 22 };
+
+
+
+//======================= Writing =========================
+
+static void put_bytes(vector<char>& buf, const void* x, size_t n){
+  const char* c = (const char*)x;
+  buf.insert(buf.end(), c, c + n);
+}
+
+static void put_int(vector<char>& buf, int x){  int32_t v = x;  put_bytes(buf, &v, sizeof(int32_t));  }
+
+static void put_double(vector<char>& buf, double x){  put_bytes(buf, &x, sizeof(double));  }
+
+static void put_string(vector<char>& buf, const std::string& x){
+  put_int(buf, x.size());
+  put_bytes(buf, x.data(), x.size());
+}
+
+static void put_ints(vector<char>& buf, const vector<int>& x){
+  put_int(buf, x.size());
+  for(int i=0; i<(int)x.size(); i++){  put_int(buf, x[i]);  }
+}
+
+static void put_doubles(vector<char>& buf, const vector<double>& x){
+  put_int(buf, x.size());
+  if(x.size()>0){ put_bytes(buf, &x[0], x.size()*sizeof(double)); }
+}
+
+static void put_matrix(vector<char>& buf, const MATRIX& x){
+  put_int(buf, x.n_rows);  put_int(buf, x.n_cols);
+  put_bytes(buf, x.M, x.n_elts*sizeof(double));
+}
+
+static void put_cmatrix(vector<char>& buf, const CMATRIX& x){
+  put_int(buf, x.n_rows);  put_int(buf, x.n_cols);
+  put_bytes(buf, x.M, x.n_elts*sizeof(complex<double>));
+}
+
+static size_t begin_section(vector<char>& buf, int tag){
+  put_int(buf, tag);
+  size_t pos = buf.size();
+  int64_t nbytes = 0;
+  put_bytes(buf, &nbytes, sizeof(int64_t));
+  return pos;
+}
+
+static void end_section(vector<char>& buf, size_t pos){
+  int64_t nbytes = buf.size() - pos - sizeof(int64_t);
+  memcpy(&buf[pos], &nbytes, sizeof(int64_t));
+}
+
+
+
+//======================= Reading =========================
+
+class checkpoint_reader{
+/**
+  The cursor over the content of the checkpoint file, with the bounds checks
+*/
+
+public:
+
+  vector<char> data;
+  size_t pos;
+  std::string filename;
+
+  checkpoint_reader(std::string _filename){
+
+    filename = _filename;
+    pos = 0;
+
+    FILE* fp = fopen(filename.c_str(), "rb");
+    if(fp==NULL){
+      cout<<"Error in load_checkpoint: can not open file "<<filename<<"\nExiting...\n"; exit(0);
+    }
+    fseek(fp, 0, SEEK_END);
+    long sz = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    data.resize(sz);
+    if(sz>0 && fread(&data[0], 1, sz, fp) != (size_t)sz){
+      cout<<"Error in load_checkpoint: can not read file "<<filename<<"\nExiting...\n"; exit(0);
+    }
+    fclose(fp);
+  }
+
+  void get_bytes(void* x, size_t n){
+    if(pos + n > data.size()){
+      cout<<"Error in load_checkpoint: the file "<<filename<<" is truncated or corrupted\nExiting...\n"; exit(0);
+    }
+    if(n>0){ memcpy(x, &data[pos], n); }
+    pos += n;
+  }
+
+  int get_int(){  int32_t v;  get_bytes(&v, sizeof(int32_t));  return v;  }
+
+  double get_double(){  double v;  get_bytes(&v, sizeof(double));  return v;  }
+
+  int get_count(size_t elt_size){
+  /**
+    The number of the elements of the array that follows; it can not be negative or exceed the rest of the file,
+    so a corrupted count is reported before anything is allocated
+  */
+    int n = get_int();
+    if(n<0 || (size_t)n*elt_size > data.size() - pos){
+      cout<<"Error in load_checkpoint: the file "<<filename<<" is truncated or corrupted (an array of "<<n
+          <<" elements)\nExiting...\n"; exit(0);
+    }
+    return n;
+  }
+
+  std::string get_string(){
+    int n = get_count(1);
+    std::string x(n, ' ');
+    if(n>0){ get_bytes(&x[0], n); }
+    return x;
+  }
+
+  void get_ints(vector<int>& x){
+    int n = get_count(sizeof(int32_t));
+    x.resize(n);
+    for(int i=0; i<n; i++){  x[i] = get_int();  }
+  }
+
+  void get_doubles(vector<double>& x){
+    int n = get_count(sizeof(double));
+    x.resize(n);
+    if(n>0){ get_bytes(&x[0], n*sizeof(double)); }
+  }
+
+  void check_dims(int nr, int nc, int n_rows, int n_cols, const char* what){
+    if(nr!=n_rows || nc!=n_cols){
+      cout<<"Error in load_checkpoint: "<<what<<" is stored as a "<<nr<<" x "<<nc<<" matrix, but the target is "
+          <<n_rows<<" x "<<n_cols<<"\nExiting...\n"; exit(0);
+    }
+  }
+
+  void get_matrix(MATRIX& x, const char* what){
+    int nr = get_int(), nc = get_int();
+    check_dims(nr, nc, x.n_rows, x.n_cols, what);
+    get_bytes(x.M, x.n_elts*sizeof(double));
+  }
+
+  void get_cmatrix(CMATRIX& x, const char* what){
+    int nr = get_int(), nc = get_int();
+    check_dims(nr, nc, x.n_rows, x.n_cols, what);
+    get_bytes(x.M, x.n_elts*sizeof(complex<double>));
+  }
+
+};
+
+
+
+//======================= Thermostats =========================
+
+static void put_thermostat(vector<char>& buf, const Thermostat& th){
+
+  put_doubles(buf, th.s_t);    put_doubles(buf, th.s_r);    put_doubles(buf, th.s_b);
+  put_doubles(buf, th.ksi_t);  put_doubles(buf, th.ksi_r);  put_doubles(buf, th.ksi_b);
+  put_doubles(buf, th.G_t);    put_doubles(buf, th.G_r);    put_doubles(buf, th.G_b);
+  put_doubles(buf, th.Q_t);    put_doubles(buf, th.Q_r);    put_doubles(buf, th.Q_b);
+
+  put_double(buf, th.Nf_t);  put_double(buf, th.Nf_r);  put_double(buf, th.Nf_b);
+  put_double(buf, th.s_var);  put_double(buf, th.Ps);  put_double(buf, th.Q);
+  put_double(buf, th.heat);
+  put_int(buf, th.thermostat_kind);
+
+  put_string(buf, th.get_rng_state());
+}
+
+static void get_thermostat(checkpoint_reader& rd, Thermostat& th){
+
+  rd.get_doubles(th.s_t);    th.s_t_size = th.s_t.size();
+  rd.get_doubles(th.s_r);    th.s_r_size = th.s_r.size();
+  rd.get_doubles(th.s_b);    th.s_b_size = th.s_b.size();
+  rd.get_doubles(th.ksi_t);  th.ksi_t_size = th.ksi_t.size();
+  rd.get_doubles(th.ksi_r);  th.ksi_r_size = th.ksi_r.size();
+  rd.get_doubles(th.ksi_b);  th.ksi_b_size = th.ksi_b.size();
+  rd.get_doubles(th.G_t);    th.G_t_size = th.G_t.size();
+  rd.get_doubles(th.G_r);    th.G_r_size = th.G_r.size();
+  rd.get_doubles(th.G_b);    th.G_b_size = th.G_b.size();
+  rd.get_doubles(th.Q_t);    th.Q_t_size = th.Q_t.size();
+  rd.get_doubles(th.Q_r);    th.Q_r_size = th.Q_r.size();
+  rd.get_doubles(th.Q_b);    th.Q_b_size = th.Q_b.size();
+
+  th.Nf_t = rd.get_double();  th.is_Nf_t = 1;
+  th.Nf_r = rd.get_double();  th.is_Nf_r = 1;
+  th.Nf_b = rd.get_double();  th.is_Nf_b = 1;
+  th.s_var = rd.get_double();  th.is_s_var = 1;
+  th.Ps = rd.get_double();  th.is_Ps = 1;
+  th.Q = rd.get_double();  th.is_Q = 1;
+  th.heat = rd.get_double();
+  th.thermostat_kind = rd.get_int();
+
+  th.set_rng_state(rd.get_string());
+}
+
+static void put_thermostats(vector<char>& buf, const vector<Thermostat>& therm){
+  put_int(buf, therm.size());
+  for(int i=0; i<(int)therm.size(); i++){  put_thermostat(buf, therm[i]);  }
+}
+
+static void get_thermostats(checkpoint_reader& rd, vector<Thermostat>& therm, const char* what){
+  int n = rd.get_int();
+  if(n!=(int)therm.size()){
+    cout<<"Error in load_checkpoint: the checkpoint has "<<n<<" "<<what<<", but the target has "<<therm.size()<<"\nExiting...\n";
+    exit(0);
+  }
+  for(int i=0; i<n; i++){  get_thermostat(rd, therm[i]);  }
+}
+
+
+
+//======================= Hamiltonians =========================
+
+static void put_hamiltonian(vector<char>& buf, nHamiltonian* ham){
+/**
+  The allocated matrices of this Hamiltonian and (recursively) of all its children
+*/
+
+  CMATRIX* x[11] = { ham->ovlp_dia, ham->ham_dia, ham->nac_dia, ham->hvib_dia, ham->ham_adi, ham->nac_adi, ham->hvib_adi,
+                     ham->basis_transform, ham->time_overlap_adi, ham->time_overlap_dia, ham->cum_phase_corr };
+  int st[11] = { ham->ovlp_dia_mem_status, ham->ham_dia_mem_status, ham->nac_dia_mem_status, ham->hvib_dia_mem_status,
+                 ham->ham_adi_mem_status, ham->nac_adi_mem_status, ham->hvib_adi_mem_status, ham->basis_transform_mem_status,
+                 ham->time_overlap_adi_mem_status, ham->time_overlap_dia_mem_status, ham->cum_phase_corr_mem_status };
+
+  vector<CMATRIX*>* xv[6] = { &ham->dc1_dia, &ham->d1ham_dia, &ham->d2ham_dia, &ham->dc1_adi, &ham->d1ham_adi, &ham->d2ham_adi };
+  vector<int>* stv[6] = { &ham->dc1_dia_mem_status, &ham->d1ham_dia_mem_status, &ham->d2ham_dia_mem_status,
+                          &ham->dc1_adi_mem_status, &ham->d1ham_adi_mem_status, &ham->d2ham_adi_mem_status };
+  int i, n;
+
+  put_int(buf, ham->ndia);  put_int(buf, ham->nadi);  put_int(buf, ham->nnucl);
+  put_int(buf, ham->children.size());
+
+  for(i=0; i<11; i++){
+    put_int(buf, (st[i]!=0));
+    if(st[i]!=0){ put_cmatrix(buf, *x[i]); }
+  }
+
+  for(i=0; i<6; i++){
+    put_int(buf, xv[i]->size());
+    for(n=0; n<(int)xv[i]->size(); n++){
+      put_int(buf, ((*stv[i])[n]!=0));
+      if((*stv[i])[n]!=0){ put_cmatrix(buf, *(*xv[i])[n]); }
+    }
+  }
+
+  if(ham->ordering_adi!=nullptr){ put_ints(buf, *ham->ordering_adi); }
+  else{ put_ints(buf, vector<int>()); }
+
+  for(n=0; n<(int)ham->children.size(); n++){  put_hamiltonian(buf, ham->children[n]);  }
+
+}
+
+
+static void get_hamiltonian(checkpoint_reader& rd, nHamiltonian* ham){
+
+  CMATRIX* x[11] = { ham->ovlp_dia, ham->ham_dia, ham->nac_dia, ham->hvib_dia, ham->ham_adi, ham->nac_adi, ham->hvib_adi,
+                     ham->basis_transform, ham->time_overlap_adi, ham->time_overlap_dia, ham->cum_phase_corr };
+  int st[11] = { ham->ovlp_dia_mem_status, ham->ham_dia_mem_status, ham->nac_dia_mem_status, ham->hvib_dia_mem_status,
+                 ham->ham_adi_mem_status, ham->nac_adi_mem_status, ham->hvib_adi_mem_status, ham->basis_transform_mem_status,
+                 ham->time_overlap_adi_mem_status, ham->time_overlap_dia_mem_status, ham->cum_phase_corr_mem_status };
+  const char* names[11] = { "ovlp_dia", "ham_dia", "nac_dia", "hvib_dia", "ham_adi", "nac_adi", "hvib_adi",
+                            "basis_transform", "time_overlap_adi", "time_overlap_dia", "cum_phase_corr" };
+
+  vector<CMATRIX*>* xv[6] = { &ham->dc1_dia, &ham->d1ham_dia, &ham->d2ham_dia, &ham->dc1_adi, &ham->d1ham_adi, &ham->d2ham_adi };
+  vector<int>* stv[6] = { &ham->dc1_dia_mem_status, &ham->d1ham_dia_mem_status, &ham->d2ham_dia_mem_status,
+                          &ham->dc1_adi_mem_status, &ham->d1ham_adi_mem_status, &ham->d2ham_adi_mem_status };
+  const char* names_v[6] = { "dc1_dia", "d1ham_dia", "d2ham_dia", "dc1_adi", "d1ham_adi", "d2ham_adi" };
+  int i, n;
+
+  int _ndia = rd.get_int(), _nadi = rd.get_int(), _nnucl = rd.get_int(), nchildren = rd.get_int();
+
+  if(_ndia!=ham->ndia || _nadi!=ham->nadi || _nnucl!=ham->nnucl || nchildren!=(int)ham->children.size()){
+    cout<<"Error in load_checkpoint: the Hamiltonian stored in the checkpoint (ndia = "<<_ndia<<", nadi = "<<_nadi
+        <<", nnucl = "<<_nnucl<<", "<<nchildren<<" children) does not match the target one (ndia = "<<ham->ndia
+        <<", nadi = "<<ham->nadi<<", nnucl = "<<ham->nnucl<<", "<<ham->children.size()<<" children)\nExiting...\n";
+    exit(0);
+  }
+
+  for(i=0; i<11; i++){
+    if(rd.get_int()){
+      if(st[i]==0){
+        cout<<"Error in load_checkpoint: "<<names[i]<<" is stored in the checkpoint, but it is not allocated in the target Hamiltonian\nExiting...\n";
+        exit(0);
+      }
+      rd.get_cmatrix(*x[i], names[i]);
+    }
+  }
+
+  for(i=0; i<6; i++){
+    int sz = rd.get_int();
+    if(sz!=(int)xv[i]->size()){
+      cout<<"Error in load_checkpoint: the checkpoint has "<<sz<<" "<<names_v[i]<<" matrices, but the target Hamiltonian has "
+          <<xv[i]->size()<<"\nExiting...\n"; exit(0);
+    }
+    for(n=0; n<sz; n++){
+      if(rd.get_int()){
+        if((*stv[i])[n]==0){
+          cout<<"Error in load_checkpoint: "<<names_v[i]<<"["<<n<<"] is stored in the checkpoint, but it is not allocated in the target Hamiltonian\nExiting...\n";
+          exit(0);
+        }
+        rd.get_cmatrix(*(*xv[i])[n], names_v[i]);
+      }
+    }
+  }
+
+  vector<int> ord;
+  rd.get_ints(ord);
+  if(ham->ordering_adi!=nullptr && ord.size()>0){ *ham->ordering_adi = ord; }
+
+  for(n=0; n<nchildren; n++){  get_hamiltonian(rd, ham->children[n]);  }
+
+}
+
+
+
+//======================= Dynamical variables =========================
+
+static void put_xf(vector<char>& buf, dyn_variables& dv, int is_mqcxf){
+/**
+  The variables of the SHXF (is_mqcxf = 0) and MQCXF (is_mqcxf = 1) methods
+*/
+
+  int itraj;
+
+  put_int(buf, dv.is_mixed.size());
+  for(itraj=0; itraj<(int)dv.is_mixed.size(); itraj++){
+    put_ints(buf, dv.is_mixed[itraj]);  put_ints(buf, dv.is_first[itraj]);
+    put_ints(buf, dv.is_fixed[itraj]);  put_ints(buf, dv.is_keep[itraj]);
+  }
+
+  for(itraj=0; itraj<dv.ntraj; itraj++){
+    put_matrix(buf, *dv.q_aux[itraj]);
+    put_matrix(buf, *dv.p_aux[itraj]);
+    put_matrix(buf, *dv.p_aux_old[itraj]);
+    put_matrix(buf, *dv.nab_phase[itraj]);
+    if(!is_mqcxf){ put_matrix(buf, *dv.nab_phase_old[itraj]); }
+    put_cmatrix(buf, *dv.ham_xf[itraj]);
+  }
+
+  put_matrix(buf, *dv.wp_width);
+  put_matrix(buf, *dv.p_quant);
+  put_matrix(buf, *dv.VP);
+  if(is_mqcxf){ put_matrix(buf, *dv.f_xf); }
+
+}
+
+static void get_xf(checkpoint_reader& rd, dyn_variables& dv, int is_mqcxf){
+
+  int itraj;
+
+  int n = rd.get_count(4*sizeof(int32_t));
+  dv.is_mixed.resize(n);  dv.is_first.resize(n);  dv.is_fixed.resize(n);  dv.is_keep.resize(n);
+  for(itraj=0; itraj<n; itraj++){
+    rd.get_ints(dv.is_mixed[itraj]);  rd.get_ints(dv.is_first[itraj]);
+    rd.get_ints(dv.is_fixed[itraj]);  rd.get_ints(dv.is_keep[itraj]);
+  }
+
+  for(itraj=0; itraj<dv.ntraj; itraj++){
+    rd.get_matrix(*dv.q_aux[itraj], "q_aux");
+    rd.get_matrix(*dv.p_aux[itraj], "p_aux");
+    rd.get_matrix(*dv.p_aux_old[itraj], "p_aux_old");
+    rd.get_matrix(*dv.nab_phase[itraj], "nab_phase");
+    if(!is_mqcxf){ rd.get_matrix(*dv.nab_phase_old[itraj], "nab_phase_old"); }
+    rd.get_cmatrix(*dv.ham_xf[itraj], "ham_xf");
+  }
+
+  rd.get_matrix(*dv.wp_width, "wp_width");
+  rd.get_matrix(*dv.p_quant, "p_quant");
+  rd.get_matrix(*dv.VP, "VP");
+  if(is_mqcxf){ rd.get_matrix(*dv.f_xf, "f_xf"); }
+
+}
+
+
+static void write_checkpoint(dyn_variables& dv, std::string filename, nHamiltonian* ham, Random* rnd, vector<Thermostat>* therm){
+
+  int itraj, idof;
+  size_t sec;
+  vector<char> buf;
+
+  // Rough estimate of the size, to avoid the reallocations
+  size_t est = 64 + 16*( dv.ntraj*( 2*dv.nadi*dv.nadi + dv.ndia*dv.ndia + dv.ndia*dv.nadi ) ) + 32*dv.ndof*dv.ntraj;
+  buf.reserve(est);
+
+  put_bytes(buf, "LIBRACHK", 8);
+  put_int(buf, checkpoint_version);
+  put_int(buf, dv.ndia);  put_int(buf, dv.nadi);  put_int(buf, dv.ndof);  put_int(buf, dv.ntraj);
+  put_int(buf, dv.timestep);
+
+  if(dv.electronic_vars_status){
+    sec = begin_section(buf, chk_electronic);
+    put_cmatrix(buf, *dv.ampl_dia);
+    put_cmatrix(buf, *dv.ampl_adi);
+    for(itraj=0; itraj<dv.ntraj; itraj++){
+      put_cmatrix(buf, *dv.proj_adi[itraj]);
+      put_cmatrix(buf, *dv.dm_dia[itraj]);
+      put_cmatrix(buf, *dv.dm_adi[itraj]);
+      put_cmatrix(buf, *dv.basis_transform[itraj]);
+    }
+    put_ints(buf, dv.act_states);
+    put_ints(buf, dv.act_states_dia);
+    end_section(buf, sec);
+  }
+
+  if(dv.nuclear_vars_status){
+    sec = begin_section(buf, chk_nuclear);
+    put_matrix(buf, *dv.iM);  put_matrix(buf, *dv.q);  put_matrix(buf, *dv.p);  put_matrix(buf, *dv.f);
+    end_section(buf, sec);
+  }
+
+  if(dv.afssh_vars_status){
+    sec = begin_section(buf, chk_afssh);
+    for(itraj=0; itraj<dv.ntraj; itraj++){
+      for(idof=0; idof<dv.ndof; idof++){  put_cmatrix(buf, *dv.dR[itraj][idof]);  put_cmatrix(buf, *dv.dP[itraj][idof]);  }
+    }
+    end_section(buf, sec);
+  }
+
+  if(dv.bcsh_vars_status){
+    sec = begin_section(buf, chk_bcsh);
+    put_matrix(buf, *dv.reversal_events);
+    end_section(buf, sec);
+  }
+
+  if(dv.dish_vars_status){
+    sec = begin_section(buf, chk_dish);
+    put_matrix(buf, *dv.coherence_time);
+    end_section(buf, sec);
+  }
+
+  if(dv.fssh2_vars_status){
+    sec = begin_section(buf, chk_fssh2);
+    for(itraj=0; itraj<dv.ntraj; itraj++){
+      put_cmatrix(buf, *dv.dm_dia_prev[itraj]);  put_cmatrix(buf, *dv.dm_adi_prev[itraj]);
+      put_doubles(buf, dv.fssh3_errors[itraj]);
+    }
+    end_section(buf, sec);
+  }
+
+  if(dv.shxf_vars_status){
+    sec = begin_section(buf, chk_shxf);  put_xf(buf, dv, 0);  end_section(buf, sec);
+  }
+
+  if(dv.mqcxf_vars_status){
+    sec = begin_section(buf, chk_mqcxf);  put_xf(buf, dv, 1);  end_section(buf, sec);
+  }
+
+  if(dv.tcnbra_vars_status){
+    sec = begin_section(buf, chk_tcnbra);
+    put_doubles(buf, dv.thermal_correction_factors);
+    put_doubles(buf, dv.tcnbra_ekin);
+    put_thermostats(buf, dv.tcnbra_thermostats);
+    end_section(buf, sec);
+  }
+
+  if(dv.qtsh_vars_status){
+    sec = begin_section(buf, chk_qtsh);
+    put_matrix(buf, *dv.qtsh_f_nc);
+    end_section(buf, sec);
+  }
+
+  if(dv.dt_adapt>0.0 || dv.elapsed_time!=0.0){
+    sec = begin_section(buf, chk_time);
+    put_double(buf, dv.dt_adapt);
+    put_double(buf, dv.elapsed_time);
+    put_ints(buf, dv.num_el_substeps);
+    end_section(buf, sec);
+  }
+
+  if(rnd!=nullptr){
+    if(rnd->get_is_seeded()){
+      sec = begin_section(buf, chk_random);
+      put_string(buf, rnd->get_state());
+      end_section(buf, sec);
+    }
+    else{
+      // Checkpoints are written many times during a run, so the warning is printed only once
+      static int is_warned = 0;
+      if(!is_warned){
+        cout<<"WARNING in save_checkpoint: the Random object is not seeded (see Random.set_seed), so its state \
+can not be saved and the restarted dynamics will use a different random number stream\n";
+        is_warned = 1;
+      }
+    }
+  }
+
+  if(therm!=nullptr){
+    sec = begin_section(buf, chk_thermostats);
+    put_thermostats(buf, *therm);
+    end_section(buf, sec);
+  }
+
+  if(ham!=nullptr){
+    sec = begin_section(buf, chk_hamiltonian);
+    put_hamiltonian(buf, ham);
+    end_section(buf, sec);
+  }
+
+  put_int(buf, chk_end);
+
+
+  // Write to the temporary file and replace the old checkpoint only when everything is written
+  std::string tmp_filename = filename + ".tmp";
+  FILE* fp = fopen(tmp_filename.c_str(), "wb");
+  if(fp==NULL){
+    cout<<"Error in save_checkpoint: can not open file "<<tmp_filename<<"\nExiting...\n"; exit(0);
+  }
+  size_t nw = fwrite(&buf[0], 1, buf.size(), fp);
+  int err = fflush(fp);
+  err += fclose(fp);
+  if(nw!=buf.size() || err!=0){
+    cout<<"Error in save_checkpoint: can not write file "<<tmp_filename<<"\nExiting...\n"; exit(0);
+  }
+  if(rename(tmp_filename.c_str(), filename.c_str())!=0){
+    cout<<"Error in save_checkpoint: can not rename "<<tmp_filename<<" to "<<filename<<"\nExiting...\n"; exit(0);
+  }
+
+}
+
+
+static void read_checkpoint(dyn_variables& dv, std::string filename, nHamiltonian* ham, Random* rnd, vector<Thermostat>* therm){
+
+  int itraj, idof;
+  checkpoint_reader rd(filename);
+
+  char magic[8];
+  rd.get_bytes(magic, 8);
+  if(strncmp(magic, "LIBRACHK", 8)!=0){
+    cout<<"Error in load_checkpoint: "<<filename<<" is not a Libra checkpoint file\nExiting...\n"; exit(0);
+  }
+
+  int version = rd.get_int();
+  if(version>checkpoint_version){
+    cout<<"Error in load_checkpoint: the checkpoint version "<<version<<" is newer than the supported one ("
+        <<checkpoint_version<<")\nExiting...\n"; exit(0);
+  }
+
+  int _ndia = rd.get_int(), _nadi = rd.get_int(), _ndof = rd.get_int(), _ntraj = rd.get_int();
+  if(_ndia!=dv.ndia || _nadi!=dv.nadi || _ndof!=dv.ndof || _ntraj!=dv.ntraj){
+    cout<<"Error in load_checkpoint: the checkpoint is for ndia = "<<_ndia<<", nadi = "<<_nadi<<", ndof = "<<_ndof
+        <<", ntraj = "<<_ntraj<<", but the dyn_variables object has ndia = "<<dv.ndia<<", nadi = "<<dv.nadi
+        <<", ndof = "<<dv.ndof<<", ntraj = "<<dv.ntraj<<"\nExiting...\n"; exit(0);
+  }
+  dv.timestep = rd.get_int();
+
+  int has_random = 0, has_therm = 0, has_ham = 0;
+  int tag = rd.get_int();
+
+  while(tag!=chk_end){
+    int64_t nbytes;
+    rd.get_bytes(&nbytes, sizeof(int64_t));
+    size_t end = rd.pos + nbytes;
+
+    if(tag==chk_electronic){
+      dv.allocate_electronic_vars();
+      rd.get_cmatrix(*dv.ampl_dia, "ampl_dia");
+      rd.get_cmatrix(*dv.ampl_adi, "ampl_adi");
+      for(itraj=0; itraj<dv.ntraj; itraj++){
+        rd.get_cmatrix(*dv.proj_adi[itraj], "proj_adi");
+        rd.get_cmatrix(*dv.dm_dia[itraj], "dm_dia");
+        rd.get_cmatrix(*dv.dm_adi[itraj], "dm_adi");
+        rd.get_cmatrix(*dv.basis_transform[itraj], "basis_transform");
+      }
+      rd.get_ints(dv.act_states);
+      rd.get_ints(dv.act_states_dia);
+    }
+    else if(tag==chk_nuclear){
+      dv.allocate_nuclear_vars();
+      rd.get_matrix(*dv.iM, "iM");  rd.get_matrix(*dv.q, "q");  rd.get_matrix(*dv.p, "p");  rd.get_matrix(*dv.f, "f");
+    }
+    else if(tag==chk_afssh){
+      dv.allocate_afssh();
+      for(itraj=0; itraj<dv.ntraj; itraj++){
+        for(idof=0; idof<dv.ndof; idof++){  rd.get_cmatrix(*dv.dR[itraj][idof], "dR");  rd.get_cmatrix(*dv.dP[itraj][idof], "dP");  }
+      }
+    }
+    else if(tag==chk_bcsh){
+      dv.allocate_bcsh();
+      rd.get_matrix(*dv.reversal_events, "reversal_events");
+    }
+    else if(tag==chk_dish){
+      dv.allocate_dish();
+      rd.get_matrix(*dv.coherence_time, "coherence_time");
+    }
+    else if(tag==chk_fssh2){
+      dv.allocate_fssh2();
+      for(itraj=0; itraj<dv.ntraj; itraj++){
+        rd.get_cmatrix(*dv.dm_dia_prev[itraj], "dm_dia_prev");  rd.get_cmatrix(*dv.dm_adi_prev[itraj], "dm_adi_prev");
+        rd.get_doubles(dv.fssh3_errors[itraj]);
+      }
+    }
+    else if(tag==chk_shxf){
+      dv.allocate_shxf();  get_xf(rd, dv, 0);
+    }
+    else if(tag==chk_mqcxf){
+      dv.allocate_mqcxf();  get_xf(rd, dv, 1);
+    }
+    else if(tag==chk_tcnbra){
+      dv.allocate_tcnbra();
+      rd.get_doubles(dv.thermal_correction_factors);
+      rd.get_doubles(dv.tcnbra_ekin);
+      get_thermostats(rd, dv.tcnbra_thermostats, "TC-NBRA thermostats");
+    }
+    else if(tag==chk_qtsh){
+      dv.allocate_qtsh();
+      rd.get_matrix(*dv.qtsh_f_nc, "qtsh_f_nc");
+    }
+    else if(tag==chk_time){
+      dv.dt_adapt = rd.get_double();
+      dv.elapsed_time = rd.get_double();
+      rd.get_ints(dv.num_el_substeps);
+    }
+    else if(tag==chk_random && rnd!=nullptr){
+      rnd->set_state(rd.get_string());  has_random = 1;
+    }
+    else if(tag==chk_thermostats && therm!=nullptr){
+      get_thermostats(rd, *therm, "thermostats");  has_therm = 1;
+    }
+    else if(tag==chk_hamiltonian && ham!=nullptr){
+      get_hamiltonian(rd, ham);  has_ham = 1;
+    }
+
+    // Skip the sections which are not needed or not known
+    if(rd.pos > end){
+      cout<<"Error in load_checkpoint: the section "<<tag<<" of "<<filename<<" is corrupted\nExiting...\n"; exit(0);
+    }
+    rd.pos = end;
+
+    tag = rd.get_int();
+  }
+
+  if(rnd!=nullptr && !has_random){
+    cout<<"WARNING in load_checkpoint: "<<filename<<" has no state of the random number stream\n";
+  }
+  if(therm!=nullptr && !has_therm){
+    cout<<"WARNING in load_checkpoint: "<<filename<<" has no thermostats\n";
+  }
+  if(ham!=nullptr && !has_ham){
+    cout<<"WARNING in load_checkpoint: "<<filename<<" has no Hamiltonian data\n";
+  }
+
+}
+
+
+
+void dyn_variables::save_checkpoint(std::string filename){
+/**
+  Writes all the allocated dynamical variables into the binary checkpoint file
+
+  \param[in] filename The name of the file
+*/
+
+  write_checkpoint(*this, filename, nullptr, nullptr, nullptr);
+
+}
+
+
+void dyn_variables::save_checkpoint(std::string filename, nHamiltonian& ham, Random& rnd, vector<Thermostat>& therm){
+/**
+  Writes all the allocated dynamical variables, the state of the random number stream, the thermostats,
+  and the allocated matrices of the Hamiltonian (including all its children) into the binary checkpoint
+  file. This is everything compute_dynamics carries from one step to the next, so the dynamics restarted
+  with load_checkpoint reproduces the uninterrupted one exactly.
+
+  The state of the random number stream can only be saved if rnd is seeded (see Random::set_seed)
+
+  \param[in] filename The name of the file
+  \param[in] ham The Hamiltonian used in the dynamics (the one that is not the `ham_aux` in compute_dynamics)
+  \param[in] rnd The random number generator used in the dynamics
+  \param[in] therm The thermostats used in the dynamics
+*/
+
+  write_checkpoint(*this, filename, &ham, &rnd, &therm);
+
+}
+
+
+void dyn_variables::load_checkpoint(std::string filename){
+/**
+  Reads the dynamical variables from the binary checkpoint file. The variable groups present in the
+  file are allocated, if needed. The dimensions of this object must be the same as those of the saved one.
+
+  \param[in] filename The name of the file
+*/
+
+  read_checkpoint(*this, filename, nullptr, nullptr, nullptr);
+
+}
+
+
+void dyn_variables::load_checkpoint(std::string filename, nHamiltonian& ham, Random& rnd, vector<Thermostat>& therm){
+/**
+  Reads the dynamical variables, the state of the random number stream, the thermostats and the Hamiltonian
+  matrices from the binary checkpoint file, see save_checkpoint. The Hamiltonian must be set up the same
+  way as the saved one (the same hierarchy and the same allocated matrices), e.g. by the same setup code.
+
+  \param[in] filename The name of the file
+  \param[in,out] ham The Hamiltonian
+  \param[in,out] rnd The random number generator
+  \param[in,out] therm The thermostats
+*/
+
+  read_checkpoint(*this, filename, &ham, &rnd, &therm);
+
+}
+
+
+
+} // libdyn
+}// liblibra
+
@@ -1254,6 +1254,55 @@ vector<double> dyn_variables::compute_average_se_pop(int rep){
 }
 
 
+void dyn_variables::get_traj_frame(libio::traj_frame& fr, int rep){
+/**
+  Fill the binary trajectory frame with the current state of all trajectories:
+
+  pos[itraj*ndof + idof] = q(idof, itraj)
+  vel[itraj*ndof + idof] = p(idof, itraj) - note, these are the momenta
+  frc[itraj*ndof + idof] = f(idof, itraj)
+  pops[itraj*nst + i] = Re(dm(i,i)) of the trajectory itraj, in the representation `rep`
+                        (0, 2 - diabatic, 1, 3 - adiabatic)
+  states[itraj] - the active adiabatic states
+
+  The step and time of the frame are not changed
+*/
+
+  int itraj, idof, i;
+
+  fr.box.clear();
+  fr.pos.resize(ndof*ntraj);
+  fr.vel.resize(ndof*ntraj);
+  fr.frc.resize(ndof*ntraj);
+
+  for(itraj=0; itraj<ntraj; itraj++){
+    for(idof=0; idof<ndof; idof++){
+      fr.pos[itraj*ndof + idof] = q->get(idof, itraj);
+      fr.vel[itraj*ndof + idof] = p->get(idof, itraj);
+      fr.frc[itraj*ndof + idof] = f->get(idof, itraj);
+    }
+  }
+
+  fr.pops.clear();
+  fr.states.clear();
+  fr.nst = 0;
+
+  if(electronic_vars_status==1){
+    int sz = (rep==0 || rep==2) ? ndia : nadi;
+
+    fr.nst = sz;
+    fr.pops.resize(sz*ntraj);
+    fr.states = act_states;
+
+    for(itraj=0; itraj<ntraj; itraj++){
+      CMATRIX* dm = (rep==0 || rep==2) ? dm_dia[itraj] : dm_adi[itraj];
+      for(i=0; i<sz; i++){  fr.pops[itraj*sz + i] = dm->get(i,i).real();  }
+    }
+  }
+
+}
+
+
 vector<double> dyn_variables::compute_average_mash_pop(int rep){
 /**
   Computing the MASH population estimators based on:
@@ -142,6 +142,17 @@ void export_dyn_control_params_objects(){
       .def_readwrite("electronic_integrator", &dyn_control_params::electronic_integrator)
       .def_readwrite("ampl_transformation_method", &dyn_control_params::ampl_transformation_method)
       .def_readwrite("assume_always_consistent", &dyn_control_params::assume_always_consistent)
+      .def_readwrite("checkpoint_frequency", &dyn_control_params::checkpoint_frequency)
+      .def_readwrite("checkpoint_filename", &dyn_control_params::checkpoint_filename)
+      .def_readwrite("adaptive_dt", &dyn_control_params::adaptive_dt)
+      .def_readwrite("adaptive_dt_energy_tol", &dyn_control_params::adaptive_dt_energy_tol)
+      .def_readwrite("adaptive_dt_force_tol", &dyn_control_params::adaptive_dt_force_tol)
+      .def_readwrite("adaptive_dt_min", &dyn_control_params::adaptive_dt_min)
+      .def_readwrite("adaptive_dt_max", &dyn_control_params::adaptive_dt_max)
+      .def_readwrite("adaptive_dt_max_factor", &dyn_control_params::adaptive_dt_max_factor)
+      .def_readwrite("adaptive_electronic_substeps", &dyn_control_params::adaptive_electronic_substeps)
+      .def_readwrite("electronic_substep_tol", &dyn_control_params::electronic_substep_tol)
+      .def_readwrite("max_electronic_substeps", &dyn_control_params::max_electronic_substeps)
       .def_readwrite("thermally_corrected_nbra", &dyn_control_params::thermally_corrected_nbra)
       .def_readwrite("total_energy", &dyn_control_params::total_energy)
       .def_readwrite("tcnbra_nu_therm", &dyn_control_params::tcnbra_nu_therm)
@@ -219,6 +230,13 @@ void export_dyn_variables_objects(){
   
   void (dyn_variables::*expt_set_active_states_diff_rep_v1)(int rep_sh, Random& rnd) = &dyn_variables::set_active_states_diff_rep;
 
+  void (dyn_variables::*expt_save_checkpoint_v1)(std::string filename) = &dyn_variables::save_checkpoint;
+  void (dyn_variables::*expt_save_checkpoint_v2)(std::string filename, nHamiltonian& ham, Random& rnd, 
+  vector<Thermostat>& therm) = &dyn_variables::save_checkpoint;
+  void (dyn_variables::*expt_load_checkpoint_v1)(std::string filename) = &dyn_variables::load_checkpoint;
+  void (dyn_variables::*expt_load_checkpoint_v2)(std::string filename, nHamiltonian& ham, Random& rnd, 
+  vector<Thermostat>& therm) = &dyn_variables::load_checkpoint;
+
 
   class_<dyn_variables>("dyn_variables",init<int, int, int, int>())
       .def("__copy__", &generic__copy__<dyn_variables>)
@@ -244,6 +262,10 @@ void export_dyn_variables_objects(){
       .def_readwrite("tcnbra_thermostats", &dyn_variables::tcnbra_thermostats)
       .def_readwrite("tcnbra_ekin", &dyn_variables::tcnbra_ekin)
       .def_readwrite("qtsh_vars_status", &dyn_variables::qtsh_vars_status)
+      .def_readwrite("timestep", &dyn_variables::timestep)
+      .def_readwrite("dt_adapt", &dyn_variables::dt_adapt)
+      .def_readwrite("elapsed_time", &dyn_variables::elapsed_time)
+      .def_readwrite("num_el_substeps", &dyn_variables::num_el_substeps)
 
       .def("set_parameters", expt_set_parameters_v1)
 
@@ -322,6 +344,12 @@ void export_dyn_variables_objects(){
       .def("compute_average_sh_pop", &dyn_variables::compute_average_sh_pop)
       .def("compute_average_mash_pop", &dyn_variables::compute_average_mash_pop)
       .def("compute_average_sh_pop_TR", &dyn_variables::compute_average_sh_pop_TR)
+      .def("get_traj_frame", &dyn_variables::get_traj_frame)
+
+      .def("save_checkpoint", expt_save_checkpoint_v1)
+      .def("save_checkpoint", expt_save_checkpoint_v2)
+      .def("load_checkpoint", expt_load_checkpoint_v1)
+      .def("load_checkpoint", expt_load_checkpoint_v2)
 
       .def("compute_tcnbra_ekin", &dyn_variables::compute_tcnbra_ekin)
       .def("compute_tcnbra_thermostat_energy", &dyn_variables::compute_tcnbra_thermostat_energy)
@@ -1083,6 +1111,17 @@ void export_Dyn_objects(){
   def("compute_dynamics", expt_compute_dynamics_v4);
 
 
+  //============= dyn_adaptive_step.cpp ======================
+
+  vector<int> (*expt_electronic_substeps_v1)
+  (dyn_variables& dyn_var, nHamiltonian& Ham, nHamiltonian& Ham_prev, dyn_control_params& prms) = &electronic_substeps;
+  def("electronic_substeps", expt_electronic_substeps_v1);
+
+  double (*expt_adaptive_time_step_v1)
+  (dyn_control_params& prms, double dt, vector<double>& dE, vector<double>& dF, int is_event) = &adaptive_time_step;
+  def("adaptive_time_step", expt_adaptive_time_step_v1);
+
+
 
 
 
@@ -27,6 +27,28 @@ namespace libdyn{
 namespace libthermostat{
 
 
+/// Distinguishes the default (unseeded) random number streams of the thermostats created in one run
+static unsigned int thermostat_stream_counter = 0;
+
+
+void Thermostat::set_seed(int seed, int stream){
+/**
+  \brief Restart the random number stream of the thermostat
+  \param[in] seed The seed, common to all the trajectories of a run
+  \param[in] stream The index of the stream, e.g. the index of the trajectory
+
+  The state of the generator is derived from both numbers with std::seed_seq, so the thermostats
+  of different trajectories, seeded with the same seed, produce independent noise, and the run
+  is reproducible for the given seed
+*/
+
+  rng_seed = seed;  is_rng_seed = 1;
+  rng_stream = stream;
+  std::seed_seq seq{ (unsigned int)seed, (unsigned int)stream };
+  rng.seed(seq);
+}
+
+
 void Thermostat::set(object at){
 /** 
   \briefSet properties of the Thermostat object from an arbitrary Python object.
@@ -45,6 +67,9 @@ void Thermostat::set(object at){
  set_value(is_NHC_size,NHC_size, at,"NHC_size");
  set_value(is_Temperature,    Temperature,    at,"Temperature");
  set_value(is_thermostat_type, thermostat_type, at, "thermostat_type");
+ set_value(is_rng_seed, rng_seed, at, "rng_seed");
+ if(is_rng_seed){ set_seed(rng_seed, rng_stream); }
+ resolve_thermostat_kind();
 }
 
 void Thermostat::show_info(){
@@ -63,6 +88,7 @@ void Thermostat::show_info(){
   if(is_NHC_size) {std::cout<<"NHC_size = "<<NHC_size<<" unitless"<<std::endl; }
   if(is_Temperature)   {std::cout<<"Temperature = "<<Temperature<<" K"<<std::endl;   }
   if(is_thermostat_type){ std::cout<<"thermostat_type = "<<thermostat_type<<std::endl; }
+  if(is_rng_seed){ std::cout<<"rng_seed = "<<rng_seed<<std::endl; }
   std::cout<<std::endl;
 }
 
@@ -84,8 +110,10 @@ void Thermostat::extract_dictionary(boost::python::dict d){
     else if(key=="NHC_size") { NHC_size = extract<int>(d.values()[i]);  is_NHC_size = 1; }
     else if(key=="Temperature") { Temperature = extract<double>(d.values()[i]);  is_Temperature = 1; }
     else if(key=="thermostat_type") { thermostat_type = extract<std::string>(d.values()[i]);  is_thermostat_type = 1; }
+    else if(key=="rng_seed") { set_seed( extract<int>(d.values()[i]) ); }
 
   }
+  resolve_thermostat_kind();
 }
 
 void Thermostat::init_variables(){
@@ -103,6 +131,17 @@ void Thermostat::init_variables(){
   NHC_size = 1;                 is_NHC_size = 1;
   Temperature = 300.0;          is_Temperature = 1;
   thermostat_type = "Nose-Poincare";     is_thermostat_type = 1;
+  rng_seed = 0;                 is_rng_seed = 0;
+  thermostat_kind = 0;
+  heat = 0.0;
+
+  // The unseeded thermostats use the seed 0 and the consecutive stream numbers: the streams are
+  // different, and the same for every run of the same script. Use set_seed(seed, itraj) to
+  // make the streams independent of the order in which the objects are created
+  rng_stream = thermostat_stream_counter++;
+  std::seed_seq seq{ 0u, (unsigned int)rng_stream };
+  rng.seed(seq);
+  n_splits = 0;
 
   s_t_size = 0;
   s_r_size = 0;
@@ -125,6 +164,11 @@ void Thermostat::copy_content(const Thermostat& th){
 
   Only the properties that are set in the source object are copied into the target project
 
+  The random number stream is not duplicated: the copy continues with a new stream derived from
+  the state of the source and the number of the copies made of it, so vector<Thermostat>(ntraj, th)
+  gives every trajectory its own noise, and the same one in every run. Use get_rng_state/set_rng_state
+  to reproduce the stream itself
+
   \param[in] th The input Thermostat object
 */
 
@@ -138,6 +182,14 @@ void Thermostat::copy_content(const Thermostat& th){
   if(th.is_NHC_size) { NHC_size = th.NHC_size;  is_NHC_size = 1; }
   if(th.is_Temperature) { Temperature = th.Temperature;  is_Temperature = 1;}
   if(th.is_thermostat_type){ thermostat_type = th.thermostat_type; is_thermostat_type = 1;}
+  if(th.is_rng_seed){ rng_seed = th.rng_seed; is_rng_seed = 1; }
+  rng_stream = th.rng_stream;
+  thermostat_kind = th.thermostat_kind;
+  heat = th.heat;
+
+  std::mt19937 src(th.rng);
+  std::seed_seq seq{ (unsigned int)src(), (unsigned int)src(), (unsigned int)src(), (unsigned int)src(), th.n_splits++ };
+  rng.seed(seq);
 
   if(th.s_t_size>0)   {  s_t = th.s_t;  s_t_size = th.s_t_size; }
   if(th.s_r_size>0)   {  s_r = th.s_r;  s_r_size = th.s_r_size; }
@@ -267,6 +319,7 @@ void Thermostat::save(boost::property_tree::ptree& pt,std::string path){
   if(is_nu_therm){  libio::save(pt,path+".nu_therm",nu_therm);    }
   if(is_Temperature){  libio::save(pt,path+".Temperature",Temperature);    }
   if(is_thermostat_type){  libio::save(pt,path+".thermostat_type",thermostat_type);    }
+  if(is_rng_seed){  libio::save(pt,path+".rng_seed",rng_seed);  libio::save(pt,path+".rng_stream",rng_stream);   }
 
 }
 
@@ -328,6 +381,10 @@ void Thermostat::load(boost::property_tree::ptree& pt,std::string path,int& stat
   libio::load(pt,path+".nu_therm",nu_therm,is_nu_therm); if(is_nu_therm==1) { status=1;}
   libio::load(pt,path+".Temperature",Temperature,is_Temperature); if(is_Temperature==1) { status=1;}
   libio::load(pt,path+".thermostat_type",thermostat_type,is_thermostat_type); if(is_thermostat_type==1) { status=1;}
+  int is_rng_stream = 0;
+  libio::load(pt,path+".rng_stream",rng_stream,is_rng_stream);
+  libio::load(pt,path+".rng_seed",rng_seed,is_rng_seed); if(is_rng_seed==1) { status=1; set_seed(rng_seed, rng_stream); }
+  resolve_thermostat_kind();
 
 }
 
@@ -17,6 +17,8 @@
 #ifndef THERMOSTAT_H
 #define THERMOSTAT_H
 
+#include <random>
+
 #include "../../math_linalg/liblinalg.h"
 #include "../../math_random/librandom.h"
 #include "../../math_specialfunctions/libspecialfunctions.h"
@@ -51,6 +53,9 @@ class Thermostat{
   void copy_content(const Thermostat&); ///< Copies the content which is defined
   void extract_dictionary(boost::python::dict);
 
+  std::mt19937 rng;             ///< The own random number stream of this thermostat (one per trajectory)
+  mutable unsigned int n_splits;  ///< The number of the copies made of this thermostat, each copy gets its own stream
+
 
 public:  
 
@@ -95,7 +100,15 @@ public:
   double NHC_size;              int is_NHC_size;        ///< Length (size) of the Nose-Hoover thermostat chain
   double nu_therm;              int is_nu_therm;        ///< Thermostat frequency parameter (time-scale)
   double Temperature;           int is_Temperature;     ///< Target temperature of the thermostat
-  std::string thermostat_type;  int is_thermostat_type; ///< Type of the thermostat in use: Nose-Poincare, Nose-Hoover, etc.
+  std::string thermostat_type;  int is_thermostat_type; ///< Type of the thermostat in use: Nose-Poincare, Nose-Hoover, Langevin, CSVR, Andersen
+  int rng_seed;                 int is_rng_seed;        ///< The seed of the random number stream of the stochastic thermostats
+  int rng_stream;               ///< The index of the stream derived from rng_seed, e.g. the index of the trajectory
+
+  // Internal variables of the stochastic thermostats (Langevin, CSVR, Andersen)
+  int thermostat_kind;          ///< The type of the thermostat resolved from thermostat_type (in init_nhc()):
+                                ///< 0 - Nose-Poincare, 1 - Nose-Hoover, 2 - Langevin (BAOAB), 3 - CSVR (Bussi),
+                                ///< 4 - Andersen (massive), -1 - unknown (no action)
+  double heat;                  ///< The energy transferred from the system to the bath by the stochastic thermostat
 
 
 
@@ -103,7 +116,9 @@ public:
   // Defined in Thermostat.cpp
   Thermostat();                   ///< constructor
   Thermostat(boost::python::dict);
-  Thermostat(const Thermostat&);  ///< copy-constructor
+  Thermostat(const Thermostat&);  ///< copy-constructor: the copy gets its own random number stream
+  Thermostat(Thermostat&&) noexcept = default;             ///< move-constructor: keeps the stream, e.g. when a vector grows
+  Thermostat& operator=(Thermostat&&) noexcept = default;  ///< move assignment: keeps the stream
  ~Thermostat();                   ///< destructor
 
   Thermostat& operator=(const Thermostat&); ///< assignment operator
@@ -125,6 +140,12 @@ public:
   double get_Nf_r() const { if(is_Nf_r){ return Nf_r; } else{ std::cout<<"Error: Nf_r is not defined\n"; exit(1); } } ///< Return the number of rotational DOF coupled to thermostat  
   double get_Nf_b() const { if(is_Nf_b){ return Nf_b; } else{ std::cout<<"Error: Nf_b is not defined\n"; exit(1); } } ///< Return the number of barostat DOF coupled to thermostat    
 
+  void set_seed(int seed, int stream);                 ///< Restart the random number stream with given seed, as the stream number stream
+  void set_seed(int seed){ set_seed(seed, rng_stream); }                        ///< Restart the random number stream with given seed
+  int get_seed() const { return rng_seed; }                                     ///< The seed of the last restart of the random number stream
+  std::string get_rng_state() const;                   ///< The state of the random number stream, e.g. for checkpoints
+  void set_rng_state(const std::string& state);        ///< Restore the state of the random number stream
+
   double get_s_var() const { return s_var; }  ///< Return the time-scaling variable (in Nose and Nose-Poincare thermostats)
 
   /// Return the thermostat variable coupled to translational DOF
@@ -149,6 +170,18 @@ public:
   void propagate_nhc(double,double, double, double);
   void cool();
 
+  // Defined in Thermostat_methods1.cpp
+  void resolve_thermostat_kind();
+  void set_thermostat_type(std::string _thermostat_type);
+  std::string get_thermostat_type() const { return thermostat_type; }
+  int is_stochastic() const { return (thermostat_kind>=2); }  ///< 1 for Langevin, CSVR and Andersen thermostats
+  double gaussian();
+  double langevin_momentum(double p, double iM, double dt);
+  int andersen_collision(double dt);
+  double andersen_momentum(double p, double iM);
+  double csvr_scale(double ekin, double nf, double dt);
+  void propagate_stochastic(MATRIX& p, MATRIX& invM, vector<int>& dofs, int traj, double dt);
+
   friend bool operator == (const Thermostat& t1, const Thermostat& t2){
     return &t1 == &t2;
   }
@@ -31,12 +31,14 @@ double Thermostat::energy(){
 /** 
   \brief Return the energy of Thermostat
 
-  So far only Nose-Hoover (including chain) and Nose-Poincare thermostats are possible
+  For Nose-Hoover (including chain) and Nose-Poincare thermostats this is the energy of the extended system variables.
+  For the stochastic thermostats (Langevin, CSVR, Andersen) this is the energy transferred to the bath, so that
+  the sum of the system's total energy and this quantity is conserved (the effective energy)
 */
 
   double comp = 0.0;
   int i;
-  if(thermostat_type=="Nose-Hoover"){
+  if(thermostat_kind==1){
 
   double kT = (boltzmann/hartree)*Temperature;
   if(Nf_t>0){
@@ -62,10 +64,12 @@ double Thermostat::energy(){
 
   }// if Nose-Hoover
 
-  else if(thermostat_type=="Nose-Poincare"){
+  else if(thermostat_kind==0){
     comp = (0.5*Ps*Ps/Q)+ (Nf_t + Nf_r)*(boltzmann/hartree)*Temperature*log(s_var); 
   }
 
+  else if(is_stochastic()){  comp = heat;  }
+
   return comp;
 }
 
@@ -84,7 +88,7 @@ void Thermostat::propagate_sPs(double t){
   2001, JPSJ, 70, 75-77
 
 */
-  if(thermostat_type=="Nose-Poincare"){
+  if(thermostat_kind==0){
     double tmp = (1.0+(0.5*t*Ps/Q));
     s_var *= (tmp*tmp);
     Ps = Ps/tmp;
@@ -97,7 +101,7 @@ void Thermostat::propagate_Ps(double amnt){
   \param[in] amnt Amount of shift: Ps -> Ps + amnt
 */
 
-  if(thermostat_type=="Nose-Poincare"){
+  if(thermostat_kind==0){
     Ps += amnt;
   }
 }
@@ -110,7 +114,7 @@ double Thermostat::vel_scale(double dt){
   Used to constructe NVT-MD algorithm. Only for Nose-Hoover thermostat
 */
   double res = 1.0;
-  if(thermostat_type=="Nose-Hoover"){  res = exp(-dt*ksi_t[0]);  }
+  if(thermostat_kind==1){  res = exp(-dt*ksi_t[0]);  }
   return res;
 }
 
@@ -123,7 +127,7 @@ double Thermostat::ang_vel_scale(double dt){
 */
 
   double res = 1.0;
-  if(thermostat_type=="Nose-Hoover"){  res = exp(-dt*ksi_r[0]);  }
+  if(thermostat_kind==1){  res = exp(-dt*ksi_r[0]);  }
   return res;
 }
 
@@ -141,7 +145,7 @@ void Thermostat::update_thermostat_forces(double ekin_tr, double ekin_rot,double
   integrators for molecular dynamics simulations of rigid molecules" J. Chem. Phys. 2005, 122, 224114-1 - 224114-30
   Note: The indexing for barostat chains is slightly different than in the original article
 */
-  if(thermostat_type=="Nose-Hoover"){
+  if(thermostat_kind==1){
   double kT = (boltzmann/hartree) * Temperature;
 
   for(int i=0;i<NHC_size;i++){
@@ -176,7 +180,7 @@ void Thermostat::update_thermostat_forces(double ekin_tr, double ekin_rot,double
 
 */
 
-  if(thermostat_type=="Nose-Hoover"){
+  if(thermostat_kind==1){
   double kT = (boltzmann/hartree) * Temperature;
     if(i==0){
       if(Nf_t>0){G_t[i] = (2.0*ekin_tr  - Nf_t * kT)/Q_t[i];}//else{ G_t[0] = 0.0; }
@@ -199,13 +203,18 @@ void Thermostat::init_nhc(){
 
   This function initializes variables, masses, and computes thermostat forces
   Note: For distinguishing between different barostats we use the number of degrees of freedom corresponding to barostat.
+
+  This function also resolves the type of the thermostat from the thermostat_type string, so it should be called
+  (as the setup step) for all types of thermostats, after the thermostat_type is changed
   
 */
 
   int i;
   double Qt,Qr,Qb;
 
-  if(thermostat_type=="Nose-Hoover"){
+  resolve_thermostat_kind();
+
+  if(thermostat_kind==1){
   double kTt = ((boltzmann/hartree) * Temperature / (nu_therm * nu_therm));
 
   // Clear all variables
@@ -295,7 +304,7 @@ void Thermostat::propagate_nhc(double dt,double ekin_tr, double ekin_rot,double
   double argt,argr,argb;
   double et,er,eb;
 
-  if(thermostat_type=="Nose-Hoover"){
+  if(thermostat_kind==1){
   int M = NHC_size - 1;
   int k;
 
@@ -356,15 +365,19 @@ void Thermostat::cool(){
   \brief Cool down the thermostat
 
   This is done by setting Ps = 0 and s_var = 1 for Nose-Poincare thermostat,
-  and by re-initializing NHC variables for the Nose-Hoover chain thermostats
+  by re-initializing NHC variables for the Nose-Hoover chain thermostats, and by
+  resetting the accumulated heat for the stochastic thermostats
 */
 
-  if(thermostat_type=="Nose-Poincare"){
+  if(thermostat_kind==0){
     Ps = 0.0;     is_Ps = 1;
     s_var = 1.0;  is_s_var = 1;   
   }
-  else if(thermostat_type=="Nose-Hoover"){
+  else if(thermostat_kind==1){
     init_nhc();
+  }
+  else if(is_stochastic()){
+    heat = 0.0;
   }
 
 }
@@ -0,0 +1,251 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 2 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Thermostat_methods1.cpp
+  \brief The file implements the stochastic thermostats: Langevin (BAOAB), CSVR (Bussi), and massive Andersen
+
+*/
+
+#include "Thermostat.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+
+/// libdyn namespace
+namespace libdyn{
+
+/// libthermostat namespace
+namespace libthermostat{
+
+
+void Thermostat::resolve_thermostat_kind(){
+/**
+  \brief Convert the thermostat_type string into the integer thermostat_kind
+
+  This is done once, at the setup, so the propagation methods do not need to compare the strings
+
+  0 - "Nose-Poincare"
+  1 - "Nose-Hoover"
+  2 - "Langevin" - Langevin dynamics with the BAOAB splitting, the friction is nu_therm
+  3 - "CSVR" (or "Bussi") - canonical sampling through velocity rescaling, the relaxation time is 1/nu_therm
+  4 - "Andersen" - massive Andersen thermostat, the collision frequency is nu_therm
+ -1 - any other type, no thermostat action
+*/
+
+  if(thermostat_type=="Nose-Poincare"){ thermostat_kind = 0; }
+  else if(thermostat_type=="Nose-Hoover"){ thermostat_kind = 1; }
+  else if(thermostat_type=="Langevin"){ thermostat_kind = 2; }
+  else if(thermostat_type=="CSVR" || thermostat_type=="Bussi"){ thermostat_kind = 3; }
+  else if(thermostat_type=="Andersen"){ thermostat_kind = 4; }
+  else{ thermostat_kind = -1; }
+
+}
+
+
+void Thermostat::set_thermostat_type(std::string _thermostat_type){
+/**
+  \brief Set the type of the thermostat and resolve the thermostat_kind right away
+
+  This is what the "thermostat_type" attribute does in Python, so the kind used by the integrators
+  is never out of sync with the type
+*/
+
+  thermostat_type = _thermostat_type;  is_thermostat_type = 1;
+  resolve_thermostat_kind();
+
+}
+
+
+std::string Thermostat::get_rng_state() const{
+/**
+  \brief Returns the state of the own random number stream of the thermostat as a string
+*/
+
+  stringstream ss;
+  ss<<rng;
+  return ss.str();
+}
+
+
+void Thermostat::set_rng_state(const std::string& state){
+/**
+  \brief Restores the state of the own random number stream of the thermostat, as returned by get_rng_state
+*/
+
+  stringstream ss(state);
+  ss>>rng;
+
+  if(ss.fail()){
+    cout<<"Error in Thermostat::set_rng_state: the state string is not valid\nExiting...\n"; exit(0);
+  }
+}
+
+
+double Thermostat::gaussian(){
+/**
+  \brief Return a normally-distributed random number (zero mean, unit variance) from the own stream of this thermostat
+*/
+
+  std::normal_distribution<double> distr(0.0, 1.0);
+  return distr(rng);
+}
+
+
+double Thermostat::langevin_momentum(double p, double iM, double dt){
+/**
+  \brief The O step of the BAOAB Langevin integrator for one degree of freedom
+  \param[in] p The momentum before the step
+  \param[in] iM The inverse mass of the DOF. The DOFs with iM <= 0 (e.g. degenerate rotations) are not affected
+  \param[in] dt The time step of the O operator (the full MD time step in BAOAB)
+
+  Returns the momentum after the exact Ornstein-Uhlenbeck step:  p' = c1 * p + sqrt( (1 - c1^2) * m * kT ) * ksi,  c1 = exp(-gamma*dt)
+  with the friction gamma = nu_therm
+
+  Leimkuhler, B.; Matthews, C. "Rational Construction of Stochastic Numerical Methods for Molecular Sampling"
+  Appl. Math. Res. Express 2013, 34-56
+*/
+
+  if(iM<=0.0){ return p; }
+
+  double kT = (boltzmann/hartree) * Temperature;
+  double c1 = exp(-nu_therm*dt);
+  double p_new = c1*p + sqrt((1.0 - c1*c1)*kT/iM) * gaussian();
+
+  heat += 0.5*iM*(p*p - p_new*p_new);
+
+  return p_new;
+}
+
+
+int Thermostat::andersen_collision(double dt){
+/**
+  \brief Decide whether the massive Andersen thermostat re-samples the momenta during the time interval dt
+  \param[in] dt The time interval
+
+  Returns 1 with the probability 1 - exp(-nu_therm*dt), 0 otherwise
+*/
+
+  std::uniform_real_distribution<double> distr(0.0, 1.0);
+  return (distr(rng) < 1.0 - exp(-nu_therm*dt));
+}
+
+
+double Thermostat::andersen_momentum(double p, double iM){
+/**
+  \brief Re-sample the momentum of one degree of freedom from the Maxwell-Boltzmann distribution
+  \param[in] p The momentum before the collision (only needed to track the heat)
+  \param[in] iM The inverse mass of the DOF. The DOFs with iM <= 0 are not affected
+*/
+
+  if(iM<=0.0){ return p; }
+
+  double kT = (boltzmann/hartree) * Temperature;
+  double p_new = sqrt(kT/iM) * gaussian();
+
+  heat += 0.5*iM*(p*p - p_new*p_new);
+
+  return p_new;
+}
+
+
+double Thermostat::csvr_scale(double ekin, double nf, double dt){
+/**
+  \brief Return the momentum scaling factor of the canonical sampling through velocity rescaling (CSVR) thermostat
+  \param[in] ekin The current kinetic energy of the thermostatted DOFs
+  \param[in] nf The number of the thermostatted DOFs
+  \param[in] dt The time step of the thermostat operator
+
+  The kinetic energy is propagated exactly according to the stochastic equation with the relaxation time tau = 1/nu_therm,
+  the new kinetic energy is alpha^2 * ekin, where alpha is the returned value
+
+  Bussi, G.; Donadio, D.; Parrinello, M. "Canonical sampling through velocity rescaling" J. Chem. Phys. 2007, 126, 014101
+*/
+
+  if(ekin<=0.0 || nf<1.0){ return 1.0; }
+
+  double kT = (boltzmann/hartree) * Temperature;
+  double ekin_target = 0.5*nf*kT;
+  double c = exp(-nu_therm*dt);
+  double f = (1.0 - c)*ekin_target/(nf*ekin);
+
+  double r1 = gaussian();
+  double sum_r2 = 0.0;   // the sum of squares of nf-1 normally-distributed numbers
+  if(nf>1.0){
+    std::chi_squared_distribution<double> distr(nf - 1.0);
+    sum_r2 = distr(rng);
+  }
+
+  double alpha2 = c + f*(r1*r1 + sum_r2) + 2.0*r1*sqrt(c*f);
+  double alpha = sqrt(alpha2);
+  if(r1 + sqrt(c/f) < 0.0){ alpha = -alpha; }
+
+  heat += ekin*(1.0 - alpha2);
+
+  return alpha;
+}
+
+
+void Thermostat::propagate_stochastic(MATRIX& p, MATRIX& invM, vector<int>& dofs, int traj, double dt){
+/**
+  \brief Apply the stochastic thermostat operator to the momenta of one trajectory
+  \param[in,out] p [ndof x ntraj] The momenta of all trajectories, only the column traj is changed
+  \param[in] invM [ndof x 1] The inverse masses of all DOFs
+  \param[in] dofs The indices of the DOFs coupled to the thermostat
+  \param[in] traj The index of the trajectory
+  \param[in] dt The time step of the operator
+
+  Langevin - the O step (in BAOAB, it is applied once per step, in the middle of the drift)
+  CSVR - the velocity rescaling
+  Andersen - re-sampling of all the thermostatted momenta (with the probability 1 - exp(-nu_therm*dt))
+
+  Nothing is done for the deterministic thermostats
+*/
+
+  int i, dof;
+  double pi, iM;
+
+  if(thermostat_kind==2){
+    for(i=0;i<(int)dofs.size();i++){
+      dof = dofs[i];
+      p.set(dof, traj, langevin_momentum(p.get(dof, traj), invM.get(dof, 0), dt));
+    }
+  }
+
+  else if(thermostat_kind==3){
+    double ekin = 0.0;
+    for(i=0;i<(int)dofs.size();i++){
+      dof = dofs[i]; pi = p.get(dof, traj);  iM = invM.get(dof, 0);
+      ekin += 0.5*iM*pi*pi;
+    }
+
+    double alpha = csvr_scale(ekin, dofs.size(), dt);
+    for(i=0;i<(int)dofs.size();i++){  p.scale(dofs[i], traj, alpha);  }
+  }
+
+  else if(thermostat_kind==4){
+    if(andersen_collision(dt)){
+      for(i=0;i<(int)dofs.size();i++){
+        dof = dofs[i];
+        p.set(dof, traj, andersen_momentum(p.get(dof, traj), invM.get(dof, 0)));
+      }
+    }
+  }
+
+}
+
+
+
+}// namespace libthermostat
+}// namespace libdyn
+
+}// liblibra
+
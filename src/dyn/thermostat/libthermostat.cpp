@@ -45,6 +45,8 @@ void export_Thermostat_objects(){
 
 
   void (Thermostat::*expt_set_Nf_t_v1)(int nf_t) = &Thermostat::set_Nf_t;
+  void (Thermostat::*expt_set_seed_v1)(int seed) = &Thermostat::set_seed;
+  void (Thermostat::*expt_set_seed_v2)(int seed, int stream) = &Thermostat::set_seed;
   void (Thermostat::*expt_set_Nf_t_v2)(double nf_t) = &Thermostat::set_Nf_t;
   void (Thermostat::*expt_set_Nf_r_v1)(int nf_t) = &Thermostat::set_Nf_r;
   void (Thermostat::*expt_set_Nf_r_v2)(double nf_t) = &Thermostat::set_Nf_r;
@@ -67,7 +69,11 @@ void export_Thermostat_objects(){
       .def_readwrite("NHC_size",&Thermostat::NHC_size)
       .def_readwrite("nu_therm",&Thermostat::nu_therm)
       .def_readwrite("Temperature",&Thermostat::Temperature)
-      .def_readwrite("thermostat_type",&Thermostat::thermostat_type)
+      .add_property("thermostat_type",&Thermostat::get_thermostat_type, &Thermostat::set_thermostat_type)
+      .add_property("rng_seed",&Thermostat::get_seed, expt_set_seed_v1)
+      .def_readonly("rng_stream",&Thermostat::rng_stream)
+      .def_readonly("thermostat_kind",&Thermostat::thermostat_kind)
+      .def_readwrite("heat",&Thermostat::heat)
 
       .def_readwrite("s_t", &Thermostat::s_t)
       .def_readwrite("s_r", &Thermostat::s_r)
@@ -112,6 +118,19 @@ void export_Thermostat_objects(){
       .def("propagate_nhc", &Thermostat::propagate_nhc)
       .def("cool", &Thermostat::cool)
 
+      .def("set_seed", expt_set_seed_v1)
+      .def("set_seed", expt_set_seed_v2)
+      .def("get_rng_state", &Thermostat::get_rng_state)
+      .def("set_rng_state", &Thermostat::set_rng_state)
+      .def("resolve_thermostat_kind", &Thermostat::resolve_thermostat_kind)
+      .def("is_stochastic", &Thermostat::is_stochastic)
+      .def("gaussian", &Thermostat::gaussian)
+      .def("langevin_momentum", &Thermostat::langevin_momentum)
+      .def("andersen_collision", &Thermostat::andersen_collision)
+      .def("andersen_momentum", &Thermostat::andersen_momentum)
+      .def("csvr_scale", &Thermostat::csvr_scale)
+      .def("propagate_stochastic", &Thermostat::propagate_stochastic)
+
   ;
 
 
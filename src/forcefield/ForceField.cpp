@@ -147,6 +147,10 @@ void ForceField::init_variables(){
   is_elec_scale13       = 0;
   is_elec_scale14       = 0;
 
+  n_compiled_atoms = n_compiled_bonds = n_compiled_angles = n_compiled_dihedrals = -1;
+  is_tables_dirty = 1;
+  n_indexed_atoms = n_indexed_bonds = n_indexed_angles = n_indexed_dihedrals = n_indexed_impropers = -1;
+
 }
 
 void ForceField::copy_content(const ForceField& ff){
@@ -195,6 +199,12 @@ void ForceField::copy_content(const ForceField& ff){
   Dihedral_Records = ff.Dihedral_Records;
   Improper_Records = ff.Improper_Records;
   Fragment_Records = ff.Fragment_Records;
+
+  type_equivalence = ff.type_equivalence;
+  n_compiled_atoms = n_compiled_bonds = n_compiled_angles = n_compiled_dihedrals = -1; // recompile on demand
+  is_tables_dirty = 1;
+  n_indexed_atoms = n_indexed_bonds = n_indexed_angles = n_indexed_dihedrals = n_indexed_impropers = -1;
+  type_cache.clear();
 }
 
 ForceField::ForceField(){
@@ -392,12 +402,15 @@ int ForceField::Atom_Record_Index(int Atom_ff_int_type){
    This function searches for index of Atom_Records vector in which
    data about atom of force field type "Atom_ff_int_type" are stored
    Returns -1 if such index has not been found
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    int indx = -1;
-   int sz   = Atom_Records.size();
+   const vector<int>& cand = candidates(atom_int_index, bond_table_key(Atom_ff_int_type, -3));
+   int sz   = cand.size();
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
        if(Atom_Records[i].is_Atom_ff_int_type){
           if(Atom_Records[i].Atom_ff_int_type==Atom_ff_int_type){
              indx = i;
@@ -414,21 +427,11 @@ int ForceField::Atom_Record_Index(std::string Atom_ff_type){
    This function searches for index of Atom_Records vector in which
    data about atom of force field type "Atom_ff_type" are stored
    Returns -1 if such index has not been found
-*****************************************************************/
-
-   int indx = -1;
-   int sz   = Atom_Records.size();
 
-   for(int i=0;i<sz;i++){
-       if(Atom_Records[i].is_Atom_ff_type){
-          if(Atom_Records[i].Atom_ff_type==Atom_ff_type){
-             indx = i;
-             break;
-          }
-       }
-   }
+   The search uses the compiled (hashed) tables, see ForceField_methods11.cpp
+*****************************************************************/
 
-   return indx;
+   return lookup_atom_record(Atom_ff_type);
 }
 
 
@@ -483,13 +486,16 @@ int ForceField::Atom_Record_Index_by_Element(int Atom_atomic_number,vector<int>&
    This function searches for index of Atom_Records vector in which
    data about atom of element number "Atom_atomic_number" are stored
    Returns -1 if such index has not been found
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    int indx = -1;
-   int sz   = Atom_Records.size();
+   const vector<int>& cand = candidates(atom_elt_index, bond_table_key(Atom_atomic_number, -3));
+   int sz   = cand.size();
    if(res.size()>0) { res.clear(); }
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
        if(Atom_Records[i].is_Atom_atomic_number){
           if(Atom_Records[i].Atom_atomic_number==Atom_atomic_number){
              indx = i;
@@ -552,7 +558,9 @@ int ForceField::Add_Atom_Record(Atom_Record rec){
 
        for(int i=0;i<at_indxs.size();i++){
            Atom_Records[at_indxs[i]].merge(rec);
+           index_atom_record(at_indxs[i]);  // the merged labels of the record
        }
+       is_tables_dirty = 1;  // the types of the merged records may have changed
        res = 0;
    }
 
@@ -621,12 +629,15 @@ int ForceField::Bond_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_type){
    data about bond formed by 2 atoms of of force field types
    "Atom1_ff_int_type" and "Atom2_ff_int_type" are stored
    Returns -1 if such index has not been found
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    int indx = -1;
-   int sz   = Bond_Records.size();
+   const vector<int>& cand = candidates(bond_int_index, bond_table_key(Atom1_ff_int_type, Atom2_ff_int_type));
+   int sz   = cand.size();
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
        if(Bond_Records[i].is_Atom1_ff_int_type && Bond_Records[i].is_Atom2_ff_int_type){
           if(((Bond_Records[i].Atom1_ff_int_type==Atom1_ff_int_type)&&(Bond_Records[i].Atom2_ff_int_type==Atom2_ff_int_type) )|| 
              ((Bond_Records[i].Atom1_ff_int_type==Atom2_ff_int_type)&&(Bond_Records[i].Atom2_ff_int_type==Atom1_ff_int_type) )
@@ -649,13 +660,16 @@ int ForceField::Bond_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_type,i
    "Atom1_ff_int_type" and "Atom2_ff_int_type" are stored
    Returns -1 if such index has not been found
    order parameter distinguish bonds 1-2 and 2-1
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    int indx = -1;
-   int sz   = Bond_Records.size();
+   const vector<int>& cand = candidates(bond_int_index, bond_table_key(Atom1_ff_int_type, Atom2_ff_int_type));
+   int sz   = cand.size();
 
    int cmpr11,cmpr12,cmpr21,cmpr22,res;
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
        if(Bond_Records[i].is_Atom1_ff_int_type && Bond_Records[i].is_Atom2_ff_int_type){
           cmpr11 = (Bond_Records[i].Atom1_ff_int_type==Atom1_ff_int_type);
           cmpr22 = (Bond_Records[i].Atom2_ff_int_type==Atom2_ff_int_type);
@@ -686,14 +700,17 @@ int ForceField::Bond_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_type,
    of last of bond_records which match the search parameters
    The bond record will be chosen on the basis of additional comparison
    the Bond_type_index properties if they are available
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    if(res.size()>0) { res.clear(); }
    int indx = -1;
-   int sz   = Bond_Records.size();
+   const vector<int>& cand = candidates(bond_int_index, bond_table_key(Atom1_ff_int_type, Atom2_ff_int_type));
+   int sz   = cand.size();
    int cmpr11,cmpr12,cmpr21,cmpr22,cmpr;
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
 
        cmpr11 = cmpr12 = cmpr21 = cmpr22 = 0;
        if(Bond_Records[i].is_Atom1_ff_int_type && Bond_Records[i].is_Atom2_ff_int_type){
@@ -731,14 +748,17 @@ int ForceField::Bond_Record_Index_by_Element(int Atom1_atomic_number, int Atom2_
    of last of bond_records which match the search parameters
    The bond record will be chosen on the basis of additional comparison
    the Bond_type_index properties if they are available
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    if(res.size()>0) { res.clear(); }
    int indx = -1;
-   int sz   = Bond_Records.size();
+   const vector<int>& cand = candidates(bond_elt_index, bond_table_key(Atom1_atomic_number, Atom2_atomic_number));
+   int sz   = cand.size();
    int cmpr11,cmpr12,cmpr21,cmpr22,cmpr;
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
 
        cmpr11 = cmpr12 = cmpr21 = cmpr22 = 0;
        if(Bond_Records[i].is_Atom1_atomic_number && Bond_Records[i].is_Atom2_atomic_number){
@@ -819,23 +839,11 @@ int ForceField::Bond_Record_Index(std::string Atom1_ff_type, std::string Atom2_f
    of last of bond_records which match the search parameters
    The bond record will be chosen on the basis of additional comparison
    the Bond_type_index properties if they are available
+
+   The search uses the compiled (hashed) tables, see ForceField_methods11.cpp
 *****************************************************************/
-  int indx = -1;
-  int sz   = Bond_Records.size();
-  int cmpr11,cmpr12,cmpr21,cmpr22,cmpr;
-
-  for(int i=0;i<sz;i++){
-    cmpr11 = cmpr12 = cmpr21 = cmpr22 = 0;
-    if(Bond_Records[i].is_Atom1_ff_type && Bond_Records[i].is_Atom2_ff_type){
-      cmpr11 = (Bond_Records[i].Atom1_ff_type == Atom1_ff_type);
-      cmpr22 = (Bond_Records[i].Atom2_ff_type == Atom2_ff_type);
-      cmpr12 = (Bond_Records[i].Atom1_ff_type == Atom2_ff_type);
-      cmpr21 = (Bond_Records[i].Atom2_ff_type == Atom1_ff_type);
-    }// if both Atom1_ff_int_type and Atom2_ff_int_type are defined
-    // --------- Conclusions -------
-    if((cmpr11&&cmpr22&&cmpr)||(cmpr12&&cmpr21&&cmpr)){ indx = i;  }
-  }// for i
-  return indx;
+
+  return lookup_bond_record(Atom1_ff_type,Atom2_ff_type);
 }
 
 
@@ -848,14 +856,17 @@ int ForceField::Bond_Record_Index(std::string Atom1_ff_type, std::string Atom2_f
    of last of bond_records which match the search parameters
    The bond record will be chosen on the basis of additional comparison
    the Bond_type_index properties if they are available
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    if(res.size()>0) { res.clear(); }
    int indx = -1;
-   int sz   = Bond_Records.size();
+   const vector<int>& cand = candidates(bond_sym_index, bond_table_key(name_id(Atom1_ff_type,0), name_id(Atom2_ff_type,0)));
+   int sz   = cand.size();
    int cmpr11,cmpr12,cmpr21,cmpr22,cmpr;
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
 
        cmpr11 = cmpr12 = cmpr21 = cmpr22 = 0;
        if(Bond_Records[i].is_Atom1_ff_type && Bond_Records[i].is_Atom2_ff_type){
@@ -942,7 +953,9 @@ int ForceField::Add_Bond_Record(Bond_Record rec){
 
        for(int i=0;i<bnd_indxs.size();i++){
            Bond_Records[bnd_indxs[i]].merge(rec);
+           index_bond_record(bnd_indxs[i]);  // the merged labels of the record
        }
+       is_tables_dirty = 1;  // the types of the merged records may have changed
        res = 0;
    }
 
@@ -1006,12 +1019,15 @@ int ForceField::Angle_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_type,
    data about angle formed by 3 atoms of of force field types
    "Atom1_ff_int_type", "Atom2_ff_int_type" and "Atom3_ff_int_type" are stored
    Returns -1 if such index has not been found
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    int indx = -1;
-   int sz   = Angle_Records.size();
+   const vector<int>& cand = candidates(angle_int_index, angle_table_key(Atom1_ff_int_type, Atom2_ff_int_type, Atom3_ff_int_type));
+   int sz   = cand.size();
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
        if(Angle_Records[i].is_Atom2_ff_int_type){
           if(Angle_Records[i].Atom2_ff_int_type==Atom2_ff_int_type){
              if(Angle_Records[i].is_Atom1_ff_int_type && Angle_Records[i].is_Atom3_ff_int_type){
@@ -1039,14 +1055,17 @@ int ForceField::Angle_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_type,
    of last of angle_records which match the search parameters
    The angle record will be chosen on the basis of additional comparison
    the Angle_type_index properties if they are available
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    if(res.size()>0) { res.clear(); }
    int indx = -1;
-   int sz   = Angle_Records.size();
+   const vector<int>& cand = candidates(angle_int_index, angle_table_key(Atom1_ff_int_type, Atom2_ff_int_type, Atom3_ff_int_type));
+   int sz   = cand.size();
    int cmpr11,cmpr13,cmpr31,cmpr33,cmpr,cmpr2;
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
 
        cmpr2 = 0;
        if(Angle_Records[i].is_Atom2_ff_int_type){
@@ -1103,14 +1122,17 @@ int ForceField::Angle_Record_Index(std::string Atom1_ff_type, std::string Atom2_
    of last of angle_records which match the search parameters
    The angle record will be chosen on the basis of additional comparison
    the Angle_type_index properties if they are available
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    if(res.size()>0) { res.clear(); }
    int indx = -1;
-   int sz   = Angle_Records.size();
+   const vector<int>& cand = candidates(angle_sym_index, angle_table_key(name_id(Atom1_ff_type,0), name_id(Atom2_ff_type,0), name_id(Atom3_ff_type,0)));
+   int sz   = cand.size();
    int cmpr11,cmpr13,cmpr31,cmpr33,cmpr,cmpr2;
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
 
        cmpr2 = 0;
        if(Angle_Records[i].is_Atom2_ff_type){
@@ -1165,35 +1187,11 @@ int ForceField::Angle_Record_Index(std::string Atom1_ff_type, std::string Atom2_
    of last of angle_records which match the search parameters
    The angle record will be chosen on the basis of additional comparison
    the Angle_type_index properties if they are available
+
+   The search uses the compiled (hashed) tables, see ForceField_methods11.cpp
 *****************************************************************/
-  int indx = -1;
-  cout<<"In ForceField::Angle_Record_Index\n";
-
-  int sz   = Angle_Records.size();
-  int cmpr11,cmpr13,cmpr31,cmpr33,cmpr,cmpr2;
-  for(int i=0;i<sz;i++){
-    cmpr2 = 0;
-    if(Angle_Records[i].is_Atom2_ff_type){
-      cmpr2 = (Angle_Records[i].Atom2_ff_type == Atom2_ff_type);
-    }
-    cout<<"i = "<<i<<" cmpr2 = "<<cmpr2<<endl;
-    if(cmpr2){
-      cmpr11 = cmpr13 = cmpr31 = cmpr33 = 0;
-      if(Angle_Records[i].is_Atom1_ff_type && Angle_Records[i].is_Atom3_ff_type){
-        cmpr11 = (Angle_Records[i].Atom1_ff_type == Atom1_ff_type);
-        cmpr33 = (Angle_Records[i].Atom3_ff_type == Atom3_ff_type);
-        cmpr13 = (Angle_Records[i].Atom1_ff_type == Atom3_ff_type);
-        cmpr31 = (Angle_Records[i].Atom3_ff_type == Atom1_ff_type);
-      }// if both Atom1_ff_int_type and Atom3_ff_int_type are defined
-
-      cout<<"cmpr11 = "<<cmpr11<<" cmpr33 = "<<cmpr33<<" cmpr13 = "<<cmpr13<<" cmpr31 = "<<cmpr31<<endl;
-
-      // --------- Conclusions -------
-//      if((cmpr11&&cmpr33&&cmpr)||(cmpr13&&cmpr31&&cmpr)){ indx = i;  }
-      if((cmpr11&&cmpr33)||(cmpr13&&cmpr31)){ indx = i;  }
-    }// if cmpr2==1
-  }// for i
-  return indx;
+
+  return lookup_angle_record(Atom1_ff_type,Atom2_ff_type,Atom3_ff_type);
 }
 
 
@@ -1250,7 +1248,9 @@ int ForceField::Add_Angle_Record(Angle_Record rec,int order){
 
        for(int i=0;i<ang_indxs.size();i++){
            Angle_Records[ang_indxs[i]].merge(rec);
+           index_angle_record(ang_indxs[i]);  // the merged labels of the record
        }
+       is_tables_dirty = 1;  // the types of the merged records may have changed
        res = 0;
    }
 
@@ -1270,21 +1270,22 @@ int ForceField::Add_Angle_Record(Angle_Record rec){
    if there is an error.
 *********************************************************************/
    int res = 1;
-   int sz = Angle_Records.size();
 
    if(rec.is_Atom1_ff_type&&rec.is_Atom2_ff_type&&rec.is_Atom3_ff_type){
 
-      for(int i=0;i<sz;i++){
-
-         if(Angle_Records[i].is_Atom1_ff_type&&Angle_Records[i].is_Atom2_ff_type&&Angle_Records[i].is_Atom3_ff_type){
-            // This type already exist
-	   if(Angle_Records[i].Atom2_ff_type==rec.Atom2_ff_type){
-             if(((Angle_Records[i].Atom1_ff_type==rec.Atom1_ff_type)&&(Angle_Records[i].Atom2_ff_type==rec.Atom3_ff_type))||
-                ((Angle_Records[i].Atom1_ff_type==rec.Atom3_ff_type)&&(Angle_Records[i].Atom2_ff_type==rec.Atom1_ff_type))
-               ){ res = 0; break; }
-	   }
+      // The candidates are the records with the same types in any order, see ForceField_methods11.cpp
+      const vector<int>& cand = candidates(angle_sym_index, angle_table_key(name_id(rec.Atom1_ff_type,0),
+                                           name_id(rec.Atom2_ff_type,0), name_id(rec.Atom3_ff_type,0)));
+
+      for(int ic=0;ic<(int)cand.size();ic++){
+         int i = cand[ic];
+         // This type already exist
+         if(Angle_Records[i].Atom2_ff_type==rec.Atom2_ff_type){
+           if(((Angle_Records[i].Atom1_ff_type==rec.Atom1_ff_type)&&(Angle_Records[i].Atom3_ff_type==rec.Atom3_ff_type))||
+              ((Angle_Records[i].Atom1_ff_type==rec.Atom3_ff_type)&&(Angle_Records[i].Atom3_ff_type==rec.Atom1_ff_type))
+             ){ res = 0; break; }
          }
-      }// for i
+      }// for ic
 
    }
    else{
@@ -1294,30 +1295,9 @@ int ForceField::Add_Angle_Record(Angle_Record rec){
 
    if(res==1){
       // Before adding angle record to array - update Atom1(2,3)_ff_int_type
-      sz = Atom_Records.size();
-      for(int i=0;i<sz;i++){
-          if(Atom_Records[i].is_Atom_ff_int_type){
-
-             // Atom1
-             if(Atom_Records[i].Atom_ff_type == rec.Atom1_ff_type){               
-                   rec.Atom1_ff_int_type = Atom_Records[i].Atom_ff_int_type;
-                   rec.is_Atom1_ff_int_type = 1;                
-             }// if Atom1
-
-             // Atom2  
-             if(Atom_Records[i].Atom_ff_type == rec.Atom2_ff_type){               
-                   rec.Atom2_ff_int_type = Atom_Records[i].Atom_ff_int_type;
-                   rec.is_Atom2_ff_int_type = 1;                
-             }// if Atom2
-
-             // Atom3  
-             if(Atom_Records[i].Atom_ff_type == rec.Atom3_ff_type){               
-                   rec.Atom3_ff_int_type = Atom_Records[i].Atom_ff_int_type;
-                   rec.is_Atom3_ff_int_type = 1;                
-             }// if Atom3
-
-          }
-      }// for i     
+      atom_int_type(rec.Atom1_ff_type, rec.Atom1_ff_int_type, rec.is_Atom1_ff_int_type);
+      atom_int_type(rec.Atom2_ff_type, rec.Atom2_ff_int_type, rec.is_Atom2_ff_int_type);
+      atom_int_type(rec.Atom3_ff_type, rec.Atom3_ff_int_type, rec.is_Atom3_ff_int_type);
       Angle_Records.push_back(rec);
    }
 
@@ -1332,12 +1312,15 @@ int ForceField::Dihedral_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_ty
    "Atom1_ff_int_type", "Atom2_ff_int_type","Atom3_ff_int_type" and 
    "Atom4_ff_int_type" are stored
     Returns -1 if such index has not been found
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    int indx = -1;
-   int sz   = Dihedral_Records.size();
+   const vector<int>& cand = candidates(dihedral_int_index, dihedral_table_key(Atom1_ff_int_type, Atom2_ff_int_type, Atom3_ff_int_type, Atom4_ff_int_type));
+   int sz   = cand.size();
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
        if(Dihedral_Records[i].is_Atom2_ff_int_type&&Dihedral_Records[i].is_Atom3_ff_int_type){
 
           if((Dihedral_Records[i].Atom2_ff_int_type==Atom2_ff_int_type)&&(Dihedral_Records[i].Atom3_ff_int_type==Atom3_ff_int_type)){
@@ -1374,13 +1357,16 @@ int ForceField::Improper_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_ty
    "Atom1_ff_int_type", "Atom2_ff_int_type","Atom3_ff_int_type" and
    "Atom4_ff_int_type" are stored
     Returns -1 if such index has not been found
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    int indx = -1;
    int res = 0;
-   int sz   = Improper_Records.size();
+   const vector<int>& cand = candidates(improper_int_index, improper_table_key(Atom1_ff_int_type, Atom2_ff_int_type, Atom3_ff_int_type, Atom4_ff_int_type));
+   int sz   = cand.size();
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
        if(Improper_Records[i].is_Atom1_ff_int_type &&
           Improper_Records[i].is_Atom2_ff_int_type &&
           Improper_Records[i].is_Atom3_ff_int_type &&
@@ -1473,14 +1459,17 @@ int ForceField::Dihedral_Record_Index(int Atom1_ff_int_type, int Atom2_ff_int_ty
    the Dihedral_type_index properties if they are available
    order - is a parameter defining importance of indices order
    if order = 1 => ijkl is not the same as lkji
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
 
    if(res.size()>0) { res.clear(); }
    int indx = -1;
-   int sz   = Dihedral_Records.size();
+   const vector<int>& cand = candidates(dihedral_int_index, dihedral_table_key(Atom1_ff_int_type, Atom2_ff_int_type, Atom3_ff_int_type, Atom4_ff_int_type));
+   int sz   = cand.size();
    int cmpr11,cmpr14,cmpr41,cmpr23,cmpr32,cmpr22,cmpr33,cmpr44,cmpr;
 
-   for(int i=0;i<sz;i++){
+   for(int ic=0;ic<sz;ic++){
+       int i = cand[ic];
 
        if(Dihedral_Records[i].is_Dihedral_type_index){
 
@@ -1543,9 +1532,11 @@ int ForceField::Dihedral_Record_Index(std::string Atom1_ff_type, std::string Ato
    the Dihedral_type_index properties if they are available
    order - is a parameter defining importance of indices order
    if order = 1 => ijkl is not the same as lkji
+
+   The search uses the compiled (hashed) tables, see ForceField_methods11.cpp
 *****************************************************************/
-  vector<int> tmp;
-  return Dihedral_Record_Index(Atom1_ff_type,Atom2_ff_type,Atom3_ff_type,Atom4_ff_type,-1,0,tmp);
+
+  return lookup_dihedral_record(Atom1_ff_type,Atom2_ff_type,Atom3_ff_type,Atom4_ff_type);
 }
 
 int ForceField::Dihedral_Record_Index(std::string Atom1_ff_type, std::string Atom2_ff_type, std::string Atom3_ff_type, std::string Atom4_ff_type, int Dihedral_type_index, int order, vector<int>& res){
@@ -1561,12 +1552,15 @@ int ForceField::Dihedral_Record_Index(std::string Atom1_ff_type, std::string Ato
    order - is a parameter defining importance of indices order
    if order = 1 => ijkl is not the same as lkji
    If Dihedral_type_index == -1 it will not be taken into account
+   The candidate records are taken from the multi-key tables, see ForceField_methods11.cpp
 *****************************************************************/
   if(res.size()>0) { res.clear(); }
   int indx = -1;
-  int sz   = Dihedral_Records.size();
+  const vector<int>& cand = candidates(dihedral_sym_index, dihedral_table_key(name_id(Atom1_ff_type,0), name_id(Atom2_ff_type,0), name_id(Atom3_ff_type,0), name_id(Atom4_ff_type,0)));
+  int sz   = cand.size();
   int cmpr11,cmpr14,cmpr41,cmpr23,cmpr32,cmpr22,cmpr33,cmpr44,cmpr;
-  for(int i=0;i<sz;i++){
+  for(int ic=0;ic<sz;ic++){
+      int i = cand[ic];
     //--------------------------------------------------
     if(Dihedral_type_index==-1){ cmpr = 1; }
     else {
@@ -1669,7 +1663,9 @@ int ForceField::Add_Dihedral_Record(Dihedral_Record rec,int order){
 
        for(int i=0;i<dih_indxs.size();i++){
            Dihedral_Records[dih_indxs[i]].merge(rec);
+           index_dihedral_record(dih_indxs[i]);  // the merged labels of the record
        }
+       is_tables_dirty = 1;  // the types of the merged records may have changed
        res = 0;
    }
 
@@ -1691,26 +1687,25 @@ int ForceField::Add_Dihedral_Record(Dihedral_Record rec){
    if there is an error.
 *********************************************************************/
    int res = 1;
-   int sz = Dihedral_Records.size();
 
    if(rec.is_Atom1_ff_type&&rec.is_Atom2_ff_type&&rec.is_Atom3_ff_type&&rec.is_Atom4_ff_type){
 
-      for(int i=0;i<sz;i++){
-
-         if(Dihedral_Records[i].is_Atom1_ff_type&&Dihedral_Records[i].is_Atom2_ff_type
-          &&Dihedral_Records[i].is_Atom3_ff_type&&Dihedral_Records[i].is_Atom4_ff_type){
-           // This type already exist
-	   if((Dihedral_Records[i].Atom2_ff_type==rec.Atom2_ff_type)&&(Dihedral_Records[i].Atom3_ff_type==rec.Atom3_ff_type)){
-             if((Dihedral_Records[i].Atom1_ff_type==rec.Atom1_ff_type)&&(Dihedral_Records[i].Atom4_ff_type==rec.Atom4_ff_type))               
-               { res = 0; break; }
-	   }
-           if((Dihedral_Records[i].Atom2_ff_type==rec.Atom3_ff_type)&&(Dihedral_Records[i].Atom3_ff_type==rec.Atom2_ff_type)){
-             if((Dihedral_Records[i].Atom1_ff_type==rec.Atom4_ff_type)&&(Dihedral_Records[i].Atom4_ff_type==rec.Atom1_ff_type))               
-               { res = 0; break; }
-	   }
+      // The candidates are the records with the same types in the direct or reversed order, see ForceField_methods11.cpp
+      const vector<int>& cand = candidates(dihedral_sym_index, dihedral_table_key(name_id(rec.Atom1_ff_type,0),
+                                           name_id(rec.Atom2_ff_type,0), name_id(rec.Atom3_ff_type,0), name_id(rec.Atom4_ff_type,0)));
 
+      for(int ic=0;ic<(int)cand.size();ic++){
+         int i = cand[ic];
+         // This type already exist
+         if((Dihedral_Records[i].Atom2_ff_type==rec.Atom2_ff_type)&&(Dihedral_Records[i].Atom3_ff_type==rec.Atom3_ff_type)){
+           if((Dihedral_Records[i].Atom1_ff_type==rec.Atom1_ff_type)&&(Dihedral_Records[i].Atom4_ff_type==rec.Atom4_ff_type))
+             { res = 0; break; }
          }
-      }// for i
+         if((Dihedral_Records[i].Atom2_ff_type==rec.Atom3_ff_type)&&(Dihedral_Records[i].Atom3_ff_type==rec.Atom2_ff_type)){
+           if((Dihedral_Records[i].Atom1_ff_type==rec.Atom4_ff_type)&&(Dihedral_Records[i].Atom4_ff_type==rec.Atom1_ff_type))
+             { res = 0; break; }
+         }
+      }// for ic
 
    }
    else{
@@ -1719,37 +1714,11 @@ int ForceField::Add_Dihedral_Record(Dihedral_Record rec){
    }
 
    if(res==1){
-      // Before adding angle record to array - update Atom1(2,3,4)_ff_int_type
-      sz = Atom_Records.size();
-      for(int i=0;i<sz;i++){
-          if(Atom_Records[i].is_Atom_ff_int_type){
-
-             // Atom1
-             if(Atom_Records[i].Atom_ff_type == rec.Atom1_ff_type){               
-                   rec.Atom1_ff_int_type = Atom_Records[i].Atom_ff_int_type;
-                   rec.is_Atom1_ff_int_type = 1;                
-             }// if Atom1
-
-             // Atom2  
-             if(Atom_Records[i].Atom_ff_type == rec.Atom2_ff_type){               
-                   rec.Atom2_ff_int_type = Atom_Records[i].Atom_ff_int_type;
-                   rec.is_Atom2_ff_int_type = 1;                
-             }// if Atom2
-
-             // Atom3  
-             if(Atom_Records[i].Atom_ff_type == rec.Atom3_ff_type){               
-                   rec.Atom3_ff_int_type = Atom_Records[i].Atom_ff_int_type;
-                   rec.is_Atom3_ff_int_type = 1;                
-             }// if Atom3
-
-             // Atom4  
-             if(Atom_Records[i].Atom_ff_type == rec.Atom4_ff_type){               
-                   rec.Atom4_ff_int_type = Atom_Records[i].Atom_ff_int_type;
-                   rec.is_Atom4_ff_int_type = 1;                
-             }// if Atom4
-
-          }
-      }// for i     
+      // Before adding dihedral record to array - update Atom1(2,3,4)_ff_int_type
+      atom_int_type(rec.Atom1_ff_type, rec.Atom1_ff_int_type, rec.is_Atom1_ff_int_type);
+      atom_int_type(rec.Atom2_ff_type, rec.Atom2_ff_int_type, rec.is_Atom2_ff_int_type);
+      atom_int_type(rec.Atom3_ff_type, rec.Atom3_ff_int_type, rec.is_Atom3_ff_int_type);
+      atom_int_type(rec.Atom4_ff_type, rec.Atom4_ff_int_type, rec.is_Atom4_ff_int_type);
       Dihedral_Records.push_back(rec);
    }
 
@@ -1809,6 +1778,7 @@ int ForceField::Add_Improper_Record(Dihedral_Record rec){
 
        for(int i=0;i<dih_indxs.size();i++){
            Improper_Records[dih_indxs[i]].merge(rec);
+           index_improper_record(dih_indxs[i]);  // the merged labels of the record
        }
        res = 0;
    }
@@ -24,6 +24,7 @@
 #include "../math_linalg/liblinalg.h"
 #include "../io/libio.h"
 #include "../Units.h"
+#include <unordered_map>
 
 
 /// liblibra namespace
@@ -46,6 +47,34 @@ namespace libforcefield{
 
 
 
+struct ff_key{
+/**
+  \brief The key of the compiled force field tables: the integer IDs of up to 4 atom types
+*/
+  int a[4];
+
+  bool operator==(const ff_key& k) const{
+    return (a[0]==k.a[0]) && (a[1]==k.a[1]) && (a[2]==k.a[2]) && (a[3]==k.a[3]);
+  }
+};
+
+struct ff_key_hash{
+/**
+  \brief The hash function for the ff_key objects
+*/
+  std::size_t operator()(const ff_key& k) const{
+    std::size_t h = 0;
+    for(int i=0;i<4;i++){  h ^= std::hash<int>()(k.a[i]) + 0x9e3779b9 + (h<<6) + (h>>2);  }
+    return h;
+  }
+};
+
+typedef std::unordered_map<ff_key, int, ff_key_hash> ff_table;
+typedef std::unordered_map<ff_key, vector<int>, ff_key_hash> ff_multi_table;
+
+int is_wildcard_type(const std::string& t);
+
+
 class ForceField{
 
   //--------- Auxiliary internal functions -------------
@@ -53,6 +82,53 @@ class ForceField{
   void copy_content(const ForceField&); // Copies the content which is defined
   void extract_dictionary(boost::python::dict);
 
+  //--------- Compiled lookup tables (ForceField_methods11.cpp) ----------
+  std::unordered_map<std::string,int> type_ids;     ///< Symbolic atom type -> integer type ID
+  std::unordered_map<int,int> atom_table;           ///< Type ID -> index of the atom record
+  ff_table bond_table;                              ///< Canonical (t1,t2) -> index of the bond record
+  ff_table angle_table;                             ///< Canonical (t1,t2,t3) -> index of the angle record
+  ff_table dihedral_table;                          ///< Canonical (t1,t2,t3,t4) -> index of the dihedral record
+  int n_compiled_atoms, n_compiled_bonds, n_compiled_angles, n_compiled_dihedrals;
+  int is_tables_dirty;                              ///< 1 - the records have been modified in place, rebuild the tables
+
+  std::map<std::string,std::string> type_equivalence;  ///< Atom type -> the type which parameters it may use
+  std::unordered_map<std::string, std::pair<std::string,int> > type_cache; ///< Chemical environment -> (atom type, coordination)
+
+  int register_type(const std::string& ff_type);
+  void compile_records(int a0, int b0, int g0, int d0);
+  ff_key bond_table_key(int t1, int t2);
+  ff_key angle_table_key(int t1, int t2, int t3);
+  ff_key dihedral_table_key(int t1, int t2, int t3, int t4);
+  void check_tables();
+  void equivalent_types(const std::string& ff_type, vector<int>& ids);
+  int lookup_atom_record(std::string ff_type);
+  int lookup_bond_record(std::string ff_type1, std::string ff_type2);
+  int lookup_angle_record(std::string ff_type1, std::string ff_type2, std::string ff_type3);
+  int lookup_dihedral_record(std::string ff_type1, std::string ff_type2, std::string ff_type3, std::string ff_type4);
+  void compile_lookup_tables();
+
+  //--------- Multi-key tables of the candidate records for the *_Record_Index searches (ForceField_methods11.cpp) ----------
+  std::unordered_map<std::string,int> name_ids;     ///< Symbolic type -> ID in the multi-key tables ("X" and "*" are distinct here)
+  ff_multi_table atom_int_index, atom_sym_index, atom_elt_index; ///< Int type / symbolic type / atomic number -> indices of the atom records
+  ff_multi_table bond_int_index, bond_sym_index, bond_elt_index; ///< Canonical pair of int types / symbolic types / atomic numbers -> indices of the bond records
+  ff_multi_table angle_int_index, angle_sym_index;  ///< Canonical triple -> indices of the angle records
+  ff_multi_table dihedral_int_index, dihedral_sym_index; ///< Canonical quadruple -> indices of the dihedral records
+  ff_multi_table improper_int_index;                ///< Central type and the sorted peripheral types -> indices of the improper records
+  int n_indexed_atoms, n_indexed_bonds, n_indexed_angles, n_indexed_dihedrals, n_indexed_impropers;
+
+  int name_id(const std::string& ff_type, int is_new);
+  ff_key improper_table_key(int t1, int t2, int t3, int t4);
+  void index_atom_record(int i);
+  void index_bond_record(int i);
+  void index_angle_record(int i);
+  void index_dihedral_record(int i);
+  void index_improper_record(int i);
+  void rebuild_record_index();
+  void check_record_index();
+  const vector<int>& candidates(ff_multi_table& tab, const ff_key& k);
+  void atom_int_type(const std::string& ff_type, int& int_type, int& is_int_type);
+
+
 public:
 
    std::string ForceField_Name;       int is_ForceField_Name;
@@ -218,16 +294,7 @@ public:
 
 
    // These are public:
-   string get_atom_type(string elt,int geometry,string func_grp,int min_ring,int& coordination){
-     string res = "";
-     if(ForceField_Name == "UFF"){ res=uff_type(elt,geometry,func_grp,min_ring,coordination);   }
-     else if(ForceField_Name == "DREIDING"){ res=dreiding_type(elt,geometry,func_grp,min_ring,coordination);   }
-     else if(ForceField_Name == "GAFF"){ res=gaff_type(elt,geometry,func_grp,min_ring,coordination);   }
-     else if(ForceField_Name == "MMFF94"){ res=mmff94_type(elt,geometry,func_grp,min_ring,coordination);   }
-     else if(ForceField_Name == "TRIPOS"){ res=tripos_type(elt,geometry,func_grp,min_ring,coordination);   }
-     else if(ForceField_Name == "TIP3P"){ res=tip3p_type(elt,geometry,func_grp,min_ring,coordination);   }
-     return res;
-   }
+   string get_atom_type(string elt,int geometry,string func_grp,int min_ring,int& coordination); // ForceField_methods11.cpp
    // ForceField_methods.cpp
    int is_valid_atom_type(std::string);
    int is_valid_fragment_type(std::string);
@@ -249,6 +316,11 @@ public:
    // ForceField_method10.cpp
    int get_cg_parameters(map<string,double>& prms);
 
+   // ForceField_methods11.cpp
+   void compile_tables();
+   int get_type_id(std::string ff_type);
+   void add_type_equivalence(std::string ff_type, std::string equiv_type);
+
 };
 
 
@@ -0,0 +1,544 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file ForceField_methods11.cpp
+  \brief The file implements the compiled (hashed) lookup tables of the force field records and
+  the cached atom typing
+*/
+
+#include <algorithm>
+#include "ForceField.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+
+namespace libforcefield{
+
+
+int is_wildcard_type(const std::string& t){
+/**
+  \param[in] t The symbolic atom type
+
+  Returns 1 if the type is a wildcard that matches any atom type ("X" or "*"), 0 otherwise
+*/
+  return (t=="X" || t=="*");
+}
+
+
+int ForceField::get_type_id(std::string ff_type){
+/**
+  \param[in] ff_type The symbolic atom type
+
+  Returns the integer ID of the atom type in the compiled tables: -2 for a wildcard,
+  -1 if this type does not appear in any of the records
+*/
+  if(is_wildcard_type(ff_type)){ return -2; }
+
+  std::unordered_map<std::string,int>::iterator it = type_ids.find(ff_type);
+  return (it!=type_ids.end())? it->second : -1;
+}
+
+int ForceField::register_type(const std::string& ff_type){
+/**
+  Returns the integer ID of the atom type, creating a new ID if needed. Wildcards are all mapped to -2
+*/
+  if(is_wildcard_type(ff_type)){ return -2; }
+
+  std::unordered_map<std::string,int>::iterator it = type_ids.find(ff_type);
+  if(it!=type_ids.end()){ return it->second; }
+
+  int id = type_ids.size();
+  type_ids[ff_type] = id;
+  return id;
+}
+
+
+ff_key ForceField::bond_table_key(int t1, int t2){
+/**
+  The canonical key of the bond formed by the atoms of types t1 and t2: the same for t1-t2 and t2-t1
+*/
+  ff_key k;
+  k.a[0] = (t1<t2)? t1 : t2;  k.a[1] = (t1<t2)? t2 : t1;  k.a[2] = k.a[3] = -3;
+  return k;
+}
+
+ff_key ForceField::angle_table_key(int t1, int t2, int t3){
+/**
+  The canonical key of the angle formed by the atoms of types t1-t2-t3: the same for t3-t2-t1
+*/
+  ff_key k;
+  k.a[0] = (t1<t3)? t1 : t3;  k.a[1] = t2;  k.a[2] = (t1<t3)? t3 : t1;  k.a[3] = -3;
+  return k;
+}
+
+ff_key ForceField::dihedral_table_key(int t1, int t2, int t3, int t4){
+/**
+  The canonical key of the dihedral formed by the atoms of types t1-t2-t3-t4: the same for t4-t3-t2-t1
+*/
+  ff_key k;
+  if( (t1<t4) || ((t1==t4) && (t2<=t3)) ){ k.a[0] = t1; k.a[1] = t2; k.a[2] = t3; k.a[3] = t4; }
+  else{                                    k.a[0] = t4; k.a[1] = t3; k.a[2] = t2; k.a[3] = t1; }
+  return k;
+}
+
+
+void ForceField::compile_records(int a0, int b0, int g0, int d0){
+/**
+  \param[in] a0 The index of the first atom record to be added to the tables
+  \param[in] b0 The index of the first bond record to be added to the tables
+  \param[in] g0 The index of the first angle record to be added to the tables
+  \param[in] d0 The index of the first dihedral record to be added to the tables
+
+  Adds the records from the given indices on to the hashed tables. The records are processed in
+  the order of their indices, so the tables reproduce the results of the linear searches: the first
+  matching atom record and the last matching bond, angle, or dihedral record.
+*/
+
+  int i;
+
+  for(i=a0;i<(int)Atom_Records.size();i++){
+    Atom_Record& r = Atom_Records[i];
+    if(r.is_Atom_ff_type){  atom_table.emplace(register_type(r.Atom_ff_type), i);  }
+  }
+
+  for(i=b0;i<(int)Bond_Records.size();i++){
+    Bond_Record& r = Bond_Records[i];
+    if(r.is_Atom1_ff_type && r.is_Atom2_ff_type){
+      bond_table[bond_table_key(register_type(r.Atom1_ff_type), register_type(r.Atom2_ff_type))] = i;
+    }
+  }
+
+  for(i=g0;i<(int)Angle_Records.size();i++){
+    Angle_Record& r = Angle_Records[i];
+    if(r.is_Atom1_ff_type && r.is_Atom2_ff_type && r.is_Atom3_ff_type){
+      angle_table[angle_table_key(register_type(r.Atom1_ff_type), register_type(r.Atom2_ff_type),
+                                  register_type(r.Atom3_ff_type))] = i;
+    }
+  }
+
+  for(i=d0;i<(int)Dihedral_Records.size();i++){
+    Dihedral_Record& r = Dihedral_Records[i];
+    if(r.is_Atom1_ff_type && r.is_Atom2_ff_type && r.is_Atom3_ff_type && r.is_Atom4_ff_type){
+      dihedral_table[dihedral_table_key(register_type(r.Atom1_ff_type), register_type(r.Atom2_ff_type),
+                                        register_type(r.Atom3_ff_type), register_type(r.Atom4_ff_type))] = i;
+    }
+  }
+
+  n_compiled_atoms = Atom_Records.size();
+  n_compiled_bonds = Bond_Records.size();
+  n_compiled_angles = Angle_Records.size();
+  n_compiled_dihedrals = Dihedral_Records.size();
+
+}
+
+void ForceField::compile_tables(){
+/**
+  Builds all the hashed tables from scratch: the lookup tables of the parameters and the multi-key
+  tables of the candidate records used by the *_Record_Index searches.
+
+  The tables are updated automatically: the appended records are added to them incrementally, and
+  the records merged by the Add_*_Record functions are re-indexed. If the records are modified in
+  place by other means (e.g. from Python), call this function explicitly.
+*/
+
+  compile_lookup_tables();
+  rebuild_record_index();
+
+}
+
+void ForceField::compile_lookup_tables(){
+/**
+  Converts the symbolic atom types of all records into the integer type IDs and builds the hashed
+  lookup tables for the atom, bond, angle, and dihedral records from scratch.
+*/
+
+  type_ids.clear();
+  atom_table.clear();
+  bond_table.clear();
+  angle_table.clear();
+  dihedral_table.clear();
+
+  compile_records(0, 0, 0, 0);
+  is_tables_dirty = 0;
+
+}
+
+void ForceField::check_tables(){
+/**
+  Brings the tables up to date before a lookup. If the records have only been appended since the last
+  compilation, just the new records are added, so building the force field record by record costs
+  O(N) in total. The tables are rebuilt from scratch if they are marked dirty or if records were removed
+*/
+  if(is_tables_dirty || n_compiled_atoms<0 ||
+     n_compiled_atoms > (int)Atom_Records.size() || n_compiled_bonds > (int)Bond_Records.size() ||
+     n_compiled_angles > (int)Angle_Records.size() || n_compiled_dihedrals > (int)Dihedral_Records.size()){
+    compile_lookup_tables();
+  }
+  else if(n_compiled_atoms != (int)Atom_Records.size() || n_compiled_bonds != (int)Bond_Records.size() ||
+          n_compiled_angles != (int)Angle_Records.size() || n_compiled_dihedrals != (int)Dihedral_Records.size()){
+    compile_records(n_compiled_atoms, n_compiled_bonds, n_compiled_angles, n_compiled_dihedrals);
+  }
+}
+
+
+int ForceField::name_id(const std::string& ff_type, int is_new){
+/**
+  \param[in] ff_type The symbolic atom type
+  \param[in] is_new 1 - create a new ID for a type not seen before, 0 - return -1 for such a type
+
+  The IDs of the symbolic types in the multi-key tables. Unlike get_type_id(), the wildcards are
+  ordinary names here, since the *_Record_Index searches compare the type strings literally
+*/
+  std::unordered_map<std::string,int>::iterator it = name_ids.find(ff_type);
+  if(it!=name_ids.end()){ return it->second; }
+  if(!is_new){ return -1; }
+
+  int id = name_ids.size();
+  name_ids[ff_type] = id;
+  return id;
+}
+
+ff_key ForceField::improper_table_key(int t1, int t2, int t3, int t4){
+/**
+  The key of the improper with the central atom of type t2: the same for any order of t1, t3 and t4
+*/
+  ff_key k;
+  int p[3] = {t1, t3, t4};
+  std::sort(p, p+3);
+  k.a[0] = t2;  k.a[1] = p[0];  k.a[2] = p[1];  k.a[3] = p[2];
+  return k;
+}
+
+
+namespace{
+
+void add_candidate(ff_multi_table& tab, const ff_key& k, int i){
+/**
+  Adds the record index i to the list of the key k, keeping the list sorted and free of duplicates
+*/
+  vector<int>& v = tab[k];
+  if(v.empty() || v.back()<i){ v.push_back(i); return; }
+
+  vector<int>::iterator it = std::lower_bound(v.begin(), v.end(), i);
+  if(it==v.end() || *it!=i){ v.insert(it, i); }
+}
+
+}// namespace
+
+
+void ForceField::index_atom_record(int i){
+/**
+  Adds the atom record i to the multi-key tables under all the labels it has
+*/
+  Atom_Record& r = Atom_Records[i];
+  if(r.is_Atom_ff_int_type){ add_candidate(atom_int_index, bond_table_key(r.Atom_ff_int_type, -3), i); }
+  if(r.is_Atom_ff_type){ add_candidate(atom_sym_index, bond_table_key(name_id(r.Atom_ff_type,1), -3), i); }
+  if(r.is_Atom_atomic_number){ add_candidate(atom_elt_index, bond_table_key(r.Atom_atomic_number, -3), i); }
+}
+
+void ForceField::index_bond_record(int i){
+/**
+  Adds the bond record i to the multi-key tables under all the labels it has
+*/
+  Bond_Record& r = Bond_Records[i];
+  if(r.is_Atom1_ff_int_type && r.is_Atom2_ff_int_type){
+    add_candidate(bond_int_index, bond_table_key(r.Atom1_ff_int_type, r.Atom2_ff_int_type), i);
+  }
+  if(r.is_Atom1_ff_type && r.is_Atom2_ff_type){
+    add_candidate(bond_sym_index, bond_table_key(name_id(r.Atom1_ff_type,1), name_id(r.Atom2_ff_type,1)), i);
+  }
+  if(r.is_Atom1_atomic_number && r.is_Atom2_atomic_number){
+    add_candidate(bond_elt_index, bond_table_key(r.Atom1_atomic_number, r.Atom2_atomic_number), i);
+  }
+}
+
+void ForceField::index_angle_record(int i){
+/**
+  Adds the angle record i to the multi-key tables under all the labels it has
+*/
+  Angle_Record& r = Angle_Records[i];
+  if(r.is_Atom1_ff_int_type && r.is_Atom2_ff_int_type && r.is_Atom3_ff_int_type){
+    add_candidate(angle_int_index, angle_table_key(r.Atom1_ff_int_type, r.Atom2_ff_int_type, r.Atom3_ff_int_type), i);
+  }
+  if(r.is_Atom1_ff_type && r.is_Atom2_ff_type && r.is_Atom3_ff_type){
+    add_candidate(angle_sym_index, angle_table_key(name_id(r.Atom1_ff_type,1), name_id(r.Atom2_ff_type,1),
+                                                   name_id(r.Atom3_ff_type,1)), i);
+  }
+}
+
+void ForceField::index_dihedral_record(int i){
+/**
+  Adds the dihedral record i to the multi-key tables under all the labels it has
+*/
+  Dihedral_Record& r = Dihedral_Records[i];
+  if(r.is_Atom1_ff_int_type && r.is_Atom2_ff_int_type && r.is_Atom3_ff_int_type && r.is_Atom4_ff_int_type){
+    add_candidate(dihedral_int_index, dihedral_table_key(r.Atom1_ff_int_type, r.Atom2_ff_int_type,
+                                                         r.Atom3_ff_int_type, r.Atom4_ff_int_type), i);
+  }
+  if(r.is_Atom1_ff_type && r.is_Atom2_ff_type && r.is_Atom3_ff_type && r.is_Atom4_ff_type){
+    add_candidate(dihedral_sym_index, dihedral_table_key(name_id(r.Atom1_ff_type,1), name_id(r.Atom2_ff_type,1),
+                                                         name_id(r.Atom3_ff_type,1), name_id(r.Atom4_ff_type,1)), i);
+  }
+}
+
+void ForceField::index_improper_record(int i){
+/**
+  Adds the improper record i to the multi-key tables
+*/
+  Dihedral_Record& r = Improper_Records[i];
+  if(r.is_Atom1_ff_int_type && r.is_Atom2_ff_int_type && r.is_Atom3_ff_int_type && r.is_Atom4_ff_int_type){
+    add_candidate(improper_int_index, improper_table_key(r.Atom1_ff_int_type, r.Atom2_ff_int_type,
+                                                         r.Atom3_ff_int_type, r.Atom4_ff_int_type), i);
+  }
+}
+
+
+void ForceField::rebuild_record_index(){
+/**
+  Builds the multi-key tables of the candidate records from scratch
+*/
+  name_ids.clear();
+  atom_int_index.clear();  atom_sym_index.clear();  atom_elt_index.clear();
+  bond_int_index.clear();  bond_sym_index.clear();  bond_elt_index.clear();
+  angle_int_index.clear(); angle_sym_index.clear();
+  dihedral_int_index.clear(); dihedral_sym_index.clear();
+  improper_int_index.clear();
+
+  n_indexed_atoms = n_indexed_bonds = n_indexed_angles = n_indexed_dihedrals = n_indexed_impropers = 0;
+  check_record_index();
+}
+
+void ForceField::check_record_index(){
+/**
+  Brings the multi-key tables up to date before a search: the appended records are added to them,
+  and the tables are rebuilt if records were removed
+*/
+  int i;
+
+  if(n_indexed_atoms<0 ||
+     n_indexed_atoms > (int)Atom_Records.size() || n_indexed_bonds > (int)Bond_Records.size() ||
+     n_indexed_angles > (int)Angle_Records.size() || n_indexed_dihedrals > (int)Dihedral_Records.size() ||
+     n_indexed_impropers > (int)Improper_Records.size()){
+    rebuild_record_index();
+    return;
+  }
+
+  for(i=n_indexed_atoms;i<(int)Atom_Records.size();i++){ index_atom_record(i); }
+  for(i=n_indexed_bonds;i<(int)Bond_Records.size();i++){ index_bond_record(i); }
+  for(i=n_indexed_angles;i<(int)Angle_Records.size();i++){ index_angle_record(i); }
+  for(i=n_indexed_dihedrals;i<(int)Dihedral_Records.size();i++){ index_dihedral_record(i); }
+  for(i=n_indexed_impropers;i<(int)Improper_Records.size();i++){ index_improper_record(i); }
+
+  n_indexed_atoms = Atom_Records.size();
+  n_indexed_bonds = Bond_Records.size();
+  n_indexed_angles = Angle_Records.size();
+  n_indexed_dihedrals = Dihedral_Records.size();
+  n_indexed_impropers = Improper_Records.size();
+}
+
+const vector<int>& ForceField::candidates(ff_multi_table& tab, const ff_key& k){
+/**
+  Returns the indices of the records stored under the key k, in the increasing order. These are all the
+  records that may match the search; the callers check each of them with the full matching rules
+*/
+  static const vector<int> empty;
+
+  check_record_index();
+  ff_multi_table::iterator it = tab.find(k);
+  return (it!=tab.end())? it->second : empty;
+}
+
+void ForceField::atom_int_type(const std::string& ff_type, int& int_type, int& is_int_type){
+/**
+  \param[in] ff_type The symbolic atom type
+  \param[out] int_type The integer type of the last atom record of this symbolic type that has it
+  \param[out] is_int_type Set to 1 if such a record is found, unchanged otherwise
+*/
+  const vector<int>& cand = candidates(atom_sym_index, bond_table_key(name_id(ff_type,0), -3));
+
+  for(int ic=(int)cand.size()-1;ic>=0;ic--){
+    Atom_Record& r = Atom_Records[cand[ic]];
+    if(r.is_Atom_ff_int_type && r.Atom_ff_type==ff_type){
+      int_type = r.Atom_ff_int_type;  is_int_type = 1;
+      return;
+    }
+  }
+}
+
+
+void ForceField::add_type_equivalence(std::string ff_type, std::string equiv_type){
+/**
+  \param[in] ff_type The atom type
+  \param[in] equiv_type The atom type which parameters are used for ff_type, if there are no records
+  defined for ff_type itself
+
+  For example, add_type_equivalence("ca", "c") lets the aromatic carbon use the parameters of the sp2 carbon
+*/
+  type_equivalence[ff_type] = equiv_type;
+}
+
+void ForceField::equivalent_types(const std::string& ff_type, vector<int>& ids){
+/**
+  Returns the IDs of the type itself and of its equivalent type (if any, and if it is different),
+  in the order of the priority
+*/
+  ids.clear();
+  ids.push_back(get_type_id(ff_type));
+
+  std::map<std::string,std::string>::iterator it = type_equivalence.find(ff_type);
+  if(it!=type_equivalence.end()){
+    int id = get_type_id(it->second);
+    if(id!=ids[0]){ ids.push_back(id); }
+  }
+}
+
+
+int ForceField::lookup_atom_record(std::string ff_type){
+/**
+  The hashed version of the search of the atom record by the symbolic type. Returns -1 if not found
+*/
+  check_tables();
+
+  std::unordered_map<int,int>::iterator it = atom_table.find(get_type_id(ff_type));
+  if(it==atom_table.end()){ return -1; }
+  return it->second;
+}
+
+int ForceField::lookup_bond_record(std::string ff_type1, std::string ff_type2){
+/**
+  The hashed version of the search of the bond record by the symbolic types. The exact types are
+  tried first, then their equivalent types. Returns -1 if not found
+*/
+  check_tables();
+
+  vector<int> t1, t2;
+  equivalent_types(ff_type1, t1);
+  equivalent_types(ff_type2, t2);
+
+  for(int i=0;i<(int)t1.size();i++){
+    for(int j=0;j<(int)t2.size();j++){
+      if(t1[i]==-1 || t2[j]==-1){ continue; }
+      ff_table::iterator it = bond_table.find(bond_table_key(t1[i], t2[j]));
+      if(it!=bond_table.end()){ return it->second; }
+    }
+  }
+  return -1;
+}
+
+int ForceField::lookup_angle_record(std::string ff_type1, std::string ff_type2, std::string ff_type3){
+/**
+  The hashed version of the search of the angle record by the symbolic types. The exact types are
+  tried first, then their equivalent types, and then the records with the wildcard terminal atoms
+  (X-t2-t3 or X-t2-X). Returns -1 if not found
+*/
+  check_tables();
+
+  vector<int> t1, t2, t3;
+  equivalent_types(ff_type1, t1);
+  equivalent_types(ff_type2, t2);
+  equivalent_types(ff_type3, t3);
+  t1.push_back(-2);  t3.push_back(-2);
+
+  // pass 0: the exact and the equivalent types only, pass 1: the combinations with a wildcard
+  for(int pass=0;pass<2;pass++){
+    for(int j=0;j<(int)t2.size();j++){
+      if(t2[j]==-1){ continue; }
+      for(int i=0;i<(int)t1.size();i++){
+        for(int k=0;k<(int)t3.size();k++){
+          if(t1[i]==-1 || t3[k]==-1){ continue; }
+          if( (t1[i]==-2 || t3[k]==-2) != (pass==1) ){ continue; }
+          ff_table::iterator it = angle_table.find(angle_table_key(t1[i], t2[j], t3[k]));
+          if(it!=angle_table.end()){ return it->second; }
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+int ForceField::lookup_dihedral_record(std::string ff_type1, std::string ff_type2, std::string ff_type3, std::string ff_type4){
+/**
+  The hashed version of the search of the dihedral record by the symbolic types. The exact types are
+  tried first, then their equivalent types, and then the records with the wildcard terminal atoms
+  (X-t2-t3-t4, t1-t2-t3-X or X-t2-t3-X). Returns -1 if not found
+*/
+  check_tables();
+
+  vector<int> t1, t2, t3, t4;
+  equivalent_types(ff_type1, t1);
+  equivalent_types(ff_type2, t2);
+  equivalent_types(ff_type3, t3);
+  equivalent_types(ff_type4, t4);
+  t1.push_back(-2);  t4.push_back(-2);
+
+  // pass 0: the exact and the equivalent types only, pass 1: the combinations with a wildcard
+  for(int pass=0;pass<2;pass++){
+    for(int j=0;j<(int)t2.size();j++){
+      for(int k=0;k<(int)t3.size();k++){
+        if(t2[j]==-1 || t3[k]==-1){ continue; }
+        for(int i=0;i<(int)t1.size();i++){
+          for(int l=0;l<(int)t4.size();l++){
+            if(t1[i]==-1 || t4[l]==-1){ continue; }
+            if( (t1[i]==-2 || t4[l]==-2) != (pass==1) ){ continue; }
+            ff_table::iterator it = dihedral_table.find(dihedral_table_key(t1[i], t2[j], t3[k], t4[l]));
+            if(it!=dihedral_table.end()){ return it->second; }
+          }
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+
+string ForceField::get_atom_type(string elt,int geometry,string func_grp,int min_ring,int& coordination){
+/**
+  \param[in] elt The element symbol
+  \param[in] geometry The number of the atoms connected to the given one
+  \param[in] func_grp The name of the functional group to which the atom belongs
+  \param[in] min_ring The size of the smallest ring to which the atom belongs
+  \param[out] coordination The coordination type of the atom, as defined by the typing rules
+
+  Determines the atom type according to the rules of the force field in use. The atoms of large systems
+  have only a few distinct chemical environments, so the results are cached for each environment and
+  the typing rules are evaluated only once per environment.
+*/
+
+  std::stringstream ss;
+  ss<<ForceField_Name<<"|"<<elt<<"|"<<geometry<<"|"<<func_grp<<"|"<<min_ring;
+  std::string key = ss.str();
+
+  std::unordered_map<std::string, std::pair<std::string,int> >::iterator it = type_cache.find(key);
+  if(it!=type_cache.end()){
+    coordination = it->second.second;
+    return it->second.first;
+  }
+
+  string res = "";
+  if(ForceField_Name == "UFF"){ res=uff_type(elt,geometry,func_grp,min_ring,coordination);   }
+  else if(ForceField_Name == "DREIDING"){ res=dreiding_type(elt,geometry,func_grp,min_ring,coordination);   }
+  else if(ForceField_Name == "GAFF"){ res=gaff_type(elt,geometry,func_grp,min_ring,coordination);   }
+  else if(ForceField_Name == "MMFF94"){ res=mmff94_type(elt,geometry,func_grp,min_ring,coordination);   }
+  else if(ForceField_Name == "TRIPOS"){ res=tripos_type(elt,geometry,func_grp,min_ring,coordination);   }
+  else if(ForceField_Name == "TIP3P"){ res=tip3p_type(elt,geometry,func_grp,min_ring,coordination);   }
+  else{ return res; }
+
+  type_cache[key] = std::pair<std::string,int>(res, coordination);
+
+  return res;
+}
+
+
+}// namespace libforcefield
+}// namespace liblibra
+
+
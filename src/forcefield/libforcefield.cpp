@@ -39,6 +39,11 @@ int (ForceField::*Add_Dihedral_Record2)(Dihedral_Record,int)   = &ForceField::Ad
 
 int (ForceField::*Add_Improper_Record1)(Dihedral_Record)       = &ForceField::Add_Improper_Record;
 
+int (ForceField::*Atom_Record_Index1)(std::string) = &ForceField::Atom_Record_Index;
+int (ForceField::*Bond_Record_Index1)(std::string,std::string) = &ForceField::Bond_Record_Index;
+int (ForceField::*Angle_Record_Index1)(std::string,std::string,std::string) = &ForceField::Angle_Record_Index;
+int (ForceField::*Dihedral_Record_Index1)(std::string,std::string,std::string,std::string) = &ForceField::Dihedral_Record_Index;
+
 
 
 void export_forcefield_objects(){
@@ -237,6 +242,13 @@ void export_forcefield_objects(){
         .def("set",&ForceField::set)
         .def("show_info",&ForceField::show_info)
         .def("set_functionals",&ForceField::set_functionals)
+        .def("compile_tables",&ForceField::compile_tables)
+        .def("get_type_id",&ForceField::get_type_id)
+        .def("add_type_equivalence",&ForceField::add_type_equivalence)
+        .def("Atom_Record_Index",Atom_Record_Index1)
+        .def("Bond_Record_Index",Bond_Record_Index1)
+        .def("Angle_Record_Index",Angle_Record_Index1)
+        .def("Dihedral_Record_Index",Dihedral_Record_Index1)
 
     ;
 
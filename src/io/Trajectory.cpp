@@ -0,0 +1,434 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Trajectory.cpp
+  \brief The file implements the binary trajectory writer and reader
+*/
+
+#include "Trajectory.h"
+#include <string.h>
+#include <sys/types.h>
+
+
+/// liblibra
+namespace liblibra{
+
+/// libio namespace
+namespace libio{
+
+
+namespace{
+
+const char traj_magic[8] = {'L','I','B','R','A','T','R','J'};
+const int32_t traj_version = 1;
+const size_t traj_header_size = 8 + 2*sizeof(int32_t) + 7*sizeof(int64_t);
+
+
+void put(vector<char>& buf, const void* x, size_t nbytes){
+  const char* p = (const char*)x;
+  buf.insert(buf.end(), p, p + nbytes);
+}
+
+void put_reals(vector<char>& buf, const vector<double>& x, int precision){
+  if(precision==8){  put(buf, x.data(), x.size()*sizeof(double));  }
+  else{
+    for(int i=0; i<(int)x.size(); i++){ float y = (float)x[i]; put(buf, &y, sizeof(float)); }
+  }
+}
+
+void get_reals(const char*& p, vector<double>& x, int64_t n, int precision){
+  x.resize(n);
+  if(precision==8){  memcpy(x.data(), p, n*sizeof(double)); p += n*sizeof(double);  }
+  else{
+    for(int i=0; i<n; i++){ float y; memcpy(&y, p, sizeof(float)); x[i] = y; p += sizeof(float); }
+  }
+}
+
+size_t get_frame_size(int precision, int64_t npos, int64_t nvel, int64_t nfrc, int64_t nbox, int64_t npops, int64_t nstates){
+  return sizeof(int64_t) + sizeof(double) + nbox*sizeof(double)
+       + (npos + nvel + nfrc + npops)*precision + nstates*sizeof(int32_t);
+}
+
+}// anonymous namespace
+
+
+
+traj_writer::traj_writer(std::string _filename){
+/**
+  Open the file `_filename` for writing (an existing file is overwritten) with the default parameters
+*/
+
+  filename = _filename;
+  precision = 8;
+  buffer_size = 4*1024*1024;
+  is_async = 1;
+
+  is_header = 0;
+  npos = nvel = nfrc = nbox = npops = nstates = nst = 0;
+  frame_size = 0;
+  nframes = 0;
+  is_pending = 0;
+  is_stop = 0;
+  io_error = 0;
+
+  fp = fopen(filename.c_str(), "wb");
+  if(fp==NULL){
+    cout<<"Error in traj_writer: can not open file "<<filename<<" for writing\nExiting...\n";
+    exit(0);
+  }
+  is_open = 1;
+}
+
+
+traj_writer::traj_writer(std::string _filename, bp::dict params) : traj_writer(_filename){
+/**
+  Same as above, with the parameters:
+
+  precision   [4 or 8] - the number of bytes per element of the pos, vel, frc and pops arrays [default: 8]
+  buffer_size [int] - the size of one of the two buffers, in bytes [default: 4 MB]
+  is_async    [0 or 1] - whether the buffers are written to the file by the background thread [default: 1]
+*/
+
+  set_parameters(params);
+}
+
+
+traj_writer::~traj_writer(){
+  close();
+}
+
+
+void traj_writer::set_parameters(bp::dict params){
+
+  if(is_header){
+    cout<<"Error in traj_writer::set_parameters: the parameters can not be changed after the first frame is written\nExiting...\n";
+    exit(0);
+  }
+
+  std::string key;
+  for(int i=0;i<len(params.values());i++){
+    key = bp::extract<std::string>(params.keys()[i]);
+
+    if(key=="precision") { precision = bp::extract<int>(params.values()[i]);   }
+    else if(key=="buffer_size") { buffer_size = bp::extract<int>(params.values()[i]);   }
+    else if(key=="is_async") { is_async = bp::extract<int>(params.values()[i]);   }
+
+  }// for i
+
+  if(precision!=4 && precision!=8){
+    cout<<"Error in traj_writer::set_parameters: precision = "<<precision<<" is not allowed, use 4 or 8\nExiting...\n";
+    exit(0);
+  }
+  if(buffer_size < 1){ buffer_size = 1; }
+}
+
+
+void traj_writer::write_header(const traj_frame& fr){
+/**
+  Fix the layout of the file by the sizes of the arrays of the first frame
+*/
+
+  npos = fr.pos.size();
+  nvel = fr.vel.size();
+  nfrc = fr.frc.size();
+  nbox = fr.box.size();
+  npops = fr.pops.size();
+  nstates = fr.states.size();
+  nst = fr.nst;
+
+  frame_size = get_frame_size(precision, npos, nvel, nfrc, nbox, npops, nstates);
+
+  fill_buf.reserve(buffer_size + frame_size + traj_header_size);
+  io_buf.reserve(buffer_size + frame_size + traj_header_size);
+
+  int32_t prec = precision;
+  put(fill_buf, traj_magic, 8);
+  put(fill_buf, &traj_version, sizeof(int32_t));
+  put(fill_buf, &prec, sizeof(int32_t));
+  put(fill_buf, &npos, sizeof(int64_t));
+  put(fill_buf, &nvel, sizeof(int64_t));
+  put(fill_buf, &nfrc, sizeof(int64_t));
+  put(fill_buf, &nbox, sizeof(int64_t));
+  put(fill_buf, &npops, sizeof(int64_t));
+  put(fill_buf, &nstates, sizeof(int64_t));
+  put(fill_buf, &nst, sizeof(int64_t));
+
+  is_header = 1;
+}
+
+
+void traj_writer::write(const traj_frame& fr){
+/**
+  Serialize the frame into the active buffer; the buffer is handed over for writing once
+  it holds at least buffer_size bytes
+*/
+
+  if(!is_open){
+    cout<<"Error in traj_writer::write: the file "<<filename<<" is already closed\nExiting...\n";
+    exit(0);
+  }
+
+  if(!is_header){ write_header(fr); }
+
+  if((int64_t)fr.pos.size()!=npos || (int64_t)fr.vel.size()!=nvel || (int64_t)fr.frc.size()!=nfrc || (int64_t)fr.box.size()!=nbox ||
+     (int64_t)fr.pops.size()!=npops || (int64_t)fr.states.size()!=nstates){
+    cout<<"Error in traj_writer::write: the sizes of the arrays of the frame "<<nframes
+        <<" differ from those of the first frame\nExiting...\n";
+    exit(0);
+  }
+
+  int64_t step = fr.step;
+  double time = fr.time;
+  put(fill_buf, &step, sizeof(int64_t));
+  put(fill_buf, &time, sizeof(double));
+  put(fill_buf, fr.box.data(), nbox*sizeof(double));
+  put_reals(fill_buf, fr.pos, precision);
+  put_reals(fill_buf, fr.vel, precision);
+  put_reals(fill_buf, fr.frc, precision);
+  put_reals(fill_buf, fr.pops, precision);
+  for(int i=0; i<nstates; i++){ int32_t s = fr.states[i]; put(fill_buf, &s, sizeof(int32_t)); }
+
+  nframes++;
+
+  if(fill_buf.size() >= (size_t)buffer_size){ submit(); }
+}
+
+
+void traj_writer::write_buffer(vector<char>& buf){
+
+  if(buf.size()>0){
+    if(fwrite(buf.data(), 1, buf.size(), fp) != buf.size()){ io_error = 1; }
+  }
+}
+
+
+void traj_writer::io_loop(){
+/**
+  The background thread: writes io_buf every time it is handed over by submit()
+*/
+
+  std::unique_lock<std::mutex> lk(mtx);
+
+  while(true){
+    cv.wait(lk, [this]{ return is_pending || is_stop; });
+
+    if(is_pending){
+      lk.unlock();
+      write_buffer(io_buf);
+      io_buf.clear();
+      lk.lock();
+      is_pending = 0;
+      cv.notify_all();
+    }
+    else if(is_stop){ break; }
+  }
+}
+
+
+void traj_writer::submit(){
+/**
+  Hand the active buffer over for writing. In the asynchronous mode, this waits only
+  if the previous buffer is still being written.
+*/
+
+  if(fill_buf.size()>0){
+
+    if(!is_async){
+      write_buffer(fill_buf);
+      fill_buf.clear();
+    }
+    else{
+      if(!worker.joinable()){ worker = std::thread(&traj_writer::io_loop, this); }
+
+      std::unique_lock<std::mutex> lk(mtx);
+      cv.wait(lk, [this]{ return !is_pending; });
+      std::swap(fill_buf, io_buf);
+      is_pending = 1;
+      lk.unlock();
+      cv.notify_all();
+
+      fill_buf.clear();
+    }
+  }
+
+  if(io_error){
+    cout<<"Error in traj_writer: failed to write to the file "<<filename<<"\nExiting...\n";
+    exit(0);
+  }
+}
+
+
+void traj_writer::wait_idle(){
+
+  if(worker.joinable()){
+    std::unique_lock<std::mutex> lk(mtx);
+    cv.wait(lk, [this]{ return !is_pending; });
+  }
+}
+
+
+void traj_writer::flush(){
+/**
+  Write all the frames collected so far to the file, so they can be read
+*/
+
+  if(!is_open){ return; }
+
+  submit();
+  wait_idle();
+  fflush(fp);
+
+  if(io_error){
+    cout<<"Error in traj_writer::flush: failed to write to the file "<<filename<<"\nExiting...\n";
+    exit(0);
+  }
+}
+
+
+void traj_writer::close(){
+/**
+  Flush the buffers, stop the background thread and close the file
+*/
+
+  if(!is_open){ return; }
+
+  flush();
+
+  if(worker.joinable()){
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      is_stop = 1;
+    }
+    cv.notify_all();
+    worker.join();
+  }
+
+  fclose(fp);
+  is_open = 0;
+}
+
+
+
+
+traj_reader::traj_reader(std::string _filename){
+/**
+  Open the trajectory file `_filename` and read its header
+*/
+
+  filename = _filename;
+
+  fp = fopen(filename.c_str(), "rb");
+  if(fp==NULL){
+    cout<<"Error in traj_reader: can not open file "<<filename<<"\nExiting...\n";
+    exit(0);
+  }
+
+  char magic[8];
+  int32_t ver, prec;
+  int ok = 1;
+
+  ok = ok && fread(magic, 1, 8, fp)==8 && memcmp(magic, traj_magic, 8)==0;
+  ok = ok && fread(&ver, sizeof(int32_t), 1, fp)==1;
+  ok = ok && fread(&prec, sizeof(int32_t), 1, fp)==1;
+  ok = ok && fread(&npos, sizeof(int64_t), 1, fp)==1;
+  ok = ok && fread(&nvel, sizeof(int64_t), 1, fp)==1;
+  ok = ok && fread(&nfrc, sizeof(int64_t), 1, fp)==1;
+  ok = ok && fread(&nbox, sizeof(int64_t), 1, fp)==1;
+  ok = ok && fread(&npops, sizeof(int64_t), 1, fp)==1;
+  ok = ok && fread(&nstates, sizeof(int64_t), 1, fp)==1;
+  ok = ok && fread(&nst, sizeof(int64_t), 1, fp)==1;
+
+  if(!ok || ver!=traj_version || (prec!=4 && prec!=8)){
+    cout<<"Error in traj_reader: the file "<<filename<<" is not a Libra binary trajectory (or is empty)\nExiting...\n";
+    exit(0);
+  }
+
+  version = ver;
+  precision = prec;
+  header_size = traj_header_size;
+  frame_size = get_frame_size(precision, npos, nvel, nfrc, nbox, npops, nstates);
+
+  refresh();
+}
+
+
+traj_reader::~traj_reader(){
+  if(fp!=NULL){ fclose(fp); }
+}
+
+
+long traj_reader::refresh(){
+/**
+  Recount the complete frames in the file - e.g. if it is still being written.
+  Returns the number of frames
+*/
+
+  fseeko(fp, 0, SEEK_END);
+  off_t sz = ftello(fp);
+
+  nframes = (sz > (off_t)header_size) ? (sz - header_size) / frame_size : 0;
+
+  return nframes;
+}
+
+
+void traj_reader::read_frame(long i, traj_frame& fr){
+/**
+  Read the frame i (negative i count from the end, as in Python)
+*/
+
+  if(i<0){ i += nframes; }
+  if(i<0 || i>=nframes){
+    cout<<"Error in traj_reader::read_frame: frame index "<<i<<" is out of range [0, "<<nframes<<")\nExiting...\n";
+    exit(0);
+  }
+
+  vector<char> buf(frame_size);
+
+  fseeko(fp, (off_t)header_size + (off_t)i * (off_t)frame_size, SEEK_SET);
+  if(fread(buf.data(), 1, frame_size, fp) != frame_size){
+    cout<<"Error in traj_reader::read_frame: can not read the frame "<<i<<" of the file "<<filename<<"\nExiting...\n";
+    exit(0);
+  }
+
+  const char* p = buf.data();
+  int64_t step;
+
+  memcpy(&step, p, sizeof(int64_t));    p += sizeof(int64_t);
+  memcpy(&fr.time, p, sizeof(double));  p += sizeof(double);
+  fr.step = step;
+
+  fr.box.resize(nbox);
+  memcpy(fr.box.data(), p, nbox*sizeof(double));  p += nbox*sizeof(double);
+
+  get_reals(p, fr.pos, npos, precision);
+  get_reals(p, fr.vel, nvel, precision);
+  get_reals(p, fr.frc, nfrc, precision);
+  get_reals(p, fr.pops, npops, precision);
+
+  fr.states.resize(nstates);
+  for(int k=0; k<nstates; k++){ int32_t s; memcpy(&s, p, sizeof(int32_t)); fr.states[k] = s; p += sizeof(int32_t); }
+
+  fr.nst = nst;
+}
+
+
+traj_frame traj_reader::read_frame(long i){
+
+  traj_frame fr;
+  read_frame(i, fr);
+  return fr;
+}
+
+
+}// namespace libio
+}// liblibra
+
@@ -0,0 +1,171 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Trajectory.h
+  \brief The file describes the binary trajectory format: the frame, the buffered writer and the reader
+
+  File layout (native byte order):
+
+    header:  char[8] "LIBRATRJ", int32 version, int32 precision (4 or 8),
+             int64 npos, nvel, nfrc, nbox, npops, nstates, int64 nst
+    frames:  int64 step, float64 time, float64 box[nbox],
+             real pos[npos], real vel[nvel], real frc[nfrc], real pops[npops], int32 states[nstates]
+
+  where "real" is float32 or float64 according to the precision. The sizes are fixed
+  by the first written frame, so all frames have the same size and the frame i
+  starts at  header_size + i * frame_size - this is what makes the random access possible.
+*/
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#if defined(USING_PCH)
+#include "../pch.h"
+#else
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/python.hpp>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+
+/// liblibra
+namespace liblibra{
+
+/// libio namespace
+namespace libio{
+
+using namespace std;
+namespace bp = boost::python;
+
+
+class traj_frame{
+/**
+  One frame of the trajectory. Any of the arrays may be empty - then it is not stored.
+*/
+
+public:
+
+  long step;                ///< the index of the MD step
+  double time;              ///< the simulation time [a.u. of time]
+  vector<double> box;       ///< 9 elements of the unit cell matrix (row-wise: tv1, tv2, tv3) or empty
+  vector<double> pos;       ///< coordinates: 3*Natoms (System) or ndof*ntraj (dyn_variables) elements [Bohr]
+  vector<double> vel;       ///< velocities or momenta
+  vector<double> frc;       ///< forces
+  vector<double> pops;      ///< electronic populations, nst x ntraj elements, pops[itraj*nst + ist]
+  vector<int> states;       ///< active states, ntraj elements
+  int nst;                  ///< the number of electronic states in pops
+
+  traj_frame(){ step = 0; time = 0.0; nst = 0; }
+  traj_frame(const traj_frame& x){ *this = x; }
+  ~traj_frame(){ }
+
+  void clear(){ box.clear(); pos.clear(); vel.clear(); frc.clear(); pops.clear(); states.clear(); nst = 0; }
+};
+
+
+class traj_writer{
+/**
+  The writer of the binary trajectory files
+
+  The frames are serialized into the active buffer; a full buffer is swapped with the
+  second one, which is written to the file by the background thread while the next
+  frames are being serialized (double buffering). With is_async = 0 the buffer is written
+  by the calling thread.
+*/
+
+  std::string filename;
+  FILE* fp;
+  int is_open;
+
+  // Layout - fixed by the first frame
+  int is_header;
+  int64_t npos, nvel, nfrc, nbox, npops, nstates, nst;
+  size_t frame_size;
+  long nframes;
+
+  // Double buffering
+  vector<char> fill_buf;    ///< the buffer the frames are serialized to
+  vector<char> io_buf;      ///< the buffer being written to the file
+  std::thread worker;
+  std::mutex mtx;
+  std::condition_variable cv;
+  int is_pending;           ///< io_buf is waiting to be written
+  int is_stop;
+  std::atomic<int> io_error; ///< set by the background thread, checked by the calling one
+
+  void write_header(const traj_frame& fr);
+  void submit();
+  void wait_idle();
+  void io_loop();
+  void write_buffer(vector<char>& buf);
+
+public:
+
+  int precision;            ///< 4 - float32 arrays, 8 - float64 arrays [default: 8]
+  int buffer_size;          ///< the size of one buffer [bytes, default: 4 MB]
+  int is_async;             ///< 1 - write on the background thread [default], 0 - synchronous writes
+
+  traj_writer(std::string _filename);
+  traj_writer(std::string _filename, bp::dict params);
+  ~traj_writer();
+
+  void set_parameters(bp::dict params);
+
+  void write(const traj_frame& fr);
+  void flush();
+  void close();
+
+  long get_nframes(){ return nframes; }
+
+};
+
+
+class traj_reader{
+/**
+  The reader of the binary trajectory files with random access to the frames
+*/
+
+  std::string filename;
+  FILE* fp;
+  int64_t npos, nvel, nfrc, nbox, npops, nstates, nst;
+  size_t header_size;
+  size_t frame_size;
+  long nframes;
+
+public:
+
+  int precision;
+  int version;
+
+  traj_reader(std::string _filename);
+  ~traj_reader();
+
+  long refresh();
+  long get_nframes(){ return nframes; }
+
+  void read_frame(long i, traj_frame& fr);
+  traj_frame read_frame(long i);
+
+};
+
+
+}// namespace libio
+}// liblibra
+
+#endif // TRAJECTORY_H
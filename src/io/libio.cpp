@@ -22,6 +22,7 @@
 #endif 
 
 #include "libio.h"
+#include "../math_linalg/PyCopy.h"
 
 
 /// liblibra 
@@ -35,11 +36,58 @@ void export_io_objects(){
 /** 
   \brief Exporter of libio classes and functions
 
-  It is empty - so far no functions/classes are exported to Python
-  mostly, they are for C++ utilization
+  Most of the functions are for C++ utilization; the binary trajectory
+  classes are exported to Python
 
 */
 
+  class_<traj_frame>("traj_frame",init<>())
+      .def(init<const traj_frame&>())
+      .def("__copy__", &generic__copy__<traj_frame>)
+      .def("__deepcopy__", &generic__deepcopy__<traj_frame>)
+
+      .def_readwrite("step", &traj_frame::step)
+      .def_readwrite("time", &traj_frame::time)
+      .def_readwrite("box", &traj_frame::box)
+      .def_readwrite("pos", &traj_frame::pos)
+      .def_readwrite("vel", &traj_frame::vel)
+      .def_readwrite("frc", &traj_frame::frc)
+      .def_readwrite("pops", &traj_frame::pops)
+      .def_readwrite("states", &traj_frame::states)
+      .def_readwrite("nst", &traj_frame::nst)
+
+      .def("clear", &traj_frame::clear)
+  ;
+
+  class_<traj_writer, boost::noncopyable>("traj_writer",init<std::string>())
+      .def(init<std::string, bp::dict>())
+
+      .def_readonly("precision", &traj_writer::precision)
+      .def_readonly("buffer_size", &traj_writer::buffer_size)
+      .def_readonly("is_async", &traj_writer::is_async)
+
+      .def("set_parameters", &traj_writer::set_parameters)
+      .def("write", &traj_writer::write)
+      .def("flush", &traj_writer::flush)
+      .def("close", &traj_writer::close)
+      .def("get_nframes", &traj_writer::get_nframes)
+  ;
+
+
+  void (traj_reader::*expt_read_frame_v1)(long i, traj_frame& fr) = &traj_reader::read_frame;
+  traj_frame (traj_reader::*expt_read_frame_v2)(long i) = &traj_reader::read_frame;
+
+  class_<traj_reader, boost::noncopyable>("traj_reader",init<std::string>())
+      .def_readonly("precision", &traj_reader::precision)
+      .def_readonly("version", &traj_reader::version)
+
+      .def("refresh", &traj_reader::refresh)
+      .def("get_nframes", &traj_reader::get_nframes)
+      .def("read_frame", expt_read_frame_v1)
+      .def("read_frame", expt_read_frame_v2)
+  ;
+
+
 }// export_io_objects()
 
 
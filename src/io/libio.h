@@ -19,6 +19,7 @@
 
 
 #include "io.h"
+#include "Trajectory.h"
 
 /// liblibra 
 namespace liblibra{
@@ -581,7 +581,9 @@ def run_dynamics(dyn_var, _dyn_params, ham, compute_model, _model_params, rnd):
 
 
             * **dyn_params["thermostat_params"]** ( dict ): Parameters controlling the thermostat,
-                only relevant for `ensemble = 1`  [ default: {} ]
+                only relevant for `ensemble = 1`  [ default: {} ]. The random numbers of the stochastic
+                thermostats of the trajectory `traj` come from the stream ( thermostat_params["rng_seed"], traj ),
+                the seed being 0 if not given, so the runs are reproducible
 
 
             * **dyn_params["thermostat_dofs"]** ( list of ints ): Thermostat DOFs
@@ -611,6 +613,42 @@ def run_dynamics(dyn_var, _dyn_params, ham, compute_model, _model_params, rnd):
             * **dyn_params["num_electronic_substeps"]** ( int ): the number of electronic integration substeps per 
                 a nuclear step, such that dt_el = dt_nucl / num_electronic_substeps
 
+            * **dyn_params["adaptive_dt"]** ( int ): whether to adapt the nuclear time step:
+
+                - 0: no, all the steps are `dt` [ default ]
+                - 1: yes, `dt` is only the initial step; the next step is chosen after each step, for all
+                     trajectories, from the energy conservation and the force change, see below. The step is
+                     not increased after the steps with hops or decoherence-induced state changes; these 
+                     steps are not rejected or shortened either, so the events themselves are not resolved
+                     any better. The "time" property then reports the actual elapsed time, 
+                     `dyn_var.elapsed_time`. Can not be used with NBRA
+
+            * **dyn_params["adaptive_dt_energy_tol"]** ( double ): the target change of the total energy of
+                a trajectory per nuclear step; not used in the NVT ensemble [ units: Ha, default: 1e-5 ]
+
+            * **dyn_params["adaptive_dt_force_tol"]** ( double ): the target relative change of the force of 
+                a trajectory per nuclear step [ default: 0.1 ]
+
+            * **dyn_params["adaptive_dt_min"]**, **dyn_params["adaptive_dt_max"]** ( double ): the smallest and
+                the largest nuclear steps; zero - dt/16 and 4*dt [ units: a.u. of time, default: 0.0 ]
+
+            * **dyn_params["adaptive_dt_max_factor"]** ( double ): the largest change of the step from one step 
+                to the next, in either direction [ default: 2.0 ]
+
+            * **dyn_params["adaptive_electronic_substeps"]** ( int ): whether to choose the number of the electronic
+                substeps of each trajectory in each nuclear step:
+
+                - 0: no, use `num_electronic_substeps` [ default ]
+                - 1: yes, from the largest vibronic coupling and the rate of change of the energy gaps of the
+                     trajectory, such that the phase accumulated due to the coupling in one substep does not exceed
+                     `electronic_substep_tol`; the rate of the gaps enters through the heuristic 
+                     (dE/dt) * h^2 / 8 < `electronic_substep_tol`, h being the substep
+
+            * **dyn_params["electronic_substep_tol"]** ( double ): see above [ units: radians, default: 0.05 ]
+
+            * **dyn_params["max_electronic_substeps"]** ( int ): the largest number of the electronic substeps 
+                per nuclear step [ default: 100 ]
+
             * **dyn_params["electronic_integrator"]** ( int ): the method for electronic TD-SE integration:
 
               rep_tdse = 0 (diabatic): 1** - with NBRA
@@ -837,7 +875,11 @@ def run_dynamics(dyn_var, _dyn_params, ham, compute_model, _model_params, rnd):
     default_params.update( { "Temperature":300.0, "ensemble":0, "thermostat_params":{},
                              "quantum_dofs":None, "thermostat_dofs":[], "constrained_dofs":[],
                              "dt":1.0*units.fs2au, "num_electronic_substeps":1,
-                             "electronic_integrator":0
+                             "electronic_integrator":0,
+                             "adaptive_dt":0, "adaptive_dt_energy_tol":1e-5, "adaptive_dt_force_tol":0.1,
+                             "adaptive_dt_min":0.0, "adaptive_dt_max":0.0, "adaptive_dt_max_factor":2.0,
+                             "adaptive_electronic_substeps":0, "electronic_substep_tol":0.05,
+                             "max_electronic_substeps":100
                            } )
 
     #================= Variables specific to Python version: saving ================
@@ -914,6 +956,10 @@ def run_dynamics(dyn_var, _dyn_params, ham, compute_model, _model_params, rnd):
     if ensemble==1:
         for traj in range(ntraj):
             therm.append( Thermostat( dyn_params["thermostat_params"] ) )
+            # Each trajectory needs its own random stream, otherwise the stochastic
+            # thermostats apply identical noise to all the trajectories; the stream is
+            # derived from the seed and the trajectory index
+            therm[traj].set_seed( dyn_params["thermostat_params"].get("rng_seed", 0), traj )
             therm[traj].set_Nf_t( len(dyn_params["thermostat_dofs"]) )
             therm[traj].init_nhc()
 
@@ -355,12 +355,15 @@ def init_tsh_savers(params, model_params, nsteps, ntraj, nnucl, nadi, ndia):
 
 
 
-def save_hdf5_1D(saver, i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, txt_type=0):
+def save_hdf5_1D(saver, i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, txt_type=0, params=None, dyn_var=None):
     """
     saver - can be either hdf5_saver or mem_saver
 
     txt_type ( int ): 0 - standard, all the timesteps, 1 - only the current one
 
+    params ( dict ), dyn_var ( dyn_variables ): needed only with the adaptive step (params["adaptive_dt"] == 1),
+        then the time is `dyn_var.elapsed_time` rather than dt*i
+
     """
 
     t = 0
@@ -370,8 +373,11 @@ def save_hdf5_1D(saver, i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_
     # Timestep 
     saver.save_scalar(t, "timestep", i) 
 
-    # Actual time
-    saver.save_scalar(t, "time", dt*i)  
+    # Actual time - with the adaptive step, the steps are not equal
+    if params is not None and params.get("adaptive_dt", 0)==1 and dyn_var is not None:
+        saver.save_scalar(t, "time", dyn_var.elapsed_time)
+    else:
+        saver.save_scalar(t, "time", dt*i)  
 
     # Average kinetic energy
     saver.save_scalar(t, "Ekin_ave", Ekin)  
@@ -420,8 +426,11 @@ def save_hdf5_1D_new(saver, i, params, dyn_var, ham, txt_type=0):
     # Timestep 
     saver.save_scalar(t, "timestep", i) 
 
-    # Actual time
-    saver.save_scalar(t, "time", dt*i)  
+    # Actual time - with the adaptive step, the steps are not equal
+    if params.get("adaptive_dt", 0)==1:
+        saver.save_scalar(t, "time", dyn_var.elapsed_time)
+    else:
+        saver.save_scalar(t, "time", dt*i)  
 
     # Average kinetic energy
     Ekin = dyn_var.compute_average_kinetic_energy()
@@ -820,7 +829,7 @@ def save_hdf5_5D(saver, i, tr, idof, dc1_adi, txt_type=0):
 
 def save_tsh_data_123(_savers, params, 
                       i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, states,
-                      pops, pops_raw, dm_adi, dm_adi_raw, dm_dia, dm_dia_raw, q, p, Cadi, Cdia
+                      pops, pops_raw, dm_adi, dm_adi_raw, dm_dia, dm_dia_raw, q, p, Cadi, Cdia, dyn_var=None
                      ):
 
 
@@ -839,16 +848,16 @@ def save_tsh_data_123(_savers, params,
 
     
     if hdf5_output_level>=1 and _savers["hdf5_saver"]!=None:
-        save_hdf5_1D(_savers["hdf5_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC)
+        save_hdf5_1D(_savers["hdf5_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, 0, params, dyn_var)
 
     if mem_output_level>=1 and _savers["mem_saver"]!=None:
-        save_hdf5_1D(_savers["mem_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC)
+        save_hdf5_1D(_savers["mem_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, 0, params, dyn_var)
 
     if txt_output_level>=1 and _savers["txt_saver"]!=None:
-        save_hdf5_1D(_savers["txt_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC)
+        save_hdf5_1D(_savers["txt_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, 0, params, dyn_var)
 
     if txt2_output_level>=1 and _savers["txt2_saver"]!=None:
-        save_hdf5_1D(_savers["txt2_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, 1)
+        save_hdf5_1D(_savers["txt2_saver"], i, dt, Ekin, Epot, Etot, dEkin, dEpot, dEtot, Etherm, E_NHC, 1, params, dyn_var)
 
 
 
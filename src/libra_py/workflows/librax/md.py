@@ -61,8 +61,8 @@ def init_files(params):
     se_pop_ex_file_prefix = params["res"]+"se_pop_ex"
     sh_pop_ex_file_prefix = params["res"]+"sh_pop_ex"
 
-    for i in xrange(nconfig):
-        #for i_ex in xrange(nstates):
+    for i in range(nconfig):
+        #for i_ex in range(nstates):
         for i_ex in params["excitations_init"]:
             index0 = "_"+str(i)+"_"+str(i_ex)
 
@@ -72,7 +72,7 @@ def init_files(params):
             fel = open(sh_pop_file,"w"); fel.close();
 
             if params["print_aux_results"] == 1:
-                for itraj in xrange(num_SH_traj):
+                for itraj in range(num_SH_traj):
                     index = index0+"_"+str(itraj)
                     ene_file = ene_file_prefix+index+".txt"
                     traj_file = traj_file_prefix+index+".xyz"
@@ -85,7 +85,7 @@ def init_files(params):
                     fm = open(mu_file,"w"); fm.close();
 
     for i_ex in params["excitations_init"]:
-    #for i_ex in xrange(nstates):
+    #for i_ex in range(nstates):
         se_pop_file = se_pop_ex_file_prefix+str(i_ex)+".txt"
         sh_pop_file = sh_pop_ex_file_prefix+str(i_ex)+".txt"
         fel = open(se_pop_file,"w"); fel.close();
@@ -126,9 +126,9 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
     dt_nucl = params["dt_nucl"]
     el_mts = params["el_mts"] # multiple time stepping algorithm for electronic DOF propagation
     if el_mts < 1:
-        print "Error in run_MD: el_mts must be positive integer"
-        print "Value given = ", el_mts
-        print "Exiting..."
+        print("Error in run_MD: el_mts must be positive integer")
+        print("Value given = ", el_mts)
+        print("Exiting...")
         sys.exit(0)
     dt_elec = dt_nucl/float(el_mts)
 
@@ -171,14 +171,16 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
 
     therm = []
     if params["therm"] != None:
-        for i in xrange(ntraj):
+        for i in range(ntraj):
             therm_i = Thermostat(params["therm"])
+            if "rng_seed" in params["therm"]:
+                therm_i.set_seed(params["therm"]["rng_seed"], i)
             therm_i.set_Nf_t(nnucl)
             therm_i.set_Nf_r(0)
             therm_i.init_nhc()
             therm.append(therm_i)
 
-    print "size of therm",len(therm)
+    print("size of therm",len(therm))
 
     if params["is_MM"] == 1: # include MM interactions
         ham_mm = include_mm.init_hamiltonian_mm(syst, params["ff"])
@@ -192,9 +194,9 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
 
     #sys.exit(0) # DEBUG!!!
 
-    print "Starting propagation"
+    print("Starting propagation")
     t.stop()
-    print "Initialization in md takes",t.show(),"sec"
+    print("Initialization in md takes",t.show(),"sec")
     
     #=============== Propagation =======================
 
@@ -211,37 +213,37 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
     mu = []
     smat_old = CMATRIX(nstates,nstates)
     smat = CMATRIX(nstates,nstates)
-    for i in xrange(nstates):
+    for i in range(nstates):
         smat.set(i,i,1.0,0.0)
-    for i in xrange(ntraj):#ens_sz):
+    for i in range(ntraj):#ens_sz):
         mu.append(MATRIX())
 
     #sys.exit(0) # debug
 
-    for i in xrange(Nsnaps):   # number of printouts
+    for i in range(Nsnaps):   # number of printouts
 
-        for j in xrange(Nsteps):   # number of integration steps per printout
+        for j in range(Nsteps):   # number of integration steps per printout
             ij = i*Nsteps + j
 
-            for iconf in xrange(nconfig):     # all initial nuclear configurations
+            for iconf in range(nconfig):     # all initial nuclear configurations
 
-                for i_ex in xrange(nstates_init):  # consider initial excitations to be on all the basis
+                for i_ex in range(nstates_init):  # consider initial excitations to be on all the basis
                                                    # states - this may be unnecessary for all cases, 
                                                    # so we may want to make this part customizable
                     cnt = iconf*nstates_init + i_ex # cnt doesn't include the number of TSH trajectory
                         
-                    for itraj in xrange(num_SH_traj): # all stochastic SH realizations
+                    for itraj in range(num_SH_traj): # all stochastic SH realizations
 
                         cnt_inc_el = iconf*nstates_init*num_SH_traj + i_ex*num_SH_traj + itraj
                         if params["do_rescaling"] == 1:
                             cnt = cnt_inc_el
 
-                        print "Initial geometry %i, initial excitation %i, tsh trajectory %i"%(iconf,params["excitations_init"][i_ex],itraj)
+                        print("Initial geometry %i, initial excitation %i, tsh trajectory %i"%(iconf,params["excitations_init"][i_ex],itraj))
                         #t.start()
 
                         # Electronic propagation: half-step
                         if params["Nstart"] < i:
-                            for k in xrange(el_mts):
+                            for k in range(el_mts):
                                 if params["smat_inc"] == 1:
                                     el[cnt_inc_el].propagate_electronic(0.5*dt_elec, ham[cnt], smat)  # el propagate using S-matrix
                                 else:
@@ -250,7 +252,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                     Nsh = 1
                     if params["do_rescaling"] == 1:
                         Nsh = num_SH_traj
-                    for itraj in xrange(Nsh):#num_SH_traj): # all stochastic SH realizations 
+                    for itraj in range(Nsh):#num_SH_traj): # all stochastic SH realizations 
                         cnt_inc_el = iconf*nstates_init*num_SH_traj + i_ex*num_SH_traj + itraj
                         if params["do_rescaling"] == 1:
                             cnt = cnt_inc_el
@@ -258,7 +260,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                         # >>>>>>>>>>> Nuclear propagation starts <<<<<<<<<<<<
                         # Optional thermostat            
                         if MD_type == 1 and params["Ncool"] < i: # NVT-MD
-                            for k in xrange(3*syst[cnt].Number_of_atoms):
+                            for k in range(3*syst[cnt].Number_of_atoms):
                                 mol[cnt].p[k] = mol[cnt].p[k] * therm[cnt].vel_scale(0.5*dt_nucl)
 
                         mol[cnt].propagate_p(0.5*dt_nucl) # p(t) -> p(t + dt/2)
@@ -319,7 +321,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                         # Update the matrices that are bound to the Hamiltonian 
                         # Compose electronic and vibronic Hamiltonians
                         t.stop()
-                        print "time before update vib ham=",t.show(),"sec"
+                        print("time before update vib ham=",t.show(),"sec")
 
                         if params["non-orth"] ==1:
                             cmt=vibronic_hamiltonian_non_orth(ham_adi[cnt], ham_vib[cnt], params, E_SD_old,E_SD,nac,smat_old,smat, str(ij))
@@ -328,7 +330,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                         else:
                             update_vibronic_hamiltonian(ham_adi[cnt], ham_vib[cnt], params, E_SD,nac, str(ij), opt)
                         t.stop()
-                        print "time after update vib ham=",t.show(),"sec"
+                        print("time after update vib ham=",t.show(),"sec")
                         #print ham_vib[cnt].show_matrix()
                         #print "ham_adi= \n"; ham_adi[cnt].show_matrix()
 
@@ -345,14 +347,14 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                             epot_mm[cnt] = compute_forces(mol[cnt],Electronic(1,0),ham_mm[cnt],1)
 
                             # update forces
-                            for k in xrange(syst[cnt].Number_of_atoms):
-                                for st in xrange(nstates):
+                            for k in range(syst[cnt].Number_of_atoms):
+                                for st in range(nstates):
                                     d1ham_adi[cnt][3*k+0].set(st,st,qm_frac*all_grads[st][k].x - mm_frac*mol[cnt].f[3*k+0])
                                     d1ham_adi[cnt][3*k+1].set(st,st,qm_frac*all_grads[st][k].y - mm_frac*mol[cnt].f[3*k+1])
                                     d1ham_adi[cnt][3*k+2].set(st,st,qm_frac*all_grads[st][k].z - mm_frac*mol[cnt].f[3*k+2])
                         else:
-                            for k in xrange(syst[cnt].Number_of_atoms):
-                                for st in xrange(nstates):
+                            for k in range(syst[cnt].Number_of_atoms):
+                                for st in range(nstates):
                                     d1ham_adi[cnt][3*k+0].set(st,st,qm_frac*all_grads[st][k].x)
                                     d1ham_adi[cnt][3*k+1].set(st,st,qm_frac*all_grads[st][k].y)
                                     d1ham_adi[cnt][3*k+2].set(st,st,qm_frac*all_grads[st][k].z)
@@ -361,13 +363,13 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                         # Update the matrices that are bound to the Hamiltonian 
                         # Compose electronic and vibronic Hamiltonians
                         t.stop()
-                        print "time before update vib ham=",t.show(),"sec"
+                        print("time before update vib ham=",t.show(),"sec")
                         if params["non-orth"] ==1:
                             vibronic_hamiltonian_non_orth(ham_adi[cnt], ham_vib[cnt], params, E_SD_old,E_SD,nac,smat_old,smat, str(ij))
                         else:
                             update_vibronic_hamiltonian(ham_adi[cnt], ham_vib[cnt], params, E_SD,nac, str(ij), opt)
                         t.stop()
-                        print "time after update vib ham=",t.show(),"sec"
+                        print("time after update vib ham=",t.show(),"sec")
                         #print ham_vib[cnt].show_matrix()
 
                         #sys.exit(0)
@@ -381,7 +383,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                         ekin[cnt] = compute_kinetic_energy(mol[cnt])                    # for propagating thermostat variables.
 
                         t.stop()
-                        print "time after computing epot and ekin, eext, etot=",t.show(),"sec"
+                        print("time after computing epot and ekin, eext, etot=",t.show(),"sec")
 
                         # propagate thermostat variables
                         etherm = 0.0
@@ -393,7 +395,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
 
                         # optional thermostat
                         if MD_type == 1 and params["Ncool"] < i: # NVT-MD
-                            for k in xrange(3*syst[cnt].Number_of_atoms):
+                            for k in range(3*syst[cnt].Number_of_atoms):
                                 mol[cnt].p[k] = mol[cnt].p[k] * therm[cnt].vel_scale(0.5*dt_nucl)
 
                         ekin[cnt] = compute_kinetic_energy(mol[cnt])
@@ -401,14 +403,14 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                         eext[cnt] = etot[cnt] + etherm
 
                         # >>>>>>>>>>> Nuclear propagation ends <<<<<<<<<<<<
-                    for itraj in xrange(Nsh):#num_SH_traj): # all stochastic SH realizations
+                    for itraj in range(Nsh):#num_SH_traj): # all stochastic SH realizations
                         cnt_inc_el = iconf*nstates_init*num_SH_traj + i_ex*num_SH_traj + itraj
                         if params["do_rescaling"] == 1:
                             cnt = cnt_inc_el
                         
                         # Electronic propagation: half-step
                         if params["Nstart"] < i:
-                            for k in xrange(el_mts):
+                            for k in range(el_mts):
                                 if params["smat_inc"] == 1:
                                     el[cnt_inc_el].propagate_electronic(0.5*dt_elec, ham[cnt], smat)  # el propagate using S-matrix
                                 else:
@@ -421,7 +423,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                         #####################################################################
 
                         t.stop()
-                        print "(iconf=%i,i_ex=%i,itraj=%i) takes %f sec"%(iconf,i_ex,itraj,t.show()) 
+                        print("(iconf=%i,i_ex=%i,itraj=%i) takes %f sec"%(iconf,i_ex,itraj,t.show())) 
                         #******** end of itsh loop
                     #********* end of i_ex loop
                 #********* end of iconf loop
@@ -429,12 +431,12 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                     
             ############ Add surface hopping ######################
             # store the electronic state
-            for tr in xrange(ens_sz):
+            for tr in range(ens_sz):
                 old_st[tr] =el[tr].istate
 
-            print "Before TSH"
+            print("Before TSH")
             t.stop()
-            print "time before TSH=",t.show(),"sec"
+            print("time before TSH=",t.show(),"sec")
 
             if SH_type>=1 and params["Nstart"] < i:
                 params["time_step"] = ij # for numbering the transition probability.
@@ -450,10 +452,10 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
 
             # induce decoherence 
             if params["do_collapse"] == 1:
-                for iconf in xrange(nconfig): 
-                    for i_ex in xrange(nstates_init):
+                for iconf in range(nconfig): 
+                    for i_ex in range(nstates_init):
                         cnt = iconf*nstates_init + i_ex
-                        for itraj in xrange(num_SH_traj):
+                        for itraj in range(num_SH_traj):
                             cnt_inc_el = iconf*nstates_init*num_SH_traj + i_ex*num_SH_traj + itraj
 
                             if params["do_rescaling"] == 1:
@@ -465,9 +467,9 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                             E_new = ham_vib[cnt].get(new_st,new_st).real
                             el[cnt_inc_el].istate, el[cnt_inc_el] = tsh.ida_py(el[cnt_inc_el], old_st[cnt_inc_el], new_st, E_old, E_new, params["Temperature"], ksi, params["do_collapse"]) 
             ################### END of TSH ##########################
-            print "Finished TSH"
+            print("Finished TSH")
             t.stop()
-            print "time after TSH=",t.show(),"sec"
+            print("time after TSH=",t.show(),"sec")
 
         #************ end of j loop - all steps for this snap
 
@@ -478,7 +480,7 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
                 Nsys = ntraj
                 if params["do_rescaling"] == 1:
                     Nsys = ntraj * num_SH_traj
-                for cnt in xrange(Nsys):
+                for cnt in range(Nsys):
                     syst[cnt].cool()
                     syst[cnt].extract_atomic_p(mol[cnt].p)  # syst -> mol
 
@@ -494,10 +496,10 @@ def run_MD(syst,el,ao,E,sd_basis,params,label,Q, active_space):
         if params["print_aux_results"]==1:
             print_results.print_ens_traj(i,mol,syst,mu,epot,ekin,etot,eext,params)
 
-        print "       ********* %i snap ends ***********" % i
-        print 
+        print("       ********* %i snap ends ***********" % i)
+        print()
         t.stop()
-        print "time after final result printing=",t.show(),"sec"
+        print("time after final result printing=",t.show(),"sec")
 
 
 
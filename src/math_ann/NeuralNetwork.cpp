@@ -91,6 +91,11 @@ void NeuralNetwork::allocate(vector<int>& arch){
    dW.push_back(w);
    dWold.push_back(w);
 
+   mW.push_back(w);
+   vW.push_back(w);
+   mB.push_back(b);
+   vB.push_back(b);
+
    // Init weights and biases (additional edges)
    for(L=1;L<Nlayers;L++){
 
@@ -109,9 +114,17 @@ void NeuralNetwork::allocate(vector<int>& arch){
       dW.push_back(w);
       dWold.push_back(w);
 
+      w = 0.0;  b = 0.0;
+      mW.push_back(w);
+      vW.push_back(w);
+      mB.push_back(b);
+      vB.push_back(b);
 
    } // max index of W as well as B is Nlayers-1
 
+   adam_t = 0;
+   shard_capacity = 0;
+
    //------------------ Debugging ------------------------
    std::cout<<"A multi-layer perceptron has been created\n";
    std::cout<<"Number of layers = "<<Nlayers<<std::endl;
@@ -149,6 +162,8 @@ NeuralNetwork::NeuralNetwork(const NeuralNetwork& ann){
 
   Nlayers      = ann.Nlayers;
   Npe          = ann.Npe;
+  sz_x         = ann.sz_x;
+  sz_y         = ann.sz_y;
 
   W            = ann.W;
   grad_w       = ann.grad_w;
@@ -165,6 +180,16 @@ NeuralNetwork::NeuralNetwork(const NeuralNetwork& ann){
   D            = ann.D;
   Delta        = ann.Delta;
 
+  mW           = ann.mW;
+  vW           = ann.vW;
+  mB           = ann.mB;
+  vB           = ann.vB;
+  adam_t       = ann.adam_t;
+  validation_error = ann.validation_error;
+
+  // The mini-batch buffers are not copied - they are re-allocated on demand
+  shard_capacity = 0;
+
 }
 
 
@@ -172,6 +197,8 @@ NeuralNetwork& NeuralNetwork::operator=(const NeuralNetwork& ann){
 
   Nlayers      = ann.Nlayers;
   Npe          = ann.Npe;
+  sz_x         = ann.sz_x;
+  sz_y         = ann.sz_y;
 
   W            = ann.W;
   grad_w       = ann.grad_w;
@@ -188,6 +215,16 @@ NeuralNetwork& NeuralNetwork::operator=(const NeuralNetwork& ann){
   D            = ann.D;
   Delta        = ann.Delta;
 
+  mW           = ann.mW;
+  vW           = ann.vW;
+  mB           = ann.mB;
+  vB           = ann.vB;
+  adam_t       = ann.adam_t;
+  validation_error = ann.validation_error;
+
+  // The mini-batch buffers are not copied - they are re-allocated on demand
+  shard_capacity = 0;
+
 
   return *this;
 }
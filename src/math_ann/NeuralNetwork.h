@@ -44,6 +44,101 @@ using namespace std;
 namespace libann{
 
 
+class ann_training_params{
+/**
+  The training hyperparameters - parsed from the Python dictionary once per ANN.train() call
+
+  Defined in: NeuralNetwork_Training.cpp
+*/
+
+public:
+
+  ///================= Optimizer ===================
+  /**
+    Learning class in parenthesis
+
+    1  (1) - Back Propagation (BProp) and options, no momentum, Algorithm 1 of [2], neither purple nor green [default]
+    11 (1) - BProp with L2 regularization - Algorithm 1 of [2], purple option
+    12 (1) - BProp with decoulpled decay  - Algorithm 1 of [2], green option
+    13 (1) - Adam with L2 regularization - Algorithm 2 of [2], purple option
+    14 (1) - Adam with decoupled decay (AdamW) - Algorithm 2 of [2], green option
+    2  (2) - Resilient Propagation without weight-backtracking (RProp-) - Eq. 1 of [3] + section 2.2
+    21 (2) - Resilient Propagation with weight-backtracking (RProp+) - Eq. 1 of [3] + section 2.1
+    22 (2) - Modified RProp- (iRprop-)
+    23 (2) - Modified RProp+ (iRprop+)
+    3  (3) - limited-memory BFGS (L-BFGS) with the backtracking line search, full-batch
+  */
+  int learning_method;
+  int learning_class;
+
+  /// `alpha` in algorithm (1) of [2]
+  double learning_rate;
+
+  /// `beta_1` in algorithm (1) of [2]
+  double momentum_term;
+
+  /// `lambda` in algorithm (1) of [2]
+  double weight_decay_lambda;
+
+  /// `etha_t` in algorithm (1) of [2]
+  double etha;
+
+  /// Adam: `beta_1`, `beta_2`, `epsilon` in algorithm (2) of [2]
+  double adam_beta1;
+  double adam_beta2;
+  double adam_eps;
+
+  /// RProp parameters
+  double a_plus;
+  double a_minus;
+  double dB_min, dB_max, dW_min, dW_max;
+
+  /// L-BFGS: the number of the stored correction pairs and the max number of the line-search halvings
+  int lbfgs_memory;
+  int lbfgs_max_linesearch;
+
+  ///================= Learning rate schedule ===================
+  /**
+    0 - constant [default]
+    1 - exponential:  lr = learning_rate * lr_decay^epoch
+    2 - step:  lr = learning_rate * lr_decay^(epoch / lr_step)
+    3 - cosine annealing from learning_rate to lr_min over num_epochs
+  */
+  int lr_schedule;
+  double lr_decay;
+  int lr_step;
+  double lr_min;
+
+  ///================= Epochs and batches ===================
+  int num_epochs;
+  int steps_per_epoch;
+  int epoch_size;
+  int verbosity;
+  int is_error_collect_frequency;
+  int error_collect_frequency;
+
+  /// The max number of the batch shards processed in parallel; 0 - use all available OpenMP threads
+  int num_threads;
+
+  ///================= Early stopping ===================
+  /// Stop if the validation error has not improved by more than `min_delta` for `patience` epochs; 0 - no early stopping
+  int patience;
+  double min_delta;
+
+
+  ann_training_params();
+  ann_training_params(const ann_training_params& x){ *this = x; }
+  ~ann_training_params(){ ;; }
+
+  void set_parameters(bp::dict params);
+  void sanity_check(int n_patterns);
+  double learning_rate_at(int epoch);
+  void show();
+
+};
+
+
+
 class NeuralNetwork{
  
 public:
@@ -72,13 +167,29 @@ public:
 //  vector<MATRIX> dF;   // derivative of the transfer functions, e.g. dF[L] = 1- Y[L]*Y[L], element by element
   vector<MATRIX> D;
   vector<MATRIX> Delta;
- 
+
+  // Adam-related: first and second moments of the gradients and the number of the steps taken
+  vector<MATRIX> mW, vW;
+  vector<MATRIX> mB, vB;
+  int adam_t;
+
+  // Validation errors collected (once per epoch) during the last train() call
+  vector<double> validation_error;
+
+  // Mini-batch buffers, one set per batch shard: activations, deltas, and partial gradients
+  // allocated on demand by allocate_batch_buffers() and reused over the training steps
+  vector< vector<MATRIX> > shard_Y;
+  vector< vector<MATRIX> > shard_delta;
+  vector< vector<MATRIX> > shard_grad_w;
+  vector< vector<MATRIX> > shard_grad_b;
+  int shard_capacity;
+
   //--------------- Basic methods: NeuralNetwork.cpp ---------------------
   // Auxiliary
   void allocate(vector<int>& arch);
 
   // Constructors
-  NeuralNetwork(){ Nlayers = 0;  }
+  NeuralNetwork(){ Nlayers = 0; adam_t = 0; shard_capacity = 0; }
   NeuralNetwork(vector<int>& arch);
   NeuralNetwork(std::string xml_filename);
 
@@ -117,6 +228,29 @@ public:
 
   // Training
   vector<double> train(Random& rnd, bp::dict params, MATRIX& inputs, MATRIX& targets);
+  vector<double> train(Random& rnd, bp::dict params, MATRIX& inputs, MATRIX& targets,
+                       MATRIX& val_inputs, MATRIX& val_targets);
+
+
+  //--------------- Mini-batch training engine: NeuralNetwork_Training.cpp ---------------------
+  void allocate_batch_buffers(int batch_size, int nshards);
+  double batch_gradients(MATRIX& inputs, MATRIX& targets, vector<int>& subset, int nthreads);
+  double batch_error(MATRIX& inputs, MATRIX& targets, int nthreads);
+
+  // Optimizer steps using the current grad_w and grad_b
+  void bprop_step(ann_training_params& prms, double lr);
+  void adam_step(ann_training_params& prms, double lr);
+  void rprop_step(ann_training_params& prms);
+  void reset_optimizer(Random& rnd, ann_training_params& prms);
+
+  // Flat views of all the trainable parameters and of their gradients, used by L-BFGS
+  int num_parameters();
+  void get_parameters(vector<double>& x);
+  void set_parameters(vector<double>& x);
+  void get_gradients(vector<double>& g);
+  double lbfgs_step(ann_training_params& prms, MATRIX& inputs, MATRIX& targets, vector<int>& subset, int nthreads,
+                    vector< vector<double> >& S, vector< vector<double> >& Y, vector<double>& rho,
+                    double& f, vector<double>& g, int& is_stalled);
 
 
 };
@@ -234,7 +234,7 @@ double NeuralNetwork::back_propagate(vector<MATRIX>& Y, MATRIX& target){
 
   Y      [Y[0]=input]      [ f(W[1]*Y[0] + B[1]) ]           [ output = f(W[NL]*Y[NL-1] + B[NL]) ]
 
- deltas  [junk]           W^T[2]*delta[2] *f'(Y[1])                   target - output[NL]
+ deltas  [junk]           W^T[2]*delta[2] *f'(Y[1])           (target - output[NL]) *f'(output[NL])
   
   */
 
@@ -249,6 +249,22 @@ double NeuralNetwork::back_propagate(vector<MATRIX>& Y, MATRIX& target){
   /// L = Nlayers-1  
   delta[Nlayers-1] = target - Y[Nlayers-1];
 
+  // Compute error
+  double err = 0.0;
+  for(i=0; i<Npe[Nlayers-1]; i++){ 
+    for(j=0; j<sz; j++){ 
+      err += delta[Nlayers-1].get(i,j) * delta[Nlayers-1].get(i,j);
+    }// for j
+  }// for i
+  err *= (0.5/double(sz));
+
+  /// The output layer also has the tanh transfer function
+  for(i=0; i<Npe[Nlayers-1]; i++){ 
+    for(j=0; j<sz; j++){ 
+      delta[Nlayers-1].scale(i, j,  (1.0 - Y[Nlayers-1].get(i, j) * Y[Nlayers-1].get(i, j))  );
+    }
+  }
+
   /// L = Nlayers - 2, Nlayers-3, ..., 1
   for(L = Nlayers-2; L > 0; L--){
 
@@ -279,16 +295,6 @@ double NeuralNetwork::back_propagate(vector<MATRIX>& Y, MATRIX& target){
 
   }// for L
 
-
-  // Compute error
-  double err = 0.0;
-  for(i=0; i<Npe[Nlayers-1]; i++){ 
-    for(j=0; j<sz; j++){ 
-      err += delta[Nlayers-1].get(i,j) * delta[Nlayers-1].get(i,j);
-    }// for j
-  }// for i
-  err *= (0.5/double(sz));
-
   return err;
 
 }
@@ -358,318 +364,150 @@ double NeuralNetwork::error(MATRIX& inputs, MATRIX& target){
 
 vector<double> NeuralNetwork::train(Random& rnd, bp::dict params, MATRIX& inputs, MATRIX& targets){
 /**
-  References:
- 
-  [1] http://page.mi.fu-berlin.de/rojas/neural/chapter/K8.pdf
-  [2] https://arxiv.org/pdf/1711.05101.pdf
-  [3] http://citeseerx.ist.psu.edu/viewdoc/summary?doi=10.1.1.17.1332
-
+  Training without the validation set - see the description of the overloaded version below
 */
 
-  int i, j, epoch, L, a1, a2;
-
-  ///============ Get the parameters ==================
-  /**
-    Learning class in parenthesis
-
-    1  (1) - Back Propagation (BProp) and options, no momentum, Algorithm 1 of [2], neither purple nor green [default]
-    11 (1) - BProp with L2 regularization - Algorithm 1 of [2], purple option
-    12 (1) - BProp with decoulpled decay  - Algorithm 1 of [2], green option
-    13 (1) - Adam with L2 regularization - Algorithm 2 of [2], purple option
-    14 (1) - Adam with decoupled decay - Algorithm 2 of [2], green option
-    2  (2) - Resilient Propagation without weight-backtracking (RProp-) - Eq. 1 of [3] + section 2.2
-    21 (2) - Resilient Propagation with weight-backtracking (RProp+) - Eq. 1 of [3] + section 2.1
-    22 (2) - Modified RProp- (iRprop-)
-    23 (2) - Modified RProp+ (iRprop+)
+  MATRIX val_inputs;
+  MATRIX val_targets;
 
+  return train(rnd, params, inputs, targets, val_inputs, val_targets);
 
-  */
-  int learning_method = 1; 
-  int learning_class = 1;
-
-  /// `alpha` in algorithm (1) of [2]
-  double learning_rate = 0.001;      
-
-  /// `beta_1` in algorithm (1) of [2]
-  double momentum_term = 0.0;        
-
-  /// `lambda` in algorithm (1) of [2]
-  /// L2 regularization factor  L_new = L_old + lambda * w^T w
-  double weight_decay_lambda = 0.0;  
-                                     
-  /// `etha_t` in algorithm (1) of [2]
-  double etha = 1.0;
-
-  int num_epochs = 1;
-  int steps_per_epoch = 1;
-  int epoch_size = 1;
-  int n_patterns = inputs.n_cols;
-  int verbosity = 0;
-  int is_error_collect_frequency = 0; 
-  int error_collect_frequency = 1;
-
-  /// RProp parameters
-  /// RProp parameter - good for up to 1.2
-  double a_plus = 1.1;   
-
-  /// RProp parameter - good for up to 0.5
-  double a_minus = 0.6;  
+}
 
-  double dB_min =  0.1*learning_rate;
-  double dB_max =  learning_rate;
-  double dW_min =  0.1*learning_rate;
-  double dW_max =  learning_rate;
 
+vector<double> NeuralNetwork::train(Random& rnd, bp::dict params, MATRIX& inputs, MATRIX& targets,
+                                    MATRIX& val_inputs, MATRIX& val_targets){
+/**
+  Trains the ANN on the inputs and targets. The patterns of every step are processed as a mini-batch
+  by the batched engine (see NeuralNetwork_Training.cpp)
 
-  std::string key;
-  for(int i=0;i<len(params.values());i++){
-    key = bp::extract<std::string>(params.keys()[i]);
+  Args:
+    rnd - random number generator
+    params - the dictionary of the training parameters, see ann_training_params
+    inputs - sz_x x n_patterns matrix of the training inputs
+    targets - sz_y x n_patterns matrix of the training targets
+    val_inputs, val_targets - the validation set; if not empty, the validation error is computed after every
+      epoch (collected in `validation_error`), the training stops after `patience` epochs without improvement,
+      and the weights and biases with the lowest validation error are restored at the end
 
+  Returns: 
+    the training errors collected every `error_collect_frequency` steps
 
-    if(key=="learning_rate") { learning_rate = bp::extract<double>(params.values()[i]); }
-    else if(key=="learning_method") { learning_method = bp::extract<int>(params.values()[i]);   }
-    else if(key=="momentum_term") { momentum_term = bp::extract<double>(params.values()[i]); }
-    else if(key=="weight_decay_lambda") { weight_decay_lambda = bp::extract<double>(params.values()[i]); }
-    else if(key=="etha") { etha = bp::extract<double>(params.values()[i]); }
+  References:
  
-    else if(key=="num_epochs") { num_epochs = bp::extract<int>(params.values()[i]);   }
-    else if(key=="steps_per_epoch") { steps_per_epoch = bp::extract<int>(params.values()[i]);   }
-    else if(key=="epoch_size") { epoch_size = bp::extract<int>(params.values()[i]);   }
-    else if(key=="verbosity") { verbosity = bp::extract<int>(params.values()[i]);   }
-    else if(key=="error_collect_frequency") { 
-      is_error_collect_frequency = 1;
-      error_collect_frequency = bp::extract<int>(params.values()[i]);  
-    }
-    else if(key=="a_plus") { a_plus = bp::extract<double>(params.values()[i]); }
-    else if(key=="a_minus") { a_minus = bp::extract<double>(params.values()[i]); }
-    else if(key=="dB_min") { dB_min = bp::extract<double>(params.values()[i]); }
-    else if(key=="dB_max") { dB_max = bp::extract<double>(params.values()[i]); }
-    else if(key=="dW_min") { dW_min = bp::extract<double>(params.values()[i]); }
-    else if(key=="dW_max") { dW_max = bp::extract<double>(params.values()[i]); }
-
-
+  [1] http://page.mi.fu-berlin.de/rojas/neural/chapter/K8.pdf
+  [2] https://arxiv.org/pdf/1711.05101.pdf
+  [3] http://citeseerx.ist.psu.edu/viewdoc/summary?doi=10.1.1.17.1332
 
-  } // for i
+*/
 
+  int i, epoch, L;
 
-  // Sanity check and other setups
-  if(learning_method==1 || learning_method==11 || learning_method==12 || learning_method==13 || learning_method==14 ){
-    learning_class = 1;
+  if(inputs.n_rows!=sz_x){
+    std::cout<<"Error: Size of the input "<<inputs.n_rows<<" does not match the ANN architecture "<<sz_x<<std::endl;
+    exit(0);
   }
-  else if(learning_method == 2 || learning_method == 21 || learning_method == 22 || learning_method == 23 ){
-    learning_class = 2;
+  if(targets.n_rows!=sz_y){
+    std::cout<<"Error: Size of the target output "<<targets.n_rows<<" does not match the ANN architecture "<<sz_y<<std::endl;
+    exit(0);
   }
-
-  // Implementation status
-  if(learning_method==13){  cout<<"The method 13 is not yet implemented: using 11 instead"; learning_method = 11;  }
-  if(learning_method==14){  cout<<"The method 14 is not yet implemented: using 12 instead"; learning_method = 12;  }
-
-  if(learning_method==21){  cout<<"The method 22 is not yet implemented: using 2 instead"; learning_method = 2;  }
-  if(learning_method==22){  cout<<"The method 22 is not yet implemented: using 2 instead"; learning_method = 2;  }
-  if(learning_method==23){  cout<<"The method 23 is not yet implemented: using 2 instead"; learning_method = 2;  }
-
-
-  if(learning_class==1){ // Backprop setups
-
-    for(L = 0; L < Nlayers; L++){ 
-      dBold[L] = dB[L]; 
-      dWold[L] = dW[L]; 
-    }// for L
-
+  if(targets.n_cols!=inputs.n_cols){    
+    std::cout<<"Error: The number of patterns is different for inputs "<<inputs.n_cols<<" and targets "<<targets.n_cols<<std::endl;
+    exit(0);
   }
-  if(learning_class==2){   // RProp setups
-    if(epoch_size!=n_patterns){  
-      cout<<"WARNING in ANN.train : epoch_size ("<<epoch_size
-          <<") should be equal to the total number of patters ("<<n_patterns<<")\n";
-      epoch_size = n_patterns;
-      cout<<"Using new value of epoch_size = "<<epoch_size<<endl;
-    }
 
-    // Initialize deltas: 
-    for(L = 0; L < Nlayers; L++){ 
-
-      for(a1=0; a1<Npe[L]; a1++){  
-        dB[L].set(a1, 0, learning_rate * rnd.uniform(0.0, 1.0) );
+  int n_patterns = inputs.n_cols;
+  int is_validation = (val_inputs.n_cols > 0);
 
-        for(a2=0; a2<Npe[L-1]; a2++){    
-          dW[L].set(a1, a2, learning_rate * rnd.uniform(0.0, 1.0) );
-        }// for a2
-      }// for a1
-    }// for L
 
-  }// RProp
+  ///============ Get the parameters ==================
+  ann_training_params prms;
+  prms.set_parameters(params);
+  prms.sanity_check(n_patterns);
 
+  reset_optimizer(rnd, prms);
 
+  if(prms.verbosity>0){
+    prms.show();
+    cout<<"n_patterns = "<<n_patterns<<endl;
+    cout<<"is_validation = "<<is_validation<<endl;
+  }// verbosity>0
 
-  if(!is_error_collect_frequency){ error_collect_frequency = steps_per_epoch;  }
 
-  MATRIX input_subset(sz_x, epoch_size);
-  MATRIX target_subset(sz_y, epoch_size);
-  vector<int> subset(epoch_size);
-  vector<int> inp_dim(sz_x); for(i=0; i<sz_x; i++){ inp_dim[i] = i; }
-  vector<int> tar_dim(sz_y); for(i=0; i<sz_y; i++){ tar_dim[i] = i; }
-  vector<MATRIX> Y;
+  vector<int> subset(prms.epoch_size);
+  if(prms.learning_class==3){ for(i=0; i<n_patterns; i++){ subset[i] = i; }  }
 
   int counter = 0;
   double err_loc = 0.0;
   vector<double> err;
 
-  if(verbosity>0){
-    cout<<"Training with parameters:\n";
-    cout<<"learning_method = "<<learning_method<<endl;
-    cout<<"learning_class = "<<learning_class<<endl;
-    cout<<"learning_rate = "<<learning_rate<<endl;
-    cout<<"momentum_term = "<<momentum_term<<endl;
-    cout<<"weight_decay_lambda = "<<weight_decay_lambda<<endl;
-    cout<<"etha = "<<etha<<endl;
-    cout<<"num_epochs = "<<num_epochs<<endl;
-    cout<<"steps_per_epoch = "<<steps_per_epoch<<endl;
-    cout<<"epoch_size = "<<epoch_size<<endl;
-    cout<<"n_patterns = "<<n_patterns<<endl;
-    cout<<"verbosity = "<<verbosity<<endl;
-    cout<<"is_error_collect_frequency = "<<is_error_collect_frequency<<endl;
-    cout<<"error_collect_frequency = "<<error_collect_frequency<<endl;
-    cout<<"a_plus = "<<a_plus<<endl;
-    cout<<"a_minus = "<<a_minus<<endl;
-    cout<<"dB_min = "<<dB_min<<endl;
-    cout<<"dB_max = "<<dB_max<<endl;
-    cout<<"dW_min = "<<dW_min<<endl;
-    cout<<"dW_max = "<<dW_max<<endl;
+  // L-BFGS state
+  vector< vector<double> > lbfgs_S, lbfgs_Y;
+  vector<double> lbfgs_rho, lbfgs_g;
+  double lbfgs_f = 0.0;
+  int lbfgs_stalled = 0;
 
+  // Early stopping state
+  vector<MATRIX> best_W, best_B;
+  double best_val = 0.0;
+  int best_epoch = -1;
+  int n_bad = 0;
 
-  }// verbosity>0
+  validation_error.clear();
 
 
   //===================================================================
    
-  for(epoch = 0; epoch < num_epochs; epoch++){    
-
-    for(i = 0; i < steps_per_epoch; i++){
-            
-        // Make a random selection of the training patterns
-        randperm(epoch_size, n_patterns, subset);
-        
-        // Extract the corresponding matrices from the inputs and outputs
-        pop_submatrix(inputs,  input_subset,  inp_dim, subset);
-        pop_submatrix(targets, target_subset, tar_dim, subset);
-
-        // Update gradients and outputs
-        Y = propagate(input_subset);
-        err_loc = back_propagate( Y, target_subset);
-
-        if(counter % error_collect_frequency ==0){  err.push_back( err_loc);       }
-       
-
-        // Update weights and biases
-        for(L = 0; L < Nlayers; L++){         
-
-          //***************************** BProp family ********************************
-          if(learning_class==1){ 
-
-            //======================= Compute deltas dW and dB ========================
-            // Momentum term is according to [1]
-            // Wight decay regularization + momentum: [2] 
-            // Here, dW and dB are understood as the momentum vectors
-            dW[L] = momentum_term * dWold[L] + etha * learning_rate * grad_w[L];
-            dB[L] = momentum_term * dBold[L] + etha * learning_rate * grad_b[L];
-
-            if(learning_method==11 || learning_method==13){
-              dW[L] += etha * learning_rate * weight_decay_lambda * W[L];
-              dB[L] += etha * learning_rate * weight_decay_lambda * B[L];
-            }
+  for(epoch = 0; epoch < prms.num_epochs; epoch++){    
 
-            //=========== Update step:  dW and dB are the momentum terms ==============
-            W[L] -= dW[L];
-            B[L] -= dB[L];
+    double lr = prms.learning_rate_at(epoch);
 
-            if(learning_method==12 || learning_method==14){
-              W[L] -=  etha * weight_decay_lambda * W[L];
-              B[L] -=  etha * weight_decay_lambda * B[L];
-            }
+    for(i = 0; i < prms.steps_per_epoch; i++){
 
-          }// BProp
+        //***************************** L-BFGS ********************************
+        if(prms.learning_class==3){
+          err_loc = lbfgs_step(prms, inputs, targets, subset, prms.num_threads, lbfgs_S, lbfgs_Y, lbfgs_rho, lbfgs_f, lbfgs_g, lbfgs_stalled);
+          if(lbfgs_stalled){
+            cout<<"Warning: L-BFGS can not decrease the error along the steepest descent direction at epoch "
+                <<epoch<<", the training stopped before convergence\n";
+            break;
+          }
+        }
+        else{
 
+          // Make a random selection of the training patterns
+          randperm(prms.epoch_size, n_patterns, subset);
 
-          //***************************** RProp family ********************************
-          // RProp   basic version: 
-          else if(learning_class==2){
+          // Update gradients, all the patterns of the batch at once
+          err_loc = batch_gradients(inputs, targets, subset, prms.num_threads);
 
-            // According to: [3], Eq. 1
-            for(a1=0; a1<Npe[L]; a1++){
-              // Biases:
-              double gr_prod = grad_b[L].get(a1, 0) * grad_b_old[L].get(a1,0);  // product of B gradients
+          // Update weights and biases
+          if(prms.learning_class==1){ 
+            if(prms.learning_method==13 || prms.learning_method==14){  adam_step(prms, lr);  }
+            else{  bprop_step(prms, lr);  }
+          }
+          else if(prms.learning_class==2){  rprop_step(prms);  }
 
-              // Scaling
-              if(gr_prod > 0.0 ){   dB[L].scale(a1, 0,  a_plus);  } 
-              else if(gr_prod < 0.0 ){ dB[L].scale(a1, 0, a_minus); }
-              else{  ;; } // don't change
+          for(L = 0; L < Nlayers; L++){         
+            dWold[L] = dW[L];
+            dBold[L] = dB[L];
 
+            grad_w_old[L] = grad_w[L];
+            grad_b_old[L] = grad_b[L];
+          }// for L - layers
 
-              //************ RProp- ****************
-              if(learning_method==2){
-
-                // Obey the bounds
-                if( dB[L].get(a1, 0) > dB_max ){  dB[L].set(a1, 0, dB_max); }
-                else if( dB[L].get(a1, 0) < dB_min ){  dB[L].set(a1, 0, dB_min); }
-
-                //Update the biases
-                B[L].add(a1, 0, -SIGN( grad_b[L].get(a1, 0) ) * dB[L].get(a1, 0) ); 
-
-              }// method == 2
-
-              //************ RProp+ ****************
-              //if(learning_method==21){ ;; }
-
-
-
-              // Weights 
-              for(a2=0; a2<Npe[L-1]; a2++){
-
-                gr_prod = grad_w[L].get(a1, a2) * grad_w_old[L].get(a1, a2);  // product of B gradients
-
-                // Scaling
-                if(gr_prod > 0.0 ){   dW[L].scale(a1, a2,  a_plus);  } 
-                else if(gr_prod < 0.0 ){ dW[L].scale(a1, a2, a_minus); }
-                else{  ;; } // don't change
-
-                //************ RProp- ****************
-                if(learning_method==2){
-
-                  // Obey the bounds
-                  if( dW[L].get(a1, a2) > dW_max ){  dW[L].set(a1, a2, dW_max); }
-                  else if( dW[L].get(a1, a2) < dW_min ){  dW[L].set(a1, a2, dW_min); }
-
-                  W[L].add(a1, a2, -SIGN( grad_w[L].get(a1, a2) ) * dW[L].get(a1, a2) ); 
-
-                }// method == 2
-                //************ RProp+ ****************
-                //if(learning_method==21){ ;; }
-
-
-              }// for a2
-            }// for a1
-
-          }// if RProp
-
-
-          dWold[L] = dW[L];
-          dBold[L] = dB[L];
-
-          grad_w_old[L] = grad_w[L];
-          grad_b_old[L] = grad_b[L];
-
-
-        }// for L - layers
+        }
 
+        if(counter % prms.error_collect_frequency ==0){  err.push_back( err_loc);       }
 
         counter++;
 
     }// for i
 
-    if(verbosity>=1){  
+    if(prms.verbosity>=1){  
       cout<<"epoch = "<<epoch<<" (local) error = "<<err_loc<<"\n"; 
     }
-    if(verbosity>=2){
+    if(prms.verbosity>=2){
       for(L = 0; L < Nlayers; L++){         
         cout<<"dW["<<L<<"] = "; dW[L].show_matrix(); cout<<endl;
       }// L
@@ -680,8 +518,31 @@ vector<double> NeuralNetwork::train(Random& rnd, bp::dict params, MATRIX& inputs
 
     }
 
+    //============ Validation and early stopping ==============
+    if(is_validation){
+      double val = batch_error(val_inputs, val_targets, prms.num_threads);
+      validation_error.push_back(val);
+
+      if(prms.verbosity>=1){  cout<<"epoch = "<<epoch<<" validation error = "<<val<<"\n";  }
+
+      if(best_epoch < 0 || val < best_val - prms.min_delta){
+        best_val = val;  best_epoch = epoch;  n_bad = 0;
+        best_W = W;  best_B = B;
+      }
+      else{
+        n_bad++;
+        if(prms.patience > 0 && n_bad >= prms.patience){
+          if(prms.verbosity>=1){  cout<<"Early stopping at epoch "<<epoch<<", the best epoch is "<<best_epoch<<"\n";  }
+          break;
+        }
+      }
+    }// is_validation
+
+    if(lbfgs_stalled){ break; }
+
   }// for epoch
 
+  if(is_validation && best_epoch >= 0){  W = best_W;  B = best_B;  }
 
   return err;
 
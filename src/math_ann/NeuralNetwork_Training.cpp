@@ -0,0 +1,886 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file NeuralNetwork_Training.cpp
+  \brief The mini-batch training engine of the ANN: the training hyperparameters, the batched
+  forward/backward passes (one matrix-matrix product per layer, OpenMP over the batch shards),
+  and the optimizers (BProp, Adam/AdamW, RProp-, L-BFGS)
+
+  References:
+
+  [1] http://page.mi.fu-berlin.de/rojas/neural/chapter/K8.pdf
+  [2] https://arxiv.org/pdf/1711.05101.pdf
+  [3] http://citeseerx.ist.psu.edu/viewdoc/summary?doi=10.1.1.17.1332
+  [4] Nocedal, J. Math. Comp. 1980, 35, 773 - L-BFGS two-loop recursion
+
+*/
+
+#if defined(USING_PCH)
+#include "../pch.h"
+#else
+#include <cmath>
+#endif
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "NeuralNetwork.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace boost;
+
+/// libann namespace
+namespace libann{
+
+
+
+ann_training_params::ann_training_params(){
+
+  learning_method = 1;
+  learning_class = 1;
+  learning_rate = 0.001;
+  momentum_term = 0.0;
+  weight_decay_lambda = 0.0;
+  etha = 1.0;
+
+  adam_beta1 = 0.9;
+  adam_beta2 = 0.999;
+  adam_eps = 1e-8;
+
+  a_plus = 1.1;
+  a_minus = 0.6;
+  dB_min =  0.1*learning_rate;
+  dB_max =  learning_rate;
+  dW_min =  0.1*learning_rate;
+  dW_max =  learning_rate;
+
+  lbfgs_memory = 10;
+  lbfgs_max_linesearch = 20;
+
+  lr_schedule = 0;
+  lr_decay = 1.0;
+  lr_step = 1;
+  lr_min = 0.0;
+
+  num_epochs = 1;
+  steps_per_epoch = 1;
+  epoch_size = 1;
+  verbosity = 0;
+  is_error_collect_frequency = 0;
+  error_collect_frequency = 1;
+
+  num_threads = 0;
+
+  patience = 0;
+  min_delta = 0.0;
+
+}
+
+
+void ann_training_params::set_parameters(bp::dict params){
+
+  std::string key;
+  for(int i=0;i<len(params.values());i++){
+    key = bp::extract<std::string>(params.keys()[i]);
+
+    if(key=="learning_rate") { learning_rate = bp::extract<double>(params.values()[i]); }
+    else if(key=="learning_method") { learning_method = bp::extract<int>(params.values()[i]);   }
+    else if(key=="momentum_term") { momentum_term = bp::extract<double>(params.values()[i]); }
+    else if(key=="weight_decay_lambda") { weight_decay_lambda = bp::extract<double>(params.values()[i]); }
+    else if(key=="etha") { etha = bp::extract<double>(params.values()[i]); }
+
+    else if(key=="adam_beta1") { adam_beta1 = bp::extract<double>(params.values()[i]); }
+    else if(key=="adam_beta2") { adam_beta2 = bp::extract<double>(params.values()[i]); }
+    else if(key=="adam_eps") { adam_eps = bp::extract<double>(params.values()[i]); }
+
+    else if(key=="a_plus") { a_plus = bp::extract<double>(params.values()[i]); }
+    else if(key=="a_minus") { a_minus = bp::extract<double>(params.values()[i]); }
+    else if(key=="dB_min") { dB_min = bp::extract<double>(params.values()[i]); }
+    else if(key=="dB_max") { dB_max = bp::extract<double>(params.values()[i]); }
+    else if(key=="dW_min") { dW_min = bp::extract<double>(params.values()[i]); }
+    else if(key=="dW_max") { dW_max = bp::extract<double>(params.values()[i]); }
+
+    else if(key=="lbfgs_memory") { lbfgs_memory = bp::extract<int>(params.values()[i]);   }
+    else if(key=="lbfgs_max_linesearch") { lbfgs_max_linesearch = bp::extract<int>(params.values()[i]);   }
+
+    else if(key=="lr_schedule") { lr_schedule = bp::extract<int>(params.values()[i]);   }
+    else if(key=="lr_decay") { lr_decay = bp::extract<double>(params.values()[i]); }
+    else if(key=="lr_step") { lr_step = bp::extract<int>(params.values()[i]);   }
+    else if(key=="lr_min") { lr_min = bp::extract<double>(params.values()[i]); }
+
+    else if(key=="num_epochs") { num_epochs = bp::extract<int>(params.values()[i]);   }
+    else if(key=="steps_per_epoch") { steps_per_epoch = bp::extract<int>(params.values()[i]);   }
+    else if(key=="epoch_size") { epoch_size = bp::extract<int>(params.values()[i]);   }
+    else if(key=="verbosity") { verbosity = bp::extract<int>(params.values()[i]);   }
+    else if(key=="error_collect_frequency") {
+      is_error_collect_frequency = 1;
+      error_collect_frequency = bp::extract<int>(params.values()[i]);
+    }
+    else if(key=="num_threads") { num_threads = bp::extract<int>(params.values()[i]);   }
+
+    else if(key=="patience") { patience = bp::extract<int>(params.values()[i]);   }
+    else if(key=="min_delta") { min_delta = bp::extract<double>(params.values()[i]); }
+
+  } // for i
+
+}
+
+
+void ann_training_params::sanity_check(int n_patterns){
+/**
+  Resolves the learning class and makes the batch setup consistent with the chosen method
+
+  \param[in] n_patterns - the total number of the training patterns
+*/
+
+  if(learning_method==1 || learning_method==11 || learning_method==12 || learning_method==13 || learning_method==14 ){
+    learning_class = 1;
+  }
+  else if(learning_method == 2 || learning_method == 21 || learning_method == 22 || learning_method == 23 ){
+    learning_class = 2;
+  }
+  else if(learning_method == 3){
+    learning_class = 3;
+  }
+  else{
+    cout<<"Error in ANN.train: learning_method = "<<learning_method<<" is not known\nExiting...\n"; exit(0);
+  }
+
+  // Implementation status
+  if(learning_method==21){  cout<<"The method 21 is not yet implemented: using 2 instead"; learning_method = 2;  }
+  if(learning_method==22){  cout<<"The method 22 is not yet implemented: using 2 instead"; learning_method = 2;  }
+  if(learning_method==23){  cout<<"The method 23 is not yet implemented: using 2 instead"; learning_method = 2;  }
+
+
+  // RProp and L-BFGS need the full-batch (deterministic) gradients
+  if(learning_class==2 || learning_class==3){
+    if(epoch_size!=n_patterns){
+      cout<<"WARNING in ANN.train : epoch_size ("<<epoch_size
+          <<") should be equal to the total number of patters ("<<n_patterns<<")\n";
+      epoch_size = n_patterns;
+      cout<<"Using new value of epoch_size = "<<epoch_size<<endl;
+    }
+  }
+
+  if(epoch_size > n_patterns){
+    cout<<"WARNING in ANN.train : epoch_size ("<<epoch_size
+        <<") is larger than the total number of patters ("<<n_patterns<<")\n";
+    epoch_size = n_patterns;
+    cout<<"Using new value of epoch_size = "<<epoch_size<<endl;
+  }
+
+  if(!is_error_collect_frequency){ error_collect_frequency = steps_per_epoch;  }
+  if(error_collect_frequency < 1){ error_collect_frequency = 1; }
+  if(lbfgs_memory < 1){ lbfgs_memory = 1; }
+  if(lr_step < 1){ lr_step = 1; }
+
+}
+
+
+double ann_training_params::learning_rate_at(int epoch){
+/**
+  The learning rate to use in a given epoch according to the selected schedule
+*/
+
+  double res = learning_rate;
+
+  if(lr_schedule==1){  res = learning_rate * pow(lr_decay, epoch);  }
+  else if(lr_schedule==2){  res = learning_rate * pow(lr_decay, epoch / lr_step);  }
+  else if(lr_schedule==3){
+    double frac = (num_epochs > 1) ? double(epoch)/double(num_epochs - 1) : 0.0;
+    res = lr_min + 0.5 * (learning_rate - lr_min) * (1.0 + cos(M_PI * frac));
+  }
+
+  return res;
+}
+
+
+void ann_training_params::show(){
+
+  cout<<"Training with parameters:\n";
+  cout<<"learning_method = "<<learning_method<<endl;
+  cout<<"learning_class = "<<learning_class<<endl;
+  cout<<"learning_rate = "<<learning_rate<<endl;
+  cout<<"momentum_term = "<<momentum_term<<endl;
+  cout<<"weight_decay_lambda = "<<weight_decay_lambda<<endl;
+  cout<<"etha = "<<etha<<endl;
+  cout<<"adam_beta1 = "<<adam_beta1<<endl;
+  cout<<"adam_beta2 = "<<adam_beta2<<endl;
+  cout<<"adam_eps = "<<adam_eps<<endl;
+  cout<<"lbfgs_memory = "<<lbfgs_memory<<endl;
+  cout<<"lbfgs_max_linesearch = "<<lbfgs_max_linesearch<<endl;
+  cout<<"lr_schedule = "<<lr_schedule<<endl;
+  cout<<"lr_decay = "<<lr_decay<<endl;
+  cout<<"lr_step = "<<lr_step<<endl;
+  cout<<"lr_min = "<<lr_min<<endl;
+  cout<<"num_epochs = "<<num_epochs<<endl;
+  cout<<"steps_per_epoch = "<<steps_per_epoch<<endl;
+  cout<<"epoch_size = "<<epoch_size<<endl;
+  cout<<"verbosity = "<<verbosity<<endl;
+  cout<<"is_error_collect_frequency = "<<is_error_collect_frequency<<endl;
+  cout<<"error_collect_frequency = "<<error_collect_frequency<<endl;
+  cout<<"num_threads = "<<num_threads<<endl;
+  cout<<"patience = "<<patience<<endl;
+  cout<<"min_delta = "<<min_delta<<endl;
+  cout<<"a_plus = "<<a_plus<<endl;
+  cout<<"a_minus = "<<a_minus<<endl;
+  cout<<"dB_min = "<<dB_min<<endl;
+  cout<<"dB_max = "<<dB_max<<endl;
+  cout<<"dW_min = "<<dW_min<<endl;
+  cout<<"dW_max = "<<dW_max<<endl;
+
+}
+
+
+
+
+//=================== Dense kernels on the row-major MATRIX storage ========================
+
+static void gemm_nn(int m, int n, int k, const double* A, const double* B, double* C){
+/**
+  C (m x n) = A (m x k) * B (k x n)
+
+  The innermost loop runs over the contiguous rows of B and C
+*/
+  for(int i=0; i<m; i++){
+    double* c = C + i*n;
+    for(int j=0; j<n; j++){ c[j] = 0.0; }
+
+    for(int p=0; p<k; p++){
+      double a = A[i*k + p];
+      const double* b = B + p*n;
+      for(int j=0; j<n; j++){ c[j] += a * b[j]; }
+    }
+  }
+}
+
+static void gemm_tn(int m, int n, int k, const double* A, const double* B, double* C){
+/**
+  C (m x n) = A^T * B,  A is (k x m), B is (k x n)
+*/
+  for(int i=0; i<m*n; i++){ C[i] = 0.0; }
+
+  for(int p=0; p<k; p++){
+    const double* a = A + p*m;
+    const double* b = B + p*n;
+    for(int i=0; i<m; i++){
+      double ai = a[i];
+      double* c = C + i*n;
+      for(int j=0; j<n; j++){ c[j] += ai * b[j]; }
+    }
+  }
+}
+
+static void gemm_nt(int m, int n, int k, const double* A, const double* B, double* C){
+/**
+  C (m x n) = A * B^T,  A is (m x k), B is (n x k)
+*/
+  for(int i=0; i<m; i++){
+    const double* a = A + i*k;
+    for(int j=0; j<n; j++){
+      const double* b = B + j*k;
+      double s = 0.0;
+      for(int p=0; p<k; p++){ s += a[p] * b[p]; }
+      C[i*n + j] = s;
+    }
+  }
+}
+
+
+
+static int number_of_shards(int sz, int nthreads){
+/**
+  The number of the batch shards to process in parallel: at most the number of the available
+  threads (or `nthreads`, if positive), and no fewer than 32 patterns per shard
+*/
+  int nth = 1;
+#if defined(_OPENMP)
+  nth = omp_get_max_threads();
+#endif
+  if(nthreads > 0 && nthreads < nth){ nth = nthreads; }
+
+  int ns = sz / 32;
+  if(ns < 1){ ns = 1; }
+  if(ns > nth){ ns = nth; }
+
+  return ns;
+}
+
+
+static double shard_pass(NeuralNetwork& ann, int s, MATRIX& inputs, MATRIX& targets, const int* cols, int nb, int do_grad){
+/**
+  Forward (and optionally backward) pass of the batch shard `s` made of the `nb` patterns (the columns `cols`
+  of the inputs and targets). Activations and deltas are stored as Npe[L] x nb blocks in the shard buffers
+
+  Returns the sum of the squared errors over the shard; if do_grad == 1, the shard gradients
+  sum_j delta[L](:,j) * Y[L-1](:,j)^T and sum_j delta[L](:,j) are placed in the shard_grad_w and shard_grad_b
+*/
+
+  int i, j, L;
+  int NL = ann.Nlayers - 1;
+  vector<int>& Npe = ann.Npe;
+  vector<MATRIX>& Y = ann.shard_Y[s];
+  vector<MATRIX>& delta = ann.shard_delta[s];
+
+  //========== Gather the inputs ============
+  int ncols = inputs.n_cols;
+  for(i=0; i<ann.sz_x; i++){
+    const double* src = inputs.M + i*ncols;
+    double* dst = Y[0].M + i*nb;
+    for(j=0; j<nb; j++){ dst[j] = src[cols[j]]; }
+  }
+
+  //========== Forward: one product per layer ============
+  for(L=1; L<=NL; L++){
+    gemm_nn(Npe[L], nb, Npe[L-1], ann.W[L].M, Y[L-1].M, Y[L].M);
+
+    for(i=0; i<Npe[L]; i++){
+      double b = ann.B[L].M[i];
+      double* y = Y[L].M + i*nb;
+      for(j=0; j<nb; j++){ y[j] = tanh(y[j] + b); }
+    }
+  }
+
+  //========== Output deltas ============
+  double err = 0.0;
+  ncols = targets.n_cols;
+  for(i=0; i<ann.sz_y; i++){
+    const double* src = targets.M + i*ncols;
+    const double* y = Y[NL].M + i*nb;
+    double* d = delta[NL].M + i*nb;
+    for(j=0; j<nb; j++){
+      d[j] = src[cols[j]] - y[j];
+      err += d[j] * d[j];
+    }
+  }
+
+  if(!do_grad){ return err; }
+
+  // The output layer also has the tanh transfer function
+  double* dNL = delta[NL].M;
+  const double* yNL = Y[NL].M;
+  for(i=0; i<Npe[NL]*nb; i++){ dNL[i] *= (1.0 - yNL[i] * yNL[i]); }
+
+  //========== Backward ============
+  for(L=NL-1; L>0; L--){
+    gemm_tn(Npe[L], nb, Npe[L+1], ann.W[L+1].M, delta[L+1].M, delta[L].M);
+
+    double* d = delta[L].M;
+    const double* y = Y[L].M;
+    for(i=0; i<Npe[L]*nb; i++){ d[i] *= (1.0 - y[i] * y[i]); }
+  }
+
+  //========== Shard gradients ============
+  for(L=1; L<=NL; L++){
+    gemm_nt(Npe[L], Npe[L-1], nb, delta[L].M, Y[L-1].M, ann.shard_grad_w[s][L].M);
+
+    for(i=0; i<Npe[L]; i++){
+      const double* d = delta[L].M + i*nb;
+      double sum = 0.0;
+      for(j=0; j<nb; j++){ sum += d[j]; }
+      ann.shard_grad_b[s][L].M[i] = sum;
+    }
+  }
+
+  return err;
+
+}
+
+
+
+void NeuralNetwork::allocate_batch_buffers(int batch_size, int nshards){
+/**
+  Allocates the activation, delta and partial gradient buffers for `nshards` shards of a batch of
+  `batch_size` patterns. The existing buffers are reused if they are large enough
+*/
+
+  int s, L;
+  int cap = (batch_size + nshards - 1) / nshards;
+
+  if((int)shard_Y.size() >= nshards && shard_capacity >= cap){ return; }
+
+  if(cap < shard_capacity){ cap = shard_capacity; }
+  if(nshards < (int)shard_Y.size()){ nshards = shard_Y.size(); }
+
+  shard_Y = vector< vector<MATRIX> >(nshards);
+  shard_delta = vector< vector<MATRIX> >(nshards);
+  shard_grad_w = vector< vector<MATRIX> >(nshards);
+  shard_grad_b = vector< vector<MATRIX> >(nshards);
+
+  for(s=0; s<nshards; s++){
+    for(L=0; L<Nlayers; L++){
+      shard_Y[s].push_back(MATRIX(Npe[L], cap));
+      shard_delta[s].push_back(MATRIX(Npe[L], cap));
+      shard_grad_w[s].push_back(MATRIX(Npe[L], (L>0 ? Npe[L-1] : Npe[0]) ));
+      shard_grad_b[s].push_back(MATRIX(Npe[L], 1));
+    }
+  }
+
+  shard_capacity = cap;
+
+}
+
+
+
+double NeuralNetwork::batch_gradients(MATRIX& inputs, MATRIX& targets, vector<int>& subset, int nthreads){
+/**
+  Computes the gradients of the error w.r.t. the weights and biases (grad_w, grad_b) averaged over
+  the patterns `subset` - the columns of the inputs and targets
+
+  The batch is split into shards processed in parallel; each shard runs the whole batch through
+  the layers as matrices, the shard gradients are then summed up
+
+  \param[in] inputs - sz_x x n_patterns matrix of all the inputs
+  \param[in] targets - sz_y x n_patterns matrix of all the targets
+  \param[in] subset - the indices of the patterns in the batch
+  \param[in] nthreads - the max number of the shards (threads); 0 - all available threads
+
+  Returns: the error 0.5 / sz * sum_j |target_j - output_j|^2 over the batch, same as in back_propagate
+*/
+
+  int sz = subset.size();
+  int nshards = number_of_shards(sz, nthreads);
+  int chunk = (sz + nshards - 1) / nshards;
+  int s, L, k;
+
+  allocate_batch_buffers(sz, nshards);
+
+  double err = 0.0;
+
+  #pragma omp parallel for num_threads(nshards) reduction(+:err)
+  for(s=0; s<nshards; s++){
+    int c0 = s * chunk;
+    int nb = sz - c0; if(nb > chunk){ nb = chunk; }
+    if(nb > 0){ err += shard_pass(*this, s, inputs, targets, &subset[c0], nb, 1); }
+    else{
+      for(int l=1; l<Nlayers; l++){ shard_grad_w[s][l] = 0.0; shard_grad_b[s][l] = 0.0; }
+    }
+  }
+
+  //========= Reduce the shard gradients ===========
+  double scl = -1.0/double(sz);
+  for(L=1; L<Nlayers; L++){
+    double* gw = grad_w[L].M;
+    double* gb = grad_b[L].M;
+
+    for(k=0; k<grad_w[L].n_elts; k++){ gw[k] = shard_grad_w[0][L].M[k]; }
+    for(k=0; k<grad_b[L].n_elts; k++){ gb[k] = shard_grad_b[0][L].M[k]; }
+
+    for(s=1; s<nshards; s++){
+      for(k=0; k<grad_w[L].n_elts; k++){ gw[k] += shard_grad_w[s][L].M[k]; }
+      for(k=0; k<grad_b[L].n_elts; k++){ gb[k] += shard_grad_b[s][L].M[k]; }
+    }
+
+    for(k=0; k<grad_w[L].n_elts; k++){ gw[k] *= scl; }
+    for(k=0; k<grad_b[L].n_elts; k++){ gb[k] *= scl; }
+  }
+
+  return err * (0.5/double(sz));
+
+}
+
+
+
+double NeuralNetwork::batch_error(MATRIX& inputs, MATRIX& targets, int nthreads){
+/**
+  The error of the prediction, 0.5 / n_patterns * sum_j |target_j - output_j|^2, computed by
+  the batched forward pass in blocks of patterns (so the buffers stay bounded for large data sets)
+*/
+
+  if(inputs.n_rows!=sz_x){
+    std::cout<<"Error: Size of the input "<<inputs.n_rows<<" does not match the ANN architecture "<<sz_x<<std::endl;
+    exit(0);
+  }
+  if(targets.n_rows!=sz_y){
+    std::cout<<"Error: Size of the target output "<<targets.n_rows<<" does not match the ANN architecture "<<sz_y<<std::endl;
+    exit(0);
+  }
+  if(targets.n_cols!=inputs.n_cols){
+    std::cout<<"Error: The number of patterns is different for inputs "<<inputs.n_cols<<" and targets "<<targets.n_cols<<std::endl;
+    exit(0);
+  }
+
+  int sz = inputs.n_cols;
+  int nshards = number_of_shards(sz, nthreads);
+  int per_shard = (shard_capacity > 256) ? shard_capacity : 256;
+  int block = nshards * per_shard;
+  int s, start;
+
+  allocate_batch_buffers(block, nshards);
+
+  vector<int> cols(sz);
+  for(s=0; s<sz; s++){ cols[s] = s; }
+
+  double err = 0.0;
+
+  for(start=0; start<sz; start+=block){
+    #pragma omp parallel for num_threads(nshards) reduction(+:err)
+    for(s=0; s<nshards; s++){
+      int c0 = start + s * per_shard;
+      int nb = sz - c0; if(nb > per_shard){ nb = per_shard; }
+      if(nb > 0){ err += shard_pass(*this, s, inputs, targets, &cols[c0], nb, 0); }
+    }
+  }
+
+  return err * (0.5/double(sz));
+
+}
+
+
+
+
+void NeuralNetwork::reset_optimizer(Random& rnd, ann_training_params& prms){
+/**
+  Prepares the optimizer state at the beginning of the training
+*/
+
+  int L, a1, a2;
+
+  // Networks created by load() or by the older versions may not have the Adam moments
+  if((int)mW.size()!=Nlayers){
+    mW = vW = grad_w;
+    mB = vB = grad_b;
+    adam_t = 0;
+  }
+
+  if(prms.learning_class==1){ // Backprop setups
+
+    for(L = 0; L < Nlayers; L++){
+      dBold[L] = dB[L];
+      dWold[L] = dW[L];
+    }// for L
+
+    if(prms.learning_method==13 || prms.learning_method==14){
+      for(L = 0; L < Nlayers; L++){
+        mW[L] = 0.0;  vW[L] = 0.0;
+        mB[L] = 0.0;  vB[L] = 0.0;
+      }
+      adam_t = 0;
+    }
+
+  }
+  else if(prms.learning_class==2){   // RProp setups
+
+    // Initialize deltas:
+    for(L = 1; L < Nlayers; L++){
+
+      for(a1=0; a1<Npe[L]; a1++){
+        dB[L].set(a1, 0, prms.learning_rate * rnd.uniform(0.0, 1.0) );
+
+        for(a2=0; a2<Npe[L-1]; a2++){
+          dW[L].set(a1, a2, prms.learning_rate * rnd.uniform(0.0, 1.0) );
+        }// for a2
+      }// for a1
+    }// for L
+
+  }// RProp
+
+}
+
+
+
+static void bprop_update(double* x, double* d, const double* dold, const double* g, int n, ann_training_params& prms, double lr){
+
+  double a = prms.etha * lr;
+  double lambda = prms.weight_decay_lambda;
+
+  for(int k=0; k<n; k++){
+    // Momentum term is according to [1]
+    // Wight decay regularization + momentum: [2]
+    // Here, dW and dB are understood as the momentum vectors
+    d[k] = prms.momentum_term * dold[k] + a * g[k];
+    if(prms.learning_method==11){  d[k] += a * lambda * x[k];  }
+
+    x[k] -= d[k];
+    if(prms.learning_method==12){  x[k] -= prms.etha * lambda * x[k];  }
+  }
+
+}
+
+void NeuralNetwork::bprop_step(ann_training_params& prms, double lr){
+/**
+  BProp update (learning methods 1, 11, 12) - Algorithm 1 of [2]
+*/
+
+  for(int L = 1; L < Nlayers; L++){
+    bprop_update(W[L].M, dW[L].M, dWold[L].M, grad_w[L].M, W[L].n_elts, prms, lr);
+    bprop_update(B[L].M, dB[L].M, dBold[L].M, grad_b[L].M, B[L].n_elts, prms, lr);
+  }
+
+}
+
+
+static void adam_update(double* x, double* d, double* m, double* v, const double* g, int n,
+                        ann_training_params& prms, double lr, double bc1, double bc2){
+
+  double b1 = prms.adam_beta1;
+  double b2 = prms.adam_beta2;
+  double lambda = prms.weight_decay_lambda;
+
+  for(int k=0; k<n; k++){
+    double gk = g[k];
+    if(prms.learning_method==13){ gk += lambda * x[k]; } // L2 regularization
+
+    m[k] = b1 * m[k] + (1.0 - b1) * gk;
+    v[k] = b2 * v[k] + (1.0 - b2) * gk * gk;
+
+    d[k] = lr * (m[k]/bc1) / (sqrt(v[k]/bc2) + prms.adam_eps);
+    if(prms.learning_method==14){ d[k] += lambda * x[k]; } // decoupled decay
+
+    d[k] *= prms.etha;
+    x[k] -= d[k];
+  }
+
+}
+
+void NeuralNetwork::adam_step(ann_training_params& prms, double lr){
+/**
+  Adam (13) and AdamW (14) updates - Algorithm 2 of [2]; dW and dB are set to the steps taken
+*/
+
+  adam_t++;
+  double bc1 = 1.0 - pow(prms.adam_beta1, adam_t);
+  double bc2 = 1.0 - pow(prms.adam_beta2, adam_t);
+
+  for(int L = 1; L < Nlayers; L++){
+    adam_update(W[L].M, dW[L].M, mW[L].M, vW[L].M, grad_w[L].M, W[L].n_elts, prms, lr, bc1, bc2);
+    adam_update(B[L].M, dB[L].M, mB[L].M, vB[L].M, grad_b[L].M, B[L].n_elts, prms, lr, bc1, bc2);
+  }
+
+}
+
+
+static void rprop_update(double* x, double* d, const double* g, const double* gold, int n,
+                         double d_min, double d_max, ann_training_params& prms){
+
+  for(int k=0; k<n; k++){
+    double gr_prod = g[k] * gold[k];
+
+    // Scaling
+    if(gr_prod > 0.0 ){   d[k] *= prms.a_plus;  }
+    else if(gr_prod < 0.0 ){ d[k] *= prms.a_minus; }
+
+    // Obey the bounds
+    if( d[k] > d_max ){  d[k] = d_max; }
+    else if( d[k] < d_min ){  d[k] = d_min; }
+
+    x[k] -= SIGN( g[k] ) * d[k];
+  }
+
+}
+
+void NeuralNetwork::rprop_step(ann_training_params& prms){
+/**
+  RProp- update (learning method 2) - [3], Eq. 1
+*/
+
+  for(int L = 1; L < Nlayers; L++){
+    rprop_update(W[L].M, dW[L].M, grad_w[L].M, grad_w_old[L].M, W[L].n_elts, prms.dW_min, prms.dW_max, prms);
+    rprop_update(B[L].M, dB[L].M, grad_b[L].M, grad_b_old[L].M, B[L].n_elts, prms.dB_min, prms.dB_max, prms);
+  }
+
+}
+
+
+
+
+int NeuralNetwork::num_parameters(){
+
+  int res = 0;
+  for(int L = 1; L < Nlayers; L++){  res += W[L].n_elts + B[L].n_elts;  }
+
+  return res;
+}
+
+void NeuralNetwork::get_parameters(vector<double>& x){
+
+  int L, k, n = 0;
+  x.resize(num_parameters());
+
+  for(L = 1; L < Nlayers; L++){
+    for(k=0; k<W[L].n_elts; k++, n++){ x[n] = W[L].M[k]; }
+    for(k=0; k<B[L].n_elts; k++, n++){ x[n] = B[L].M[k]; }
+  }
+}
+
+void NeuralNetwork::set_parameters(vector<double>& x){
+
+  int L, k, n = 0;
+
+  if((int)x.size()!=num_parameters()){
+    cout<<"Error in NeuralNetwork::set_parameters: the size of the input ("<<x.size()
+        <<") is not equal to the number of the ANN parameters ("<<num_parameters()<<")\nExiting...\n";
+    exit(0);
+  }
+
+  for(L = 1; L < Nlayers; L++){
+    for(k=0; k<W[L].n_elts; k++, n++){ W[L].M[k] = x[n]; }
+    for(k=0; k<B[L].n_elts; k++, n++){ B[L].M[k] = x[n]; }
+  }
+}
+
+void NeuralNetwork::get_gradients(vector<double>& g){
+
+  int L, k, n = 0;
+  g.resize(num_parameters());
+
+  for(L = 1; L < Nlayers; L++){
+    for(k=0; k<grad_w[L].n_elts; k++, n++){ g[n] = grad_w[L].M[k]; }
+    for(k=0; k<grad_b[L].n_elts; k++, n++){ g[n] = grad_b[L].M[k]; }
+  }
+}
+
+
+
+static double dot(vector<double>& a, vector<double>& b){
+  double res = 0.0;
+  for(int k=0; k<(int)a.size(); k++){ res += a[k] * b[k]; }
+  return res;
+}
+
+
+static double lbfgs_objective(NeuralNetwork& ann, ann_training_params& prms, MATRIX& inputs, MATRIX& targets,
+                              vector<int>& subset, int nthreads, vector<double>& x, vector<double>& g){
+/**
+  The L-BFGS objective at the parameters x: the batch error plus the L2 penalty 0.5 * lambda * |x|^2
+  The gradient is returned in g
+*/
+
+  ann.set_parameters(x);
+  double f = ann.batch_gradients(inputs, targets, subset, nthreads);
+  ann.get_gradients(g);
+
+  if(prms.weight_decay_lambda > 0.0){
+    for(int k=0; k<(int)x.size(); k++){
+      f += 0.5 * prms.weight_decay_lambda * x[k] * x[k];
+      g[k] += prms.weight_decay_lambda * x[k];
+    }
+  }
+
+  return f;
+}
+
+
+double NeuralNetwork::lbfgs_step(ann_training_params& prms, MATRIX& inputs, MATRIX& targets, vector<int>& subset, int nthreads,
+                                 vector< vector<double> >& S, vector< vector<double> >& Y, vector<double>& rho,
+                                 double& f, vector<double>& g, int& is_stalled){
+/**
+  One L-BFGS iteration [4] with the backtracking (Armijo) line search
+
+  \param[in,out] S, Y, rho - the stored correction pairs s_k = x_{k+1} - x_k, y_k = g_{k+1} - g_k, rho_k = 1/(y_k^T s_k)
+  \param[in,out] f, g - the objective and its gradient at the current parameters; if g is empty,
+  they are computed here
+  \param[out] is_stalled - set to 1 if the line search failed along the steepest descent direction,
+  so the further iterations can not make any progress; 0 otherwise
+
+  Returns: the objective after the step
+*/
+
+  int k;
+  int n = num_parameters();
+  vector<double> x0, x, g_new;
+
+  is_stalled = 0;
+
+  get_parameters(x0);
+  if((int)g.size()!=n){  f = lbfgs_objective(*this, prms, inputs, targets, subset, nthreads, x0, g);  }
+
+  //========== Two-loop recursion: d = -H * g ============
+  int m = S.size();
+  vector<double> d(g);
+  vector<double> alpha(m, 0.0);
+
+  for(k=m-1; k>=0; k--){
+    alpha[k] = rho[k] * dot(S[k], d);
+    for(int i=0; i<n; i++){ d[i] -= alpha[k] * Y[k][i]; }
+  }
+
+  double gamma = 1.0;
+  if(m>0){  gamma = dot(S[m-1], Y[m-1]) / dot(Y[m-1], Y[m-1]);  }
+  for(int i=0; i<n; i++){ d[i] *= gamma; }
+
+  for(k=0; k<m; k++){
+    double beta = rho[k] * dot(Y[k], d);
+    for(int i=0; i<n; i++){ d[i] += (alpha[k] - beta) * S[k][i]; }
+  }
+  for(int i=0; i<n; i++){ d[i] = -d[i]; }
+
+  double gd = dot(g, d);
+  double gnorm = sqrt(dot(g, g));
+
+  // Not a descent direction: restart from the steepest descent
+  if(gd >= 0.0){
+    S.clear(); Y.clear(); rho.clear(); m = 0;
+    for(int i=0; i<n; i++){ d[i] = -g[i]; }
+    gd = -gnorm * gnorm;
+  }
+
+  double step = 1.0;
+  if(m==0 && gnorm > 0.0){  step = (1.0/gnorm < 1.0) ? 1.0/gnorm : 1.0;  }
+
+  //========== Backtracking line search ============
+  int is_accepted = 0;
+  double f_new = f;
+  x.resize(n);
+
+  for(int it=0; it<prms.lbfgs_max_linesearch; it++){
+    for(int i=0; i<n; i++){ x[i] = x0[i] + step * d[i]; }
+    f_new = lbfgs_objective(*this, prms, inputs, targets, subset, nthreads, x, g_new);
+
+    if(f_new <= f + 1e-4 * step * gd){ is_accepted = 1; break; }
+    step *= 0.5;
+  }
+
+  if(!is_accepted){
+    // Keep the old point. If the direction came from the curvature information, forget it and
+    // restart from the steepest descent; if it was the steepest descent already, retrying the
+    // same direction can not help
+    set_parameters(x0);
+    if(m==0){  is_stalled = 1;  }
+    S.clear(); Y.clear(); rho.clear();
+    if(prms.verbosity>=2 && !is_stalled){ cout<<"L-BFGS: the line search failed, restarting\n"; }
+    return f;
+  }
+
+  //========== Update the correction pairs ============
+  vector<double> s_k(n), y_k(n);
+  for(int i=0; i<n; i++){
+    s_k[i] = step * d[i];
+    y_k[i] = g_new[i] - g[i];
+  }
+  double sy = dot(s_k, y_k);
+
+  if(sy > 1e-12 * sqrt(dot(s_k, s_k) * dot(y_k, y_k)) ){
+    S.push_back(s_k);
+    Y.push_back(y_k);
+    rho.push_back(1.0/sy);
+
+    if((int)S.size() > prms.lbfgs_memory){
+      S.erase(S.begin());
+      Y.erase(Y.begin());
+      rho.erase(rho.begin());
+    }
+  }
+
+  f = f_new;
+  g = g_new;
+
+  return f;
+
+}
+
+
+
+}// namespace libann
+}// namespace liblibra
@@ -45,6 +45,14 @@ void export_NeuralNetwork_objects(){
 
   vector<double> (NeuralNetwork::*expt_train_v1)
   (Random& rnd, bp::dict params, MATRIX& inputs, MATRIX& targets) = &NeuralNetwork::train;
+  vector<double> (NeuralNetwork::*expt_train_v2)
+  (Random& rnd, bp::dict params, MATRIX& inputs, MATRIX& targets,
+   MATRIX& val_inputs, MATRIX& val_targets) = &NeuralNetwork::train;
+
+  double (NeuralNetwork::*expt_batch_gradients_v1)
+  (MATRIX& inputs, MATRIX& targets, vector<int>& subset, int nthreads) = &NeuralNetwork::batch_gradients;
+  double (NeuralNetwork::*expt_batch_error_v1)
+  (MATRIX& inputs, MATRIX& targets, int nthreads) = &NeuralNetwork::batch_error;
 
 
   void (NeuralNetwork::*expt_save_v1)(std::string filename) = &NeuralNetwork::save;
@@ -68,6 +76,10 @@ void export_NeuralNetwork_objects(){
       .def("back_propagate",expt_back_propagate_v1)
       .def("error",expt_error_v1)
       .def("train",expt_train_v1)
+      .def("train",expt_train_v2)
+      .def("batch_gradients",expt_batch_gradients_v1)
+      .def("batch_error",expt_batch_error_v1)
+      .def("num_parameters",&NeuralNetwork::num_parameters)
          
       .def_readwrite("B",&NeuralNetwork::B)
       .def_readwrite("grad_b",&NeuralNetwork::grad_b)
@@ -83,6 +95,12 @@ void export_NeuralNetwork_objects(){
       .def_readwrite("Npe",&NeuralNetwork::Npe)
       .def_readwrite("sz_x",&NeuralNetwork::sz_x)
       .def_readwrite("sz_y",&NeuralNetwork::sz_y)
+      .def_readwrite("mW",&NeuralNetwork::mW)
+      .def_readwrite("vW",&NeuralNetwork::vW)
+      .def_readwrite("mB",&NeuralNetwork::mB)
+      .def_readwrite("vB",&NeuralNetwork::vB)
+      .def_readwrite("adam_t",&NeuralNetwork::adam_t)
+      .def_readwrite("validation_error",&NeuralNetwork::validation_error)
        
       .enable_pickling()
   ;
@@ -0,0 +1,591 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+
+#include <limits>
+#include "DATA_stream.h"
+
+//=========================== DATA_stream class ================================
+
+/// liblibra namespace
+namespace liblibra{
+
+/// libdata namespace
+namespace libdata{
+
+
+DATA_stream::DATA_stream(){
+
+  max_levels = 32;
+  is_histogram = 0;
+  hist_min = 0.0;
+  hist_max = 1.0;
+  hist_nbins = 0;
+  is_store_series = 0;
+
+  reset();
+}
+
+DATA_stream::DATA_stream(int _max_levels){
+
+  if(_max_levels<1){
+    cout<<"Error in DATA_stream: max_levels = "<<_max_levels<<" must be positive\nExiting...\n";
+    exit(0);
+  }
+
+  max_levels = _max_levels;
+  is_histogram = 0;
+  hist_min = 0.0;
+  hist_max = 1.0;
+  hist_nbins = 0;
+  is_store_series = 0;
+
+  reset();
+}
+
+
+void DATA_stream::reset(){
+/**
+  Forget all the samples, but keep the settings (max_levels, histogram
+  range, is_store_series)
+*/
+
+  n = 0;
+  ave = 0.0;
+  M2 = 0.0;
+  sum = 0.0;
+  sum_comp = 0.0;
+  mae_sum = 0.0;
+  is_mae = 1;
+  min_val = 0.0;
+  max_val = 0.0;
+
+  block_n = vector<long>(max_levels, 0);
+  block_ave = vector<double>(max_levels, 0.0);
+  block_M2 = vector<double>(max_levels, 0.0);
+  block_pending = vector<double>(max_levels, 0.0);
+  is_block_pending = vector<int>(max_levels, 0);
+
+  hist = vector<double>(hist_nbins, 0.0);
+  hist_underflow = 0.0;
+  hist_overflow = 0.0;
+
+  series.clear();
+}
+
+
+void DATA_stream::set_histogram(double _hist_min, double _hist_max, int _hist_nbins){
+/**
+  Start accumulating the histogram with _hist_nbins equal bins on [_hist_min, _hist_max)
+  The samples added before this call are not binned.
+*/
+
+  if(_hist_nbins<1 || _hist_max<=_hist_min){
+    cout<<"Error in DATA_stream::set_histogram: invalid binning, hist_min = "<<_hist_min
+        <<" hist_max = "<<_hist_max<<" hist_nbins = "<<_hist_nbins<<"\nExiting...\n";
+    exit(0);
+  }
+
+  is_histogram = 1;
+  hist_min = _hist_min;
+  hist_max = _hist_max;
+  hist_nbins = _hist_nbins;
+
+  hist = vector<double>(hist_nbins, 0.0);
+  hist_underflow = 0.0;
+  hist_overflow = 0.0;
+}
+
+
+void DATA_stream::push_block(int lev, double x){
+/**
+  Add the block average x (of 2^lev samples) to the blocking level lev.
+  Every second block at this level is pair-averaged and sent one level up.
+*/
+
+  while(lev<max_levels){
+
+    block_n[lev]++;
+    double d = x - block_ave[lev];
+    block_ave[lev] += d/double(block_n[lev]);
+    block_M2[lev] += d*(x - block_ave[lev]);
+
+    if(!is_block_pending[lev]){
+      block_pending[lev] = x;
+      is_block_pending[lev] = 1;
+      break;
+    }
+
+    x = 0.5*(block_pending[lev] + x);
+    is_block_pending[lev] = 0;
+    lev++;
+  }
+
+}
+
+
+void DATA_stream::add(double x){
+
+  if(n==0){ min_val = max_val = x; }
+  else{
+    if(x<min_val){ min_val = x; }
+    if(x>max_val){ max_val = x; }
+  }
+
+  // Welford update
+  n++;
+  double d = x - ave;
+  ave += d/double(n);
+  M2 += d*(x - ave);
+  mae_sum += fabs(x - ave);
+
+  // Kahan summation
+  double y = x - sum_comp;
+  double t = sum + y;
+  sum_comp = (t - sum) - y;
+  sum = t;
+
+  // Blocking
+  push_block(0, x);
+
+  // Histogram
+  if(is_histogram){
+    if(x<hist_min){ hist_underflow += 1.0; }
+    else if(x>=hist_max){ hist_overflow += 1.0; }
+    else{
+      int b = int( (x - hist_min) * hist_nbins / (hist_max - hist_min) );
+      if(b>=hist_nbins){ b = hist_nbins-1; }
+      hist[b] += 1.0;
+    }
+  }
+
+  if(is_store_series){ series.push_back(x); }
+
+}
+
+void DATA_stream::add(vector<double>& x){
+
+  for(int i=0;i<x.size();i++){ add(x[i]); }
+
+}
+
+void DATA_stream::add(boost::python::list x){
+
+  int sz = boost::python::len(x);
+  for(int i=0;i<sz;i++){ add( (double)boost::python::extract<double>(x[i]) ); }
+
+}
+
+
+void DATA_stream::merge(const DATA_stream& other){
+/**
+  Combine the statistics of another accumulator into this one, as if all the
+  samples of `other` were added after the samples of this object.
+
+  The moments and the histogram are merged exactly. The blocking levels are
+  merged exactly for the completed blocks; the half-complete blocks of the two
+  accumulators are paired with each other (so a few blocks straddle the
+  boundary between the two series, which is harmless for independent
+  trajectories).
+
+  The approximate mae can not be merged (it is built with the running means of
+  the two series), so it is not available after this call.
+*/
+
+  if(other.max_levels!=max_levels){
+    cout<<"Error in DATA_stream::merge: max_levels differ ("<<max_levels<<" vs. "<<other.max_levels<<")\nExiting...\n";
+    exit(0);
+  }
+  if(is_histogram!=other.is_histogram || (is_histogram &&
+     (hist_nbins!=other.hist_nbins || hist_min!=other.hist_min || hist_max!=other.hist_max) ) ){
+    cout<<"Error in DATA_stream::merge: the histogram settings differ\nExiting...\n";
+    exit(0);
+  }
+
+  if(other.n==0){ return; }
+  if(n==0){
+    vector<double> _series(series);
+    *this = other;
+    if(is_store_series){ series.insert(series.begin(), _series.begin(), _series.end()); }
+    return;
+  }
+
+  int k;
+
+  // Moments: Chan et al. pairwise update
+  double na = double(n);
+  double nb = double(other.n);
+  double nab = na + nb;
+  double d = other.ave - ave;
+
+  ave += d*nb/nab;
+  M2 += other.M2 + d*d*na*nb/nab;
+  mae_sum = 0.0;
+  is_mae = 0;
+  n += other.n;
+
+  if(other.min_val<min_val){ min_val = other.min_val; }
+  if(other.max_val>max_val){ max_val = other.max_val; }
+
+  // Kahan-compensated sum: add the other's sum and its compensation
+  double y = (other.sum - other.sum_comp) - sum_comp;
+  double t = sum + y;
+  sum_comp = (t - sum) - y;
+  sum = t;
+
+  // Blocking: completed blocks
+  for(k=0;k<max_levels;k++){
+    if(other.block_n[k]==0){ continue; }
+    if(block_n[k]==0){
+      block_n[k] = other.block_n[k];
+      block_ave[k] = other.block_ave[k];
+      block_M2[k] = other.block_M2[k];
+    }
+    else{
+      na = double(block_n[k]);
+      nb = double(other.block_n[k]);
+      nab = na + nb;
+      d = other.block_ave[k] - block_ave[k];
+      block_ave[k] += d*nb/nab;
+      block_M2[k] += other.block_M2[k] + d*d*na*nb/nab;
+      block_n[k] += other.block_n[k];
+    }
+  }
+
+  // Blocking: pending halves. A pending value has been counted at its own
+  // level already, so the pair average only goes to the next level
+  for(k=0;k<max_levels;k++){
+    if(!other.is_block_pending[k]){ continue; }
+
+    if(is_block_pending[k]){
+      is_block_pending[k] = 0;
+      if(k+1<max_levels){ push_block(k+1, 0.5*(block_pending[k] + other.block_pending[k])); }
+    }
+    else{
+      block_pending[k] = other.block_pending[k];
+      is_block_pending[k] = 1;
+    }
+  }
+
+  // Histogram
+  if(is_histogram){
+    for(k=0;k<hist_nbins;k++){ hist[k] += other.hist[k]; }
+    hist_underflow += other.hist_underflow;
+    hist_overflow += other.hist_overflow;
+  }
+
+  if(is_store_series){ series.insert(series.end(), other.series.begin(), other.series.end()); }
+
+}
+
+
+double DATA_stream::get_sum(){  return sum;  }
+
+double DATA_stream::get_var(){
+
+  if(n<2){
+    std::cout<<"Warning: Data size is less than 2. Can not calculate statistics for such data\n";
+    return 0.0;
+  }
+  return M2/double(n-1);
+}
+
+double DATA_stream::get_sd(){  return sqrt(get_var());  }
+
+double DATA_stream::get_se(){  return (n>0) ? get_sd()/sqrt(double(n)) : 0.0;  }
+
+double DATA_stream::get_mse(){  return (n>0) ? M2/double(n) : 0.0;  }
+
+double DATA_stream::get_mae(){
+/**
+  Single-pass approximation of the mean absolute error: the deviations are taken from the
+  running mean. Returns NaN for the merged accumulators
+*/
+
+  if(!is_mae){
+    std::cout<<"Warning: DATA_stream::get_mae - the mae is not available for the merged accumulators\n";
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  return (n>0) ? mae_sum/double(n) : 0.0;
+}
+
+double DATA_stream::get_rmse(){  return sqrt(get_mse());  }
+
+int DATA_stream::Calculate_Estimators(double& Ave, double& Var, double& Sd,double& Se, double& Mse, double& Mae,double& Rmse){
+
+  Ave = ave;
+  Var = get_var();
+  Sd = sqrt(Var);
+  Se = (n>0) ? Sd/sqrt(double(n)) : 0.0;
+  Mse = get_mse();
+  Mae = get_mae();
+  Rmse = sqrt(Mse);
+
+  return 0;
+}
+
+
+vector<double> DATA_stream::blocking_se(){
+/**
+  Returns the standard error of the mean estimated from the block averages at
+  every level that has at least 2 blocks: se_k = sqrt( var_k / (n_k - 1) ),
+  with var_k = M2_k / n_k. For correlated data se_k grows with k and levels off
+  once the block length exceeds the correlation time.
+*/
+
+  vector<double> res;
+
+  for(int k=0;k<max_levels;k++){
+    if(block_n[k]<2){ break; }
+    double nk = double(block_n[k]);
+    res.push_back( sqrt( block_M2[k] / (nk*(nk-1.0)) ) );
+  }
+
+  return res;
+}
+
+
+double DATA_stream::blocking_error(int min_blocks){
+/**
+  Plateau estimate of the standard error: the largest se_k among the levels
+  that still have at least min_blocks blocks (fewer blocks make se_k too noisy).
+  If there are fewer than min_blocks samples, there is no such level - NaN is returned
+*/
+
+  if(n<min_blocks || n<2){
+    std::cout<<"Warning: DATA_stream::blocking_error - "<<n<<" samples is fewer than min_blocks = "<<min_blocks
+             <<", the error can not be estimated\n";
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  vector<double> se_k = blocking_se();
+  double res = 0.0;
+
+  for(int k=0;k<se_k.size();k++){
+    if(block_n[k]<min_blocks){ break; }
+    if(se_k[k]>res){ res = se_k[k]; }
+  }
+
+  return res;
+}
+
+double DATA_stream::blocking_error(){  return blocking_error(128);  }
+
+
+double DATA_stream::correlation_time(){
+/**
+  Integrated autocorrelation time (in sampling steps) implied by the ratio of
+  the blocking and the naive standard errors: se_block^2 = 2 * tau * se_naive^2.
+  NaN if there are too few samples for blocking_error()
+*/
+
+  double se_block = blocking_error();
+  if(std::isnan(se_block)){ return se_block; }
+
+  double se0 = get_se();
+  if(se0<=0.0){ return 0.0; }
+
+  double r = se_block / se0;
+  return 0.5*r*r;
+}
+
+
+vector<double> DATA_stream::histogram_density(){
+/**
+  Probability density in every bin, normalized by all the samples added since
+  the histogram was set up (including the under/overflow ones)
+*/
+
+  vector<double> res(hist_nbins, 0.0);
+
+  double tot = hist_underflow + hist_overflow;
+  for(int k=0;k<hist_nbins;k++){ tot += hist[k]; }
+  if(tot==0.0){ return res; }
+
+  double dx = (hist_max - hist_min)/double(hist_nbins);
+  for(int k=0;k<hist_nbins;k++){ res[k] = hist[k]/(tot*dx); }
+
+  return res;
+}
+
+vector<double> DATA_stream::histogram_centers(){
+
+  vector<double> res(hist_nbins, 0.0);
+  double dx = (hist_max - hist_min)/double(hist_nbins);
+
+  for(int k=0;k<hist_nbins;k++){ res[k] = hist_min + (k+0.5)*dx; }
+
+  return res;
+}
+
+
+vector<double> DATA_stream::autocorrelation(int max_lag){
+
+  if(!is_store_series){
+    cout<<"Error in DATA_stream::autocorrelation: the series is not stored, set is_store_series = 1 before adding data\nExiting...\n";
+    exit(0);
+  }
+
+  return libdata::autocorrelation(series, max_lag, 1);
+}
+
+
+
+//=========================== Correlation functions ================================
+
+void fft(vector< complex<double> >& x, int is_inverse){
+/**
+  In-place iterative radix-2 FFT. The size of x must be a power of 2.
+  is_inverse = 1 computes the unnormalized inverse transform.
+*/
+
+  int N = x.size();
+  int i, j, len;
+
+  if(N & (N-1)){
+    cout<<"Error in fft: the size of the input "<<N<<" is not a power of 2\nExiting...\n";
+    exit(0);
+  }
+
+  // Bit-reversal permutation
+  for(i=1, j=0; i<N; i++){
+    int bit = N>>1;
+    for(; j & bit; bit >>= 1){ j ^= bit; }
+    j ^= bit;
+    if(i<j){ std::swap(x[i], x[j]); }
+  }
+
+  double sgn = is_inverse ? 1.0 : -1.0;
+
+  for(len=2; len<=N; len<<=1){
+    double ang = sgn * 2.0 * M_PI / double(len);
+    complex<double> wlen(cos(ang), sin(ang));
+    int half = len>>1;
+
+    for(i=0; i<N; i+=len){
+      complex<double> w(1.0, 0.0);
+      for(j=0; j<half; j++){
+        complex<double> u = x[i+j];
+        complex<double> v = x[i+j+half]*w;
+        x[i+j] = u + v;
+        x[i+j+half] = u - v;
+        w *= wlen;
+      }
+    }
+  }
+
+}
+
+
+vector<double> cross_correlation(vector<double>& a, vector<double>& b, int max_lag, int normalize){
+/**
+  C(t) = 1/(N-t) sum_{i=0}^{N-t-1} (a_i - <a>)(b_{i+t} - <b>),  t = 0, ..., max_lag
+
+  Computed as IFFT( conj(FFT(a)) * FFT(b) ) on zero-padded series - O(N log N)
+  instead of O(N * max_lag). max_lag < 0 or max_lag >= N means all lags.
+*/
+
+  int N = a.size();
+  int i;
+
+  if(b.size()!=N){
+    cout<<"Error in cross_correlation: the series have different lengths "<<N<<" and "<<b.size()<<"\nExiting...\n";
+    exit(0);
+  }
+  if(N<1){
+    cout<<"Error in cross_correlation: empty series\nExiting...\n";
+    exit(0);
+  }
+
+  if(max_lag<0 || max_lag>=N){ max_lag = N-1; }
+
+  double ave_a = 0.0, ave_b = 0.0;
+  for(i=0;i<N;i++){ ave_a += a[i];  ave_b += b[i]; }
+  ave_a /= double(N);  ave_b /= double(N);
+
+  int M = 1;
+  while(M < 2*N){ M <<= 1; }
+
+  vector< complex<double> > fa(M, complex<double>(0.0, 0.0));
+  vector< complex<double> > fb(M, complex<double>(0.0, 0.0));
+  for(i=0;i<N;i++){
+    fa[i] = complex<double>(a[i] - ave_a, 0.0);
+    fb[i] = complex<double>(b[i] - ave_b, 0.0);
+  }
+
+  fft(fa, 0);
+  fft(fb, 0);
+  for(i=0;i<M;i++){ fa[i] = std::conj(fa[i]) * fb[i]; }
+  fft(fa, 1);
+
+  vector<double> res(max_lag+1, 0.0);
+  for(i=0;i<=max_lag;i++){ res[i] = fa[i].real() / (double(M) * double(N-i)); }
+
+  if(normalize){
+    double var_a = 0.0, var_b = 0.0;
+    for(i=0;i<N;i++){
+      var_a += (a[i] - ave_a)*(a[i] - ave_a);
+      var_b += (b[i] - ave_b)*(b[i] - ave_b);
+    }
+    double nrm = sqrt(var_a*var_b)/double(N);
+    if(nrm>0.0){ for(i=0;i<=max_lag;i++){ res[i] /= nrm; } }
+  }
+
+  return res;
+}
+
+vector<double> cross_correlation(vector<double>& a, vector<double>& b, int max_lag){
+
+  return cross_correlation(a, b, max_lag, 1);
+}
+
+
+vector<double> autocorrelation(vector<double>& a, int max_lag, int normalize){
+/**
+  Autocorrelation function, C(t) = cross_correlation(a, a); with normalize = 1
+  this is rho(t) = C(t)/C(0)
+*/
+
+  return cross_correlation(a, a, max_lag, normalize);
+}
+
+vector<double> autocorrelation(vector<double>& a, int max_lag){
+
+  return autocorrelation(a, max_lag, 1);
+}
+
+
+double integrated_autocorrelation_time(vector<double>& a, double c){
+/**
+  tau_int = 1/2 + sum_{t=1}^{W} rho(t), with Sokal's automatic window: the
+  smallest W such that W >= c * tau_int(W). c is usually 4 - 10.
+  For uncorrelated data tau_int = 1/2; the variance of the mean is 2*tau_int*var/N.
+*/
+
+  vector<double> rho = autocorrelation(a, -1, 1);
+  double tau = 0.5;
+
+  for(int t=1;t<rho.size();t++){
+    tau += rho[t];
+    if(double(t) >= c*tau){ break; }
+  }
+
+  return tau;
+}
+
+double integrated_autocorrelation_time(vector<double>& a){
+
+  return integrated_autocorrelation_time(a, 5.0);
+}
+
+
+}// namespace libdata
+}// namespace liblibra
+
@@ -0,0 +1,153 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+
+#ifndef DATA_STREAM_H
+#define DATA_STREAM_H
+
+#if defined(USING_PCH)
+#include "../pch.h"
+#else
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include <complex>
+#include <boost/python.hpp>
+#include <boost/python/suite/indexing/vector_indexing_suite.hpp>
+
+#endif
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace boost::python;
+using namespace std;
+
+
+/// libdata namespace
+namespace libdata{
+
+//========================= Class DATA_stream ==============================
+// On-line (streaming) statistics accumulator. Unlike DATA, the samples are
+// not kept in memory (unless is_store_series = 1), so ensemble and time
+// averages can be reduced on the fly over arbitrarily long runs.
+//
+// - mean/variance: Welford updates; the raw sum is Kahan-compensated
+// - hierarchical blocking (Flyvbjerg-Petersen): the series is repeatedly
+//   pair-averaged on the fly, the standard error is tracked at every level
+// - fixed-bin histogram with under/overflow counters
+// - merge() combines accumulators built on different threads/trajectories
+//   (Chan et al. pairwise update for the moments)
+// - mae is only a single-pass approximation (the deviations are taken from
+//   the running mean) and it can not be merged: it is not available after
+//   merge() of two non-empty accumulators
+
+class DATA_stream{
+
+  public:
+
+  // Moments
+  long n;                 // number of samples
+  double ave;             // running mean (Welford)
+  double M2;              // sum of squared deviations from the mean (Welford)
+  double sum;             // Kahan-compensated sum of the samples
+  double sum_comp;        // Kahan compensation term
+  double mae_sum;         // sum of |x - ave| taken with the running mean (approximate mae)
+  int is_mae;             // 1 - mae_sum is valid, 0 - the accumulator has been merged
+  double min_val;         // minimal value
+  double max_val;         // maximal value
+
+  // Blocking analysis: level k holds blocks of 2^k consecutive samples
+  int max_levels;               // maximal number of blocking levels
+  vector<long> block_n;         // number of blocks completed at each level
+  vector<double> block_ave;     // mean of the block averages at each level (Welford)
+  vector<double> block_M2;      // Welford M2 of the block averages at each level
+  vector<double> block_pending; // a half-complete pair waiting at each level
+  vector<int> is_block_pending; // whether the pending value is set
+
+  // Histogram
+  int is_histogram;       // 1 - accumulate the histogram, 0 - don't
+  double hist_min;        // left boundary of the first bin
+  double hist_max;        // right boundary of the last bin
+  int hist_nbins;         // number of bins
+  vector<double> hist;    // counts in each bin
+  double hist_underflow;  // number of samples < hist_min
+  double hist_overflow;   // number of samples >= hist_max
+
+  // Optional copy of the series - needed only for the correlation functions
+  int is_store_series;
+  vector<double> series;
+
+
+  // Constructors
+  DATA_stream();
+  DATA_stream(int _max_levels);
+
+  void reset();
+  void push_block(int lev, double x);
+  void set_histogram(double _hist_min, double _hist_max, int _hist_nbins);
+
+  // Accumulation
+  void add(double x);
+  void add(vector<double>& x);
+  void add(boost::python::list x);
+  void merge(const DATA_stream& other);
+
+  // Estimators: same definitions as in DATA::Calculate_Estimators, except for
+  // mae, which is approximate (NaN after merge())
+  double get_sum();
+  double get_var();       // unbiased, (n-1) in denominator
+  double get_sd();
+  double get_se();        // naive standard error: sd/sqrt(n)
+  double get_mse();
+  double get_mae();
+  double get_rmse();
+  int Calculate_Estimators(double&,double&,double&,double&,double&,double&,double&);
+
+  // Blocking analysis
+  vector<double> blocking_se();       // standard error of the mean at every level
+  double blocking_error(int min_blocks); // plateau estimate of the standard error, NaN if n < min_blocks
+  double blocking_error();
+  double correlation_time();          // 0.5*(se_block/se_naive)^2, in units of the sampling step, NaN if n < 128
+
+  // Histogram
+  vector<double> histogram_density();
+  vector<double> histogram_centers();
+
+  // Correlation functions of the stored series
+  vector<double> autocorrelation(int max_lag);
+
+};
+
+typedef std::vector<DATA_stream> DATA_streamList;
+
+
+// FFT-based correlation functions of time series. The series are zero-padded
+// to a power of 2 of at least 2N, so the result is the linear (not circular)
+// correlation: C(t) = 1/(N-t) sum_i (a_i - <a>)(b_{i+t} - <b>)
+// If normalize = 1 the result is divided by C(0) (autocorrelation) or by
+// sd(a)*sd(b) (cross-correlation)
+void fft(vector< complex<double> >& x, int is_inverse);
+vector<double> autocorrelation(vector<double>& a, int max_lag, int normalize);
+vector<double> autocorrelation(vector<double>& a, int max_lag);
+vector<double> cross_correlation(vector<double>& a, vector<double>& b, int max_lag, int normalize);
+vector<double> cross_correlation(vector<double>& a, vector<double>& b, int max_lag);
+double integrated_autocorrelation_time(vector<double>& a, double c);
+double integrated_autocorrelation_time(vector<double>& a);
+
+
+}// namespace libdata
+}// namespace liblibra
+
+#endif // DATA_STREAM_H
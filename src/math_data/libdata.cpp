@@ -91,6 +91,72 @@ void export_Data_objects(){
   ;
 
 
+  void (DATA_stream::*expt_add_v1)(double) = &DATA_stream::add;
+  void (DATA_stream::*expt_add_v2)(boost::python::list) = &DATA_stream::add;
+  double (DATA_stream::*expt_blocking_error_v1)(int) = &DATA_stream::blocking_error;
+  double (DATA_stream::*expt_blocking_error_v2)() = &DATA_stream::blocking_error;
+
+  class_<DATA_stream>("DATA_stream",init<>())
+      .def(init<int>())
+      .def(init<const DATA_stream&>())
+      .def("__copy__", &generic__copy__<DATA_stream>)
+      .def("__deepcopy__", &generic__deepcopy__<DATA_stream>)
+
+      .def_readonly("n",&DATA_stream::n)
+      .def_readonly("ave",&DATA_stream::ave)
+      .def_readonly("M2",&DATA_stream::M2)
+      .def_readonly("min_val",&DATA_stream::min_val)
+      .def_readonly("max_val",&DATA_stream::max_val)
+      .def_readonly("max_levels",&DATA_stream::max_levels)
+      .def_readonly("is_histogram",&DATA_stream::is_histogram)
+      .def_readonly("hist_min",&DATA_stream::hist_min)
+      .def_readonly("hist_max",&DATA_stream::hist_max)
+      .def_readonly("hist_nbins",&DATA_stream::hist_nbins)
+      .def_readonly("hist",&DATA_stream::hist)
+      .def_readonly("hist_underflow",&DATA_stream::hist_underflow)
+      .def_readonly("hist_overflow",&DATA_stream::hist_overflow)
+      .def_readwrite("is_store_series",&DATA_stream::is_store_series)
+      .def_readonly("series",&DATA_stream::series)
+
+      .def("reset", &DATA_stream::reset)
+      .def("set_histogram", &DATA_stream::set_histogram)
+      .def("add", expt_add_v1)
+      .def("add", expt_add_v2)
+      .def("merge", &DATA_stream::merge)
+
+      .def("get_sum", &DATA_stream::get_sum)
+      .def("get_var", &DATA_stream::get_var)
+      .def("get_sd", &DATA_stream::get_sd)
+      .def("get_se", &DATA_stream::get_se)
+      .def("get_mse", &DATA_stream::get_mse)
+      .def("get_mae", &DATA_stream::get_mae)
+      .def("get_rmse", &DATA_stream::get_rmse)
+
+      .def("blocking_se", &DATA_stream::blocking_se)
+      .def("blocking_error", expt_blocking_error_v1)
+      .def("blocking_error", expt_blocking_error_v2)
+      .def("correlation_time", &DATA_stream::correlation_time)
+      .def("histogram_density", &DATA_stream::histogram_density)
+      .def("histogram_centers", &DATA_stream::histogram_centers)
+      .def("autocorrelation", &DATA_stream::autocorrelation)
+  ;
+
+
+  vector<double> (*expt_autocorrelation_v1)(vector<double>& a, int max_lag, int normalize) = &autocorrelation;
+  vector<double> (*expt_autocorrelation_v2)(vector<double>& a, int max_lag) = &autocorrelation;
+  vector<double> (*expt_cross_correlation_v1)(vector<double>& a, vector<double>& b, int max_lag, int normalize) = &cross_correlation;
+  vector<double> (*expt_cross_correlation_v2)(vector<double>& a, vector<double>& b, int max_lag) = &cross_correlation;
+  double (*expt_integrated_autocorrelation_time_v1)(vector<double>& a, double c) = &integrated_autocorrelation_time;
+  double (*expt_integrated_autocorrelation_time_v2)(vector<double>& a) = &integrated_autocorrelation_time;
+
+  def("autocorrelation", expt_autocorrelation_v1);
+  def("autocorrelation", expt_autocorrelation_v2);
+  def("cross_correlation", expt_cross_correlation_v1);
+  def("cross_correlation", expt_cross_correlation_v2);
+  def("integrated_autocorrelation_time", expt_integrated_autocorrelation_time_v1);
+  def("integrated_autocorrelation_time", expt_integrated_autocorrelation_time_v2);
+
+
 
 }
 
@@ -14,6 +14,7 @@
 
 
 #include "DATA.h"
+#include "DATA_stream.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -15,6 +15,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <iterator>
 #endif 
 
 #include "GRAPH.h"
@@ -173,6 +174,174 @@ void show_paths(vector<Path>& p){
 
 }
 
+
+int find_sssr(vector< vector<int> >& adj, vector< vector<int> >& rings, int max_ring_size){
+/**
+  \param[in] adj The adjacency lists of the undirected graph: adj[i] - the indices of the vertices connected to i
+  \param[out] rings The smallest set of smallest rings. Each ring is given by the indices of its vertices, in the cyclic order
+  \param[in] max_ring_size The largest ring to be looked for. Use a non-positive value to remove this limit
+
+  Returns the number of rings found.
+
+  The algorithm works with the sparse graph directly, not with the distance matrix:
+  1) The acyclic parts (trees hanging on the rings and the chains) are pruned, the number of independent
+     rings (E - V + 1 for each connected component) is computed
+  2) For each vertex r, the breadth-first search (limited to the depth of max_ring_size/2) gives the tree of
+     shortest paths. Each non-tree edge (x,y), such that the paths r..x and r..y only share r, defines the 
+     candidate ring r..x-y..r (Horton's set of candidates)
+  3) The unique candidates are sorted by size and the linearly independent ones (over GF(2), in the edge space)
+     are collected until the number of independent rings is reached
+
+  For the sparse molecular graphs with the limited ring size, the cost grows linearly with the number of vertices.
+  Without the limit, the cost is O(V*E).
+*/
+
+  int i,j,k;
+  int n = adj.size();
+  int L = (max_ring_size>0)? max_ring_size : n;
+
+  if(rings.size()>0){ rings.clear(); }
+
+  //=========== Step 1: prune the acyclic parts =================
+  vector<int> deg(n, 0);
+  vector<int> alive(n, 1);
+  for(i=0;i<n;i++){  deg[i] = adj[i].size();  }
+
+  vector<int> queue;
+  for(i=0;i<n;i++){  if(deg[i]<=1){ queue.push_back(i); alive[i] = 0; }  }
+  for(k=0;k<queue.size();k++){
+    i = queue[k];
+    for(j=0;j<adj[i].size();j++){
+      int nb = adj[i][j];
+      if(alive[nb]){
+        deg[nb]--;
+        if(deg[nb]<=1){ queue.push_back(nb); alive[nb] = 0; }
+      }
+    }
+  }
+
+  // Index the remaining edges: nbr[i] - pairs (neighbor, edge index)
+  vector< vector< pair<int,int> > > nbr(n);
+  int nedges = 0;
+  for(i=0;i<n;i++){
+    if(!alive[i]){ continue; }
+    for(j=0;j<adj[i].size();j++){
+      int nb = adj[i][j];
+      if(alive[nb] && i<nb){
+        nbr[i].push_back(make_pair(nb, nedges));
+        nbr[nb].push_back(make_pair(i, nedges));
+        nedges++;
+      }
+    }
+  }
+
+  // The number of independent rings: E - V + C
+  int nu = nedges;
+  vector<int> comp(n, -1);
+  for(i=0;i<n;i++){
+    if(!alive[i] || comp[i]!=-1){ continue; }
+    nu++;                                      // new component
+    vector<int> stack(1, i);  comp[i] = i;
+    while(!stack.empty()){
+      int v = stack.back();  stack.pop_back();  nu--;
+      for(j=0;j<nbr[v].size();j++){
+        int nb = nbr[v][j].first;
+        if(comp[nb]==-1){ comp[nb] = i; stack.push_back(nb); }
+      }
+    }
+  }
+  if(nu<=0){ return 0; }
+
+
+  //=========== Step 2: ring candidates =================
+  vector< pair<int, vector<int> > > cand_edges;   // (size, sorted edge indices)
+  vector< vector<int> > cand_verts;               // vertices in the cyclic order
+
+  vector<int> dist(n, -1), par(n, -1), par_edge(n, -1), branch(n, -1);
+  vector<int> visited;
+
+  for(int r=0;r<n;r++){
+    if(!alive[r]){ continue; }
+
+    // Limited BFS
+    visited.clear();
+    visited.push_back(r);  dist[r] = 0;  par[r] = -1;  par_edge[r] = -1;  branch[r] = r;
+
+    for(k=0;k<visited.size();k++){
+      int v = visited[k];
+      if(2*dist[v] >= L){ continue; }
+      for(j=0;j<nbr[v].size();j++){
+        int nb = nbr[v][j].first;
+        if(dist[nb]==-1){
+          dist[nb] = dist[v] + 1;  par[nb] = v;  par_edge[nb] = nbr[v][j].second;
+          branch[nb] = (v==r)? nb : branch[v];
+          visited.push_back(nb);
+        }
+      }
+    }
+
+    // Non-tree edges closing the rings through r
+    for(k=0;k<visited.size();k++){
+      int x = visited[k];
+      if(x==r){ continue; }
+      for(j=0;j<nbr[x].size();j++){
+        int y = nbr[x][j].first;
+        int e = nbr[x][j].second;
+        if(y<=x || y==r || dist[y]==-1){ continue; }
+        if(par_edge[x]==e || par_edge[y]==e){ continue; }
+        if(branch[x]==branch[y]){ continue; }          // the paths overlap beyond r
+        if(dist[x]+dist[y]+1 > L){ continue; }
+
+        vector<int> edges(1, e);
+        vector<int> verts;
+        int v = x;
+        while(v!=r){ verts.push_back(v); edges.push_back(par_edge[v]); v = par[v]; }
+        verts.push_back(r);
+        std::reverse(verts.begin(), verts.end());      // r ... x
+        v = y;
+        while(v!=r){ verts.push_back(v); edges.push_back(par_edge[v]); v = par[v]; }  // y ... (r)
+
+        std::sort(edges.begin(), edges.end());
+        cand_edges.push_back(make_pair((int)edges.size(), edges));
+        cand_verts.push_back(verts);
+      }
+    }
+
+    for(k=0;k<visited.size();k++){ dist[visited[k]] = -1; }
+  }// for r
+
+
+  //=========== Step 3: the smallest independent set =================
+  vector<int> order(cand_edges.size());
+  for(i=0;i<order.size();i++){ order[i] = i; }
+  std::sort(order.begin(), order.end(), [&](int a, int b){ return cand_edges[a] < cand_edges[b]; });
+
+  std::map<int, vector<int> > basis;   // the reduced cycles, keyed by their largest edge index
+  int nrings = 0;
+
+  for(k=0;k<order.size() && nrings<nu;k++){
+    int c = order[k];
+    if(k>0 && cand_edges[c]==cand_edges[order[k-1]]){ continue; }  // the same ring from another root
+
+    vector<int> v = cand_edges[c].second;
+    while(!v.empty()){
+      std::map<int, vector<int> >::iterator it = basis.find(v.back());
+      if(it==basis.end()){ break; }
+      vector<int> res;
+      std::set_symmetric_difference(v.begin(), v.end(), it->second.begin(), it->second.end(), std::back_inserter(res));
+      v.swap(res);
+    }
+
+    if(!v.empty()){
+      basis[v.back()] = v;
+      rings.push_back(cand_verts[c]);
+      nrings++;
+    }
+  }
+
+  return nrings;
+}
+
 }// namespace libgraph
 }// namespace liblibra
 
@@ -61,6 +61,7 @@ int is_included(Path& p,vector<Path>& P);
 int path_xor(Path& p1, Path& p2, Path& res);
 void show_path(Path& p);
 void show_paths(vector<Path>& p);
+int find_sssr(vector< vector<int> >& adj, vector< vector<int> >& rings, int max_ring_size);
 
 
 //*********************************************************************
@@ -248,6 +249,7 @@ template <class VERTEX_DATA,class EDGE_DATA> class GRAPH{
       int REDUCE_GRAPH();
       int FIND_PATHS_FLOYD_WARSHALL(double** D,vector<Path>** P);
       int FIND_SSSR(vector<Path>&);
+      int FIND_SSSR_FAST(vector<Path>&, int max_ring_size);
 
       int show_vertices(int);
       int show_edges(int);
@@ -988,6 +990,41 @@ template <class VERTEX_DATA,class EDGE_DATA> int GRAPH<VERTEX_DATA,EDGE_DATA>::F
     return 0;
 }
 
+
+template <class VERTEX_DATA,class EDGE_DATA> int GRAPH<VERTEX_DATA,EDGE_DATA>::FIND_SSSR_FAST(vector<Path>& sssr, int max_ring_size){
+/**
+  Same as FIND_SSSR, but uses the sparse find_sssr algorithm instead of the all-pairs path matrices,
+  so it can be used for large graphs. The rings larger than max_ring_size are not searched for 
+  (non-positive value - no limit). The rings are returned as the paths of the edge indices
+*/
+
+    if(sssr.size()>0) { sssr.clear(); }
+
+    vector< vector<int> > adj(_V_);
+    for(int i=0;i<_V_;i++){  adj[i] = V[i].adjacent_vertices;  }
+
+    vector< vector<int> > rings;
+    int n_ringidx = find_sssr(adj, rings, max_ring_size);
+
+    // Convert the vertex sequences to the edge sequences
+    for(int r=0;r<n_ringidx;r++){
+        Path p;
+        int sz = rings[r].size();
+        for(int k=0;k<sz;k++){
+            int v1 = rings[r][k];
+            int v2 = rings[r][(k+1)%sz];
+            for(int j=0;j<V[v1].vertex_degree;j++){
+                if(V[v1].adjacent_vertices[j]==v2){ p.push_back(V[v1].adjacent_edges[j]); break; }
+            }
+        }// for k
+        sssr.push_back(p);
+    }// for r
+
+    cout<<"Ring search completed. Number of rings found is "<<n_ringidx<<endl;   
+
+    return 0;
+}
+
 }// namespace libgraph
 }// namespace liblibra
 
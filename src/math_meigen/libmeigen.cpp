@@ -108,6 +108,44 @@ void export_mEigen_objects(){
   def("exp_matrix", expt_exp_matrix_v2);
 
 
+  class_<herm_workspace, boost::noncopyable>("herm_workspace",init<>())
+      .def(init<int>())
+      .def_readonly("n", &herm_workspace::n)
+      .def_readonly("evals", &herm_workspace::evals)
+      .def("resize", &herm_workspace::resize)
+  ;
+
+  void (*expt_expm_pade_v1)(CMATRIX& res, CMATRIX& A, complex<double> dt) = &expm_pade;
+  void (*expt_expm_pade_v2)(vector<CMATRIX>& res, vector<CMATRIX>& A, complex<double> dt) = &expm_pade;
+  def("expm_pade", expt_expm_pade_v1);
+  def("expm_pade", expt_expm_pade_v2);
+
+  def("log_matrix", &log_matrix);
+
+  void (*expt_exp_hermitian_v1)(CMATRIX& res, CMATRIX& H, complex<double> dt, herm_workspace& ws) = &exp_hermitian;
+  void (*expt_exp_hermitian_v2)(CMATRIX& res, CMATRIX& H, complex<double> dt) = &exp_hermitian;
+  void (*expt_exp_hermitian_v3)(vector<CMATRIX>& res, vector<CMATRIX>& H, complex<double> dt) = &exp_hermitian;
+  def("exp_hermitian", expt_exp_hermitian_v1);
+  def("exp_hermitian", expt_exp_hermitian_v2);
+  def("exp_hermitian", expt_exp_hermitian_v3);
+
+  def("sqrt_hermitian", &sqrt_hermitian);
+
+  void (*expt_inv_sqrt_hermitian_v1)(CMATRIX& S, CMATRIX& S_i_half, double thresh, herm_workspace& ws) = &inv_sqrt_hermitian;
+  void (*expt_inv_sqrt_hermitian_v2)(CMATRIX& S, CMATRIX& S_i_half, double thresh) = &inv_sqrt_hermitian;
+  void (*expt_inv_sqrt_hermitian_v3)(CMATRIX& S, CMATRIX& S_i_half) = &inv_sqrt_hermitian;
+  void (*expt_inv_sqrt_hermitian_v4)(vector<CMATRIX>& S, vector<CMATRIX>& S_i_half, double thresh) = &inv_sqrt_hermitian;
+  def("inv_sqrt_hermitian", expt_inv_sqrt_hermitian_v1);
+  def("inv_sqrt_hermitian", expt_inv_sqrt_hermitian_v2);
+  def("inv_sqrt_hermitian", expt_inv_sqrt_hermitian_v3);
+  def("inv_sqrt_hermitian", expt_inv_sqrt_hermitian_v4);
+
+  void (*expt_log_hermitian_v1)(CMATRIX& res, CMATRIX& S, herm_workspace& ws) = &log_hermitian;
+  void (*expt_log_hermitian_v2)(CMATRIX& res, CMATRIX& S) = &log_hermitian;
+  def("log_hermitian", expt_log_hermitian_v1);
+  def("log_hermitian", expt_log_hermitian_v2);
+
+
   void (*expt_FullPivLU_rank_invertible_v1)(MATRIX& A, int& rank, int& is_inver) = &FullPivLU_rank_invertible;
   void (*expt_FullPivLU_rank_invertible_v2)(CMATRIX& A, int& rank, int& is_inver) = &FullPivLU_rank_invertible;
   boost::python::list (*expt_FullPivLU_rank_invertible_v3)(MATRIX& A) = &FullPivLU_rank_invertible;
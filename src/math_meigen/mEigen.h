@@ -115,6 +115,48 @@ void exp_matrix(CMATRIX& res, CMATRIX& S, complex<double> dt, int do_phase_corre
 void exp_matrix(CMATRIX& res, CMATRIX& S, complex<double> dt);
 
 
+class herm_workspace{
+/**
+  The workspace of the Hermitian matrix functions: keeps the self-adjoint eigensolver
+  and the temporary matrices allocated between the calls with the matrices of the same size.
+  A workspace must not be shared between threads.
+*/
+
+  herm_workspace(const herm_workspace&);
+  herm_workspace& operator=(const herm_workspace&);
+
+public:
+  class solver;                 ///< defined in mEigen_matrix_functions.cpp
+  solver* slv;
+
+  int n;                        ///< the size of the matrices
+  vector<double> evals;         ///< the eigenvalues of the last processed matrix, in the ascending order
+
+  herm_workspace();
+  herm_workspace(int _n);
+  ~herm_workspace();
+
+  void resize(int _n);
+};
+
+///< General matrices
+void expm_pade(CMATRIX& res, CMATRIX& A, complex<double> dt);
+void expm_pade(vector<CMATRIX>& res, vector<CMATRIX>& A, complex<double> dt);
+void log_matrix(CMATRIX& res, CMATRIX& A);
+
+///< Hermitian matrices
+void exp_hermitian(CMATRIX& res, CMATRIX& H, complex<double> dt, herm_workspace& ws);
+void exp_hermitian(CMATRIX& res, CMATRIX& H, complex<double> dt);
+void exp_hermitian(vector<CMATRIX>& res, vector<CMATRIX>& H, complex<double> dt);
+void sqrt_hermitian(CMATRIX& S, CMATRIX& S_half, CMATRIX& S_i_half, double thresh, herm_workspace& ws);
+void inv_sqrt_hermitian(CMATRIX& S, CMATRIX& S_i_half, double thresh, herm_workspace& ws);
+void inv_sqrt_hermitian(CMATRIX& S, CMATRIX& S_i_half, double thresh);
+void inv_sqrt_hermitian(CMATRIX& S, CMATRIX& S_i_half);
+void inv_sqrt_hermitian(vector<CMATRIX>& S, vector<CMATRIX>& S_i_half, double thresh);
+void log_hermitian(CMATRIX& res, CMATRIX& S, herm_workspace& ws);
+void log_hermitian(CMATRIX& res, CMATRIX& S);
+
+
 ///=========== Look in: mEigen_decompositions.cpp ==================
 ///< LU decomposition
 void FullPivLU_decomposition(MATRIX& A, MATRIX& P, MATRIX& L, MATRIX& U, MATRIX& Q);
@@ -15,6 +15,7 @@
 #include <Eigen/Core>
 #include "mEigen.h"
 #include <cmath>
+#include <omp.h>
 
 /// liblibra namespace
 namespace liblibra{
@@ -28,79 +29,465 @@ using namespace liblinalg;
 namespace libmeigen{
 
 
+typedef Eigen::Matrix<complex<double>, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixRMcd;  ///< the layout of CMATRIX::M
 
 
+class herm_workspace::solver{
+public:
+  SelfAdjointEigenSolver<MatrixXcd> es;
+  MatrixXcd a;      ///< the copy of the input matrix
+  VectorXcd f;      ///< the function of the eigenvalues
+  MatrixXcd tmp;
+};
 
-void sqrt_matrix(CMATRIX& S, CMATRIX& S_half, CMATRIX& S_i_half, double thresh, int do_phase_correction){
-/**
-  This function computes S^{1/2} and S^{-1/2} for given matrix S
-  \param[in] S Input matrix
-  \param[out] S_half Computed S^{1/2} matrix
-  \param[out] S_i_half Computed S^{-1/2} matrix
-  \param[in] threshold - if an absolute value of any eigenvalue of S is below this level, we stop,
-   throwing an error message
 
+herm_workspace::herm_workspace(){  n = 0; slv = new solver();  }
 
+herm_workspace::herm_workspace(int _n){  n = 0; slv = new solver(); resize(_n);  }
+
+herm_workspace::~herm_workspace(){  delete slv;  }
+
+void herm_workspace::resize(int _n){
+/**
+  Allocate the workspace for the n x n matrices. Nothing is done if the size does not change
 */
 
-  if(S.n_cols != S.n_rows){
-    cout<<"Error in libmeigen::sqrt_matrix : the input matrix is not square\n"; exit(0); 
+  if(_n==n){ return; }
+
+  n = _n;
+  evals.resize(n);
+  slv->a.resize(n, n);
+  slv->f.resize(n);
+  slv->tmp.resize(n, n);
+  slv->es = SelfAdjointEigenSolver<MatrixXcd>(n);
+}
+
+
+namespace{
+
+void check_square(CMATRIX& A, CMATRIX& res, std::string fname){
+  if(A.n_cols != A.n_rows){
+    cout<<"Error in libmeigen::"<<fname<<" : the input matrix is not square\n"; exit(0);
   }
-  if(S_half.n_cols != S_half.n_rows){
-    cout<<"Error in libmeigen::sqrt_matrix : the output S^{1/2} matrix is not square\n"; exit(0); 
+  if(res.n_cols != A.n_cols || res.n_rows != A.n_rows){
+    cout<<"Error in libmeigen::"<<fname<<" : the output matrix is not of the same size as the input one\n"; exit(0);
   }
-  if(S_i_half.n_cols != S_i_half.n_rows){
-    cout<<"Error in libmeigen::sqrt_matrix : the output S^{-1/2} matrix is not square\n"; exit(0); 
+}
+
+
+void herm_eigen(CMATRIX& H, herm_workspace& ws){
+/**
+  Diagonalize the Hermitian matrix H: ws.evals - the eigenvalues, the eigenvectors stay in the solver
+*/
+
+  ws.resize(H.n_cols);
+
+  ws.slv->a = Map<MatrixRMcd>(H.M, ws.n, ws.n);
+  ws.slv->es.compute(ws.slv->a, ComputeEigenvectors);
+
+  if(ws.slv->es.info()!=Success){
+    cout<<"Error in libmeigen::herm_eigen : the eigensolver did not converge\n"; exit(0);
   }
-  if(S.n_cols != S_half.n_cols){
-    cout<<"Error in libmeigen::sqrt_matrix : size of matrix S is not the same as that of matrix S^{1/2}\n"; exit(0); 
+
+  for(int i=0;i<ws.n;i++){ ws.evals[i] = ws.slv->es.eigenvalues()(i); }
+}
+
+
+void herm_apply(CMATRIX& res, herm_workspace& ws){
+/**
+  res = C * diag(f) * C^+, where C are the eigenvectors found by herm_eigen
+*/
+
+  int n = ws.n;
+  const MatrixXcd& C = ws.slv->es.eigenvectors();
+
+  ws.slv->tmp.noalias() = C * ws.slv->f.asDiagonal();
+
+  Map<MatrixRMcd> r(res.M, n, n);
+  r.noalias() = ws.slv->tmp * C.adjoint();
+}
+
+
+double norm1(const MatrixXcd& A){  return A.cwiseAbs().colwise().sum().maxCoeff();  }
+
+
+void expm_pade_eigen(MatrixXcd& A, MatrixXcd& R){
+/**
+  R = exp(A) by the scaling and squaring with the Pade approximants of degree 3, 5, 7, 9 or 13:
+
+  N. J. Higham, "The scaling and squaring method for the matrix exponential revisited",
+  SIAM J. Matrix Anal. Appl. 2005, 26, 1179
+*/
+
+  static const double theta[5] = {1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+                                  2.097847961257068e0, 5.371920351148152e0 };
+  static const double b3[4] = {120.0, 60.0, 12.0, 1.0};
+  static const double b5[6] = {30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0};
+  static const double b7[8] = {17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 1.0};
+  static const double b9[10] = {17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0,
+                                2162160.0, 110880.0, 3960.0, 90.0, 1.0};
+  static const double b13[14] = {64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+                                 1187353796428800.0, 129060195264000.0, 10559470521600.0, 670442572800.0,
+                                 33522128640.0, 1323241920.0, 40840800.0, 960960.0, 16380.0, 182.0, 1.0};
+  static const double* b[4] = {b3, b5, b7, b9};
+
+  int n = A.rows();
+  MatrixXcd I = MatrixXcd::Identity(n, n);
+  MatrixXcd U(n, n), V(n, n);
+  double nrm = norm1(A);
+  int s = 0;
+
+  int m = -1;
+  for(int k=0; k<4; k++){  if(nrm <= theta[k]){ m = k; break; }  }
+
+  if(m>=0){
+    // Low degree, no scaling: U = A * sum_odd b_k A^{k-1},  V = sum_even b_k A^k
+    const double* c = b[m];
+    int deg = 2*m + 3;
+    MatrixXcd A2 = A * A;
+    MatrixXcd P = I;
+    U = c[1] * I;
+    V = c[0] * I;
+    for(int k=2; k<=deg; k+=2){
+      P = P * A2;
+      V += c[k] * P;
+      U += c[k+1] * P;
+    }
+    U = A * U;
   }
-  if(S.n_cols != S_i_half.n_cols){
-    cout<<"Error in libmeigen::sqrt_matrix : size of matrix S is not the same as that of matrix S^{-1/2}\n"; exit(0); 
+  else{
+    if(nrm > theta[4]){  s = (int)ceil(log2(nrm / theta[4]));  }
+    MatrixXcd As = A / pow(2.0, s);
+    MatrixXcd A2 = As * As;
+    MatrixXcd A4 = A2 * A2;
+    MatrixXcd A6 = A4 * A2;
+
+    U = A6 * (b13[13]*A6 + b13[11]*A4 + b13[9]*A2);
+    U += b13[7]*A6 + b13[5]*A4 + b13[3]*A2 + b13[1]*I;
+    U = As * U;
+
+    V = A6 * (b13[12]*A6 + b13[10]*A4 + b13[8]*A2);
+    V += b13[6]*A6 + b13[4]*A4 + b13[2]*A2 + b13[0]*I;
   }
 
+  // R = (V - U)^{-1} (V + U)
+  R = (V - U).partialPivLu().solve(V + U);
 
-  int i,j;
- 
-  // Let us first diagonalize the overlap matrix S
-  int sz = S.n_cols;  
-  CMATRIX* C; C = new CMATRIX(sz, sz);  *C = complex<double>(0.0, 0.0);
-  CMATRIX* Seig; Seig = new CMATRIX(sz, sz);  *Seig = complex<double>(0.0,0.0);
+  for(int k=0; k<s; k++){  R = R * R;  }
+}
 
+}// anonymous namespace
 
-  // Find the eigenvalues of the the S matrix
-  solve_eigen(S, *Seig, *C, 0);  // S * C = C * Seig  ==>  S = C * Seig * C.H()
 
-  //if(do_phase_correction){   correct_phase(C);  }
 
-  // Diagonal form of the S^{-1/2} and S^{1/2} matrices
-  S_i_half = complex<double>(0.0,0.0);  // S^{-1/2}
-  S_half = complex<double>(0.0,0.0);    // S^{1/2}
+void expm_pade(CMATRIX& res, CMATRIX& A, complex<double> dt){
+/**
+  This function computes exp(A*dt) for a general (not necessarily normal) matrix A
+  by the Pade scaling and squaring method
+  \param[out] res the result
+  \param[in] A input matrix
+  \param[in] dt scaling factor
+*/
+
+  check_square(A, res, "expm_pade");
+
+  int n = A.n_cols;
+  MatrixXcd a(n, n), r(n, n);
+
+  a = Map<MatrixRMcd>(A.M, n, n) * dt;
+  expm_pade_eigen(a, r);
+  Map<MatrixRMcd>(res.M, n, n) = r;
+
+}
+
+
+void exp_hermitian(CMATRIX& res, CMATRIX& H, complex<double> dt, herm_workspace& ws){
+/**
+  This function computes exp(H*dt) for a Hermitian matrix H: exp(H*dt) = C * exp(E*dt) * C^+
+  \param[out] res the result
+  \param[in] H input Hermitian matrix
+  \param[in] dt scaling factor (e.g. -i*dt/hbar for the propagator)
+  \param[in,out] ws the workspace, reused between the calls
+*/
+
+  check_square(H, res, "exp_hermitian");
+
+  herm_eigen(H, ws);
+  for(int i=0;i<ws.n;i++){  ws.slv->f(i) = std::exp(dt * ws.evals[i]);  }
+  herm_apply(res, ws);
+
+}
+
+void exp_hermitian(CMATRIX& res, CMATRIX& H, complex<double> dt){
+  herm_workspace ws(H.n_cols);
+  exp_hermitian(res, H, dt, ws);
+}
+
+
+void sqrt_hermitian(CMATRIX& S, CMATRIX& S_half, CMATRIX& S_i_half, double thresh, herm_workspace& ws){
+/**
+  This function computes S^{1/2} and S^{-1/2} for a Hermitian matrix S
+  \param[in] S Input matrix
+  \param[out] S_half Computed S^{1/2} matrix
+  \param[out] S_i_half Computed S^{-1/2} matrix
+  \param[in] thresh - if the absolute value of the square root of any eigenvalue of S is below this level,
+   we stop, throwing an error message
+  \param[in,out] ws the workspace, reused between the calls
+*/
+
+  check_square(S, S_half, "sqrt_hermitian");
+  check_square(S, S_i_half, "sqrt_hermitian");
 
-  for(i=0;i<sz;i++){
-    complex<double> val = std::sqrt(Seig->get(i,i));
+  int i;
 
-    double nrm  = std::abs(val);
-    if(nrm<thresh){  
+  herm_eigen(S, ws);
+
+  for(i=0;i<ws.n;i++){
+    complex<double> val = std::sqrt(complex<double>(ws.evals[i], 0.0));
+
+    if(std::abs(val)<thresh){
       std::cout<<"\n Error in sqrt_matrix: One of the eigenvalues of the matrix S is "<< val
                <<"\n this is below the used threshold of "<<thresh
                <<"\n So... the matrix is likely singular or your threshold is too large"
                <<"\n Exiting now...\n";
       exit(0);
     }
-    else{
-      S_i_half.M[i*sz+i] = 1.0/val;
-      S_half.M[i*sz+i] = val;
+    ws.slv->f(i) = val;
+  }
+  herm_apply(S_half, ws);
+
+  for(i=0;i<ws.n;i++){  ws.slv->f(i) = 1.0/ws.slv->f(i);  }
+  herm_apply(S_i_half, ws);
+
+}
+
+
+void inv_sqrt_hermitian(CMATRIX& S, CMATRIX& S_i_half, double thresh, herm_workspace& ws){
+/**
+  This function computes S^{-1/2} for a Hermitian matrix S (e.g. the Lowdin orthogonalization)
+  \param[in] S Input matrix
+  \param[out] S_i_half Computed S^{-1/2} matrix
+  \param[in] thresh - see sqrt_hermitian
+  \param[in,out] ws the workspace, reused between the calls
+*/
+
+  check_square(S, S_i_half, "inv_sqrt_hermitian");
+
+  herm_eigen(S, ws);
+
+  for(int i=0;i<ws.n;i++){
+    complex<double> val = std::sqrt(complex<double>(ws.evals[i], 0.0));
+
+    if(std::abs(val)<thresh || std::abs(val)==0.0){
+      std::cout<<"\n Error in inv_sqrt_hermitian: One of the eigenvalues of the matrix S is "<< ws.evals[i]
+               <<"\n its square root is below the used threshold of "<<thresh
+               <<"\n Exiting now...\n";
+      exit(0);
     }
+    ws.slv->f(i) = 1.0/val;
   }
+  herm_apply(S_i_half, ws);
 
-  // Convert to the original basis
-  S_i_half = (*C) * S_i_half * ((*C).H());
-  S_half = (*C) * S_half * ((*C).H());
+}
 
-  delete C;
-  delete Seig;
+void inv_sqrt_hermitian(CMATRIX& S, CMATRIX& S_i_half, double thresh){
+  herm_workspace ws(S.n_cols);
+  inv_sqrt_hermitian(S, S_i_half, thresh, ws);
+}
 
+void inv_sqrt_hermitian(CMATRIX& S, CMATRIX& S_i_half){
+  inv_sqrt_hermitian(S, S_i_half, -1.0);
+}
+
+
+void log_hermitian(CMATRIX& res, CMATRIX& S, herm_workspace& ws){
+/**
+  This function computes the principal logarithm of a Hermitian positive-definite matrix S
+  \param[out] res the result
+  \param[in] S Input matrix
+  \param[in,out] ws the workspace, reused between the calls
+*/
+
+  check_square(S, res, "log_hermitian");
+
+  herm_eigen(S, ws);
+
+  for(int i=0;i<ws.n;i++){
+    if(ws.evals[i]<=0.0){
+      cout<<"Error in libmeigen::log_hermitian : the matrix is not positive-definite, eigenvalue "<<i<<" = "<<ws.evals[i]<<"\n";
+      exit(0);
+    }
+    ws.slv->f(i) = std::log(ws.evals[i]);
+  }
+  herm_apply(res, ws);
+
+}
+
+void log_hermitian(CMATRIX& res, CMATRIX& S){
+  herm_workspace ws(S.n_cols);
+  log_hermitian(res, S, ws);
+}
+
+
+void log_matrix(CMATRIX& res, CMATRIX& A){
+/**
+  This function computes the principal logarithm of a general matrix A (no eigenvalues on the
+  closed negative real axis), e.g. of a unitary time-overlap matrix, by the inverse scaling and squaring:
+
+  log(A) = 2^k * log(A^{1/2^k}),  where A^{1/2^k} is close to I, so the series
+
+  log(I + Y) = 2 * atanh(Z) = 2 * (Z + Z^3/3 + Z^5/5 + ...),  Z = Y * (2I + Y)^{-1}
+
+  converges quickly. The square roots are found by the Denman-Beavers iteration.
+  \param[out] res the result
+  \param[in] A input matrix
+*/
+
+  check_square(A, res, "log_matrix");
+
+  int n = A.n_cols;
+  int k, it;
+  MatrixXcd I = MatrixXcd::Identity(n, n);
+  MatrixXcd X(n, n);
+  X = Map<MatrixRMcd>(A.M, n, n);
+
+  // Square roots until X is close to I
+  for(k=0; k<64 && norm1(X - I) > 0.25; k++){
+
+    MatrixXcd Y = X;
+    MatrixXcd Z = I;
+
+    for(it=0; it<100; it++){
+      MatrixXcd Yi = Y.partialPivLu().inverse();
+      MatrixXcd Zi = Z.partialPivLu().inverse();
+      MatrixXcd Yn = 0.5*(Y + Zi);
+      Z = 0.5*(Z + Yi);
+      double dY = norm1(Yn - Y);
+      Y = Yn;
+      if(dY <= 1e-15 * norm1(Y)){ break; }
+    }
+    if(it==100 || !Y.allFinite()){
+      cout<<"Error in libmeigen::log_matrix : the square root iterations did not converge - the matrix\n"
+          <<"is likely singular or has eigenvalues on the negative real axis\nExiting...\n";
+      exit(0);
+    }
+
+    X = Y;
+  }
+
+  if(k==64){
+    cout<<"Error in libmeigen::log_matrix : can not bring the matrix close to identity\nExiting...\n";
+    exit(0);
+  }
+
+  MatrixXcd Z = (X - I) * (X + I).partialPivLu().inverse();
+  MatrixXcd Z2 = Z * Z;
+  MatrixXcd term = Z;
+  MatrixXcd L = Z;
+
+  for(int j=1; j<60; j++){
+    term = term * Z2;
+    MatrixXcd dL = term / double(2*j + 1);
+    L += dL;
+    if(norm1(dL) <= 1e-17 * norm1(L)){ break; }
+  }
+
+  Map<MatrixRMcd>(res.M, n, n) = L * (2.0 * pow(2.0, k));
+
+}
+
+
+
+void expm_pade(vector<CMATRIX>& res, vector<CMATRIX>& A, complex<double> dt){
+/**
+  The batched version of expm_pade: res[i] = exp(A[i]*dt) for all the matrices, in parallel
+*/
+
+  if(res.size()!=A.size()){
+    cout<<"Error in libmeigen::expm_pade : the number of the output matrices is not the same as that of the input ones\n"; exit(0);
+  }
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i=0;i<A.size();i++){  expm_pade(res[i], A[i], dt);  }
+
+}
+
+
+void exp_hermitian(vector<CMATRIX>& res, vector<CMATRIX>& H, complex<double> dt){
+/**
+  The batched version of exp_hermitian: res[i] = exp(H[i]*dt) for all the matrices, in parallel.
+  Every thread reuses its own workspace
+*/
+
+  if(res.size()!=H.size()){
+    cout<<"Error in libmeigen::exp_hermitian : the number of the output matrices is not the same as that of the input ones\n"; exit(0);
+  }
+
+  #pragma omp parallel
+  {
+    herm_workspace ws;
+
+    #pragma omp for schedule(dynamic)
+    for(int i=0;i<H.size();i++){  exp_hermitian(res[i], H[i], dt, ws);  }
+  }
+
+}
+
+
+void inv_sqrt_hermitian(vector<CMATRIX>& S, vector<CMATRIX>& S_i_half, double thresh){
+/**
+  The batched version of inv_sqrt_hermitian, in parallel. Every thread reuses its own workspace
+*/
+
+  if(S_i_half.size()!=S.size()){
+    cout<<"Error in libmeigen::inv_sqrt_hermitian : the number of the output matrices is not the same as that of the input ones\n"; exit(0);
+  }
+
+  #pragma omp parallel
+  {
+    herm_workspace ws;
+
+    #pragma omp for schedule(dynamic)
+    for(int i=0;i<S.size();i++){  inv_sqrt_hermitian(S[i], S_i_half[i], thresh, ws);  }
+  }
+
+}
+
+
+
+void sqrt_matrix(CMATRIX& S, CMATRIX& S_half, CMATRIX& S_i_half, double thresh, int do_phase_correction){
+/**
+  This function computes S^{1/2} and S^{-1/2} for given Hermitian matrix S
+
+  S is assumed to be Hermitian and this is not checked: the self-adjoint eigensolver reads only
+  its lower triangle, so for a non-Hermitian S the result is that of a different (Hermitian) matrix
+  \param[in] S Input matrix
+  \param[out] S_half Computed S^{1/2} matrix
+  \param[out] S_i_half Computed S^{-1/2} matrix
+  \param[in] threshold - if an absolute value of any eigenvalue of S is below this level, we stop,
+   throwing an error message
+
+  See sqrt_hermitian for the version with the reusable workspace
+*/
+
+  if(S.n_cols != S.n_rows){
+    cout<<"Error in libmeigen::sqrt_matrix : the input matrix is not square\n"; exit(0); 
+  }
+  if(S_half.n_cols != S_half.n_rows){
+    cout<<"Error in libmeigen::sqrt_matrix : the output S^{1/2} matrix is not square\n"; exit(0); 
+  }
+  if(S_i_half.n_cols != S_i_half.n_rows){
+    cout<<"Error in libmeigen::sqrt_matrix : the output S^{-1/2} matrix is not square\n"; exit(0); 
+  }
+  if(S.n_cols != S_half.n_cols){
+    cout<<"Error in libmeigen::sqrt_matrix : size of matrix S is not the same as that of matrix S^{1/2}\n"; exit(0); 
+  }
+  if(S.n_cols != S_i_half.n_cols){
+    cout<<"Error in libmeigen::sqrt_matrix : size of matrix S is not the same as that of matrix S^{-1/2}\n"; exit(0); 
+  }
+
+  herm_workspace ws(S.n_cols);
+  sqrt_hermitian(S, S_half, S_i_half, thresh, ws);
 
 }// sqrt_matrix
 
@@ -125,34 +512,15 @@ void exp_matrix(CMATRIX& res, CMATRIX& S, complex<double> dt, int do_phase_corre
   \param[in] S input matrix
   \param[in] dt scaling factor
 
+  The matrix S does not need to be normal: the exponential is computed by the Pade
+  scaling and squaring (see expm_pade). Use exp_hermitian for the Hermitian S
 */
 
   if(S.n_cols != S.n_rows){
     cout<<"Error in libmeigen::exp_matrix : the input matrix is not square\n"; exit(0); 
   }
 
-
-  int i,j;
- 
-  // Let us first diagonalize the input matrix x
-  int sz = S.n_cols;  
-  CMATRIX* C; C = new CMATRIX(sz, sz);  *C = complex<double>(0.0, 0.0);
-  CMATRIX* Seig; Seig = new CMATRIX(sz, sz);  *Seig = complex<double>(0.0,0.0);
-
-
-  // Find the eigenvalues of the the S matrix
-  solve_eigen(S, *Seig, *C, 0);  // S * C = C * Seig  ==>  S = C * Seig * C.H()
-
-  //if(do_phase_correction){   correct_phase(C);  }
-
-  
-  for(i=0;i<sz;i++){ res.M[i*sz+i]= std::exp(dt * Seig->get(i,i)); }
-
-  // Convert to the original basis
-  res = (*C) * res * ((*C).H());
-
-  delete C;
-  delete Seig;
+  expm_pade(res, S, dt);
 
 }// exp_matrix
 
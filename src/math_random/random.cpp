@@ -18,6 +18,36 @@ namespace liblibra{
 namespace librandom{
 
 
+std::string Random::get_state() const{
+/**
+  Returns the state of the own random number stream (see set_seed) as a string
+*/
+
+  if(!is_seeded){
+    cout<<"Error in Random::get_state: the state of the C library rand() stream can not be saved, use set_seed first\nExiting...\n";
+    exit(0);
+  }
+
+  stringstream ss;
+  ss<<engine;
+  return ss.str();
+}
+
+void Random::set_state(const std::string& state){
+/**
+  Restores the state of the own random number stream, as returned by get_state
+*/
+
+  stringstream ss(state);
+  ss>>engine;
+
+  if(ss.fail()){
+    cout<<"Error in Random::set_state: the state string is not valid\nExiting...\n"; exit(0);
+  }
+  is_seeded = 1;
+}
+
+
 int Random::fact(int k){
   if(k<=1){  return 1; }
   else{ return k*fact(k-1); }
@@ -56,7 +86,9 @@ void Random::bin(vector<double>& in,double minx,double maxx,double dx,vector< pa
 
 double Random::uniform(double a,double b){
 
-  double ksi = rand()/((double)RAND_MAX);
+  double ksi;
+  if(is_seeded){  ksi = engine()/((double)std::mt19937::max());  }
+  else{  ksi = rand()/((double)RAND_MAX);  }
   return (a + (b-a)*ksi);
 }
 double Random::p_uniform(double a,double b){
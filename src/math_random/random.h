@@ -27,6 +27,10 @@
 
 #endif 
 
+#include <random>
+#include <string>
+#include <sstream>
+
 /// liblibra namespace
 namespace liblibra{
 
@@ -42,11 +46,21 @@ class Random{
   double Gamma(double a);
   void bin(vector<double>& in,double minx,double maxx,double dx,vector< pair<double,double> >& out);
 
+  std::mt19937 engine;   ///< The own random number stream, used once the seed is set
+  int is_seeded;         ///< 0 - the C library rand() is used [default], 1 - the own stream is used
+
   public:
 
-  Random(){   srand(time(0)); }
+  Random(){   srand(time(0)); is_seeded = 0; }
+  Random(int seed){  set_seed(seed); }
   ~Random(){ ;; }
 
+  // Reproducible streams: the state of the own stream can be saved and restored (e.g. in checkpoints)
+  void set_seed(int seed){ engine.seed(seed); is_seeded = 1; }
+  int get_is_seeded() const { return is_seeded; }
+  std::string get_state() const;
+  void set_state(const std::string& state);
+
 
   // Uniform distribution
   double uniform(double a,double b);   // the random number of the disctribution below
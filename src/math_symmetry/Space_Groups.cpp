@@ -15,6 +15,7 @@
 */
 
 #include "Space_Groups.h"
+#include "Symmetry_Ops.h"
 
 
 /// liblibra namespace
@@ -57,24 +58,16 @@ void Apply_Symmetry(std::string space_group_name,VECTOR r,std::vector<VECTOR>& r
    double remx,remy,remz;
    double eps = 1e-5;
 
-   SPACE_GROUP sg(space_group_name);
-   MATRIX mr(4,1); 
-          mr.M[0] = r.x;
-          mr.M[1] = r.y;
-          mr.M[2] = r.z;
-          mr.M[3] = 1.0;
-   MATRIX R(3,1);
+   // The group is compiled once and then reused by all the subsequent calls
+   const compiled_space_group& sg = get_space_group(space_group_name);
    VECTOR vR;
 
    // Add original point to list of equivalent positions
    r_equiv.push_back(r);
 
-   for(int i=0;i<sg.operators.size();i++){
+   for(int i=0;i<sg.nops;i++){
 
-       R = sg.operators[i]*mr;
-       vR.x = R.M[0];
-       vR.y = R.M[1];
-       vR.z = R.M[2];
+       vR = sg.apply(i, r);
 
        /* Now check if this vector can be obtained from one of
           the already included positions by integer translations
@@ -0,0 +1,317 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Symmetry_Ops.cpp
+  \brief The file implements the compiled space groups, the batch application of the symmetry
+  operations and the maps of the symmetry-equivalent atoms
+
+*/
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "Space_Groups.h"
+#include "Symmetry_Ops.h"
+
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace std;
+using namespace liblinalg;
+
+/// libsymmetry namespace
+namespace libsymmetry{
+
+
+
+compiled_space_group::compiled_space_group(SPACE_GROUP& sg, std::string _name){
+/**
+  \brief Flatten the 3x4 operator matrices of the space group
+  \param[in] sg The space group
+  \param[in] _name The name of the space group
+*/
+
+  name = _name;
+  nops = sg.operators.size();
+  rot = vector<double>(9*nops, 0.0);
+  trans = vector<double>(3*nops, 0.0);
+
+  for(int op=0; op<nops; op++){
+    for(int i=0;i<3;i++){
+      for(int j=0;j<3;j++){  rot[9*op + 3*i + j] = sg.operators[op].get(i, j);  }
+      trans[3*op + i] = sg.operators[op].get(i, 3);
+    }
+  }
+
+}
+
+
+MATRIX compiled_space_group::get_rotation(int op) const{
+/**
+  \brief Returns the 3x3 rotation/reflection part of the operation op
+*/
+
+  MATRIX res(3,3);
+  for(int i=0;i<9;i++){ res.M[i] = rot[9*op + i]; }
+  return res;
+}
+
+VECTOR compiled_space_group::get_translation(int op) const{
+/**
+  \brief Returns the translation part (fractional) of the operation op
+*/
+
+  VECTOR res(trans[3*op+0], trans[3*op+1], trans[3*op+2]);
+  return res;
+}
+
+
+VECTOR compiled_space_group::apply(int op, const VECTOR& x) const{
+/**
+  \brief Apply the operation op to a point with the fractional coordinates x
+*/
+
+  const double* R = &rot[9*op];
+  const double* t = &trans[3*op];
+
+  VECTOR res( R[0]*x.x + R[1]*x.y + R[2]*x.z + t[0],
+              R[3]*x.x + R[4]*x.y + R[5]*x.z + t[1],
+              R[6]*x.x + R[7]*x.y + R[8]*x.z + t[2] );
+  return res;
+}
+
+
+void compiled_space_group::apply(const vector<VECTOR>& x, vector<VECTOR>& res) const{
+/**
+  \brief Apply all the operations of the group to all the points
+  \param[in] x The fractional coordinates of N points
+  \param[out] res The images: res[op*N + a] is the image of the point a under the operation op;
+  the list is resized to nops*N
+*/
+
+  int N = x.size();
+  res.resize(nops*N);
+
+  for(int op=0; op<nops; op++){
+    const double* R = &rot[9*op];
+    const double* t = &trans[3*op];
+
+    for(int a=0; a<N; a++){
+      VECTOR& r = res[op*N + a];
+      r.x = R[0]*x[a].x + R[1]*x[a].y + R[2]*x[a].z + t[0];
+      r.y = R[3]*x[a].x + R[4]*x[a].y + R[5]*x[a].z + t[1];
+      r.z = R[6]*x[a].x + R[7]*x[a].y + R[8]*x[a].z + t[2];
+    }
+  }
+
+}
+
+vector<VECTOR> compiled_space_group::apply(const vector<VECTOR>& x) const{
+/**
+  \brief Same as above, but the images are returned
+*/
+
+  vector<VECTOR> res;
+  apply(x, res);
+  return res;
+}
+
+
+
+const compiled_space_group& get_space_group(std::string name){
+/**
+  \brief Returns the compiled space group with a given name
+
+  The group is built from its name only the first time it is requested, then it is kept in
+  the table for the rest of the run. The function is thread-safe.
+*/
+
+  static std::mutex mtx;
+  static std::map<std::string, compiled_space_group> table;
+
+  std::lock_guard<std::mutex> lock(mtx);
+
+  std::map<std::string, compiled_space_group>::iterator it = table.find(name);
+  if(it!=table.end()){ return it->second; }
+
+  SPACE_GROUP sg(name);
+  if(sg.operators.size()==0){
+    cout<<"Error in get_space_group: the space group "<<name<<" is not known\nExiting...\n";
+    exit(0);
+  }
+
+  table[name] = compiled_space_group(sg, name);
+
+  return table[name];
+}
+
+
+
+
+// The cell of the spatial hash that contains the point (wrapped into the unit cell)
+inline void hash_cell(const VECTOR& w, int nb, int* c){
+
+  c[0] = int(w.x * nb);  if(c[0]>=nb){ c[0] = nb-1; }
+  c[1] = int(w.y * nb);  if(c[1]>=nb){ c[1] = nb-1; }
+  c[2] = int(w.z * nb);  if(c[2]>=nb){ c[2] = nb-1; }
+}
+
+inline long long hash_key(int cx, int cy, int cz, int nb){
+
+  cx = (cx + nb) % nb;  cy = (cy + nb) % nb;  cz = (cz + nb) % nb;
+  return ((long long)cx * nb + cy) * nb + cz;
+}
+
+inline VECTOR wrap_frac(const VECTOR& x){
+
+  VECTOR w(x.x - std::floor(x.x), x.y - std::floor(x.y), x.z - std::floor(x.z));
+  return w;
+}
+
+
+symmetry_atom_map::symmetry_atom_map
+(const compiled_space_group& g, const vector<VECTOR>& x, const vector<int>& types, double _tol){
+/**
+  \brief Find the symmetry-equivalent atoms of a periodic structure
+  \param[in] g The space group
+  \param[in] x The fractional coordinates of the atoms in the unit cell
+  \param[in] types The types (e.g. element indices) of the atoms - only the atoms of the same type can be equivalent
+  \param[in] _tol The tolerance: two positions match if they differ by less than _tol in each fractional
+  coordinate, modulo the lattice translations
+
+  The atoms are stored in a spatial hash over the unit cell with the cells of the size of at least
+  2*_tol, so the image of each atom is looked up among the atoms of the 27 neighboring cells only.
+  This makes the cost O(nops * natoms) instead of O(nops * natoms^2). The operations under which at
+  least one atom has no image are not the symmetries of the structure and are not included in valid_ops.
+*/
+
+  int a, b, op;
+
+  natoms = x.size();
+  tol = _tol;
+
+  if(types.size()!=natoms){
+    cout<<"Error in symmetry_atom_map: the size of the types ("<<types.size()
+        <<") is not equal to the number of atoms ("<<natoms<<")\nExiting...\n";
+    exit(0);
+  }
+  if(tol<=0.0){
+    cout<<"Error in symmetry_atom_map: the tolerance must be positive\nExiting...\n";
+    exit(0);
+  }
+
+  // The spatial hash
+  int nb = int(0.5/tol);
+  if(nb<1){ nb = 1; }
+  if(nb>1024){ nb = 1024; }
+
+  vector<VECTOR> w(natoms);
+  std::unordered_map<long long, vector<int> > grid;
+
+  for(a=0; a<natoms; a++){
+    int c[3];
+    w[a] = wrap_frac(x[a]);
+    hash_cell(w[a], nb, c);
+    grid[hash_key(c[0], c[1], c[2], nb)].push_back(a);
+  }
+
+  // The images of all atoms under all operations
+  vector<VECTOR> img;
+  g.apply(x, img);
+
+  valid_ops.clear();
+  atom_map.clear();
+
+  vector<int> mp(natoms);
+
+  for(op=0; op<g.nops; op++){
+
+    int is_valid = 1;
+
+    for(a=0; a<natoms && is_valid; a++){
+
+      VECTOR wi; wi = wrap_frac(img[op*natoms + a]);
+      int c[3];
+      hash_cell(wi, nb, c);
+
+      int found = -1;
+      int sx = (nb>1) ? 1 : 0;   // with a single cell per direction, it is its only neighbor
+
+      for(int dx=-sx; dx<=sx && found<0; dx++){
+        for(int dy=-sx; dy<=sx && found<0; dy++){
+          for(int dz=-sx; dz<=sx && found<0; dz++){
+
+            std::unordered_map<long long, vector<int> >::iterator it;
+            it = grid.find(hash_key(c[0]+dx, c[1]+dy, c[2]+dz, nb));
+            if(it==grid.end()){ continue; }
+
+            for(int n=0; n<it->second.size(); n++){
+              b = it->second[n];
+              if(types[b]!=types[a]){ continue; }
+
+              VECTOR d; d = wi - w[b];
+              d.x -= std::round(d.x);  d.y -= std::round(d.y);  d.z -= std::round(d.z);
+
+              if(std::fabs(d.x)<tol && std::fabs(d.y)<tol && std::fabs(d.z)<tol){ found = b; break; }
+            }
+
+          }// for dz
+        }// for dy
+      }// for dx
+
+      if(found<0){ is_valid = 0; }
+      else{ mp[a] = found; }
+
+    }// for a
+
+    if(is_valid){
+      valid_ops.push_back(op);
+      atom_map.push_back(mp);
+    }
+
+  }// for op
+
+
+  // The orbits: the lowest index in each orbit is its representative
+  irreducible = vector<int>(natoms, -1);
+  irreducible_op = vector<int>(natoms, -1);
+
+  for(a=0; a<natoms; a++){
+    if(irreducible[a]>=0){ continue; }
+
+    irreducible[a] = a;
+    for(int k=0; k<valid_ops.size(); k++){
+      b = atom_map[k][a];
+      if(irreducible[b]<0){ irreducible[b] = a; irreducible_op[b] = k; }
+      if(b==a && irreducible_op[a]<0){ irreducible_op[a] = k; }
+    }
+  }
+
+}
+
+
+vector<int> symmetry_atom_map::get_irreducible_atoms() const{
+/**
+  \brief Returns the list of the symmetry-unique atoms (the representatives of all orbits)
+*/
+
+  vector<int> res;
+  for(int a=0; a<natoms; a++){  if(irreducible[a]==a){ res.push_back(a); }  }
+  return res;
+}
+
+
+
+}//namespace libsymmetry
+}//namespace liblibra
+
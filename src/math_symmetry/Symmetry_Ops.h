@@ -0,0 +1,107 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Symmetry_Ops.h
+  \brief The file describes the compiled space groups, the batch application of the symmetry
+  operations and the maps of the symmetry-equivalent atoms
+
+*/
+
+#ifndef SYMMETRY_OPS_H
+#define SYMMETRY_OPS_H
+
+#if defined(USING_PCH)
+#include "../pch.h"
+#else
+#include <string>
+#include <vector>
+#endif
+
+#include "../math_linalg/liblinalg.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+
+/// libsymmetry namespace
+namespace libsymmetry{
+
+
+class SPACE_GROUP;
+
+
+class compiled_space_group{
+/**
+  The symmetry operations of a space group in the flat form: x' = R * x + t, where x are the
+  fractional coordinates. Unlike SPACE_GROUP, the object does not need to parse the group name
+  each time it is used - see get_space_group()
+*/
+
+public:
+
+  std::string name;         ///< the name of the space group
+  int nops;                 ///< the number of the symmetry operations
+  vector<double> rot;       ///< the rotation/reflection parts: nops x 9, rot[9*op + 3*i + j] = R_op(i,j)
+  vector<double> trans;     ///< the translation parts (fractional): nops x 3, trans[3*op + i] = t_op(i)
+
+
+  compiled_space_group(){ name = ""; nops = 0; }
+  compiled_space_group(SPACE_GROUP& sg, std::string _name);
+  compiled_space_group(const compiled_space_group& x){ *this = x; }
+  ~compiled_space_group(){ }
+
+  MATRIX get_rotation(int op) const;
+  VECTOR get_translation(int op) const;
+
+  VECTOR apply(int op, const VECTOR& x) const;
+  void apply(const vector<VECTOR>& x, vector<VECTOR>& res) const;
+  vector<VECTOR> apply(const vector<VECTOR>& x) const;
+
+};
+
+
+const compiled_space_group& get_space_group(std::string name);
+
+
+
+class symmetry_atom_map{
+/**
+  The map of the symmetry-equivalent atoms of a periodic structure: which atom each symmetry
+  operation of the group takes each atom to (modulo the lattice translations)
+*/
+
+public:
+
+  int natoms;                       ///< the number of atoms
+  double tol;                       ///< the tolerance of the positions matching (fractional units)
+  vector<int> valid_ops;            ///< the operations of the group that map the structure onto itself
+  vector< vector<int> > atom_map;   ///< atom_map[k][a] - the atom onto which the operation valid_ops[k] maps the atom a
+  vector<int> irreducible;          ///< irreducible[a] - the representative (the lowest index) of the orbit of the atom a
+  vector<int> irreducible_op;       ///< irreducible_op[a] - the index k (in valid_ops) of the operation that maps irreducible[a] onto a
+
+
+  symmetry_atom_map(){ natoms = 0; tol = 1e-4; }
+  symmetry_atom_map(const compiled_space_group& g, const vector<VECTOR>& x, const vector<int>& types, double _tol);
+  symmetry_atom_map(const symmetry_atom_map& x){ *this = x; }
+  ~symmetry_atom_map(){ }
+
+  vector<int> get_irreducible_atoms() const;
+
+};
+
+
+
+}// namespace libsymmetry
+}// namespace liblibra
+
+
+#endif // SYMMETRY_OPS_H
@@ -47,6 +47,9 @@ void export_symmetry_objects(){
   void (*expt_Apply_Symmetry_v1)(std::string space_group_name,VECTOR r,std::vector<VECTOR>& r_equiv) = &Apply_Symmetry;
 //  voi (*expt_Apply_Symmetry_v1)(std::string space_group_name,VECTOR r,std::vector<VECTOR>& r_equiv) = &Apply_Symmetry;
 
+  VECTOR (compiled_space_group::*expt_apply_v1)(int op, const VECTOR& x) const = &compiled_space_group::apply;
+  vector<VECTOR> (compiled_space_group::*expt_apply_v2)(const vector<VECTOR>& x) const = &compiled_space_group::apply;
+
   class_<SPACE_GROUP>("SPACE_GROUP",init<>())
       .def(init<std::string>())
       .def("__copy__", &generic__copy__<SPACE_GROUP>) 
@@ -58,6 +61,35 @@ void export_symmetry_objects(){
   def("Apply_Symmetry",expt_Apply_Symmetry_v1);
 
 
+  class_<compiled_space_group>("compiled_space_group",init<>())
+      .def(init<SPACE_GROUP&, std::string>())
+      .def("__copy__", &generic__copy__<compiled_space_group>) 
+      .def("__deepcopy__", &generic__deepcopy__<compiled_space_group>)
+      .def_readonly("name",&compiled_space_group::name)
+      .def_readonly("nops",&compiled_space_group::nops)
+      .def("get_rotation", &compiled_space_group::get_rotation)
+      .def("get_translation", &compiled_space_group::get_translation)
+      .def("apply", expt_apply_v1)
+      .def("apply", expt_apply_v2)
+  ;
+
+  def("get_space_group", &get_space_group, return_value_policy<copy_const_reference>());
+
+
+  class_<symmetry_atom_map>("symmetry_atom_map",init<>())
+      .def(init<const compiled_space_group&, const vector<VECTOR>&, const vector<int>&, double>())
+      .def("__copy__", &generic__copy__<symmetry_atom_map>) 
+      .def("__deepcopy__", &generic__deepcopy__<symmetry_atom_map>)
+      .def_readonly("natoms",&symmetry_atom_map::natoms)
+      .def_readonly("tol",&symmetry_atom_map::tol)
+      .def_readonly("valid_ops",&symmetry_atom_map::valid_ops)
+      .def_readonly("atom_map",&symmetry_atom_map::atom_map)
+      .def_readonly("irreducible",&symmetry_atom_map::irreducible)
+      .def_readonly("irreducible_op",&symmetry_atom_map::irreducible_op)
+      .def("get_irreducible_atoms", &symmetry_atom_map::get_irreducible_atoms)
+  ;
+
+
 
 }// export_symmetry_objects()
 
@@ -0,0 +1,330 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Model_LVC.cpp
+  \brief The file implements the linear (and quadratic) vibronic coupling model of arbitrary
+  numbers of states and modes, and the spin-boson and Holstein-Peierls models built on it
+
+  The model Hamiltonian:
+
+  H_ij = E0_ij + delta_ij * sum_k { 0.5 * m_k * omega_k^2 * q_k^2 }
+       + sum_{(i,j,k) terms}   c_ijk  * q_k
+       + sum_{(i,j,k,l) terms} c_ijkl * q_k * q_l
+
+  Only the nonzero coupling terms are stored and evaluated. The terms with i != j are applied
+  to both H_ij and H_ji; the quadratic terms with k != l are listed once for every pair of modes.
+  The diabatic states are orthonormal and do not depend on q, so Sdia = I and dc1_dia = 0.
+
+  The flat list of parameters (as produced by set_params_LVC):
+
+  params[0] = nst,  params[1] = ndof,  params[2] = nlin,  params[3] = nquad,
+  E0 [nst x nst, row-wise],  omega [ndof],  mass [ndof],
+  nlin terms (i, j, k, c),  nquad terms (i, j, k, l, c)
+*/
+
+#include "Model_LVC.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+
+/// libmodels namespace
+namespace libmodels{
+
+
+vector<double> set_params_LVC(int nst, int ndof, MATRIX& E0, vector<double>& omega, vector<double>& mass,
+                              MATRIX& lin_terms, MATRIX& quad_terms){
+/**
+  Pack the parameters of the LVC/QVC model into the flat list used by model_LVC
+
+  \param[in] nst The number of the electronic states
+  \param[in] ndof The number of the vibrational modes
+  \param[in] E0 MATRIX(nst, nst) - the constant (symmetric) part of the diabatic Hamiltonian [Ha]
+  \param[in] omega The frequencies of the modes [Ha]
+  \param[in] mass The masses of the modes (use 1.0 for the mass-weighted coordinates) [a.u.]
+  \param[in] lin_terms MATRIX(nlin, 4) - every row is (i, j, k, c): H_ij += c * q_k
+  \param[in] quad_terms MATRIX(nquad, 5) - every row is (i, j, k, l, c): H_ij += c * q_k * q_l
+*/
+
+  int i, t;
+
+  if(E0.n_rows!=nst || E0.n_cols!=nst){
+    cout<<"Error in set_params_LVC: E0 must be a "<<nst<<" x "<<nst<<" matrix\nExiting...\n"; exit(0);
+  }
+  if((int)omega.size()!=ndof || (int)mass.size()!=ndof){
+    cout<<"Error in set_params_LVC: omega and mass must have "<<ndof<<" elements\nExiting...\n"; exit(0);
+  }
+  if(lin_terms.n_rows>0 && lin_terms.n_cols!=4){
+    cout<<"Error in set_params_LVC: every linear term must be (i, j, k, c)\nExiting...\n"; exit(0);
+  }
+  if(quad_terms.n_rows>0 && quad_terms.n_cols!=5){
+    cout<<"Error in set_params_LVC: every quadratic term must be (i, j, k, l, c)\nExiting...\n"; exit(0);
+  }
+
+  int nlin = lin_terms.n_rows;
+  int nquad = quad_terms.n_rows;
+
+  vector<double> params;
+  params.reserve(4 + nst*nst + 2*ndof + 4*nlin + 5*nquad);
+
+  params.push_back(nst);  params.push_back(ndof);
+  params.push_back(nlin); params.push_back(nquad);
+
+  for(i=0;i<nst*nst;i++){ params.push_back(E0.M[i]); }
+  for(i=0;i<ndof;i++){ params.push_back(omega[i]); }
+  for(i=0;i<ndof;i++){ params.push_back(mass[i]); }
+
+  for(t=0;t<nlin;t++){
+    int a = (int)lin_terms.get(t,0), b = (int)lin_terms.get(t,1), k = (int)lin_terms.get(t,2);
+    if(a<0 || a>=nst || b<0 || b>=nst || k<0 || k>=ndof){
+      cout<<"Error in set_params_LVC: the linear term "<<t<<" refers to a nonexistent state or mode\nExiting...\n"; exit(0);
+    }
+    params.push_back(a); params.push_back(b); params.push_back(k); params.push_back(lin_terms.get(t,3));
+  }
+
+  for(t=0;t<nquad;t++){
+    int a = (int)quad_terms.get(t,0), b = (int)quad_terms.get(t,1);
+    int k = (int)quad_terms.get(t,2), l = (int)quad_terms.get(t,3);
+    if(a<0 || a>=nst || b<0 || b>=nst || k<0 || k>=ndof || l<0 || l>=ndof){
+      cout<<"Error in set_params_LVC: the quadratic term "<<t<<" refers to a nonexistent state or mode\nExiting...\n"; exit(0);
+    }
+    params.push_back(a); params.push_back(b); params.push_back(k); params.push_back(l); params.push_back(quad_terms.get(t,4));
+  }
+
+  return params;
+}
+
+
+vector<double> set_params_LVC(int nst, int ndof, MATRIX& E0, vector<double>& omega, vector<double>& mass,
+                              MATRIX& lin_terms){
+/**
+  Same as above, with no quadratic terms (pure LVC)
+*/
+
+  MATRIX quad_terms(0, 5);
+  return set_params_LVC(nst, ndof, E0, omega, mass, lin_terms, quad_terms);
+}
+
+
+
+vector<double> set_params_spin_boson(double eps, double Delta, int nmodes, int spectral_density, 
+                                     double strength, double omega_c){
+/**
+  The spin-boson model with the bath spectral density discretized into nmodes modes (unit masses):
+
+  H_00 =  eps + sum_k c_k q_k + V_bath,    H_11 = -eps - sum_k c_k q_k + V_bath,    H_01 = Delta
+  V_bath = sum_k 0.5 * omega_k^2 * q_k^2
+
+  \param[in] spectral_density The form of J(w) = pi/2 * sum_k c_k^2 / omega_k * delta(w - omega_k):
+
+    0 - Ohmic with exponential cutoff:  J(w) = pi/2 * xi * w * exp(-w/omega_c),  strength = xi (Kondo parameter)
+        omega_k = -omega_c * ln( (k + 0.5) / nmodes ),  c_k = omega_k * sqrt( xi * omega_c / nmodes )
+
+    1 - Debye:  J(w) = 2 * lambda * omega_c * w / (w^2 + omega_c^2),  strength = lambda (reorganization energy)
+        omega_k = omega_c * tan( pi/2 * (1 - (k+1)/(nmodes+1)) ),  c_k = omega_k * sqrt( 2 * lambda / (nmodes+1) )
+
+  Both discretizations reproduce the reorganization energy of the continuous J(w)
+*/
+
+  if(nmodes<1){ cout<<"Error in set_params_spin_boson: nmodes must be positive\nExiting...\n"; exit(0); }
+
+  vector<double> omega(nmodes, 0.0), mass(nmodes, 1.0), c(nmodes, 0.0);
+
+  for(int k=0;k<nmodes;k++){
+    if(spectral_density==0){
+      omega[k] = -omega_c * log( (k + 0.5) / double(nmodes) );
+      c[k] = omega[k] * sqrt( strength * omega_c / double(nmodes) );
+    }
+    else if(spectral_density==1){
+      omega[k] = omega_c * tan( 0.5*M_PI * (1.0 - (k + 1.0)/(nmodes + 1.0)) );
+      c[k] = omega[k] * sqrt( 2.0 * strength / (nmodes + 1.0) );
+    }
+    else{
+      cout<<"Error in set_params_spin_boson: spectral_density = "<<spectral_density<<" is not defined\nExiting...\n"; exit(0);
+    }
+  }
+
+  MATRIX E0(2,2);
+  E0.set(0,0, eps);    E0.set(0,1, Delta);
+  E0.set(1,0, Delta);  E0.set(1,1, -eps);
+
+  MATRIX lin_terms(2*nmodes, 4);
+  for(int k=0;k<nmodes;k++){
+    lin_terms.set(2*k,   0, 0.0);  lin_terms.set(2*k,   1, 0.0);  lin_terms.set(2*k,   2, k);  lin_terms.set(2*k,   3,  c[k]);
+    lin_terms.set(2*k+1, 0, 1.0);  lin_terms.set(2*k+1, 1, 1.0);  lin_terms.set(2*k+1, 2, k);  lin_terms.set(2*k+1, 3, -c[k]);
+  }
+
+  return set_params_LVC(2, nmodes, E0, omega, mass, lin_terms);
+}
+
+
+
+vector<double> set_params_Holstein(int nsites, double eps, double J, double omega, double g, double alpha, 
+                                   int is_periodic){
+/**
+  The Holstein-Peierls chain of nsites sites (states), with one local mode (unit mass) per site:
+
+  H_nn = eps + g * q_n + V,   V = sum_n 0.5 * omega^2 * q_n^2
+  H_n,n+1 = J + alpha * (q_{n+1} - q_n)
+
+  alpha = 0 gives the Holstein (Frenkel exciton) model. With is_periodic = 1, the last
+  site is coupled to the first one (for nsites > 2)
+*/
+
+  if(nsites<1){ cout<<"Error in set_params_Holstein: nsites must be positive\nExiting...\n"; exit(0); }
+
+  int n, nbonds = nsites - 1;
+  if(is_periodic && nsites>2){ nbonds = nsites; }
+
+  MATRIX E0(nsites, nsites);
+  vector<double> om(nsites, omega), mass(nsites, 1.0);
+
+  int nlin = nsites + ( (alpha!=0.0) ? 2*nbonds : 0 );
+  MATRIX lin_terms(nlin, 4);
+
+  int t = 0;
+  for(n=0;n<nsites;n++){
+    E0.set(n,n, eps);
+    lin_terms.set(t,0, n); lin_terms.set(t,1, n); lin_terms.set(t,2, n); lin_terms.set(t,3, g);  t++;
+  }
+
+  for(int b=0;b<nbonds;b++){
+    n = b;
+    int m = (b + 1) % nsites;
+    E0.set(n,m, J);  E0.set(m,n, J);
+
+    if(alpha!=0.0){
+      lin_terms.set(t,0, n); lin_terms.set(t,1, m); lin_terms.set(t,2, m); lin_terms.set(t,3,  alpha);  t++;
+      lin_terms.set(t,0, n); lin_terms.set(t,1, m); lin_terms.set(t,2, n); lin_terms.set(t,3, -alpha);  t++;
+    }
+  }
+
+  return set_params_LVC(nsites, nsites, E0, om, mass, lin_terms);
+}
+
+
+
+void model_LVC(CMATRIX* Hdia, CMATRIX* Sdia, vector<CMATRIX*>& d1ham_dia, vector<CMATRIX*>& dc1_dia,
+               const vector<double>& q, const vector<double>& params){
+/**
+  The LVC/QVC Hamiltonian and its analytic derivatives, see the description at the top of the file.
+  This version writes directly into the matrices of the nHamiltonian
+
+  \param[out] Hdia  The Hamiltonian in the diabatic basis (diabatic Hamiltonian)
+  \param[out] Sdia  The overlap matrix in the diabatic basis
+  \param[out] d1ham_dia  The 1-st order derivatives of the diabatic Hamiltonian w.r.t. all nuclear DOFs
+  \param[out] dc1_dia  The 1-st order derivative couplings in the diabatic basis w.r.t. all nuclear DOFs
+  \param[in] q The nuclear DOFs
+  \param[in] params The model parameters, as produced by set_params_LVC, set_params_spin_boson or set_params_Holstein
+*/
+
+  if(params.size()<4){ cout<<"Error in model_LVC: the parameters are not defined, use set_params_LVC\nExiting...\n"; exit(0); }
+
+  int nst = (int)params[0];
+  int ndof = (int)params[1];
+  int nlin = (int)params[2];
+  int nquad = (int)params[3];
+
+  if((int)params.size() != 4 + nst*nst + 2*ndof + 4*nlin + 5*nquad){
+    cout<<"Error in model_LVC: the size of the parameters list is inconsistent, use set_params_LVC\nExiting...\n"; exit(0);
+  }
+  if((int)q.size()<ndof || (int)d1ham_dia.size()<ndof || (int)dc1_dia.size()<ndof || Hdia->n_rows!=nst){
+    cout<<"Error in model_LVC: the model has "<<nst<<" states and "<<ndof<<" modes, but the arguments are of different sizes\nExiting...\n"; exit(0);
+  }
+
+  int i, k, t;
+  int nst2 = nst * nst;
+  const double* E0 = &params[4];
+  const double* omega = E0 + nst2;
+  const double* mass = omega + ndof;
+  const double* lin = mass + ndof;
+  const double* quad = lin + 4*nlin;
+
+  complex<double>* H = Hdia->M;
+
+  *Sdia = complex<double>(0.0, 0.0);
+  for(i=0;i<nst;i++){ Sdia->M[i*nst+i] = 1.0; }
+
+  for(i=0;i<nst2;i++){ H[i] = E0[i]; }
+
+  // All the derivatives are reset, including those w.r.t. the DOFs beyond the model ones
+  for(k=0;k<(int)d1ham_dia.size();k++){ *d1ham_dia[k] = complex<double>(0.0, 0.0); }
+  for(k=0;k<(int)dc1_dia.size();k++){ *dc1_dia[k] = complex<double>(0.0, 0.0); }
+
+  // Reference harmonic potential, common to all states
+  double V0 = 0.0;
+  for(k=0;k<ndof;k++){
+    double mw2 = mass[k] * omega[k] * omega[k];
+    V0 += 0.5 * mw2 * q[k] * q[k];
+
+    CMATRIX& dH = *d1ham_dia[k];
+    for(i=0;i<nst;i++){ dH.M[i*nst+i] = mw2 * q[k]; }
+  }
+  for(i=0;i<nst;i++){ H[i*nst+i] += V0; }
+
+  // Linear couplings
+  for(t=0;t<nlin;t++){
+    const double* x = lin + 4*t;
+    int a = (int)x[0], b = (int)x[1];
+    k = (int)x[2];
+    double c = x[3];
+
+    complex<double>* dH = d1ham_dia[k]->M;
+
+    H[a*nst+b] += c * q[k];   dH[a*nst+b] += c;
+    if(a!=b){  H[b*nst+a] += c * q[k];   dH[b*nst+a] += c;  }
+  }
+
+  // Quadratic couplings
+  for(t=0;t<nquad;t++){
+    const double* x = quad + 5*t;
+    int a = (int)x[0], b = (int)x[1];
+    k = (int)x[2];
+    int l = (int)x[3];
+    double c = x[4];
+
+    complex<double>* dHk = d1ham_dia[k]->M;
+    complex<double>* dHl = d1ham_dia[l]->M;
+
+    double v = c * q[k] * q[l];
+    H[a*nst+b] += v;  if(a!=b){ H[b*nst+a] += v; }
+
+    if(k==l){
+      dHk[a*nst+b] += 2.0 * c * q[k];   if(a!=b){ dHk[b*nst+a] += 2.0 * c * q[k]; }
+    }
+    else{
+      dHk[a*nst+b] += c * q[l];   if(a!=b){ dHk[b*nst+a] += c * q[l]; }
+      dHl[a*nst+b] += c * q[k];   if(a!=b){ dHl[b*nst+a] += c * q[k]; }
+    }
+  }
+
+}
+
+
+void model_LVC(CMATRIX& Hdia, CMATRIX& Sdia, vector<CMATRIX>& d1ham_dia, vector<CMATRIX>& dc1_dia,
+               vector<double>& q, vector<double>& params){ 
+/*** 
+    To use with the nHamiltonian class - see the version above
+*/
+
+  vector<CMATRIX*> d1(d1ham_dia.size()), dc1(dc1_dia.size());
+  for(int k=0;k<(int)d1ham_dia.size();k++){ d1[k] = &d1ham_dia[k]; }
+  for(int k=0;k<(int)dc1_dia.size();k++){ dc1[k] = &dc1_dia[k]; }
+
+  model_LVC(&Hdia, &Sdia, d1, dc1, q, params);
+
+}
+
+
+}// namespace libmodels
+}// liblibra
+
@@ -0,0 +1,55 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Model_LVC.h
+  \brief The file describes the linear (and quadratic) vibronic coupling model of arbitrary
+  numbers of states and modes, and the spin-boson and Holstein-Peierls models built on it
+    
+*/
+
+#ifndef MODEL_LVC_H
+#define MODEL_LVC_H
+
+#include "../math_linalg/liblinalg.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+
+
+/// libmodels namespace
+namespace libmodels{
+
+
+vector<double> set_params_LVC(int nst, int ndof, MATRIX& E0, vector<double>& omega, vector<double>& mass,
+                              MATRIX& lin_terms, MATRIX& quad_terms);
+vector<double> set_params_LVC(int nst, int ndof, MATRIX& E0, vector<double>& omega, vector<double>& mass,
+                              MATRIX& lin_terms);
+
+vector<double> set_params_spin_boson(double eps, double Delta, int nmodes, int spectral_density, 
+                                     double strength, double omega_c);
+
+vector<double> set_params_Holstein(int nsites, double eps, double J, double omega, double g, double alpha, 
+                                   int is_periodic);
+
+
+void model_LVC(CMATRIX* Hdia, CMATRIX* Sdia, vector<CMATRIX*>& d1ham_dia, vector<CMATRIX*>& dc1_dia,
+               const vector<double>& q, const vector<double>& params);
+
+void model_LVC(CMATRIX& Hdia, CMATRIX& Sdia, vector<CMATRIX>& d1ham_dia, vector<CMATRIX>& dc1_dia,
+               vector<double>& q, vector<double>& params);
+
+
+}// namespace libmodels
+}// liblibra
+
+#endif // MODEL_LVC_H
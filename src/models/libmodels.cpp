@@ -125,6 +125,21 @@ void export_models_objects(){
   def("model_2S_1D_tanh", expt_model_2S_1D_tanh_v1);
 
 
+  vector<double> (*expt_set_params_LVC_v1)(int nst, int ndof, MATRIX& E0, vector<double>& omega, vector<double>& mass,
+                              MATRIX& lin_terms, MATRIX& quad_terms) = &set_params_LVC;
+  vector<double> (*expt_set_params_LVC_v2)(int nst, int ndof, MATRIX& E0, vector<double>& omega, vector<double>& mass,
+                              MATRIX& lin_terms) = &set_params_LVC;
+
+  void (*expt_model_LVC_v1)(CMATRIX& Hdia, CMATRIX& Sdia, vector<CMATRIX>& d1ham_dia, vector<CMATRIX>& dc1_dia,
+                     vector<double>& q, vector<double>& params) = &model_LVC;
+
+  def("set_params_LVC", expt_set_params_LVC_v1);
+  def("set_params_LVC", expt_set_params_LVC_v2);
+  def("set_params_spin_boson", set_params_spin_boson);
+  def("set_params_Holstein", set_params_Holstein);
+  def("model_LVC", expt_model_LVC_v1);
+
+
 
 }
 
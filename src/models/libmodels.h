@@ -27,6 +27,7 @@
 #include "Model_DAC.h"
 #include "Model_double_well.h"
 #include "Model_ECWR.h"
+#include "Model_LVC.h"
 #include "Model_Marcus.h"
 #include "Model_Rabi2.h"
 #include "Model_SAC.h"
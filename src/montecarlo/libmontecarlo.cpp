@@ -50,6 +50,99 @@ void export_montecarlo_objects(){
   def("metropolis_gau",expt_metropolis_gau_v1);
 
 
+  class_<mc_target>("mc_target",init<>())
+      .def(init<bp::object, bp::object>())
+      .def(init<bp::dict>())
+      .def(init<const mc_target&>())
+
+      .def_readwrite("target_type",&mc_target::target_type)
+      .def_readwrite("py_funct",&mc_target::py_funct)
+      .def_readwrite("py_params",&mc_target::py_params)
+      .def_readwrite("force_constants",&mc_target::force_constants)
+      .def_readwrite("frequencies",&mc_target::frequencies)
+      .def_readwrite("masses",&mc_target::masses)
+      .def_readwrite("x0",&mc_target::x0)
+      .def_readwrite("model",&mc_target::model)
+      .def_readwrite("model_params",&mc_target::model_params)
+      .def_readwrite("state",&mc_target::state)
+      .def_readwrite("Temperature",&mc_target::Temperature)
+
+      .def("set_parameters", &mc_target::set_parameters)
+      .def("model_energy", &mc_target::model_energy)
+      .def("log_density", &mc_target::log_density)
+  ;
+
+
+  vector<MATRIX> (mc_sampler::*expt_run_v1)(mc_target& target, MATRIX& dof) = &mc_sampler::run;
+  vector<MATRIX> (mc_sampler::*expt_run_v2)(mc_target& target, vector<MATRIX>& dofs) = &mc_sampler::run;
+
+  class_<mc_sampler>("mc_sampler",init<>())
+      .def(init<bp::dict>())
+      .def(init<const mc_sampler&>())
+
+      .def_readwrite("num_chains",&mc_sampler::num_chains)
+      .def_readwrite("sample_size",&mc_sampler::sample_size)
+      .def_readwrite("start_sampling",&mc_sampler::start_sampling)
+      .def_readwrite("thinning",&mc_sampler::thinning)
+      .def_readwrite("gau_var",&mc_sampler::gau_var)
+      .def_readwrite("temperatures",&mc_sampler::temperatures)
+      .def_readwrite("exchange_frequency",&mc_sampler::exchange_frequency)
+      .def_readwrite("is_adaptive",&mc_sampler::is_adaptive)
+      .def_readwrite("adaptation_frequency",&mc_sampler::adaptation_frequency)
+      .def_readwrite("num_threads",&mc_sampler::num_threads)
+      .def_readwrite("rng_seed",&mc_sampler::rng_seed)
+      .def_readwrite("is_rng_seed",&mc_sampler::is_rng_seed)
+      .def_readwrite("output_file",&mc_sampler::output_file)
+      .def_readwrite("output_buffer_size",&mc_sampler::output_buffer_size)
+      .def_readwrite("verbosity",&mc_sampler::verbosity)
+      .def_readwrite("acceptance",&mc_sampler::acceptance)
+      .def_readwrite("swap_acceptance",&mc_sampler::swap_acceptance)
+      .def_readwrite("last_states",&mc_sampler::last_states)
+
+      .def("set_parameters", &mc_sampler::set_parameters)
+      .def("show", &mc_sampler::show)
+      .def("run", expt_run_v1)
+      .def("run", expt_run_v2)
+  ;
+
+
+  vector<MATRIX> (*expt_metropolis_sample_v1)
+                 (mc_target& target, MATRIX& dof, bp::dict params) = &metropolis_sample;
+
+  def("metropolis_sample",expt_metropolis_sample_v1);
+
+
+  void (*expt_normal_modes_v1)
+       (MATRIX& hessian, vector<double>& mass, vector<double>& omega, MATRIX& modes) = &normal_modes;
+
+  def("normal_modes",expt_normal_modes_v1);
+
+
+  void (nm_sampler::*expt_sample_v1)(MATRIX& modes, vector<double>& omega, vector<double>& mass, 
+                                     MATRIX& q0, MATRIX& p0, MATRIX& q, MATRIX& p) = &nm_sampler::sample;
+  void (nm_sampler::*expt_sample_v2)(MATRIX& hessian, vector<double>& mass, 
+                                     MATRIX& q0, MATRIX& p0, MATRIX& q, MATRIX& p) = &nm_sampler::sample;
+
+  class_<nm_sampler>("nm_sampler",init<>())
+      .def(init<bp::dict>())
+      .def(init<const nm_sampler&>())
+
+      .def_readwrite("Temperature",&nm_sampler::Temperature)
+      .def_readwrite("is_quantum",&nm_sampler::is_quantum)
+      .def_readwrite("frozen_modes",&nm_sampler::frozen_modes)
+      .def_readwrite("freq_threshold",&nm_sampler::freq_threshold)
+      .def_readwrite("block_size",&nm_sampler::block_size)
+      .def_readwrite("num_threads",&nm_sampler::num_threads)
+      .def_readwrite("rng_seed",&nm_sampler::rng_seed)
+      .def_readwrite("is_rng_seed",&nm_sampler::is_rng_seed)
+
+      .def("set_parameters", &nm_sampler::set_parameters)
+      .def("widths", &nm_sampler::widths)
+      .def("sample", expt_sample_v1)
+      .def("sample", expt_sample_v2)
+  ;
+
+
 }// export_montecarlo_objects()
 
 
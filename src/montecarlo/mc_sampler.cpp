@@ -0,0 +1,445 @@
+/*********************************************************************************
+* Copyright (C) 2018-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file mc_sampler.cpp
+  \brief The file implements the multi-chain Metropolis sampler with the parallel tempering
+
+  References:
+
+  [1] Haario, H.; Saksman, E.; Tamminen, J. Bernoulli 2001, 7, 223 - adaptive Metropolis
+  [2] Earl, D. J.; Deem, M. W. Phys. Chem. Chem. Phys. 2005, 7, 3910 - parallel tempering
+    
+*/
+
+#if defined(USING_PCH)
+#include "../pch.h"
+#else
+#include <cmath>
+#include <random>
+#include <fstream>
+#endif
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "montecarlo.h"
+
+
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+using namespace libio;
+using namespace librandom;
+
+/// libmontecarlo namespace 
+namespace libmontecarlo{
+
+namespace bp = boost::python;
+
+
+/// Counts the samplers created so far, so the unseeded ones get different random streams
+static unsigned int mc_sampler_stream_counter = 0;
+
+
+
+mc_sampler::mc_sampler(){
+
+  num_chains = 1;
+  sample_size = 1;
+  start_sampling = 0;
+  thinning = 1;
+  gau_var = 0.1;
+  temperatures = vector<double>(1, 1.0);
+  exchange_frequency = 1;
+
+  is_adaptive = 0;
+  adaptation_frequency = 100;
+
+  num_threads = 0;
+  rng_seed = 0;  is_rng_seed = 0;
+
+  output_file = "";
+  output_buffer_size = 1000;
+  verbosity = 0;
+
+}
+
+
+mc_sampler::mc_sampler(bp::dict params) : mc_sampler(){
+
+  set_parameters(params);
+
+}
+
+
+void mc_sampler::set_parameters(bp::dict params){
+
+  std::string key;
+  for(int i=0;i<len(params.values());i++){
+    key = bp::extract<std::string>(params.keys()[i]);
+
+    if(key=="num_chains") { num_chains = bp::extract<int>(params.values()[i]);   }
+    else if(key=="sample_size") { sample_size = bp::extract<int>(params.values()[i]);   }
+    else if(key=="start_sampling") { start_sampling = bp::extract<int>(params.values()[i]);   }
+    else if(key=="thinning") { thinning = bp::extract<int>(params.values()[i]);   }
+    else if(key=="gau_var") { gau_var = bp::extract<double>(params.values()[i]); }
+    else if(key=="temperatures") {
+      temperatures.clear();
+      bp::list tmp = bp::extract<bp::list>(params.values()[i]);
+      for(int j=0; j<len(tmp); j++){  temperatures.push_back( bp::extract<double>(tmp[j]) );  }
+    }
+    else if(key=="exchange_frequency") { exchange_frequency = bp::extract<int>(params.values()[i]);   }
+    else if(key=="is_adaptive") { is_adaptive = bp::extract<int>(params.values()[i]);   }
+    else if(key=="adaptation_frequency") { adaptation_frequency = bp::extract<int>(params.values()[i]);   }
+    else if(key=="num_threads") { num_threads = bp::extract<int>(params.values()[i]);   }
+    else if(key=="rng_seed") { rng_seed = bp::extract<int>(params.values()[i]);  is_rng_seed = 1; }
+    else if(key=="output_file") { output_file = bp::extract<std::string>(params.values()[i]);   }
+    else if(key=="output_buffer_size") { output_buffer_size = bp::extract<int>(params.values()[i]);   }
+    else if(key=="verbosity") { verbosity = bp::extract<int>(params.values()[i]);   }
+
+  } // for i
+
+
+  // Sanity check
+  if(num_chains < 1){ num_chains = 1; }
+  if(thinning < 1){ thinning = 1; }
+  if(exchange_frequency < 1){ exchange_frequency = 1; }
+  if(adaptation_frequency < 1){ adaptation_frequency = 1; }
+  if(output_buffer_size < 1){ output_buffer_size = 1; }
+  if(temperatures.size()==0){ temperatures = vector<double>(1, 1.0); }
+
+  if(fabs(temperatures[0] - 1.0) > 1e-12){
+    cout<<"Error in mc_sampler::set_parameters: the first temperature factor must be 1.0, but it is "
+        <<temperatures[0]<<"\nExiting...\n"; exit(0);
+  }
+  for(int k=0; k<(int)temperatures.size(); k++){
+    if(temperatures[k] <= 0.0){
+      cout<<"Error in mc_sampler::set_parameters: the temperature factors must be positive\nExiting...\n"; exit(0);
+    }
+  }
+
+}
+
+
+void mc_sampler::show(){
+
+  cout<<"Sampling with parameters:\n";
+  cout<<"num_chains = "<<num_chains<<endl;
+  cout<<"sample_size = "<<sample_size<<endl;
+  cout<<"start_sampling = "<<start_sampling<<endl;
+  cout<<"thinning = "<<thinning<<endl;
+  cout<<"gau_var = "<<gau_var<<endl;
+  cout<<"temperatures = ";  for(int k=0; k<(int)temperatures.size(); k++){ cout<<temperatures[k]<<" "; }  cout<<endl;
+  cout<<"exchange_frequency = "<<exchange_frequency<<endl;
+  cout<<"is_adaptive = "<<is_adaptive<<endl;
+  cout<<"adaptation_frequency = "<<adaptation_frequency<<endl;
+  cout<<"num_threads = "<<num_threads<<endl;
+  if(is_rng_seed){ cout<<"rng_seed = "<<rng_seed<<endl; }
+  cout<<"output_file = "<<output_file<<endl;
+  cout<<"output_buffer_size = "<<output_buffer_size<<endl;
+  cout<<"verbosity = "<<verbosity<<endl;
+
+}
+
+
+
+static int cholesky(vector<double>& A, vector<double>& L, int n){
+/**
+  L * L^T = A for the symmetric positive-definite n x n matrix A (row-major)
+
+  Returns 1 on success, 0 if A is not positive-definite (L is not changed then)
+*/
+
+  vector<double> res(n*n, 0.0);
+
+  for(int i=0; i<n; i++){
+    for(int j=0; j<=i; j++){
+      double s = A[i*n+j];
+      for(int p=0; p<j; p++){ s -= res[i*n+p] * res[j*n+p]; }
+
+      if(i==j){
+        if(s <= 0.0){ return 0; }
+        res[i*n+i] = sqrt(s);
+      }
+      else{ res[i*n+j] = s / res[j*n+j]; }
+    }
+  }
+
+  L = res;
+  return 1;
+}
+
+
+static void write_samples(std::ofstream& out, int chain, vector<MATRIX>& buf){
+
+  for(int s=0; s<(int)buf.size(); s++){
+    out<<chain;
+    for(int i=0; i<buf[s].n_elts; i++){ out<<"  "<<buf[s].M[i]; }
+    out<<"\n";
+  }
+
+}
+
+
+
+vector<MATRIX> mc_sampler::run(mc_target& target, MATRIX& dof){
+/**
+  Runs all the chains starting from the same point dof - see the description of the overloaded version
+*/
+
+  vector<MATRIX> dofs(num_chains, dof);
+
+  return run(target, dofs);
+
+}
+
+
+vector<MATRIX> mc_sampler::run(mc_target& target, vector<MATRIX>& dofs){
+/**
+  Samples the target distribution with `num_chains` independent random-walk Metropolis chains
+
+  \param[in] target - the distribution to sample
+  \param[in] dofs - the starting points of the chains, one per chain
+
+  Each chain takes start_sampling + sample_size * thinning steps. A step is a Gaussian move of
+  every replica x' = x + L*z (z ~ N(0,1)), accepted with the probability min(1, [p(x')/p(x)]^(1/T_k)),
+  followed by the replica exchanges (every `exchange_frequency` steps) between the neighboring
+  temperatures, alternately the even and the odd pairs, accepted with the probability
+  min(1, [p(x_k+1)/p(x_k)]^(1/T_k - 1/T_k+1)). The rejected moves repeat the current state in the chain
+
+  L = gau_var * sqrt(T_k) * I initially; with is_adaptive = 1 it is replaced, during the burn-in,
+  by the Cholesky factor of 2.38^2/ndof * cov(x), the covariance of the replica states visited so far [1]
+
+  Returns:
+    the samples of the T=1 replicas, chain by chain: sample_size * num_chains matrices; the list is empty
+    if the samples are written to `output_file`
+
+  The Python targets are not thread-safe, so the chains are propagated serially for them
+
+  The chain c uses the random stream seeded with rng_seed + 7919 * c, so the run is reproducible for a given
+  rng_seed regardless of the number of threads. If rng_seed is not set, the streams are seeded from 
+  std::random_device - use this only when the reproducibility is not needed
+*/
+
+  if((int)dofs.size()!=num_chains){
+    cout<<"Error in mc_sampler::run: the number of the starting points ("<<dofs.size()
+        <<") is not equal to num_chains ("<<num_chains<<")\nExiting...\n"; exit(0);
+  }
+
+  int c, k;
+  int nchains = num_chains;
+  int ntemps = temperatures.size();
+  int ndof = dofs[0].n_elts;
+  int nsteps = start_sampling + sample_size * thinning;
+  int is_streaming = (output_file.size() > 0);
+
+  if(verbosity>0){ show(); }
+
+  //============ Parallel setup ==============
+  int nth = 1;
+#if defined(_OPENMP)
+  nth = omp_get_max_threads();
+#endif
+  if(num_threads > 0 && num_threads < nth){ nth = num_threads; }
+  if(nth > nchains){ nth = nchains; }
+  if(!target.is_native()){ nth = 1; }
+
+  //============ Random number streams, one per chain ==============
+  vector<std::mt19937> rng(nchains);
+  if(is_rng_seed){
+    for(c=0; c<nchains; c++){ rng[c].seed( rng_seed + 7919u * c ); }
+  }
+  else{
+    if(verbosity>0){ cout<<"mc_sampler::run: rng_seed is not set, the random streams are not reproducible\n"; }
+    std::random_device rd;
+    for(c=0; c<nchains; c++){ rng[c].seed( rd() + 7919u * (mc_sampler_stream_counter++) ); }
+  }
+
+  //============ Output ==============
+  std::ofstream out;
+  if(is_streaming){
+    out.open(output_file.c_str(), std::ios::out);
+    if(!out.is_open()){
+      cout<<"Error in mc_sampler::run: can not open the file "<<output_file<<"\nExiting...\n"; exit(0);
+    }
+  }
+
+  vector< vector<MATRIX> > samples(nchains);
+  vector<int> n_acc(nchains, 0);
+  vector< vector<int> > n_swap_att(nchains, vector<int>(ntemps, 0));
+  vector< vector<int> > n_swap_acc(nchains, vector<int>(ntemps, 0));
+  last_states = vector<MATRIX>(nchains, dofs[0]);
+
+
+  #pragma omp parallel for num_threads(nth) schedule(dynamic)
+  for(c=0; c<nchains; c++){
+
+    int r, i, j, step;
+    std::mt19937& gen = rng[c];
+    std::normal_distribution<double> gau(0.0, 1.0);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+    //========= Replicas of this chain ==========
+    vector<MATRIX> x(ntemps, dofs[c]);
+    MATRIX x_new(dofs[c]);
+    vector<double> logp(ntemps);
+    for(r=0; r<ntemps; r++){ logp[r] = target.log_density(x[r]); }
+
+    // The proposal factors L and the running statistics for the adaptation (Welford)
+    vector< vector<double> > L(ntemps, vector<double>(ndof*ndof, 0.0));
+    vector< vector<double> > mean(ntemps, vector<double>(ndof, 0.0));
+    vector< vector<double> > M2(ntemps, vector<double>(ndof*ndof, 0.0));
+    vector<double> z(ndof), dx(ndof);
+
+    for(r=0; r<ntemps; r++){
+      double w = gau_var * sqrt(temperatures[r]);
+      for(i=0; i<ndof; i++){ L[r][i*ndof+i] = w; }
+    }
+
+    if(!is_streaming){ samples[c].reserve(sample_size); }
+    vector<MATRIX> buf;
+
+    for(step=0; step<nsteps; step++){
+
+      //========= Metropolis moves ==========
+      for(r=0; r<ntemps; r++){
+
+        for(i=0; i<ndof; i++){ z[i] = gau(gen); }
+        for(i=0; i<ndof; i++){
+          double s = 0.0;
+          for(j=0; j<=i; j++){ s += L[r][i*ndof+j] * z[j]; }
+          x_new.M[i] = x[r].M[i] + s;
+        }
+
+        double lp_new = target.log_density(x_new);
+        double arg = (lp_new - logp[r]) / temperatures[r];
+
+        if(arg >= 0.0 || uni(gen) < exp(arg)){
+          x[r] = x_new;
+          logp[r] = lp_new;
+          if(r==0 && step >= start_sampling){ n_acc[c]++; }
+        }
+
+        //========= Adaptation of the proposal, only during the burn-in ==========
+        if(is_adaptive && step < start_sampling){
+          double n = step + 1;
+          for(i=0; i<ndof; i++){
+            dx[i] = x[r].M[i] - mean[r][i];
+            mean[r][i] += dx[i] / n;
+          }
+          for(i=0; i<ndof; i++){
+            for(j=0; j<ndof; j++){  M2[r][i*ndof+j] += dx[i] * (x[r].M[j] - mean[r][j]);  }
+          }
+
+          if((step+1) % adaptation_frequency == 0 && n > 2*ndof){
+            double scl = 2.38*2.38/double(ndof) / (n - 1.0);
+            vector<double> C(ndof*ndof);
+            for(i=0; i<ndof*ndof; i++){ C[i] = scl * M2[r][i]; }
+            for(i=0; i<ndof; i++){ C[i*ndof+i] += 1e-10 + 1e-8 * C[i*ndof+i]; }
+            cholesky(C, L[r], ndof);
+          }
+        }
+
+      }// for r
+
+      //========= Replica exchanges ==========
+      if(ntemps > 1 && (step+1) % exchange_frequency == 0){
+
+        for(k=((step+1)/exchange_frequency) % 2; k+1<ntemps; k+=2){
+          double arg = (logp[k+1] - logp[k]) * (1.0/temperatures[k] - 1.0/temperatures[k+1]);
+
+          n_swap_att[c][k]++;
+          if(arg >= 0.0 || uni(gen) < exp(arg)){
+            std::swap(x[k], x[k+1]);
+            std::swap(logp[k], logp[k+1]);
+            n_swap_acc[c][k]++;
+          }
+        }// for k
+      }
+
+      //========= Collect the samples ==========
+      if(step >= start_sampling && (step - start_sampling + 1) % thinning == 0){
+
+        if(is_streaming){
+          buf.push_back(x[0]);
+          if((int)buf.size() >= output_buffer_size){
+            #pragma omp critical(mc_sampler_output)
+            {  write_samples(out, c, buf);  }
+            buf.clear();
+          }
+        }
+        else{ samples[c].push_back(x[0]); }
+      }
+
+    }// for step
+
+    if(is_streaming && buf.size() > 0){
+      #pragma omp critical(mc_sampler_output)
+      {  write_samples(out, c, buf);  }
+    }
+
+    last_states[c] = x[0];
+
+  }// for c
+
+  if(is_streaming){ out.close(); }
+
+
+  //============ Statistics ==============
+  acceptance = vector<double>(nchains, 0.0);
+  for(c=0; c<nchains; c++){
+    if(nsteps > start_sampling){ acceptance[c] = double(n_acc[c]) / double(nsteps - start_sampling); }
+  }
+
+  swap_acceptance = vector<double>(ntemps > 1 ? ntemps-1 : 0, 0.0);
+  for(k=0; k+1<ntemps; k++){
+    int att = 0, acc = 0;
+    for(c=0; c<nchains; c++){ att += n_swap_att[c][k];  acc += n_swap_acc[c][k]; }
+    if(att > 0){ swap_acceptance[k] = double(acc) / double(att); }
+  }
+
+  if(verbosity>0){
+    for(c=0; c<nchains; c++){ cout<<"chain "<<c<<" acceptance = "<<acceptance[c]<<endl; }
+    for(k=0; k+1<ntemps; k++){ cout<<"replicas "<<k<<" <-> "<<k+1<<" exchange acceptance = "<<swap_acceptance[k]<<endl; }
+  }
+
+
+  vector<MATRIX> res;
+  if(!is_streaming){
+    res.reserve(nchains * sample_size);
+    for(c=0; c<nchains; c++){  res.insert(res.end(), samples[c].begin(), samples[c].end());  }
+  }
+
+  return res;
+
+}
+
+
+
+vector<MATRIX> metropolis_sample(mc_target& target, MATRIX& dof, bp::dict params){
+/**
+  A shortcut: sets up the mc_sampler with the params and runs it from the point dof
+*/
+
+  mc_sampler sampler(params);
+
+  return sampler.run(target, dof);
+
+}
+
+
+
+}// namespace libmontecarlo
+}// liblibra
+
@@ -0,0 +1,241 @@
+/*********************************************************************************
+* Copyright (C) 2018-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file mc_target.cpp
+  \brief The file implements the target probability densities of the Monte Carlo sampling
+    
+*/
+
+#if defined(USING_PCH)
+#include "../pch.h"
+#else
+#include <cmath>
+#include <limits>
+#endif
+
+#include "montecarlo.h"
+#include "../models/libmodels.h"
+
+
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+using namespace libio;
+using namespace libmodels;
+
+/// libmontecarlo namespace 
+namespace libmontecarlo{
+
+namespace bp = boost::python;
+
+
+
+mc_target::mc_target(){
+
+  target_type = 0;
+  model = 0;
+  state = -1;
+  Temperature = 300.0;
+
+}
+
+
+mc_target::mc_target(bp::object _py_funct, bp::object _py_params){
+
+  target_type = 0;
+  model = 0;
+  state = -1;
+  Temperature = 300.0;
+
+  py_funct = _py_funct;
+  py_params = _py_params;
+
+}
+
+
+mc_target::mc_target(bp::dict params){
+
+  target_type = 1;
+  model = 0;
+  state = -1;
+  Temperature = 300.0;
+
+  set_parameters(params);
+
+}
+
+
+void mc_target::set_parameters(bp::dict params){
+
+  std::string key;
+  for(int i=0;i<len(params.values());i++){
+    key = bp::extract<std::string>(params.keys()[i]);
+
+    if(key=="target_type") { target_type = bp::extract<int>(params.values()[i]);   }
+    else if(key=="Temperature") { Temperature = bp::extract<double>(params.values()[i]); }
+    else if(key=="model") { model = bp::extract<int>(params.values()[i]);   }
+    else if(key=="state") { state = bp::extract<int>(params.values()[i]);   }
+
+    else if(key=="force_constants") {
+      force_constants.clear();
+      bp::list tmp = bp::extract<bp::list>(params.values()[i]);
+      for(int j=0; j<len(tmp); j++){  force_constants.push_back( bp::extract<double>(tmp[j]) );  }
+    }
+    else if(key=="frequencies") {
+      frequencies.clear();
+      bp::list tmp = bp::extract<bp::list>(params.values()[i]);
+      for(int j=0; j<len(tmp); j++){  frequencies.push_back( bp::extract<double>(tmp[j]) );  }
+    }
+    else if(key=="masses") {
+      masses.clear();
+      bp::list tmp = bp::extract<bp::list>(params.values()[i]);
+      for(int j=0; j<len(tmp); j++){  masses.push_back( bp::extract<double>(tmp[j]) );  }
+    }
+    else if(key=="x0") {
+      x0.clear();
+      bp::list tmp = bp::extract<bp::list>(params.values()[i]);
+      for(int j=0; j<len(tmp); j++){  x0.push_back( bp::extract<double>(tmp[j]) );  }
+    }
+    else if(key=="model_params") {
+      model_params.clear();
+      bp::list tmp = bp::extract<bp::list>(params.values()[i]);
+      for(int j=0; j<len(tmp); j++){  model_params.push_back( bp::extract<double>(tmp[j]) );  }
+    }
+
+  } // for i
+
+  if(target_type<0 || target_type>3){
+    cout<<"Error in mc_target::set_parameters: target_type = "<<target_type<<" is not known\nExiting...\n"; exit(0);
+  }
+  if(target_type==3 && (model<0 || model>7)){
+    cout<<"Error in mc_target::set_parameters: model = "<<model<<" is not known\nExiting...\n"; exit(0);
+  }
+
+}
+
+
+
+double mc_target::model_energy(MATRIX& x){
+/**
+  The energy of the model at the point x: the diabatic energy of the `state` or, if state < 0,
+  the lowest eigenvalue of the diabatic Hamiltonian (the models have at most 2 states)
+*/
+
+  int nst = (model<=1) ? 1 : 2;
+  int ndof = (model==3) ? 2 : 1;
+
+  if(x.n_elts < ndof){
+    cout<<"Error in mc_target::model_energy: the model "<<model<<" needs "<<ndof<<" DOFs, but only "
+        <<x.n_elts<<" are given\nExiting...\n"; exit(0);
+  }
+
+  vector<double> q(ndof);
+  for(int i=0; i<ndof; i++){ q[i] = x.M[i]; }
+
+  CMATRIX Hdia(nst, nst);
+  CMATRIX Sdia(nst, nst);
+  vector<CMATRIX> d1ham_dia(ndof, CMATRIX(nst, nst));
+  vector<CMATRIX> dc1_dia(ndof, CMATRIX(nst, nst));
+
+  if(model==0){ model_1S_1D_poly2(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+  else if(model==1){ model_1S_1D_poly4(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+  else if(model==2){ model_2S_1D_sin(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+  else if(model==3){ model_2S_2D_sin(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+  else if(model==4){ model_2S_1D_tanh(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+  else if(model==5){ model_DAC(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+  else if(model==6){ model_ECWR(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+  else if(model==7){ model_SAC(Hdia, Sdia, d1ham_dia, dc1_dia, q, model_params); }
+
+  if(state>=0){
+    if(state>=nst){
+      cout<<"Error in mc_target::model_energy: state = "<<state<<" but the model has only "<<nst<<" states\nExiting...\n"; exit(0);
+    }
+    return Hdia.get(state, state).real();
+  }
+
+  if(nst==1){  return Hdia.get(0,0).real();  }
+
+  // The lower eigenvalue of the 2x2 Hermitian matrix
+  double h00 = Hdia.get(0,0).real();
+  double h11 = Hdia.get(1,1).real();
+  double h01 = std::abs(Hdia.get(0,1));
+  double dh = 0.5*(h00 - h11);
+
+  return 0.5*(h00 + h11) - sqrt(dh*dh + h01*h01);
+
+}
+
+
+
+double mc_target::log_density(MATRIX& x){
+/**
+  The logarithm of the (unnormalized) target probability density at the point x
+
+  Returns -infinity where the density is zero
+*/
+
+  const double kb = 3.166811429e-6; // Hartree/K
+  double res = 0.0;
+  int i;
+
+  if(target_type==0){
+    double p = bp::extract<double>( py_funct(x, py_params) );
+    if(p>0.0){ res = log(p); }
+    else{ res = -std::numeric_limits<double>::infinity(); }
+  }
+
+  else if(target_type==1){
+    double beta = 1.0/(kb*Temperature);
+    int n = x.n_elts;
+    if(force_constants.size()<n){
+      cout<<"Error in mc_target::log_density: "<<n<<" force constants are needed, but only "
+          <<force_constants.size()<<" are given\nExiting...\n"; exit(0);
+    }
+
+    for(i=0; i<n; i++){
+      double dx = x.M[i] - (i<x0.size() ? x0[i] : 0.0);
+      res -= 0.5 * beta * force_constants[i] * dx * dx;
+    }
+  }
+
+  else if(target_type==2){
+    int n = x.n_elts/2;
+    if(frequencies.size()<n || masses.size()<n){
+      cout<<"Error in mc_target::log_density: "<<n<<" frequencies and masses are needed, but only "
+          <<frequencies.size()<<" and "<<masses.size()<<" are given\nExiting...\n"; exit(0);
+    }
+
+    for(i=0; i<n; i++){
+      double w = frequencies[i];
+      double mw = masses[i] * w;
+      double th = tanh(0.5 * w / (kb*Temperature));
+      double dq = x.M[i] - (i<x0.size() ? x0[i] : 0.0);
+      double p = x.M[n+i];
+
+      res -= th * ( p*p/mw + mw*dq*dq );
+    }
+  }
+
+  else if(target_type==3){
+    res = -model_energy(x) / (kb*Temperature);
+  }
+
+  return res;
+
+}
+
+
+
+}// namespace libmontecarlo
+}// liblibra
+
@@ -42,6 +42,169 @@ vector<MATRIX> metropolis_gau(Random& rnd, bp::object target_distribution, MATRI
 
 
 
+class mc_target{
+/**
+  The target probability density of the Monte Carlo sampling, p(x) ~ exp(log_density(x))
+
+  Native targets are evaluated without the Python interpreter and may be used by many chains
+  in parallel; the Python target is always evaluated serially
+
+  Defined in: mc_target.cpp
+*/
+
+public:
+
+  /**
+    0 - Python function: p = target_distribution(x, distribution_params) [default]
+    1 - harmonic Boltzmann: p ~ exp( -sum_i 0.5 * k_i * (x_i - x0_i)^2 / (kB*T) )
+    2 - harmonic Wigner: the first half of the x elements are the coordinates q_i, the second half - the momenta p_i,
+        p ~ exp( -sum_i tanh(w_i/(2*kB*T)) * (p_i^2/(m_i*w_i) + m_i*w_i*(q_i-x0_i)^2) )
+    3 - Boltzmann distribution on the energy surface of the model from the `models` library:
+        p ~ exp( -E(x) / (kB*T) ), where E is the diabatic energy of the `state` or the ground adiabatic energy if state < 0
+  */
+  int target_type;
+
+  ///================= Python target ===================
+  bp::object py_funct;
+  bp::object py_params;
+
+  ///================= Harmonic and Wigner targets ===================
+  vector<double> force_constants;   ///< k_i, a.u.
+  vector<double> frequencies;       ///< w_i, a.u.
+  vector<double> masses;            ///< m_i, a.u.
+  vector<double> x0;                ///< the minima positions, a.u.; zero if not given
+
+  ///================= Model target ===================
+  /**
+    0 - model_1S_1D_poly2,   1 - model_1S_1D_poly4,   2 - model_2S_1D_sin,   3 - model_2S_2D_sin,
+    4 - model_2S_1D_tanh,    5 - model_DAC,           6 - model_ECWR,        7 - model_SAC
+  */
+  int model;
+  vector<double> model_params;
+  int state;
+
+  /// Temperature [K]
+  double Temperature;
+
+
+  mc_target();
+  mc_target(bp::object _py_funct, bp::object _py_params);
+  mc_target(bp::dict params);
+  mc_target(const mc_target& x){ *this = x; }
+  ~mc_target(){ ;; }
+
+  void set_parameters(bp::dict params);
+  int is_native(){ return target_type!=0; }
+  double model_energy(MATRIX& x);
+  double log_density(MATRIX& x);
+
+};
+
+
+
+class mc_sampler{
+/**
+  Multi-chain random-walk Metropolis sampler with the parallel tempering (replica exchange)
+
+  Every chain is made of `ntemps` replicas that sample p(x)^(1/T_k) for the temperature factors
+  T_k = temperatures[k] (T_0 = 1 is the target distribution). The chains are independent, each
+  has its own random number stream, and they are propagated in parallel with OpenMP
+
+  Defined in: mc_sampler.cpp
+*/
+
+public:
+
+  ///================= Parameters ===================
+  int num_chains;             ///< the number of independent chains
+  int sample_size;            ///< the number of the samples to collect from each chain
+  int start_sampling;         ///< the number of the first (burn-in) steps to disregard
+  int thinning;               ///< keep every `thinning`-th state of the chain
+  double gau_var;             ///< the initial width of the Gaussian proposal
+  vector<double> temperatures;///< the temperature factors of the replicas; only [1.0] - no tempering [default]
+  int exchange_frequency;     ///< attempt the replica exchanges every that many steps
+
+  /// Adapt the proposal covariance to the covariance of the chain (Haario et al.); only during the burn-in,
+  /// so the collected samples are from a proper Markov chain
+  int is_adaptive;
+  int adaptation_frequency;   ///< recompute the proposal every that many burn-in steps
+
+  int num_threads;            ///< the max number of the threads; 0 - all available OpenMP threads
+
+  /// The seed of the random number streams (one per chain), set by the "rng_seed" key of the parameters.
+  /// With the seed given, the samples are reproducible and do not depend on the number of threads.
+  /// Without it (is_rng_seed = 0), the streams are seeded from std::random_device, so every run is different
+  int rng_seed;  int is_rng_seed;
+
+  /// If not empty, the samples are written to this file as they are collected (one sample per line,
+  /// preceded by the chain index) rather than kept in memory
+  std::string output_file;
+  int output_buffer_size;     ///< the number of the samples kept in each chain buffer before a write
+  int verbosity;
+
+  ///================= Results of the last run ===================
+  vector<double> acceptance;       ///< the acceptance ratios of the T=1 replicas of all chains
+  vector<double> swap_acceptance;  ///< the acceptance ratios of the exchanges between the replicas k and k+1
+  vector<MATRIX> last_states;      ///< the final states of the T=1 replicas of all chains
+
+
+  mc_sampler();
+  mc_sampler(bp::dict params);
+  mc_sampler(const mc_sampler& x){ *this = x; }
+  ~mc_sampler(){ ;; }
+
+  void set_parameters(bp::dict params);
+  void show();
+
+  vector<MATRIX> run(mc_target& target, MATRIX& dof);
+  vector<MATRIX> run(mc_target& target, vector<MATRIX>& dofs);
+
+};
+
+
+vector<MATRIX> metropolis_sample(mc_target& target, MATRIX& dof, bp::dict params);
+
+
+
+void normal_modes(MATRIX& hessian, vector<double>& mass, vector<double>& omega, MATRIX& modes);
+
+
+class nm_sampler{
+/**
+  Direct (not Markov chain) sampler of the nuclear initial conditions from the Wigner or the
+  Boltzmann distributions of the harmonic normal modes. The whole ensemble is generated at once
+
+  Defined in: nm_sampler.cpp
+*/
+
+public:
+
+  double Temperature;         ///< Temperature [K, default: 300.0]
+  int is_quantum;             ///< 1 - Wigner distribution [default], 0 - classical Boltzmann distribution
+  vector<int> frozen_modes;   ///< the indices of the modes that are not sampled (Q = P = 0)
+  double freq_threshold;      ///< the modes with the frequencies below this are frozen [a.u., default: 1e-6]
+  int block_size;             ///< the number of trajectories per random stream [default: 256]
+
+  int num_threads;            ///< the max number of the threads; 0 - all available OpenMP threads
+  int rng_seed;  int is_rng_seed;
+
+
+  nm_sampler();
+  nm_sampler(bp::dict params);
+  nm_sampler(const nm_sampler& x){ *this = x; }
+  ~nm_sampler(){ ;; }
+
+  void set_parameters(bp::dict params);
+  void widths(vector<double>& omega, vector<double>& sigma_q, vector<double>& sigma_p);
+
+  void sample(MATRIX& modes, vector<double>& omega, vector<double>& mass, MATRIX& q0, MATRIX& p0, MATRIX& q, MATRIX& p);
+  void sample(MATRIX& hessian, vector<double>& mass, MATRIX& q0, MATRIX& p0, MATRIX& q, MATRIX& p);
+
+};
+
+
+
+
 }// namespace libmontecarlo
 }// liblibra
 
@@ -0,0 +1,350 @@
+/*********************************************************************************
+* Copyright (C) 2018-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file nm_sampler.cpp
+  \brief The file implements the direct sampling of the nuclear initial conditions from the
+  Wigner or Boltzmann distributions of the harmonic normal modes
+    
+*/
+
+#if defined(USING_PCH)
+#include "../pch.h"
+#else
+#include <cmath>
+#include <random>
+#endif
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "montecarlo.h"
+#include "../math_meigen/libmeigen.h"
+
+
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace liblinalg;
+using namespace librandom;
+using namespace libmeigen;
+
+/// libmontecarlo namespace 
+namespace libmontecarlo{
+
+namespace bp = boost::python;
+
+
+/// Counts the samplers runs so far, so the unseeded ones get different random streams
+static unsigned int nm_sampler_stream_counter = 0;
+
+
+
+void normal_modes(MATRIX& hessian, vector<double>& mass, vector<double>& omega, MATRIX& modes){
+/**
+  \brief Computes the normal modes from the Cartesian Hessian
+
+  \param[in] hessian - ndof x ndof matrix of the second derivatives of the energy [a.u.]
+  \param[in] mass - ndof masses of all the DOFs [a.u.]
+  \param[out] omega - ndof frequencies [a.u.], in the ascending order; negative values mean
+  the imaginary frequencies, omega = -sqrt(|lambda|)
+  \param[out] modes - ndof x ndof matrix, whose columns are the orthonormal eigenvectors
+  of the mass-weighted Hessian  H_ij / sqrt(m_i * m_j)
+*/
+
+  int i, j;
+  int ndof = hessian.n_rows;
+
+  if(hessian.n_cols!=ndof || (int)mass.size()!=ndof){
+    cout<<"Error in normal_modes: the Hessian must be a "<<mass.size()<<" x "<<mass.size()<<" matrix, but it is "
+        <<hessian.n_rows<<" x "<<hessian.n_cols<<"\nExiting...\n"; exit(0);
+  }
+  if(modes.n_rows!=ndof || modes.n_cols!=ndof){
+    cout<<"Error in normal_modes: the modes matrix must be "<<ndof<<" x "<<ndof<<"\nExiting...\n"; exit(0);
+  }
+
+  MATRIX Hmw(ndof, ndof);
+  MATRIX E(ndof, ndof);
+
+  for(i=0;i<ndof;i++){
+    for(j=0;j<ndof;j++){  Hmw.M[i*ndof+j] = hessian.M[i*ndof+j] / sqrt(mass[i] * mass[j]);  }
+  }
+
+  solve_eigen(Hmw, E, modes, 0);
+
+  omega = vector<double>(ndof, 0.0);
+  for(i=0;i<ndof;i++){
+    double lambda = E.M[i*ndof+i];
+    omega[i] = (lambda >= 0.0) ? sqrt(lambda) : -sqrt(-lambda);
+  }
+
+}
+
+
+
+static void gaussian_fill(std::mt19937_64& gen, double* z, int n){
+/**
+  Fills the array z with n independent N(0,1) numbers - the Box-Muller transform of a batch of
+  the uniform numbers drawn from the stream gen. Both uniform numbers of a pair are taken from
+  one 64-bit draw, 32 bits each
+*/
+
+  const double two_pi = 6.283185307179586;
+  const double scl = 1.0 / 4294967296.0;  // 2^-32
+  int i;
+  int npairs = (n + 1) / 2;
+
+  vector<double> u1(npairs), u2(npairs);
+  for(i=0;i<npairs;i++){
+    unsigned long long x = gen();
+    u1[i] = ((x >> 32) + 1.0) * scl;          // (0, 1]
+    u2[i] = (x & 0xffffffffULL) * scl;        // [0, 1)
+  }
+
+  for(i=0;i<npairs;i++){
+    double r = sqrt(-2.0 * log(u1[i]));
+    double phi = two_pi * u2[i];
+    z[2*i] = r * cos(phi);
+    if(2*i+1 < n){  z[2*i+1] = r * sin(phi);  }
+  }
+
+}
+
+
+
+nm_sampler::nm_sampler(){
+
+  Temperature = 300.0;
+  is_quantum = 1;
+  freq_threshold = 1e-6;
+  block_size = 256;
+
+  num_threads = 0;
+  rng_seed = 0;  is_rng_seed = 0;
+
+}
+
+
+nm_sampler::nm_sampler(bp::dict params) : nm_sampler(){
+
+  set_parameters(params);
+
+}
+
+
+void nm_sampler::set_parameters(bp::dict params){
+
+  std::string key;
+  for(int i=0;i<len(params.values());i++){
+    key = bp::extract<std::string>(params.keys()[i]);
+
+    if(key=="Temperature") { Temperature = bp::extract<double>(params.values()[i]);   }
+    else if(key=="is_quantum") { is_quantum = bp::extract<int>(params.values()[i]);   }
+    else if(key=="frozen_modes") {
+      frozen_modes.clear();
+      bp::list tmp = bp::extract<bp::list>(params.values()[i]);
+      for(int j=0; j<len(tmp); j++){  frozen_modes.push_back( bp::extract<int>(tmp[j]) );  }
+    }
+    else if(key=="freq_threshold") { freq_threshold = bp::extract<double>(params.values()[i]);   }
+    else if(key=="block_size") { block_size = bp::extract<int>(params.values()[i]);   }
+    else if(key=="num_threads") { num_threads = bp::extract<int>(params.values()[i]);   }
+    else if(key=="rng_seed") { rng_seed = bp::extract<int>(params.values()[i]);  is_rng_seed = 1; }
+
+  } // for i
+
+
+  // Sanity check
+  if(block_size < 1){ block_size = 1; }
+  if(Temperature < 0.0){
+    cout<<"Error in nm_sampler::set_parameters: the temperature must not be negative\nExiting...\n"; exit(0);
+  }
+
+}
+
+
+void nm_sampler::widths(vector<double>& omega, vector<double>& sigma_q, vector<double>& sigma_p){
+/**
+  \brief The widths of the Gaussian distributions of the mass-weighted normal coordinates Q_k and momenta P_k
+
+  \param[in] omega - the frequencies of the modes [a.u.]
+  \param[out] sigma_q - the standard deviations of Q_k
+  \param[out] sigma_p - the standard deviations of P_k
+
+  Wigner (is_quantum = 1):  sigma_q^2 = coth(w/2kT) / (2w),  sigma_p^2 = w * coth(w/2kT) / 2
+  Boltzmann (is_quantum = 0):  sigma_q^2 = kT / w^2,  sigma_p^2 = kT
+
+  The frozen modes and the modes with the frequencies below freq_threshold (the translations, rotations 
+  and the imaginary frequencies) get zero widths
+*/
+
+  const double kb = 3.166811429e-6; // Hartree/K
+  double kT = kb * Temperature;
+  int nmodes = omega.size();
+
+  sigma_q = vector<double>(nmodes, 0.0);
+  sigma_p = vector<double>(nmodes, 0.0);
+
+  for(int k=0; k<nmodes; k++){
+
+    int is_frozen = (omega[k] < freq_threshold);
+    for(int j=0; j<(int)frozen_modes.size(); j++){ if(frozen_modes[j]==k){ is_frozen = 1; } }
+    if(is_frozen){ continue; }
+
+    double w = omega[k];
+
+    if(is_quantum){
+      double cth = 1.0;
+      if(kT > 0.0){ cth = 1.0 / tanh(0.5 * w / kT); }
+      sigma_q[k] = sqrt(0.5 * cth / w);
+      sigma_p[k] = sqrt(0.5 * cth * w);
+    }
+    else{
+      sigma_q[k] = sqrt(kT) / w;
+      sigma_p[k] = sqrt(kT);
+    }
+
+  }// for k
+
+}
+
+
+void nm_sampler::sample(MATRIX& modes, vector<double>& omega, vector<double>& mass, MATRIX& q0, MATRIX& p0,
+                        MATRIX& q, MATRIX& p){
+/**
+  \brief Samples the ensemble of the nuclear coordinates and momenta from the normal modes distribution
+
+  \param[in] modes - ndof x nmodes matrix, whose columns are the orthonormal mass-weighted normal modes L_k
+  \param[in] omega - nmodes frequencies of the modes [a.u.]
+  \param[in] mass - ndof masses of all the DOFs [a.u.]
+  \param[in] q0 - ndof x 1 matrix of the reference (equilibrium) coordinates
+  \param[in] p0 - ndof x 1 matrix of the reference momenta
+  \param[out] q - ndof x ntraj matrix of the sampled coordinates, must be allocated by the caller
+  \param[out] p - ndof x ntraj matrix of the sampled momenta, must be allocated by the caller
+
+  The mass-weighted normal coordinates and momenta are drawn independently, Q_k ~ N(0, sigma_q_k^2) and
+  P_k ~ N(0, sigma_p_k^2) (see widths), and transformed back to the Cartesian ones:
+
+    q_i = q0_i + sum_k L_ik * Q_k / sqrt(m_i),     p_i = p0_i + sum_k L_ik * P_k * sqrt(m_i)
+
+  The trajectories are processed in blocks of block_size columns, in parallel. Every block has its own
+  random stream seeded by the block index, so with the given rng_seed the result does not depend on
+  the number of threads
+*/
+
+  int ndof = mass.size();
+  int nmodes = omega.size();
+  int ntraj = q.n_cols;
+  int i, k;
+
+  if(modes.n_rows!=ndof || modes.n_cols!=nmodes){
+    cout<<"Error in nm_sampler::sample: the modes matrix must be "<<ndof<<" x "<<nmodes<<", but it is "
+        <<modes.n_rows<<" x "<<modes.n_cols<<"\nExiting...\n"; exit(0);
+  }
+  if(q0.n_rows!=ndof || p0.n_rows!=ndof){
+    cout<<"Error in nm_sampler::sample: the reference coordinates and momenta must have "<<ndof<<" rows\nExiting...\n"; exit(0);
+  }
+  if(q.n_rows!=ndof || p.n_rows!=ndof || p.n_cols!=ntraj){
+    cout<<"Error in nm_sampler::sample: the q and p matrices must be "<<ndof<<" x ntraj\nExiting...\n"; exit(0);
+  }
+
+
+  //============ The Cartesian displacement per unit normal deviate, only for the sampled modes ==============
+  vector<double> sigma_q, sigma_p;
+  widths(omega, sigma_q, sigma_p);
+
+  vector<int> act;
+  for(k=0; k<nmodes; k++){  if(sigma_q[k] > 0.0 || sigma_p[k] > 0.0){ act.push_back(k); }  }
+  int nact = act.size();
+
+  vector<double> Aq(ndof*nact), Ap(ndof*nact);
+  for(i=0; i<ndof; i++){
+    double sm = sqrt(mass[i]);
+    for(k=0; k<nact; k++){
+      double L = modes.M[i*nmodes + act[k]];
+      Aq[i*nact+k] = L * sigma_q[act[k]] / sm;
+      Ap[i*nact+k] = L * sigma_p[act[k]] * sm;
+    }
+  }
+
+
+  //============ Parallel setup ==============
+  int nblocks = (ntraj + block_size - 1) / block_size;
+  int nth = 1;
+#if defined(_OPENMP)
+  nth = omp_get_max_threads();
+#endif
+  if(num_threads > 0 && num_threads < nth){ nth = num_threads; }
+  if(nth > nblocks){ nth = nblocks; }
+  if(nth < 1){ nth = 1; }
+
+  unsigned int seed;
+  if(is_rng_seed){  seed = rng_seed;  }
+  else{  std::random_device rd;  seed = rd() + 7919u * (nm_sampler_stream_counter++);  }
+
+
+  #pragma omp parallel for num_threads(nth) schedule(dynamic)
+  for(int b=0; b<nblocks; b++){
+
+    int t0 = b * block_size;
+    int nt = std::min(block_size, ntraj - t0);
+    int i, k, t;
+
+    std::seed_seq seq{ seed, (unsigned int)b };
+    std::mt19937_64 gen(seq);
+
+    // The normal deviates of this block: Z[k*nt + t], the Q ones, then the P ones
+    vector<double> Zq(nact*nt), Zp(nact*nt);
+    if(nact > 0){
+      gaussian_fill(gen, &Zq[0], nact*nt);
+      gaussian_fill(gen, &Zp[0], nact*nt);
+    }
+
+    for(i=0; i<ndof; i++){
+      double* q_row = q.M + i*ntraj + t0;
+      double* p_row = p.M + i*ntraj + t0;
+
+      for(t=0; t<nt; t++){  q_row[t] = q0.M[i];  p_row[t] = p0.M[i];  }
+
+      for(k=0; k<nact; k++){
+        double aq = Aq[i*nact+k];
+        double ap = Ap[i*nact+k];
+        const double* zq = &Zq[k*nt];
+        const double* zp = &Zp[k*nt];
+        for(t=0; t<nt; t++){  q_row[t] += aq * zq[t];  p_row[t] += ap * zp[t];  }
+      }
+    }// for i
+
+  }// for b
+
+}
+
+
+void nm_sampler::sample(MATRIX& hessian, vector<double>& mass, MATRIX& q0, MATRIX& p0, MATRIX& q, MATRIX& p){
+/**
+  \brief Same as above, but the normal modes are computed from the Cartesian Hessian
+
+  \param[in] hessian - ndof x ndof matrix of the second derivatives of the energy at q0 [a.u.]
+*/
+
+  int ndof = mass.size();
+  vector<double> omega;
+  MATRIX modes(ndof, ndof);
+
+  normal_modes(hessian, mass, omega, modes);
+  sample(modes, omega, mass, q0, p0, q, p);
+
+}
+
+
+
+}// namespace libmontecarlo
+}// liblibra
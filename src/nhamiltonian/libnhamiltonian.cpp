@@ -118,6 +118,9 @@ void export_nhamiltonian_objects(){
   void (nHamiltonian::*expt_compute_diabatic_v2)(int model, vector<double>& q, vector<double>& params)
   = &nHamiltonian::compute_diabatic; 
 
+  void (nHamiltonian::*expt_compute_diabatic_v5)(int model, MATRIX& q, vector<double>& params, int lvl)
+  = &nHamiltonian::compute_diabatic; 
+
 
   // for models defined in Python
 /*
@@ -193,6 +196,12 @@ void export_nhamiltonian_objects(){
   = &nHamiltonian::compute_nac_adi;
   void (nHamiltonian::*expt_compute_nac_adi_v3)(MATRIX& p, const MATRIX& invM, int lvl, int split)
   = &nHamiltonian::compute_nac_adi;
+  void (nHamiltonian::*expt_compute_nac_adi_v4)(double dt, int method)
+  = &nHamiltonian::compute_nac_adi;
+  void (nHamiltonian::*expt_compute_nac_adi_v5)(double dt, int method, vector<int>& perm)
+  = &nHamiltonian::compute_nac_adi;
+  void (nHamiltonian::*expt_compute_nac_adi_v6)(double dt, int method, int lvl)
+  = &nHamiltonian::compute_nac_adi;
 
 
   void (nHamiltonian::*expt_compute_hvib_dia_v1)()
@@ -269,6 +278,8 @@ void export_nhamiltonian_objects(){
   = &nHamiltonian::Ehrenfest_forces_adi;
   CMATRIX (nHamiltonian::*expt_Ehrenfest_forces_adi_v2)(CMATRIX& ampl_adi, int lvl)
   = &nHamiltonian::Ehrenfest_forces_adi;
+  void (nHamiltonian::*expt_Ehrenfest_forces_adi_v4)(CMATRIX& ampl_adi, MATRIX& F, int lvl, int option)
+  = &nHamiltonian::Ehrenfest_forces_adi;
 
 //  CMATRIX (nHamiltonian::*expt_Ehrenfest_forces_adi_v2)(CMATRIX& ampl_adi, vector<int>& id_)
 //  = &nHamiltonian::Ehrenfest_forces_adi;
@@ -276,6 +287,14 @@ void export_nhamiltonian_objects(){
   = &nHamiltonian::Ehrenfest_forces_dia;
   CMATRIX (nHamiltonian::*expt_Ehrenfest_forces_dia_v2)(CMATRIX& ampl_dia, int lvl)
   = &nHamiltonian::Ehrenfest_forces_dia;
+  void (nHamiltonian::*expt_Ehrenfest_forces_dia_v3)(CMATRIX& ampl_dia, MATRIX& F, int lvl, int option)
+  = &nHamiltonian::Ehrenfest_forces_dia;
+  void (nHamiltonian::*expt_Ehrenfest_forces_dia_contract_v1)(CMATRIX& ampl_dia, int itraj, int option, MATRIX& F)
+  = &nHamiltonian::Ehrenfest_forces_dia_contract;
+  CMATRIX (nHamiltonian::*expt_Ehrenfest_forces_dia_unit_v1)(CMATRIX& ampl_dia, int option)
+  = &nHamiltonian::Ehrenfest_forces_dia_unit;
+  CMATRIX (nHamiltonian::*expt_Ehrenfest_forces_adi_unit_v1)(CMATRIX& ampl_adi, int option)
+  = &nHamiltonian::Ehrenfest_forces_adi_unit;
 //  CMATRIX (nHamiltonian::*expt_Ehrenfest_forces_dia_v2)(CMATRIX& ampl_dia, vector<int>& id_)
 //  = &nHamiltonian::Ehrenfest_forces_dia;
 
@@ -482,6 +501,7 @@ void export_nhamiltonian_objects(){
       .def("compute_diabatic", expt_compute_diabatic_v2)
       .def("compute_diabatic", expt_compute_diabatic_v3)
       .def("compute_diabatic", expt_compute_diabatic_v4)
+      .def("compute_diabatic", expt_compute_diabatic_v5)
 
 
       .def("update_ordering", expt_update_ordering_v1)
@@ -530,6 +550,9 @@ void export_nhamiltonian_objects(){
       .def("compute_nac_adi", expt_compute_nac_adi_v1)
       .def("compute_nac_adi", expt_compute_nac_adi_v2)
       .def("compute_nac_adi", expt_compute_nac_adi_v3)
+      .def("compute_nac_adi", expt_compute_nac_adi_v4)
+      .def("compute_nac_adi", expt_compute_nac_adi_v5)
+      .def("compute_nac_adi", expt_compute_nac_adi_v6)
 
       .def("compute_hvib_dia", expt_compute_hvib_dia_v1)
       .def("compute_hvib_dia", expt_compute_hvib_dia_v2)
@@ -560,10 +583,16 @@ void export_nhamiltonian_objects(){
 
       .def("Ehrenfest_forces_adi", expt_Ehrenfest_forces_adi_v1)
       .def("Ehrenfest_forces_adi", expt_Ehrenfest_forces_adi_v2)
+      .def("Ehrenfest_forces_adi", expt_Ehrenfest_forces_adi_v4)
+      .def("Ehrenfest_forces_adi_contract", &nHamiltonian::Ehrenfest_forces_adi_contract)
 //      .def("Ehrenfest_forces_adi", expt_Ehrenfest_forces_adi_v3)
 //      .def("Ehrenfest_forces_adi", expt_Ehrenfest_forces_adi_v2)
       .def("Ehrenfest_forces_dia", expt_Ehrenfest_forces_dia_v1)
       .def("Ehrenfest_forces_dia", expt_Ehrenfest_forces_dia_v2)
+      .def("Ehrenfest_forces_dia", expt_Ehrenfest_forces_dia_v3)
+      .def("Ehrenfest_forces_dia_contract", expt_Ehrenfest_forces_dia_contract_v1)
+      .def("Ehrenfest_forces_dia_unit", expt_Ehrenfest_forces_dia_unit_v1)
+      .def("Ehrenfest_forces_adi_unit", expt_Ehrenfest_forces_adi_unit_v1)
 //      .def("Ehrenfest_forces_dia", expt_Ehrenfest_forces_dia_v2)
       
       .def("QTSH_energy_adi", expt_QTSH_energy_adi_v1)
@@ -602,6 +631,10 @@ void export_nhamiltonian_objects(){
 */
 
 
+  def("max_overlap_reordering", &max_overlap_reordering);
+  def("nac_from_time_overlap", &nac_from_time_overlap);
+
+
   double (*expt_ETHD_energy_v1)(const MATRIX& q, const MATRIX& invM) = &ETHD_energy;
   MATRIX (*expt_ETHD_forces_v1)(const MATRIX& q, const MATRIX& invM) = &ETHD_forces;
 
@@ -429,6 +429,8 @@ public:
 
   void compute_diabatic(int model, vector<double>& q, vector<double>& params, int lvl); // for internal model types
   void compute_diabatic(int model, vector<double>& q, vector<double>& params); // for internal model types
+  void compute_diabatic(int model, MATRIX& q, vector<double>& params, int lvl); // for internal model types, one column of q per child
+  void compute_model(int model, const vector<double>& q, vector<double>& params);
 
 //  void compute_diabatic(bp::object py_funct, bp::object q, bp::object params, int lvl); // for models defined in Python
 //  void compute_diabatic(bp::object py_funct, bp::object q, bp::object params); // for models defined in Python
@@ -526,6 +528,8 @@ public:
   void compute_nac_dia(MATRIX& p, const MATRIX& invM, vector<int>& id_);
   void compute_nac_dia(MATRIX& p, const MATRIX& invM, int lvl, int split);
   void compute_nac_adi(double dt, int method);
+  void compute_nac_adi(double dt, int method, vector<int>& perm);
+  void compute_nac_adi(double dt, int method, int lvl);
   void compute_nac_adi(MATRIX& p, const MATRIX& invM);
   void compute_nac_adi(MATRIX& p, const MATRIX& invM, vector<int>& id_);
   void compute_nac_adi(MATRIX& p, const MATRIX& invM, int lvl, int split);
@@ -547,6 +551,9 @@ public:
   CMATRIX Ehrenfest_forces_dia_unit(CMATRIX& ampl_dia);                  ///< Ehrenfest forces in diabatic basis
   CMATRIX Ehrenfest_forces_dia(CMATRIX& ampl_dia, int lvl, int option);  ///< Ehrenfest forces in diabatic basis
   CMATRIX Ehrenfest_forces_dia(CMATRIX& ampl_dia, int lvl);              ///< Ehrenfest forces in diabatic basis
+  void Ehrenfest_forces_dia_contract(CMATRIX& ampl_dia, int itraj, int option, MATRIX& F, const CMATRIX* invS);  ///< Same, with the precomputed S^-1
+  void Ehrenfest_forces_dia_contract(CMATRIX& ampl_dia, int itraj, int option, MATRIX& F);  ///< Force-contraction kernel, one trajectory
+  void Ehrenfest_forces_dia(CMATRIX& ampl_dia, MATRIX& F, int lvl, int option);  ///< Ehrenfest forces in diabatic basis, into preallocated F
 
 
   ///< In nHamiltonian_compute_Ehrenfest.cpp and nHamiltonian_compute_Ehrenfest_forces.cpp
@@ -560,6 +567,8 @@ public:
   CMATRIX Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl, int option, vector<CMATRIX*>& transforms);  ///< Ehrenfest forces in adiabatic basis
   CMATRIX Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl, int option);  ///< Ehrenfest forces in adiabatic basis
   CMATRIX Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl);              ///< Ehrenfest forces in adiabatic basis
+  void Ehrenfest_forces_adi_contract(CMATRIX& ampl_adi, int itraj, int option, MATRIX& F);  ///< Force-contraction kernel, one trajectory
+  void Ehrenfest_forces_adi(CMATRIX& ampl_adi, MATRIX& F, int lvl, int option);  ///< Ehrenfest forces in adiabatic basis, into preallocated F
 
 
 
@@ -616,6 +625,11 @@ typedef std::vector<nHamiltonian> nHamiltonianList;  ///< data type for keeping
 */
 
 
+///< In nHamiltonian_compute_nac.cpp
+vector<int> max_overlap_reordering(CMATRIX& St);
+void nac_from_time_overlap(CMATRIX& St, CMATRIX& nac, double dt, int method, vector<int>& perm);
+
+
 ///< In nHamiltonian_compute_ETHD.cpp
 double ETHD_energy(const MATRIX& q, const MATRIX& invM);
 MATRIX ETHD_forces(const MATRIX& q, const MATRIX& invM);
@@ -167,7 +167,7 @@ vector<CMATRIX> nHamiltonian::Ehrenfest_forces_tens_adi(CMATRIX& ampl_adi){
 
   complex<double> norm = (ampl_adi.H() * ampl_adi).M[0]; 
 
-  CMATRIX* tmp; tmp = new CMATRIX(nadi, nadi);
+  CMATRIX tmp(nadi, nadi);
 
 
   for(int n=0;n<nnucl;n++){
@@ -178,15 +178,15 @@ vector<CMATRIX> nHamiltonian::Ehrenfest_forces_tens_adi(CMATRIX& ampl_adi){
     if(dc1_adi_mem_status[n]==0){ cout<<"Error in Ehrenfest_forces_tens_adi(): the derivatives couplings matrix in the adiabatic \
     basis w.r.t. the nuclear DOF "<<n<<" is not allocated but is needed for the calculations \n"; exit(0); }
 
-    *tmp = (*dc1_adi[n]).H() * (*ham_adi);
-    *tmp = (*tmp + (*tmp).H() );
+    // tmp = D^+ * H + H * D
+    tmp = dc1_adi[n]->H() * (*ham_adi);
+    tmp += tmp.H();
 
-    res[n] = (-1.0/norm) * (*d1ham_adi[n] - *tmp );
+    res[n] = *d1ham_adi[n] - tmp;
+    res[n] *= (-1.0/norm);
 
   }// for n
 
-  delete tmp;
-
   return res;
 
 }
@@ -231,10 +231,15 @@ vector<CMATRIX> nHamiltonian::Ehrenfest_forces_tens_dia(CMATRIX& ampl_dia){
 //  not allocated, but they are needed for the calculations\n"; exit(0); }
 
 
-  CMATRIX* dtilda; dtilda = new CMATRIX(nadi,nadi);
-  CMATRIX* invS; invS = new CMATRIX(nadi, nadi); 
+  CMATRIX dtilda(ndia, ndia);
+  CMATRIX invS(ndia, ndia); 
+
+  FullPivLU_inverse(*ovlp_dia, invS);
+
+  // S^-1 * H is the same for all DOFs
+  CMATRIX invS_H(ndia, ndia);
+  invS_H.product(invS, *ham_dia);
 
-  FullPivLU_inverse(*ovlp_dia, *invS);
   complex<double> norm = (ampl_dia.H() * (*ovlp_dia) * ampl_dia).M[0]; 
 
   
@@ -247,17 +252,16 @@ vector<CMATRIX> nHamiltonian::Ehrenfest_forces_tens_dia(CMATRIX& ampl_dia){
       basis w.r.t. the nuclear DOF "<<n<<" is not allocated but is needed for the calculations \n"; exit(0); }
 
 
-      *dtilda = (*dc1_dia[n]).H() * (*invS) * (*ham_dia);
-      *dtilda = (*dtilda + (*dtilda).H() ) ;
+      // dtilda = D^+ * S^-1 * H + H * S^-1 * D
+      dtilda = dc1_dia[n]->H() * invS_H;
+      dtilda += dtilda.H();
 
-      res[n] = (-1.0/norm) * (*d1ham_dia[n] - *dtilda );
+      res[n] = *d1ham_dia[n] - dtilda;
+      res[n] *= (-1.0/norm);
 
   }// for n
 
 
-  delete dtilda;
-  delete invS;
-
   return res;
  
 }
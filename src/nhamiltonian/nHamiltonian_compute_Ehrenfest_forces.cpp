@@ -18,6 +18,7 @@
 #include "../pch.h"
 #else
 #include <stdlib.h>
+#include <omp.h>
 #endif 
 
 #include "nHamiltonian.h"
@@ -117,6 +118,165 @@ CMATRIX nHamiltonian::Ehrenfest_forces_dia_unit(CMATRIX& ampl_dia){
 
 
 
+void nHamiltonian::Ehrenfest_forces_dia_contract(CMATRIX& ampl_dia, int itraj, int option, MATRIX& F, const CMATRIX* invS){
+/**
+  \brief The force-contraction kernel: Ehrenfest forces in the diabatic basis for one trajectory
+
+  \param[in] ampl_dia [ndia x ntraj] matrix of diabatic amplitudes, only the column itraj is used
+  \param[in] itraj - the index of the trajectory (column) to process
+  \param[in] option [0 or 1] - same as in Ehrenfest_forces_dia_unit
+  \param[out] F [ndof x ntraj] matrix, the forces are written into its column itraj
+  \param[in] invS - the inverse of ovlp_dia, if it is already known (e.g. shared by all the trajectories
+  of one Hamiltonian); if NULL, it is computed here. Only used with option = 0
+
+  This is the same quantity as computed by Ehrenfest_forces_dia_unit:
+
+  F_n = -Re[ c^+ (dH_n - (D_n^+ S^-1 H + H S^-1 D_n)) c ] / (c^+ S c)
+
+  but without the matrix-matrix products: the dH_n term is contracted over the upper triangle
+  (dH_n is Hermitian) and the NAC term reduces to  2 Re[ (S^-1 H c)^+ (D_n c) ], where S^-1 H c
+  is computed once for all DOFs. So the cost is O(ndia^2) per DOF instead of O(ndia^3).
+  The matrices H, S and dH_n are assumed to be Hermitian.
+*/
+
+  if(ovlp_dia_mem_status==0){ cout<<"Error in Ehrenfest_forces_dia_contract(): the overlap matrix in the diabatic basis is not allocated \
+  but it is needed for the calculations\n"; exit(0); }
+
+  if(ham_dia_mem_status==0){ cout<<"Error in Ehrenfest_forces_dia_contract(): the diabatic Hamiltonian matrix is not allocated \
+  but it is needed for the calculations\n"; exit(0); }
+
+  int i, j, n;
+  int nst = ndia;
+  int ntraj = ampl_dia.n_cols;
+
+  vector< complex<double> > c(nst), w(nst), u(nst);
+  for(i=0;i<nst;i++){ c[i] = ampl_dia.M[i*ntraj+itraj]; }
+
+  // norm = c^+ S c
+  const complex<double>* s = ovlp_dia->M;
+  double norm = 0.0;
+  for(i=0;i<nst;i++){
+    complex<double> sc(0.0, 0.0);
+    for(j=0;j<nst;j++){ sc += s[i*nst+j] * c[j]; }
+    norm += (std::conj(c[i]) * sc).real();
+  }
+
+  // w = S^-1 * H * c
+  if(option==0){
+    CMATRIX* _invS = NULL;
+    if(invS==NULL){
+      _invS = new CMATRIX(nst, nst);
+      FullPivLU_inverse(*ovlp_dia, *_invS);
+      invS = _invS;
+    }
+
+    const complex<double>* h = ham_dia->M;
+    for(i=0;i<nst;i++){
+      u[i] = complex<double>(0.0, 0.0);
+      for(j=0;j<nst;j++){ u[i] += h[i*nst+j] * c[j]; }
+    }
+    for(i=0;i<nst;i++){
+      w[i] = complex<double>(0.0, 0.0);
+      for(j=0;j<nst;j++){ w[i] += invS->M[i*nst+j] * u[j]; }
+    }
+
+    if(_invS!=NULL){ delete _invS; }
+  }
+
+
+  for(n=0;n<nnucl;n++){
+
+    if(d1ham_dia_mem_status[n]==0){ cout<<"Error in Ehrenfest_forces_dia_contract(): the derivatives of the Hamiltonian matrix in the \
+    diabatic basis w.r.t. the nuclear DOF "<<n<<" is not allocated but is needed for the calculations \n"; exit(0); }
+
+    // Re[ c^+ dH_n c ]
+    const complex<double>* dh = d1ham_dia[n]->M;
+    double e = 0.0;
+    for(i=0;i<nst;i++){
+      complex<double> tmp(0.0, 0.0);
+      for(j=i+1;j<nst;j++){ tmp += dh[i*nst+j] * c[j]; }
+      e += dh[i*nst+i].real() * std::norm(c[i]) + 2.0 * (std::conj(c[i]) * tmp).real();
+    }
+
+    // - 2 Re[ (S^-1 H c)^+ (D_n c) ]
+    if(option==0){
+
+      if(dc1_dia_mem_status[n]==0){ cout<<"Error in Ehrenfest_forces_dia_contract(): the derivatives couplings matrix in the diabatic \
+      basis w.r.t. the nuclear DOF "<<n<<" is not allocated but is needed for the calculations \n"; exit(0); }
+
+      const complex<double>* d = dc1_dia[n]->M;
+      complex<double> tmp(0.0, 0.0);
+      for(i=0;i<nst;i++){
+        complex<double> dc(0.0, 0.0);
+        for(j=0;j<nst;j++){ dc += d[i*nst+j] * c[j]; }
+        tmp += std::conj(w[i]) * dc;
+      }
+      e -= 2.0 * tmp.real();
+    }
+
+    F.M[n*ntraj+itraj] = -e / norm;
+
+  }// for n
+
+}
+
+void nHamiltonian::Ehrenfest_forces_dia_contract(CMATRIX& ampl_dia, int itraj, int option, MATRIX& F){
+/**
+  Same as above, S^-1 is computed here
+*/
+  Ehrenfest_forces_dia_contract(ampl_dia, itraj, option, F, NULL);
+}
+
+
+void nHamiltonian::Ehrenfest_forces_dia(CMATRIX& ampl_dia, MATRIX& F, int lvl, int option){
+/**
+  \brief Computes the Ehrenfest forces in the diabatic basis for all trajectories, into the preallocated matrix
+
+  \param[in] ampl_dia [ndia x ntraj] matrix of diabatic amplitudes
+  \param[out] F [ndof x ntraj] matrix of the (real) forces, must be allocated by the caller
+  \param[in] lvl [0 or 1] - same as in Ehrenfest_forces_dia(ampl_dia, lvl, option)
+  \param[in] option [0 or 1] - same as in Ehrenfest_forces_dia_unit
+
+  The trajectories are processed in parallel, each by the Ehrenfest_forces_dia_contract kernel
+*/
+
+  int ntraj = ampl_dia.n_cols;
+
+  if(lvl==1 && (int)children.size()!=ntraj){
+    cout<<"ERROR in nHamiltonian::Ehrenfest_forces_dia(CMATRIX& ampl_dia, MATRIX& F, int lvl, int option):\n";
+    cout<<"The number of columns of the ampl_dia ("<<ntraj<<")";
+    cout<<" should be equal to the number of children Hamiltonians ("<<children.size()<<")\n";
+    cout<<"Exiting...\n";
+    exit(0);
+  }
+
+  if(F.n_rows!=nnucl || F.n_cols!=ntraj){
+    cout<<"ERROR in nHamiltonian::Ehrenfest_forces_dia(CMATRIX& ampl_dia, MATRIX& F, int lvl, int option):\n";
+    cout<<"The forces matrix should be of the size "<<nnucl<<" x "<<ntraj<<", but it is "<<F.n_rows<<" x "<<F.n_cols<<"\n";
+    cout<<"Exiting...\n";
+    exit(0);
+  }
+
+  // All the trajectories of this Hamiltonian share the overlap matrix, so it is inverted only once;
+  // the children have their own overlaps, each one is inverted by the kernel
+  CMATRIX* p_invS = NULL;
+  if(lvl==0 && option==0){
+    if(ovlp_dia_mem_status==0){ cout<<"Error in Ehrenfest_forces_dia(): the overlap matrix in the diabatic basis is not allocated \
+    but it is needed for the calculations\n"; exit(0); }
+    p_invS = new CMATRIX(ndia, ndia);
+    FullPivLU_inverse(*ovlp_dia, *p_invS);
+  }
+
+  #pragma omp parallel for
+  for(int itraj=0; itraj<ntraj; itraj++){
+    if(lvl==0){  Ehrenfest_forces_dia_contract(ampl_dia, itraj, option, F, p_invS);  }
+    else{  children[itraj]->Ehrenfest_forces_dia_contract(ampl_dia, itraj, option, F, NULL);  }
+  }
+
+  if(p_invS!=NULL){ delete p_invS; }
+}
+
+
 CMATRIX nHamiltonian::Ehrenfest_forces_dia(CMATRIX& ampl_dia, int lvl, int option){
 /**
   \brief Computes the Ehrenfest forces in the diabatic basis
@@ -136,51 +296,15 @@ CMATRIX nHamiltonian::Ehrenfest_forces_dia(CMATRIX& ampl_dia, int lvl, int optio
   Returns:
   MATRIX(ndof, ntraj) - Ehrenfest forces in diabatic representation, for multiple trajectories
 
+  The forces are computed by the Ehrenfest_forces_dia_contract kernel, see the
+  Ehrenfest_forces_dia(ampl_dia, F, lvl, option) for the version that avoids the allocations
 
 */
-  int i;
-
-  if(lvl==1){
-    // Check whether we have enough sub-Hamiltonians
-    if(children.size()!=ampl_dia.n_cols){
-      cout<<"ERROR in CMATRIX nHamiltonian::Ehrenfest_forces_dia(CMATRIX& ampl_dia):\n";
-      cout<<"The number of columns of the ampl_dia ("<<ampl_dia.n_cols<<")";
-      cout<<" should be equal to the number of children Hamiltonians ("<<children.size()<<")\n";
-      cout<<"Exiting...\n";
-      exit(0);
-    }
-  }
-
-  CMATRIX ampl_tmp(ampl_dia.n_rows, 1);
-  CMATRIX frc_tmp(nnucl, 1);
-  CMATRIX F(nnucl, ampl_dia.n_cols);
 
-  vector<int> stenc_ampl(ampl_dia.n_rows, 0);
-  vector<int> stenc_frc(nnucl, 0);
-  vector<int> stenc_col(1, 0);
-
-  // The indicies in stenc_frc reflects which indicies are to be updated in the final F matrix
-  for(i=0;i<nnucl;i++) { stenc_frc[i] = i;}    
-
-  for(i=0;i<ampl_dia.n_rows;i++){ stenc_ampl[i] = i;}
-
-  for(i=0;i<ampl_dia.n_cols;i++){
-    stenc_col[0] = i;
-
-    pop_submatrix(ampl_dia, ampl_tmp, stenc_ampl, stenc_col);
-
-    if(lvl==0){
-        frc_tmp = Ehrenfest_forces_dia_unit(ampl_tmp, option);
-    }
-    if(lvl==1){
-        frc_tmp = children[i]->Ehrenfest_forces_dia_unit(ampl_tmp, option);
-    }
-
-    push_submatrix(F, frc_tmp, stenc_frc, stenc_col);
- 
-  }// for all children
+  MATRIX f(nnucl, ampl_dia.n_cols);
+  Ehrenfest_forces_dia(ampl_dia, f, lvl, option);
 
-  return F;
+  return CMATRIX(f);
   
 }
 
@@ -302,110 +426,163 @@ CMATRIX nHamiltonian::Ehrenfest_forces_adi_unit(CMATRIX& ampl_adi){
 }
 
 
-CMATRIX nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl, int option, vector<CMATRIX*>& transforms){
+void nHamiltonian::Ehrenfest_forces_adi_contract(CMATRIX& ampl_adi, int itraj, int option, MATRIX& F){
 /**
-  \brief Computes the Ehrenfest forces in the adiabatic basis
+  \brief The force-contraction kernel: Ehrenfest forces in the adiabatic basis for one trajectory
 
-  \param[in] ampl_adi [nadi x ntraj] matrix of adiabatic amplitudes for
-  one of many (ntraj) trajectories
-  \param[in] lvl [0 or 1] - 0 - use the present level for all trajectories, 1 - use the next 
-  level for the trajectories (one sub-Hamiltonian per each trajectory) 
+  \param[in] ampl_adi [nadi x ntraj] matrix of adiabatic amplitudes, only the column itraj is used
+  \param[in] itraj - the index of the trajectory (column) to process
+  \param[in] option [0 or 1] - same as in Ehrenfest_forces_adi_unit
+  \param[out] F [ndof x ntraj] matrix, the forces are written into its column itraj
 
-  There are 2 possible use cases:
-  a) lvl = 0 ampl_adi is a nadi x ntraj matrix and is meant to 
-  be handled by the current Hamiltonian (e.g. like the NBRA) 
+  This is the same quantity as computed by Ehrenfest_forces_adi_unit (with T = I):
 
-  b) lvl = 1 ampl_adi is a nadi x ntraj matrix (ntraj trajectories) and 
-  each trajectory is meant to be handled by a separate sub-Hamiltonian 
+  F_n = -Re[ c^+ (dH_n - (D_n^+ H + H D_n)) c ] / (c^+ c)
 
-  \params[in] option [0 or 1] - option 0 keeps all the terms in the Ehrenfest force expression, including NAC
-  option 1 removes all the derivative NACs - this is to enforce the local diabatization approximation, to be
-  consistent with it
+  but without the matrix-matrix products: the dH_n term is contracted over the upper triangle
+  (dH_n is Hermitian) and the NAC term reduces to  2 Re[ (H c)^+ (D_n c) ], where H c is
+  computed once for all DOFs. So the cost is O(nadi^2) per DOF instead of O(nadi^3).
+  The matrices H and dH_n are assumed to be Hermitian.
+*/
 
-  Returns:
-  MATRIX(ndof, ntraj) - Ehrenfest forces in adiabatic representation, for multiple trajectories
+  if(ham_adi_mem_status==0){ cout<<"Error in Ehrenfest_forces_adi_contract(): the adiabatic Hamiltonian matrix is not allocated \
+  but it is needed for the calculations\n"; exit(0); }
 
-*/
-  int i;
-
-  if(lvl==1){
-    // Check whether we have enough sub-Hamiltonians
-    if(children.size()!=ampl_adi.n_cols){
-      cout<<"ERROR in CMATRIX nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi):\n";
-      cout<<"The number of columns of the ampl_adi ("<<ampl_adi.n_cols<<")";
-      cout<<" should be equal to the number of children Hamiltonians ("<<children.size()<<")\n";
-      cout<<"Exiting...\n";
-      exit(0);
+  int i, j, n;
+  int nst = nadi;
+  int ntraj = ampl_adi.n_cols;
+
+  vector< complex<double> > c(nst), w(nst);
+  double norm = 0.0;
+  for(i=0;i<nst;i++){ c[i] = ampl_adi.M[i*ntraj+itraj];  norm += std::norm(c[i]); }
+
+  // w = H * c
+  if(option==0){
+    const complex<double>* h = ham_adi->M;
+    for(i=0;i<nst;i++){
+      w[i] = complex<double>(0.0, 0.0);
+      for(j=0;j<nst;j++){ w[i] += h[i*nst+j] * c[j]; }
     }
   }
 
 
-  CMATRIX ampl_tmp(ampl_adi.n_rows, 1);
-  CMATRIX frc_tmp(nnucl, 1);
-  CMATRIX F(nnucl, ampl_adi.n_cols);
+  for(n=0;n<nnucl;n++){
 
-  vector<int> stenc_ampl(ampl_adi.n_rows, 0);
-  vector<int> stenc_frc(nnucl, 0);
-  vector<int> stenc_col(1, 0);
-
-  // The indicies in stenc_frc reflects which indicies are to be updated in the final F matrix
-  for(i=0;i<nnucl;i++) { stenc_frc[i] = i;}   
+    if(d1ham_adi_mem_status[n]==0){ cout<<"Error in Ehrenfest_forces_adi_contract(): the derivatives of the Hamiltonian matrix in the \
+    adiabatic basis w.r.t. the nuclear DOF "<<n<<" is not allocated but is needed for the calculations \n"; exit(0); }
 
-  for(i=0;i<ampl_adi.n_rows;i++){ stenc_ampl[i] = i;}
+    // Re[ c^+ dH_n c ]
+    const complex<double>* dh = d1ham_adi[n]->M;
+    double e = 0.0;
+    for(i=0;i<nst;i++){
+      complex<double> tmp(0.0, 0.0);
+      for(j=i+1;j<nst;j++){ tmp += dh[i*nst+j] * c[j]; }
+      e += dh[i*nst+i].real() * std::norm(c[i]) + 2.0 * (std::conj(c[i]) * tmp).real();
+    }
 
-  for(i=0;i<ampl_adi.n_cols;i++){
-    stenc_col[0] = i;
+    // - 2 Re[ (H c)^+ (D_n c) ]
+    if(option==0){
 
-    pop_submatrix(ampl_adi, ampl_tmp, stenc_ampl, stenc_col);
+      if(dc1_adi_mem_status[n]==0){ cout<<"Error in Ehrenfest_forces_adi_contract(): the derivatives couplings matrix in the adiabatic \
+      basis w.r.t. the nuclear DOF "<<n<<" is not allocated but is needed for the calculations \n"; exit(0); }
 
-    if(lvl==0){
-        frc_tmp = Ehrenfest_forces_adi_unit(ampl_tmp, option);
-    }
-    if(lvl==1){
-        frc_tmp = children[i]->Ehrenfest_forces_adi_unit(ampl_tmp, option, *transforms[i] );
+      const complex<double>* d = dc1_adi[n]->M;
+      complex<double> tmp(0.0, 0.0);
+      for(i=0;i<nst;i++){
+        complex<double> dc(0.0, 0.0);
+        for(j=0;j<nst;j++){ dc += d[i*nst+j] * c[j]; }
+        tmp += std::conj(w[i]) * dc;
+      }
+      e -= 2.0 * tmp.real();
     }
 
-    push_submatrix(F, frc_tmp, stenc_frc, stenc_col);
- 
-  }// for all children
+    F.M[n*ntraj+itraj] = -e / norm;
+
+  }// for n
 
-  return F;
 }
 
-CMATRIX nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl, int option){
+
+void nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, MATRIX& F, int lvl, int option){
+/**
+  \brief Computes the Ehrenfest forces in the adiabatic basis for all trajectories, into the preallocated matrix
+
+  \param[in] ampl_adi [nadi x ntraj] matrix of adiabatic amplitudes
+  \param[out] F [ndof x ntraj] matrix of the (real) forces, must be allocated by the caller
+  \param[in] lvl [0 or 1] - same as in Ehrenfest_forces_adi(ampl_adi, lvl, option)
+  \param[in] option [0 or 1] - same as in Ehrenfest_forces_adi_unit
+
+  The trajectories are processed in parallel, each by the Ehrenfest_forces_adi_contract kernel
+*/
+
   int ntraj = ampl_adi.n_cols;
-  vector<CMATRIX*> I(ntraj);
 
+  if(lvl==1 && (int)children.size()!=ntraj){
+    cout<<"ERROR in nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, MATRIX& F, int lvl, int option):\n";
+    cout<<"The number of columns of the ampl_adi ("<<ntraj<<")";
+    cout<<" should be equal to the number of children Hamiltonians ("<<children.size()<<")\n";
+    cout<<"Exiting...\n";
+    exit(0);
+  }
+
+  if(F.n_rows!=nnucl || F.n_cols!=ntraj){
+    cout<<"ERROR in nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, MATRIX& F, int lvl, int option):\n";
+    cout<<"The forces matrix should be of the size "<<nnucl<<" x "<<ntraj<<", but it is "<<F.n_rows<<" x "<<F.n_cols<<"\n";
+    cout<<"Exiting...\n";
+    exit(0);
+  }
+
+  #pragma omp parallel for
   for(int itraj=0; itraj<ntraj; itraj++){
-    I[itraj] = new CMATRIX(nadi, nadi);
-    I[itraj]->load_identity();
-  }      
+    if(lvl==0){  Ehrenfest_forces_adi_contract(ampl_adi, itraj, option, F);  }
+    else{  children[itraj]->Ehrenfest_forces_adi_contract(ampl_adi, itraj, option, F);  }
+  }
 
-  CMATRIX F(nnucl, ampl_adi.n_cols);
+}
 
-  F = Ehrenfest_forces_adi(ampl_adi, lvl, option, I);
 
-  for(int itraj=0; itraj<ntraj; itraj++){  delete I[itraj];  }  I.clear();
+CMATRIX nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl, int option, vector<CMATRIX*>& transforms){
+/**
+  \brief Computes the Ehrenfest forces in the adiabatic basis
 
-  return F;
+  \param[in] ampl_adi [nadi x ntraj] matrix of adiabatic amplitudes for
+  one of many (ntraj) trajectories
+  \param[in] lvl [0 or 1] - 0 - use the present level for all trajectories, 1 - use the next 
+  level for the trajectories (one sub-Hamiltonian per each trajectory) 
 
-}
+  There are 2 possible use cases:
+  a) lvl = 0 ampl_adi is a nadi x ntraj matrix and is meant to 
+  be handled by the current Hamiltonian (e.g. like the NBRA) 
 
-CMATRIX nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl){
-  int ntraj = ampl_adi.n_cols;
-  vector<CMATRIX*> I(ntraj);
+  b) lvl = 1 ampl_adi is a nadi x ntraj matrix (ntraj trajectories) and 
+  each trajectory is meant to be handled by a separate sub-Hamiltonian 
 
-  for(int itraj=0; itraj<ntraj; itraj++){
-    I[itraj] = new CMATRIX(nadi, nadi);
-    I[itraj]->load_identity();
-  }  
+  \params[in] option [0 or 1] - option 0 keeps all the terms in the Ehrenfest force expression, including NAC
+  option 1 removes all the derivative NACs - this is to enforce the local diabatization approximation, to be
+  consistent with it
+
+  Returns:
+  MATRIX(ndof, ntraj) - Ehrenfest forces in adiabatic representation, for multiple trajectories
 
-  CMATRIX F(nnucl, ampl_adi.n_cols);
+  The forces are computed by the Ehrenfest_forces_adi_contract kernel, see the
+  Ehrenfest_forces_adi(ampl_adi, F, lvl, option) for the version that avoids the allocations.
+  As in Ehrenfest_forces_adi_unit, the transforms are not applied (T = I)
+*/
 
-  F = Ehrenfest_forces_adi(ampl_adi, lvl, 0, I);
+  MATRIX f(nnucl, ampl_adi.n_cols);
+  Ehrenfest_forces_adi(ampl_adi, f, lvl, option);
+
+  return CMATRIX(f);
+}
 
-  for(int itraj=0; itraj<ntraj; itraj++){  delete I[itraj];  }  I.clear();
-  return F;
+CMATRIX nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl, int option){
+  MATRIX f(nnucl, ampl_adi.n_cols);
+  Ehrenfest_forces_adi(ampl_adi, f, lvl, option);
+  return CMATRIX(f);
+}
+
+CMATRIX nHamiltonian::Ehrenfest_forces_adi(CMATRIX& ampl_adi, int lvl){
+  return Ehrenfest_forces_adi(ampl_adi, lvl, 0);
 }
 
 
@@ -24,6 +24,7 @@
 
 #include "nHamiltonian.h"
 #include "../math_meigen/libmeigen.h"
+#include "../timer/Profiler.h"
 
 
 /// liblibra namespace
@@ -292,6 +293,7 @@ CMATRIX nHamiltonian::update_phases(CMATRIX& U_prev){
 
 
 void nHamiltonian::compute_adiabatic(int der_lvl){
+  ScopedTimer _prof("nHamiltonian::compute_adiabatic");
 
   compute_adiabatic(der_lvl, 0);
 
@@ -25,6 +25,8 @@
 #include "nHamiltonian.h"
 //#include "../Hamiltonian_Model/libhamiltonian_model.h"
 #include "../io/libio.h"
+#include "../timer/Profiler.h"
+#include "../models/libmodels.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -34,6 +36,7 @@ namespace libnhamiltonian{
 
 ///using namespace libhamiltonian_model;
 using namespace libio;
+using namespace libmodels;
 
 
 namespace bp = boost::python;
@@ -54,18 +57,81 @@ bp::object import_py_funct(const std::string& module, const std::string& path, b
 
 
 void nHamiltonian::compute_diabatic(int model, vector<double>& q, vector<double>& params){
+/**
+  Performs the diabatic properties calculation at the top-most level of the Hamiltonians 
+  hierarchy. See the description of the more general function prototype for more info.
+*/ 
 
   compute_diabatic(model, q, params, 0);
 
 }
 
+
+void nHamiltonian::compute_model(int model, const vector<double>& q, vector<double>& params){
+/**
+  Calls one of the model Hamiltonians implemented in C++ (see the models folder) for this node
+
+  model = 0   - model_SAC          model = 3   - model_2S_1D_sin
+  model = 1   - model_DAC          model = 4   - model_2S_2D_sin
+  model = 2   - model_ECWR         model = 5   - model_2S_1D_tanh
+  model = 100 - model_1S_1D_poly2  model = 101 - model_1S_1D_poly4
+  model = 200 - model_LVC (also the spin-boson and Holstein-Peierls models)
+
+  The LVC model writes directly into the storage of this Hamiltonian, the other models 
+  use the temporary matrices
+*/
+
+  if(ham_dia_mem_status==0 || ovlp_dia_mem_status==0){
+    cout<<"Error in nHamiltonian::compute_diabatic: ham_dia and ovlp_dia must be allocated first\nExiting...\n"; exit(0);
+  }
+  for(int i=0;i<nnucl;i++){
+    if(d1ham_dia_mem_status[i]==0 || dc1_dia_mem_status[i]==0){
+      cout<<"Error in nHamiltonian::compute_diabatic: d1ham_dia and dc1_dia must be allocated first\nExiting...\n"; exit(0);
+    }
+  }
+
+  if(model==200){  model_LVC(ham_dia, ovlp_dia, d1ham_dia, dc1_dia, q, params);   return; }
+
+  CMATRIX Hdia(ndia, ndia);
+  CMATRIX Sdia(ndia, ndia);
+  vector<CMATRIX> d1(nnucl, CMATRIX(ndia, ndia));
+  vector<CMATRIX> dc1(nnucl, CMATRIX(ndia, ndia));
+  vector<double> _q(q);
+
+  if(model==0){        model_SAC(Hdia, Sdia, d1, dc1, _q, params);  }
+  else if(model==1){   model_DAC(Hdia, Sdia, d1, dc1, _q, params);  }
+  else if(model==2){   model_ECWR(Hdia, Sdia, d1, dc1, _q, params);  }
+  else if(model==3){   model_2S_1D_sin(Hdia, Sdia, d1, dc1, _q, params);  }
+  else if(model==4){   model_2S_2D_sin(Hdia, Sdia, d1, dc1, _q, params);  }
+  else if(model==5){   model_2S_1D_tanh(Hdia, Sdia, d1, dc1, _q, params);  }
+  else if(model==100){ model_1S_1D_poly2(Hdia, Sdia, d1, dc1, _q, params);  }
+  else if(model==101){ model_1S_1D_poly4(Hdia, Sdia, d1, dc1, _q, params);  }
+  else{
+    cout<<"Error in nHamiltonian::compute_diabatic: model = "<<model<<" is not defined\nExiting...\n"; exit(0);
+  }
+
+  *ham_dia = Hdia;
+  *ovlp_dia = Sdia;
+  for(int i=0;i<nnucl;i++){  *d1ham_dia[i] = d1[i];  *dc1_dia[i] = dc1[i];  }
+
+}
+
+
 void nHamiltonian::compute_diabatic(int model, vector<double>& q, vector<double>& params, int lvl){
+/**
+  Computes the diabatic properties (ham_dia, ovlp_dia, d1ham_dia, dc1_dia) using one of the model 
+  Hamiltonians implemented in C++, see compute_model for the available models
 
-  if(level==lvl){
-/* 
-    if(model==100){   model_1S_1D_poly2(ham_dia, ovlp_dia, d1ham_dia, dc1_dia, q, params);  }
-    if(model==100){   model_1S_1D_poly4(ham_dia, ovlp_dia, d1ham_dia, dc1_dia, q, params);  }
+  q - the nuclear coordinates, the same for all the Hamiltonians at the level lvl
+  params - the parameters of the model, e.g. as produced by set_params_LVC
+
+  lvl - is the level of the Hamiltonians in the hierarchy of Hamiltonians to be executed by this call 
 */
+
+  if(level==lvl){
+
+    compute_model(model, q, params);
+
   }
   else if(lvl>level){
   
@@ -81,7 +147,53 @@ void nHamiltonian::compute_diabatic(int model, vector<double>& q, vector<double>
      child node\n";    
   }
 
+}
+
+
+void nHamiltonian::compute_diabatic(int model, MATRIX& q, vector<double>& params, int lvl){
+/**
+  Same as above, but for the swarm of trajectories: q is a MATRIX(nnucl, ntraj) and the column i 
+  is used by the i-th child Hamiltonian. The children are evaluated in parallel, with no
+  calls to Python. 
+
+  lvl - the level of the Hamiltonians to compute: level (then ntraj must be 1) or level+1 
+  (then ntraj must be equal to the number of the children)
+*/
+
+  ScopedTimer _prof("nHamiltonian::compute_diabatic(model)");
+
+  int ntraj = q.n_cols;
+
+  if(lvl==level){
 
+    if(ntraj!=1){
+      cout<<"Error in nHamiltonian::compute_diabatic: the Hamiltonian at the level "<<lvl
+          <<" needs a single column of the coordinates, but "<<ntraj<<" are given\nExiting...\n"; exit(0);
+    }
+    vector<double> qi(q.M, q.M + q.n_rows);
+    compute_model(model, qi, params);
+
+  }
+  else if(lvl==level+1){
+
+    if(ntraj!=children.size()){
+      cout<<"Error in nHamiltonian::compute_diabatic: the number of the coordinate columns ("<<ntraj
+          <<") is not equal to the number of the children Hamiltonians ("<<children.size()<<")\nExiting...\n"; exit(0);
+    }
+
+    #pragma omp parallel for
+    for(int i=0;i<ntraj;i++){
+      vector<double> qi(q.n_rows, 0.0);
+      for(int k=0;k<q.n_rows;k++){  qi[k] = q.M[k*ntraj+i];  }
+
+      children[i]->compute_model(model, qi, params);
+    }
+
+  }
+  else{
+    cout<<"Error in nHamiltonian::compute_diabatic: the level "<<lvl<<" can not be computed from the level "
+        <<level<<" with the coordinates given as a matrix\nExiting...\n"; exit(0);
+  }
 
 }
 
@@ -92,6 +204,7 @@ void nHamiltonian::compute_diabatic(bp::object py_funct, MATRIX& q, bp::object p
   Performs the diabatic properties calculation at the top-most level of the Hamiltonians 
   hierarchy. See the description of the more general function prototype for more info.
 */ 
+  ScopedTimer _prof("nHamiltonian::compute_diabatic");
 
   compute_diabatic(py_funct, q, params, 0);
 
@@ -24,6 +24,7 @@
 
 #include "nHamiltonian.h"
 #include "../math_meigen/libmeigen.h"
+#include "../calculators/NPI.h"
 
 
 /// liblibra namespace
@@ -35,6 +36,7 @@ namespace libnhamiltonian{
 
 using namespace liblinalg;
 using namespace libmeigen;
+using namespace libcalculators;
 
 
 
@@ -171,10 +173,146 @@ void nHamiltonian::compute_nac_dia(MATRIX& p, const MATRIX& invM, int lvl, int s
 
 
 
-void nHamiltonian::compute_nac_adi(double dt, int method){
-/***
-  One of the ways to update scalar NAC matrix, using the time-overlap info
+vector<int> max_overlap_reordering(CMATRIX& St){
+/**
+  Match the states at time t (rows of St = <psi_i(t)|psi_j(t+dt)>) to the states at
+  time t+dt (columns), taking the pairs with the largest |St_ij| first.
+
+  Returns perm, such that the state i at time t continues as the state perm[i] at t+dt.
+  perm[i] != i indicates the trivial (unavoided) crossing of the state i.
+*/
+
+  int n = St.n_rows;
+  int i, j, k;
+  vector<int> perm(n, -1);
+  vector<int> is_used(n, 0);
+
+  for(k=0; k<n; k++){
+    int imax = -1, jmax = -1;
+    double vmax = -1.0;
+
+    for(i=0; i<n; i++){
+      if(perm[i]>=0){ continue; }
+      for(j=0; j<n; j++){
+        if(is_used[j]){ continue; }
+        double v = std::abs(St.get(i,j));
+        if(v>vmax){ vmax = v; imax = i; jmax = j; }
+      }
+    }
+
+    perm[imax] = jmax;
+    is_used[jmax] = 1;
+  }
+
+  return perm;
+}
+
+
+void nac_from_time_overlap(CMATRIX& St, CMATRIX& nac, double dt, int method, vector<int>& perm){
+/**
+  Compute the NACs, nac_ij = <psi_i|d/dt|psi_j> at the midpoint t+dt/2, from the time-overlap
+  St_ij = <psi_i(t)|psi_j(t+dt)>.
+
+  First, the states at t+dt are reordered to follow the states at t (trivial crossings, see
+  max_overlap_reordering) and their phases are chosen such that the diagonal of the reordered
+  overlap S is real and positive. The NACs are hence indexed by the states at time t.
+
+  method:
+    0 - Hammes-Schiffer - Tully:   nac = (S - S^+) / (2*dt)
+    1 - norm-preserving interpolation (NPI) of Meek and Levine, J. Phys. Chem. Lett. 2014, 5, 2351:
+        libcalculators::nac_npi applied to the real part of the orthonormalized S
+    2 - matrix logarithm:  nac = log(U) / dt, with U = the orthonormalized (Lowdin) S. This is exact
+        for the states rotating with the constant generator over the step. The principal logarithm
+        (libmeigen::log_matrix) is used, so the eigenphases of U should stay within (-pi, pi)
+
+  \param[out] perm - the reordering found: the state i at time t is the state perm[i] at t+dt
+*/
+
+  int n = St.n_rows;
+  int i, j;
+
+  if(dt==0.0){
+    cout<<"Error in nac_from_time_overlap(): dt can not be zero\nExiting...\n";
+    exit(0);
+  }
+
+  // Trivial crossings and phases
+  perm = max_overlap_reordering(St);
+
+  CMATRIX S(n, n);
+  for(i=0; i<n; i++){
+    for(j=0; j<n; j++){  S.set(i, j, St.get(i, perm[j]));  }
+  }
+
+  for(j=0; j<n; j++){
+    complex<double> d = S.get(j,j);
+    double a = std::abs(d);
+    if(a>1e-12){
+      complex<double> ph = std::conj(d) / a;
+      for(i=0; i<n; i++){ S.set(i, j, S.get(i,j) * ph); }
+    }
+  }
+
+  nac = complex<double>(0.0, 0.0);
+
+  if(method==0){
+    for(i=0; i<n; i++){
+      for(j=0; j<n; j++){
+        nac.set(i, j, (S.get(i,j) - std::conj(S.get(j,i))) / (2.0*dt) );
+      }
+    }
+  }
+
+  else if(method==1 || method==2){
+
+    // Orthonormalize: S = W * s * V^+  ==>  U = W * V^+
+    CMATRIX W(n, n), sv(n, n), V(n, n), U(n, n);
+    JacobiSVD_decomposition(S, W, sv, V);
+    U = W * V.H();
+
+    if(method==1){
+
+      MATRIX U_re(U.real());
+      MATRIX nac_re(nac_npi(U_re, dt));
+      MATRIX nac_im(n, n);
+      nac = CMATRIX(nac_re, nac_im);
+
+    }// method == 1
+
+    else{
+
+      // The principal logarithm of the unitary U is anti-Hermitian: nac = log(U) / dt
+      CMATRIX L(n, n);
+      log_matrix(L, U);
+
+      nac = L / dt;
+
+    }// method == 2
 
+  }// method == 1 or 2
+
+  else{
+    cout<<"Error in nac_from_time_overlap(): method = "<<method<<" is not defined\nExiting...\n";
+    exit(0);
+  }
+
+  for(i=0; i<n; i++){ nac.set(i, i, complex<double>(0.0, nac.get(i,i).imag()) ); }
+
+}
+
+
+
+void nHamiltonian::compute_nac_adi(double dt, int method, vector<int>& perm){
+/**
+  Compute the scalar NAC matrix from the time-overlap of the adiabatic states,
+  time_overlap_adi = <psi_adi(t)|psi_adi(t+dt)>. See nac_from_time_overlap for the methods:
+  0 - HST, 1 - NPI, 2 - matrix logarithm.
+
+  perm[i] is the index of the state at t+dt that continues the state i at time t (trivial
+  crossings). The reordering is applied to the present (t+dt) Hamiltonian with update_ordering
+  (basis_transform, ham_adi, the derivatives, ordering_adi) and to the columns of time_overlap_adi,
+  so after the call all the adiabatic properties, as well as nac_adi, follow the states at time t.
+  The phases of basis_transform are not changed.
 */ 
 
   if(time_overlap_adi_mem_status==0){ cout<<"Error in compute_nac_adi(): the memory is not allocated for \
@@ -183,13 +321,56 @@ void nHamiltonian::compute_nac_adi(double dt, int method){
   if(nac_adi_mem_status==0){ cout<<"Error in compute_nac_adi(): the memory is not allocated for \
   nac_adi but is needed for the calculations \n"; exit(0); }
 
-  nac_adi->set(-1, std::complex<double>(0.0, 0.0));
+  CMATRIX nac(nadi, nadi);
+  nac_from_time_overlap(*time_overlap_adi, nac, dt, method, perm);
+
+  int is_identity = 1;
+  for(int i=0; i<nadi; i++){ if(perm[i]!=i){ is_identity = 0; break; } }
+
+  if(!is_identity){
+    update_ordering(perm, level);
+    time_overlap_adi->permute_cols(perm);
+  }
+
+  *nac_adi = nac;
+
+}
 
 
-  // HST formula
-  if(method==0){  
+void nHamiltonian::compute_nac_adi(double dt, int method){
+/***
+  Same as above, the reordering is not returned
+*/
 
- //   nac_adi->
+  vector<int> perm;
+  compute_nac_adi(dt, method, perm);
+
+}
+
+
+void nHamiltonian::compute_nac_adi(double dt, int method, int lvl){
+/**
+  Same as above, for all the Hamiltonians at the level lvl of the hierarchy, e.g.
+  for all trajectories at once. The children are processed in parallel.
+*/
+
+  if(lvl==level){
+    compute_nac_adi(dt, method);
+  }
+
+  else if(lvl>level){
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i=0;i<(int)children.size();i++){
+      children[i]->compute_nac_adi(dt, method, lvl);
+    }
+
+  }
+
+  else{
+    cout<<"WARNING in nHamiltonian::compute_nac_adi\n"; 
+    cout<<"Can not run evaluation of function in the parent Hamiltonian from the\
+     child node\n";    
   }
 
 }
@@ -0,0 +1,578 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 2 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Geometry_optimization.cpp
+  \brief The geometry optimization (energy minimization) of the System with the forces from the
+  Hamiltonian object (MM, QM, or any other): L-BFGS, FIRE, and conjugate gradients, optionally
+  together with the relaxation of the periodic cell
+
+  References:
+
+  [1] Nocedal, J. Math. Comp. 1980, 35, 773 - L-BFGS
+  [2] Bitzek, E.; Koskinen, P.; Gahler, F.; Moseler, M.; Gumbsch, P. Phys. Rev. Lett. 2006, 97, 170201 - FIRE
+  [3] Tadmor, E. B.; Smith, G. S.; Bernstein, N.; Kaxiras, E. Phys. Rev. B 1999, 59, 235 - the cell DOFs
+
+*/
+
+#include "State.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+namespace libscripts{
+namespace libstate{
+
+
+
+GeomOpt::GeomOpt(){
+
+  method = "LBFGS";
+  method_index = 0;
+  max_steps = 1000;
+  force_tol = 1e-3;
+  energy_tol = 1e-6;
+  max_step = 0.2;
+  el_opt = 1;
+  verbosity = 0;
+
+  lbfgs_memory = 10;
+
+  fire_dt_start = 0.1;
+  fire_dt_max = 1.0;
+  fire_f_inc = 1.1;
+  fire_f_dec = 0.5;
+  fire_alpha_start = 0.1;
+  fire_f_alpha = 0.99;
+  fire_n_min = 5;
+
+  relax_cell = 0;
+  target_pressure = 0.0;
+  cell_factor = 0.0;
+
+  n_steps = 0;
+  is_converged = 0;
+  energy = 0.0;
+  max_force = 0.0;
+
+}
+
+
+GeomOpt::GeomOpt(boost::python::dict params) : GeomOpt(){
+
+  set_parameters(params);
+
+}
+
+
+void GeomOpt::set_parameters(boost::python::dict params){
+
+  std::string key;
+  for(int i=0;i<len(params.values());i++){
+    key = extract<std::string>(params.keys()[i]);
+
+    if(key=="method") { method = extract<std::string>(params.values()[i]); }
+    else if(key=="max_steps") { max_steps = extract<int>(params.values()[i]); }
+    else if(key=="force_tol") { force_tol = extract<double>(params.values()[i]); }
+    else if(key=="energy_tol") { energy_tol = extract<double>(params.values()[i]); }
+    else if(key=="max_step") { max_step = extract<double>(params.values()[i]); }
+    else if(key=="el_opt") { el_opt = extract<int>(params.values()[i]); }
+    else if(key=="verbosity") { verbosity = extract<int>(params.values()[i]); }
+    else if(key=="lbfgs_memory") { lbfgs_memory = extract<int>(params.values()[i]); }
+    else if(key=="fire_dt_start") { fire_dt_start = extract<double>(params.values()[i]); }
+    else if(key=="fire_dt_max") { fire_dt_max = extract<double>(params.values()[i]); }
+    else if(key=="fire_f_inc") { fire_f_inc = extract<double>(params.values()[i]); }
+    else if(key=="fire_f_dec") { fire_f_dec = extract<double>(params.values()[i]); }
+    else if(key=="fire_alpha_start") { fire_alpha_start = extract<double>(params.values()[i]); }
+    else if(key=="fire_f_alpha") { fire_f_alpha = extract<double>(params.values()[i]); }
+    else if(key=="fire_n_min") { fire_n_min = extract<int>(params.values()[i]); }
+    else if(key=="relax_cell") { relax_cell = extract<int>(params.values()[i]); }
+    else if(key=="target_pressure") { target_pressure = extract<double>(params.values()[i]); }
+    else if(key=="cell_factor") { cell_factor = extract<double>(params.values()[i]); }
+
+  }// for i
+
+}
+
+
+void GeomOpt::show_info(){
+
+  cout<<"Geometry optimization with parameters:\n";
+  cout<<"method = "<<method<<endl;
+  cout<<"max_steps = "<<max_steps<<endl;
+  cout<<"force_tol = "<<force_tol<<endl;
+  cout<<"energy_tol = "<<energy_tol<<endl;
+  cout<<"max_step = "<<max_step<<endl;
+  cout<<"el_opt = "<<el_opt<<endl;
+  cout<<"verbosity = "<<verbosity<<endl;
+  if(method_index==0){  cout<<"lbfgs_memory = "<<lbfgs_memory<<endl;  }
+  if(method_index==1){
+    cout<<"fire_dt_start = "<<fire_dt_start<<endl;
+    cout<<"fire_dt_max = "<<fire_dt_max<<endl;
+    cout<<"fire_f_inc = "<<fire_f_inc<<endl;
+    cout<<"fire_f_dec = "<<fire_f_dec<<endl;
+    cout<<"fire_alpha_start = "<<fire_alpha_start<<endl;
+    cout<<"fire_f_alpha = "<<fire_f_alpha<<endl;
+    cout<<"fire_n_min = "<<fire_n_min<<endl;
+  }
+  cout<<"relax_cell = "<<relax_cell<<endl;
+  if(relax_cell){
+    cout<<"target_pressure = "<<target_pressure<<endl;
+    cout<<"cell_factor = "<<cell_factor<<endl;
+  }
+
+}
+
+
+
+class geom_objective{
+/**
+  The function to minimize: the energy (or the enthalpy E + P*V, with the cell relaxation) as a function
+  of the flat vector x of the optimized DOFs
+
+  x = [r_ref (3*Natoms), cell_factor * eps (9)],  r = (I + eps) * r_ref,  Box = (I + eps) * Box_0
+
+  Without the cell relaxation x are just the atomic coordinates
+*/
+
+public:
+
+  System* syst;
+  Nuclear* mol;
+  Electronic* el;
+  Hamiltonian* ham;
+  GeomOpt* prms;
+  Hamiltonian_Atomistic* ham_at;
+
+  int nat;       ///< the number of atoms
+  int n;         ///< the number of the optimized DOFs
+  MATRIX3x3 h0;  ///< the cell at the beginning of the optimization
+  double cf;     ///< cell_factor
+
+
+  geom_objective(System& _syst, Nuclear& _mol, Electronic& _el, Hamiltonian& _ham, GeomOpt& _prms){
+
+    syst = &_syst;  mol = &_mol;  el = &_el;  ham = &_ham;  prms = &_prms;
+    ham_at = NULL;
+
+    nat = syst->Number_of_atoms;
+    n = 3*nat;
+
+    if(mol->nnucl!=3*nat){
+      cout<<"Error in optimize_geometry: the Nuclear object has "<<mol->nnucl<<" DOFs, but the System has "
+          <<nat<<" atoms\nExiting...\n"; exit(0);
+    }
+
+    if(prms->relax_cell){
+      ham_at = dynamic_cast<Hamiltonian_Atomistic*>(ham);
+
+      if(ham_at==NULL){
+        cout<<"Error in optimize_geometry: the cell relaxation needs the stress, which is only available for the "
+            <<"Hamiltonian_Atomistic objects\nExiting...\n"; exit(0);
+      }
+      if(!ham_at->is_stress_available()){
+        cout<<"Error in optimize_geometry: the cell relaxation needs the stress, which is only implemented for the "
+            <<"pure MM Hamiltonians\nExiting...\n"; exit(0);
+      }
+      if(!syst->is_Box){
+        cout<<"Error in optimize_geometry: the cell relaxation is requested, but the System has no Box\nExiting...\n"; exit(0);
+      }
+
+      n += 9;
+      h0 = syst->Box;
+      cf = (prms->cell_factor > 0.0) ? prms->cell_factor : double(nat);
+    }
+
+  }
+
+
+  void init(vector<double>& x){
+  /** The initial point - the current coordinates of the System */
+
+    x = vector<double>(n, 0.0);
+    syst->extract_atomic_q(mol->q);
+
+    for(int i=0; i<3*nat; i++){ x[i] = mol->q[i]; }
+
+  }
+
+
+  MATRIX3x3 deformation(vector<double>& x){
+
+    MATRIX3x3 F; F.identity();
+    if(prms->relax_cell){
+      const double* e = &x[3*nat];
+      F.xx += e[0]/cf;  F.xy += e[1]/cf;  F.xz += e[2]/cf;
+      F.yx += e[3]/cf;  F.yy += e[4]/cf;  F.yz += e[5]/cf;
+      F.zx += e[6]/cf;  F.zy += e[7]/cf;  F.zz += e[8]/cf;
+    }
+    return F;
+
+  }
+
+
+  double eval(vector<double>& x, vector<double>& g, double& fmax){
+  /**
+    Returns the energy at x, its gradient g, and the max atomic force norm fmax (or the max
+    cell force component, if larger). The System and the Nuclear objects are set to the point x
+  */
+
+    int i;
+    MATRIX3x3 F = deformation(x);
+
+    if(prms->relax_cell){  syst->Box = F * h0;  }
+
+    for(i=0; i<nat; i++){
+      VECTOR r(x[3*i], x[3*i+1], x[3*i+2]);
+      if(prms->relax_cell){  r = F * r;  }
+      mol->q[3*i] = r.x;  mol->q[3*i+1] = r.y;  mol->q[3*i+2] = r.z;
+    }
+
+    double E = compute_forces(mol, el, ham, prms->el_opt);
+
+    g = vector<double>(n, 0.0);
+    fmax = 0.0;
+
+    for(i=0; i<nat; i++){
+      VECTOR f(mol->f[3*i], mol->f[3*i+1], mol->f[3*i+2]);
+
+      double fn = f.length();
+      if(fn > fmax){ fmax = fn; }
+
+      if(prms->relax_cell){  f = F.T() * f;  }
+      g[3*i] = -f.x;  g[3*i+1] = -f.y;  g[3*i+2] = -f.z;
+    }
+
+    if(prms->relax_cell){
+      // dE/d(eps) = -(W - P*V*I) * F^{-T}, W = sum r x f - the virial
+      double V = syst->volume();
+      MATRIX3x3 W = ham_at->get_stress("at");
+      W.xx -= prms->target_pressure * V;
+      W.yy -= prms->target_pressure * V;
+      W.zz -= prms->target_pressure * V;
+
+      MATRIX3x3 G = -1.0 * (W * F.inverse().T());
+      G = 0.5*(G + G.T());   // no rotations of the cell
+
+      double* gc = &g[3*nat];
+      gc[0] = G.xx;  gc[1] = G.xy;  gc[2] = G.xz;
+      gc[3] = G.yx;  gc[4] = G.yy;  gc[5] = G.yz;
+      gc[6] = G.zx;  gc[7] = G.zy;  gc[8] = G.zz;
+
+      for(i=0; i<9; i++){
+        gc[i] /= cf;
+        if(fabs(gc[i]) > fmax){ fmax = fabs(gc[i]); }
+      }
+
+      E += prms->target_pressure * V;
+    }
+
+    return E;
+
+  }
+
+
+  void finalize(vector<double>& x){
+  /** Sets the System to the final point and re-initializes the fragments for the new geometry */
+
+    vector<double> g;
+    double fmax;
+    eval(x, g, fmax);
+
+    syst->set_atomic_q(mol->q);
+    syst->init_fragments();
+
+  }
+
+};
+
+
+
+static double dot(vector<double>& a, vector<double>& b){
+  double res = 0.0;
+  for(int k=0; k<(int)a.size(); k++){ res += a[k] * b[k]; }
+  return res;
+}
+
+
+static double max_abs(vector<double>& a){
+  double res = 0.0;
+  for(int k=0; k<(int)a.size(); k++){ if(fabs(a[k]) > res){ res = fabs(a[k]); } }
+  return res;
+}
+
+
+static double line_search(geom_objective& obj, vector<double>& x, vector<double>& d, double step, double E, vector<double>& g,
+                          vector<double>& x_new, vector<double>& g_new, double& fmax, int& status){
+/**
+  Backtracking line search along d with the Armijo condition, starting from the step `step`
+
+  Returns the energy at the accepted point x_new (the gradient is g_new); status = 0 if no point is accepted
+*/
+
+  int n = x.size();
+  double gd = dot(g, d);
+  double E_new = E;
+  status = 0;
+
+  for(int it=0; it<30; it++){
+
+    for(int i=0; i<n; i++){ x_new[i] = x[i] + step * d[i]; }
+    E_new = obj.eval(x_new, g_new, fmax);
+
+    if(E_new <= E + 1e-4 * step * gd){ status = 1; break; }
+    step *= 0.5;
+  }
+
+  return E_new;
+
+}
+
+
+
+double optimize_geometry(System& syst, Nuclear& mol, Electronic& el, Hamiltonian& ham, GeomOpt& prms){
+/**
+  \brief Minimizes the energy of the System w.r.t. the atomic coordinates (and the periodic cell)
+  \param[in,out] syst The System to optimize; on return, contains the optimized coordinates (and Box)
+  \param[in,out] mol The Nuclear object used to exchange the coordinates and forces with the Hamiltonian
+  \param[in] el Describes the electronic DOF - defines the energy surface, see compute_forces()
+  \param[in,out] ham The Hamiltonian (bound to the syst) that computes the energy and forces
+  \param[in,out] prms The optimization parameters; the results are stored in it too
+
+  The optimization stops when the max force norm is below force_tol and the energy changed by less
+  than energy_tol in the last step, or after max_steps steps
+
+  Returns the final energy (enthalpy, if the cell is relaxed)
+*/
+
+  if(prms.method=="LBFGS"){ prms.method_index = 0; }
+  else if(prms.method=="FIRE"){ prms.method_index = 1; }
+  else if(prms.method=="CG"){ prms.method_index = 2; }
+  else{
+    cout<<"Error in optimize_geometry: method = "<<prms.method<<" is not known\nExiting...\n"; exit(0);
+  }
+
+  if(prms.verbosity>0){ prms.show_info(); }
+
+  geom_objective obj(syst, mol, el, ham, prms);
+
+  int i, step;
+  int n = obj.n;
+  vector<double> x, g, x_new(n), g_new(n), d(n, 0.0);
+  double fmax;
+
+  obj.init(x);
+  double E = obj.eval(x, g, fmax);
+  double E_old = E;
+
+  prms.energies.clear();
+  prms.energies.push_back(E);
+  prms.is_converged = 0;
+
+  // L-BFGS state
+  vector< vector<double> > S, Y;
+  vector<double> rho;
+
+  // CG state
+  vector<double> g_old;
+  double cg_step = 0.0;
+
+  // FIRE state
+  vector<double> v(n, 0.0);
+  double fire_dt = prms.fire_dt_start;
+  double fire_alpha = prms.fire_alpha_start;
+  int fire_n_pos = 0;
+
+
+  for(step=0; step<prms.max_steps; step++){
+
+    //======================= L-BFGS ===========================
+    if(prms.method_index==0){
+
+      // Two-loop recursion: d = -H * g
+      int m = S.size();
+      vector<double> alpha(m, 0.0);
+      d = g;
+
+      for(int k=m-1; k>=0; k--){
+        alpha[k] = rho[k] * dot(S[k], d);
+        for(i=0; i<n; i++){ d[i] -= alpha[k] * Y[k][i]; }
+      }
+
+      double gamma = 1.0;
+      if(m>0){  gamma = dot(S[m-1], Y[m-1]) / dot(Y[m-1], Y[m-1]);  }
+      for(i=0; i<n; i++){ d[i] *= gamma; }
+
+      for(int k=0; k<m; k++){
+        double beta = rho[k] * dot(Y[k], d);
+        for(i=0; i<n; i++){ d[i] += (alpha[k] - beta) * S[k][i]; }
+      }
+      for(i=0; i<n; i++){ d[i] = -d[i]; }
+
+      // Not a descent direction: restart from the steepest descent
+      if(dot(g, d) >= 0.0){
+        S.clear(); Y.clear(); rho.clear();
+        for(i=0; i<n; i++){ d[i] = -g[i]; }
+      }
+
+      // Obey the max displacement
+      double dmax = max_abs(d);
+      double step0 = (dmax > prms.max_step) ? prms.max_step/dmax : 1.0;
+
+      int status;
+      double E_new = line_search(obj, x, d, step0, E, g, x_new, g_new, fmax, status);
+
+      if(!status){
+        // Forget the curvature information and try again with the steepest descent
+        if(S.size()==0){ obj.eval(x, g, fmax);  break; }
+        S.clear(); Y.clear(); rho.clear();
+        obj.eval(x, g, fmax);
+        continue;
+      }
+
+      vector<double> s_k(n), y_k(n);
+      for(i=0; i<n; i++){  s_k[i] = x_new[i] - x[i];  y_k[i] = g_new[i] - g[i];  }
+      double sy = dot(s_k, y_k);
+
+      if(sy > 1e-12 * sqrt(dot(s_k, s_k) * dot(y_k, y_k))){
+        S.push_back(s_k);  Y.push_back(y_k);  rho.push_back(1.0/sy);
+        if((int)S.size() > prms.lbfgs_memory){  S.erase(S.begin());  Y.erase(Y.begin());  rho.erase(rho.begin());  }
+      }
+
+      x = x_new;  g = g_new;  E_old = E;  E = E_new;
+
+    }// LBFGS
+
+    //======================= FIRE ===========================
+    else if(prms.method_index==1){
+
+      // The forces are -g; unit masses. P = 0 (e.g. at rest, on the first step) is not uphill
+      double P = 0.0;
+      for(i=0; i<n; i++){ P -= g[i] * v[i]; }
+
+      if(P >= 0.0){
+        double vn = sqrt(dot(v, v));
+        double fn = sqrt(dot(g, g));
+        if(fn > 0.0){
+          for(i=0; i<n; i++){ v[i] = (1.0 - fire_alpha) * v[i] - fire_alpha * vn * g[i] / fn; }
+        }
+
+        if(fire_n_pos > prms.fire_n_min){
+          fire_dt = fire_dt * prms.fire_f_inc;
+          if(fire_dt > prms.fire_dt_max){ fire_dt = prms.fire_dt_max; }
+          fire_alpha *= prms.fire_f_alpha;
+        }
+        fire_n_pos++;
+      }
+      else{
+        for(i=0; i<n; i++){ v[i] = 0.0; }
+        fire_dt *= prms.fire_f_dec;
+        fire_alpha = prms.fire_alpha_start;
+        fire_n_pos = 0;
+      }
+
+      // Semi-implicit Euler step
+      for(i=0; i<n; i++){  v[i] -= fire_dt * g[i];  d[i] = fire_dt * v[i];  }
+
+      double dmax = max_abs(d);
+      if(dmax > prms.max_step){ for(i=0; i<n; i++){ d[i] *= prms.max_step/dmax; } }
+
+      for(i=0; i<n; i++){ x[i] += d[i]; }
+
+      E_old = E;
+      E = obj.eval(x, g, fmax);
+
+    }// FIRE
+
+    //======================= CG ===========================
+    else if(prms.method_index==2){
+
+      // Polak-Ribiere+ direction; restart every n steps or if not a descent direction
+      double beta = 0.0;
+      if((int)g_old.size()==n && step % n != 0){
+        double num = 0.0;
+        for(i=0; i<n; i++){ num += g[i] * (g[i] - g_old[i]); }
+        beta = num / dot(g_old, g_old);
+        if(beta < 0.0){ beta = 0.0; }
+      }
+
+      for(i=0; i<n; i++){ d[i] = -g[i] + beta * d[i]; }
+      if(dot(g, d) >= 0.0){  for(i=0; i<n; i++){ d[i] = -g[i]; }  }
+
+      // The trial step: a bit longer than the last accepted one, but within max_step
+      double dmax = max_abs(d);
+      double step0 = (cg_step > 0.0) ? 2.0*cg_step : 1.0;
+      if(step0 * dmax > prms.max_step){ step0 = prms.max_step/dmax; }
+
+      int status;
+      double E_new = line_search(obj, x, d, step0, E, g, x_new, g_new, fmax, status);
+
+      if(!status){
+        obj.eval(x, g, fmax);
+        if(g_old.size()==0){ break; }
+        g_old.clear();  cg_step = 0.0;
+        continue;
+      }
+
+      cg_step = 0.0;
+      for(i=0; i<n; i++){ if(fabs(d[i]) > 0.0){ cg_step = (x_new[i] - x[i]) / d[i]; break; } }
+
+      g_old = g;
+      x = x_new;  g = g_new;  E_old = E;  E = E_new;
+
+    }// CG
+
+
+    prms.energies.push_back(E);
+
+    if(prms.verbosity>=1){
+      cout<<"step = "<<step<<" energy = "<<E<<" max force = "<<fmax<<endl;
+    }
+
+    if(fmax < prms.force_tol && fabs(E - E_old) < prms.energy_tol){
+      prms.is_converged = 1;
+      step++;
+      break;
+    }
+
+  }// for step
+
+  obj.finalize(x);
+
+  prms.n_steps = step;
+  prms.energy = E;
+  prms.max_force = fmax;
+
+  if(!prms.is_converged){
+    cout<<"WARNING: optimize_geometry did not converge in "<<step<<" steps. Max force = "<<fmax<<"\n";
+  }
+
+  return E;
+
+}
+
+
+double optimize_geometry(System& syst, Nuclear& mol, Electronic& el, Hamiltonian& ham, boost::python::dict params){
+/**
+  \brief Python-friendly version: the parameters are given as a dictionary, see the GeomOpt class
+*/
+
+  GeomOpt prms(params);
+
+  return optimize_geometry(syst, mol, el, ham, prms);
+
+}
+
+
+
+}// namespace libstate
+}// namespace libscripts
+}// liblibra
+
@@ -47,6 +47,10 @@ double compute_potential_energy(Nuclear& mol, Electronic& el, Hamiltonian& ham,
 double compute_forces(Nuclear* mol, Electronic* el, Hamiltonian* ham, int opt);
 double compute_forces(Nuclear& mol, Electronic& el, Hamiltonian& ham, int opt);
 
+int integrator_index(std::string integrator);
+double kick_fragments(vector<RigidBody*>& rb, MATRIX3x3& sc1, MATRIX3x3& sc2, double sc3, double sc4);
+double drift_fragments(vector<RigidBody*>& rb, int integr, double dt, int is_barostat, MATRIX3x3& sc1, MATRIX3x3& sc2, double& ekin_before);
+
 
 class MD{
 
@@ -92,6 +96,58 @@ public:
 
 void save(boost::property_tree::ptree& pt,std::string path,vector<MD>& vt);
 void load(boost::property_tree::ptree& pt,std::string path,vector<MD>& vt,int& status);
+
+
+class GeomOpt{
+/**
+  Parameters and the results of the geometry optimization of the System - see optimize_geometry()
+
+  Defined in Geometry_optimization.cpp
+*/
+
+public:
+
+  std::string method;    ///< "LBFGS" [default], "FIRE", or "CG" (Polak-Ribiere+ conjugate gradients)
+  int method_index;      ///< the method resolved into the index: 0 - LBFGS, 1 - FIRE, 2 - CG
+  int max_steps;         ///< the max number of the optimization steps
+  double force_tol;      ///< converged if the max atomic force norm (and the cell force) is below this value...
+  double energy_tol;     ///< ... and the energy changed by less than this value in the last step
+  double max_step;       ///< the max displacement of any coordinate in one step
+  int el_opt;            ///< the energy to minimize: 0 - Ehrenfest (mean-field), 1 - the active state [default], see compute_forces()
+  int verbosity;
+
+  // L-BFGS
+  int lbfgs_memory;      ///< the number of the stored correction pairs
+
+  // FIRE (Bitzek et al. PRL 2006, 97, 170201)
+  double fire_dt_start, fire_dt_max, fire_f_inc, fire_f_dec, fire_alpha_start, fire_f_alpha;
+  int fire_n_min;
+
+  // Cell relaxation
+  int relax_cell;          ///< 1 - optimize also the periodic cell (System::Box) under the external pressure (pure MM Hamiltonians only)
+  double target_pressure;  ///< the external pressure, in the Hamiltonian units of energy/volume
+  double cell_factor;      ///< the scaling of the cell DOFs; 0 - use the number of atoms [default]
+
+  // Results of the last optimization
+  int n_steps;               ///< the number of the steps done
+  int is_converged;
+  double energy;             ///< the final energy (enthalpy, if relax_cell = 1)
+  double max_force;          ///< the final max atomic force norm
+  vector<double> energies;   ///< the energies along the optimization
+
+
+  GeomOpt();
+  GeomOpt(boost::python::dict params);
+  GeomOpt(const GeomOpt& x){ *this = x; }
+  ~GeomOpt(){ ;; }
+
+  void set_parameters(boost::python::dict params);
+  void show_info();
+
+};
+
+double optimize_geometry(System& syst, Nuclear& mol, Electronic& el, Hamiltonian& ham, GeomOpt& prms);
+double optimize_geometry(System& syst, Nuclear& mol, Electronic& el, Hamiltonian& ham, boost::python::dict params);
 
 
 
@@ -151,6 +207,8 @@ public:
   // Defined in State_methods.cpp
   void update();
   void cool();
+  void thermalize_fragment(RigidBody& top, double dt);
+  void apply_stochastic_thermostat(double dt);
 
   // Defined in State_methods1.cpp
   void init_md(Nuclear& mol, Electronic& el, Hamiltonian& ham, Random& rnd);
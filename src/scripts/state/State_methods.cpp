@@ -240,6 +240,186 @@ void State::cool(){
 }
 
 
+void State::thermalize_fragment(RigidBody& top, double dt){
+/**
+  \brief The O step of the Langevin (BAOAB) thermostat for one rigid fragment
+  \param[in,out] top The rigid body whose momenta are updated
+  \param[in] dt The time step of the O operator
+
+  The friction and the noise act on the linear momentum and on the angular momentum in the body frame,
+  the principal inverse moments of inertia play the role of the inverse masses
+*/
+
+  VECTOR p = top.rb_p;
+  p.x = thermostat->langevin_momentum(p.x, top.rb_iM, dt);
+  p.y = thermostat->langevin_momentum(p.y, top.rb_iM, dt);
+  p.z = thermostat->langevin_momentum(p.z, top.rb_iM, dt);
+  top.set_momentum(p);
+
+  if(syst->Nf_r>0){
+    VECTOR l = top.rb_l_e;
+    l.x = thermostat->langevin_momentum(l.x, top.rb_A, dt);
+    l.y = thermostat->langevin_momentum(l.y, top.rb_B, dt);
+    l.z = thermostat->langevin_momentum(l.z, top.rb_C, dt);
+    top.set_angular_momentum(l);
+  }
+}
+
+void State::apply_stochastic_thermostat(double dt){
+/**
+  \brief Apply the CSVR or the massive Andersen thermostat to all rigid fragments of the system
+  \param[in] dt The time step of the thermostat operator
+
+  The Langevin thermostat is applied in the middle of the drift (see thermalize_fragment), so nothing
+  is done here for it, as well as for the deterministic thermostats
+
+  The resampled momenta generally violate the velocity constraints, so if the system has holonomic
+  constraints they are imposed again (RATTLE) and the thermostat acts only on the unconstrained
+  degrees of freedom, which the reduced Nf_t assumes. This projection is not a constraint force, so it
+  does not contribute to the constraint virial
+*/
+
+  int i;
+
+  if(thermostat->thermostat_kind==3){
+    double ekin = syst->ekin_tr() + syst->ekin_rot();
+    double alpha = thermostat->csvr_scale(ekin, syst->Nf_t + syst->Nf_r, dt);
+
+    for(i=0;i<syst->Number_of_fragments;i++){
+      RigidBody& top = syst->Fragments[i].Group_RB;
+      top.scale_linear_(alpha);
+      top.scale_angular_(alpha);
+    }
+  }
+
+  else if(thermostat->thermostat_kind==4){
+    if(thermostat->andersen_collision(dt)){
+      for(i=0;i<syst->Number_of_fragments;i++){
+        RigidBody& top = syst->Fragments[i].Group_RB;
+
+        VECTOR p = top.rb_p;
+        p.x = thermostat->andersen_momentum(p.x, top.rb_iM);
+        p.y = thermostat->andersen_momentum(p.y, top.rb_iM);
+        p.z = thermostat->andersen_momentum(p.z, top.rb_iM);
+        top.set_momentum(p);
+
+        if(syst->Nf_r>0){
+          VECTOR l = top.rb_l_e;
+          l.x = thermostat->andersen_momentum(l.x, top.rb_A);
+          l.y = thermostat->andersen_momentum(l.y, top.rb_B);
+          l.z = thermostat->andersen_momentum(l.z, top.rb_C);
+          top.set_angular_momentum(l);
+        }
+      }// for i
+    }
+  }
+
+  if(syst->Number_of_constraints>0 && (thermostat->thermostat_kind==3 || thermostat->thermostat_kind==4)){
+    syst->apply_velocity_constraints(dt, 0);
+  }
+
+}
+
+
+
+int integrator_index(std::string integrator){
+/**
+  \brief Convert the name of the rigid-body integrator into its index, so the MD loop does not compare the strings
+
+  0 - "Jacobi", 1 - "DLML", 2 - "Terec", 3 - "qTerec", 4 - "NO_SQUISH", 5 - "KLN", 6 - "Omelyan",
+ -1 - any other name: no rotational propagation, only the translation of the centers of mass
+*/
+
+  if(integrator=="Jacobi"){ return 0; }
+  else if(integrator=="DLML"){ return 1; }
+  else if(integrator=="Terec"){ return 2; }
+  else if(integrator=="qTerec"){ return 3; }
+  else if(integrator=="NO_SQUISH"){ return 4; }
+  else if(integrator=="KLN"){ return 5; }
+  else if(integrator=="Omelyan"){ return 6; }
+  return -1;
+}
+
+
+double kick_fragments(vector<RigidBody*>& rb, MATRIX3x3& sc1, MATRIX3x3& sc2, double sc3, double sc4){
+/**
+  \brief The A(dt/2) operator for all fragments: thermostat/barostat scaling of the momenta fused with the force/torque kicks
+  \param[in,out] rb The rigid bodies of all fragments
+  \param[in] sc1, sc2 The scaling of the linear momenta and the factor applied to the forces
+  \param[in] sc3, sc4 The scaling of the angular momenta and the factor applied to the torques
+
+  The fragments are processed in parallel. Returns the kinetic energy of all fragments after the kick
+*/
+
+  double ekin = 0.0;
+  int n = rb.size();
+
+  #pragma omp parallel for reduction(+:ekin)
+  for(int i=0;i<n;i++){
+    RigidBody& top = *rb[i];
+    //-------------------- Linear momentum propagation --------------------
+    top.scale_linear_(sc1);
+    top.apply_force(sc2);
+    //------------------- Angular momentum propagation -----------------------
+    top.scale_angular_(sc3);
+    top.apply_torque(sc4);
+    ekin += (top.ekin_rot() + top.ekin_tr());
+  }
+
+  return ekin;
+}
+
+
+double drift_fragments(vector<RigidBody*>& rb, int integr, double dt, int is_barostat, MATRIX3x3& sc1, MATRIX3x3& sc2, double& ekin_before){
+/**
+  \brief The core (drift) operator for all fragments: free rotation followed by the translation of the centers of mass
+  \param[in,out] rb The rigid bodies of all fragments
+  \param[in] integr The index of the rotational integrator (see integrator_index())
+  \param[in] dt The time step of the drift
+  \param[in] is_barostat If 1, the positions are scaled by sc1 and shifted by sc2*v, otherwise shifted by dt*v
+  \param[out] ekin_before The kinetic energy of all fragments before the drift
+
+  The fragments are processed in parallel. Returns the kinetic energy of all fragments after the rotation
+*/
+
+  double ekin_after = 0.0;
+  double ekin_b = 0.0;
+  int n = rb.size();
+
+  #pragma omp parallel for reduction(+:ekin_b,ekin_after)
+  for(int i=0;i<n;i++){
+    RigidBody& top = *rb[i];
+    double Ps = 0.0;
+
+    ekin_b += (top.ekin_rot() + top.ekin_tr());
+
+    switch(integr){
+      case 0: top.propagate_exact_rb(dt); break;
+      case 1: top.propagate_dlml(dt,Ps); break;
+      case 2: top.propagate_terec(dt); break;
+      case 3: top.propagate_qterec(dt); break;
+      case 4: top.propagate_no_squish(dt); break;
+      case 5: top.propagate_kln(dt); break;
+      case 6: top.propagate_omelyan(dt); break;
+      default: break;
+    }
+
+    ekin_after += (top.ekin_rot() + top.ekin_tr());
+
+    if(is_barostat) {
+      top.scale_position(sc1);
+      top.shift_position(sc2*top.rb_p*top.rb_iM);
+    }
+    else{
+      top.shift_position(dt*top.rb_p*top.rb_iM);
+    }
+  }
+
+  ekin_before = ekin_b;
+  return ekin_after;
+}
+
+
 
 }// namespace libstate
 }// namespace libscripts
@@ -68,6 +68,9 @@ void State::init_md(Nuclear& mol, Electronic& el, Hamiltonian& ham, Random& rnd)
   }
 
   //---------------- Initialize system --------------------
+  // Remove the initial velocity components that violate the holonomic constraints
+  if(syst->Number_of_constraints>0){ syst->apply_velocity_constraints(md->dt); }
+
   E_kin = 0.0;
   for(int i=0;i<syst->Number_of_fragments;i++){
     RigidBody& top = syst->Fragments[i].Group_RB;
@@ -117,6 +120,12 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
   double scl,sc3,sc4,ksi_r;
   MATRIX3x3 S,I,sc1,sc2;
 
+  // The integrator is resolved once; the rigid bodies of all fragments are collected in a contiguous
+  // array, so they can be propagated in parallel
+  int integr = integrator_index(md->integrator);
+  vector<RigidBody*> frag_rb(syst->Number_of_fragments);
+  for(i=0;i<syst->Number_of_fragments;i++){ frag_rb[i] = &syst->Fragments[i].Group_RB; }
+
 
   while(md->curr_step<md->max_step){
 
@@ -126,6 +135,7 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
       if(is_barostat){  ekin_baro = barostat->ekin_baro(); }
       thermostat->update_thermostat_forces(syst->ekin_tr(),syst->ekin_rot(),ekin_baro);
       thermostat->propagate_nhc(dt_half,syst->ekin_tr(),syst->ekin_rot(),ekin_baro);
+      apply_stochastic_thermostat(dt_half);
     }
 
 
@@ -174,17 +184,7 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
     sc3 = exp(-dt_half*ksi_r);
     sc4 = dt_half*exp(-0.5*dt_half*ksi_r)*sinh_(0.5*dt_half*ksi_r);
 
-
-
-    for(i=0;i<syst->Number_of_fragments;i++){
-      RigidBody& top = syst->Fragments[i].Group_RB;
-      //-------------------- Linear momentum propagation --------------------
-      top.scale_linear_(sc1);
-      top.apply_force(sc2);
-      //------------------- Angular momentum propagation -----------------------
-      top.scale_angular_(sc3);
-      top.apply_torque(sc4);       
-    }// for i
+    kick_fragments(frag_rb, sc1, sc2, sc3, sc4);
     
 
 //    if(is_thermostat){
@@ -196,38 +196,39 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
 
     //ccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
     //ccccccccccccccccccccccccccccccc Core part ccccccccccccccccccccccccccccccccccccc
+    int n_drift = 1;
+    if(is_thermostat && thermostat->thermostat_kind==2){  n_drift = 2;  }
+    double dt_drift = dt_over_s/n_drift;
+
+    // With two drifts (BAOAB), each one scales the positions by the half of the cell change
     sc1.identity();
     sc2.identity();
     sc2 = sc2 * dt;
     if(is_barostat){
-      sc1 = (barostat->pos_scale(dt));
-      sc2 = dt*barostat->vpos_scale(dt);
+      sc1 = (barostat->pos_scale(dt/n_drift));
+      sc2 = (dt/n_drift)*barostat->vpos_scale(dt/n_drift);
     }
 
-    for(i=0;i<syst->Number_of_fragments;i++){
-      RigidBody& top = syst->Fragments[i].Group_RB;
-      if(is_thermostat){  thermostat->propagate_Ps( 0.5*dt_over_s2*(top.ekin_rot()+top.ekin_tr()) ); }
-      double Ps,s_var;
-      s_var = 1.0;  if(is_thermostat){ s_var = thermostat->s_var; }
-      Ps = 0.0;
-      if(md->integrator=="Jacobi")    { top.propagate_exact_rb(dt_over_s); }
-      else if(md->integrator=="DLML")  { top.propagate_dlml(dt_over_s,Ps); }
-      else if(md->integrator=="Terec") { top.propagate_terec(dt_over_s);}
-      else if(md->integrator=="qTerec") { top.propagate_qterec(dt_over_s);}
-      else if(md->integrator=="NO_SQUISH"){ top.propagate_no_squish(dt_over_s);}
-      else if(md->integrator=="KLN")   { top.propagate_kln(dt_over_s);}
-      else if(md->integrator=="Omelyan"){ top.propagate_omelyan(dt_over_s);}
-
-      if(is_thermostat){  thermostat->propagate_Ps( 0.5*dt_over_s2*(top.ekin_rot()+top.ekin_tr()) ); } 
-      if(is_barostat) {  
-        top.scale_position(sc1); 
-        top.shift_position(sc2*top.rb_p*top.rb_iM);
+    syst->save_constraint_reference();
+
+    for(int drift=0;drift<n_drift;drift++){
+      // Langevin thermostat (BAOAB): the O step acts between the two halves of the drift.
+      // It draws from the single random number stream of the thermostat, so it is done serially
+      if(drift>0){
+        for(i=0;i<syst->Number_of_fragments;i++){  thermalize_fragment(*frag_rb[i], dt);  }
+      }
+
+      double ekin_before, ekin_after;
+      ekin_after = drift_fragments(frag_rb, integr, dt_drift, is_barostat, sc1, sc2, ekin_before);
+
+      if(is_thermostat){
+        if(drift==0){  thermostat->propagate_Ps( 0.5*dt_over_s2*ekin_before );  }
+        thermostat->propagate_Ps( 0.5*dt_over_s2*ekin_after );
       }
-      else{
-        top.shift_position(dt_over_s*top.rb_p*top.rb_iM);
-      }        
+    }// for drift
 
-    }// for i - all fragments
+    // SHAKE/SETTLE/LINCS: restore the constrained bond lengths after the drift
+    syst->apply_position_constraints(dt_over_s);
 
     if(is_thermostat){  thermostat->propagate_Ps(dt*( H0 - Nf*boltzmann*thermostat->Temperature*(log(thermostat->s_var)+1.0) ) ); }
 
@@ -277,7 +278,7 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
     }
 
     // Update atomic positions and calculate interactions
-    for(i=0;i<syst->Number_of_fragments;i++){ syst->update_atoms_for_fragment(i);  }
+    syst->update_atoms_for_fragments();
     syst->zero_forces_and_torques();
 
 //!!!!!!!!!!!!!!!!1    E_pot = system->energy(); !!!!!!!!!!!!!!!!1
@@ -311,17 +312,13 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
     sc3 = exp(-dt_half*ksi_r);
     sc4 = dt_half*exp(-0.5*dt_half*ksi_r)*sinh_(0.5*dt_half*ksi_r);
 
+    E_kin = kick_fragments(frag_rb, sc1, sc2, sc3, sc4);
 
-    for(i=0;i<syst->Number_of_fragments;i++){
-      RigidBody& top = syst->Fragments[i].Group_RB;
-      //-------------------- Linear momentum propagation --------------------
-      top.scale_linear_(sc1);
-      top.apply_force(sc2);
-      //------------------- Angular momentum propagation -----------------------
-      top.scale_angular_(sc3);
-      top.apply_torque(sc4);
-      E_kin += (top.ekin_rot() + top.ekin_tr());
-    }// for i
+    // RATTLE: remove the momenta components along the constrained bonds
+    if(syst->Number_of_constraints>0){
+      syst->apply_velocity_constraints(dt);
+      E_kin = syst->ekin_tr() + syst->ekin_rot();
+    }
 
     //aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa
 
@@ -354,6 +351,8 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
       if(is_barostat){  ekin_baro = barostat->ekin_baro(); }
       thermostat->update_thermostat_forces(syst->ekin_tr(),syst->ekin_rot(),ekin_baro);
       thermostat->propagate_nhc(dt_half,syst->ekin_tr(),syst->ekin_rot(),ekin_baro);
+      apply_stochastic_thermostat(dt_half);
+      if(thermostat->is_stochastic()){  E_kin = syst->ekin_tr() + syst->ekin_rot();  }
     }
 
 
@@ -369,8 +368,8 @@ void State::run_md(Nuclear& mol, Electronic& el, Hamiltonian& ham){
     else if(md->ensemble=="NVT"){
       if(is_thermostat){
         if(!is_H0){ H0 = E_tot + thermostat->energy(); is_H0 = 1;}
-        if(thermostat->thermostat_type=="Nose-Poincare"){    H_NP = thermostat->s_var*(E_tot + thermostat->energy() - H0);   }
-        else if(thermostat->thermostat_type=="Nose-Hoover"){ H_NP = E_tot + thermostat->energy();    }
+        if(thermostat->thermostat_kind==0){    H_NP = thermostat->s_var*(E_tot + thermostat->energy() - H0);   }
+        else if(thermostat->thermostat_kind>=1){ H_NP = E_tot + thermostat->energy();    }
       }
     }
     else if(md->ensemble=="NPH"||md->ensemble=="NPH_FLEX"){
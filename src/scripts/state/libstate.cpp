@@ -85,6 +85,45 @@ void export_state_objects(){
       .def("run_md",expt_run_md_v2)
 //      .def("run_md_respa",&State::run_md_respa)
   ;
+
+  class_<GeomOpt>("GeomOpt",init<>())
+      .def(init<boost::python::dict>())
+      .def(init<const GeomOpt&>())
+      .def_readwrite("method",&GeomOpt::method)
+      .def_readwrite("max_steps",&GeomOpt::max_steps)
+      .def_readwrite("force_tol",&GeomOpt::force_tol)
+      .def_readwrite("energy_tol",&GeomOpt::energy_tol)
+      .def_readwrite("max_step",&GeomOpt::max_step)
+      .def_readwrite("el_opt",&GeomOpt::el_opt)
+      .def_readwrite("verbosity",&GeomOpt::verbosity)
+      .def_readwrite("lbfgs_memory",&GeomOpt::lbfgs_memory)
+      .def_readwrite("fire_dt_start",&GeomOpt::fire_dt_start)
+      .def_readwrite("fire_dt_max",&GeomOpt::fire_dt_max)
+      .def_readwrite("fire_f_inc",&GeomOpt::fire_f_inc)
+      .def_readwrite("fire_f_dec",&GeomOpt::fire_f_dec)
+      .def_readwrite("fire_alpha_start",&GeomOpt::fire_alpha_start)
+      .def_readwrite("fire_f_alpha",&GeomOpt::fire_f_alpha)
+      .def_readwrite("fire_n_min",&GeomOpt::fire_n_min)
+      .def_readwrite("relax_cell",&GeomOpt::relax_cell)
+      .def_readwrite("target_pressure",&GeomOpt::target_pressure)
+      .def_readwrite("cell_factor",&GeomOpt::cell_factor)
+      .def_readwrite("n_steps",&GeomOpt::n_steps)
+      .def_readwrite("is_converged",&GeomOpt::is_converged)
+      .def_readwrite("energy",&GeomOpt::energy)
+      .def_readwrite("max_force",&GeomOpt::max_force)
+      .def_readwrite("energies",&GeomOpt::energies)
+
+      .def("set_parameters",&GeomOpt::set_parameters)
+      .def("show_info",&GeomOpt::show_info)
+  ;
+
+  double (*expt_optimize_geometry_v1)
+  (System& syst, Nuclear& mol, Electronic& el, Hamiltonian& ham, GeomOpt& prms) = &optimize_geometry;
+  double (*expt_optimize_geometry_v2)
+  (System& syst, Nuclear& mol, Electronic& el, Hamiltonian& ham, boost::python::dict params) = &optimize_geometry;
+
+  def("optimize_geometry", expt_optimize_geometry_v1);
+  def("optimize_geometry", expt_optimize_geometry_v2);
 
 
 
@@ -0,0 +1,566 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 2 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+ \file Qeq_solver.cpp
+ \brief The file implements the Qeq_solver class - the iterative charge equilibration (QEq) solver
+
+*/
+
+#include "Qeq_solver.h"
+#include <algorithm>
+
+
+/// liblibra namespace
+namespace liblibra{
+
+
+/// libsolvers namespace
+namespace libsolvers{
+
+
+
+double Qeq_taper(double r, double R_off){
+/**
+  The 7-th order taper function that switches the interactions off smoothly:
+  Tap(0) = 1, Tap(R_off) = 0 and the first 3 derivatives vanish at both ends
+
+  \param[in] r The distance
+  \param[in] R_off The cutoff distance
+*/
+  if(r>=R_off){ return 0.0; }
+
+  double x = r/R_off;
+  double x2 = x*x;
+  double x4 = x2*x2;
+
+  return  x4*(x*(x*(20.0*x - 70.0) + 84.0) - 35.0) + 1.0;
+}
+
+
+double Qeq_shielded_coulomb(double r, double gamma_ij){
+/**
+  The shielded Coulomb kernel: 1/(r^3 + gamma_ij^-3)^(1/3)
+  It is finite at r = 0 and goes to 1/r at large distances
+
+  \param[in] r The distance [Bohr]
+  \param[in] gamma_ij The shielding parameter of the pair [Bohr^-1]
+*/
+  double g3 = gamma_ij*gamma_ij*gamma_ij;
+
+  return 1.0/cbrt(r*r*r + 1.0/g3);
+}
+
+
+
+Qeq_solver::Qeq_solver(vector<double>& chi_, vector<double>& J_, vector<double>& gamma_, double R_off_){
+/**
+  The constructor of the QEq solver
+
+  \param[in] chi_ Electronegativities of all atoms [Ha]
+  \param[in] J_ Hardnesses of all atoms [Ha]
+  \param[in] gamma_ Shielding parameters of all atoms [Bohr^-1]
+  \param[in] R_off_ The cutoff distance of the real-space interactions [Bohr]
+*/
+
+  natoms = chi_.size();
+
+  if((int)J_.size()!=natoms || (int)gamma_.size()!=natoms){
+    cout<<"Error in Qeq_solver: the sizes of the chi, J, and gamma arrays should be equal\n";
+    cout<<"chi.size() = "<<chi_.size()<<" J.size() = "<<J_.size()<<" gamma.size() = "<<gamma_.size()<<endl;
+    cout<<"Exiting...\n"; exit(0);
+  }
+
+  chi = chi_;
+  J = J_;
+  gamma = gamma_;
+
+  R_off = R_off_;
+  threshold = 1e-6;
+  MaxCount = 500;
+
+  is_periodic = 0;
+  box.identity();
+  etha = 1.0;
+  rec_deg = 0;
+
+  n_iter_s = 0;
+  n_iter_t = 0;
+  mu = 0.0;
+
+}// Qeq_solver::Qeq_solver
+
+
+
+void Qeq_solver::set_pbc(MATRIX3x3& box_, double etha_, int rec_deg_){
+/**
+  Turn on the periodic boundary conditions with the Ewald summation
+
+  \param[in] box_ The periodic cell in the format: (tv1, tv2, tv3) [Bohr]
+  \param[in] etha_ The width of the Ewald screening Gaussians [Bohr]. The real-space part
+  should be converged within R_off, e.g. R_off ~ 3.5 * etha
+  \param[in] rec_deg_ The range of the reciprocal-space summation
+*/
+
+  is_periodic = 1;
+  box = box_;
+  etha = etha_;
+  rec_deg = rec_deg_;
+
+}
+
+
+void Qeq_solver::reset_guess(){
+/**
+  Forget the solutions of the previous call, so the next call starts from the zero guess
+*/
+  s_prev.clear();
+  t_prev.clear();
+}
+
+
+
+void Qeq_solver::build_real_space(vector<VECTOR>& R){
+/**
+  Construct the sparse real-space part of the hardness matrix using the cell lists,
+  so the cost is linear in the number of atoms. In the periodic case, all images
+  within R_off are included (also for boxes smaller than R_off)
+
+  \param[in] R Coordinates of all atoms [Bohr]
+*/
+
+  int i, a;
+  int nb[3], m[3];
+  double s_i[3];
+  VECTOR t[3];
+
+  vector<VECTOR> r(natoms);   // the wrapped coordinates
+  vector<int> bin_of(3*natoms);
+
+  MATRIX3x3 invBox;
+  VECTOR rmin, rmax;
+
+  if(is_periodic){
+    invBox = box.inverse();
+    box.get_vectors(t[0], t[1], t[2]);
+
+    VECTOR g[3];
+    invBox.T().get_vectors(g[0], g[1], g[2]);
+
+    for(a=0;a<3;a++){
+      // The cell is split into nb[a] bins along direction a, each not thinner than R_off
+      nb[a] = std::max(1, int(floor(1.0/(R_off*g[a].length()))));
+      m[a] = int(ceil(R_off*g[a].length()*nb[a]));
+    }
+
+    for(i=0;i<natoms;i++){
+      VECTOR f = invBox * R[i];
+      f.x -= floor(f.x);  f.y -= floor(f.y);  f.z -= floor(f.z);
+      r[i] = box * f;
+
+      s_i[0] = f.x; s_i[1] = f.y; s_i[2] = f.z;
+      for(a=0;a<3;a++){  bin_of[3*i+a] = std::min(nb[a]-1, int(s_i[a]*nb[a]));  }
+    }
+  }
+  else{
+    rmin = R[0]; rmax = R[0];
+    for(i=1;i<natoms;i++){
+      rmin.x = std::min(rmin.x, R[i].x);  rmax.x = std::max(rmax.x, R[i].x);
+      rmin.y = std::min(rmin.y, R[i].y);  rmax.y = std::max(rmax.y, R[i].y);
+      rmin.z = std::min(rmin.z, R[i].z);  rmax.z = std::max(rmax.z, R[i].z);
+    }
+    double L[3] = {rmax.x - rmin.x, rmax.y - rmin.y, rmax.z - rmin.z};
+
+    for(a=0;a<3;a++){
+      nb[a] = std::max(1, int(floor(L[a]/R_off)));
+      m[a] = 1;
+    }
+
+    for(i=0;i<natoms;i++){
+      r[i] = R[i];
+
+      s_i[0] = R[i].x - rmin.x; s_i[1] = R[i].y - rmin.y; s_i[2] = R[i].z - rmin.z;
+      for(a=0;a<3;a++){
+        if(L[a]>0.0){  bin_of[3*i+a] = std::min(nb[a]-1, int(s_i[a]*nb[a]/L[a]));  }
+        else{ bin_of[3*i+a] = 0; }
+      }
+    }
+  }// non-periodic
+
+
+  // Distribute atoms over the bins
+  int nbins = nb[0]*nb[1]*nb[2];
+  vector< vector<int> > bins(nbins);
+  for(i=0;i<natoms;i++){
+    bins[ (bin_of[3*i]*nb[1] + bin_of[3*i+1])*nb[2] + bin_of[3*i+2] ].push_back(i);
+  }
+
+  double self_ewald = (is_periodic ? -2.0/(sqrt(M_PI)*etha) : 0.0);
+
+  // Compute the rows of the matrix
+  vector< vector< pair<int,double> > > rows(natoms);
+
+  #pragma omp parallel for schedule(dynamic,64)
+  for(int i1=0;i1<natoms;i1++){
+
+    vector< pair<int,double> >& row = rows[i1];
+    row.push_back(pair<int,double>(i1, J[i1] + self_ewald));
+
+    int c[3], n[3], cw[3];
+
+    for(int d0=-m[0];d0<=m[0];d0++){
+      c[0] = bin_of[3*i1] + d0;
+
+      for(int d1=-m[1];d1<=m[1];d1++){
+        c[1] = bin_of[3*i1+1] + d1;
+
+        for(int d2=-m[2];d2<=m[2];d2++){
+          c[2] = bin_of[3*i1+2] + d2;
+
+          // Map the bin index into the box and find the corresponding image
+          int is_outside = 0;
+          for(int a1=0;a1<3;a1++){
+            n[a1] = int(floor(double(c[a1])/double(nb[a1])));
+            cw[a1] = c[a1] - n[a1]*nb[a1];
+            if(!is_periodic && n[a1]!=0){ is_outside = 1; }
+          }
+          if(is_outside){ continue; }
+
+          VECTOR T(0.0, 0.0, 0.0);
+          if(is_periodic){ T = n[0]*t[0] + n[1]*t[1] + n[2]*t[2]; }
+
+          vector<int>& bin = bins[ (cw[0]*nb[1] + cw[1])*nb[2] + cw[2] ];
+
+          for(int k=0;k<(int)bin.size();k++){
+            int j = bin[k];
+            if(j==i1 && n[0]==0 && n[1]==0 && n[2]==0){ continue; }
+
+            VECTOR dr = r[j] + T - r[i1];
+            double dist = dr.length();
+            if(dist>=R_off){ continue; }
+
+            double g_ij = sqrt(gamma[i1]*gamma[j]);
+            double val = 0.0;
+
+            if(is_periodic){
+              val = erfc(dist/etha)/dist + Qeq_taper(dist, R_off) * (Qeq_shielded_coulomb(dist, g_ij) - 1.0/dist);
+            }
+            else{
+              val = Qeq_taper(dist, R_off) * Qeq_shielded_coulomb(dist, g_ij);
+            }
+
+            row.push_back(pair<int,double>(j, val));
+
+          }// for k
+        }// for d2
+      }// for d1
+    }// for d0
+
+    // Several images of the same atom may contribute to the same matrix element - merge them
+    std::sort(row.begin(), row.end());
+    int last = 0;
+    for(int k=1;k<(int)row.size();k++){
+      if(row[k].first==row[last].first){ row[last].second += row[k].second; }
+      else{ last++; row[last] = row[k]; }
+    }
+    row.resize(last+1);
+
+  }// for i1
+
+
+  // Pack into the CSR format
+  row_ptr = vector<int>(natoms+1, 0);
+  for(i=0;i<natoms;i++){  row_ptr[i+1] = row_ptr[i] + rows[i].size();  }
+
+  col_indx = vector<int>(row_ptr[natoms], 0);
+  H_val = vector<double>(row_ptr[natoms], 0.0);
+  H_diag = vector<double>(natoms, 0.0);
+
+  for(i=0;i<natoms;i++){
+    for(int k=0;k<(int)rows[i].size();k++){
+      col_indx[row_ptr[i]+k] = rows[i][k].first;
+      H_val[row_ptr[i]+k] = rows[i][k].second;
+      if(rows[i][k].first==i){ H_diag[i] = rows[i][k].second; }
+    }
+  }
+
+}// build_real_space
+
+
+void Qeq_solver::build_reciprocal_space(vector<VECTOR>& R){
+/**
+  Precompute the structure factor tables of the reciprocal-space part of the Ewald sum.
+  Only a half of the k-space is stored, so the prefactors include the factor of 2
+
+  Note: this is the plain Ewald k-space sum, not PME - its cost is O(N*nk) per
+  matrix-vector product, with nk the number of k-vectors within rec_deg
+
+  \param[in] R Coordinates of all atoms [Bohr]
+*/
+
+  rec_pref.clear();
+  cos_kr.clear();
+  sin_kr.clear();
+
+  if(!is_periodic){ return; }
+
+  VECTOR tv1,tv2,tv3, t;
+  VECTOR h1,h2,h3;
+
+  box.get_vectors(tv1,tv2,tv3);
+  t.cross(tv2,tv3);    h1 = 2.0*M_PI*t/(tv1*t);
+  t.cross(tv3,tv1);    h2 = 2.0*M_PI*t/(tv2*t);
+  t.cross(tv1,tv2);    h3 = 2.0*M_PI*t/(tv3*t);
+
+  double omega = fabs(box.Determinant());
+  vector<VECTOR> kvec;
+
+  for(int n1=0;n1<=rec_deg;n1++){
+    for(int n2=-rec_deg;n2<=rec_deg;n2++){
+      for(int n3=-rec_deg;n3<=rec_deg;n3++){
+
+        // Half-space: k and -k give identical contributions
+        if(n1==0 && (n2<0 || (n2==0 && n3<=0))){ continue; }
+
+        VECTOR k = n1*h1 + n2*h2 + n3*h3;
+        double k2 = k.length2();
+
+        kvec.push_back(k);
+        rec_pref.push_back( (8.0*M_PI/omega) * exp(-0.25*k2*etha*etha) / k2 );
+      }
+    }
+  }
+
+  int nk = kvec.size();
+  cos_kr = vector<double>(natoms*nk, 0.0);
+  sin_kr = vector<double>(natoms*nk, 0.0);
+
+  #pragma omp parallel for
+  for(int i=0;i<natoms;i++){
+    for(int k=0;k<nk;k++){
+      double kr = kvec[k] * R[i];
+      cos_kr[i*nk+k] = cos(kr);
+      sin_kr[i*nk+k] = sin(kr);
+    }
+  }
+
+}// build_reciprocal_space
+
+
+
+void Qeq_solver::update_hardness(vector<VECTOR>& R){
+/**
+  Recompute and cache the hardness matrix for the new coordinates. This should be
+  called once per MD step, before the solve() function
+
+  \param[in] R Coordinates of all atoms [Bohr]
+*/
+
+  if((int)R.size()!=natoms){
+    cout<<"Error in Qeq_solver::update_hardness: R.size() = "<<R.size()<<" is not equal to natoms = "<<natoms<<endl;
+    cout<<"Exiting...\n"; exit(0);
+  }
+
+  build_real_space(R);
+  build_reciprocal_space(R);
+
+}
+
+
+
+void Qeq_solver::hardness_product(vector<double>& x, vector<double>& y){
+/**
+  Compute the product y = H * x without forming the full matrix
+
+  \param[in] x The input vector (natoms)
+  \param[out] y The result (natoms)
+*/
+
+  if((int)y.size()!=natoms){ y = vector<double>(natoms, 0.0); }
+
+  #pragma omp parallel for
+  for(int i=0;i<natoms;i++){
+    double sum = 0.0;
+    for(int k=row_ptr[i];k<row_ptr[i+1];k++){  sum += H_val[k] * x[col_indx[k]];  }
+    y[i] = sum;
+  }
+
+  int nk = rec_pref.size();
+  if(nk==0){ return; }
+
+  // Structure factors
+  vector<double> S_c(nk, 0.0);
+  vector<double> S_s(nk, 0.0);
+
+  #pragma omp parallel for
+  for(int k=0;k<nk;k++){
+    double sc = 0.0, ss = 0.0;
+    for(int j=0;j<natoms;j++){
+      sc += x[j] * cos_kr[j*nk+k];
+      ss += x[j] * sin_kr[j*nk+k];
+    }
+    S_c[k] = rec_pref[k] * sc;
+    S_s[k] = rec_pref[k] * ss;
+  }
+
+  #pragma omp parallel for
+  for(int i=0;i<natoms;i++){
+    double sum = 0.0;
+    for(int k=0;k<nk;k++){  sum += cos_kr[i*nk+k] * S_c[k] + sin_kr[i*nk+k] * S_s[k];  }
+    y[i] += sum;
+  }
+
+}
+
+
+MATRIX Qeq_solver::get_hardness(){
+/**
+  Return the full (dense) hardness matrix. This is meant for testing and analysis only
+*/
+
+  MATRIX res(natoms, natoms);
+  vector<double> x(natoms, 0.0);
+  vector<double> y(natoms, 0.0);
+
+  for(int j=0;j<natoms;j++){
+    x[j] = 1.0;
+    hardness_product(x, y);
+    for(int i=0;i<natoms;i++){ res.set(i, j, y[i]); }
+    x[j] = 0.0;
+  }
+
+  return res;
+}
+
+
+
+int Qeq_solver::pcg(vector<double>& b, vector<double>& x){
+/**
+  Solve H x = b with the Jacobi-preconditioned conjugate gradients method
+
+  \param[in] b The right-hand side
+  \param[in,out] x On input - the initial guess, on output - the solution
+
+  Returns the number of iterations used
+*/
+
+  int i, iter;
+  vector<double> r(natoms, 0.0);
+  vector<double> z(natoms, 0.0);
+  vector<double> p(natoms, 0.0);
+  vector<double> Hp(natoms, 0.0);
+
+  double b_norm = 0.0;
+  for(i=0;i<natoms;i++){ b_norm += b[i]*b[i]; }
+  b_norm = sqrt(b_norm);
+  if(b_norm==0.0){ x = vector<double>(natoms, 0.0); return 0; }
+
+  hardness_product(x, Hp);
+
+  double rz = 0.0, r_norm = 0.0;
+  for(i=0;i<natoms;i++){
+    r[i] = b[i] - Hp[i];
+    z[i] = r[i]/H_diag[i];
+    p[i] = z[i];
+    rz += r[i]*z[i];
+    r_norm += r[i]*r[i];
+  }
+
+  iter = 0;
+  while(sqrt(r_norm) > threshold*b_norm && iter<MaxCount){
+
+    hardness_product(p, Hp);
+
+    double pHp = 0.0;
+    for(i=0;i<natoms;i++){ pHp += p[i]*Hp[i]; }
+    double alp = rz/pHp;
+
+    double rz_new = 0.0;  r_norm = 0.0;
+    for(i=0;i<natoms;i++){
+      x[i] += alp * p[i];
+      r[i] -= alp * Hp[i];
+      z[i] = r[i]/H_diag[i];
+      rz_new += r[i]*z[i];
+      r_norm += r[i]*r[i];
+    }
+
+    double bet = rz_new/rz;
+    rz = rz_new;
+    for(i=0;i<natoms;i++){ p[i] = z[i] + bet * p[i]; }
+
+    iter++;
+  }// while
+
+  return iter;
+}
+
+
+
+vector<double> Qeq_solver::solve(double Q_tot){
+/**
+  Find the charges that minimize the QEq energy under the total charge constraint.
+  The hardness matrix should be already computed by the update_hardness() function
+
+  \param[in] Q_tot The total charge of the system
+
+  Returns the equilibrated charges
+*/
+
+  int i;
+
+  if((int)row_ptr.size()!=natoms+1){
+    cout<<"Error in Qeq_solver::solve: the hardness matrix is not computed - call update_hardness() first\n";
+    cout<<"Exiting...\n"; exit(0);
+  }
+
+  if((int)s_prev.size()!=natoms){ s_prev = vector<double>(natoms, 0.0); }
+  if((int)t_prev.size()!=natoms){ t_prev = vector<double>(natoms, 0.0); }
+
+  vector<double> b_s(natoms, 0.0);
+  vector<double> b_t(natoms, 1.0);
+  for(i=0;i<natoms;i++){ b_s[i] = -chi[i]; }
+
+  n_iter_s = pcg(b_s, s_prev);
+  n_iter_t = pcg(b_t, t_prev);
+
+  double sum_s = 0.0, sum_t = 0.0;
+  for(i=0;i<natoms;i++){ sum_s += s_prev[i]; sum_t += t_prev[i]; }
+
+  mu = (Q_tot - sum_s)/sum_t;
+
+  vector<double> q(natoms, 0.0);
+  for(i=0;i<natoms;i++){ q[i] = s_prev[i] + mu * t_prev[i]; }
+
+  return q;
+
+}
+
+
+double Qeq_solver::energy(vector<double>& q){
+/**
+  Compute the QEq energy for given charges: E = chi * q + 1/2 * q * H * q
+
+  \param[in] q The atomic charges
+*/
+
+  vector<double> Hq(natoms, 0.0);
+  hardness_product(q, Hq);
+
+  double res = 0.0;
+  for(int i=0;i<natoms;i++){ res += q[i] * (chi[i] + 0.5*Hq[i]); }
+
+  return res;
+}
+
+
+
+}// namespace libsolvers
+}// namespace liblibra
+
@@ -0,0 +1,123 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 2 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+ \file Qeq_solver.h
+ \brief The file describes the Qeq_solver class - the iterative charge equilibration (QEq) solver
+
+*/
+
+
+#ifndef QEQ_SOLVER_H
+#define QEQ_SOLVER_H
+
+#include <boost/python.hpp>
+#include <boost/python/suite/indexing/vector_indexing_suite.hpp>
+#include "../math_linalg/liblinalg.h"
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace boost::python;
+using namespace liblinalg;
+
+
+/// libsolvers namespace
+namespace libsolvers{
+
+
+class Qeq_solver{
+/**
+  This is the class that solves the electronegativity equalization problem:
+
+  E(q) = sum_i { chi_i * q_i }  + 1/2 * sum_{i,j} { q_i * H_ij * q_j },   sum_i q_i = Q_tot
+
+  H_ii = J_i (atomic hardness), H_ij - shielded Coulomb kernel, truncated at R_off with the
+  7-th order taper. In the periodic case, the long-range part is handled by the Ewald summation:
+  the real-space (erfc-screened) part is kept in the sparse matrix, the reciprocal-space part
+  is applied on the fly in the matrix-vector products.
+
+  The constrained problem is reduced to two linear systems H s = -chi and H t = 1, which
+  are solved with the Jacobi-preconditioned conjugate gradients. The solutions of the previous
+  call are used as the initial guesses, so in MD only a few iterations are needed per step.
+
+  The solver is standalone - it is not called by the force fields or the MD drivers, the caller
+  sets the returned charges itself. The reciprocal-space part is the plain Ewald k-space sum
+  (not PME), so every matrix-vector product costs O(N*nk), nk - the number of the k-vectors.
+
+  All quantities are in atomic units: coordinates in Bohr, chi and J in Ha, gamma in Bohr^-1
+*/
+
+  // Sparse (CSR) storage of the hardness matrix
+  vector<int> row_ptr;           ///< row_ptr[i] - the index of the first element of row i in col_indx and H_val
+  vector<int> col_indx;          ///< column indices of the stored elements
+  vector<double> H_val;          ///< values of the stored elements
+  vector<double> H_diag;         ///< the diagonal of H, used as the preconditioner
+
+  // Reciprocal space data (periodic case only)
+  vector<double> rec_pref;       ///< prefactors of all k-vectors in the half-space
+  vector<double> cos_kr;         ///< cos(k*r_i), natoms x nk
+  vector<double> sin_kr;         ///< sin(k*r_i), natoms x nk
+
+  // Warm-start guesses
+  vector<double> s_prev;         ///< the solution of H s = -chi from the previous call
+  vector<double> t_prev;         ///< the solution of H t = 1 from the previous call
+
+  void build_real_space(vector<VECTOR>& R);
+  void build_reciprocal_space(vector<VECTOR>& R);
+  int pcg(vector<double>& b, vector<double>& x);
+
+
+public:
+
+  // Parameters
+  int natoms;                    ///< the number of atoms
+  vector<double> chi;            ///< electronegativities of all atoms
+  vector<double> J;              ///< hardnesses (idempotentials) of all atoms
+  vector<double> gamma;          ///< shielding parameters of all atoms
+
+  double R_off;                  ///< the cutoff of the real-space interactions
+  double threshold;              ///< convergence criterion: the relative norm of the residual
+  int MaxCount;                  ///< maximal number of CG iterations
+
+  int is_periodic;               ///< flag to use periodic boundary conditions
+  MATRIX3x3 box;                 ///< the periodic cell in the format: (tv1, tv2, tv3)
+  double etha;                   ///< the width of the Ewald screening Gaussians, etha = 1/alpha
+  int rec_deg;                   ///< the range of the reciprocal-space summation
+
+  // Diagnostics
+  int n_iter_s;                  ///< the number of the CG iterations used in the last call for s
+  int n_iter_t;                  ///< the number of the CG iterations used in the last call for t
+  double mu;                     ///< the electronic chemical potential found in the last call
+
+
+  Qeq_solver(vector<double>& chi_, vector<double>& J_, vector<double>& gamma_, double R_off_);  ///< Constructor
+
+  void set_pbc(MATRIX3x3& box_, double etha_, int rec_deg_);
+
+  void update_hardness(vector<VECTOR>& R);
+  void hardness_product(vector<double>& x, vector<double>& y);
+  MATRIX get_hardness();
+
+  vector<double> solve(double Q_tot);
+  double energy(vector<double>& q);
+  void reset_guess();
+
+};
+
+
+double Qeq_taper(double r, double R_off);
+double Qeq_shielded_coulomb(double r, double gamma_ij);
+
+
+}// libsolvers namespace
+}// liblibra
+
+#endif // QEQ_SOLVER_H
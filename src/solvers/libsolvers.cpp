@@ -59,6 +59,40 @@ void export_solvers_objects(){
   ;
 
 
+  //----------------- Qeq_solver.cpp ------------------------------
+
+  def("Qeq_taper", &Qeq_taper);
+  def("Qeq_shielded_coulomb", &Qeq_shielded_coulomb);
+
+  class_<Qeq_solver>("Qeq_solver",init<vector<double>&, vector<double>&, vector<double>&, double>())
+      .def("__copy__", &generic__copy__<Qeq_solver>)
+      .def("__deepcopy__", &generic__deepcopy__<Qeq_solver>)
+
+      .def("set_pbc", &Qeq_solver::set_pbc)
+      .def("update_hardness", &Qeq_solver::update_hardness)
+      .def("hardness_product", &Qeq_solver::hardness_product)
+      .def("get_hardness", &Qeq_solver::get_hardness)
+      .def("solve", &Qeq_solver::solve)
+      .def("energy", &Qeq_solver::energy)
+      .def("reset_guess", &Qeq_solver::reset_guess)
+
+      .def_readonly("natoms",&Qeq_solver::natoms)
+      .def_readwrite("chi",&Qeq_solver::chi)
+      .def_readwrite("J",&Qeq_solver::J)
+      .def_readwrite("gamma",&Qeq_solver::gamma)
+      .def_readwrite("R_off",&Qeq_solver::R_off)
+      .def_readwrite("threshold",&Qeq_solver::threshold)
+      .def_readwrite("MaxCount",&Qeq_solver::MaxCount)
+      .def_readwrite("is_periodic",&Qeq_solver::is_periodic)
+      .def_readwrite("box",&Qeq_solver::box)
+      .def_readwrite("etha",&Qeq_solver::etha)
+      .def_readwrite("rec_deg",&Qeq_solver::rec_deg)
+      .def_readonly("n_iter_s",&Qeq_solver::n_iter_s)
+      .def_readonly("n_iter_t",&Qeq_solver::n_iter_t)
+      .def_readonly("mu",&Qeq_solver::mu)
+  ;
+
+
 }// export_solvers_objects()
 
 
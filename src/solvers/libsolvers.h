@@ -19,6 +19,7 @@
 #define LIB_SOLVERS_H
 
 #include "DIIS.h"
+#include "Qeq_solver.h"
 
 /// liblibra namespace
 namespace liblibra{
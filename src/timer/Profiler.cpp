@@ -0,0 +1,218 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Profiler.cpp
+  \brief Implementation of the hierarchical wall-clock profiler
+
+*/
+
+#include "Profiler.h"
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <stdlib.h>
+
+
+/// liblibra namespace
+namespace liblibra{
+
+
+namespace{
+
+std::atomic<int> profiler_state(0);
+
+/// All the per-thread profiles ever created. They are owned here (not by the
+/// threads), so the data of the threads that have finished is not lost.
+std::mutex registry_mutex;
+vector< std::unique_ptr<ThreadProfile> > registry;
+
+thread_local ThreadProfile* this_thread_profile = NULL;
+
+
+ThreadProfile* get_thread_profile(){
+
+  if(this_thread_profile==NULL){
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back( std::unique_ptr<ThreadProfile>(new ThreadProfile(registry.size())) );
+    this_thread_profile = registry.back().get();
+  }
+  return this_thread_profile;
+}
+
+}// anonymous namespace
+
+
+
+void profiler_enable(){   profiler_state.store(1);  }
+
+void profiler_disable(){  profiler_state.store(0);  }
+
+int is_profiler_enabled(){  return profiler_state.load(std::memory_order_relaxed);  }
+
+
+void profiler_reset(){
+/**
+  Clear the accumulated timings of all threads. Must not be called while any
+  scope is open in another thread.
+*/
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+
+  for(int i=0;i<registry.size();i++){
+    registry[i]->nodes.clear();
+  }
+}
+
+
+void profiler_begin(std::string name){
+
+  ThreadProfile* tp = get_thread_profile();
+
+  if(tp->stack_path.size()==0){  tp->stack_path.push_back(name);  }
+  else{  tp->stack_path.push_back(tp->stack_path.back() + "/" + name);  }
+
+  tp->stack_children.push_back(0.0);
+  tp->stack_start.push_back(wall_time());
+
+}
+
+
+void profiler_end(){
+
+  double t = wall_time();
+  ThreadProfile* tp = get_thread_profile();
+
+  if(tp->stack_path.size()==0){
+    cout<<"Error in profiler_end: no open profiling scope in this thread\nExiting...\n";
+    exit(0);
+  }
+
+  double dt = t - tp->stack_start.back();
+
+  ProfileNode& node = tp->nodes[tp->stack_path.back()];
+  node.count++;
+  node.inclusive += dt;
+  node.children += tp->stack_children.back();
+
+  tp->stack_path.pop_back();
+  tp->stack_start.pop_back();
+  tp->stack_children.pop_back();
+
+  if(tp->stack_children.size()>0){  tp->stack_children.back() += dt;  }
+
+}
+
+
+vector<ProfileEntry> profiler_summary(){
+/**
+  Combine the timings of all threads. The entries are sorted by path, so the
+  children follow their parents.
+
+  Note: the scopes opened by the worker threads of a parallel region start
+  their own hierarchy (their paths do not include the scopes of the master
+  thread that spawned the region).
+*/
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+
+  map<string, ProfileEntry> res;
+
+  for(int i=0;i<registry.size();i++){
+    map<string, ProfileNode>::iterator it;
+
+    for(it=registry[i]->nodes.begin(); it!=registry[i]->nodes.end(); it++){
+      ProfileEntry& e = res[it->first];
+      e.count += it->second.count;
+      e.inclusive += it->second.inclusive;
+      e.exclusive += it->second.inclusive - it->second.children;
+      if(it->second.inclusive > e.max_thread){ e.max_thread = it->second.inclusive; }
+      e.nthreads++;
+    }
+  }
+
+  vector<ProfileEntry> summary;
+  map<string, ProfileEntry>::iterator it;
+
+  for(it=res.begin(); it!=res.end(); it++){
+    ProfileEntry e = it->second;
+
+    e.path = it->first;
+    size_t pos = e.path.rfind('/');
+    e.name = (pos==string::npos) ? e.path : e.path.substr(pos+1);
+
+    e.depth = 0;
+    for(int k=0;k<e.path.size();k++){ if(e.path[k]=='/'){ e.depth++; } }
+
+    double mean = e.inclusive / double(e.nthreads);
+    e.imbalance = (mean>0.0) ? e.max_thread / mean : 1.0;
+
+    summary.push_back(e);
+  }
+
+  return summary;
+}
+
+
+std::string profiler_report(){
+
+  vector<ProfileEntry> summary = profiler_summary();
+  stringstream ss;
+
+  ss<<left<<setw(48)<<"scope"<<right
+    <<setw(12)<<"calls"
+    <<setw(14)<<"incl [s]"
+    <<setw(14)<<"excl [s]"
+    <<setw(14)<<"per call [s]"
+    <<setw(9)<<"threads"
+    <<setw(11)<<"imbalance"<<"\n";
+
+  for(int i=0;i<summary.size();i++){
+    ProfileEntry& e = summary[i];
+
+    string label = string(2*e.depth, ' ') + e.name;
+
+    ss<<left<<setw(48)<<label<<right
+      <<setw(12)<<e.count
+      <<setw(14)<<fixed<<setprecision(6)<<e.inclusive
+      <<setw(14)<<e.exclusive
+      <<setw(14)<<scientific<<setprecision(3)<<(e.count>0 ? e.inclusive/double(e.count) : 0.0)
+      <<setw(9)<<e.nthreads
+      <<setw(11)<<fixed<<setprecision(3)<<e.imbalance<<"\n";
+  }
+
+  return ss.str();
+}
+
+
+void profiler_print(){
+
+  cout<<profiler_report();
+
+}
+
+
+void profiler_print(std::string filename){
+
+  ofstream out(filename.c_str(), ios::out);
+
+  if(!out.is_open()){
+    cout<<"Error in profiler_print: can not open file "<<filename<<"\nExiting...\n";
+    exit(0);
+  }
+
+  out<<profiler_report();
+  out.close();
+
+}
+
+
+}// namespace liblibra
+
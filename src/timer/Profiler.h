@@ -0,0 +1,152 @@
+/*********************************************************************************
+* Copyright (C) 2015-2022 Alexey V. Akimov
+*
+* This file is distributed under the terms of the GNU General Public License
+* as published by the Free Software Foundation, either version 3 of
+* the License, or (at your option) any later version.
+* See the file LICENSE in the root directory of this distribution
+* or <http://www.gnu.org/licenses/>.
+*
+*********************************************************************************/
+/**
+  \file Profiler.h
+  \brief Hierarchical wall-clock profiler with named, nestable scopes
+
+  Every thread keeps its own stack of open scopes and its own table of
+  accumulated times, so no locking is done on the hot path. A scope is
+  identified by its path, e.g. "compute_dynamics/update_Hamiltonian_variables".
+  The per-thread tables are combined only when the report is requested, which
+  should be done outside of the parallel regions.
+
+  Usage in C++:
+
+    void some_function(){
+      ScopedTimer _prof("some_function");
+      ...
+    }
+
+  Usage in Python:
+
+    profiler_enable()
+    ...
+    profiler_begin("my_loop"); ... ; profiler_end()
+    print( profiler_report() )
+
+  The profiler is off by default; a disabled ScopedTimer costs one atomic load.
+
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+/// liblibra namespace
+namespace liblibra{
+
+using namespace std;
+
+
+/// Monotonic high-resolution wall-clock time in seconds
+inline double wall_time(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+class ProfileNode{
+/**
+  Accumulated timings of one scope (path) in one thread
+*/
+public:
+  long count;          ///< number of calls
+  double inclusive;    ///< total time spent in the scope, including the nested scopes [s]
+  double children;     ///< time spent in the nested scopes [s]
+
+  ProfileNode(){ count = 0; inclusive = 0.0; children = 0.0; }
+};
+
+
+class ThreadProfile{
+/**
+  Per-thread profiling data: the stack of the currently open scopes and the
+  table of the accumulated timings
+*/
+public:
+  int thread_id;                       ///< registration index of the thread
+  map<string, ProfileNode> nodes;      ///< path -> accumulated timings
+  vector<string> stack_path;           ///< paths of the open scopes
+  vector<double> stack_start;          ///< start times of the open scopes
+  vector<double> stack_children;       ///< time spent in the children of the open scopes
+
+  ThreadProfile(int _thread_id){ thread_id = _thread_id; }
+};
+
+
+class ProfileEntry{
+/**
+  Timings of one scope combined over all threads
+*/
+public:
+  string path;         ///< full path of the scope
+  string name;         ///< the last component of the path
+  int depth;           ///< nesting level, 0 for the top-level scopes
+  long count;          ///< number of calls summed over threads
+  double inclusive;    ///< inclusive time summed over threads [s]
+  double exclusive;    ///< exclusive (self) time summed over threads [s]
+  double max_thread;   ///< largest inclusive time of a single thread [s]
+  int nthreads;        ///< number of threads that entered the scope
+  double imbalance;    ///< max_thread / (inclusive / nthreads); 1.0 - perfectly balanced
+
+  ProfileEntry(){ depth = 0; count = 0; inclusive = exclusive = max_thread = 0.0; nthreads = 0; imbalance = 1.0; }
+};
+
+
+// Profiler control
+void profiler_enable();
+void profiler_disable();
+int is_profiler_enabled();
+void profiler_reset();
+
+// Manual (non-RAII) scopes - these are also what the Python interface uses
+void profiler_begin(std::string name);
+void profiler_end();
+
+// Results
+vector<ProfileEntry> profiler_summary();
+std::string profiler_report();
+void profiler_print();
+void profiler_print(std::string filename);
+
+
+class ScopedTimer{
+/**
+  RAII guard: opens a profiling scope in the constructor and closes it in the
+  destructor. Does nothing if the profiler is disabled at construction time.
+*/
+  int is_active;
+
+public:
+  ScopedTimer(const char* name){
+    is_active = is_profiler_enabled();
+    if(is_active){ profiler_begin(name); }
+  }
+  ~ScopedTimer(){
+    if(is_active){ profiler_end(); }
+  }
+
+private:
+  ScopedTimer(const ScopedTimer&);
+  ScopedTimer& operator=(const ScopedTimer&);
+};
+
+
+}// namespace liblibra
+
+#endif // PROFILER_H
@@ -57,6 +57,7 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <chrono>
 
 
 #include <stdexcept>
@@ -72,23 +73,30 @@ using namespace std;
 class Timer{
 /**
   The Timer class which can be used for benchmarking purposes
+
+  Measures the wall-clock time with the monotonic high-resolution clock. (The
+  CPU time returned by clock() is summed over all threads, so it over-reports
+  the OpenMP regions.)
 */
 
- time_t t1,t2; // start and end points
- time_t acc;   // accumulator 
+ std::chrono::steady_clock::time_point t1,t2; // start and end points
+ double acc;   // accumulator [s]
 
 public:
 
-  Timer(){ acc = 0.0; } ///< Constructor: resets accumulated time to zero
+  Timer(){ acc = 0.0; t1 = t2 = std::chrono::steady_clock::now(); } ///< Constructor: resets accumulated time to zero
 
-  inline void start(){ t1 = clock(); }  ///< Start: saves the time of the start
+  inline void start(){ t1 = std::chrono::steady_clock::now(); }  ///< Start: saves the time of the start
   inline double stop(){
   /** Stop: gets the time of call and computes the time difference w.r.t to the start time. The difference is returned
   but is also added to the internal accumulator
   */
-    t2 = clock(); acc += (t2-t1); return ((t2-t1)/((double)CLOCKS_PER_SEC));
+    t2 = std::chrono::steady_clock::now(); 
+    double dt = std::chrono::duration<double>(t2-t1).count();
+    acc += dt; return dt;
   }
-  inline double show(){  return (acc/((double)CLOCKS_PER_SEC)); }  ///< Returns the time accumulated so far (in between start/stop) calls
+  inline double show(){  return acc; }  ///< Returns the time accumulated so far (in between start/stop) calls
+  inline void reset(){  acc = 0.0; }  ///< Resets the accumulated time to zero
 
 
 };
@@ -25,6 +25,17 @@ namespace liblibra{
 using namespace boost::python;
 
 
+boost::python::list profiler_summary_list(){
+
+  vector<ProfileEntry> summary = profiler_summary();
+  boost::python::list res;
+
+  for(int i=0;i<summary.size();i++){  res.append(summary[i]);  }
+
+  return res;
+}
+
+
 void export_timer_objects(){
 /** 
   \brief Exporter of Timer class and other mathematical libraries and their components
@@ -68,6 +79,35 @@ void export_timer_objects(){
 
   ;
 
+
+  class_<ProfileEntry>("ProfileEntry",init<>())
+      .def_readonly("path", &ProfileEntry::path)
+      .def_readonly("name", &ProfileEntry::name)
+      .def_readonly("depth", &ProfileEntry::depth)
+      .def_readonly("count", &ProfileEntry::count)
+      .def_readonly("inclusive", &ProfileEntry::inclusive)
+      .def_readonly("exclusive", &ProfileEntry::exclusive)
+      .def_readonly("max_thread", &ProfileEntry::max_thread)
+      .def_readonly("nthreads", &ProfileEntry::nthreads)
+      .def_readonly("imbalance", &ProfileEntry::imbalance)
+  ;
+
+
+  void (*expt_profiler_print_v1)() = &profiler_print;
+  void (*expt_profiler_print_v2)(std::string) = &profiler_print;
+
+  def("wall_time", &wall_time);
+  def("profiler_enable", &profiler_enable);
+  def("profiler_disable", &profiler_disable);
+  def("is_profiler_enabled", &is_profiler_enabled);
+  def("profiler_reset", &profiler_reset);
+  def("profiler_begin", &profiler_begin);
+  def("profiler_end", &profiler_end);
+  def("profiler_summary", &profiler_summary_list);
+  def("profiler_report", &profiler_report);
+  def("profiler_print", expt_profiler_print_v1);
+  def("profiler_print", expt_profiler_print_v2);
+
 
 
 }// export_timer_objects()
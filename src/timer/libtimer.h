@@ -18,6 +18,7 @@
 #define LIBTIMER_H
 
 #include "Timer.h"
+#include "Profiler.h"
 
 /// liblibra namespace
 namespace liblibra{
@@ -0,0 +1,184 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+def make_ann(arch, seed):
+    rnd = Random()
+    rnd.set_seed(seed)
+    ann = NeuralNetwork(Py2Cpp_int(arch))
+    ann.init_weights_biases_uniform(rnd, -1.0, 1.0, -0.1, 0.1)
+    return ann
+
+
+def make_data(n, sz_x, seed):
+    """ Random inputs in [-1, 1] and the smooth targets y = 0.6 sin(2 x_0) cos(x_{sz_x-1}) """
+    rnd = Random()
+    rnd.set_seed(seed)
+    X = MATRIX(sz_x, n)
+    T = MATRIX(1, n)
+    for j in range(n):
+        for i in range(sz_x):
+            X.set(i, j, rnd.uniform(-1.0, 1.0))
+        T.set(0, j, 0.6 * math.sin(2.0 * X.get(0, j)) * math.cos(X.get(sz_x-1, j)))
+    return X, T
+
+
+def columns(X, cols):
+    res = MATRIX(X.num_of_rows, len(cols))
+    for j, c in enumerate(cols):
+        for i in range(X.num_of_rows):
+            res.set(i, j, X.get(i, c))
+    return res
+
+
+def params_of(ann):
+    """ All the weights and biases as a flat list, in the order W[1], B[1], W[2], B[2], ... """
+    res = []
+    for L in range(1, ann.Nlayers):
+        for M in [ann.W[L], ann.B[L]]:
+            res += [ M.get(i, j) for i in range(M.num_of_rows) for j in range(M.num_of_cols) ]
+    return res
+
+
+def grads_of(ann):
+    res = []
+    for L in range(1, ann.Nlayers):
+        for M in [ann.grad_w[L], ann.grad_b[L]]:
+            res += [ M.get(i, j) for i in range(M.num_of_rows) for j in range(M.num_of_cols) ]
+    return res
+
+
+def set_param(ann, L, is_bias, i, j, val):
+    if is_bias:
+        B = ann.B
+        B[L].set(i, j, val)
+        ann.B = B
+    else:
+        W = ann.W
+        W[L].set(i, j, val)
+        ann.W = W
+
+
+arch = [2, 5, 4, 1]
+
+
+class TestANNTraining:
+
+    @pytest.mark.parametrize('nthreads', [1, 0])
+    def test_1(self, nthreads):
+        """ The batched gradients and error are the same as those of back_propagate, for the whole set and for a subset """
+        X, T = make_data(150, 2, 1)
+        ann = make_ann(arch, 2)
+        ref = make_ann(arch, 2)
+
+        for cols in [ list(range(150)), [ (7*k + 3) % 150 for k in range(70) ] ]:
+            err = ann.batch_gradients(X, T, Py2Cpp_int(cols), nthreads)
+
+            Xs, Ts = columns(X, cols), columns(T, cols)
+            err_ref = ref.back_propagate(ref.propagate(Xs), Ts)
+
+            assert abs(err - err_ref) < 1e-13
+            assert abs(err - ref.error(Xs, Ts)) < 1e-13
+            for a, b in zip(grads_of(ann), grads_of(ref)):
+                assert abs(a - b) < 1e-13
+
+
+    def test_2(self):
+        """ The gradients are the derivatives of the error: central finite differences """
+        X, T = make_data(40, 2, 3)
+        ann = make_ann(arch, 4)
+        ann.batch_gradients(X, T, Py2Cpp_int(list(range(40))), 1)
+
+        h = 1e-6
+        for L in range(1, ann.Nlayers):
+            for is_bias in [0, 1]:
+                G = ann.grad_b[L] if is_bias else ann.grad_w[L]
+                M = ann.B[L] if is_bias else ann.W[L]
+                for i in range(M.num_of_rows):
+                    for j in range(M.num_of_cols):
+                        x0 = M.get(i, j)
+                        set_param(ann, L, is_bias, i, j, x0 + h);  ep = ann.error(X, T)
+                        set_param(ann, L, is_bias, i, j, x0 - h);  em = ann.error(X, T)
+                        set_param(ann, L, is_bias, i, j, x0)
+
+                        fd = (ep - em) / (2.0 * h)
+                        assert abs(G.get(i, j) - fd) < 1e-7 * max(1.0, abs(fd))
+
+
+    @pytest.mark.parametrize('method', [13, 14])
+    def test_3(self, method):
+        """ The first step of Adam (13) and AdamW (14) vs. the explicit formula: with the bias corrections,
+            m/bc1 = g and v/bc2 = g^2, so the step is lr * g / (|g| + eps) plus the regularization """
+        n, lr, lam = 60, 0.01, 0.05
+        X, T = make_data(n, 2, 5)
+        ann = make_ann(arch, 6)
+        ref = make_ann(arch, 6)
+
+        rnd = Random()
+        rnd.set_seed(7)
+        ann.train(rnd, {"learning_method":method, "learning_rate":lr, "weight_decay_lambda":lam,
+                        "num_epochs":1, "steps_per_epoch":1, "epoch_size":n}, X, T)
+        assert ann.adam_t == 1
+
+        x0 = params_of(ref)
+        ref.batch_gradients(X, T, Py2Cpp_int(list(range(n))), 0)
+        g0 = grads_of(ref)
+
+        for x, g, x1 in zip(x0, g0, params_of(ann)):
+            if method == 13:
+                g = g + lam * x
+                d = lr * g / (abs(g) + 1e-8)
+            else:
+                d = lr * g / (abs(g) + 1e-8) + lam * x
+            assert abs(x1 - (x - d)) < 1e-10
+
+
+    @pytest.mark.parametrize('method', [13, 14, 3])
+    def test_4(self, method):
+        """ A small fit converges with Adam, AdamW and L-BFGS. The L-BFGS errors never increase """
+        n = 80
+        X, T = make_data(n, 1, 8)
+        ann = make_ann([1, 8, 1], 9)
+        err0 = ann.error(X, T)
+
+        prms = {"learning_method":method, "learning_rate":0.01, "num_epochs":600, "steps_per_epoch":1,
+                "epoch_size":n, "num_threads":1}
+
+        rnd = Random()
+        rnd.set_seed(10)
+        err = list(ann.train(rnd, prms, X, T))
+
+        assert ann.error(X, T) < 0.05 * err0
+        if method == 3:
+            for k in range(1, len(err)):
+                assert err[k] <= err[k-1]
+            assert ann.error(X, T) < 1e-2 * err0
+
+
+    @pytest.mark.parametrize('patience', [3, 0])
+    def test_5(self, patience):
+        """ Early stopping: the validation set that gets worse as the training set is fitted (the opposite
+            targets). The training stops `patience` epochs after the best one, and the best weights are restored """
+        n, num_epochs = 60, 100
+        X, T = make_data(n, 2, 11)
+        Tv = MATRIX(1, n)
+        for j in range(n):
+            Tv.set(0, j, -T.get(0, j))
+
+        ann = make_ann(arch, 12)
+        rnd = Random()
+        rnd.set_seed(13)
+        ann.train(rnd, {"learning_method":13, "learning_rate":0.02, "num_epochs":num_epochs, "steps_per_epoch":2,
+                        "epoch_size":n, "num_threads":1, "patience":patience}, X, T, X, Tv)
+
+        val = list(ann.validation_error)
+        best = val.index(min(val))
+        if patience > 0:
+            assert best + 1 < num_epochs - patience
+            assert len(val) == best + 1 + patience
+        else:
+            assert len(val) == num_epochs
+
+        assert ann.batch_error(X, Tv, 1) == val[best]
@@ -0,0 +1,123 @@
+import pytest
+
+import cmath
+from liblibra_core import *
+
+
+# A small orthorhombic cell with 3 atoms; the AOs are s and p shells
+cell = [ 4.0, 4.5, 5.0 ]
+atoms = [ [0.0, 0.0, 0.0], [1.6, 0.3, 0.2], [0.4, 2.1, 2.6] ]
+shells = [ [ (0, 0.8) , (1, 0.6) ], [ (0, 1.1) ], [ (0, 0.7), (1, 0.9) ] ]   # (L, alpha) per atom
+cart = { 0: [ (0,0,0) ], 1: [ (1,0,0), (0,1,0), (0,0,1) ] }
+
+
+def translations():
+    return VECTOR(cell[0], 0.0, 0.0), VECTOR(0.0, cell[1], 0.0), VECTOR(0.0, 0.0, cell[2])
+
+
+def make_basis(shifted_atom=-1, T=(0.0, 0.0, 0.0)):
+    """ The AOs of all atoms, the AOs of the atom `shifted_atom` are displaced by T.
+        Returns the AOs, the AO-to-atom map and the atom-to-AO map """
+    basis = AOList()
+    ao_to_atom, atom_to_ao = [], []
+
+    for A in range(len(atoms)):
+        d = T if A==shifted_atom else (0.0, 0.0, 0.0)
+        R = VECTOR(atoms[A][0] + d[0], atoms[A][1] + d[1], atoms[A][2] + d[2])
+        atom_to_ao.append([])
+        for L, alp in shells[A]:
+            for (x, y, z) in cart[L]:
+                g = PrimitiveG()
+                g.init(x, y, z, alp, R)
+                ao = AO()
+                ao.add_primitive(1.0, g)
+                atom_to_ao[A].append(len(ao_to_atom))
+                basis.append(ao)
+                ao_to_atom.append(A)
+
+    atom_to_ao_map = intList2()
+    for x in atom_to_ao:
+        atom_to_ao_map.append(Py2Cpp_int(x))
+
+    return basis, Py2Cpp_int(ao_to_atom), atom_to_ao_map
+
+
+def per_atom(nx, ny, nz, basis, ao_to_atom, atom_to_ao, c):
+    """ The derivative couplings of the atom c from the original function """
+    t1, t2, t3 = translations()
+    n = len(basis)
+    Dx, Dy, Dz = MATRIX(n, n), MATRIX(n, n), MATRIX(n, n)
+    update_derivative_coupling_matrix(nx, ny, nz, t1, t2, t3, atom_to_ao, ao_to_atom, basis, c, Dx, Dy, Dz)
+    return [Dx, Dy, Dz]
+
+
+def max_diff(X, Y):
+    err = 0.0
+    for i in range(X.num_of_rows):
+        for j in range(X.num_of_cols):
+            err = max(err, abs(X.get(i, j) - Y.get(i, j)))
+    return err
+
+
+class TestBasisNAC:
+
+    @pytest.mark.parametrize('periods', [ (0, 0, 0), (1, 1, 1), (2, 1, 0) ])
+    def test_1(self, periods):
+        """ Gamma-point: all the matrices at once vs. the original function for each atom, both the real
+            and the complex (k = 0) versions """
+        t1, t2, t3 = translations()
+        basis, ao_to_atom, atom_to_ao = make_basis()
+        nx, ny, nz = periods
+
+        D = MATRIXList()
+        update_derivative_coupling_matrices(nx, ny, nz, t1, t2, t3, ao_to_atom, basis, -1.0, D)
+        Dk = update_derivative_coupling_matrices(nx, ny, nz, t1, t2, t3, VECTOR(0.0, 0.0, 0.0), ao_to_atom, basis, -1.0)
+
+        assert len(D) == 3 * len(atoms) and len(Dk) == 3 * len(atoms)
+        for c in range(len(atoms)):
+            ref = per_atom(nx, ny, nz, basis, ao_to_atom, atom_to_ao, c)
+            for a in range(3):
+                assert max_diff(D[3*c+a], ref[a]) < 1e-12
+                assert max_diff(Dk[3*c+a].real(), ref[a]) < 1e-12
+                assert max_diff(Dk[3*c+a].imag(), MATRIX(len(basis), len(basis))) < 1e-14
+
+
+    def test_2(self):
+        """ A k-point: the Bloch sum over the images T, exp(i k.T) <i|d/dR_c|j(r-T)>, built from the original function
+            applied to the basis with the AOs of the atom c displaced by T """
+        t1, t2, t3 = translations()
+        basis, ao_to_atom, atom_to_ao = make_basis()
+        k = VECTOR(0.3, -0.2, 0.45)
+        n = len(basis)
+
+        Dk = update_derivative_coupling_matrices(1, 1, 1, t1, t2, t3, k, ao_to_atom, basis, -1.0)
+
+        for c in range(len(atoms)):
+            ref = [ CMATRIX(n, n) for a in range(3) ]
+            for ix in [-1, 0, 1]:
+                for iy in [-1, 0, 1]:
+                    for iz in [-1, 0, 1]:
+                        T = (ix * cell[0], iy * cell[1], iz * cell[2])
+                        ph = cmath.exp(1j * (k.x * T[0] + k.y * T[1] + k.z * T[2]))
+
+                        basis_T, ao_to_atom_T, atom_to_ao_T = make_basis(c, T)
+                        D = per_atom(0, 0, 0, basis_T, ao_to_atom_T, atom_to_ao_T, c)
+                        for a in range(3):
+                            for i in range(n):
+                                for j in range(n):
+                                    ref[a].set(i, j, ref[a].get(i, j) + ph * D[a].get(i, j))
+
+            for a in range(3):
+                assert max_diff(Dk[3*c+a], ref[a]) < 1e-12
+
+
+    def test_3(self):
+        """ The screening radius larger than the size of the image sum changes nothing """
+        t1, t2, t3 = translations()
+        basis, ao_to_atom, atom_to_ao = make_basis()
+        k = VECTOR(0.1, 0.2, 0.3)
+
+        D0 = update_derivative_coupling_matrices(1, 1, 1, t1, t2, t3, k, ao_to_atom, basis, -1.0)
+        D1 = update_derivative_coupling_matrices(1, 1, 1, t1, t2, t3, k, ao_to_atom, basis, 1e4)
+        for a in range(len(D0)):
+            assert max_diff(D0[a], D1[a]) == 0.0
@@ -0,0 +1,125 @@
+import pytest
+
+import random
+from liblibra_core import *
+
+
+amu = 1822.888
+valences = {"C":50}   # no saturation, so the bonding depends only on the distances
+
+class elt:
+    pass
+
+
+def make_universe():
+    U = Universe()
+    e = elt()
+    e.Elt_name = "C"
+    e.Elt_mass = 12.011 * amu
+    rec = Element()
+    rec.set(e)
+    U.Add_Element_To_Periodic_Table(rec)
+    return U
+
+
+def make_system(U, coords):
+    syst = System()
+    for r in coords:
+        syst.CREATE_ATOM( Atom(U, {"Atom_element":"C", "Atom_cm_x":r[0], "Atom_cm_y":r[1], "Atom_cm_z":r[2]}) )
+    return syst
+
+
+def set_coords(syst, coords):
+    syst.set_atomic_q(Py2Cpp_double([ x for r in coords for x in r ]))
+
+
+def bonds(syst):
+    res = set()
+    for i in range(syst.Number_of_bonds):
+        a, b = syst.Bonds[i].globAtom_Index[0], syst.Bonds[i].globAtom_Index[1]
+        res.add((min(a, b), max(a, b)))
+    return res
+
+
+def full_bonds(U, coords):
+    """ The bonding of the geometry perceived from scratch """
+    syst = make_system(U, coords)
+    syst.CREATE_BONDS(list(range(1, len(coords)+1)), valences, 0.4*1.889725989, 0)
+    return bonds(syst)
+
+
+def random_coords(rnd, n, x0):
+    return [ [x0 + rnd.uniform(0.0, 10.0), rnd.uniform(0.0, 10.0), rnd.uniform(0.0, 10.0)] for i in range(n) ]
+
+
+class TestBondPerception:
+
+    @pytest.mark.parametrize('seed', [1, 2, 3])
+    def test_1(self, seed):
+        """ A cluster approaching a static one: the incremental updates never form a bond out of range,
+            and the final update gives the same bonding as the full perception """
+        rnd = random.Random(seed)
+        U = make_universe()
+        A = random_coords(rnd, 12, 0.0)
+        B = random_coords(rnd, 12, 14.0)
+        n = len(A) + len(B)
+
+        syst = make_system(U, A + B)
+        tol = 0.4*1.889725989
+        syst.CREATE_BONDS(list(range(1, n+1)), valences, tol, 0)
+        assert bonds(syst) == full_bonds(U, A + B)
+
+        for step in range(25):
+            for r in B:
+                r[0] -= 0.15          # all the A-B distances decrease
+            set_coords(syst, A + B)
+            syst.UPDATE_BONDS(0.5*tol)
+            assert bonds(syst) <= full_bonds(U, A + B)
+
+        syst.UPDATE_BONDS(0.0)
+        assert bonds(syst) == full_bonds(U, A + B)
+
+
+    def test_2(self):
+        """ The displacements below the threshold are not re-examined; a zero threshold re-examines the moved atoms """
+        U = make_universe()
+        coords = [ [0.0, 0.0, 0.0], [5.0, 0.0, 0.0], [20.0, 0.0, 0.0] ]
+        syst = make_system(U, coords)
+        syst.CREATE_BONDS([1, 2, 3], valences, 0.4*1.889725989, 0)
+        assert len(bonds(syst)) == 0
+
+        coords[1][0] = 3.0            # within the bonding range of the atom 0 now
+        set_coords(syst, coords)
+        assert syst.UPDATE_BONDS(5.0) == 0
+        assert len(bonds(syst)) == 0
+
+        assert syst.UPDATE_BONDS(0.0) == 1
+        assert bonds(syst) == {(0, 1)}
+
+
+    @pytest.mark.parametrize('seed', [4, 5])
+    def test_3(self, seed):
+        """ Random moves of random atoms: every bond was in range at some point, and all the bonds
+            in range in the final geometry are found by the final update """
+        rnd = random.Random(seed)
+        U = make_universe()
+        coords = random_coords(rnd, 30, 0.0)
+        n = len(coords)
+        tol = 0.4*1.889725989
+
+        syst = make_system(U, coords)
+        syst.CREATE_BONDS(list(range(1, n+1)), valences, tol, 0)
+        seen = full_bonds(U, coords)
+
+        for step in range(40):
+            for i in rnd.sample(range(n), 5):
+                for c in range(3):
+                    coords[i][c] += rnd.uniform(-0.3, 0.3)
+            set_coords(syst, coords)
+            syst.UPDATE_BONDS(0.5*tol)
+            seen |= full_bonds(U, coords)
+            assert bonds(syst) <= seen
+
+        syst.UPDATE_BONDS(0.0)
+        assert full_bonds(U, coords) <= bonds(syst) <= seen
+
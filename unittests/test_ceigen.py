@@ -250,6 +250,91 @@ class TestmEigen(unittest.TestCase):
             self.assertAlmostEqual( lhs4.get(i), I.get(i), 7  )
 
 
+    def test_5a(self):
+        """sqrt() of a complex Hermitian positive-definite matrix"""
+        N = 6
+        S = CMATRIX(N,N)
+
+        for i in xrange(N):
+            for j in xrange(N):
+                S.set(i,j, math.exp(-0.5*(i-j)**2), 0.05*(i-j) );
+
+        S_half_inv = CMATRIX(N,N)
+        S_half = CMATRIX(N,N)
+
+        sqrt_matrix(S, S_half, S_half_inv)
+
+        I = CMATRIX(N,N);  I.identity();
+
+        lhs1 = S_half * S_half
+        lhs2 = S_half * S_half_inv
+
+        for i in xrange(N*N):
+            self.assertAlmostEqual( lhs1.get(i), S.get(i), 7  )
+            self.assertAlmostEqual( lhs2.get(i), I.get(i), 7  )
+
+
+    def test_6(self):
+        """exp(log(U)) = U for a unitary U"""
+        N = 5
+        H = CMATRIX(N,N)
+
+        for i in xrange(N):
+            for j in xrange(N):
+                H.set(i,j, 0.3*math.exp(-0.2*(i-j)**2), 0.1*(i-j) );
+
+        # U = exp(-i*H), the eigenphases are within (-pi, pi)
+        U = CMATRIX(N,N)
+        exp_hermitian(U, H, -1.0j)
+
+        I = CMATRIX(N,N);  I.identity();
+        UU = U.H() * U
+        for i in xrange(N*N):
+            self.assertAlmostEqual( UU.get(i), I.get(i), 10  )
+
+        L = CMATRIX(N,N)
+        log_matrix(L, U)
+
+        # The principal logarithm of U is -i*H
+        for i in xrange(N*N):
+            self.assertAlmostEqual( L.get(i), -1.0j*H.get(i), 8  )
+
+        U2 = CMATRIX(N,N)
+        exp_matrix(U2, L, 1.0+0.0j)
+        for i in xrange(N*N):
+            self.assertAlmostEqual( U2.get(i), U.get(i), 8  )
+
+
+    def test_6a(self):
+        """Pade exponential of a non-normal matrix"""
+
+        # A is nilpotent, so exp(A*dt) = I + A*dt exactly
+        A = CMATRIX(2,2)
+        A.set(0,1, 3.0, 1.0)
+
+        res = CMATRIX(2,2)
+        expm_pade(res, A, 0.5+0.0j)
+
+        self.assertAlmostEqual( res.get(0,0), 1.0+0.0j )
+        self.assertAlmostEqual( res.get(0,1), 1.5+0.5j )
+        self.assertAlmostEqual( res.get(1,0), 0.0+0.0j )
+        self.assertAlmostEqual( res.get(1,1), 1.0+0.0j )
+
+        # Same as exp_hermitian for the Hermitian input
+        N = 4
+        H = CMATRIX(N,N)
+        for i in xrange(N):
+            for j in xrange(N):
+                H.set(i,j, 1.0/(1.0+i+j), 0.2*(i-j) );
+
+        R1 = CMATRIX(N,N)
+        R2 = CMATRIX(N,N)
+        expm_pade(R1, H, -2.0j)
+        exp_hermitian(R2, H, -2.0j)
+        for i in xrange(N*N):
+            self.assertAlmostEqual( R1.get(i), R2.get(i), 10  )
+
+
 
 
 
@@ -0,0 +1,169 @@
+import pytest
+
+import math
+import random
+from liblibra_core import *
+
+
+amu = 1822.888
+
+class elt:
+    pass
+
+
+def make_universe():
+    U = Universe()
+    for name, m in [("O", 15.999), ("H", 1.008), ("C", 12.011)]:
+        e = elt()
+        e.Elt_name = name
+        e.Elt_mass = m * amu
+        rec = Element()
+        rec.set(e)
+        U.Add_Element_To_Periodic_Table(rec)
+    return U
+
+
+def make_system(U, elements, coords):
+    """ One single-atom fragment per atom """
+    syst = System()
+    for el, r in zip(elements, coords):
+        syst.CREATE_ATOM( Atom(U, {"Atom_element":el, "Atom_cm_x":r[0], "Atom_cm_y":r[1], "Atom_cm_z":r[2]}) )
+    syst.init_fragments()
+    return syst
+
+
+def water(U):
+    dOH, theta = 1.81, 104.5*math.pi/180.0
+    x, y = dOH*math.sin(0.5*theta), dOH*math.cos(0.5*theta)
+    syst = make_system(U, ["O", "H", "H"], [(0.0, 0.0, 0.0), (x, y, 0.0), (-x, y, 0.0)])
+    syst.add_constraint(0, 1)
+    syst.add_constraint(0, 2)
+    syst.add_constraint(1, 2)
+    return syst
+
+
+def chain(U):
+    """ A zig-zag H-C-C-H chain with all the bonds constrained: a coupled cluster """
+    syst = make_system(U, ["H", "C", "C", "H"], [(0.0, 0.0, 0.0), (2.0, 0.5, 0.0), (4.8, 0.0, 0.3), (6.8, 0.6, 0.0)])
+    syst.add_constraint(0, 1)
+    syst.add_constraint(1, 2)
+    syst.add_constraint(2, 3)
+    return syst
+
+
+def step(syst, dt, rnd, fixed=[]):
+    """ Random momenta, free drift, and the position/velocity constraints - like one MD step """
+    n = syst.Number_of_fragments
+    q = Py2Cpp_double([0.0]*(3*n))
+    p = Py2Cpp_double([0.0]*(3*n))
+    m = Py2Cpp_double([0.0]*(3*n))
+    syst.extract_fragment_q(q)
+    syst.extract_fragment_mass(m)
+
+    for i in range(n):
+        for c in range(3):
+            if i not in fixed:
+                p[3*i+c] = m[3*i+c] * rnd.uniform(-1.0, 1.0) * 1e-3
+    syst.set_fragment_p(p)
+
+    syst.save_constraint_reference()
+    for i in range(3*n):
+        q[i] = q[i] + dt * p[i] / m[i]
+    syst.set_fragment_q(q)
+
+    syst.apply_position_constraints(dt)
+    syst.apply_velocity_constraints(dt)
+
+
+def bond_checks(syst, bonds):
+    """ Returns the largest |r - d|/d and the largest relative velocity along the bonds """
+    n = syst.Number_of_fragments
+    q = Py2Cpp_double([0.0]*(3*n))
+    v = Py2Cpp_double([0.0]*(3*n))
+    syst.extract_fragment_q(q)
+    syst.extract_fragment_v(v)
+
+    dev, vdev = 0.0, 0.0
+    for (a, b, d) in bonds:
+        r = [q[3*a+c] - q[3*b+c] for c in range(3)]
+        w = [v[3*a+c] - v[3*b+c] for c in range(3)]
+        L = math.sqrt(sum(x*x for x in r))
+        dev = max(dev, abs(L - d)/d)
+        vdev = max(vdev, abs(sum(r[c]*w[c] for c in range(3)))/L)
+    return dev, vdev
+
+
+def lengths(syst, pairs):
+    n = syst.Number_of_fragments
+    q = Py2Cpp_double([0.0]*(3*n))
+    syst.extract_fragment_q(q)
+    return [ (a, b, math.sqrt(sum((q[3*a+c]-q[3*b+c])**2 for c in range(3)))) for (a, b) in pairs ]
+
+
+class TestConstraints:
+
+    @pytest.mark.parametrize('method, tol', [("SHAKE", 1e-7), ("M-SHAKE", 1e-7), ("LINCS", 1e-3)])
+    def test_1(self, method, tol):
+        """ SHAKE, M-SHAKE, LINCS with RATTLE: the bond lengths and the bond velocities after the steps """
+        U = make_universe()
+        syst = chain(U)
+        syst.constraint_method = method
+        bonds = lengths(syst, [(0, 1), (1, 2), (2, 3)])
+
+        rnd = random.Random(3)
+        for i in range(10):
+            step(syst, 20.0, rnd)
+            dev, vdev = bond_checks(syst, bonds)
+            assert dev < tol
+            assert vdev < 1e-10
+
+
+    def test_2(self):
+        """ SETTLE with RATTLE: a rigid water keeps its geometry """
+        U = make_universe()
+        syst = water(U)
+        bonds = lengths(syst, [(0, 1), (0, 2), (1, 2)])
+
+        rnd = random.Random(5)
+        for i in range(10):
+            step(syst, 20.0, rnd)
+            dev, vdev = bond_checks(syst, bonds)
+            assert dev < 1e-10
+            assert vdev < 1e-10
+
+
+    def test_3(self):
+        """ The constrained DOFs survive the re-initialization of the fragments """
+        U = make_universe()
+        syst = make_system(U, ["H", "C", "C", "H"], [(0.0, 0.0, 0.0), (2.0, 0.5, 0.0), (4.8, 0.0, 0.3), (6.8, 0.6, 0.0)])
+        nf0 = syst.Nf_t
+
+        syst.add_constraint(0, 1)
+        syst.add_constraint(1, 2)
+        assert syst.Nf_t == nf0 - 2
+
+        syst.init_fragments()
+        assert syst.Nf_t == nf0 - 2
+
+        syst.clear_constraints()
+        assert syst.Nf_t == nf0
+
+
+    def test_4(self):
+        """ A water with the fixed O atom: the O atom is not moved by the constraints, the bonds are kept """
+        U = make_universe()
+        syst = water(U)
+        syst.fix_fragment_translation(1)   # the fragment of the O atom
+        bonds = lengths(syst, [(0, 1), (0, 2), (1, 2)])
+
+        rnd = random.Random(7)
+        for i in range(10):
+            step(syst, 20.0, rnd, fixed=[0])
+            dev, vdev = bond_checks(syst, bonds)
+            assert dev < 1e-7
+            assert vdev < 1e-10
+
+        q = Py2Cpp_double([0.0]*9)
+        syst.extract_fragment_q(q)
+        assert q[0] == 0.0 and q[1] == 0.0 and q[2] == 0.0
+
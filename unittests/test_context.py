@@ -0,0 +1,108 @@
+import pytest
+
+from liblibra_core import *
+
+
+def make_context():
+    """ root: a = 1, s = "x", child: b = 2.0, v = [1.0, 2.0] """
+    ctx = Context()
+    ctx.set_path("root")
+    ctx.add("a", 1)
+    ctx.add("s", "x")
+
+    ch = Context()
+    ch.set_path("child")
+    ch.add("b", 2.0)
+    ch.add("v", Py2Cpp_double([1.0, 2.0]))
+    ctx.add_context(ch)
+
+    return ctx
+
+
+class TestContext:
+
+    def test_1(self):
+        """ The values of the context and of its child view """
+        ctx = make_context()
+        assert ctx.get("a", 0) == 1
+        assert ctx.get("s", "") == "x"
+        assert ctx.get("missing", -5) == -5
+
+        v = ctx.get_child("child", Context())
+        assert v.get_path() == "child"
+        assert v.get("b", 0.0) == 2.0
+        assert list(v.get("v", Py2Cpp_double([]))) == [1.0, 2.0]
+        assert v.get("a", 0) == 0      # the variables of the parent are not visible in the child
+
+        assert len(ctx.get_children("child")) == 1
+        assert [ x.get_path() for x in ctx.get_children_all() ] == ["a", "s", "child"]
+
+
+    def test_2(self):
+        """ Modifying the parent after the view is taken does not change the view """
+        ctx = make_context()
+        v = ctx.get_child("child", Context())
+
+        ctx.add("child.b", 5.0)
+        ctx.add("a", 7)
+
+        assert v.get("b", 0.0) == 2.0
+        assert ctx.get_child("child", Context()).get("b", 0.0) == 5.0
+        assert ctx.get("a", 0) == 7
+
+
+    def test_3(self):
+        """ Modifying the view (and a copy) does not change the parent """
+        ctx = make_context()
+        v = ctx.get_child("child", Context())
+        c = Context(ctx)
+
+        v.add("b", 3.0)
+        v.add("c", 4)
+        c.add("a", 9)
+
+        assert v.get("b", 0.0) == 3.0
+        assert v.get("c", 0) == 4
+        assert c.get("a", 0) == 9
+
+        w = ctx.get_child("child", Context())
+        assert w.get("b", 0.0) == 2.0
+        assert w.get("c", 0) == 0
+        assert ctx.get("a", 0) == 1
+
+
+    def test_4(self):
+        """ add() invalidates the cached values, both present and missing ones """
+        ctx = make_context()
+        assert ctx.get("a", 0) == 1
+        assert ctx.get("new", 0.0) == 0.0
+
+        ctx.add("a", 2)
+        ctx.add("new", 1.5)
+        assert ctx.get("a", 0) == 2
+        assert ctx.get("new", 0.0) == 1.5
+
+        v = ctx.get_child("child", Context())
+        assert v.get("b", 0.0) == 2.0
+        v.add("b", 6.0)
+        assert v.get("b", 0.0) == 6.0
+
+
+    def test_5(self, tmp_path):
+        """ save_xml of a view writes the subtree only, it is read back as a context of its own """
+        ctx = make_context()
+        v = ctx.get_child("child", Context())
+
+        fname = str(tmp_path / "child.xml")
+        v.save_xml(fname)
+
+        w = Context(fname)
+        assert w.get_path() == "child"
+        assert w.get("b", 0.0) == 2.0
+        assert list(w.get("v", Py2Cpp_double([]))) == [1.0, 2.0]
+
+        fname = str(tmp_path / "root.xml")
+        ctx.save_xml(fname)
+        r = Context(fname)
+        assert r.get("a", 0) == 1
+        assert r.get_child("child", Context()).get("b", 0.0) == 2.0
@@ -12,6 +12,7 @@
 import os
 import sys
 import math
+import unittest
 
 cwd = os.getcwd()
 print "Current working directory", cwd
@@ -47,5 +48,58 @@ print "mae = ",mae
 print "rmse = ",rmse
 
 
+class TestDATA_stream(unittest.TestCase):
+    """ Summary of the tests:
+    1 - blocking_error and correlation_time are NaN for the series shorter than min_blocks
+    2 - single-pass mae of the non-merged accumulator, NaN after merge()
+    """
 
+    def test_1(self):
+        """Blocking analysis of a short series"""
 
+        s = DATA_stream()
+        for i in xrange(10):
+            s.add( math.sin(0.3*i) )
+
+        self.assertTrue( math.isnan( s.blocking_error() ) )       # 10 samples < 128 blocks
+        self.assertTrue( math.isnan( s.blocking_error(16) ) )
+        self.assertTrue( math.isnan( s.correlation_time() ) )
+        self.assertFalse( math.isnan( s.blocking_error(4) ) )
+
+        for i in xrange(10, 200):
+            s.add( math.sin(0.3*i) )
+        self.assertFalse( math.isnan( s.blocking_error() ) )
+        self.assertFalse( math.isnan( s.correlation_time() ) )
+
+
+    def test_2(self):
+        """mae with the running mean"""
+
+        x = [1.0, 0.5, 2.0, -0.5, 3.0, 0.25]
+
+        s = DATA_stream()
+        ave, mae = 0.0, 0.0
+        for i in xrange(len(x)):
+            s.add(x[i])
+            ave = ave + (x[i] - ave)/(i+1.0)
+            mae = mae + abs(x[i] - ave)
+
+        self.assertAlmostEqual( s.get_mae(), mae/len(x) )
+
+        # Merging into an empty accumulator is a copy - the mae is still available
+        s0 = DATA_stream()
+        s0.merge(s)
+        self.assertAlmostEqual( s0.get_mae(), mae/len(x) )
+
+        # Merging two non-empty accumulators: the moments are exact, the mae is not available
+        s1 = DATA_stream()
+        s1.add([4.0, -1.0])
+        s.merge(s1)
+        self.assertEqual( s.n, len(x) + 2 )
+        self.assertAlmostEqual( s.ave, sum(x + [4.0, -1.0])/(len(x) + 2.0) )
+        self.assertTrue( math.isnan( s.get_mae() ) )
+
+
+
+if __name__=='__main__':
+    unittest.main()
@@ -0,0 +1,164 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+nst, ndof, ntraj = 2, 1, 3
+
+class tmp:
+    pass
+
+
+def params(**kw):
+    prms = dyn_control_params()
+    x = {"dt":10.0, "adaptive_dt":1, "adaptive_dt_min":2.0, "adaptive_dt_max":20.0, "adaptive_dt_max_factor":2.0,
+         "adaptive_dt_energy_tol":1e-5, "adaptive_dt_force_tol":0.1, "ensemble":0}
+    x.update(kw)
+    prms.set_parameters(x)
+    return prms
+
+
+def model(q, params, full_id):
+    """ A 1D two-state avoided crossing: V11 = -V22 = A tanh(B x), V12 = C exp(-D x^2) """
+    A, B, C, D = 0.01, 1.6, 0.005, 1.0
+    indx = Cpp2Py(full_id)[-1]
+    x = q.get(0, indx)
+
+    obj = tmp()
+    obj.ham_dia = CMATRIX(nst, nst)
+    obj.ovlp_dia = CMATRIX(nst, nst)
+    obj.ovlp_dia.identity()
+    obj.d1ham_dia = CMATRIXList()
+    obj.dc1_dia = CMATRIXList()
+
+    v, dv = A * math.tanh(B * x), A * B / math.cosh(B * x)**2
+    c, dc = C * math.exp(-D * x * x), -2.0 * D * x * C * math.exp(-D * x * x)
+
+    obj.ham_dia.set(0, 0, v + 0.0j);  obj.ham_dia.set(1, 1, -v + 0.0j)
+    obj.ham_dia.set(0, 1, c + 0.0j);  obj.ham_dia.set(1, 0, c + 0.0j)
+
+    d1 = CMATRIX(nst, nst)
+    d1.set(0, 0, dv + 0.0j);  d1.set(1, 1, -dv + 0.0j)
+    d1.set(0, 1, dc + 0.0j);  d1.set(1, 0, dc + 0.0j)
+    obj.d1ham_dia.append(d1)
+    obj.dc1_dia.append(CMATRIX(nst, nst))
+
+    return obj
+
+
+def vibronic_hamiltonians(energies, coupling):
+    """ The parent Hamiltonian with one child per trajectory; the children have the given
+        energies and the off-diagonal elements of the vibronic Hamiltonian """
+    ham = nHamiltonian(nst, nst, ndof)
+    children = []
+    for traj in range(ntraj):
+        ch = nHamiltonian(nst, nst, ndof)
+        ch.init_all(2)
+        H = CMATRIX(nst, nst)
+        for i in range(nst):
+            H.set(i, i, energies[i] + 0.0j)
+        H.set(0, 1, 0.0 - coupling[traj] * 1.0j)
+        H.set(1, 0, 0.0 + coupling[traj] * 1.0j)
+        ch.set_ham_adi_by_val(H)
+        ch.set_hvib_adi_by_val(H)
+        ham.add_child(ch)
+        children.append(ch)
+    return ham, children      # the children must be kept alive
+
+
+class TestAdaptiveStep:
+
+    def test_1(self):
+        """ The step grows when the errors are small, shrinks when they are large, within the bounds """
+        prms = params()
+        small, large = Py2Cpp_double([1e-9]*ntraj), Py2Cpp_double([1e-2]*ntraj)
+        zero = Py2Cpp_double([0.0]*ntraj)
+
+        assert adaptive_time_step(prms, 8.0, small, zero, 0) == 16.0     # by the largest factor
+        assert adaptive_time_step(prms, 15.0, small, zero, 0) == 20.0    # by the upper bound
+        assert adaptive_time_step(prms, 8.0, large, zero, 0) == 4.0      # by the largest factor
+        assert adaptive_time_step(prms, 3.0, large, zero, 0) == 2.0      # by the lower bound
+        assert adaptive_time_step(prms, 8.0, zero, Py2Cpp_double([0.0, 1.0, 0.0]), 0) == 4.0
+
+        dt = adaptive_time_step(prms, 8.0, Py2Cpp_double([0.0, 2e-5, 0.0]), zero, 0)
+        assert abs(dt - 8.0*0.9*math.sqrt(1e-5/2e-5)) < 1e-12       # the energy error ~ dt^2
+
+        dt = adaptive_time_step(prms, 8.0, zero, Py2Cpp_double([0.12, 0.0, 0.0]), 0)
+        assert abs(dt - 8.0*0.9*0.1/0.12) < 1e-12                     # the force change ~ dt
+
+
+    def test_2(self):
+        """ No growth after an event; the shrinking is not affected """
+        prms = params()
+        small, large = Py2Cpp_double([1e-9]*ntraj), Py2Cpp_double([1e-2]*ntraj)
+        zero = Py2Cpp_double([0.0]*ntraj)
+
+        assert adaptive_time_step(prms, 8.0, small, zero, 1) == 8.0
+        assert adaptive_time_step(prms, 8.0, large, zero, 1) == 4.0
+
+
+    def test_3(self):
+        """ The energy criterion is not used in the NVT dynamics """
+        prms = params(ensemble=1)
+        large = Py2Cpp_double([1e-2]*ntraj)
+        zero = Py2Cpp_double([0.0]*ntraj)
+        assert adaptive_time_step(prms, 8.0, large, zero, 0) == 16.0
+
+
+    def test_4(self):
+        """ electronic_substeps: 1 without the coupling, max_electronic_substeps for a huge one,
+            ceil(|V| dt / tol) in between """
+        prms = params(adaptive_electronic_substeps=1, electronic_substep_tol=0.01, max_electronic_substeps=50, rep_tdse=1)
+        dyn_var = dyn_variables(nst, nst, ndof, ntraj)
+
+        ham, ch = vibronic_hamiltonians([0.1, 0.2], [0.0, 0.0, 0.0])
+        ham_prev, ch_prev = vibronic_hamiltonians([0.1, 0.2], [0.0, 0.0, 0.0])
+        assert list(electronic_substeps(dyn_var, ham, ham_prev, prms)) == [1, 1, 1]
+
+        ham, ch = vibronic_hamiltonians([0.1, 0.2], [0.0, 1e3, 0.0095])
+        ham_prev, ch_prev = vibronic_hamiltonians([0.1, 0.2], [0.0, 1e3, 0.0095])
+        assert list(electronic_substeps(dyn_var, ham, ham_prev, prms)) == [1, 50, 10]
+
+        # The XF methods use the largest number for all the trajectories
+        prms.decoherence_algo = 5
+        assert list(electronic_substeps(dyn_var, ham, ham_prev, prms)) == [50, 50, 50]
+
+
+    def test_5(self):
+        """ The adaptive NVE run on the 1D model: the elapsed time is the sum of the steps made,
+            and all the steps are within the bounds """
+        rnd = Random()
+        rnd.set_seed(3)
+        dyn_params = {"dt":10.0, "adaptive_dt":1, "adaptive_dt_min":2.0, "adaptive_dt_max":40.0,
+                      "adaptive_dt_energy_tol":1e-6, "ensemble":0}
+
+        dyn_var = dyn_variables(nst, nst, ndof, ntraj)
+        dyn_var.init_nuclear_dyn_var({"init_type":3, "q":[-4.0], "p":[20.0], "mass":[2000.0], "force_constant":[0.01]}, rnd)
+        dyn_var.init_amplitudes({"init_type":3, "istates":[1.0, 0.0], "rep":1}, rnd)
+        dyn_var.init_density_matrix({})
+
+        ham = nHamiltonian(nst, nst, ndof)
+        ham.add_new_children(nst, nst, ndof, ntraj)
+        ham.init_all(2, 1)
+        update_Hamiltonian_variables(dyn_params, dyn_var, ham, ham, model, {}, 0)
+        update_Hamiltonian_variables(dyn_params, dyn_var, ham, ham, model, {}, 1)
+        dyn_var.update_basis_transform(ham)
+        dyn_var.update_amplitudes({"rep_tdse":1}, ham)
+        dyn_var.update_density_matrix(dyn_params, ham, 1)
+        dyn_var.init_active_states({"init_type":3, "istates":[1.0, 0.0], "rep":1}, rnd)
+
+        ham_aux = nHamiltonian(ham)
+        therm = ThermostatList()
+
+        steps = []
+        for step in range(60):
+            dt = dyn_var.dt_adapt if dyn_var.dt_adapt > 0.0 else dyn_params["dt"]
+            compute_dynamics(dyn_var, dyn_params, ham, ham_aux, model, {"timestep":step}, rnd, therm)
+            steps.append(dt)
+
+        assert steps[0] == 10.0
+        for dt in steps:
+            assert 2.0 <= dt <= 40.0
+        assert len(set(steps)) > 1
+        assert abs(dyn_var.elapsed_time - sum(steps)) < 1e-9 * sum(steps)
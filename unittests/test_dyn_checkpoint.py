@@ -0,0 +1,195 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+nst, ndof, ntraj = 2, 1, 4
+
+class tmp:
+    pass
+
+
+def model(q, params, full_id):
+    """ A 1D two-state avoided crossing: V11 = -V22 = A tanh(B x), V12 = C exp(-D x^2) """
+    A, B, C, D = 0.01, 1.6, 0.005, 1.0
+    indx = Cpp2Py(full_id)[-1]
+    x = q.get(0, indx)
+
+    obj = tmp()
+    obj.ham_dia = CMATRIX(nst, nst)
+    obj.ovlp_dia = CMATRIX(nst, nst)
+    obj.ovlp_dia.identity()
+    obj.d1ham_dia = CMATRIXList()
+    obj.dc1_dia = CMATRIXList()
+
+    v, dv = A * math.tanh(B * x), A * B / math.cosh(B * x)**2
+    c, dc = C * math.exp(-D * x * x), -2.0 * D * x * C * math.exp(-D * x * x)
+
+    obj.ham_dia.set(0, 0, v + 0.0j);  obj.ham_dia.set(1, 1, -v + 0.0j)
+    obj.ham_dia.set(0, 1, c + 0.0j);  obj.ham_dia.set(1, 0, c + 0.0j)
+
+    d1 = CMATRIX(nst, nst)
+    d1.set(0, 0, dv + 0.0j);  d1.set(1, 1, -dv + 0.0j)
+    d1.set(0, 1, dc + 0.0j);  d1.set(1, 0, dc + 0.0j)
+    obj.d1ham_dia.append(d1)
+    obj.dc1_dia.append(CMATRIX(nst, nst))
+
+    return obj
+
+
+therm_params = {"thermostat_type":"Langevin", "Temperature":300.0, "nu_therm":0.001}
+
+def dyn_params(**kw):
+    prms = {"dt":20.0, "ensemble":1, "thermostat_dofs":[0], "thermostat_params":therm_params}
+    prms.update(kw)
+    return prms
+
+
+def setup(seed, **kw):
+    """ The dynamical variables, the Hamiltonians, the random numbers and the thermostats ready for
+        compute_dynamics, set up the same way as in libra_py.dynamics.tsh.compute """
+    rnd = Random()
+    rnd.set_seed(seed)
+    prms = dyn_params(**kw)
+
+    dyn_var = dyn_variables(nst, nst, ndof, ntraj)
+    dyn_var.init_nuclear_dyn_var({"init_type":3, "q":[-4.0], "p":[20.0], "mass":[2000.0], "force_constant":[0.01]}, rnd)
+    dyn_var.init_amplitudes({"init_type":3, "istates":[1.0, 0.0], "rep":1}, rnd)
+    dyn_var.init_density_matrix({})
+
+    ham = nHamiltonian(nst, nst, ndof)
+    ham.add_new_children(nst, nst, ndof, ntraj)
+    ham.init_all(2, 1)
+
+    prms1 = dict(prms)
+    prms1.update({"ham_update_method":1, "ham_transform_method":1})
+    update_Hamiltonian_variables(prms1, dyn_var, ham, ham, model, {}, 0)
+    update_Hamiltonian_variables(prms1, dyn_var, ham, ham, model, {}, 1)
+
+    dyn_var.update_basis_transform(ham)
+    dyn_var.update_amplitudes({"rep_tdse":1}, ham)
+    dyn_var.update_density_matrix(prms, ham, 1)
+    dyn_var.init_active_states({"init_type":3, "istates":[1.0, 0.0], "rep":1}, rnd)
+
+    therm = ThermostatList()
+    for traj in range(ntraj):
+        therm.append(Thermostat(therm_params))
+        therm[traj].set_seed(seed, traj)
+        therm[traj].set_Nf_t(1)
+        therm[traj].init_nhc()
+
+    return dyn_var, ham, nHamiltonian(ham), rnd, therm, prms
+
+
+def run(dyn_var, ham, ham_aux, rnd, therm, prms, start, nsteps):
+    """ The steps with the indices start, ..., start + nsteps - 1 """
+    for step in range(start, start + nsteps):
+        compute_dynamics(dyn_var, prms, ham, ham_aux, model, {"timestep":step}, rnd, therm)
+
+
+def same_matrix(X, Y):
+    assert X.num_of_rows == Y.num_of_rows and X.num_of_cols == Y.num_of_cols
+    for i in range(X.num_of_rows):
+        for j in range(X.num_of_cols):
+            assert X.get(i, j) == Y.get(i, j)
+
+
+def same_state(a, b):
+    """ The variables of two dyn_variables objects are identical to the last bit """
+    same_matrix(a.get_coords(), b.get_coords())
+    same_matrix(a.get_momenta(), b.get_momenta())
+    same_matrix(a.get_forces(), b.get_forces())
+    same_matrix(a.get_imass(), b.get_imass())
+    same_matrix(a.get_ampl_adi(), b.get_ampl_adi())
+    same_matrix(a.get_ampl_dia(), b.get_ampl_dia())
+    for i in range(ntraj):
+        same_matrix(a.get_dm_adi(i), b.get_dm_adi(i))
+        same_matrix(a.get_proj_adi(i), b.get_proj_adi(i))
+    assert list(a.act_states) == list(b.act_states)
+    assert list(a.act_states_dia) == list(b.act_states_dia)
+    assert a.timestep == b.timestep
+
+
+def file_bytes(name):
+    with open(name, "rb") as f:
+        return f.read()
+
+
+class TestDynCheckpoint:
+
+    def test_1(self, tmp_path):
+        """ save -> load -> save: all the allocated groups, the random number stream, the thermostats
+            and the Hamiltonian are restored exactly, so the second checkpoint is the same as the first one """
+        f1, f2 = str(tmp_path / "a.chk"), str(tmp_path / "b.chk")
+
+        dyn_var, ham, ham_aux, rnd, therm, prms = setup(5)
+        run(dyn_var, ham, ham_aux, rnd, therm, prms, 0, 3)
+        for grp in [dyn_var.allocate_afssh, dyn_var.allocate_bcsh, dyn_var.allocate_dish, dyn_var.allocate_fssh2,
+                    dyn_var.allocate_shxf, dyn_var.allocate_tcnbra, dyn_var.allocate_qtsh]:
+            grp()
+        dyn_var.tcnbra_ekin = Py2Cpp_double([0.1*i for i in range(ntraj)])
+        dyn_var.elapsed_time, dyn_var.dt_adapt = 60.0, 20.0
+        dyn_var.num_el_substeps = Py2Cpp_int([1, 2, 3, 4])
+        dyn_var.save_checkpoint(f1, ham, rnd, therm)
+
+        # The target objects are set up with a different seed, so nothing matches before the load
+        dyn_var2, ham2, ham_aux2, rnd2, therm2, prms2 = setup(6)
+        dyn_var2.load_checkpoint(f1, ham2, rnd2, therm2)
+
+        for st in ["afssh", "bcsh", "dish", "fssh2", "shxf", "tcnbra", "qtsh"]:
+            assert getattr(dyn_var2, st + "_vars_status") == 1
+        assert dyn_var2.mqcxf_vars_status == 0
+        same_state(dyn_var, dyn_var2)
+        assert list(dyn_var2.tcnbra_ekin) == list(dyn_var.tcnbra_ekin)
+        assert (dyn_var2.elapsed_time, dyn_var2.dt_adapt) == (60.0, 20.0)
+        assert list(dyn_var2.num_el_substeps) == [1, 2, 3, 4]
+        same_matrix(dyn_var.get_wp_width(), dyn_var2.get_wp_width())
+        for i in range(ntraj):
+            same_matrix(ham.get_ham_adi(Py2Cpp_int([0, i])), ham2.get_ham_adi(Py2Cpp_int([0, i])))
+
+        dyn_var2.save_checkpoint(f2, ham2, rnd2, therm2)
+        assert file_bytes(f1) == file_bytes(f2)
+
+        # The random number streams continue identically
+        assert [ rnd.uniform(0.0, 1.0) for i in range(10) ] == [ rnd2.uniform(0.0, 1.0) for i in range(10) ]
+        for i in range(ntraj):
+            assert list(therm[i].s_t) == list(therm2[i].s_t)
+            assert [ therm[i].gaussian() for k in range(10) ] == [ therm2[i].gaussian() for k in range(10) ]
+
+
+    def test_2(self, tmp_path):
+        """ Only the variables: the file without the Hamiltonian, the random numbers and the thermostats """
+        f1 = str(tmp_path / "a.chk")
+        dyn_var, ham, ham_aux, rnd, therm, prms = setup(5)
+        run(dyn_var, ham, ham_aux, rnd, therm, prms, 0, 2)
+        dyn_var.save_checkpoint(f1)
+
+        dyn_var2 = dyn_variables(nst, nst, ndof, ntraj)
+        dyn_var2.load_checkpoint(f1)
+        assert dyn_var2.electronic_vars_status == 1 and dyn_var2.nuclear_vars_status == 1
+        assert dyn_var2.afssh_vars_status == 0
+        same_state(dyn_var, dyn_var2)
+
+
+    def test_3(self, tmp_path):
+        """ The dynamics restarted from the checkpoint written by compute_dynamics reproduces the uninterrupted
+            one exactly, including the hops and the Langevin noise """
+        fname = str(tmp_path / "run.chk")
+        nsteps, nrestart = 30, 12
+
+        ref = setup(17)
+        run(*ref, 0, nsteps)
+
+        # The first part writes the checkpoint after nrestart steps (the step index nrestart - 1) and goes on
+        first = setup(17, checkpoint_frequency=nrestart, checkpoint_filename=fname)
+        run(*first, 0, nrestart + 5)
+
+        dyn_var, ham, ham_aux, rnd, therm, prms = setup(99)
+        dyn_var.load_checkpoint(fname, ham, rnd, therm)
+        assert dyn_var.timestep == nrestart - 1
+        run(dyn_var, ham, ham_aux, rnd, therm, prms, nrestart, nsteps - nrestart)
+
+        same_state(ref[0], dyn_var)
+        for i in range(ntraj):
+            same_matrix(ref[1].get_ham_adi(Py2Cpp_int([0, i])), ham.get_ham_adi(Py2Cpp_int([0, i])))
@@ -0,0 +1,156 @@
+import pytest
+
+import math
+import random
+from liblibra_core import *
+
+
+nst, ndof, ntraj = 4, 3, 5
+
+
+class tmp:
+    pass
+
+
+def random_hermitian(rnd, n, scl):
+    X = CMATRIX(n, n)
+    for i in range(n):
+        X.set(i, i, scl * rnd.uniform(-1.0, 1.0) + 0.0j)
+        for j in range(i+1, n):
+            z = scl * complex(rnd.uniform(-1.0, 1.0), rnd.uniform(-1.0, 1.0))
+            X.set(i, j, z)
+            X.set(j, i, z.conjugate())
+    return X
+
+
+def random_general(rnd, n, scl):
+    X = CMATRIX(n, n)
+    for i in range(n):
+        for j in range(n):
+            X.set(i, j, scl * complex(rnd.uniform(-1.0, 1.0), rnd.uniform(-1.0, 1.0)))
+    return X
+
+
+# The fixed random parts of the model
+_rnd = random.Random(11)
+H0 = random_hermitian(_rnd, nst, 0.05)
+H1 = [ random_hermitian(_rnd, nst, 0.01) for k in range(ndof) ]
+S1 = [ random_hermitian(_rnd, nst, 0.05) for k in range(ndof) ]
+D1 = [ random_general(_rnd, nst, 0.02) for k in range(ndof) ]
+
+
+def random_model(q, params, full_id):
+    """ A random Hermitian model: H = H0 + sum_k q_k H1_k, S = I + sum_k sin(q_k) S1_k (positive definite),
+        non-zero derivative couplings. The forces are compared between the implementations, so the
+        derivatives need not be consistent with H and S """
+
+    indx = Cpp2Py(full_id)[-1]
+
+    obj = tmp()
+    obj.ham_dia = CMATRIX(H0)
+    obj.ovlp_dia = CMATRIX(nst, nst)
+    obj.ovlp_dia.identity()
+    obj.d1ham_dia = CMATRIXList()
+    obj.dc1_dia = CMATRIXList()
+
+    for k in range(ndof):
+        x = q.get(k, indx)
+        obj.ham_dia = obj.ham_dia + x * H1[k]
+        obj.ovlp_dia = obj.ovlp_dia + (0.3 * math.sin(x)) * S1[k]
+        obj.d1ham_dia.append(H1[k] + (0.5 * x) * H0)
+        obj.dc1_dia.append((1.0 + x) * D1[k])
+
+    return obj
+
+
+def make_data():
+    rnd = random.Random(7)
+    q = MATRIX(ndof, ntraj)
+    ampl = CMATRIX(nst, ntraj)
+    for i in range(ntraj):
+        for k in range(ndof):
+            q.set(k, i, rnd.uniform(-1.0, 1.0))
+        for a in range(nst):
+            ampl.set(a, i, complex(rnd.uniform(-1.0, 1.0), rnd.uniform(-1.0, 1.0)))
+    return q, ampl
+
+
+def single_ham(q, i):
+    """ The Hamiltonian of the trajectory i alone """
+    qi = MATRIX(ndof, 1)
+    for k in range(ndof):
+        qi.set(k, 0, q.get(k, i))
+
+    ham = nHamiltonian(nst, nst, ndof)
+    ham.init_all(2)
+    ham.compute_diabatic(random_model, qi, {})
+    ham.compute_adiabatic(1)
+    return ham
+
+
+def column(X, i):
+    c = CMATRIX(X.num_of_rows, 1)
+    for a in range(X.num_of_rows):
+        c.set(a, 0, X.get(a, i))
+    return c
+
+
+def compare(F, i, ref):
+    for k in range(ndof):
+        assert abs(F.get(k, i) - ref.get(k, 0).real) < 1e-10 * max(1.0, abs(ref.get(k, 0)))
+
+
+class TestEhrenfestForces:
+
+    @pytest.mark.parametrize('option', [0, 1])
+    @pytest.mark.parametrize('rep', ["dia", "adi"])
+    def test_1(self, rep, option):
+        """ lvl = 0: all the trajectories share one Hamiltonian """
+        q, ampl = make_data()
+        ham = single_ham(q, 0)
+
+        F = MATRIX(ndof, ntraj)
+        if rep=="dia":
+            ham.Ehrenfest_forces_dia(ampl, F, 0, option)
+            Fc = ham.Ehrenfest_forces_dia(ampl, 0, option)
+        else:
+            ham.Ehrenfest_forces_adi(ampl, F, 0, option)
+            Fc = ham.Ehrenfest_forces_adi(ampl, 0, option)
+
+        for i in range(ntraj):
+            c = column(ampl, i)
+            if rep=="dia":
+                ref = ham.Ehrenfest_forces_dia_unit(c, option)
+            else:
+                ref = ham.Ehrenfest_forces_adi_unit(c, option)
+            compare(F, i, ref)
+            compare(Fc.real(), i, ref)
+
+
+    @pytest.mark.parametrize('option', [0, 1])
+    @pytest.mark.parametrize('rep', ["dia", "adi"])
+    def test_2(self, rep, option):
+        """ lvl = 1: one child Hamiltonian per trajectory """
+        q, ampl = make_data()
+
+        ham = nHamiltonian(nst, nst, ndof)
+        ham.add_new_children(nst, nst, ndof, ntraj)
+        ham.init_all(2, 1)
+        ham.compute_diabatic(random_model, q, {}, 1)
+        ham.compute_adiabatic(1, 1)
+
+        F = MATRIX(ndof, ntraj)
+        if rep=="dia":
+            ham.Ehrenfest_forces_dia(ampl, F, 1, option)
+        else:
+            ham.Ehrenfest_forces_adi(ampl, F, 1, option)
+
+        for i in range(ntraj):
+            hi = single_ham(q, i)
+            c = column(ampl, i)
+            if rep=="dia":
+                ref = hi.Ehrenfest_forces_dia_unit(c, option)
+            else:
+                ref = hi.Ehrenfest_forces_adi_unit(c, option)
+            compare(F, i, ref)
+
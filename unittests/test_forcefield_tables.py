@@ -0,0 +1,198 @@
+import pytest
+
+import random
+from liblibra_core import *
+
+
+class tmp:
+    pass
+
+
+def bond(t1, t2, **kw):
+    x = tmp()
+    x.Atom1_ff_type, x.Atom2_ff_type = t1, t2
+    for k in kw:
+        setattr(x, k, kw[k])
+    r = Bond_Record()
+    r.set(x)
+    return r
+
+
+def int_bond(t1, t2, **kw):
+    x = tmp()
+    x.Atom1_ff_int_type, x.Atom2_ff_int_type = t1, t2
+    for k in kw:
+        setattr(x, k, kw[k])
+    r = Bond_Record()
+    r.set(x)
+    return r
+
+
+def angle(t1, t2, t3, k):
+    x = tmp()
+    x.Atom1_ff_type, x.Atom2_ff_type, x.Atom3_ff_type = t1, t2, t3
+    x.Angle_k_angle = k
+    r = Angle_Record()
+    r.set(x)
+    return r
+
+
+def dihedral(t1, t2, t3, t4, v):
+    x = tmp()
+    x.Atom1_ff_type, x.Atom2_ff_type, x.Atom3_ff_type, x.Atom4_ff_type = t1, t2, t3, t4
+    x.Dihedral_vphi = v
+    r = Dihedral_Record()
+    r.set(x)
+    return r
+
+
+def atom(t):
+    x = tmp()
+    x.Atom_ff_type = t
+    r = Atom_Record()
+    r.set(x)
+    return r
+
+
+class TestForceFieldTables:
+
+    def test_1(self):
+        """ Add_Bond_Record: the duplicates (in any order, with the compatible type index) are merged, not appended """
+        ff = ForceField()
+        assert ff.Add_Bond_Record(bond("c", "h")) == 1
+        assert ff.Add_Bond_Record(bond("h", "c", Bond_k_bond=0.3)) == 0
+        assert len(ff.Bond_Records) == 1
+        assert ff.Bond_Records[0].Bond_k_bond == 0.3
+
+        assert ff.Add_Bond_Record(bond("c", "c", Bond_type_index=1)) == 1
+        assert ff.Add_Bond_Record(bond("c", "c", Bond_type_index=2)) == 1
+        assert ff.Add_Bond_Record(bond("c", "c", Bond_type_index=2, Bond_r_eq=2.5)) == 0
+        assert len(ff.Bond_Records) == 3
+        assert ff.Bond_Records[2].Bond_r_eq == 2.5
+
+        # Integer types
+        assert ff.Add_Bond_Record(int_bond(3, 5)) == 1
+        assert ff.Add_Bond_Record(int_bond(5, 3, Bond_k_bond=0.1)) == 0
+        assert len(ff.Bond_Records) == 4
+
+
+    @pytest.mark.parametrize('seed', [1, 2, 3])
+    def test_2(self, seed):
+        """ Add_Bond_Record over many random records vs. the linear-search rules """
+        rnd = random.Random(seed)
+        types = ["c", "h", "o", "n", "ca", "X", "*"]
+        ff = ForceField()
+        ref = []   # (t1, t2, type index or None)
+
+        for n in range(300):
+            t1, t2 = rnd.choice(types), rnd.choice(types)
+            bt = rnd.choice([None, 1, 2])
+            kw = {} if bt is None else {"Bond_type_index": bt}
+
+            bt0 = 0 if bt is None else bt
+            match = [ i for i, (a, b, c) in enumerate(ref)
+                      if ((a==t1 and b==t2) or (a==t2 and b==t1)) and (c is None or c==bt0) ]
+            expected = 0 if len(match)>0 else 1
+            if expected==1:
+                ref.append((t1, t2, bt))
+            else:
+                for i in match:   # the merge fills in the undefined type index
+                    if ref[i][2] is None and bt is not None:
+                        ref[i] = (ref[i][0], ref[i][1], bt)
+
+            assert ff.Add_Bond_Record(bond(t1, t2, **kw)) == expected
+            assert len(ff.Bond_Records) == len(ref)
+
+
+    def test_3(self):
+        """ The compiled lookups: both orders, the records added after a lookup, and in-place modifications """
+        ff = ForceField()
+        ff.Add_Atom_Record(atom("c"))
+        ff.Add_Atom_Record(atom("h"))
+        ff.Add_Bond_Record(bond("c", "h"))
+
+        assert ff.Atom_Record_Index("h") == 1
+        assert ff.Atom_Record_Index("o") == -1
+        assert ff.Bond_Record_Index("c", "h") == 0
+        assert ff.Bond_Record_Index("h", "c") == 0
+        assert ff.Bond_Record_Index("c", "o") == -1
+
+        # Appended after the tables are compiled
+        ff.Add_Atom_Record(atom("o"))
+        ff.Add_Bond_Record(bond("o", "c"))
+        assert ff.Atom_Record_Index("o") == 2
+        assert ff.Bond_Record_Index("c", "o") == 1
+
+        # Modified in place from Python: the tables have to be recompiled explicitly
+        recs = ff.Bond_Records
+        recs[1].Atom1_ff_type = "n"
+        ff.Bond_Records = recs
+        ff.compile_tables()
+        assert ff.Bond_Record_Index("c", "o") == -1
+        assert ff.Bond_Record_Index("c", "n") == 1
+
+
+    def test_4(self):
+        """ The type equivalences: used only when there is no record for the type itself """
+        ff = ForceField()
+        ff.Add_Bond_Record(bond("c", "h"))
+        ff.Add_Angle_Record(angle("h", "c", "h", 0.1))
+        ff.add_type_equivalence("ca", "c")
+
+        assert ff.Bond_Record_Index("ca", "h") == 0
+        assert ff.Angle_Record_Index("h", "ca", "h") == 0
+        assert ff.Bond_Record_Index("cb", "h") == -1
+
+        ff.Add_Bond_Record(bond("h", "ca"))
+        assert ff.Bond_Record_Index("ca", "h") == 1
+        assert ff.Bond_Record_Index("c", "h") == 0
+
+
+    def test_5(self):
+        """ The wildcards: the exact and equivalent types are preferred, then the X terminal atoms """
+        ff = ForceField()
+        ff.Add_Angle_Record(angle("X", "c", "X", 0.1))     # 0
+        ff.Add_Angle_Record(angle("h", "c", "X", 0.2))     # 1
+        ff.Add_Angle_Record(angle("h", "c", "h", 0.3))     # 2
+        ff.Add_Angle_Record(angle("o", "n", "o", 0.4))     # 3
+        ff.add_type_equivalence("hc", "h")
+
+        assert ff.Angle_Record_Index("h", "c", "h") == 2
+        assert ff.Angle_Record_Index("hc", "c", "hc") == 2     # the equivalence beats the wildcards
+        assert ff.Angle_Record_Index("o", "c", "h") == 1
+        assert ff.Angle_Record_Index("h", "c", "o") == 1
+        assert ff.Angle_Record_Index("o", "c", "o") == 0
+        assert ff.Angle_Record_Index("o", "n", "h") == -1
+
+        ff.Add_Dihedral_Record(dihedral("X", "c", "c", "X", 1.0))    # 0
+        ff.Add_Dihedral_Record(dihedral("h", "c", "c", "h", 2.0))    # 1
+        ff.Add_Dihedral_Record(dihedral("X", "c", "n", "o", 3.0))    # 2
+
+        assert ff.Dihedral_Record_Index("h", "c", "c", "h") == 1
+        assert ff.Dihedral_Record_Index("hc", "c", "c", "h") == 1
+        assert ff.Dihedral_Record_Index("h", "c", "c", "o") == 0
+        assert ff.Dihedral_Record_Index("o", "n", "c", "h") == 2      # reversed
+        assert ff.Dihedral_Record_Index("h", "c", "n", "h") == -1
+
+
+    def test_6(self):
+        """ The duplicate checks of the loaders' Add_Angle_Record/Add_Dihedral_Record, and the integer types of the atoms """
+        ff = ForceField()
+        x = tmp()
+        x.Atom_ff_type, x.Atom_ff_int_type = "c", 7
+        a = Atom_Record()
+        a.set(x)
+        ff.Add_Atom_Record(a)
+
+        assert ff.Add_Angle_Record(angle("h", "c", "o", 0.1)) == 1
+        assert ff.Add_Angle_Record(angle("o", "c", "h", 0.1)) == 0
+        assert ff.Add_Angle_Record(angle("h", "c", "c", 0.1)) == 1
+        assert len(ff.Angle_Records) == 2
+        assert ff.Angle_Records[1].Atom2_ff_int_type == 7
+        assert ff.Angle_Records[1].Atom3_ff_int_type == 7
+
+        assert ff.Add_Dihedral_Record(dihedral("h", "c", "c", "o", 1.0)) == 1
+        assert ff.Add_Dihedral_Record(dihedral("o", "c", "c", "h", 1.0)) == 0
+        assert ff.Add_Dihedral_Record(dihedral("h", "c", "c", "h", 1.0)) == 1
+        assert len(ff.Dihedral_Records) == 2
+
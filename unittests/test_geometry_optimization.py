@@ -0,0 +1,161 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+amu = 1822.888
+
+class tmp:
+    pass
+
+
+def make_universe():
+    U = Universe()
+    for name, m in [("C", 12.011), ("Ar", 39.948)]:
+        e = tmp()
+        e.Elt_name = name
+        e.Elt_mass = m * amu
+        rec = Element()
+        rec.set(e)
+        U.Add_Element_To_Periodic_Table(rec)
+    return U
+
+
+def record(cls, **kw):
+    x = tmp()
+    for k in kw:
+        setattr(x, k, kw[k])
+    r = cls()
+    r.set(x)
+    return r
+
+
+def make_system(U, elt, coords):
+    syst = System()
+    for r in coords:
+        syst.CREATE_ATOM( Atom(U, {"Atom_element":elt, "Atom_ff_type":elt, "Atom_cm_x":r[0], "Atom_cm_y":r[1], "Atom_cm_z":r[2]}) )
+    return syst
+
+
+def make_hamiltonian(syst, ff):
+    n = syst.Number_of_atoms
+    lst = list(range(1, n+1))
+    ham = Hamiltonian_Atomistic(1, 3*n)
+    ham.set_Hamiltonian_type("MM")
+    ham.set_interactions_for_atoms(syst, lst, lst, ff, 0, 0)
+    ham.set_system(syst)
+    return ham, Nuclear(3*n), Electronic(1, 0)
+
+
+r_eq, k_bond = 2.9, 0.3
+
+def chain():
+    """ A bent C-C-C chain with two harmonic bonds (no angle term): the minima have both bonds at r_eq """
+    U = make_universe()
+    syst = make_system(U, "C", [(0.0, 0.0, 0.0), (2.5, 0.0, 0.0), (2.5 + 3.3*math.cos(1.0), 3.3*math.sin(1.0), 0.2)])
+    syst.CREATE_BONDS([1, 2, 3], {"C":4}, 0.4*1.889725989, 0)
+    syst.init_fragments()
+
+    ff = ForceField({"bond_functional":"Harmonic"})
+    ff.Add_Atom_Record(record(Atom_Record, Atom_ff_type="C"))
+    ff.Add_Bond_Record(record(Bond_Record, Atom1_ff_type="C", Atom2_ff_type="C", Bond_r_eq=r_eq, Bond_k_bond=k_bond))
+
+    ham, mol, el = make_hamiltonian(syst, ff)
+    return syst, ham, mol, el
+
+
+def distances(syst, pairs):
+    q = Py2Cpp_double([0.0]*(3*syst.Number_of_atoms))
+    syst.extract_atomic_q(q)
+    return [ math.sqrt(sum((q[3*a+c] - q[3*b+c])**2 for c in range(3))) for (a, b) in pairs ]
+
+
+def lj_crystal(a):
+    """ The conventional cubic cell of an fcc Lennard-Jones crystal with the lattice constant a """
+    U = make_universe()
+    syst = make_system(U, "Ar", [(0.0, 0.0, 0.0), (0.5*a, 0.5*a, 0.0), (0.5*a, 0.0, 0.5*a), (0.0, 0.5*a, 0.5*a)])
+    syst.init_fragments()
+    syst.init_box(a, a, a)
+
+    ff = ForceField({"mb_functional":"vdw_LJ1", "R_vdw_on":12.0, "R_vdw_off":14.0,
+                     "sigma_comb_rule":"ARITHMETIC", "epsilon_comb_rule":"GEOMETRIC"})
+    ff.Add_Atom_Record(record(Atom_Record, Atom_ff_type="Ar", Atom_sigma=6.4, Atom_epsilon=3.8e-4))
+
+    ham, mol, el = make_hamiltonian(syst, ff)
+    return syst, ham, mol, el
+
+
+class TestGeometryOptimization:
+
+    @pytest.mark.parametrize('method', ["LBFGS", "FIRE", "CG"])
+    def test_1(self, method):
+        """ All the methods converge to the minimum of the harmonic chain, the System gets the optimized geometry """
+        syst, ham, mol, el = chain()
+
+        prms = GeomOpt({"method":method, "max_steps":5000, "force_tol":1e-6, "energy_tol":1e-12})
+        E = optimize_geometry(syst, mol, el, ham, prms)
+
+        assert prms.is_converged == 1
+        assert prms.max_force < 1e-6
+        assert abs(E) < 1e-10
+        assert prms.energies[-1] <= prms.energies[0]
+        for d in distances(syst, [(0, 1), (1, 2)]):
+            assert abs(d - r_eq) < 1e-5
+
+
+    @pytest.mark.parametrize('method', ["LBFGS", "CG"])
+    def test_2(self, method):
+        """ The line-search methods never increase the energy """
+        syst, ham, mol, el = chain()
+
+        prms = GeomOpt({"method":method, "max_steps":5000, "force_tol":1e-6, "energy_tol":1e-12})
+        optimize_geometry(syst, mol, el, ham, prms)
+
+        for i in range(1, len(prms.energies)):
+            assert prms.energies[i] <= prms.energies[i-1] + 1e-14
+
+
+    def test_3(self):
+        """ FIRE from rest: the first step is a downhill one with the starting time step, not an uphill
+            one with the halved time step: the atom 0 moves by dt_start^2 * |f| """
+        syst, ham, mol, el = chain()
+        f0 = 2.0 * k_bond * abs(2.5 - r_eq)   # the initial force on the atom 0, along the 0-1 bond
+
+        prms = GeomOpt({"method":"FIRE", "max_steps":1, "force_tol":1e-6, "energy_tol":1e-12, "fire_dt_start":0.1})
+        optimize_geometry(syst, mol, el, ham, prms)
+
+        assert prms.n_steps == 1
+        assert prms.energies[1] < prms.energies[0]
+
+        q = Py2Cpp_double([0.0]*9)
+        syst.extract_atomic_q(q)
+        d0 = math.sqrt(q[0]**2 + q[1]**2 + q[2]**2)
+        assert abs(d0 - 0.1**2 * f0) < 1e-10
+
+
+    @pytest.mark.parametrize('method', ["LBFGS", "FIRE"])
+    def test_4(self, method):
+        """ The cell relaxation of an LJ crystal: the stress balances the target pressure at the end,
+            and a higher pressure gives a smaller cell """
+        volumes = []
+        for P in [0.0, 1e-5]:
+            syst, ham, mol, el = lj_crystal(11.0)
+
+            prms = GeomOpt({"method":method, "max_steps":5000, "force_tol":1e-6, "energy_tol":1e-12,
+                            "relax_cell":1, "target_pressure":P})
+            optimize_geometry(syst, mol, el, ham, prms)
+            assert prms.is_converged == 1
+            assert prms.energies[-1] < prms.energies[0]
+
+            V = syst.volume()
+            W = ham.get_stress("at")
+            for w in [W.xx, W.yy, W.zz]:
+                assert abs(w - P*V) < 1e-4
+            for w in [W.xy, W.xz, W.yz]:
+                assert abs(w) < 1e-4
+
+            volumes.append(V)
+
+        assert volumes[1] < volumes[0]
+
@@ -0,0 +1,97 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+kb = 3.166811429e-6   # Hartree/K
+
+
+def moments(samples, i):
+    """ The mean, the variance and the 4-th central moment of the i-th DOF """
+    x = [ s.get(i, 0) for s in samples ]
+    n = len(x)
+    m = sum(x) / n
+    var = sum((a - m)**2 for a in x) / n
+    m4 = sum((a - m)**4 for a in x) / n
+    return m, var, m4
+
+
+def values(samples):
+    return [ [ s.get(i, 0) for i in range(s.num_of_rows) ] for s in samples ]
+
+
+def gaussian_target():
+    """ p(x) ~ exp(-0.5 k (x - x0)^2 / kT): the mean x0 = 0.5, the variance kT / k = 0.3167 """
+    return mc_target({"target_type":1, "force_constants":[0.01], "x0":[0.5], "Temperature":1000.0})
+
+
+class TestMCSampler:
+
+    @pytest.mark.parametrize('temperatures', [ [1.0], [1.0, 2.0, 4.0] ])
+    def test_1(self, temperatures):
+        """ 1D Gaussian: the mean, the variance and the kurtosis of the samples, with and without the tempering """
+        target = gaussian_target()
+        sampler = mc_sampler({"num_chains":8, "sample_size":10000, "start_sampling":1000, "thinning":3,
+                              "gau_var":1.2, "temperatures":temperatures, "rng_seed":11})
+
+        samples = sampler.run(target, MATRIX(1, 1))
+        assert len(samples) == 8 * 10000
+
+        var0 = kb * 1000.0 / 0.01
+        m, var, m4 = moments(samples, 0)
+        assert abs(m - 0.5) < 0.02
+        assert abs(var / var0 - 1.0) < 0.03
+        assert abs(m4 / (3.0 * var0**2) - 1.0) < 0.08
+
+        for a in sampler.acceptance:
+            assert 0.2 < a < 0.9
+        if len(temperatures) > 1:
+            for a in sampler.swap_acceptance:
+                assert a > 0.1
+
+
+    def test_2(self):
+        """ Harmonic Wigner distribution: the widths of q and p are 1/(2 m w tanh(w/2kT)) and m w/(2 tanh(w/2kT)),
+            which is neither the classical (kT/(m w^2)) nor the zero-temperature (1/(2 m w)) value here """
+        w, m = 0.01, 100.0          # m w = 1
+        T = 0.5 * w / kb            # w / 2kT = 1
+        th = math.tanh(1.0)
+
+        target = mc_target({"target_type":2, "frequencies":[w], "masses":[m], "Temperature":T})
+        sampler = mc_sampler({"num_chains":8, "sample_size":10000, "start_sampling":1000, "thinning":3,
+                              "gau_var":1.5, "rng_seed":5})
+        samples = sampler.run(target, MATRIX(2, 1))
+
+        mq, var_q, m4 = moments(samples, 0)
+        mp, var_p, m4 = moments(samples, 1)
+
+        assert abs(mq) < 0.03 and abs(mp) < 0.03
+        assert abs(var_q / (1.0 / (2.0 * m * w * th)) - 1.0) < 0.03
+        assert abs(var_p / (m * w / (2.0 * th)) - 1.0) < 0.03
+        assert abs(var_q - kb * T / (m * w * w)) > 0.1      # 0.657 vs. the classical 0.5
+
+
+    def test_3(self):
+        """ A fixed seed gives the same samples, also with a different number of threads; another seed does not """
+        target = gaussian_target()
+        prms = {"num_chains":6, "sample_size":200, "start_sampling":100, "thinning":2, "gau_var":1.0,
+                "temperatures":[1.0, 1.5], "is_adaptive":1, "adaptation_frequency":20, "rng_seed":21}
+
+        ref = values(mc_sampler(prms).run(target, MATRIX(1, 1)))
+
+        for nthreads in [1, 2, 0]:
+            prms["num_threads"] = nthreads
+            assert values(mc_sampler(prms).run(target, MATRIX(1, 1))) == ref
+
+        prms["rng_seed"] = 22
+        assert values(mc_sampler(prms).run(target, MATRIX(1, 1))) != ref
+
+
+    def test_4(self):
+        """ The unseeded samplers give different streams """
+        target = gaussian_target()
+        prms = {"num_chains":2, "sample_size":50, "start_sampling":10, "gau_var":1.0}
+        s1 = values(mc_sampler(prms).run(target, MATRIX(1, 1)))
+        s2 = values(mc_sampler(prms).run(target, MATRIX(1, 1)))
+        assert s1 != s2
@@ -0,0 +1,162 @@
+import pytest
+
+import os
+import sys
+import json
+import subprocess
+from liblibra_core import *
+
+
+amu = 1822.888
+
+class tmp:
+    pass
+
+
+def record(cls, **kw):
+    x = tmp()
+    for k in kw:
+        setattr(x, k, kw[k])
+    r = cls()
+    r.set(x)
+    return r
+
+
+nfrag = 6
+
+def make_system():
+    """ 6 rigid, non-linear 3-atom fragments along x. The fragments are held together by the harmonic
+        springs from the atom 1 of each fragment to the atom 0 of the next one, so they both translate and rotate """
+    U = Universe()
+    U.Add_Element_To_Periodic_Table(record(Element, Elt_name="C", Elt_mass=12.011 * amu))
+
+    syst = System()
+    for f in range(nfrag):
+        s = 1.0 + 0.05 * f
+        for dx, dy, dz in [ (0.0, 0.0, 0.0), (1.8*s, 0.4, 0.1*f), (0.3, 1.7*s, -0.6) ]:
+            syst.CREATE_ATOM( Atom(U, {"Atom_element":"C", "Atom_ff_type":"C",
+                                       "Atom_cm_x":5.0*f + dx, "Atom_cm_y":0.3*(f % 2) + dy, "Atom_cm_z":dz}) )
+
+    for f in range(nfrag-1):
+        syst.LINK_ATOMS(3*f + 2, 3*f + 4)       # the atom IDs start at 1
+    for f in range(nfrag):
+        syst.GROUP_ATOMS([3*f + 1, 3*f + 2, 3*f + 3], 3*f + 1)
+    syst.init_fragments()
+
+    ff = ForceField({"bond_functional":"Harmonic"})
+    ff.Add_Atom_Record(record(Atom_Record, Atom_ff_type="C"))
+    ff.Add_Bond_Record(record(Bond_Record, Atom1_ff_type="C", Atom2_ff_type="C", Bond_r_eq=2.9, Bond_k_bond=0.3))
+
+    n = syst.Number_of_atoms
+    lst = list(range(1, n+1))
+    ham = Hamiltonian_Atomistic(1, 3*n)
+    ham.set_Hamiltonian_type("MM")
+    ham.set_interactions_for_atoms(syst, lst, lst, ff, 0, 0)
+    ham.set_system(syst)
+
+    mol = Nuclear(3*n)
+    syst.extract_atomic_q(mol.q)
+    syst.extract_atomic_mass(mol.mass)
+
+    return syst, ham, mol, Electronic(1, 0)
+
+
+def run_md(integrator, ensemble, filename):
+    """ A short MD run, the atomic positions, the fragment momenta and the energies are written to the file
+        with all the digits """
+    syst, ham, mol, el = make_system()
+
+    rnd = Random()
+    rnd.set_seed(17)
+    syst.init_fragment_velocities(300.0, rnd)
+
+    md = MD({"integrator":integrator, "ensemble":ensemble, "dt":20.0, "max_step":40, "terec_exp_size":20})
+    therm = Thermostat({"thermostat_type":"Nose-Hoover", "NHC_size":2, "nu_therm":0.001, "Q":100.0, "Temperature":300.0})
+
+    st = State()
+    st.set_system(syst)
+    st.set_md(md)
+    if ensemble == "NVT":
+        st.set_thermostat(therm)
+
+    st.init_md(mol, el, ham, rnd)
+    st.run_md(mol, el, ham)
+
+    q = Py2Cpp_double([0.0]*(3*syst.Number_of_atoms))
+    syst.extract_atomic_q(q)
+    res = { "q": [ repr(x) for x in q ], "E_kin": repr(st.E_kin), "E_pot": repr(st.E_pot), "rb": [] }
+    for f in range(syst.Number_of_fragments):
+        rb = syst.Fragments[f].Group_RB
+        res["rb"].append([ repr(v) for v in [rb.rb_p.x, rb.rb_p.y, rb.rb_p.z, rb.rb_L.x, rb.rb_L.y, rb.rb_L.z] ])
+
+    with open(filename, "w") as f:
+        json.dump(res, f)
+
+
+def run_md_with_threads(nthreads, integrator, ensemble, tmp_path):
+    """ Runs `run_md` in a separate process with the given number of OpenMP threads """
+    filename = str(tmp_path / ("md_%s_%s_%i.json" % (integrator, ensemble, nthreads)))
+    env = dict(os.environ)
+    env["OMP_NUM_THREADS"] = str(nthreads)
+    env["PYTHONPATH"] = os.pathsep.join(sys.path)
+
+    subprocess.run([sys.executable, os.path.abspath(__file__), integrator, ensemble, filename],
+                   env=env, check=True, stdout=subprocess.DEVNULL)
+    with open(filename) as f:
+        return json.load(f)
+
+
+class TestMDFragments:
+
+    def test_1(self):
+        """ update_atoms_for_fragments gives the same atomic positions as update_atoms_for_fragment
+            called for each fragment in turn, bit-for-bit """
+        syst, ham, mol, el = make_system()
+        n = syst.Number_of_atoms
+
+        for f in range(nfrag):
+            syst.ROTATE_FRAGMENT(20.0 + 15.0*f, VECTOR(1.0, -0.5*f, 0.7), 3*f + 1)    # the fragment IDs
+
+        q0 = Py2Cpp_double([0.0]*(3*n))
+        syst.extract_atomic_q(q0)
+
+        zero = Py2Cpp_double([0.0]*(3*n))
+        syst.set_atomic_q(zero)
+        for f in range(nfrag):
+            syst.update_atoms_for_fragment(f)
+        q_serial = Py2Cpp_double([0.0]*(3*n))
+        syst.extract_atomic_q(q_serial)
+
+        syst.set_atomic_q(zero)
+        syst.update_atoms_for_fragments()
+        q_parallel = Py2Cpp_double([0.0]*(3*n))
+        syst.extract_atomic_q(q_parallel)
+
+        assert list(q_parallel) == list(q_serial)
+        for a, b in zip(q_parallel, q0):
+            assert abs(a - b) < 1e-10
+
+
+    @pytest.mark.parametrize('integrator', ["Jacobi", "DLML", "Terec", "NO_SQUISH"])
+    @pytest.mark.parametrize('ensemble', ["NVE", "NVT"])
+    def test_2(self, integrator, ensemble, tmp_path):
+        """ The OpenMP kicks and drifts of the fragments (kick_fragments/drift_fragments) and the atoms update
+            give the same trajectory as the serial (1 thread) run, bit-for-bit. The Nose-Hoover thermostat
+            does not use the reduced kinetic energies, so the NVT runs are also identical """
+        ref = run_md_with_threads(1, integrator, ensemble, tmp_path)
+
+        # The fragments do move
+        syst, ham, mol, el = make_system()
+        assert max(abs(float(a) - b) for a, b in zip(ref["q"], mol.q)) > 1e-3
+
+        for nthreads in [2, 4]:
+            res = run_md_with_threads(nthreads, integrator, ensemble, tmp_path)
+            assert res["q"] == ref["q"]
+            assert res["rb"] == ref["rb"]
+            assert res["E_pot"] == ref["E_pot"]
+            assert abs(float(res["E_kin"]) - float(ref["E_kin"])) <= 1e-14 * abs(float(ref["E_kin"]))
+
+
+
+if __name__ == "__main__":
+    run_md(sys.argv[1], sys.argv[2], sys.argv[3])
@@ -0,0 +1,176 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+def lvc_params():
+    """ 3 states, 2 modes: diagonal and off-diagonal linear terms, diagonal and bilinear quadratic terms """
+
+    nst, ndof = 3, 2
+
+    E0 = MATRIX(nst, nst)
+    E0.set(0,0, 0.00);  E0.set(1,1, 0.02);  E0.set(2,2, 0.05)
+    E0.set(0,1, 0.01);  E0.set(1,0, 0.01)
+    E0.set(1,2, 0.004); E0.set(2,1, 0.004)
+
+    omega = Py2Cpp_double([0.005, 0.012])
+    mass = Py2Cpp_double([1.0, 2000.0])
+
+    lin = [ [0, 0, 0,  0.003], [1, 1, 0, -0.002], [2, 2, 1, 0.001], [0, 1, 1, 0.0015], [1, 2, 0, -0.0007] ]
+    quad = [ [0, 0, 0, 0,  0.0004], [1, 1, 0, 1, -0.0002], [0, 2, 1, 1, 0.0001], [1, 2, 0, 1, 0.0003] ]
+
+    lin_terms = MATRIX(len(lin), 4)
+    for t in range(len(lin)):
+        for c in range(4):
+            lin_terms.set(t, c, lin[t][c])
+
+    quad_terms = MATRIX(len(quad), 5)
+    for t in range(len(quad)):
+        for c in range(5):
+            quad_terms.set(t, c, quad[t][c])
+
+    return nst, ndof, set_params_LVC(nst, ndof, E0, omega, mass, lin_terms, quad_terms)
+
+
+def spin_boson_params():
+    return 2, 4, set_params_spin_boson(0.01, 0.005, 4, 0, 0.1, 0.01)
+
+
+def holstein_params():
+    return 4, 4, set_params_Holstein(4, 0.0, 0.01, 0.004, 0.002, 0.0005, 1)
+
+
+def evaluate(nst, ndof, params, q):
+    Hdia = CMATRIX(nst, nst)
+    Sdia = CMATRIX(nst, nst)
+    d1ham_dia = CMATRIXList()
+    dc1_dia = CMATRIXList()
+    for k in range(ndof):
+        d1ham_dia.append(CMATRIX(nst, nst))
+        dc1_dia.append(CMATRIX(nst, nst))
+
+    model_LVC(Hdia, Sdia, d1ham_dia, dc1_dia, Py2Cpp_double(q), params)
+
+    return Hdia, Sdia, d1ham_dia, dc1_dia
+
+
+models = [ lvc_params, spin_boson_params, holstein_params ]
+points = [ [0.0, 0.0, 0.0, 0.0], [0.3, -0.7, 1.1, 0.2], [-1.5, 0.4, -0.2, 2.0] ]
+
+
+class TestModelLVC:
+
+    @pytest.mark.parametrize('model', models)
+    @pytest.mark.parametrize('q0', points)
+    def test_1(self, model, q0):
+        """ Hermitian H, unit overlap, zero diabatic derivative couplings """
+        nst, ndof, params = model()
+        Hdia, Sdia, d1ham_dia, dc1_dia = evaluate(nst, ndof, params, q0[:ndof])
+
+        for i in range(nst):
+            for j in range(nst):
+                assert abs(Hdia.get(i, j) - Hdia.get(j, i).conjugate()) < 1e-14
+                assert abs(Sdia.get(i, j) - (1.0 if i==j else 0.0)) < 1e-14
+                for k in range(ndof):
+                    assert abs(dc1_dia[k].get(i, j)) < 1e-14
+
+
+    @pytest.mark.parametrize('model', models)
+    @pytest.mark.parametrize('q0', points)
+    def test_2(self, model, q0):
+        """ The analytic derivatives of the diabatic Hamiltonian vs. the central finite differences """
+        nst, ndof, params = model()
+        q = q0[:ndof]
+        Hdia, Sdia, d1ham_dia, dc1_dia = evaluate(nst, ndof, params, q)
+
+        h = 1e-4
+        for k in range(ndof):
+            qp = list(q);  qp[k] += h
+            qm = list(q);  qm[k] -= h
+            Hp = evaluate(nst, ndof, params, qp)[0]
+            Hm = evaluate(nst, ndof, params, qm)[0]
+
+            for i in range(nst):
+                for j in range(nst):
+                    fd = (Hp.get(i, j) - Hm.get(i, j)) / (2.0*h)
+                    # The model is at most quadratic in q, so the central difference is exact up to round-off
+                    assert abs(d1ham_dia[k].get(i, j) - fd) < 1e-8 * max(1.0, abs(fd))
+
+
+    def test_3(self):
+        """ The LVC/QVC Hamiltonian at a given point vs. the explicit formula """
+        nst, ndof, params = lvc_params()
+        q = [0.3, -0.7]
+        Hdia = evaluate(nst, ndof, params, q)[0]
+
+        V0 = 0.5 * 1.0 * 0.005**2 * q[0]**2 + 0.5 * 2000.0 * 0.012**2 * q[1]**2
+        H00 = 0.00 + V0 + 0.003*q[0] + 0.0004*q[0]*q[0]
+        H11 = 0.02 + V0 - 0.002*q[0] - 0.0002*q[0]*q[1]
+        H22 = 0.05 + V0 + 0.001*q[1]
+        H01 = 0.01 + 0.0015*q[1]
+        H02 = 0.0001*q[1]*q[1]
+        H12 = 0.004 - 0.0007*q[0] + 0.0003*q[0]*q[1]
+
+        ref = [[H00, H01, H02], [H01, H11, H12], [H02, H12, H22]]
+        for i in range(nst):
+            for j in range(nst):
+                assert abs(Hdia.get(i, j) - ref[i][j]) < 1e-14
+
+
+    @pytest.mark.parametrize('model', models)
+    def test_4(self, model):
+        """ The derivatives w.r.t. the DOFs beyond the model ones are zeroed, not left from the previous call """
+        nst, ndof, params = model()
+
+        Hdia, Sdia = CMATRIX(nst, nst), CMATRIX(nst, nst)
+        d1ham_dia, dc1_dia = CMATRIXList(), CMATRIXList()
+        for k in range(ndof + 2):
+            X = CMATRIX(nst, nst)
+            for i in range(nst):
+                for j in range(nst):
+                    X.set(i, j, 1.0 + 2.0j)
+            d1ham_dia.append(CMATRIX(X))
+            dc1_dia.append(CMATRIX(X))
+
+        model_LVC(Hdia, Sdia, d1ham_dia, dc1_dia, Py2Cpp_double([0.3]*(ndof + 2)), params)
+
+        for k in range(ndof, ndof + 2):
+            for i in range(nst):
+                for j in range(nst):
+                    assert d1ham_dia[k].get(i, j) == 0.0j
+                    assert dc1_dia[k].get(i, j) == 0.0j
+
+
+    @pytest.mark.parametrize('model', models)
+    def test_5(self, model):
+        """ The batched compute_diabatic over the children gives the same results as the calls for
+            each trajectory separately """
+        nst, ndof, params = model()
+        ntraj = 5
+
+        q = MATRIX(ndof, ntraj)
+        for k in range(ndof):
+            for traj in range(ntraj):
+                q.set(k, traj, 0.4 * math.sin(1.0 + k + 2.3 * traj))
+
+        ham = nHamiltonian(nst, nst, ndof)
+        ham.add_new_children(nst, nst, ndof, ntraj)
+        ham.init_all(1, 1)
+        ham.compute_diabatic(200, q, params, 1)
+
+        for traj in range(ntraj):
+            ref = nHamiltonian(nst, nst, ndof)
+            ref.init_all(1)
+            ref.compute_diabatic(200, Py2Cpp_double([ q.get(k, traj) for k in range(ndof) ]), params, 0)
+
+            id_ = Py2Cpp_int([0, traj])
+            pairs = [ (ham.get_ham_dia(id_), ref.get_ham_dia()), (ham.get_ovlp_dia(id_), ref.get_ovlp_dia()) ]
+            for k in range(ndof):
+                pairs.append( (ham.get_d1ham_dia(k, id_), ref.get_d1ham_dia(k)) )
+                pairs.append( (ham.get_dc1_dia(k, id_), ref.get_dc1_dia(k)) )
+
+            for X, Y in pairs:
+                for i in range(nst):
+                    for j in range(nst):
+                        assert X.get(i, j) == Y.get(i, j)
@@ -0,0 +1,117 @@
+import pytest
+
+from liblibra_core import *
+
+
+nst, dt = 3, 2.0
+
+# The constant real anti-symmetric generator: nac = <psi_i|d/dt psi_j> = A_ij
+A_elts = {(0, 1): 0.01, (1, 2): 0.005, (0, 2): 0.002}
+
+
+def generator():
+    A = CMATRIX(nst, nst)
+    for (i, j), a in A_elts.items():
+        A.set(i, j, a + 0.0j)
+        A.set(j, i, -a + 0.0j)
+    return A
+
+
+def propagator():
+    """ U = exp(A*dt) - the time-overlap <psi(t)|psi(t+dt)> of the states rotating with A """
+    U = CMATRIX(nst, nst)
+    exp_matrix(U, generator(), dt + 0.0j)
+    return U
+
+
+def crossed(U):
+    """ The same overlap, with the states 1 and 2 at t+dt swapped (a trivial crossing), and the
+        phase of the new state 2 flipped """
+    St = CMATRIX(nst, nst)
+    for i in range(nst):
+        St.set(i, 0, U.get(i, 0))
+        St.set(i, 1, U.get(i, 2))
+        St.set(i, 2, -U.get(i, 1))
+    return St
+
+
+def nac(St, method):
+    res = CMATRIX(nst, nst)
+    perm = Py2Cpp_int([])
+    nac_from_time_overlap(St, res, dt, method, perm)
+    return res, list(perm)
+
+
+def max_diff(X, Y):
+    return max(abs(X.get(i, j) - Y.get(i, j)) for i in range(nst) for j in range(nst))
+
+
+class TestNACTimeOverlap:
+
+    def test_1(self):
+        """ HST, NPI and log(U) on the states rotating with a constant generator: log(U) is exact,
+            the others agree with it to O(dt^2) """
+        U = propagator()
+        A = generator()
+
+        res = [ nac(U, method)[0] for method in [0, 1, 2] ]
+        assert max_diff(res[2], A) < 1e-10
+        assert max_diff(res[0], A) < 1e-5
+        assert max_diff(res[1], A) < 1e-5
+        assert max_diff(res[0], res[1]) < 1e-5
+
+        for X in res:     # anti-Hermitian
+            for i in range(nst):
+                for j in range(nst):
+                    assert abs(X.get(i, j) + X.get(j, i).conjugate()) < 1e-10
+
+
+    @pytest.mark.parametrize('method', [0, 1, 2])
+    def test_2(self, method):
+        """ The trivial crossing (and the phase flip) is detected and undone: the NACs are the same as
+            without the crossing, indexed by the states at time t """
+        U = propagator()
+        ref, perm0 = nac(U, method)
+        res, perm = nac(crossed(U), method)
+
+        assert perm0 == [0, 1, 2]
+        assert perm == [0, 2, 1]
+        assert max_diff(res, ref) < 1e-12
+
+
+    @pytest.mark.parametrize('method', [0, 1, 2])
+    def test_3(self, method):
+        """ nHamiltonian.compute_nac_adi applies the crossing to the adiabatic properties at t+dt """
+        U = propagator()
+
+        ham = nHamiltonian(nst, nst, 1)
+        ham.init_all(1)
+
+        E = CMATRIX(nst, nst)
+        for i, e in enumerate([0.1, 0.3, 0.2]):   # the state 1 at t is the state 2 at t+dt
+            E.set(i, i, e + 0.0j)
+        T = CMATRIX(nst, nst)
+        T.identity()
+
+        ham.set_ham_adi_by_val(E)
+        ham.set_basis_transform_by_val(T)
+        ham.set_time_overlap_adi_by_val(crossed(U))
+
+        perm = Py2Cpp_int([])
+        ham.compute_nac_adi(dt, method, perm)
+        assert list(perm) == [0, 2, 1]
+
+        E = ham.get_ham_adi()
+        assert [E.get(i, i).real for i in range(nst)] == [0.1, 0.2, 0.3]
+
+        T = ham.get_basis_transform()
+        assert T.get(0, 0) == 1.0 and T.get(2, 1) == 1.0 and T.get(1, 2) == 1.0
+
+        St = ham.get_time_overlap_adi()
+        for i in range(nst):
+            for j in range(nst):
+                assert abs(abs(St.get(i, j)) - abs(U.get(i, j))) < 1e-12
+
+        assert list(ham.get_ordering_adi()) == [0, 2, 1]
+        assert max_diff(ham.get_nac_adi(), nac(U, method)[0]) < 1e-12
+
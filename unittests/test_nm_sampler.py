@@ -0,0 +1,116 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+kb = 3.166811429e-6   # Hartree/K
+
+
+def coupled_system():
+    """ 3 DOFs with different masses, coupled by the off-diagonal force constants """
+    mass = [1000.0, 2000.0, 5000.0]
+    K = [[0.30, -0.05, 0.02], [-0.05, 0.50, -0.10], [0.02, -0.10, 0.80]]
+    hess = MATRIX(3, 3)
+    for i in range(3):
+        for j in range(3):
+            hess.set(i, j, K[i][j])
+    return hess, mass
+
+
+def zeros(n, m):
+    return MATRIX(n, m)
+
+
+def normal_coordinates(modes, mass, q, p):
+    """ Q_k = sum_i L_ik sqrt(m_i) q_i,  P_k = sum_i L_ik p_i / sqrt(m_i) for all the trajectories (q0 = p0 = 0),
+        as the lists Q[k][t] and P[k][t] """
+    n, ntraj = len(mass), q.num_of_cols
+    qs = [ [ q.get(i, t) * math.sqrt(mass[i]) for t in range(ntraj) ] for i in range(n) ]
+    ps = [ [ p.get(i, t) / math.sqrt(mass[i]) for t in range(ntraj) ] for i in range(n) ]
+    L = [ [ modes.get(i, k) for k in range(n) ] for i in range(n) ]
+
+    Q = [ [ sum(L[i][k] * qs[i][t] for i in range(n)) for t in range(ntraj) ] for k in range(n) ]
+    P = [ [ sum(L[i][k] * ps[i][t] for i in range(n)) for t in range(ntraj) ] for k in range(n) ]
+    return Q, P
+
+
+class TestNMSampler:
+
+    @pytest.mark.parametrize('is_quantum', [1, 0])
+    def test_1(self, is_quantum):
+        """ 1e5 samples of a coupled 3-DOF system: the variances of the normal coordinates and momenta are the
+            Wigner (or Boltzmann) widths, and the normal modes are not correlated """
+        hess, mass = coupled_system()
+        ntraj = 100000
+
+        omega = Py2Cpp_double([0.0]*3)
+        modes = MATRIX(3, 3)
+        normal_modes(hess, Py2Cpp_double(mass), omega, modes)
+
+        sampler = nm_sampler({"Temperature":300.0, "is_quantum":is_quantum, "rng_seed":7})
+        sq, sp = Py2Cpp_double([]), Py2Cpp_double([])
+        sampler.widths(omega, sq, sp)
+
+        q, p = zeros(3, ntraj), zeros(3, ntraj)
+        sampler.sample(hess, Py2Cpp_double(mass), zeros(3, 1), zeros(3, 1), q, p)
+
+        Q, P = normal_coordinates(modes, mass, q, p)
+        sQ = [ [ sum(x*y for x, y in zip(Q[a], Q[b])) / ntraj for b in range(3) ] for a in range(3) ]
+        sP = [ [ sum(x*y for x, y in zip(P[a], P[b])) / ntraj for b in range(3) ] for a in range(3) ]
+
+        kT = kb * 300.0
+        for k in range(3):
+            w = omega[k]
+            if is_quantum:
+                vq, vp = 0.5 / (w * math.tanh(0.5 * w / kT)), 0.5 * w / math.tanh(0.5 * w / kT)
+            else:
+                vq, vp = kT / w**2, kT
+            assert abs(sq[k]**2 / vq - 1.0) < 1e-12
+            assert abs(sp[k]**2 / vp - 1.0) < 1e-12
+
+            assert abs(sQ[k][k] / vq - 1.0) < 0.02
+            assert abs(sP[k][k] / vp - 1.0) < 0.02
+
+            for l in range(3):
+                if l != k:
+                    assert abs(sQ[k][l]) < 0.02 * math.sqrt(sQ[k][k] * sQ[l][l])
+                    assert abs(sP[k][l]) < 0.02 * math.sqrt(sP[k][k] * sP[l][l])
+
+
+    def test_2(self):
+        """ The frozen modes are not sampled: the coordinates along them stay at zero """
+        hess, mass = coupled_system()
+        omega = Py2Cpp_double([0.0]*3)
+        modes = MATRIX(3, 3)
+        normal_modes(hess, Py2Cpp_double(mass), omega, modes)
+
+        sampler = nm_sampler({"frozen_modes":[1], "rng_seed":3})
+        q, p = zeros(3, 500), zeros(3, 500)
+        sampler.sample(modes, omega, Py2Cpp_double(mass), zeros(3, 1), zeros(3, 1), q, p)
+
+        Q, P = normal_coordinates(modes, mass, q, p)
+        for t in range(500):
+            assert abs(Q[1][t]) < 1e-10 and abs(P[1][t]) < 1e-10
+        assert max(abs(x) for x in Q[0]) > 1e-3
+
+
+    def test_3(self):
+        """ A fixed seed gives the same ensemble with any number of threads; another seed does not """
+        hess, mass = coupled_system()
+        ntraj = 1000
+        q0, p0 = zeros(3, 1), zeros(3, 1)
+        q0.set(1, 0, 0.5);  p0.set(2, 0, -1.0)
+
+        def run(**kw):
+            prms = {"rng_seed":11, "block_size":64}
+            prms.update(kw)
+            q, p = zeros(3, ntraj), zeros(3, ntraj)
+            nm_sampler(prms).sample(hess, Py2Cpp_double(mass), q0, p0, q, p)
+            return [ [ (q.get(i, t), p.get(i, t)) for t in range(ntraj) ] for i in range(3) ]
+
+        ref = run(num_threads=1)
+        assert run(num_threads=2) == ref
+        assert run(num_threads=5) == ref
+        assert run(num_threads=0) == ref
+        assert run(num_threads=1, rng_seed=12) != ref
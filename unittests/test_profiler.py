@@ -0,0 +1,132 @@
+import pytest
+
+import time
+import threading
+from liblibra_core import *
+
+
+def summary():
+    """ The profiler entries as a dictionary path -> entry """
+    return { e.path : e for e in profiler_summary() }
+
+
+def scope(name, dt):
+    profiler_begin(name)
+    time.sleep(dt)
+    profiler_end()
+
+
+@pytest.fixture(autouse=True)
+def clean_profiler():
+    profiler_reset()
+    profiler_enable()
+    yield
+    profiler_disable()
+    profiler_reset()
+
+
+class TestProfiler:
+
+    def test_1(self):
+        """ Nested scopes: the paths, the depths and the call counts; the parent's exclusive time is its
+            inclusive time less the time of its children """
+        profiler_begin("outer")
+        scope("inner", 0.02)
+        time.sleep(0.01)
+        scope("inner", 0.02)
+        profiler_begin("inner")
+        scope("leaf", 0.01)
+        profiler_end()
+        profiler_end()
+
+        s = summary()
+        assert sorted(s.keys()) == [ "outer", "outer/inner", "outer/inner/leaf" ]
+
+        outer, inner, leaf = s["outer"], s["outer/inner"], s["outer/inner/leaf"]
+        assert (outer.depth, inner.depth, leaf.depth) == (0, 1, 2)
+        assert (outer.count, inner.count, leaf.count) == (1, 3, 1)
+        assert inner.name == "inner" and leaf.name == "leaf"
+
+        assert inner.inclusive >= 0.05 and leaf.inclusive >= 0.01
+        assert outer.inclusive >= inner.inclusive + 0.01
+        assert abs(outer.exclusive - (outer.inclusive - inner.inclusive)) < 1e-9
+        assert abs(inner.exclusive - (inner.inclusive - leaf.inclusive)) < 1e-9
+        assert leaf.exclusive == leaf.inclusive
+        assert outer.nthreads == 1 and outer.imbalance == 1.0
+
+
+    def test_2(self):
+        """ The scopes of several threads are combined: the counts and the times are summed,
+            the largest time of a single thread and the imbalance are reported """
+        nthreads = 4
+        dt = [ 0.02 * (t + 1) for t in range(nthreads) ]
+
+        def work(t):
+            profiler_begin("work")
+            scope("step", dt[t])
+            scope("step", 0.01)
+            profiler_end()
+
+        threads = [ threading.Thread(target=work, args=(t,)) for t in range(nthreads) ]
+        for th in threads:
+            th.start()
+        for th in threads:
+            th.join()
+
+        s = summary()
+        assert sorted(s.keys()) == [ "work", "work/step" ]
+
+        w, st = s["work"], s["work/step"]
+        assert w.nthreads == nthreads and st.nthreads == nthreads
+        assert w.count == nthreads and st.count == 2 * nthreads
+
+        assert w.inclusive >= sum(dt) + 0.01 * nthreads
+        assert w.max_thread >= dt[-1] + 0.01
+        assert w.max_thread <= w.inclusive
+        assert abs(w.imbalance - w.max_thread / (w.inclusive / nthreads)) < 1e-12
+        assert w.imbalance > 1.0
+        assert abs(w.exclusive - (w.inclusive - st.inclusive)) < 1e-9
+
+
+    def test_3(self):
+        """ The reset clears the timings of all threads, including the ones that have finished;
+            the scopes opened after the reset are counted from zero """
+        th = threading.Thread(target=scope, args=("worker", 0.01))
+        th.start()
+        th.join()
+        scope("main", 0.01)
+        scope("main", 0.01)
+        assert summary()["main"].count == 2 and "worker" in summary()
+
+        profiler_reset()
+        assert len(profiler_summary()) == 0
+
+        scope("main", 0.01)
+        s = summary()
+        assert list(s.keys()) == [ "main" ]
+        assert s["main"].count == 1 and s["main"].nthreads == 1
+
+
+    def test_4(self):
+        """ The ScopedTimer of the C++ code opens a scope only when the profiler is enabled, and it
+            is nested into the scope opened from Python """
+        nst, ndof, ntraj = 2, 4, 3
+        params = set_params_spin_boson(0.01, 0.005, ndof, 0, 0.1, 0.01)
+        ham = nHamiltonian(nst, nst, ndof)
+        ham.add_new_children(nst, nst, ndof, ntraj)
+        ham.init_all(1, 1)
+        q = MATRIX(ndof, ntraj)
+
+        profiler_disable()
+        ham.compute_diabatic(200, q, params, 1)
+        assert len(profiler_summary()) == 0
+
+        profiler_enable()
+        profiler_begin("outer")
+        ham.compute_diabatic(200, q, params, 1)
+        ham.compute_diabatic(200, q, params, 1)
+        profiler_end()
+
+        s = summary()
+        assert sorted(s.keys()) == [ "outer", "outer/nHamiltonian::compute_diabatic(model)" ]
+        assert s["outer/nHamiltonian::compute_diabatic(model)"].count == 2
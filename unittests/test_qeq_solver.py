@@ -0,0 +1,106 @@
+import pytest
+
+import math
+import random
+from liblibra_core import *
+
+
+def coords(lst):
+    R = VECTORList()
+    for r in lst:
+        R.append(VECTOR(r[0], r[1], r[2]))
+    return R
+
+
+def make_solver(chi, J, gamma, R_off):
+    qeq = Qeq_solver(Py2Cpp_double(chi), Py2Cpp_double(J), Py2Cpp_double(gamma), R_off)
+    qeq.threshold = 1e-12
+    qeq.MaxCount = 1000
+    return qeq
+
+
+def potentials(qeq, chi, q):
+    """ dE/dq_i = chi_i + sum_j H_ij q_j """
+    H = qeq.get_hardness()
+    n = len(chi)
+    return [ chi[i] + sum(H.get(i, j) * q[j] for j in range(n)) for i in range(n) ]
+
+
+def random_cluster(rnd, m, a):
+    """ m^3 atoms on a randomly distorted cubic grid with the spacing a, with random parameters """
+    pos = [ [a*(i + rnd.uniform(-0.15, 0.15)), a*(j + rnd.uniform(-0.15, 0.15)), a*(k + rnd.uniform(-0.15, 0.15))]
+            for i in range(m) for j in range(m) for k in range(m) ]
+    n = len(pos)
+    chi = [ rnd.uniform(0.1, 0.3) for i in range(n) ]
+    J = [ rnd.uniform(0.4, 0.6) for i in range(n) ]
+    gamma = [ rnd.uniform(0.5, 1.0) for i in range(n) ]
+    return pos, chi, J, gamma
+
+
+class TestQeqSolver:
+
+    @pytest.mark.parametrize('Q', [0.0, 1.0, -0.5])
+    def test_1(self, Q):
+        """ Two atoms: q1 = (chi2 - chi1 + (J2 - k) Q) / (J1 + J2 - 2k), with k the tapered shielded Coulomb coupling """
+        chi, J, gamma = [0.15, 0.25], [0.5, 0.4], [0.6, 0.9]
+        r, R_off = 4.0, 12.0
+
+        qeq = make_solver(chi, J, gamma, R_off)
+        qeq.update_hardness(coords([[0.0, 0.0, 0.0], [0.0, 0.0, r]]))
+        q = list(qeq.solve(Q))
+
+        k = Qeq_taper(r, R_off) * Qeq_shielded_coulomb(r, math.sqrt(gamma[0]*gamma[1]))
+        q1 = (chi[1] - chi[0] + (J[1] - k)*Q) / (J[0] + J[1] - 2.0*k)
+
+        H = qeq.get_hardness()
+        assert abs(H.get(0, 1) - k) < 1e-14 and abs(H.get(0, 0) - J[0]) < 1e-14
+        assert abs(q[0] - q1) < 1e-10
+        assert abs(q[1] - (Q - q1)) < 1e-10
+
+        # The electronegativities are equalized: both potentials are mu
+        for v in potentials(qeq, chi, q):
+            assert abs(v - qeq.mu) < 1e-10
+
+
+    def test_2(self):
+        """ Beyond the cutoff the atoms do not interact: q1 = (chi2 - chi1 + J2 Q) / (J1 + J2) """
+        chi, J, gamma = [0.15, 0.25], [0.5, 0.4], [0.6, 0.9]
+        qeq = make_solver(chi, J, gamma, 6.0)
+        qeq.update_hardness(coords([[0.0, 0.0, 0.0], [7.0, 0.0, 0.0]]))
+        q = list(qeq.solve(0.0))
+        assert abs(q[0] - (chi[1] - chi[0]) / (J[0] + J[1])) < 1e-10
+
+
+    @pytest.mark.parametrize('Q', [0.0, 2.0])
+    def test_3(self, Q):
+        """ A random cluster: the total charge is conserved and the potentials are equal, also after a move (warm start) """
+        rnd = random.Random(3)
+        pos, chi, J, gamma = random_cluster(rnd, 3, 3.5)
+        qeq = make_solver(chi, J, gamma, 10.0)
+
+        for it in range(2):
+            qeq.update_hardness(coords(pos))
+            q = list(qeq.solve(Q))
+
+            assert abs(sum(q) - Q) < 1e-10
+            for v in potentials(qeq, chi, q):
+                assert abs(v - qeq.mu) < 1e-8
+
+            for r in pos:
+                for a in range(3):
+                    r[a] += rnd.uniform(-0.05, 0.05)
+
+
+    def test_4(self):
+        """ The periodic (Ewald) case: the cell stays neutral and the potentials are equal """
+        rnd = random.Random(5)
+        L = 12.0
+        pos, chi, J, gamma = random_cluster(rnd, 3, L/3)
+        qeq = make_solver(chi, J, gamma, 10.0)
+        qeq.set_pbc(MATRIX3x3(VECTOR(L, 0.0, 0.0), VECTOR(0.0, L, 0.0), VECTOR(0.0, 0.0, L)), 3.0, 6)
+        qeq.update_hardness(coords(pos))
+        q = list(qeq.solve(0.0))
+
+        assert abs(sum(q)) < 1e-10
+        for v in potentials(qeq, chi, q):
+            assert abs(v - qeq.mu) < 1e-8
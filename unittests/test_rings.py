@@ -0,0 +1,108 @@
+import pytest
+
+from liblibra_core import *
+
+
+amu = 1822.888
+
+class elt:
+    pass
+
+
+def make_system(n, edges):
+    """ n carbon atoms linked by the given (0-based) edges """
+    U = Universe()
+    e = elt()
+    e.Elt_name = "C"
+    e.Elt_mass = 12.011 * amu
+    rec = Element()
+    rec.set(e)
+    U.Add_Element_To_Periodic_Table(rec)
+
+    syst = System()
+    for i in range(n):
+        syst.CREATE_ATOM( Atom(U, {"Atom_element":"C", "Atom_cm_x":1.5*i, "Atom_cm_y":0.0, "Atom_cm_z":0.0}) )
+    for a, b in edges:
+        syst.LINK_ATOMS(a+1, b+1)
+    return syst
+
+
+def cycle(atoms):
+    return [ (atoms[i], atoms[(i+1) % len(atoms)]) for i in range(len(atoms)) ]
+
+
+def rings(syst):
+    return [ frozenset(syst.Rings[i].globAtom_Index) for i in range(syst.Number_of_rings) ]
+
+
+def min_ring_sizes(syst):
+    return [ syst.Atoms[i].Atom_min_ring_size for i in range(syst.Number_of_atoms) ]
+
+
+# The carbons 0..5 and the hydrogens 6..11
+benzene = (12, cycle(list(range(6))) + [ (i, i+6) for i in range(6) ])
+
+# The rings 0-1-2-3-4-9 and 4-5-6-7-8-9 fused by the 4-9 bond
+naphthalene = (10, cycle([0, 1, 2, 3, 4, 9]) + [ (4, 5), (5, 6), (6, 7), (7, 8), (8, 9) ])
+
+# The vertices of the cube: the faces 0-1-2-3 and 4-5-6-7 linked by the 4 edges i, i+4
+cubane = (8, cycle([0, 1, 2, 3]) + cycle([4, 5, 6, 7]) + [ (i, i+4) for i in range(4) ])
+cube_faces = [ {0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7} ]
+
+
+class TestRings:
+
+    def test_1(self):
+        """ Benzene: one 6-membered ring of the carbons, the hydrogens are not in rings """
+        syst = make_system(*benzene)
+        syst.Assign_Rings()
+
+        assert rings(syst) == [ frozenset(range(6)) ]
+        assert min_ring_sizes(syst) == [6]*6 + [1]*6
+
+
+    def test_2(self):
+        """ Naphthalene: the two 6-membered rings, not the 10-membered perimeter """
+        syst = make_system(*naphthalene)
+        syst.Assign_Rings()
+
+        assert sorted(rings(syst), key=min) == [ frozenset([0, 1, 2, 3, 4, 9]), frozenset([4, 5, 6, 7, 8, 9]) ]
+        assert min_ring_sizes(syst) == [6]*10
+
+
+    def test_3(self):
+        """ Cubane: E - V + 1 = 5 independent 4-membered rings, all of them are the faces of the cube """
+        syst = make_system(*cubane)
+        syst.Assign_Rings()
+
+        r = rings(syst)
+        assert len(r) == 5
+        assert len(set(r)) == 5
+        for x in r:
+            assert set(x) in cube_faces
+        assert min_ring_sizes(syst) == [4]*8
+
+
+    def test_4(self):
+        """ The rings larger than 8 atoms are found only when asked for """
+        syst = make_system(18, cycle(list(range(18))))
+
+        syst.Assign_Rings()
+        assert syst.Number_of_rings == 0
+        assert min_ring_sizes(syst) == [1]*18
+
+        syst.Assign_Rings(18)
+        assert rings(syst) == [ frozenset(range(18)) ]
+        assert min_ring_sizes(syst) == [18]*18
+
+        syst.Assign_Rings(0)      # no limit
+        assert rings(syst) == [ frozenset(range(18)) ]
+
+
+    def test_5(self):
+        """ The repeated calls do not duplicate the rings """
+        syst = make_system(*naphthalene)
+        syst.Assign_Rings()
+        syst.Assign_Rings()
+        syst.Assign_Rings(8)
+        assert syst.Number_of_rings == 2
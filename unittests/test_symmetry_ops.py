@@ -0,0 +1,117 @@
+import pytest
+
+import math
+from liblibra_core import *
+
+
+# A cubic Pm-3m cell: the atoms at 1a (0,0,0), 1b (1/2,1/2,1/2) and 3c (0,1/2,1/2), (1/2,0,1/2), (1/2,1/2,0)
+a0 = 5.0
+group = "P_m_-3_m"
+frac = [ [0.0, 0.0, 0.0], [0.5, 0.5, 0.5], [0.0, 0.5, 0.5], [0.5, 0.0, 0.5], [0.5, 0.5, 0.0] ]
+types = [ 0, 1, 2, 2, 2 ]
+elements = [ "Cs", "Cl", "O" ]
+
+# Cartesian components of the s, p and d shells
+shells = { 0: [ (0,0,0) ],
+           1: [ (1,0,0), (0,1,0), (0,0,1) ],
+           2: [ (2,0,0), (0,2,0), (0,0,2), (1,1,0), (1,0,1), (0,1,1) ]
+         }
+
+# The radial parts of the shells of each atom type: (L, [(alpha, coefficient), ...])
+radial = [ [ (0, [(1.3, 0.6), (0.45, 0.5)]), (1, [(0.9, 1.0)]), (2, [(0.8, 1.0)]) ],
+           [ (0, [(1.1, 1.0)]), (1, [(1.2, 0.7), (0.5, 0.4)]) ],
+           [ (0, [(0.9, 1.0)]), (1, [(0.7, 1.0)]) ]
+         ]
+
+
+def cell():
+    t1, t2, t3 = VECTOR(a0, 0.0, 0.0), VECTOR(0.0, a0, 0.0), VECTOR(0.0, 0.0, a0)
+    return t1, t2, t3
+
+
+def make_basis(skip=None):
+    """ The AOs of all atoms and the AO-to-atom map; skip = (atom, x, y, z) drops one Cartesian component """
+    basis = AOList()
+    ao_to_atom = []
+
+    for A in range(len(frac)):
+        R = VECTOR(a0*frac[A][0], a0*frac[A][1], a0*frac[A][2])
+        for L, prims in radial[types[A]]:
+            for (x, y, z) in shells[L]:
+                if skip is not None and skip==(A, x, y, z):
+                    continue
+                ao = AO()
+                ao.element = elements[types[A]]
+                for alp, c in prims:
+                    g = PrimitiveG()
+                    g.init(x, y, z, alp, R)
+                    ao.add_primitive(c, g)
+                basis.append(ao)
+                ao_to_atom.append(A)
+
+    return basis, Py2Cpp_int(ao_to_atom)
+
+
+def max_diff(X, Y):
+    err = 0.0
+    for i in range(X.num_of_rows):
+        for j in range(X.num_of_cols):
+            err = max(err, abs(X.get(i, j) - Y.get(i, j)))
+    return err
+
+
+class TestSymmetryOps:
+
+    def test_1(self):
+        """ The equivalent atoms of the Pm-3m structure and the consistency of the atom map with the operations """
+        g = get_space_group(group)
+        x = VECTORList()
+        for f in frac:
+            x.append(VECTOR(f[0], f[1], f[2]))
+
+        smap = symmetry_atom_map(g, x, Py2Cpp_int(types), 1e-4)
+
+        assert g.nops == 48
+        assert len(smap.valid_ops) == 48
+        assert [smap.irreducible[A] for A in range(len(frac))] == [0, 1, 2, 2, 2]
+
+        for k in range(len(smap.valid_ops)):
+            for A in range(len(frac)):
+                B = smap.atom_map[k][A]
+                y = g.apply(smap.valid_ops[k], x[A])
+                d = y - x[B]
+                for c in [d.x, d.y, d.z]:
+                    assert abs(c - round(c)) < 1e-8
+
+
+    @pytest.mark.parametrize('skip', [ None, (2, 1, 0, 0) ])
+    def test_2(self, skip):
+        """ The symmetry-projected overlap matrix vs. the direct one, for a converged image sum.
+            With an incomplete p shell the symmetry can not be used - the direct fallback must give the same """
+        t1, t2, t3 = cell()
+        basis, ao_to_atom = make_basis(skip)
+        norb = len(basis)
+
+        S_dir = MATRIX(norb, norb)
+        S_sym = MATRIX(norb, norb)
+        update_overlap_matrix(3, 3, 3, t1, t2, t3, basis, S_dir)
+        update_overlap_matrix(3, 3, 3, t1, t2, t3, ao_to_atom, basis, group, 1e-4, S_sym)
+
+        assert max_diff(S_dir, S_sym) < 1e-10
+
+
+    def test_3(self):
+        """ The symmetry-projected derivative couplings vs. the direct ones, for a converged image sum """
+        t1, t2, t3 = cell()
+        basis, ao_to_atom = make_basis()
+
+        D_dir = MATRIXList()
+        D_sym = MATRIXList()
+        update_derivative_coupling_matrices(3, 3, 3, t1, t2, t3, ao_to_atom, basis, -1.0, D_dir)
+        update_derivative_coupling_matrices(3, 3, 3, t1, t2, t3, ao_to_atom, basis, -1.0, group, 1e-4, D_sym)
+
+        assert len(D_dir) == 3*len(frac)
+        assert len(D_sym) == len(D_dir)
+        for n in range(len(D_dir)):
+            assert max_diff(D_dir[n], D_sym[n]) < 1e-10
+
@@ -0,0 +1,81 @@
+import pytest
+
+from liblibra_core import *
+
+
+params = {"thermostat_type":"Langevin", "Temperature":300.0, "nu_therm":0.01}
+
+
+def draws(th, n=20):
+    return [ th.gaussian() for i in range(n) ]
+
+
+def run(seed, ntraj=3, nsteps=50):
+    """ Langevin O steps for ntraj trajectories that start from the same momenta """
+    ndof = 2
+    p = MATRIX(ndof, ntraj)
+    invM = MATRIX(ndof, 1)
+    for k in range(ndof):
+        invM.set(k, 0, 1.0/2000.0)
+        for i in range(ntraj):
+            p.set(k, i, 1.0)
+
+    therm = ThermostatList()
+    for i in range(ntraj):
+        therm.append(Thermostat(params))
+        therm[i].set_seed(seed, i)
+
+    dofs = Py2Cpp_int([0, 1])
+    for step in range(nsteps):
+        for i in range(ntraj):
+            therm[i].propagate_stochastic(p, invM, dofs, i, 41.0)
+
+    return p
+
+
+class TestThermostatRNG:
+
+    def test_1(self):
+        """ The same seed: the streams of different trajectories differ, the same stream is reproduced """
+        a, b, c = Thermostat(params), Thermostat(params), Thermostat(params)
+        a.set_seed(5, 0)
+        b.set_seed(5, 1)
+        c.set_seed(5, 0)
+
+        xa, xb, xc = draws(a), draws(b), draws(c)
+        assert xa == xc
+        assert xa != xb
+        assert a.rng_seed == 5 and b.rng_stream == 1
+
+
+    def test_2(self):
+        """ The copies of a thermostat do not duplicate its noise """
+        th = Thermostat(params)
+        th.set_seed(7, 0)
+
+        th1 = Thermostat(th)
+        th2 = Thermostat(th)
+        x, x1, x2 = draws(th), draws(th1), draws(th2)
+        assert x1 != x2
+        assert x != x1 and x != x2
+
+
+    def test_3(self):
+        """ The unseeded thermostats have different streams too """
+        a, b = Thermostat(params), Thermostat(params)
+        assert draws(a) != draws(b)
+
+
+    def test_4(self):
+        """ A seeded run is reproduced exactly; the trajectories get different noise """
+        p1 = run(11)
+        p2 = run(11)
+        p3 = run(12)
+
+        for k in range(p1.num_of_rows):
+            for i in range(p1.num_of_cols):
+                assert p1.get(k, i) == p2.get(k, i)
+
+        assert p1.get(0, 0) != p1.get(0, 1)
+        assert p1.get(0, 0) != p3.get(0, 0)
+
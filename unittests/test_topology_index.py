@@ -0,0 +1,117 @@
+import pytest
+
+import random
+from liblibra_core import *
+
+
+amu = 1822.888
+
+class elt:
+    pass
+
+
+def make_system(n):
+    U = Universe()
+    e = elt()
+    e.Elt_name = "C"
+    e.Elt_mass = 12.011 * amu
+    rec = Element()
+    rec.set(e)
+    U.Add_Element_To_Periodic_Table(rec)
+
+    syst = System()
+    for i in range(n):
+        syst.CREATE_ATOM( Atom(U, {"Atom_element":"C", "Atom_cm_x":1.5*i, "Atom_cm_y":0.0, "Atom_cm_z":0.0}) )
+    return syst
+
+
+def atoms(groups, n):
+    return [ list(groups[i].globAtom_Index) for i in range(n) ]
+
+
+def linear_improper(syst, c):
+    for i, a in enumerate(atoms(syst.Impropers, syst.Number_of_impropers)):
+        if a[0]==c:
+            return i
+    return -1
+
+
+def linear_bond(syst, x, y):
+    for i, a in enumerate(atoms(syst.Bonds, syst.Number_of_bonds)):
+        if sorted(a)==sorted([x, y]):
+            return i
+    return -1
+
+
+def linear_dihedral(syst, x):
+    for i, a in enumerate(atoms(syst.Dihedrals, syst.Number_of_dihedrals)):
+        if a==x or a==x[::-1]:
+            return i
+    return -1
+
+
+def check(syst, n):
+    """ All the hashed lookups agree with the linear searches """
+    for c in range(n):
+        assert syst.Find_Improper(c) == linear_improper(syst, c)
+    for x in range(n):
+        for y in range(n):
+            assert syst.Find_Bond(x, y) == linear_bond(syst, x, y)
+    for a in atoms(syst.Dihedrals, syst.Number_of_dihedrals):
+        assert syst.Find_Dihedral(a[0], a[1], a[2], a[3]) == linear_dihedral(syst, a)
+        assert syst.Find_Dihedral(a[3], a[2], a[1], a[0]) == linear_dihedral(syst, a)
+
+
+class TestTopologyIndex:
+
+    def test_1(self):
+        """ The improper of a center that gets the 4-th neighbor is erased, the last improper takes its
+            place, and both are found at the right positions without rebuilding the index """
+        syst = make_system(9)
+        for x, y in [(1, 2), (1, 3), (1, 4),     # the improper of the atom 0 (IDs are 1-based)
+                     (5, 6), (5, 7), (5, 8)]:    # the improper of the atom 4
+            syst.LINK_ATOMS(x, y)
+
+        assert syst.Number_of_impropers == 2
+        assert syst.Find_Improper(0) == 0
+        assert syst.Find_Improper(4) == 1
+
+        syst.LINK_ATOMS(1, 9)                    # the atom 0 has 4 neighbors now
+        assert syst.Number_of_impropers == 1
+        assert syst.Find_Improper(0) == -1
+        assert syst.Find_Improper(4) == 0
+        assert list(syst.Impropers[0].globAtom_Index)[0] == 4
+        check(syst, 9)
+
+        syst.LINK_ATOMS(5, 9)                    # and so does the atom 4: the last improper is erased
+        assert syst.Number_of_impropers == 0
+        assert syst.Find_Improper(4) == -1
+        check(syst, 9)
+
+
+    @pytest.mark.parametrize('seed', [1, 2, 3])
+    def test_2(self, seed):
+        """ Random linking: the lookups agree with the linear searches after every new bond """
+        rnd = random.Random(seed)
+        n = 14
+        syst = make_system(n)
+
+        pairs = [ (x, y) for x in range(1, n+1) for y in range(x+1, n+1) ]
+        rnd.shuffle(pairs)
+        for x, y in pairs[:25]:
+            syst.LINK_ATOMS(x, y)
+            check(syst, n)
+
+
+    def test_3(self):
+        """ The containers changed directly (from Python): the index is rebuilt on the next lookup """
+        syst = make_system(9)
+        for x, y in [(1, 2), (1, 3), (1, 4), (5, 6), (5, 7), (5, 8)]:
+            syst.LINK_ATOMS(x, y)
+
+        impr = GroupList()
+        impr.append(syst.Impropers[1])
+        syst.Impropers = impr
+        syst.Number_of_impropers = 1
+        assert syst.Find_Improper(0) == -1
+        assert syst.Find_Improper(4) == 0
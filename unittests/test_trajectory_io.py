@@ -0,0 +1,89 @@
+import pytest
+
+import random
+from liblibra_core import *
+
+
+nat, ntraj, nst = 4, 3, 2
+
+
+def make_frame(rnd, step):
+    fr = traj_frame()
+    fr.step = step
+    fr.time = 41.0 * step
+    fr.box = Py2Cpp_double([ rnd.uniform(5.0, 10.0) for i in range(9) ])
+    fr.pos = Py2Cpp_double([ rnd.uniform(-5.0, 5.0) for i in range(3*nat) ])
+    fr.vel = Py2Cpp_double([ rnd.uniform(-1e-3, 1e-3) for i in range(3*nat) ])
+    fr.pops = Py2Cpp_double([ rnd.uniform(0.0, 1.0) for i in range(nst*ntraj) ])
+    fr.states = Py2Cpp_int([ rnd.randint(0, nst-1) for i in range(ntraj) ])
+    fr.nst = nst
+    return fr
+
+
+def same(a, b, tol):
+    assert a.step == b.step
+    assert a.time == b.time
+    assert a.nst == b.nst
+    assert list(a.box) == list(b.box)       # the box is always stored in double precision
+    assert list(a.states) == list(b.states)
+    assert len(b.frc) == 0
+    for x, y in [(a.pos, b.pos), (a.vel, b.vel), (a.pops, b.pops)]:
+        assert len(x) == len(y)
+        for i in range(len(x)):
+            assert abs(x[i] - y[i]) <= tol * max(1.0, abs(x[i]))
+
+
+class TestTrajectoryIO:
+
+    @pytest.mark.parametrize('is_async', [0, 1])
+    @pytest.mark.parametrize('precision, tol', [(8, 0.0), (4, 1e-6)])
+    def test_1(self, tmp_path, precision, tol, is_async):
+        """ Write-read round trip, with the buffers smaller than all the frames, and the random (also negative) access """
+        fname = str(tmp_path / "traj.bin")
+        rnd = random.Random(17)
+        frames = [ make_frame(rnd, 10*i) for i in range(25) ]
+
+        w = traj_writer(fname, {"precision":precision, "is_async":is_async, "buffer_size":1000})
+        for fr in frames:
+            w.write(fr)
+        w.close()
+        assert w.get_nframes() == len(frames)
+
+        r = traj_reader(fname)
+        assert r.precision == precision
+        assert r.get_nframes() == len(frames)
+
+        for i in [0, 7, 24, 3]:
+            same(frames[i], r.read_frame(i), tol)
+
+        for i in [-1, -25, -10]:
+            same(frames[len(frames)+i], r.read_frame(i), tol)
+
+        fr = traj_frame()
+        r.read_frame(-2, fr)
+        same(frames[-2], fr, tol)
+
+
+    def test_2(self, tmp_path):
+        """ The reader sees the flushed frames of the file still being written """
+        fname = str(tmp_path / "traj.bin")
+        rnd = random.Random(3)
+        frames = [ make_frame(rnd, i) for i in range(10) ]
+
+        w = traj_writer(fname, {"is_async":1})
+        for fr in frames[:4]:
+            w.write(fr)
+        w.flush()
+
+        r = traj_reader(fname)
+        assert r.get_nframes() == 4
+        same(frames[3], r.read_frame(-1), 0.0)
+
+        for fr in frames[4:]:
+            w.write(fr)
+        w.close()
+
+        assert r.refresh() == 10
+        same(frames[9], r.read_frame(-1), 0.0)
+        same(frames[4], r.read_frame(4), 0.0)
+